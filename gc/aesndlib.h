@@ -25,6 +25,7 @@
 #define VOICE_STEREO8_UNSIGNED	0x00000005
 #define VOICE_MONO16_UNSIGNED	0x00000006
 #define VOICE_STEREO16_UNSIGNED	0x00000007
+#define VOICE_MONO_ADPCM		0x00000008
 
 #define VOICE_FREQ32KHZ			32000
 #define VOICE_FREQ48KHZ			48000
@@ -37,12 +38,15 @@ typedef struct aesndpb_t AESNDPB;
 
 typedef void (*AESNDVoiceCallback)(AESNDPB *pb,u32 state);
 typedef void (*AESNDAudioCallback)(void *audio_buffer,u32 len);
+typedef s32 (*AESNDSourceCallback)(AESNDPB *pb,void *buffer,u32 len,void *cb_arg);
 
 void AESND_Init();
 void AESND_Reset();
 void AESND_Pause(bool pause);
 u32 AESND_GetDSPProcessTime();
 f32 AESND_GetDSPProcessUsage();
+u32 AESND_GetDSPProcessPeak();
+u32 AESND_GetDSPVoiceCount();
 AESNDAudioCallback AESND_RegisterAudioCallback(AESNDAudioCallback cb);
 
 AESNDPB* AESND_AllocateVoice(AESNDVoiceCallback cb);
@@ -54,11 +58,14 @@ void AESND_SetVoiceStop(AESNDPB *pb,bool stop);
 void AESND_SetVoiceMute(AESNDPB *pb,bool mute);
 void AESND_SetVoiceLoop(AESNDPB *pb,bool loop);
 void AESND_SetVoiceFormat(AESNDPB *pb,u32 format);
+void AESND_SetVoiceADPCM(AESNDPB *pb,const s16 *coefs,u16 loop_ps,s16 loop_yn1,s16 loop_yn2);
 void AESND_SetVoiceStream(AESNDPB *pb,bool stream);
 void AESND_SetVoiceFrequency(AESNDPB *pb,u32 freq);
 void AESND_SetVoiceFrequencyRatio(AESNDPB *pb,f32 ratio);
 void AESND_SetVoiceVolume(AESNDPB *pb,u16 volume_l,u16 volume_r);
 void AESND_SetVoiceBuffer(AESNDPB *pb,const void *buffer,u32 len);
+void AESND_SetVoiceSource(AESNDPB *pb,AESNDSourceCallback source,void *cb_arg);
+u32 AESND_GetVoiceUnderruns(AESNDPB *pb);
 void AESND_PlayVoice(AESNDPB *pb,u32 format,const void *buffer,u32 len,u32 freq,u32 delay,bool looped);
 AESNDVoiceCallback AESND_RegisterVoiceCallback(AESNDPB *pb,AESNDVoiceCallback cb);
 
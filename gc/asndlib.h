@@ -65,6 +65,7 @@ extern "C" {
 #define SND_UNUSED   0   /*!< This voice is available for use. */
 #define SND_WORKING  1   /*!< This voice is currently in progress. */
 #define SND_WAITING  2   /*!< This voice is currently in progress and waiting to one SND_AddVoice() function (the voice handler is called continuously) */
+#define SND_VIRTUAL  3   /*!< This virtual voice is in progress without a DSP voice; its play position keeps advancing. */
 /*! @} */
 
 /*! \addtogroup sndsetvoiceformats Voice format
@@ -183,6 +184,17 @@ NOTE_B
 /** \brief Callback type for ASND_SetVoice(). */
 typedef void (*ASNDVoiceCallback)(s32 voice);
 
+/** \brief Voice statistics returned by ASND_GetVoiceStats(). */
+typedef struct
+{
+	u32 virtual_voices; /*!< Virtual voices in progress. */
+	u32 real_voices;    /*!< Virtual voices currently playing on a DSP voice. */
+	u32 direct_voices;  /*!< DSP voices used directly through ASND_SetVoice(). */
+	u32 stolen;         /*!< DSP voices taken from a virtual voice by a more audible one since ASND_Init(). */
+	u32 dsp_percent;    /*!< DSP usage of the last tick, in percent (see ASND_GetDSP_PercentUse()). */
+	u32 dsp_peak;       /*!< Highest DSP usage seen since ASND_Init(), in percent. */
+} ASNDVoiceStats;
+
 /*------------------------------------------------------------------------------------------------------------------------------------------------------*/
 
 /** \brief Initializes the SND lib and fixes the hardware sample rate.
@@ -365,6 +377,70 @@ s32 ASND_TestVoiceBufferReady(s32 voice);
 
 /*! @} */
 
+/*! \addtogroup virtualfuncs Virtual voice functions
+ * \details Virtual voices are not limited in number. On every tick the most audible ones (priority &times; (volume_l + volume_r)) are mapped
+ * onto the DSP voices 1 to (MAX_VOICES-1) left free by ASND_SetVoice(); the others keep their play position advancing without being mixed and
+ * resume where they would be when a DSP voice becomes available again.
+ * \note Resuming is done on the 32 bytes block containing the play position, as the DSP reads the samples from aligned addresses.
+ * @{
+ */
+
+/*! \brief Starts a PCM virtual voice.
+ * \param[in] format \ref sndsetvoiceformats to use for this sound.
+ * \param[in] pitch Frequency to use, in Hz.
+ * \param[in] delay Delay to wait before playing this voice; value is in milliseconds.
+ * \param[in] snd Buffer containing samples to play back; the buffer <b>must</b> be aligned and padded to 32 bytes!
+ * \param[in] size_snd Size of the buffer samples, in bytes.
+ * \param[in] volume_l \ref voicevol of the left channel; value can be 0 - 256 inclusive.
+ * \param[in] volume_r \ref voicevol of the right channel; value can be 0 - 256 inclusive.
+ * \param[in] priority Priority of the voice, 0 or higher; it is weighted with the volume to pick the voices that get a DSP voice.
+ * \param[in] loop If 1, the voice plays infinitely until ASND_StopVirtualVoice() is called.
+ * \return A handle for the voice functions below, or SND_INVALID. */
+s32 ASND_SetVirtualVoice(s32 format, s32 pitch, s32 delay, void *snd, s32 size_snd, s32 volume_l, s32 volume_r, s32 priority, s32 loop);
+
+/*! \brief Stops a virtual voice and releases its DSP voice.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \return SND_OK or SND_INVALID. */
+s32 ASND_StopVirtualVoice(s32 handle);
+
+/*! \brief Pauses a virtual voice; a paused voice gives its DSP voice up.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \param[in] pause If 1, the voice is paused; it can be unpaused with 0.
+ * \return SND_OK or SND_INVALID. */
+s32 ASND_PauseVirtualVoice(s32 handle, s32 pause);
+
+/*! \brief Returns the status of a virtual voice.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \return SND_UNUSED once the voice has ended or if the handle is stale, SND_WORKING while it plays on a DSP voice, SND_VIRTUAL while it
+ * advances without one, or SND_WAITING while paused. */
+s32 ASND_StatusVirtualVoice(s32 handle);
+
+/*! \brief Changes the virtual voice volume in real-time.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \param[in] volume_l \ref voicevol to set the left channel to, from 0 to 256.
+ * \param[in] volume_r \ref voicevol to set the right channel to, from 0 to 256.
+ * \return SND_OK or SND_INVALID. */
+s32 ASND_ChangeVolumeVirtualVoice(s32 handle, s32 volume_l, s32 volume_r);
+
+/*! \brief Changes the virtual voice pitch in real-time.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \param[in] pitch Frequency to use, in Hz.
+ * \return SND_OK or SND_INVALID. */
+s32 ASND_ChangePitchVirtualVoice(s32 handle, s32 pitch);
+
+/*! \brief Changes the priority of a virtual voice.
+ * \param[in] handle Virtual voice handle returned by ASND_SetVirtualVoice().
+ * \param[in] priority New priority, 0 or higher.
+ * \return SND_OK or SND_INVALID. */
+s32 ASND_ChangePriorityVirtualVoice(s32 handle, s32 priority);
+
+/*! \brief Returns the virtual and DSP voice counts and the DSP load.
+ * \param[out] stats Structure to fill in.
+ * \return None. */
+void ASND_GetVoiceStats(ASNDVoiceStats *stats);
+
+/*! @} */
+
 /*! \addtogroup dspfuncs DSP functions
  * @{
  */
@@ -57,6 +57,7 @@ distribution.
 #include "ogc/mutex.h"
 #include "ogc/message.h"
 #include "ogc/semaphore.h"
+#include "ogc/iocq.h"
 #include "ogc/pad.h"
 #include "ogc/tpl.h"
 #include "ogc/system.h"
@@ -136,6 +137,7 @@ distribution.
  * - \ref mutex.h "Thread subsystem III"
  * - \ref semaphore.h "Thread subsystem IV"
  * - \ref cond.h "Thread subsystem V"
+ * - \ref iocq.h "I/O completion queue subsystem"
  */
 
 s32 depackrnc1_ulen(void *packed);
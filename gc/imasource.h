@@ -0,0 +1,60 @@
+/*-------------------------------------------------------------
+
+imasource.h -- IMA-ADPCM streaming source for AESND voices
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __IMASOURCE_H__
+#define __IMASOURCE_H__
+
+#include <gctypes.h>
+#include <aesndlib.h>
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _imasource IMASource;
+
+/* Decodes the block layout of WAVE_FORMAT_IMA_ADPCM (0x0011) data: channels, samplerate
+   and block_align come from the fmt chunk, the data is the contents of the data chunk.
+   Mono plays on a VOICE_MONO16 voice, stereo on VOICE_STEREO16.
+
+   Like MP3Source, blocks are decoded from the AESND voice source callback, in interrupt
+   context. Decoding costs a few operations per sample and only as many blocks as one
+   stream buffer half needs, so the callback stays short; the reader has the same contract
+   as the MP3Source one: it must not block, returns the number of bytes read, 0 when no data
+   is available yet (the voice underruns) or a negative value at the end of the stream. */
+IMASource* IMASource_Create(void *cb_data,s32 (*reader)(void *,void *,s32),u32 channels,u32 samplerate,u32 block_align);
+IMASource* IMASource_CreateBuffer(const void *buffer,s32 len,u32 channels,u32 samplerate,u32 block_align);
+void IMASource_Destroy(IMASource *src);
+
+s32 IMASource_Play(IMASource *src,AESNDPB *pb,u32 delay);
+u32 IMASource_GetUnderruns(IMASource *src);
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#endif
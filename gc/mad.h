@@ -26,7 +26,9 @@ extern "C" {
 
 #include <gctypes.h>
 
-# define FPM_PPC
+# if !defined(FPM_FLOAT)
+#  define FPM_PPC
+# endif
 
 # define SIZEOF_INT 4
 # define SIZEOF_LONG 4
@@ -63,7 +65,12 @@ extern s8 const mad_build[];
 # ifndef LIBMAD_FIXED_H
 # define LIBMAD_FIXED_H
 
-# if SIZEOF_INT >= 4
+# if defined(FPM_FLOAT)
+typedef float mad_fixed_t;
+
+typedef float mad_fixed64hi_t;
+typedef float mad_fixed64lo_t;
+# elif SIZEOF_INT >= 4
 typedef s32 mad_fixed_t;
 
 typedef s32 mad_fixed64hi_t;
@@ -147,11 +154,41 @@ typedef mad_fixed_t mad_sample_t;
 # define mad_f_add(x, y)	((x) + (y))
 # define mad_f_sub(x, y)	((x) - (y))
 
+/* integer x with the given number of fractional bits */
+# define mad_f_fromscaled(x, bits)  \
+				((mad_fixed_t) (x) << (MAD_F_FRACBITS - (bits)))
+
 # if defined(FPM_FLOAT)
-#  error "FPM_FLOAT not yet supported"
 
+/*
+ * Samples are single-precision floats with MAD_F_ONE == 1.0. The constant
+ * tables are converted at compile time, and products become plain
+ * multiplies that the FPU can fuse with the following add.
+ */
 #  undef MAD_F
-#  define MAD_F(x)		mad_f_todouble(x)
+#  define MAD_F(x)		((mad_fixed_t)  \
+				 ((double) (x) / (double) (1L << MAD_F_FRACBITS)))
+
+#  undef MAD_F_MIN
+#  undef MAD_F_MAX
+#  define MAD_F_MIN		((mad_fixed_t) -8.0)
+#  define MAD_F_MAX		((mad_fixed_t) +8.0)
+
+#  undef mad_f_tofixed
+#  undef mad_f_todouble
+#  define mad_f_tofixed(x)	((mad_fixed_t) (x))
+#  define mad_f_todouble(x)	((double) (x))
+
+#  undef mad_f_intpart
+#  undef mad_f_fracpart
+#  undef mad_f_fromint
+#  define mad_f_intpart(x)	((s32) (x))
+#  define mad_f_fracpart(x)	((x) - (mad_fixed_t) (s32) (x))
+#  define mad_f_fromint(x)	((mad_fixed_t) (x))
+
+#  undef mad_f_fromscaled
+#  define mad_f_fromscaled(x, bits)  \
+				((mad_fixed_t) (x) / (mad_fixed_t) (1L << (bits)))
 
 #  define mad_f_mul(x, y)	((x) * (y))
 #  define mad_f_scale64
@@ -555,7 +592,7 @@ u16 mad_bit_crc(struct mad_bitptr, u32, u16);
 # define LIBMAD_TIMER_H
 
 typedef struct {
-  signed long seconds;		/* whole seconds */
+  s32 seconds;		/* whole seconds */
   u32 fraction;	/* 1/MAD_TIMER_RESOLUTION seconds */
 } mad_timer_t;
 
@@ -622,9 +659,9 @@ mad_timer_t mad_timer_abs(mad_timer_t);
 
 void mad_timer_set(mad_timer_t *, u32, u32, u32);
 void mad_timer_add(mad_timer_t *, mad_timer_t);
-void mad_timer_multiply(mad_timer_t *, signed long);
+void mad_timer_multiply(mad_timer_t *, s32);
 
-signed long mad_timer_count(mad_timer_t, enum mad_units);
+s32 mad_timer_count(mad_timer_t, enum mad_units);
 u32 mad_timer_fraction(mad_timer_t, u32);
 void mad_timer_string(mad_timer_t, s8 *, s8 const *,
 		      enum mad_units, enum mad_units, u32);
@@ -33,6 +33,10 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define MAX_VOICES  32
 
+#define MOD_INTERP_NONE     0
+#define MOD_INTERP_LINEAR   1
+#define MOD_INTERP_CUBIC    2
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -123,6 +127,8 @@ typedef struct _mod
     BOOL set;
     BOOL *notify;
 
+    s32 interpolation; /* MOD_INTERP_* resampling used by the mixer */
+
   } MOD;
 
 s32 MOD_SetMOD ( MOD *, u8 * );
@@ -8,12 +8,22 @@
    extern "C" {
 #endif /* __cplusplus */
 
+#define MP3PLAYER_QUALITY_LOW		0
+#define MP3PLAYER_QUALITY_MEDIUM	1
+#define MP3PLAYER_QUALITY_HIGH		2
+
 void MP3Player_Init();
 void MP3Player_Stop();
 BOOL MP3Player_IsPlaying();
 void MP3Player_Volume(u32 volume);
+void MP3Player_SetQuality(u32 quality);
+void MP3Player_SetEqualizer(f32 low,f32 mid,f32 high);
 s32 MP3Player_PlayBuffer(const void *buffer,s32 len,void (*filterfunc)(struct mad_stream *,struct mad_frame *));
 s32 MP3Player_PlayFile(void *cb_data,s32 (*reader)(void *,void *,s32),void (*filterfunc)(struct mad_stream *,struct mad_frame *));
+s32 MP3Player_PlayFileSeekable(void *cb_data,s32 (*reader)(void *,void *,s32),s32 (*seeker)(void *,s32,s32),void (*filterfunc)(struct mad_stream *,struct mad_frame *));
+s32 MP3Player_Seek(u32 ms);
+u32 MP3Player_GetPosition();
+u32 MP3Player_GetDuration();
 
 #ifdef __cplusplus
    }
@@ -0,0 +1,65 @@
+/*-------------------------------------------------------------
+
+mp3source.h -- MP3 streaming source for AESND voices
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __MP3SOURCE_H__
+#define __MP3SOURCE_H__
+
+#include <gctypes.h>
+#include <aesndlib.h>
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _mp3source MP3Source;
+
+/* The decoder runs from the AESND voice source callback, that is from the DSP interrupt
+   handler with interrupts disabled, each time the DSP enters one half of the voice's stream
+   buffer. The reader is called there too: it must not block, sleep, wait on a thread queue,
+   mutex or semaphore, or start I/O that waits for an interrupt. Feed it from a ring buffer
+   filled by a thread. It returns the number of bytes read, 0 when no data is available yet
+   (the voice underruns) or a negative value at the end of the stream.
+
+   A call decodes and synthesizes at most 3 frames, lost sync and damaged frames included;
+   when that is not enough to fill the half, the rest is silence and counts as an underrun.
+   MP3Source_Destroy stops the voice and detaches the source before freeing it, so it is
+   safe to call while the voice plays. */
+MP3Source* MP3Source_Create(void *cb_data,s32 (*reader)(void *,void *,s32));
+MP3Source* MP3Source_CreateBuffer(const void *buffer,s32 len);
+void MP3Source_Destroy(MP3Source *src);
+
+s32 MP3Source_Play(MP3Source *src,AESNDPB *pb,u32 delay);
+u32 MP3Source_GetUnderruns(MP3Source *src);
+u32 MP3Source_GetDecodeTime(MP3Source *src);
+f32 MP3Source_GetCPUUsage(MP3Source *src);
+u32 MP3Source_GetLatency(MP3Source *src);
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#endif
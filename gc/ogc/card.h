@@ -599,6 +599,45 @@ s32 CARD_SetCompany(const char *company);
 */
 s32 CARD_SetGamecode(const char *gamecode);
 
+
+/*! \fn s32 CARD_BeginTransaction(s32 chn)
+\brief Starts batching directory and FAT updates. Until the transaction is committed, create, delete, write and status changes only update the in-memory copies; the card keeps its previous consistent state. Blocks of files deleted in the transaction stay allocated until the commit, so their space cannot be reused before it.
+\param[in] chn CARD slot
+
+\return \ref card_errors "card error codes"
+*/
+s32 CARD_BeginTransaction(s32 chn);
+
+
+/*! \fn s32 CARD_CommitTransactionAsync(s32 chn,cardcallback callback)
+\brief Writes the directory and FAT changes made since CARD_BeginTransaction() back to the card: the FAT, then the directory, then the FAT once more if the transaction freed blocks. An interrupted commit can at worst leak blocks. This function returns immediately. Asynchronous version.
+\param[in] chn CARD slot
+\param[in] callback pointer to a callback function. This callback will be called when the commit has finished.
+
+\return \ref card_errors "card error codes"
+*/
+s32 CARD_CommitTransactionAsync(s32 chn,cardcallback callback);
+
+
+/*! \fn s32 CARD_CommitTransaction(s32 chn)
+\brief Writes the directory and FAT changes made since CARD_BeginTransaction() back to the card: the FAT, then the directory, then the FAT once more if the transaction freed blocks. An interrupted commit can at worst leak blocks. Synchronous version.
+\param[in] chn CARD slot
+
+\return \ref card_errors "card error codes"
+*/
+s32 CARD_CommitTransaction(s32 chn);
+
+
+/*! \fn s32 CARD_SetReadCache(s32 chn,void *buffer,u32 len)
+\brief Sets a buffer used to keep recently read data blocks, so repeated reads of the same blocks are served from memory. Blocks are only cached by reads covering them in full.
+\param[in] chn CARD slot
+\param[in] buffer 32-byte aligned buffer holding up to 16 blocks, or NULL to disable the cache.
+\param[in] len size of the buffer in bytes.
+
+\return \ref card_errors "card error codes"
+*/
+s32 CARD_SetReadCache(s32 chn,void *buffer,u32 len);
+
 #ifdef __cplusplus
    }
 #endif /* __cplusplus */
@@ -33,6 +33,10 @@ s32 CON_Init(void *framebuffer,int xstart,int ystart,int xres,int yres,int strid
 /*!
  * \fn s32 CON_InitEx(GXRModeObj *rmode, s32 conXOrigin,s32 conYOrigin,s32 conWidth,s32 conHeight)
  * \brief Initialize stdout console
+ *
+ * Text is kept in a character cell grid. On every retrace only the rows that changed since the last one are
+ * rendered and copied to the external framebuffer. A scroll or a switch to another framebuffer copies every row.
+ *
  * \param[in] rmode pointer to the video/render mode configuration
  * \param[in] conXOrigin starting pixel in X direction of the console output on the external framebuffer
  * \param[in] conYOrigin starting pixel in Y direction of the console output on the external framebuffer
@@ -43,6 +47,23 @@ s32 CON_Init(void *framebuffer,int xstart,int ystart,int xres,int yres,int strid
  */
 s32 CON_InitEx(GXRModeObj *rmode, s32 conXOrigin,s32 conYOrigin,s32 conWidth,s32 conHeight);
 
+/*!
+ * \fn s32 CON_SetFont(const void *font,int width,int height,int first,int count)
+ * \brief Replace the console font, the console is cleared and its metrics follow the new glyph size
+ *
+ * Each glyph is \a height rows of (\a width + 7) / 8 bytes, the most significant bit being the leftmost pixel.
+ * Characters outside of the font are drawn blank. The font data is not copied and must stay valid.
+ *
+ * \param[in] font pointer to the glyph bitmaps, or NULL to restore the built-in 8x16 font
+ * \param[in] width glyph width in pixel, even and at most 32
+ * \param[in] height glyph height in pixel
+ * \param[in] first character code of the first glyph
+ * \param[in] count number of glyphs
+ *
+ * \return 0 on success, <0 on error
+ */
+s32 CON_SetFont(const void *font,int width,int height,int first,int count);
+
 /*!
  * \fn CON_GetMetrics(int *cols, int *rows)
  * \brief retrieve the columns and rows of the current console
@@ -79,4 +79,36 @@ struct DISC_INTERFACE_STRUCT {
 	DISC_INTERFACE_CONST uint32_t				bytesPerSector ;
 } ;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Transfers numSectors starting at sector through the given driver function,
+ splitting the request into runs that can be passed to it directly and runs
+ that are copied through a shared pool of DMA-capable bounce buffers.
+ A read into a buffer that is only misaligned takes all but its last sector
+ by DMA to the next aligned address inside the buffer and moves them down,
+ so only that sector is bounced; writes cannot do this to the caller's data.
+ align is the buffer alignment the driver requires for DMA.
+*/
+bool disc_bounceReadSectors(DISC_INTERFACE* disc, sec_t sector, sec_t numSectors, void* buffer, uint32_t align, FN_MEDIUM_READSECTORS readSectors) ;
+bool disc_bounceWriteSectors(DISC_INTERFACE* disc, sec_t sector, sec_t numSectors, const void* buffer, uint32_t align, FN_MEDIUM_WRITESECTORS writeSectors) ;
+
+/*
+ Wraps disc in a write-back sector cache of at most cacheSize bytes.
+ Writes are held in memory and written back in the order they were first
+ written since the last write-back, sequential runs coalesced, when the cache fills up, on flush or shutdown,
+ and flushMs milliseconds after the oldest pending write if flushMs is non-zero.
+ Writes larger than half the cache bypass it after the pending ones are written.
+ The returned interface is used in place of disc until disc_cacheDestroy,
+ which writes back anything still pending.
+*/
+DISC_INTERFACE* disc_cacheCreate(DISC_INTERFACE* disc, uint32_t cacheSize, uint32_t flushMs) ;
+bool disc_cacheDestroy(DISC_INTERFACE* cache) ;
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif	// define OGC_DISC_IO_INCLUDE
@@ -100,6 +100,20 @@ distribution.
  */
 
 
+/*! 
+ * \addtogroup dvd_queuepolicy DVD command queue policies
+ * @{
+ */
+
+#define DVD_QUEUE_FIFO					0x00000000	/*!< Serve each priority level in submission order */
+#define DVD_QUEUE_ELEVATOR				0x00000001	/*!< Serve reads within a priority level in C-LOOK order */
+#define DVD_QUEUE_MERGE					0x00000002	/*!< Merge reads contiguous on disc into one transfer */
+
+/*!
+ * @}
+ */
+
+
 #ifdef __cplusplus
    extern "C" {
 #endif /* __cplusplus */
@@ -213,6 +227,27 @@ struct _dvddrvinfo {
 };
 
 
+/*!
+ * \typedef struct _dvdprefetchstats dvdprefetchstats
+ *
+ *        This structure holds the counters of the read-ahead engine.<br>
+ *		  Use DVD_GetPrefetchStats() to retrieve them.
+ *
+ * \param hits reads served entirely from prefetched data
+ * \param misses reads that had to go to the drive
+ * \param bytes_prefetched bytes read ahead from the disc
+ * \param bytes_hit bytes of reads served from prefetched data
+ * \param bytes_wasted prefetched bytes discarded without being read
+ */
+typedef struct _dvdprefetchstats {
+	u32 hits;
+	u32 misses;
+	u64 bytes_prefetched;
+	u64 bytes_hit;
+	u64 bytes_wasted;
+} dvdprefetchstats;
+
+
 /*!
  * \typedef struct _dvdfileinfo dvdfileinfo
  * \brief forward typedef for struct _dvdfileinfo
@@ -256,6 +291,67 @@ void DVD_Pause();
 void DVD_Resume();
 
 
+/*! 
+ * \fn u32 DVD_SetQueuePolicy(u32 policy)
+ * \brief Selects how pending commands are picked from the waiting queue.
+ *
+ *        With DVD_QUEUE_ELEVATOR, reads of the same priority are served in ascending offset order
+ *        from the current head position, wrapping to the lowest one. Other commands are never
+ *        reordered, and a request passed over too many times is served next regardless.
+ *
+ *        With DVD_QUEUE_MERGE, pending reads that continue the one being issued on disc are
+ *        transferred together with it. Reads that also continue it in memory are merged in place;
+ *        others, and reads a small gap further on disc, only when they fit the buffer given to
+ *        DVD_SetMergeBuffer(). Each request still completes through its own callback.
+ *
+ * \param[in] policy bitmask of \ref dvd_queuepolicy "queue policies"
+ *
+ * \return the previous policy
+ */
+u32 DVD_SetQueuePolicy(u32 policy);
+
+
+/*! 
+ * \fn s32 DVD_SetMergeBuffer(void *buffer,u32 len)
+ * \brief Sets the buffer that merged reads are transferred through when they do not continue each other in memory.
+ *
+ *        Each request's part is copied out of it from the completion interrupt.
+ *
+ * \param[in] buffer 32-byte aligned buffer, or NULL to merge only reads contiguous in memory
+ * \param[in] len size of the buffer in bytes, which bounds the length of such a merged read
+ *
+ * \return \ref dvd_errorcodes "dvd error code"
+ */
+s32 DVD_SetMergeBuffer(void *buffer,u32 len);
+
+
+/*! 
+ * \fn s32 DVD_SetPrefetch(void *buffer,u32 len)
+ * \brief Enables read-ahead for synchronous reads, such as DVD_ReadAbs() and the DISC_INTERFACE.
+ *
+ *        Once reads become sequential, the data that follows is read into a ring of buffers
+ *        carved out of the given one, at the lowest queue priority. Reads covered by the ring
+ *        are served from memory; any other read, asynchronous ones included, drops it.
+ *
+ * \param[in] buffer 32-byte aligned buffer for the ring, or NULL to disable read-ahead
+ * \param[in] len size of the buffer in bytes
+ *
+ * \return \ref dvd_errorcodes "dvd error code"
+ */
+s32 DVD_SetPrefetch(void *buffer,u32 len);
+
+
+/*! 
+ * \fn void DVD_GetPrefetchStats(dvdprefetchstats *stats)
+ * \brief Retrieves the read-ahead counters, which are reset by DVD_SetPrefetch().
+ *
+ * \param[out] stats pointer to the structure receiving the counters
+ *
+ * \return none
+ */
+void DVD_GetPrefetchStats(dvdprefetchstats *stats);
+
+
 /*! 
  * \fn void DVD_Reset(u32 reset_mode)
  * \brief Performs a reset of the drive and FW respectively.
@@ -122,6 +122,27 @@ distribution.
  */
 
 
+/*!
+ * \addtogroup exi_chainops EXI chain operations
+ * @{
+ */
+
+#define EXI_OP_SELECT				0			/*!< EXI_Select() on dev with freq */
+#define EXI_OP_SELECTSD				1			/*!< EXI_SelectSD() on dev with freq */
+#define EXI_OP_DESELECT				2			/*!< EXI_Deselect() */
+#define EXI_OP_IMM					3			/*!< immediate mode transfer of len bytes, any length */
+#define EXI_OP_DMA					4			/*!< DMA mode transfer of len bytes, 32 byte aligned */
+#define EXI_OP_POLL					5			/*!< read single bytes until (byte&mask)==value, at most len times */
+
+#define EXI_CHAIN_OK				0			/*!< all operations of the chain completed */
+#define EXI_CHAIN_ERROR				-1			/*!< an operation could not be started */
+#define EXI_CHAIN_TIMEOUT			-2			/*!< a poll operation did not see its value */
+
+/*!
+ * @}
+ */
+
+
 /*!
  * \addtogroup exi_mcident EXI memory card identifier
  * @{
@@ -152,6 +173,60 @@ distribution.
 typedef s32 (*EXICallback)(s32 chn,s32 dev);
 
 
+/*! \typedef struct _exiop exiop
+\brief a single step of an EXI chain
+\param op \ref exi_chainops "operation" to perform
+\param mode direction of transfer for EXI_OP_IMM and EXI_OP_DMA (EXI_READ,EXI_WRITE,EXI_READWRITE)
+\param dev EXI device for EXI_OP_SELECT and EXI_OP_SELECTSD
+\param freq EXI frequency for EXI_OP_SELECT and EXI_OP_SELECTSD
+\param mask,value byte to wait for with EXI_OP_POLL
+\param buf data buffer, for EXI_OP_POLL an optional u8 receiving the matching byte
+\param len length of data to transfer, for EXI_OP_POLL the maximum number of bytes to read
+*/
+typedef struct _exiop {
+	u8 op;
+	u8 mode;
+	u8 dev;
+	u8 freq;
+	u8 mask;
+	u8 value;
+	void *buf;
+	u32 len;
+} exiop;
+
+typedef struct _exichain exichain;
+
+/*! \typedef void (*EXIChainCallback)(s32 chn,s32 result,exichain *chain)
+\brief function pointer typedef for the completion callback of an EXI chain, called from interrupt context
+\param chn EXI channel
+\param result \ref exi_chainops "result" of the chain
+\param chain the completed chain
+*/
+typedef void (*EXIChainCallback)(s32 chn,s32 result,exichain *chain);
+
+/*! \typedef struct _exichain exichain
+\brief a sequence of EXI operations executed from the transfer complete interrupt
+\param ops array of operations
+\param cnt number of operations
+\param curr index of the operation in progress, or of the failed one
+\param pos progress within the current operation
+\param poll last byte read by EXI_OP_POLL
+\param result result of the chain
+\param cb completion callback
+\param usrdata user data
+*/
+struct _exichain {
+	exiop *ops;
+	u32 cnt;
+	u32 curr;
+	u32 pos;
+	u8 poll;
+	s32 result;
+	EXIChainCallback cb;
+	void *usrdata;
+};
+
+
 /*! \fn s32 EXI_ProbeEx(s32 nChn)
 \brief Performs an extended probe of the EXI channel
 \param[in] nChn EXI channel to probe
@@ -283,6 +358,29 @@ s32 EXI_Dma(s32 nChn,void *pData,u32 nLen,u32 nMode,EXICallback tc_cb);
 s32 EXI_DmaEx(s32 nChn,void *pData,u32 nLen,u32 nMode);
 
 
+/*! \fn s32 EXI_SubmitChain(s32 nChn,exichain *chain,EXIChainCallback cb)
+\brief Starts a chain of EXI operations. Each operation is started by the transfer complete interrupt of the previous one, without
+       thread involvement. If an operation fails the channel is deselected and the chain ends early.
+       The caller must hold the EXI lock of every device the chain selects until the callback has been called.
+\param[in] nChn EXI channel to run the chain on
+\param[in] chain pointer to the chain, must stay valid until completion
+\param[in] cb pointer to a callback to call when the chain has completed. May be NULL.
+
+\return 1 on success, <=0 on error
+*/
+s32 EXI_SubmitChain(s32 nChn,exichain *chain,EXIChainCallback cb);
+
+
+/*! \fn s32 EXI_RunChain(s32 nChn,exichain *chain)
+\brief Runs a chain of EXI operations and waits for its completion.
+\param[in] nChn EXI channel to run the chain on
+\param[in] chain pointer to the chain
+
+\return \ref exi_chainops "result" of the chain
+*/
+s32 EXI_RunChain(s32 nChn,exichain *chain);
+
+
 /*! \fn s32 EXI_GetState(s32 nChn)
 \brief Get the EXI state
 \param[in] nChn EXI channel to select
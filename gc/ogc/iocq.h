@@ -0,0 +1,173 @@
+/*-------------------------------------------------------------
+
+iocq.h -- I/O completion queues
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __OGC_IOCQ_H__
+#define __OGC_IOCQ_H__
+
+/*! \file iocq.h 
+\brief I/O completion queue subsystem
+
+*/ 
+
+#include <gctypes.h>
+#include <time.h>
+#include <ogc/lwp.h>
+#include <ogc/dvd.h>
+
+#define IOCQ_ERROR_OK				 0
+#define IOCQ_ERROR_OVERFLOW			-1
+#define IOCQ_ERROR_BUSY				-2
+
+#define IOCQ_SOURCE_USER			 0
+#define IOCQ_SOURCE_DVD				 1
+#define IOCQ_SOURCE_CARD			 2
+#define IOCQ_SOURCE_IPC				 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! \typedef struct _iocq_event iocq_event
+\brief a harvested completion
+\param tag the tag given to IOCQ_InitRequest()
+\param result the result the device passed to its completion callback
+\param source IOCQ_SOURCE_* of the device the request was issued to
+*/
+typedef struct _iocq_event {
+	void *tag;
+	s32 result;
+	u32 source;
+} iocq_event;
+
+/*! \typedef struct _iocq iocq
+\brief completion queue, storage is owned by the caller
+*/
+typedef struct _iocq {
+	lwpq_t waitq;
+	iocq_event *events;
+	u32 size;
+	u32 head;
+	u32 count;
+	u32 overflows;
+} iocq;
+
+/*! \typedef struct _iocq_req iocq_req
+\brief tag for one in-flight request, must stay valid until its completion has been posted
+*/
+typedef struct _iocq_req {
+	iocq *cq;
+	void *tag;
+} iocq_req;
+
+/*! \fn s32 IOCQ_Init(iocq *cq,iocq_event *events,u32 size)
+\brief Initializes a completion queue.
+\param[in] cq pointer to the queue to initialize
+\param[in] events caller provided ring of size entries holding posted completions
+\param[in] size number of entries in events
+
+\return 0 on success, negative on error
+*/
+s32 IOCQ_Init(iocq *cq,iocq_event *events,u32 size);
+
+/*! \fn s32 IOCQ_Close(iocq *cq)
+\brief Closes a completion queue, waking up all waiting threads. Requests still in flight must not be posted afterwards.
+\param[in] cq pointer to the queue
+
+\return 0 on success, negative on error; -EINVAL if the queue is already closed
+*/
+s32 IOCQ_Close(iocq *cq);
+
+/*! \fn void IOCQ_InitRequest(iocq_req *req,iocq *cq,void *tag)
+\brief Tags a request so its completion is posted to cq.
+\param[in] req pointer to the request tag
+\param[in] cq pointer to the queue to post to
+\param[in] tag user value returned in iocq_event::tag
+*/
+void IOCQ_InitRequest(iocq_req *req,iocq *cq,void *tag);
+
+/*! \fn s32 IOCQ_Post(iocq *cq,void *tag,s32 result,u32 source)
+\brief Posts a completion to the queue. May be called from interrupt context.
+\param[in] cq pointer to the queue
+\param[in] tag user value
+\param[in] result result of the operation
+\param[in] source IOCQ_SOURCE_* value
+
+\return IOCQ_ERROR_OK on success, IOCQ_ERROR_OVERFLOW if the queue is full
+*/
+s32 IOCQ_Post(iocq *cq,void *tag,s32 result,u32 source);
+
+/*! \fn s32 IOCQ_Wait(iocq *cq,iocq_event *events,u32 max,const struct timespec *reltime)
+\brief Waits until at least one completion is pending, then harvests up to max of them at once.
+\param[in] cq pointer to the queue
+\param[out] events array receiving the completions in posting order
+\param[in] max number of entries in events
+\param[in] reltime pointer to a timespec structure holding the relative time for the timeout. If NULL, wait forever.
+
+\return number of completions harvested, 0 on timeout, negative on error
+*/
+s32 IOCQ_Wait(iocq *cq,iocq_event *events,u32 max,const struct timespec *reltime);
+
+/*! \fn s32 IOCQ_Poll(iocq *cq,iocq_event *events,u32 max)
+\brief Harvests up to max pending completions without blocking.
+\param[in] cq pointer to the queue
+\param[out] events array receiving the completions in posting order
+\param[in] max number of entries in events
+
+\return number of completions harvested
+*/
+s32 IOCQ_Poll(iocq *cq,iocq_event *events,u32 max);
+
+/*! \fn void IOCQ_DVDCallback(s32 result,dvdcmdblk *block)
+\brief dvdcbcallback that posts to the queue of the iocq_req set with DVD_SetUserData().
+*/
+void IOCQ_DVDCallback(s32 result,dvdcmdblk *block);
+
+/*! \fn s32 IOCQ_IPCCallback(s32 result,void *usrdata)
+\brief ipccallback/isfscallback/usbcallback that posts to the queue of the iocq_req passed as usrdata.
+*/
+s32 IOCQ_IPCCallback(s32 result,void *usrdata);
+
+/*! \fn s32 IOCQ_CARDBind(s32 chn,iocq_req *req)
+\brief Binds req to the next asynchronous operation on memory card slot chn that uses IOCQ_CARDCallback.
+       The binding is dropped when the callback runs; if the CARD_*Async() call fails, drop it by binding NULL.
+\param[in] chn CARD slot
+\param[in] req pointer to the request tag, or NULL to unbind
+
+\return IOCQ_ERROR_OK on success, IOCQ_ERROR_BUSY if a request is still bound to chn, -EINVAL if chn is not a CARD slot
+*/
+s32 IOCQ_CARDBind(s32 chn,iocq_req *req);
+
+/*! \fn void IOCQ_CARDCallback(s32 chn,s32 result)
+\brief cardcallback that posts to the queue of the iocq_req bound to chn.
+*/
+void IOCQ_CARDCallback(s32 chn,s32 result);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
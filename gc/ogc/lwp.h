@@ -80,6 +80,14 @@ distribution.
 #define LWP_THREAD_NULL				0xffffffff
 #define LWP_TQUEUE_NULL				0xffffffff
 
+#define LWP_OBJECTS_THREAD			  1
+#define LWP_OBJECTS_TQUEUE			  2
+#define LWP_OBJECTS_MUTEX			  3
+#define LWP_OBJECTS_SEMA			  4
+#define LWP_OBJECTS_COND			  5
+#define LWP_OBJECTS_MQUEUE			  6
+#define LWP_OBJECTS_ALARM			  7
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -96,6 +104,26 @@ typedef u32 lwp_t;
 */
 typedef u32 lwpq_t;
 
+
+/*! \typedef void (*lwpstackcallback)(lwp_t thethread)
+\brief function pointer typedef for the stack overflow callback
+\param[in] thethread handle of the thread whose stack guard was found destroyed
+*/
+typedef void (*lwpstackcallback)(lwp_t thethread);
+
+
+/*! \typedef struct _lwp_objstats lwp_objstats
+\brief object table usage of one kernel object type
+\param allocated number of objects the table currently has room for
+\param inuse number of objects currently in use
+\param peak highest number of objects in use at any one time since SYS_Init()
+*/
+typedef struct _lwp_objstats {
+	u32 allocated;
+	u32 inuse;
+	u32 peak;
+} lwp_objstats;
+
 /*! \fn s32 LWP_CreateThread(lwp_t *thethread,void* (*entry)(void *),void *arg,void *stackbase,u32 stack_size,u8 prio)
 \brief Spawn a new thread with the given parameters
 \param[out] thethread pointer to a lwp_t handle
@@ -163,6 +191,32 @@ lwp_t LWP_GetSelf();
 s32 LWP_GetThreadStackSize(lwp_t thethread);
 
 
+/*! \fn s32 LWP_GetThreadStackUsage(lwp_t thethread)
+\brief Get the peak stack usage of the given thread. Stacks are painted when the thread is created, so this is the deepest point reached since then.
+\param[in] thethread handle to the thread context whose stack usage should be returned. If NULL, the current thread will be taken.
+
+\return peak number of stack bytes used
+*/
+s32 LWP_GetThreadStackUsage(lwp_t thethread);
+
+
+/*! \fn void LWP_SetStackOverflowCallback(lwpstackcallback cb)
+\brief Enable checking the stack guard of each thread that is switched out, and set the callback to run when it has been overwritten.
+\param[in] cb callback to run on overflow, or NULL to disable the check.
+
+\return none
+*/
+void LWP_SetStackOverflowCallback(lwpstackcallback cb);
+
+
+/*! \fn void LWP_ReportStackUsage()
+\brief Print the stack size and peak stack usage of every thread through SYS_Report().
+
+\return none
+*/
+void LWP_ReportStackUsage();
+
+
 /*! \fn s32 LWP_GetThreadPriority(lwp_t thethread)
 \brief Get the priority of the given thread.
 \param[in] thethread handle to the thread context whose priority should be returned. If NULL, the current thread will be taken.
@@ -302,6 +356,16 @@ s32 LWP_ThreadSignal(lwpq_t thequeue);
 */
 s32 LWP_ThreadBroadcast(lwpq_t thequeue);
 
+
+/*! \fn s32 LWP_GetObjectStats(u32 type,lwp_objstats *stats)
+\brief Get the usage and high-water mark of a kernel object table, e.g. to right-size the __lwp_max_* settings in lwp_config.h.
+\param[in] type object type, one of LWP_OBJECTS_*
+\param[out] stats pointer to a lwp_objstats structure to fill
+
+\return 0 on success, non-zero on error
+*/
+s32 LWP_GetObjectStats(u32 type,lwp_objstats *stats);
+
 #ifdef __cplusplus
 	}
 #endif
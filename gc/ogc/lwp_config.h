@@ -54,6 +54,11 @@ distribution.
 #ifndef __OGC_LWP_CONFIG_H__
 #define __OGC_LWP_CONFIG_H__
 
+#include <gctypes.h>
+
+#define LWP_UNLIMITED_OBJECTS		0x80000000
+#define LWP_UNLIMITED(n)			((n)|LWP_UNLIMITED_OBJECTS)
+
 #define LWP_MAX_MQUEUES				64
 
 #define LWP_MAX_MUTEXES				64
@@ -68,4 +73,24 @@ distribution.
 
 #define LWP_MAX_WATCHDOGS			64
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Object table sizes used by SYS_Init(). An application may override any of
+ * these by defining the variable itself, e.g. u32 __lwp_max_threads = 4;
+ * Wrapping the count in LWP_UNLIMITED() lets the table grow in blocks of that
+ * many objects when it runs out, which is the default for all of them. */
+extern u32 __lwp_max_threads;
+extern u32 __lwp_max_tqueues;
+extern u32 __lwp_max_mutexes;
+extern u32 __lwp_max_semas;
+extern u32 __lwp_max_condvars;
+extern u32 __lwp_max_mqueues;
+extern u32 __lwp_max_watchdogs;
+
+#ifdef __cplusplus
+	}
+#endif
+
 #endif
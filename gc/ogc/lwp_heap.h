@@ -63,7 +63,7 @@ distribution.
 #define HEAP_DUMMY_FLAG					(0+HEAP_BLOCK_USED)
 
 #define HEAP_OVERHEAD					(sizeof(u32)*2)
-#define HEAP_BLOCK_USED_OVERHEAD		(sizeof(void*)*2)
+#define HEAP_BLOCK_USED_OVERHEAD		(sizeof(u32)*2)
 #define HEAP_MIN_SIZE					(HEAP_OVERHEAD+sizeof(heap_block))
 
 #ifdef __cplusplus
@@ -61,6 +61,8 @@ distribution.
 #define LWP_OBJMASKID(id)			((id)&0xffff)
 #define LWP_OBJTYPE(id)				((id)>>16)
 
+#define LWP_OBJ_MAXNODES			0xffff
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -82,6 +84,9 @@ struct _lwp_objinfo {
 	void *obj_blocks;
 	lwp_queue inactives;
 	u32 inactives_cnt;
+	u32 objs_per_block;
+	u32 peak_cnt;
+	BOOL auto_extend;
 };
 
 void __lwp_objmgr_initinfo(lwp_objinfo *info,u32 max_nodes,u32 node_size);
@@ -90,6 +95,7 @@ lwp_obj* __lwp_objmgr_allocate(lwp_objinfo *info);
 lwp_obj* __lwp_objmgr_get(lwp_objinfo *info,u32 id);
 lwp_obj* __lwp_objmgr_getisrdisable(lwp_objinfo *info,u32 id,u32 *p_level);
 lwp_obj* __lwp_objmgr_getnoprotection(lwp_objinfo *info,u32 id);
+void __lwp_objmgr_getstats(lwp_objinfo *info,u32 *p_allocated,u32 *p_inuse,u32 *p_peak);
 
 #ifdef LIBOGC_INTERNAL
 #include <libogc/lwp_objmgr.inl>
@@ -61,12 +61,18 @@ distribution.
 #define CPU_MINIMUM_STACK_SIZE			1024*8
 #define CPU_MINIMUM_STACK_FRAME_SIZE	8
 
+#define CPU_STACK_MAGIC					0xDEADBABE
+#define CPU_STACK_PAINT					0xC5C5C5C5
+#define CPU_STACK_GUARD_WORDS			4
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 u32 __lwp_stack_allocate(lwp_cntrl *,u32);
 void __lwp_stack_free(lwp_cntrl *);
+void __lwp_stack_paint(lwp_cntrl *);
+u32 __lwp_stack_used(lwp_cntrl *);
 
 #ifdef LIBOGC_INTERNAL
 #include <libogc/lwp_stack.inl>
@@ -88,6 +88,7 @@ typedef struct _lwpwaitinfo {
 	void *ret_arg_1;
 	u32 option;
 	u32 ret_code;
+	u32 prio;
 	lwp_queue block2n;
 	lwp_thrqueue *queue;
 } lwp_waitinfo;
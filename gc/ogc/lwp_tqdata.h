@@ -54,9 +54,8 @@ distribution.
 #ifndef __OGC_LWP_TQDATA_H__
 #define __OGC_LWP_TQDATA_H__
 
-#define LWP_THREADQ_NUM_PRIOHEADERS		4
-#define LWP_THREADQ_PRIOPERHEADER		64
-#define LWP_THREADQ_REVERSESEARCHMASK	0x20
+#define LWP_THREADQ_NUM_PRIOHEADERS		16
+#define LWP_THREADQ_PRIOPERHEADER		16
 
 #define LWP_THREADQ_SYNCHRONIZED		0
 #define LWP_THREADQ_NOTHINGHAPPEND		1
@@ -78,6 +77,8 @@ typedef struct _lwpthrqueue {
 		lwp_queue fifo;
 		lwp_queue priority[LWP_THREADQ_NUM_PRIOHEADERS];
 	} queues;
+	u32 prio_major;
+	u32 prio_minor[LWP_THREADQ_NUM_PRIOHEADERS];
 	u32 sync_state;
 	u32 mode;
 	u32 state;
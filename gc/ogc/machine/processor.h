@@ -39,6 +39,9 @@
 		asm volatile("mfdec %0" : "=r" (_rval)); _rval;})
 #define mtdec(_val)  asm volatile("mtdec %0" : : "r" (_val))
 
+#define mfsp()   ({register u32 _rval; \
+		asm volatile("mr %0,%%r1" : "=r" (_rval)); _rval;})
+
 #define mfspr(_rn) \
 ({	register u32 _rval = 0; \
 	asm volatile("mfspr %0," __stringify(_rn) \
@@ -36,7 +36,9 @@ distribution.
 #if defined(HW_RVL)
 
 #include <gctypes.h>
+#include <ogc/lwp.h>
 #include <ogc/mutex.h>
+#include <ogc/message.h>
 #include <ogc/disc_io.h>
 #include <ogc/system.h>
 
@@ -81,8 +83,27 @@ typedef struct
 	u8 suspended;
 
 	u8 *buffer;
+
+	mqbox_t reqbox;
+	lwp_t worker;
 } usbstorage_handle;
 
+typedef struct _usbstorage_req usbstorage_req;
+typedef void (*usbstorage_callback)(s32 result, usbstorage_req *req);
+
+struct _usbstorage_req
+{
+	usbstorage_handle *dev;
+	u8 lun;
+	u8 write;
+	u64 sector;
+	u32 n_sectors;
+	void *buffer;
+	s32 result;
+	usbstorage_callback cb;
+	void *usrdata;
+};
+
 #define B_RAW_DEVICE_DATA_IN 0x01
 #define B_RAW_DEVICE_COMMAND 0
 
@@ -110,6 +131,8 @@ s32 USBStorage_ioctl(int request, ...);
 s32 USBStorage_ReadCapacity(usbstorage_handle *dev, u8 lun, u32 *sector_size, u64 *n_sectors);
 s32 USBStorage_Read(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors, u8 *buffer);
 s32 USBStorage_Write(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors, const u8 *buffer);
+s32 USBStorage_ReadAsync(usbstorage_handle *dev, usbstorage_req *req, u8 lun, u64 sector, u32 n_sectors, u8 *buffer, usbstorage_callback cb, void *usrdata);
+s32 USBStorage_WriteAsync(usbstorage_handle *dev, usbstorage_req *req, u8 lun, u64 sector, u32 n_sectors, const u8 *buffer, usbstorage_callback cb, void *usrdata);
 s32 USBStorage_StartStop(usbstorage_handle *dev, u8 lun, u8 lo_ej, u8 start, u8 imm);
 
 #define DEVICE_TYPE_WII_USB (('W'<<24)|('U'<<16)|('S'<<8)|'B')
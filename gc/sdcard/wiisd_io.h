@@ -40,6 +40,49 @@
 
 #define DEVICE_TYPE_WII_SD (('W'<<24)|('S'<<16)|('D'<<8)|'0')
 
+typedef struct _sdio_segment
+{
+	void *buffer;
+	u32 numSectors;
+} sdio_segment;
+
+typedef struct _sdio_request sdio_request;
+typedef void (*sdio_callback)(s32 result, sdio_request *req);
+
+struct _sdio_request
+{
+	sdio_request *next;
+	sdio_segment *segs;
+	u32 numSegs;
+	sec_t sector;
+	u8 write;
+	s32 result;
+	sdio_callback cb;
+	void *usrdata;
+
+	u32 seg;
+	u32 pos;
+	u32 done;
+	u32 pending;
+};
+
 extern DISC_INTERFACE __io_wiisd;
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Queues a transfer of consecutive sectors starting at sector, scattered over
+ numSegs DMA-capable buffers. Requests run in submission order, back to back,
+ without deselecting the card in between. cb is called from interrupt context
+ once the request is done; req and segs must stay valid until then.
+*/
+s32 sdio_ReadAsync(sdio_request *req, sec_t sector, sdio_segment *segs, u32 numSegs, sdio_callback cb, void *usrdata);
+s32 sdio_WriteAsync(sdio_request *req, sec_t sector, sdio_segment *segs, u32 numSegs, sdio_callback cb, void *usrdata);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
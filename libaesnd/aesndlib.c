@@ -9,13 +9,18 @@
 #include "aesndlib.h"
 #include "dspmixer.h"
 
-#define PB_STRUCT_SIZE			64
+#define PB_STRUCT_SIZE			96
 #define DSP_DRAMSIZE			8192
 
 #define VOICE_PAUSE				0x00000008
 #define VOICE_LOOP				0x00000010
 #define VOICE_ONCE				0x00000020
 #define VOICE_STREAM			0x00000040
+#define VOICE_ADPCM				0x00000080
+#define VOICE_LOOPCTX			0x00000100
+#define VOICE_SOURCEEND			0x00000200
+#define VOICE_SOURCESHORT		0x00000400
+#define VOICE_SOURCEDONE		0x00000800
 
 #define VOICE_FINISHED			0x00100000
 #define VOICE_STOPPED			0x00200000
@@ -45,7 +50,17 @@ struct aesndpb_t
 
 	u32 flags;					//40
 
-	u8 _pad[20];
+	u16 loop_pds;				//44
+	u16 loop_yn1;				//46
+	u16 loop_yn2;				//48
+	u16 ring_pds;				//50
+
+	u32 loop_start;				//52
+	u32 loop_end;				//56
+
+	u8 _pad1[4];				//60
+
+	s16 coefs[16];				//64
 
 	u32 mram_start;
 	u32 mram_curr;
@@ -56,6 +71,10 @@ struct aesndpb_t
 	u32 shift;
 	AESNDVoiceCallback cb;
 	void *usr_data;
+
+	AESNDSourceCallback source;
+	void *source_arg;
+	u32 underruns;
 	
 	AESNDAudioCallback audioCB;
 } ATTRIBUTE_PACKED;
@@ -69,6 +88,9 @@ static vu32 __aesndcurrvoice = MAX_VOICES;
 static vu32 __aesnddspcomplete = 0;
 static vu64 __aesnddspstarttime = 0;
 static vu64 __aesnddspprocesstime = 0;
+static vu64 __aesnddspprocesspeak = 0;
+static vu32 __aesnddspvoicecount = 0;
+static vu32 __aesnddspvoices = 0;
 static volatile bool __aesndglobalpause = false;
 static volatile bool __aesndvoicesstopped = true;
 
@@ -107,6 +129,14 @@ static __inline__ void __aesndcopycommand(AESNDPB *dst,AESNDPB *src)
 	dst->flags = src->flags;
 	dst->delay = src->delay;
 
+	dst->loop_pds = src->loop_pds;
+	dst->loop_yn1 = src->loop_yn1;
+	dst->loop_yn2 = src->loop_yn2;
+	dst->ring_pds = src->ring_pds;
+	dst->loop_start = src->loop_start;
+	dst->loop_end = src->loop_end;
+	memcpy(dst->coefs,src->coefs,sizeof(dst->coefs));
+
 	dst->mram_start = src->mram_start;
 	dst->mram_curr = src->mram_curr;
 	dst->mram_end = src->mram_end;
@@ -116,11 +146,21 @@ static __inline__ void __aesndcopycommand(AESNDPB *dst,AESNDPB *src)
 	dst->shift = src->shift;
 	dst->cb = src->cb;
 	dst->usr_data = src->usr_data;
+
+	dst->source = src->source;
+	dst->source_arg = src->source_arg;
+	dst->underruns = src->underruns;
 }
 
 static __inline__ void __aesndsetvoiceformat(AESNDPB *pb,u32 format)
 {
-	pb->flags = (pb->flags&~0x07)|(format&0x07);
+	if(format==VOICE_MONO_ADPCM) {
+		pb->flags = (pb->flags&~(0x07|VOICE_LOOPCTX))|(VOICE_ADPCM|VOICE_MONO16);
+		pb->shift = 0;
+		return;
+	}
+
+	pb->flags = (pb->flags&~(0x07|VOICE_ADPCM|VOICE_LOOPCTX))|(format&0x07);
 	switch((format&0x07)) {
 		case VOICE_MONO8:
 		case VOICE_STEREO8:
@@ -137,6 +177,74 @@ static __inline__ void __aesndsetvoiceformat(AESNDPB *pb,u32 format)
 	}
 }
 
+// accelerator address of a stream buffer location: ADPCM is addressed in nibbles
+static __inline__ u32 __aesndbufaddr(AESNDPB *pb,u32 addr)
+{
+	if(pb->flags&VOICE_ADPCM) return (addr<<1);
+	return (addr>>pb->shift);
+}
+
+// ADPCM restarts skip the 2 nibble frame header: the DSP supplies pred/scale from the PB instead
+static __inline__ u32 __aesndbufstart(AESNDPB *pb,u32 addr)
+{
+	if(pb->flags&VOICE_ADPCM) return (addr<<1) + 2;
+	return (addr>>pb->shift);
+}
+
+// ADPCM loops restart the decoder from the loop context at the head of the refilled half
+static __inline__ void __aesndsetloopcontext(AESNDPB *pb,u32 buf_addr,u32 buffer)
+{
+	if((pb->flags&(VOICE_ADPCM|VOICE_LOOP|VOICE_STREAM))!=(VOICE_ADPCM|VOICE_LOOP)) return;
+	if(pb->source || pb->mram_curr!=pb->mram_start) return;
+
+	pb->loop_start = __aesndbufstart(pb,buf_addr);
+	pb->loop_end = buffer ? (__aesndbufaddr(pb,buf_addr) - 1) : pb->buf_end;
+	pb->flags |= VOICE_LOOPCTX;
+}
+
+// reads the next stream data, from the voice buffer or decoded in place by the voice source
+static u32 __aesndreadsource(AESNDPB *pb,void *buffer,u32 len)
+{
+	register u32 copy_len;
+	register s32 ret;
+
+	if(pb->source) {
+		/* asked again after the end: the DSP is done with the half that holds the last data */
+		if(pb->flags&VOICE_SOURCEEND) {
+			pb->flags |= VOICE_SOURCEDONE;
+			return 0;
+		}
+
+		ret = pb->source(pb,buffer,len,pb->source_arg);
+		if(ret<0) {
+			pb->flags = (pb->flags&~VOICE_SOURCESHORT)|VOICE_SOURCEEND;
+			return 0;
+		}
+
+		/* a short read is an underrun once the source goes on, not when it was the last one */
+		if(pb->flags&VOICE_SOURCESHORT) pb->underruns++;
+		if((u32)ret<len)
+			pb->flags |= VOICE_SOURCESHORT;
+		else
+			pb->flags &= ~VOICE_SOURCESHORT;
+		return ret;
+	}
+
+	copy_len = (pb->mram_end - pb->mram_curr);
+	if(copy_len>len) copy_len = len;
+
+	memcpy(buffer,(void*)pb->mram_curr,copy_len);
+	pb->mram_curr += copy_len;
+
+	return copy_len;
+}
+
+static __inline__ bool __aesndsourcedone(AESNDPB *pb)
+{
+	if(pb->source) return ((pb->flags&VOICE_SOURCEDONE)!=0);
+	return (pb->mram_curr>=pb->mram_end);
+}
+
 static __inline__ void __aesndsetvoicebuffer(AESNDPB *pb,void* buffer,u32 len)
 {
 	pb->mram_start = (u32)buffer;
@@ -170,16 +278,14 @@ static void __aesndfillbuffer(AESNDPB *pb,u32 buffer)
 	buf_addr = __aesndaramblocks[pb->voiceno];
 	if(buffer) buf_addr += DSP_STREAMBUFFER_SIZE;
 
-	copy_len = (pb->mram_end - pb->mram_curr);
-	if(copy_len>DSP_STREAMBUFFER_SIZE) copy_len = DSP_STREAMBUFFER_SIZE;
+	__aesndsetloopcontext(pb,buf_addr,buffer);
 
-	memcpy(stream_buffer,(void*)pb->mram_curr,copy_len);
+	copy_len = __aesndreadsource(pb,stream_buffer,DSP_STREAMBUFFER_SIZE);
 	if(copy_len<DSP_STREAMBUFFER_SIZE) memset(stream_buffer + copy_len,0,DSP_STREAMBUFFER_SIZE - copy_len);
+	if(!buffer && pb->flags&VOICE_ADPCM) pb->ring_pds = stream_buffer[0];
 
 	DCFlushRange(stream_buffer,DSP_STREAMBUFFER_SIZE);
 	ARQ_PostRequestAsync(&arq_request[pb->voiceno],pb->voiceno,ARQ_MRAMTOARAM,ARQ_PRIO_HI,buf_addr,MEM_VIRTUAL_TO_PHYSICAL(stream_buffer),DSP_STREAMBUFFER_SIZE,NULL);
-
-	pb->mram_curr += copy_len;
 }
 
 static __inline__ void __aesndhandlerequest(AESNDPB *pb)
@@ -187,7 +293,7 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 	register u32 buf_addr;
 	register u32 copy_len;
 
-	if(pb->mram_curr>=pb->mram_end) {
+	if(__aesndsourcedone(pb)) {
 		if(pb->flags&VOICE_STREAM && pb->cb)
 			pb->cb(pb,VOICE_STATE_STREAM);
 		if(pb->flags&VOICE_ONCE) {
@@ -200,8 +306,8 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 		register u32 curr_pos = pb->buf_curr;
 		if(curr_pos<pb->stream_last)
 			__aesndfillbuffer(pb,1);
-		if(curr_pos>=(pb->buf_start + (DSP_STREAMBUFFER_SIZE>>pb->shift)) &&
-		   pb->stream_last<(pb->buf_start + (DSP_STREAMBUFFER_SIZE>>pb->shift)))
+		if(curr_pos>=(pb->buf_start + __aesndbufaddr(pb,DSP_STREAMBUFFER_SIZE)) &&
+		   pb->stream_last<(pb->buf_start + __aesndbufaddr(pb,DSP_STREAMBUFFER_SIZE)))
 			__aesndfillbuffer(pb,0);
 
 		pb->stream_last = curr_pos;
@@ -209,20 +315,16 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 	}
 
 	buf_addr = __aesndaramblocks[pb->voiceno];
-	pb->buf_start = buf_addr>>pb->shift;
-	pb->buf_end = (buf_addr + (DSP_STREAMBUFFER_SIZE*2) - (1<<pb->shift))>>pb->shift;
+	pb->buf_start = __aesndbufstart(pb,buf_addr);
+	pb->buf_end = __aesndbufaddr(pb,buf_addr + (DSP_STREAMBUFFER_SIZE*2)) - 1;
 	pb->buf_curr = pb->buf_start;
 
-	copy_len = (pb->mram_end - pb->mram_curr);
-	if(copy_len>(DSP_STREAMBUFFER_SIZE*2)) copy_len = (DSP_STREAMBUFFER_SIZE*2);
-
-	memcpy(stream_buffer,(void*)pb->mram_curr,copy_len);
+	copy_len = __aesndreadsource(pb,stream_buffer,(DSP_STREAMBUFFER_SIZE*2));
 	if(copy_len<(DSP_STREAMBUFFER_SIZE*2)) memset(stream_buffer + copy_len,0,(DSP_STREAMBUFFER_SIZE*2) - copy_len);
+	if(pb->flags&VOICE_ADPCM) pb->pds = pb->ring_pds = stream_buffer[0];
 
 	DCFlushRange(stream_buffer,(DSP_STREAMBUFFER_SIZE*2));
 	ARQ_PostRequestAsync(&arq_request[pb->voiceno],pb->voiceno,ARQ_MRAMTOARAM,ARQ_PRIO_HI,buf_addr,MEM_VIRTUAL_TO_PHYSICAL(stream_buffer),(DSP_STREAMBUFFER_SIZE*2),__aesndarqcallback);
-
-	pb->mram_curr += copy_len;
 }
 #elif defined(HW_RVL)
 static u8 stream_buffer[MAX_VOICES][DSP_STREAMBUFFER_SIZE*2] ATTRIBUTE_ALIGN(32);
@@ -235,15 +337,13 @@ static void __aesndfillbuffer(AESNDPB *pb,u32 buffer)
 	buf_addr = (u32)stream_buffer[pb->voiceno];
 	if(buffer) buf_addr += DSP_STREAMBUFFER_SIZE;
 
-	copy_len = (pb->mram_end - pb->mram_curr);
-	if(copy_len>DSP_STREAMBUFFER_SIZE) copy_len = DSP_STREAMBUFFER_SIZE;
+	__aesndsetloopcontext(pb,MEM_VIRTUAL_TO_PHYSICAL(buf_addr),buffer);
 
-	memcpy((void*)buf_addr,(void*)pb->mram_curr,copy_len);
+	copy_len = __aesndreadsource(pb,(void*)buf_addr,DSP_STREAMBUFFER_SIZE);
 	if(copy_len<DSP_STREAMBUFFER_SIZE) memset((void*)(buf_addr + copy_len),0,DSP_STREAMBUFFER_SIZE - copy_len);
+	if(!buffer && pb->flags&VOICE_ADPCM) pb->ring_pds = *(u8*)buf_addr;
 
 	DCFlushRange((void*)buf_addr,DSP_STREAMBUFFER_SIZE);
-
-	pb->mram_curr += copy_len;
 }
 
 static __inline__ void __aesndhandlerequest(AESNDPB *pb)
@@ -251,7 +351,7 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 	register u32 buf_addr;
 	register u32 copy_len;
 
-	if(pb->mram_curr>=pb->mram_end) {
+	if(__aesndsourcedone(pb)) {
 		if(pb->flags&VOICE_STREAM && pb->cb)
 			pb->cb(pb,VOICE_STATE_STREAM);
 		if(pb->flags&VOICE_ONCE) {
@@ -265,8 +365,8 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 		register u32 curr_pos = pb->buf_curr;
 		if(curr_pos<pb->stream_last)
 			__aesndfillbuffer(pb,1);
-		if(curr_pos>=(pb->buf_start + (DSP_STREAMBUFFER_SIZE>>pb->shift)) &&
-		   pb->stream_last<(pb->buf_start + (DSP_STREAMBUFFER_SIZE>>pb->shift)))
+		if(curr_pos>=(pb->buf_start + __aesndbufaddr(pb,DSP_STREAMBUFFER_SIZE)) &&
+		   pb->stream_last<(pb->buf_start + __aesndbufaddr(pb,DSP_STREAMBUFFER_SIZE)))
 			__aesndfillbuffer(pb,0);
 
 		pb->stream_last = curr_pos;
@@ -274,19 +374,16 @@ static __inline__ void __aesndhandlerequest(AESNDPB *pb)
 	}
 
 	buf_addr = MEM_VIRTUAL_TO_PHYSICAL(stream_buffer[pb->voiceno]);
-	pb->buf_start = buf_addr>>pb->shift;
-	pb->buf_end = (buf_addr + (DSP_STREAMBUFFER_SIZE*2) - (1<<pb->shift))>>pb->shift;
+	pb->buf_start = __aesndbufstart(pb,buf_addr);
+	pb->buf_end = __aesndbufaddr(pb,buf_addr + (DSP_STREAMBUFFER_SIZE*2)) - 1;
 	pb->buf_curr = pb->buf_start;
 
-	copy_len = (pb->mram_end - pb->mram_curr);
-	if(copy_len>(DSP_STREAMBUFFER_SIZE*2)) copy_len = (DSP_STREAMBUFFER_SIZE*2);
-
-	memcpy(stream_buffer[pb->voiceno],(void*)pb->mram_curr,copy_len);
+	copy_len = __aesndreadsource(pb,stream_buffer[pb->voiceno],(DSP_STREAMBUFFER_SIZE*2));
 	if(copy_len<(DSP_STREAMBUFFER_SIZE*2)) memset(stream_buffer[pb->voiceno] + copy_len,0,(DSP_STREAMBUFFER_SIZE*2) - copy_len);
+	if(pb->flags&VOICE_ADPCM) pb->pds = pb->ring_pds = stream_buffer[pb->voiceno][0];
 
 	DCFlushRange(stream_buffer[pb->voiceno],(DSP_STREAMBUFFER_SIZE*2));
 
-	pb->mram_curr += copy_len;
 	pb->flags |= VOICE_RUNNING;
 }
 #endif
@@ -306,6 +403,8 @@ static void __dsp_initcallback(dsptask_t *task)
 static void __dsp_resumecallback(dsptask_t *task)
 {
 	__aesnddspprocesstime = (gettime() - __aesnddspstarttime);
+	if(__aesnddspprocesstime>__aesnddspprocesspeak) __aesnddspprocesspeak = __aesnddspprocesstime;
+	__aesnddspvoices = __aesnddspvoicecount;
 	__aesnddspcomplete = 1;
 }
 
@@ -330,6 +429,7 @@ static void __dsp_requestcallback(dsptask_t *task)
 			if(__aesndcommand.cb) __aesndcommand.cb(&__aesndcommand,VOICE_STATE_RUNNING);
 
 			DCFlushRange(&__aesndcommand,PB_STRUCT_SIZE);
+			__aesnddspvoicecount++;
 			DSP_SendMailTo(0xface0020);
 			while(DSP_CheckMailTo());
 			return;
@@ -367,6 +467,7 @@ static void __audio_dma_callback()
 	__aesndcurrvoice = 0;
 	__aesnddspcomplete = 0;
 	__aesnddspprocesstime = 0;
+	__aesnddspvoicecount = 0;
 	while(__aesndcurrvoice<MAX_VOICES && (!(__aesndvoicepb[__aesndcurrvoice].flags&VOICE_USED) || (__aesndvoicepb[__aesndcurrvoice].flags&VOICE_STOPPED))) __aesndcurrvoice++;
 	if(__aesndcurrvoice>=MAX_VOICES) {
 		__aesndvoicesstopped = true;
@@ -385,6 +486,7 @@ static void __audio_dma_callback()
 	__aesndcommand.out_buf = MEM_VIRTUAL_TO_PHYSICAL(audio_buffer[__aesndcurrab]);
 	DCFlushRange(&__aesndcommand,PB_STRUCT_SIZE);
 
+	__aesnddspvoicecount = 1;
 	__aesnddspstarttime = gettime();
 	DSP_SendMailTo(0xface0010);
 	while(DSP_CheckMailTo());
@@ -516,6 +618,24 @@ f32 AESND_GetDSPProcessUsage()
 	return usage;
 }
 
+u32 AESND_GetDSPProcessPeak()
+{
+	u32 level;
+	u32 time = 0;
+
+	_CPU_ISR_Disable(level);
+	time = ticks_to_microsecs(__aesnddspprocesspeak);
+	__aesnddspprocesspeak = 0;
+	_CPU_ISR_Restore(level);
+
+	return time;
+}
+
+u32 AESND_GetDSPVoiceCount()
+{
+	return __aesnddspvoices;
+}
+
 AESNDAudioCallback AESND_RegisterAudioCallback(AESNDAudioCallback cb)
 {
 	u32 level;
@@ -579,7 +699,7 @@ void AESND_PlayVoice(AESNDPB *pb,u32 format,const void *buffer,u32 len,u32 freq,
 	__aesndsetvoicefreq(pb,freq);
 	__aesndsetvoicebuffer(pb,ptr,len);
 
-	pb->flags &= ~(VOICE_RUNNING|VOICE_STOPPED|VOICE_LOOP|VOICE_ONCE);
+	pb->flags &= ~(VOICE_RUNNING|VOICE_STOPPED|VOICE_LOOP|VOICE_ONCE|VOICE_LOOPCTX|VOICE_SOURCEEND|VOICE_SOURCESHORT|VOICE_SOURCEDONE);
 	if(looped==true) 
 		pb->flags |= VOICE_LOOP;
 	else
@@ -587,7 +707,7 @@ void AESND_PlayVoice(AESNDPB *pb,u32 format,const void *buffer,u32 len,u32 freq,
 
 	pb->buf_start = pb->buf_curr = pb->buf_end = pb->stream_last = 0;
 	pb->delay = (delay*48);
-	pb->pds = pb->yn1 = pb->yn2 = 0;
+	pb->pds = pb->yn1 = pb->yn2 = pb->ring_pds = 0;
 	pb->counter = 0;
 	_CPU_ISR_Restore(level);
 }
@@ -602,6 +722,38 @@ void AESND_SetVoiceBuffer(AESNDPB *pb,const void *buffer,u32 len)
 	_CPU_ISR_Restore(level);
 }
 
+void AESND_SetVoiceSource(AESNDPB *pb,AESNDSourceCallback source,void *cb_arg)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	pb->source = source;
+	pb->source_arg = cb_arg;
+	pb->underruns = 0;
+	pb->flags &= ~(VOICE_SOURCEEND|VOICE_SOURCESHORT|VOICE_SOURCEDONE);
+
+	/* the voice in flight is copied back from the command block when the DSP is done with it,
+	   the source fields lie past the part the DSP writes back */
+	if(pb!=&__aesndcommand && !__aesnddspcomplete && __aesndcurrvoice==pb->voiceno) {
+		__aesndcommand.source = source;
+		__aesndcommand.source_arg = cb_arg;
+		__aesndcommand.underruns = 0;
+	}
+	_CPU_ISR_Restore(level);
+}
+
+u32 AESND_GetVoiceUnderruns(AESNDPB *pb)
+{
+	u32 level;
+	u32 underruns;
+
+	_CPU_ISR_Disable(level);
+	underruns = pb->underruns;
+	_CPU_ISR_Restore(level);
+
+	return underruns;
+}
+
 void AESND_SetVoiceFormat(AESNDPB *pb,u32 format)
 {
 	u32 level;
@@ -611,6 +763,18 @@ void AESND_SetVoiceFormat(AESNDPB *pb,u32 format)
 	_CPU_ISR_Restore(level);
 }
 
+void AESND_SetVoiceADPCM(AESNDPB *pb,const s16 *coefs,u16 loop_ps,s16 loop_yn1,s16 loop_yn2)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	memcpy(pb->coefs,coefs,sizeof(pb->coefs));
+	pb->loop_pds = loop_ps;
+	pb->loop_yn1 = (u16)loop_yn1;
+	pb->loop_yn2 = (u16)loop_yn2;
+	_CPU_ISR_Restore(level);
+}
+
 void AESND_SetVoiceVolume(AESNDPB *pb,u16 volume_l,u16 volume_r)
 {
 	u32 level;
@@ -72,19 +72,29 @@ FLAGS_SMPL:		equ		PB_ADDR+0x15
 LOOP_PDS:		equ		PB_ADDR+0x16
 LOOP_YN1:		equ		PB_ADDR+0x17
 LOOP_YN2:		equ		PB_ADDR+0x18
+RING_PDS:		equ		PB_ADDR+0x19
+
+LOOP_SADDRH:	equ		PB_ADDR+0x1a
+LOOP_SADDRL:	equ		PB_ADDR+0x1b
+LOOP_EADDRH:	equ		PB_ADDR+0x1c
+LOOP_EADDRL:	equ		PB_ADDR+0x1d
+
+ADPCM_COEFS:	equ		PB_ADDR+0x20
 
 /* flags and buffers used */
 MEM_SMP_BUF:		equ		0x0800
 MEM_TMP_BUF:		equ		0x0a00
 MEM_SND_BUF:		equ		0x0c00					//buffer for output sound data, will be DMA'd out to OUTBUF_SND
 
-PB_STURCT_SIZE:		equ		64
+PB_STURCT_SIZE:		equ		96
 NUM_SAMPLES:		equ		96						//process 2ms of sample data
 DEF_FREQ_INT:		equ		0x0001
 
 VOICE_FLAGL_PAUSE:	equ		0x0008
 VOICE_FLAGL_LOOP:	equ		0x0010
 VOICE_FLAGL_ONCE:	equ		0x0020
+VOICE_FLAGL_ADPCM:	equ		0x0080
+VOICE_FLAGL_LOOPCTX:	equ		0x0100
 
 VOICE_FLAGH_END:	equ		0x0010
 VOICE_FLAGH_STOP:	equ		0x0020
@@ -96,6 +106,9 @@ ACCL_FMT_16BIT:		equ		0x000a
 ACCL_GAIN_8BIT:		equ		0x0100
 ACCL_GAIN_16BIT:	equ		0x0800
 
+ACCL_FMT_ADPCM:		equ		0x0000
+ACCL_GAIN_ADPCM:	equ		0x0000
+
 _start:
 	nop
 	nop
@@ -320,13 +333,20 @@ no_change_buffer:
 	lr		$acc1.l,@FLAGS_SMPL
 	
 	mrr		$acc1.m,$acc1.l
+	andcf	$acc1.m,#VOICE_FLAGL_ADPCM
+	jlnz	pcm_format
+	lri		$acc1.m,#0x04
+	jmp		set_format
+pcm_format:
 	andi	$acc1.m,#0x02
+set_format:
 	addi	$acc1.m,#select_format
 	mrr		$ar3,$acc1.m
 	ilrri	$acc0.m,@$ar3
 	ilrri	$acc1.m,@$ar3
 	call	setup_accl
 	
+	lr		$acc1.l,@FLAGS_SMPL
 	mrr		$acc1.m,$acc1.l
 	andi	$acc1.m,#0x07
 	addi	$acc1.m,#select_mixer
@@ -495,7 +515,7 @@ wait_dma:
 	jlnz	wait_dma
 	ret
 		
-//setup_accl: acc0.m = format, acc1.m = gain, ar1 = sndbuf_start
+//setup_accl: acc0.m = format, acc1.m = gain, ar1 = sndbuf_start, clobbers acc0/acc1
 setup_accl:
 	srs		@ACFMT,$acc0.m
 	srs		@ACGAN,$acc1.m
@@ -519,23 +539,61 @@ setup_accl:
 	lrri	$acc0.m,@$ar1
 	srs		@ACPDS,$acc0.m
 
-	si		@ACCOEF+0,#0
-	si		@ACCOEF+1,#0
-	si		@ACCOEF+2,#0
-	si		@ACCOEF+3,#0
-	si		@ACCOEF+4,#0
-	si		@ACCOEF+5,#0
-	si		@ACCOEF+6,#0
-	si		@ACCOEF+7,#0
-	si		@ACCOEF+8,#0
-	si		@ACCOEF+9,#0
-	si		@ACCOEF+10,#0
-	si		@ACCOEF+11,#0
-	si		@ACCOEF+12,#0
-	si		@ACCOEF+13,#0
-	si		@ACCOEF+14,#0
-	si		@ACCOEF+15,#0
+	lr		$acc0.m,@ADPCM_COEFS+0
+	srs		@ACCOEF+0,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+1
+	srs		@ACCOEF+1,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+2
+	srs		@ACCOEF+2,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+3
+	srs		@ACCOEF+3,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+4
+	srs		@ACCOEF+4,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+5
+	srs		@ACCOEF+5,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+6
+	srs		@ACCOEF+6,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+7
+	srs		@ACCOEF+7,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+8
+	srs		@ACCOEF+8,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+9
+	srs		@ACCOEF+9,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+10
+	srs		@ACCOEF+10,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+11
+	srs		@ACCOEF+11,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+12
+	srs		@ACCOEF+12,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+13
+	srs		@ACCOEF+13,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+14
+	srs		@ACCOEF+14,$acc0.m
+	lr		$acc0.m,@ADPCM_COEFS+15
+	srs		@ACCOEF+15,$acc0.m
+
+	// pending ADPCM loop start ahead of the current address: end the pass just before it
+	lr		$acc1.m,@FLAGS_SMPL
+	andcf	$acc1.m,#VOICE_FLAGL_LOOPCTX
+	jlnz	setup_accl_end
+
+	clr		$acc0
+	clr		$acc1
+	lrs		$acc0.m,@ACCAH
+	lrs		$acc0.l,@ACCAL
+	lr		$acc1.m,@LOOP_SADDRH
+	lr		$acc1.l,@LOOP_SADDRL
+	cmp
+	jge		setup_accl_end
+
+	srs		@ACSAH,$acc1.m
+	srs		@ACSAL,$acc1.l
+	lr		$acc1.m,@LOOP_EADDRH
+	srs		@ACEAH,$acc1.m
+	lr		$acc1.m,@LOOP_EADDRL
+	srs		@ACEAL,$acc1.m
 
+setup_accl_end:
 	ret
 	
 wait_mail_sent:
@@ -579,6 +637,10 @@ exception5:		// Accelerator address overflow
 	s16
 	mrr		$st1,$acc0.m
 
+	lr		$acc0.m,@FLAGS_SMPL
+	andcf	$acc0.m,#VOICE_FLAGL_ADPCM
+	jlz		adpcm_wrap
+
 	lrs		$acc0.m,@ACYN1
 	srs		@ACYN1,$acc0.m
 	lrs		$acc0.m,@ACYN2
@@ -588,6 +650,61 @@ exception5:		// Accelerator address overflow
 
 	mrr		$acc0.m,$st1
 	rti
+
+adpcm_wrap:
+	mrr		$st1,$acx0.h
+
+	andcf	$acc0.m,#VOICE_FLAGL_LOOPCTX
+	jlnz	ring_context
+
+	lrs		$acc0.m,@ACSAL
+	lr		$acx0.h,@LOOP_SADDRL
+	xorr	$acc0.m,$acx0.h
+	jne		arm_loop_context
+
+	// wrapped onto the loop start: reload the decoder context, restore the stream buffer
+	lr		$acc0.m,@LOOP_YN1
+	srs		@ACYN1,$acc0.m
+	lr		$acc0.m,@LOOP_YN2
+	srs		@ACYN2,$acc0.m
+	lr		$acc0.m,@LOOP_PDS
+	srs		@ACPDS,$acc0.m
+
+	lr		$acc0.m,@SNDBUF_SADDRH
+	srs		@ACSAH,$acc0.m
+	lr		$acc0.m,@SNDBUF_SADDRL
+	srs		@ACSAL,$acc0.m
+	lr		$acc0.m,@SNDBUF_EADDRH
+	srs		@ACEAH,$acc0.m
+	lr		$acc0.m,@SNDBUF_EADDRL
+	srs		@ACEAL,$acc0.m
+
+	lr		$acc0.m,@FLAGS_SMPL
+	andi	$acc0.m,#0xfeff				// ~VOICE_FLAGL_LOOPCTX
+	sr		@FLAGS_SMPL,$acc0.m
+
+	jmp		adpcm_wrap_end
+
+arm_loop_context:
+	// wrapped onto the stream buffer start: end the next pass just before the loop start
+	lr		$acc0.m,@LOOP_SADDRH
+	srs		@ACSAH,$acc0.m
+	lr		$acc0.m,@LOOP_SADDRL
+	srs		@ACSAL,$acc0.m
+	lr		$acc0.m,@LOOP_EADDRH
+	srs		@ACEAH,$acc0.m
+	lr		$acc0.m,@LOOP_EADDRL
+	srs		@ACEAL,$acc0.m
+
+ring_context:
+	// the stream buffer start skips the frame header: the CPU keeps its pred/scale in the PB
+	lr		$acc0.m,@RING_PDS
+	srs		@ACPDS,$acc0.m
+
+adpcm_wrap_end:
+	mrr		$acx0.h,$st1
+	mrr		$acc0.m,$st1
+	rti
 	
 exception6:
 	rti
@@ -610,4 +727,6 @@ select_format:
 	cw		ACCL_GAIN_8BIT
 	cw		ACCL_FMT_16BIT
 	cw		ACCL_GAIN_16BIT
+	cw		ACCL_FMT_ADPCM
+	cw		ACCL_GAIN_ADPCM
 	
\ No newline at end of file
@@ -1,44 +1,51 @@
 /* gdtool v1.4 .h exporter by Hermes */
 
-#define dspmixer_size 1088
+#define dspmixer_size 1312
 
-unsigned short dspmixer[544] __attribute__ ((aligned (32))) ={
+unsigned short dspmixer[656] __attribute__ ((aligned (32))) ={
 
 
-	0x0000, 0x0000, 0x029f, 0x01f7, 0x029f, 0x01f8, 0x029f, 0x01f9, 0x029f, 0x01fa, 0x029f, 0x01fb, 0x029f, 0x0205, 0x029f, 0x0206,
+	0x0000, 0x0000, 0x029f, 0x022a, 0x029f, 0x022b, 0x029f, 0x022c, 0x029f, 0x022d, 0x029f, 0x022e, 0x029f, 0x0278, 0x029f, 0x0279,
 	0x1302, 0x1303, 0x1204, 0x1305, 0x1306, 0x8e00, 0x8c00, 0x8b00, 0x0092, 0x00ff, 0x0088, 0xffff, 0x0089, 0xffff, 0x008a, 0xffff,
 	0x008b, 0xffff, 0x16fc, 0xdcd1, 0x16fd, 0x0000, 0x16fb, 0x0001, 0x029f, 0x0042, 0x1302, 0x1303, 0x1204, 0x1305, 0x1306, 0x8e00,
 	0x8c00, 0x8b00, 0x0092, 0x00ff, 0x0088, 0xffff, 0x0089, 0xffff, 0x008a, 0xffff, 0x008b, 0xffff, 0x16fc, 0xdcd1, 0x16fd, 0x0001,
-	0x16fb, 0x0001, 0x8100, 0x8900, 0x02bf, 0x01df, 0x02bf, 0x01e5, 0x009e, 0xcdd1, 0x8200, 0x0295, 0x006e, 0x009e, 0xface, 0x8200,
+	0x16fb, 0x0001, 0x8100, 0x8900, 0x02bf, 0x0212, 0x02bf, 0x0218, 0x009e, 0xcdd1, 0x8200, 0x0295, 0x006e, 0x009e, 0xface, 0x8200,
 	0x0294, 0x0042, 0x27ff, 0x0380, 0x0010, 0x0295, 0x00dd, 0x0380, 0x0020, 0x0295, 0x00d7, 0x0380, 0x0080, 0x0295, 0x00cd, 0x0380,
 	0x0100, 0x0295, 0x00ba, 0x0380, 0x0200, 0x0295, 0x00c5, 0x009e, 0xdead, 0x8200, 0x0295, 0x00b2, 0x029f, 0x0042, 0x27ff, 0x0380,
-	0x0001, 0x0295, 0x0079, 0x0380, 0x0002, 0x0295, 0x8000, 0x029f, 0x0042, 0x8e00, 0x8100, 0x8900, 0x02bf, 0x01eb, 0x24ff, 0x02bf,
-	0x01f1, 0x25ff, 0x02bf, 0x01f1, 0x27ff, 0x2ece, 0x2ccf, 0x16c9, 0x0001, 0x2fcd, 0x2dcb, 0x8100, 0x8900, 0x02bf, 0x01eb, 0x24ff,
-	0x1c9e, 0x1cbc, 0x02bf, 0x01f1, 0x25ff, 0x02bf, 0x01f1, 0x27ff, 0x1cdf, 0x1cfd, 0x8100, 0x02bf, 0x01eb, 0x26ff, 0x1c1e, 0x8900,
-	0x02bf, 0x01f1, 0x20ff, 0x1f5f, 0x02bf, 0x01eb, 0x21ff, 0x02bf, 0x01eb, 0x23ff, 0x26c9, 0x02a0, 0x0004, 0x029c, 0x00aa, 0x029f,
+	0x0001, 0x0295, 0x0079, 0x0380, 0x0002, 0x0295, 0x8000, 0x029f, 0x0042, 0x8e00, 0x8100, 0x8900, 0x02bf, 0x021e, 0x24ff, 0x02bf,
+	0x0224, 0x25ff, 0x02bf, 0x0224, 0x27ff, 0x2ece, 0x2ccf, 0x16c9, 0x0001, 0x2fcd, 0x2dcb, 0x8100, 0x8900, 0x02bf, 0x021e, 0x24ff,
+	0x1c9e, 0x1cbc, 0x02bf, 0x0224, 0x25ff, 0x02bf, 0x0224, 0x27ff, 0x1cdf, 0x1cfd, 0x8100, 0x02bf, 0x021e, 0x26ff, 0x1c1e, 0x8900,
+	0x02bf, 0x0224, 0x20ff, 0x1f5f, 0x02bf, 0x021e, 0x21ff, 0x02bf, 0x021e, 0x23ff, 0x26c9, 0x02a0, 0x0004, 0x029c, 0x00aa, 0x029f,
 	0x80b5, 0x0021, 0x16fc, 0xdcd1, 0x16fd, 0x0003, 0x16fb, 0x0001, 0x029f, 0x0042, 0x0080, 0x0c00, 0x0901, 0x0098, 0x0180, 0x00de,
-	0x0200, 0x00dc, 0x0201, 0x02bf, 0x019c, 0x16fc, 0xdcd1, 0x16fd, 0x0002, 0x16fb, 0x0001, 0x029f, 0x0042, 0x02bf, 0x01e5, 0x0082,
-	0x0000, 0x26fe, 0x1b5e, 0x26ff, 0x1a5e, 0x029f, 0x0042, 0x16c9, 0x0000, 0x02bf, 0x018c, 0x029f, 0x00e9, 0x16c9, 0x0000, 0x02bf,
-	0x018c, 0x0080, 0x0c00, 0x009d, 0x0000, 0x0098, 0x00c0, 0x0058, 0x1b1d, 0x8100, 0x00df, 0x0215, 0x03c0, 0x0008, 0x029d, 0x017a,
-	0x00df, 0x0214, 0x03c0, 0x4000, 0x029c, 0x017a, 0x0081, 0x0202, 0x193e, 0x18bc, 0xb100, 0x0295, 0x017a, 0x00dd, 0x0215, 0x1ffd,
-	0x0340, 0x0002, 0x0300, 0x020f, 0x1c7f, 0x021b, 0x031b, 0x02bf, 0x01aa, 0x1ffd, 0x0340, 0x0007, 0x0300, 0x0207, 0x1c7f, 0x0313,
-	0x1c7f, 0x0081, 0x020e, 0x8151, 0x193b, 0x1926, 0x1927, 0x1930, 0x193e, 0x0080, 0x0c00, 0x0098, 0x0060, 0x0081, 0x020b, 0x0089,
-	0x0004, 0xb100, 0x0295, 0x0131, 0x0084, 0x0002, 0x0078, 0x012b, 0x7800, 0x0295, 0x012c, 0x0010, 0x1f0f, 0x00f0, 0x0212, 0x00fe,
-	0x0213, 0x8f00, 0x0078, 0x016a, 0x191f, 0x181e, 0x4704, 0x4438, 0x1b1e, 0x8159, 0x1939, 0x183c, 0x4a00, 0x1f1e, 0x1b3c, 0x0601,
-	0x1760, 0x029f, 0x0169, 0x0078, 0x0146, 0x26dd, 0x1ffe, 0x0220, 0x8000, 0x0320, 0x8000, 0x029f, 0x0161, 0x0078, 0x0150, 0x26dd,
-	0x1ffe, 0x029f, 0x0161, 0x0078, 0x0156, 0x26dd, 0x27dd, 0x0220, 0x8000, 0x0320, 0x8000, 0x029f, 0x0161, 0x0078, 0x0160, 0x26dd,
-	0x27dd, 0x1f46, 0xc000, 0x1f67, 0xde00, 0x1488, 0x6f31, 0x1588, 0x1abf, 0x193a, 0x193b, 0x8e00, 0x0089, 0xffff, 0x0081, 0x020a,
-	0x26da, 0x1abe, 0x26dc, 0x1abe, 0x26db, 0x1abe, 0x26d9, 0x1abe, 0x26d8, 0x1abe, 0x00de, 0x0214, 0x0260, 0x0010, 0x00fe, 0x0214,
-	0x16c9, 0x0001, 0x02bf, 0x018c, 0x16fc, 0xdcd1, 0x16fd, 0x0004, 0x16fb, 0x0001, 0x029f, 0x0042, 0x00de, 0x0000, 0x00dc, 0x0001,
-	0x2ece, 0x2ccf, 0x16cd, 0x0200, 0x16cb, 0x0040, 0x26c9, 0x02a0, 0x0004, 0x029c, 0x0196, 0x02df, 0x2ece, 0x2ccf, 0x00e0, 0xffcd,
-	0x00f9, 0xffc9, 0x00f8, 0xffcb, 0x26c9, 0x02a0, 0x0004, 0x029c, 0x01a4, 0x02df, 0x2ed1, 0x2fde, 0x193e, 0x2ed4, 0x193e, 0x2ed5,
-	0x193e, 0x2ed6, 0x193e, 0x2ed7, 0x193e, 0x2ed8, 0x193e, 0x2ed9, 0x193e, 0x2edb, 0x193e, 0x2edc, 0x193e, 0x2eda, 0x16a0, 0x0000,
-	0x16a1, 0x0000, 0x16a2, 0x0000, 0x16a3, 0x0000, 0x16a4, 0x0000, 0x16a5, 0x0000, 0x16a6, 0x0000, 0x16a7, 0x0000, 0x16a8, 0x0000,
-	0x16a9, 0x0000, 0x16aa, 0x0000, 0x16ab, 0x0000, 0x16ac, 0x0000, 0x16ad, 0x0000, 0x16ae, 0x0000, 0x16af, 0x0000, 0x02df, 0x26fc,
-	0x02a0, 0x8000, 0x029c, 0x01df, 0x02df, 0x27fe, 0x03c0, 0x8000, 0x029c, 0x01e5, 0x02df, 0x26fe, 0x02c0, 0x8000, 0x029c, 0x01eb,
-	0x02df, 0x27fe, 0x03c0, 0x8000, 0x029c, 0x01e5, 0x02df, 0x02ff, 0x02ff, 0x02ff, 0x02ff, 0x8e00, 0x1dbe, 0x26db, 0x2edb, 0x26dc,
-	0x2edc, 0x26da, 0x2eda, 0x1fcd, 0x02ff, 0x02ff, 0x02ff, 0x014d, 0x015d, 0x014d, 0x015d, 0x0143, 0x0153, 0x0143, 0x0153, 0x0019,
-	0x0100, 0x000a, 0x0800, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+	0x0200, 0x00dc, 0x0201, 0x02bf, 0x01a6, 0x16fc, 0xdcd1, 0x16fd, 0x0002, 0x16fb, 0x0001, 0x029f, 0x0042, 0x02bf, 0x0218, 0x0082,
+	0x0000, 0x26fe, 0x1b5e, 0x26ff, 0x1a5e, 0x029f, 0x0042, 0x16c9, 0x0000, 0x02bf, 0x0196, 0x029f, 0x00e9, 0x16c9, 0x0000, 0x02bf,
+	0x0196, 0x0080, 0x0c00, 0x009d, 0x0000, 0x0098, 0x00c0, 0x0058, 0x1b1d, 0x8100, 0x00df, 0x0215, 0x03c0, 0x0008, 0x029d, 0x0184,
+	0x00df, 0x0214, 0x03c0, 0x4000, 0x029c, 0x0184, 0x0081, 0x0202, 0x193e, 0x18bc, 0xb100, 0x0295, 0x0184, 0x00dd, 0x0215, 0x1ffd,
+	0x03c0, 0x0080, 0x029c, 0x0108, 0x009f, 0x0004, 0x029f, 0x010a, 0x0340, 0x0002, 0x0300, 0x0282, 0x1c7f, 0x021b, 0x031b, 0x02bf,
+	0x01b4, 0x00dd, 0x0215, 0x1ffd, 0x0340, 0x0007, 0x0300, 0x027a, 0x1c7f, 0x0313, 0x1c7f, 0x0081, 0x020e, 0x8151, 0x193b, 0x1926,
+	0x1927, 0x1930, 0x193e, 0x0080, 0x0c00, 0x0098, 0x0060, 0x0081, 0x020b, 0x0089, 0x0004, 0xb100, 0x0295, 0x013b, 0x0084, 0x0002,
+	0x0078, 0x0135, 0x7800, 0x0295, 0x0136, 0x0010, 0x1f0f, 0x00f0, 0x0212, 0x00fe, 0x0213, 0x8f00, 0x0078, 0x0174, 0x191f, 0x181e,
+	0x4704, 0x4438, 0x1b1e, 0x8159, 0x1939, 0x183c, 0x4a00, 0x1f1e, 0x1b3c, 0x0601, 0x1760, 0x029f, 0x0173, 0x0078, 0x0150, 0x26dd,
+	0x1ffe, 0x0220, 0x8000, 0x0320, 0x8000, 0x029f, 0x016b, 0x0078, 0x015a, 0x26dd, 0x1ffe, 0x029f, 0x016b, 0x0078, 0x0160, 0x26dd,
+	0x27dd, 0x0220, 0x8000, 0x0320, 0x8000, 0x029f, 0x016b, 0x0078, 0x016a, 0x26dd, 0x27dd, 0x1f46, 0xc000, 0x1f67, 0xde00, 0x1488,
+	0x6f31, 0x1588, 0x1abf, 0x193a, 0x193b, 0x8e00, 0x0089, 0xffff, 0x0081, 0x020a, 0x26da, 0x1abe, 0x26dc, 0x1abe, 0x26db, 0x1abe,
+	0x26d9, 0x1abe, 0x26d8, 0x1abe, 0x00de, 0x0214, 0x0260, 0x0010, 0x00fe, 0x0214, 0x16c9, 0x0001, 0x02bf, 0x0196, 0x16fc, 0xdcd1,
+	0x16fd, 0x0004, 0x16fb, 0x0001, 0x029f, 0x0042, 0x00de, 0x0000, 0x00dc, 0x0001, 0x2ece, 0x2ccf, 0x16cd, 0x0200, 0x16cb, 0x0060,
+	0x26c9, 0x02a0, 0x0004, 0x029c, 0x01a0, 0x02df, 0x2ece, 0x2ccf, 0x00e0, 0xffcd, 0x00f9, 0xffc9, 0x00f8, 0xffcb, 0x26c9, 0x02a0,
+	0x0004, 0x029c, 0x01ae, 0x02df, 0x2ed1, 0x2fde, 0x193e, 0x2ed4, 0x193e, 0x2ed5, 0x193e, 0x2ed6, 0x193e, 0x2ed7, 0x193e, 0x2ed8,
+	0x193e, 0x2ed9, 0x193e, 0x2edb, 0x193e, 0x2edc, 0x193e, 0x2eda, 0x00de, 0x0220, 0x2ea0, 0x00de, 0x0221, 0x2ea1, 0x00de, 0x0222,
+	0x2ea2, 0x00de, 0x0223, 0x2ea3, 0x00de, 0x0224, 0x2ea4, 0x00de, 0x0225, 0x2ea5, 0x00de, 0x0226, 0x2ea6, 0x00de, 0x0227, 0x2ea7,
+	0x00de, 0x0228, 0x2ea8, 0x00de, 0x0229, 0x2ea9, 0x00de, 0x022a, 0x2eaa, 0x00de, 0x022b, 0x2eab, 0x00de, 0x022c, 0x2eac, 0x00de,
+	0x022d, 0x2ead, 0x00de, 0x022e, 0x2eae, 0x00de, 0x022f, 0x2eaf, 0x00df, 0x0215, 0x03c0, 0x0100, 0x029c, 0x0211, 0x8100, 0x8900,
+	0x26d8, 0x24d9, 0x00df, 0x021a, 0x00dd, 0x021b, 0x8200, 0x0290, 0x0211, 0x2fd4, 0x2dd5, 0x00df, 0x021c, 0x2fd6, 0x00df, 0x021d,
+	0x2fd7, 0x02df, 0x26fc, 0x02a0, 0x8000, 0x029c, 0x0212, 0x02df, 0x27fe, 0x03c0, 0x8000, 0x029c, 0x0218, 0x02df, 0x26fe, 0x02c0,
+	0x8000, 0x029c, 0x021e, 0x02df, 0x27fe, 0x03c0, 0x8000, 0x029c, 0x0218, 0x02df, 0x02ff, 0x02ff, 0x02ff, 0x02ff, 0x8e00, 0x1dbe,
+	0x00de, 0x0215, 0x02c0, 0x0080, 0x029d, 0x023e, 0x26db, 0x2edb, 0x26dc, 0x2edc, 0x26da, 0x2eda, 0x1fcd, 0x02ff, 0x1dba, 0x02c0,
+	0x0100, 0x029c, 0x0272, 0x26d5, 0x00da, 0x021b, 0x3000, 0x0294, 0x0266, 0x00de, 0x0217, 0x2edb, 0x00de, 0x0218, 0x2edc, 0x00de,
+	0x0216, 0x2eda, 0x00de, 0x0202, 0x2ed4, 0x00de, 0x0203, 0x2ed5, 0x00de, 0x0204, 0x2ed6, 0x00de, 0x0205, 0x2ed7, 0x00de, 0x0215,
+	0x0240, 0xfeff, 0x00fe, 0x0215, 0x029f, 0x0275, 0x00de, 0x021a, 0x2ed4, 0x00de, 0x021b, 0x2ed5, 0x00de, 0x021c, 0x2ed6, 0x00de,
+	0x021d, 0x2ed7, 0x00de, 0x0219, 0x2eda, 0x1f4d, 0x1fcd, 0x02ff, 0x02ff, 0x02ff, 0x0157, 0x0167, 0x0157, 0x0167, 0x014d, 0x015d,
+	0x014d, 0x015d, 0x0019, 0x0100, 0x000a, 0x0800, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
 
 };
 
@@ -0,0 +1,260 @@
+/*-------------------------------------------------------------
+
+imasource.c -- IMA-ADPCM streaming source for AESND voices
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ogcsys.h>
+
+#include "aesndlib.h"
+#include "imasource.h"
+
+struct _imasource
+{
+	void *cb_data;
+	s32 (*reader)(void *,void *,s32);
+
+	const u8 *mem;
+	s32 memlen;
+	s32 mempos;
+
+	AESNDPB *pb;
+	u32 channels;
+	u32 samplerate;
+	u32 blockalign;
+	u32 blocksamples;
+	BOOL eof;
+
+	u32 inlen;				// bytes of the current block read so far
+	u32 pcmpos;				// sample frames of the decoded block already sent
+	u32 pcmlen;
+
+	u8 *input;
+	s16 *pcm;
+};
+
+static const s16 _imasteps[89] = {
+	    7,    8,    9,   10,   11,   12,   13,   14,   16,   17,
+	   19,   21,   23,   25,   28,   31,   34,   37,   41,   45,
+	   50,   55,   60,   66,   73,   80,   88,   97,  107,  118,
+	  130,  143,  157,  173,  190,  209,  230,  253,  279,  307,
+	  337,  371,  408,  449,  494,  544,  598,  658,  724,  796,
+	  876,  963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	 5894, 6484, 7132, 7845, 8630, 9493,10442,11487,12635,13899,
+	15289,16818,18500,20350,22385,24623,27086,29794,32767
+};
+
+static const s8 _imaindex[8] = {-1,-1,-1,-1,2,4,6,8};
+
+static __inline__ s16 _imadecode(s32 *pred,s32 *index,u32 nibble)
+{
+	s32 step = _imasteps[*index];
+	s32 diff = step>>3;
+
+	if(nibble&1) diff += step>>2;
+	if(nibble&2) diff += step>>1;
+	if(nibble&4) diff += step;
+
+	if(nibble&8) *pred -= diff;
+	else *pred += diff;
+
+	if(*pred>32767) *pred = 32767;
+	else if(*pred<-32768) *pred = -32768;
+
+	*index += _imaindex[nibble&7];
+	if(*index<0) *index = 0;
+	else if(*index>88) *index = 88;
+
+	return (s16)*pred;
+}
+
+static s32 _imamemread(void *cb_data,void *dst,s32 len)
+{
+	IMASource *src = cb_data;
+
+	if(src->mempos>=src->memlen) return -1;
+	if(len>(src->memlen - src->mempos)) len = (src->memlen - src->mempos);
+
+	memcpy(dst,src->mem + src->mempos,len);
+	src->mempos += len;
+	return len;
+}
+
+/* decodes the block in the input, which may be a short last block */
+static void _imasourcedecode(IMASource *src)
+{
+	const u8 *in = src->input;
+	const u8 *end = src->input + src->inlen;
+	u32 ch = src->channels;
+	s32 pred[2],index[2];
+	u32 c,i,s;
+
+	for(c=0;c<ch;c++) {
+		pred[c] = (s16)(in[c*4 + 0]|(in[c*4 + 1]<<8));
+		index[c] = in[c*4 + 2];
+		if(index[c]>88) index[c] = 88;
+		src->pcm[c] = (s16)pred[c];
+	}
+	in += ch*4;
+
+	/* 4 bytes of each channel in turn, 8 samples, low nibble first */
+	for(s=1;(in + ch*4)<=end;s+=8) {
+		for(c=0;c<ch;c++) {
+			for(i=0;i<4;i++) {
+				u8 byte = in[c*4 + i];
+
+				src->pcm[(s + i*2 + 0)*ch + c] = _imadecode(&pred[c],&index[c],byte&0x0f);
+				src->pcm[(s + i*2 + 1)*ch + c] = _imadecode(&pred[c],&index[c],byte>>4);
+			}
+		}
+		in += ch*4;
+	}
+
+	src->pcmpos = 0;
+	src->pcmlen = s;
+}
+
+/* reads and decodes the next block, returns FALSE on underrun or at the end */
+static BOOL _imasourceblock(IMASource *src)
+{
+	s32 ret;
+
+	while(src->eof==FALSE && src->inlen<src->blockalign) {
+		ret = src->reader(src->cb_data,src->input + src->inlen,src->blockalign - src->inlen);
+		if(ret==0) return FALSE;
+		if(ret<0) src->eof = TRUE;
+		else src->inlen += ret;
+	}
+
+	if(src->inlen<(src->channels*4)) {
+		src->inlen = 0;
+		return FALSE;
+	}
+
+	_imasourcedecode(src);
+	src->inlen = 0;
+	return TRUE;
+}
+
+static s32 _imasourcefill(AESNDPB *pb,void *buffer,u32 len,void *cb_arg)
+{
+	IMASource *src = cb_arg;
+	u32 framesize = (src->channels<<1);
+	u32 n,frames,done = 0;
+	u8 *out = buffer;
+
+	frames = (len/framesize);
+	while(done<frames) {
+		if(src->pcmpos>=src->pcmlen) {
+			if(_imasourceblock(src)==FALSE) break;
+			continue;
+		}
+
+		n = src->pcmlen - src->pcmpos;
+		if(n>(frames - done)) n = (frames - done);
+
+		memcpy(out,src->pcm + (src->pcmpos*src->channels),n*framesize);
+		out += n*framesize;
+
+		src->pcmpos += n;
+		done += n;
+	}
+
+	if(done==0 && src->eof==TRUE) return -1;
+	return (done*framesize);
+}
+
+IMASource* IMASource_Create(void *cb_data,s32 (*reader)(void *,void *,s32),u32 channels,u32 samplerate,u32 block_align)
+{
+	IMASource *src;
+	u32 blocksamples;
+
+	if(reader==NULL || samplerate==0) return NULL;
+	if(channels<1 || channels>2) return NULL;
+	if(block_align<=(channels*4) || ((block_align - channels*4)%(channels*4))!=0) return NULL;
+
+	blocksamples = 1 + ((block_align - channels*4)<<1)/channels;
+
+	src = malloc(sizeof(IMASource) + block_align + blocksamples*channels*sizeof(s16));
+	if(src==NULL) return NULL;
+
+	memset(src,0,sizeof(IMASource));
+	src->cb_data = cb_data;
+	src->reader = reader;
+	src->channels = channels;
+	src->samplerate = samplerate;
+	src->blockalign = block_align;
+	src->blocksamples = blocksamples;
+
+	src->pcm = (s16*)(src + 1);
+	src->input = (u8*)(src->pcm + blocksamples*channels);
+
+	return src;
+}
+
+IMASource* IMASource_CreateBuffer(const void *buffer,s32 len,u32 channels,u32 samplerate,u32 block_align)
+{
+	IMASource *src;
+
+	if(buffer==NULL || len<=0) return NULL;
+
+	src = IMASource_Create(NULL,_imamemread,channels,samplerate,block_align);
+	if(src==NULL) return NULL;
+
+	src->cb_data = src;
+	src->mem = buffer;
+	src->memlen = len;
+	return src;
+}
+
+void IMASource_Destroy(IMASource *src)
+{
+	if(src==NULL) return;
+
+	if(src->pb!=NULL) {
+		AESND_SetVoiceStop(src->pb,true);
+		AESND_SetVoiceSource(src->pb,NULL,NULL);
+	}
+	free(src);
+}
+
+s32 IMASource_Play(IMASource *src,AESNDPB *pb,u32 delay)
+{
+	if(src==NULL || pb==NULL) return -1;
+
+	src->pb = pb;
+	AESND_SetVoiceSource(pb,_imasourcefill,src);
+	AESND_PlayVoice(pb,(src->channels==2) ? VOICE_STEREO16 : VOICE_MONO16,NULL,0,src->samplerate,delay,false);
+	return 0;
+}
+
+u32 IMASource_GetUnderruns(IMASource *src)
+{
+	if(src==NULL || src->pb==NULL) return 0;
+
+	return AESND_GetVoiceUnderruns(src->pb);
+}
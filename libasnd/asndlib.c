@@ -27,6 +27,7 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <ogcsys.h>
@@ -43,6 +44,13 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define VOICE_PAUSE       (1<<9)
 #define VOICE_SETLOOP     (1<<8)
 
+#define VIRTUAL_USED      (1<<0)
+#define VIRTUAL_LOOP      (1<<1)
+#define VIRTUAL_PAUSE     (1<<2)
+#define VIRTUAL_SELECTED  (1<<3)
+
+#define VIRTUAL_GROW      32
+
 typedef struct
 {
 	void *out_buf;	// output buffer 4096 bytes aligned to 32
@@ -76,6 +84,30 @@ typedef struct
 	u32 _pad;
 } t_sound_data;
 
+typedef struct
+{
+	u32 flags;
+
+	u32 index;
+	u32 generation; // upper half of the handle, catches stale handles
+
+	s32 voice;	// DSP voice playing it or -1 while virtual
+
+	s32 format;	// (step<<16) | (type & 7) as in t_sound_data
+	u32 step;	// bytes per sample
+
+	u32 pitch;
+	u32 priority;
+	u32 volume_l,volume_r;
+
+	u32 start_addr; // physical pointer (bytes aligned to 32 bytes)
+	u32 size;
+
+	u32 pos;	// play position in bytes from start_addr
+	u32 frac;	// fraction of sample of the position, in 1/48000 units
+	u32 delay;	// samples left before to start
+} t_virtual_voice;
+
 static dsptask_t dsp_task;
 
 static vu64 time_of_process;
@@ -98,6 +130,242 @@ static t_sound_data sound_data_dma ATTRIBUTE_ALIGN(32);
 static u8 mute_buf[SND_BUFFERSIZE] ATTRIBUTE_ALIGN(32);
 static u8 audio_buf[2][SND_BUFFERSIZE] ATTRIBUTE_ALIGN(32);
 
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+// virtual voices: any number of logical voices, the most audible ones get a DSP voice each tick
+
+static t_virtual_voice *virtual_voices = NULL;
+static u32 virtual_cap = 0;
+static s32 virtual_owner[MAX_VOICES];
+static u32 virtual_stolen = 0;
+static u32 dsp_peak = 0;
+
+static s32 __asnd_formatflags(s32 format)
+{
+	u32 flag_h=0;
+
+	format&=7;
+
+	switch(format&3)
+	{
+	case 0:
+		flag_h=1<<16;break;
+	case 1:
+	case 2:
+		flag_h=2<<16;break;
+	case 3:
+		flag_h=4<<16;break;
+	}
+
+	return format | flag_h;
+}
+
+static t_virtual_voice* __asnd_getvirtual(s32 handle)
+{
+	t_virtual_voice *vv;
+	u32 n = (handle & 0xffff);
+
+	if(handle<0 || n>=virtual_cap) return NULL;
+
+	vv = &virtual_voices[n];
+	if(!vv->flags || vv->generation!=((u32)handle>>16)) return NULL;
+
+	return vv;
+}
+
+static u32 __asnd_virtualscore(t_virtual_voice *vv)
+{
+	u32 score = vv->priority*(vv->volume_l + vv->volume_r);
+
+	// hysteresis: a voice already on the DSP keeps it against an equal contender
+	if(vv->voice>=0) score += (score>>3);
+
+	return score;
+}
+
+static void __asnd_stopvirtual(t_virtual_voice *vv)
+{
+	if(vv->voice>=0) {
+		sound_data[vv->voice].backup_addr=sound_data[vv->voice].start_addr=sound_data[vv->voice].start_addr2=0;
+		sound_data[vv->voice].end_addr=sound_data[vv->voice].end_addr2=0;
+		sound_data[vv->voice].flags=0;
+
+		virtual_owner[vv->voice]=-1;
+		vv->voice=-1;
+	}
+}
+
+static void __asnd_startvirtual(t_virtual_voice *vv,s32 voice)
+{
+	t_sound_data *sd = &sound_data[voice];
+
+	sd->left=0;
+	sd->right=0;
+	sd->counter=0;
+
+	sd->freq=vv->pitch;
+	sd->delay_samples=vv->delay;
+
+	sd->volume_l=sd->volume2_l=vv->volume_l;
+	sd->volume_r=sd->volume2_r=vv->volume_r;
+
+	// the DSP fetches the samples in 32 bytes blocks from an aligned address
+	sd->backup_addr=sd->start_addr=vv->start_addr+(vv->pos & ~31);
+	sd->end_addr=vv->start_addr+vv->size;
+
+	if(vv->flags & VIRTUAL_LOOP)
+	{
+		sd->start_addr2=vv->start_addr;
+		sd->end_addr2=vv->start_addr+vv->size;
+		sd->flags=vv->format | VOICE_UPDATE | VOICE_SETLOOP;
+	}
+	else
+	{
+		sd->start_addr2=0;
+		sd->end_addr2=0;
+		sd->flags=vv->format | VOICE_UPDATE;
+	}
+
+	sd->tick_counter=0;
+	sd->cb=NULL;
+
+	virtual_owner[voice]=vv->index;
+	vv->voice=voice;
+}
+
+// advances a voice without DSP voice by one tick, returns 0 when a one-shot voice ends
+static s32 __asnd_advancevirtual(t_virtual_voice *vv)
+{
+	u32 samples = SND_BUFFERSIZE/4;
+
+	if(vv->flags & VIRTUAL_PAUSE) return 1;
+
+	if(vv->delay>=samples)
+	{
+		vv->delay-=samples;
+		return 1;
+	}
+	samples-=vv->delay;
+	vv->delay=0;
+
+	vv->frac+=vv->pitch*samples;
+	vv->pos+=(vv->frac/48000)*vv->step;
+	vv->frac%=48000;
+
+	if(vv->pos>=vv->size)
+	{
+		if(!(vv->flags & VIRTUAL_LOOP)) return 0;
+		vv->pos%=vv->size;
+	}
+
+	return 1;
+}
+
+// reads back the progress of a voice from its DSP voice, returns 0 when the DSP voice ended
+static s32 __asnd_syncvirtual(t_virtual_voice *vv)
+{
+	t_sound_data *sd = &sound_data[vv->voice];
+
+	if(!(sd->flags>>16) || !sd->start_addr) return 0;
+
+	vv->delay=sd->delay_samples;
+	if(sd->start_addr>=vv->start_addr && sd->start_addr<vv->start_addr+vv->size)
+		vv->pos=sd->start_addr-vv->start_addr;
+
+	return 1;
+}
+
+// ASND_SetVoice() and friends take a DSP voice back from the virtual voice on it,
+// which goes on without one until it wins a DSP voice again
+static void __asnd_demotevirtual(s32 voice)
+{
+	t_virtual_voice *vv;
+
+	if(virtual_owner[voice]<0) return;
+
+	vv=&virtual_voices[virtual_owner[voice]];
+	if(!__asnd_syncvirtual(vv)) vv->flags=0;
+	__asnd_stopvirtual(vv);
+}
+
+static void __asnd_updatevirtual()
+{
+	s32 best[MAX_VOICES];
+	u32 best_score[MAX_VOICES];
+	s32 nbest=0,nphys=0;
+	s32 n,m,v;
+	u32 score;
+	t_virtual_voice *vv;
+
+	if(time_of_process*100/21333>dsp_peak) dsp_peak=time_of_process*100/21333;
+
+	// voice 0 stays reserved for the player as in ASND_GetFirstUnusedVoice()
+	for(v=1;v<MAX_VOICES;v++)
+		if(virtual_owner[v]>=0 || !(sound_data[v].flags>>16)) nphys++;
+
+	for(n=0;n<(s32)virtual_cap;n++)
+	{
+		vv=&virtual_voices[n];
+		if(!vv->flags) continue;
+
+		if(vv->voice>=0)
+		{
+			if(!__asnd_syncvirtual(vv))
+			{
+				__asnd_stopvirtual(vv);
+				vv->flags=0;
+				continue;
+			}
+		}
+		else if(!__asnd_advancevirtual(vv))
+		{
+			vv->flags=0;
+			continue;
+		}
+
+		vv->flags&=~VIRTUAL_SELECTED;
+		if(vv->flags & VIRTUAL_PAUSE) continue;
+
+		// keep the nphys highest scores, sorted in descending order
+		score=__asnd_virtualscore(vv);
+		if(nbest==nphys && (nbest==0 || score<=best_score[nbest-1])) continue;
+		if(nbest<nphys) nbest++;
+
+		for(m=nbest-1;m>0 && best_score[m-1]<score;m--)
+		{
+			best[m]=best[m-1];
+			best_score[m]=best_score[m-1];
+		}
+		best[m]=n;
+		best_score[m]=score;
+	}
+
+	for(m=0;m<nbest;m++) virtual_voices[best[m]].flags|=VIRTUAL_SELECTED;
+
+	// steal the DSP voices of the losers first, their position keeps advancing virtually
+	for(n=0;n<(s32)virtual_cap;n++)
+	{
+		vv=&virtual_voices[n];
+		if(vv->flags && vv->voice>=0 && !(vv->flags & VIRTUAL_SELECTED))
+		{
+			__asnd_stopvirtual(vv);
+			if(!(vv->flags & VIRTUAL_PAUSE)) virtual_stolen++;
+		}
+	}
+
+	for(m=0;m<nbest;m++)
+	{
+		vv=&virtual_voices[best[m]];
+		if(vv->voice>=0) continue;
+
+		for(v=1;v<MAX_VOICES;v++)
+			if(virtual_owner[v]<0 && !(sound_data[v].flags>>16)) break;
+		if(v>=MAX_VOICES) break;
+
+		__asnd_startvirtual(vv,v);
+	}
+}
+
 static void __dsp_initcallback(dsptask_t *task)
 {
 	DSP_SendMailTo(0x0123); // command to fix the data operation
@@ -258,6 +526,8 @@ static void audio_dma_callback()
 
 	if(global_callback) global_callback();
 
+	__asnd_updatevirtual();
+
 	snd_chan = 0;
 	if(!sound_data[snd_chan].start_addr2 && (sound_data[snd_chan].flags>>16) && sound_data[snd_chan].cb) sound_data[snd_chan].cb(snd_chan);
 
@@ -357,6 +627,13 @@ void ASND_Init()
 		for(i=0;i<MAX_VOICES;i++)
 			memset(&sound_data[i],0,sizeof(t_sound_data));
 
+		for(i=0;i<MAX_VOICES;i++)
+			virtual_owner[i]=-1;
+		for(i=0;i<virtual_cap;i++)
+			virtual_voices[i].flags=0;
+		virtual_stolen=0;
+		dsp_peak=0;
+
 		dsp_task.prio = 255;
 		dsp_task.iram_maddr = (u16*)MEM_VIRTUAL_TO_PHYSICAL(dsp_mixer);
 		dsp_task.iram_len = dsp_mixer_size;
@@ -434,6 +711,8 @@ s32 ASND_SetVoice(s32 voice, s32 format, s32 pitch,s32 delay, void *snd, s32 siz
 
 	_CPU_ISR_Disable(level);
 
+	__asnd_demotevirtual(voice);
+
 	sound_data[voice].left=0;
 	sound_data[voice].right=0;
 	sound_data[voice].counter=0;
@@ -504,6 +783,8 @@ s32 ASND_SetInfiniteVoice(s32 voice, s32 format, s32 pitch,s32 delay, void *snd,
 
 	_CPU_ISR_Disable(level);
 
+	__asnd_demotevirtual(voice);
+
 	sound_data[voice].left=0;
 	sound_data[voice].right=0;
 	sound_data[voice].counter=0;
@@ -615,6 +896,8 @@ s32 ASND_StopVoice(s32 voice)
 
 	_CPU_ISR_Disable(level);
 
+	__asnd_demotevirtual(voice);
+
 	sound_data[voice].backup_addr=sound_data[voice].start_addr=sound_data[voice].start_addr2=0;
 	sound_data[voice].end_addr=sound_data[voice].end_addr2=0;
 	sound_data[voice].flags=0;
@@ -793,6 +1076,285 @@ u32 ASND_GetDSP_ProcessTime()
 
 /*------------------------------------------------------------------------------------------------------------------------------------------------------*/
 
+s32 ASND_SetVirtualVoice(s32 format, s32 pitch, s32 delay, void *snd, s32 size_snd, s32 volume_l, s32 volume_r, s32 priority, s32 loop)
+{
+	u32 level,n,cap;
+	s32 handle;
+	t_virtual_voice *vv,*tab=NULL,*old=NULL;
+
+	if(size_snd<=0 || snd==NULL || priority<0) return SND_INVALID; // invalid voice
+
+	DCFlushRange(snd, size_snd);
+
+	if(pitch<MIN_PITCH) pitch=MIN_PITCH;
+	if(pitch>MAX_PITCH) pitch=MAX_PITCH;
+
+	if(volume_l<MIN_VOLUME) volume_l=MIN_VOLUME;
+	if(volume_l>MAX_VOLUME) volume_l=MAX_VOLUME;
+
+	if(volume_r<MIN_VOLUME) volume_r=MIN_VOLUME;
+	if(volume_r>MAX_VOLUME) volume_r=MAX_VOLUME;
+
+	delay=(u32) (48000LL*((u64) delay)/1000LL);
+
+	_CPU_ISR_Disable(level);
+
+	for(n=0;n<virtual_cap;n++)
+		if(!virtual_voices[n].flags) break;
+
+	// the table is grown outside the interrupt lock: a bigger copy is made
+	// and swapped in under it, unless another thread grew the table meanwhile
+	while(n==virtual_cap)
+	{
+		cap=virtual_cap;
+		_CPU_ISR_Restore(level);
+
+		free(tab);
+		tab=NULL;
+		if(cap<0x10000) tab=malloc((cap+VIRTUAL_GROW)*sizeof(t_virtual_voice));
+		if(tab==NULL) return SND_INVALID; // out of memory
+
+		_CPU_ISR_Disable(level);
+
+		if(virtual_cap==cap)
+		{
+			if(cap) memcpy(tab,virtual_voices,cap*sizeof(t_virtual_voice));
+			memset(&tab[cap],0,VIRTUAL_GROW*sizeof(t_virtual_voice));
+			old=virtual_voices;
+			virtual_voices=tab;
+			virtual_cap+=VIRTUAL_GROW;
+			tab=NULL;
+		}
+
+		for(n=0;n<virtual_cap;n++)
+			if(!virtual_voices[n].flags) break;
+	}
+
+	vv=&virtual_voices[n];
+
+	vv->index=n;
+	vv->generation=(vv->generation+1) & 0x7fff;
+	vv->voice=-1;
+
+	vv->format=__asnd_formatflags(format);
+	vv->step=vv->format>>16;
+
+	vv->pitch=pitch;
+	vv->priority=priority;
+	vv->volume_l=volume_l;
+	vv->volume_r=volume_r;
+
+	vv->start_addr=MEM_VIRTUAL_TO_PHYSICAL(snd);
+	vv->size=size_snd;
+
+	vv->pos=0;
+	vv->frac=0;
+	vv->delay=delay;
+
+	vv->flags=VIRTUAL_USED;
+	if(loop) vv->flags|=VIRTUAL_LOOP;
+
+	handle=(vv->generation<<16) | n;
+
+	_CPU_ISR_Restore(level);
+
+	free(old);
+	free(tab);
+
+	return handle;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_StopVirtualVoice(s32 handle)
+{
+	u32 level;
+	t_virtual_voice *vv;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv==NULL)
+	{
+		_CPU_ISR_Restore(level);
+		return SND_INVALID; // invalid voice
+	}
+
+	__asnd_stopvirtual(vv);
+	vv->flags=0;
+
+	_CPU_ISR_Restore(level);
+
+	return SND_OK;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_PauseVirtualVoice(s32 handle, s32 pause)
+{
+	u32 level;
+	t_virtual_voice *vv;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv==NULL)
+	{
+		_CPU_ISR_Restore(level);
+		return SND_INVALID; // invalid voice
+	}
+
+	if(pause) vv->flags|=VIRTUAL_PAUSE; else vv->flags&=~VIRTUAL_PAUSE;
+
+	_CPU_ISR_Restore(level);
+
+	return SND_OK;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_StatusVirtualVoice(s32 handle)
+{
+	u32 level;
+	s32 status=SND_UNUSED;
+	t_virtual_voice *vv;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv!=NULL)
+	{
+		if(vv->flags & VIRTUAL_PAUSE) status=SND_WAITING;
+		else if(vv->voice>=0) status=SND_WORKING;
+		else status=SND_VIRTUAL;
+	}
+
+	_CPU_ISR_Restore(level);
+
+	return status;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_ChangeVolumeVirtualVoice(s32 handle, s32 volume_l, s32 volume_r)
+{
+	u32 level;
+	t_virtual_voice *vv;
+
+	if(volume_l<MIN_VOLUME) volume_l=MIN_VOLUME;
+	if(volume_l>MAX_VOLUME) volume_l=MAX_VOLUME;
+
+	if(volume_r<MIN_VOLUME) volume_r=MIN_VOLUME;
+	if(volume_r>MAX_VOLUME) volume_r=MAX_VOLUME;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv==NULL)
+	{
+		_CPU_ISR_Restore(level);
+		return SND_INVALID; // invalid voice
+	}
+
+	vv->volume_l=volume_l;
+	vv->volume_r=volume_r;
+
+	if(vv->voice>=0)
+	{
+		sound_data[vv->voice].flags |=VOICE_VOLUPDATE;
+		sound_data[vv->voice].volume_l= sound_data[vv->voice].volume2_l= volume_l;
+		sound_data[vv->voice].volume_r= sound_data[vv->voice].volume2_r= volume_r;
+	}
+
+	_CPU_ISR_Restore(level);
+
+	return SND_OK;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_ChangePitchVirtualVoice(s32 handle, s32 pitch)
+{
+	u32 level;
+	t_virtual_voice *vv;
+
+	if(pitch<MIN_PITCH) pitch=MIN_PITCH;
+	if(pitch>MAX_PITCH) pitch=MAX_PITCH;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv==NULL)
+	{
+		_CPU_ISR_Restore(level);
+		return SND_INVALID; // invalid voice
+	}
+
+	vv->pitch=pitch;
+	if(vv->voice>=0) sound_data[vv->voice].freq=pitch;
+
+	_CPU_ISR_Restore(level);
+
+	return SND_OK;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+s32 ASND_ChangePriorityVirtualVoice(s32 handle, s32 priority)
+{
+	u32 level;
+	t_virtual_voice *vv;
+
+	if(priority<0) return SND_INVALID;
+
+	_CPU_ISR_Disable(level);
+
+	vv=__asnd_getvirtual(handle);
+	if(vv==NULL)
+	{
+		_CPU_ISR_Restore(level);
+		return SND_INVALID; // invalid voice
+	}
+
+	vv->priority=priority;
+
+	_CPU_ISR_Restore(level);
+
+	return SND_OK;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+void ASND_GetVoiceStats(ASNDVoiceStats *stats)
+{
+	u32 level,n;
+
+	if(stats==NULL) return;
+
+	memset(stats,0,sizeof(ASNDVoiceStats));
+
+	_CPU_ISR_Disable(level);
+
+	for(n=0;n<virtual_cap;n++)
+	{
+		if(!virtual_voices[n].flags) continue;
+
+		stats->virtual_voices++;
+		if(virtual_voices[n].voice>=0) stats->real_voices++;
+	}
+
+	for(n=0;n<MAX_VOICES;n++)
+		if((sound_data[n].flags>>16) && virtual_owner[n]<0) stats->direct_voices++;
+
+	stats->stolen=virtual_stolen;
+	stats->dsp_percent=time_of_process*100/21333;
+	stats->dsp_peak=dsp_peak;
+
+	_CPU_ISR_Restore(level);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
 int ANote2Freq(int note, int freq_base,int note_base)
 {
 	int n;
@@ -39,6 +39,12 @@ mad_fixed_t mad_f_abs(mad_fixed_t x)
  * NAME:	fixed->div()
  * DESCRIPTION:	perform division using fixed-point math
  */
+# if defined(FPM_FLOAT)
+mad_fixed_t mad_f_div(mad_fixed_t x, mad_fixed_t y)
+{
+  return x / y;
+}
+# else
 mad_fixed_t mad_f_div(mad_fixed_t x, mad_fixed_t y)
 {
   mad_fixed_t q, r;
@@ -78,3 +84,4 @@ mad_fixed_t mad_f_div(mad_fixed_t x, mad_fixed_t y)
 
   return q << bits;
 }
+# endif
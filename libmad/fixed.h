@@ -23,7 +23,12 @@
 
 #include <gctypes.h>
 
-# if SIZEOF_INT >= 4
+# if defined(FPM_FLOAT)
+typedef float mad_fixed_t;
+
+typedef float mad_fixed64hi_t;
+typedef float mad_fixed64lo_t;
+# elif SIZEOF_INT >= 4
 typedef s32 mad_fixed_t;
 
 typedef s32 mad_fixed64hi_t;
@@ -107,11 +112,41 @@ typedef mad_fixed_t mad_sample_t;
 # define mad_f_add(x, y)	((x) + (y))
 # define mad_f_sub(x, y)	((x) - (y))
 
+/* integer x with the given number of fractional bits */
+# define mad_f_fromscaled(x, bits)  \
+				((mad_fixed_t) (x) << (MAD_F_FRACBITS - (bits)))
+
 # if defined(FPM_FLOAT)
-#  error "FPM_FLOAT not yet supported"
 
+/*
+ * Samples are single-precision floats with MAD_F_ONE == 1.0. The constant
+ * tables are converted at compile time, and products become plain
+ * multiplies that the FPU can fuse with the following add.
+ */
 #  undef MAD_F
-#  define MAD_F(x)		mad_f_todouble(x)
+#  define MAD_F(x)		((mad_fixed_t)  \
+				 ((double) (x) / (double) (1L << MAD_F_FRACBITS)))
+
+#  undef MAD_F_MIN
+#  undef MAD_F_MAX
+#  define MAD_F_MIN		((mad_fixed_t) -8.0)
+#  define MAD_F_MAX		((mad_fixed_t) +8.0)
+
+#  undef mad_f_tofixed
+#  undef mad_f_todouble
+#  define mad_f_tofixed(x)	((mad_fixed_t) (x))
+#  define mad_f_todouble(x)	((double) (x))
+
+#  undef mad_f_intpart
+#  undef mad_f_fracpart
+#  undef mad_f_fromint
+#  define mad_f_intpart(x)	((s32) (x))
+#  define mad_f_fracpart(x)	((x) - (mad_fixed_t) (s32) (x))
+#  define mad_f_fromint(x)	((mad_fixed_t) (x))
+
+#  undef mad_f_fromscaled
+#  define mad_f_fromscaled(x, bits)  \
+				((mad_fixed_t) (x) / (mad_fixed_t) (1L << (bits)))
 
 #  define mad_f_mul(x, y)	((x) * (y))
 #  define mad_f_scale64
@@ -21,7 +21,9 @@
 # ifndef LIBMAD_GLOBAL_H
 # define LIBMAD_GLOBAL_H
 
-# define FPM_PPC
+# if !defined(FPM_FLOAT)
+#  define FPM_PPC
+# endif
 /* conditional debugging */
 
 # if defined(DEBUG) && defined(NDEBUG)
@@ -38,10 +40,14 @@
 #  error "cannot optimize for both speed and accuracy"
 # endif
 
-# if defined(OPT_SPEED) && !defined(OPT_SSO)
+# if defined(OPT_SPEED) && !defined(OPT_SSO) && !defined(FPM_FLOAT)
 #  define OPT_SSO
 # endif
 
+# if defined(FPM_FLOAT) && defined(OPT_SSO)
+#  error "OPT_SSO cannot be used with FPM_FLOAT"
+# endif
+
 # if defined(HAVE_UNISTD_H) && defined(HAVE_WAITPID) &&  \
     defined(HAVE_FCNTL) && defined(HAVE_PIPE) && defined(HAVE_FORK)
 #  define USE_ASYNC
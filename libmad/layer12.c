@@ -74,21 +74,22 @@ static
 mad_fixed_t I_sample(struct mad_bitptr *ptr, u32 nb)
 {
   mad_fixed_t sample;
+  s32 value;
 
-  sample = mad_bit_read(ptr, nb);
+  value = mad_bit_read(ptr, nb);
 
   /* invert most significant bit, extend sign, then scale to fixed format */
 
-  sample ^= 1 << (nb - 1);
-  sample |= -(sample & (1 << (nb - 1)));
+  value ^= 1 << (nb - 1);
+  value |= -(value & (1 << (nb - 1)));
 
-  sample <<= MAD_F_FRACBITS - (nb - 1);
+  sample = mad_f_fromscaled(value, nb - 1);
 
   /* requantize the sample */
 
   /* s'' = (2^nb / (2^nb - 1)) * (s''' + 2^(-nb + 1)) */
 
-  sample += MAD_F_ONE >> (nb - 1);
+  sample += mad_f_fromscaled(1, nb - 1);
 
   return mad_f_mul(sample, linear_table[nb - 2]);
 
@@ -304,13 +305,14 @@ void II_samples(struct mad_bitptr *ptr,
 
   for (s = 0; s < 3; ++s) {
     mad_fixed_t requantized;
+    s32 value;
 
     /* invert most significant bit, extend sign, then scale to fixed format */
 
-    requantized  = sample[s] ^ (1 << (nb - 1));
-    requantized |= -(requantized & (1 << (nb - 1)));
+    value  = sample[s] ^ (1 << (nb - 1));
+    value |= -(value & (1 << (nb - 1)));
 
-    requantized <<= MAD_F_FRACBITS - (nb - 1);
+    requantized = mad_f_fromscaled(value, nb - 1);
 
     /* requantize the sample */
 
@@ -32,6 +32,7 @@
 # endif
 
 #include <limits.h>
+#include <math.h>
 
 # include "fixed.h"
 # include "bit.h"
@@ -329,7 +330,16 @@ struct fixedfloat {
   u32 mantissa  : 27;
   u16 exponent :  5;
 } const rq_table[8207] = {
+# if defined(FPM_FLOAT)
+  /* the mantissas stay 4.28 integers, III_requantize() scales them */
+#  pragma push_macro("MAD_F")
+#  undef MAD_F
+#  define MAD_F(x)		(x)
+# endif
 # include "rq_table.dat"
+# if defined(FPM_FLOAT)
+#  pragma pop_macro("MAD_F")
+# endif
 };
 
 /*
@@ -885,9 +895,18 @@ mad_fixed_t III_requantize(u32 value, s32 exp)
   exp /= 4;
 
   power = &rq_table[value];
-  requantized = power->mantissa;
   exp += power->exponent;
 
+# if defined(FPM_FLOAT)
+  if (exp >= 5) {
+    /* overflow */
+    requantized = MAD_F_MAX;
+  }
+  else
+    requantized = ldexpf((mad_fixed_t) power->mantissa, exp - MAD_F_FRACBITS);
+# else
+  requantized = power->mantissa;
+
   if (exp < 0) {
     if (-exp >= sizeof(mad_fixed_t) * CHAR_BIT) {
       /* underflow */
@@ -910,6 +929,7 @@ mad_fixed_t III_requantize(u32 value, s32 exp)
     else
       requantized <<= exp;
   }
+# endif
 
   return frac ? mad_f_mul(requantized, root_table[3 + frac]) : requantized;
 }
@@ -29,10 +29,21 @@ static u32 mp3_volume = 256;
 #else
 	#define ADMA_BUFFERSIZE			(8192)
 #endif
-#define STACKSIZE				(32768)
+#define STACKSIZE				(65536)
 
 #define DATABUFFER_SIZE			(32768)
 
+#define RESAMPLE_PHASEBITS		8
+#define RESAMPLE_PHASES			(1<<RESAMPLE_PHASEBITS)
+#define RESAMPLE_MAXTAPS		16
+#define RESAMPLE_CHUNK			2048
+
+#define INDEX_STRIDE			16
+#define INDEX_GROW				1024
+#define SEEK_PREROLL			2
+#define SEEK_MAXPREROLL			16
+#define SEEK_RESERVOIR			511
+
 typedef struct _eqstate_s
 {
 	f32 lf;
@@ -56,6 +67,45 @@ typedef struct _eqstate_s
 	f32 hg;
 } EQState;
 
+typedef struct _resampler_s
+{
+	u32 pos;
+	u32 incr;
+	u32 taps;
+	u32 count;
+	u32 channels;
+	u32 quality;
+	u32 src_samplerate;
+	s16 hist[2][RESAMPLE_MAXTAPS+1152];
+} Resampler;
+
+typedef struct _streaminfo_s
+{
+	s32 size;
+	s32 readpos;
+	s32 bufpos;
+	s32 datastart;
+	u32 samplerate;
+	u32 spf;
+	u32 layer;
+	u32 minframe;
+	u32 frame;
+	u32 skip;
+	u32 mute;
+	BOOL exact;
+
+	u32 frames;
+	u32 bytes;
+	BOOL havetoc;
+	u8 toc[100];
+
+	u32 *index;
+	u32 indexcnt;
+	u32 indexcap;
+	u32 stride;
+	BOOL indexfixed;
+} StreamInfo;
+
 struct _outbuffer_s
 {
 	void *bs;
@@ -67,6 +117,18 @@ struct _outbuffer_s
 static u8 InputBuffer[DATABUFFER_SIZE+MAD_BUFFER_GUARD];
 static u8 OutputBuffer[3][ADMA_BUFFERSIZE] ATTRIBUTE_ALIGN(32);
 static struct _outbuffer_s OutputRingBuffer;
+
+static Resampler ResampleState;
+static s16 ResampleCoeffs[RESAMPLE_PHASES][RESAMPLE_MAXTAPS] ATTRIBUTE_ALIGN(32);
+static u32 ResampleCoeffTaps = 0;
+static u32 ResampleOutput[RESAMPLE_CHUNK] ATTRIBUTE_ALIGN(32);
+static u32 mp3_quality = MP3PLAYER_QUALITY_MEDIUM;
+static f32 mp3_eqgain[3] = {1.0F,1.0F,1.0F};
+
+static StreamInfo Info;
+static s32 SeekTarget = -1;
+static u32 PositionMs = 0;
+static u32 DurationMs = 0;
 	
 static u32 init_done = 0;
 static u32 CurrentBuffer = 0;
@@ -81,12 +143,17 @@ static lwp_t hStreamPlay;
 static lwpq_t thQueue;
 
 static s32 (*mp3read)(void*,void *,s32);
+static s32 (*mp3seek)(void*,s32,s32);
 static void (*mp3filterfunc)(struct mad_stream *,struct mad_frame *);
 
 static void DataTransferCallback();
 static void Init3BandState(EQState *es,s32 lowfreq,s32 highfreq,s32 mixfreq);
 static s16 Do3Band(EQState *es,s16 sample);
+static void ResampleReset(Resampler *rs,u32 channels,u32 src_samplerate);
 static void Resample(struct mad_pcm *Pcm,EQState eqs[2],u32 stereo,u32 src_samplerate);
+static BOOL StreamParseInfo(StreamInfo *si,struct mad_stream *Stream,struct mad_header *Header);
+static BOOL StreamFrameDone(StreamInfo *si,struct mad_stream *Stream,struct mad_header *Header,mad_timer_t *Timer);
+static BOOL StreamSeek(StreamInfo *si,u32 ms,mad_timer_t *Timer);
 
 struct _rambuffer
 {
@@ -102,8 +169,12 @@ static __inline__ s16 FixedToShort(mad_fixed_t Fixed)
 	if(Fixed<=-MAD_F_ONE)
 		return(-SHRT_MAX);
 
+#if defined(FPM_FLOAT)
+	return((s16)(Fixed*32768.0f));
+#else
 	Fixed=Fixed>>(MAD_F_FRACBITS-15);
 	return((s16)Fixed);
+#endif
 }
 
 static __inline__ void buf_init(struct _outbuffer_s *buf)
@@ -161,8 +232,8 @@ static __inline__ s32 buf_get(struct _outbuffer_s *buf,void *data,s32 len)
 
 static __inline__ s32 buf_put(struct _outbuffer_s *buf,void *data,s32 len)
 {
-	u32 *p;
-	s32 cnt,i;
+	u8 *p;
+	s32 cnt;
 
 	while(len>buf_space(buf))
 		LWP_ThreadSleep(thQueue);
@@ -170,14 +241,12 @@ static __inline__ s32 buf_put(struct _outbuffer_s *buf,void *data,s32 len)
 	p = data;
 	cnt = ((u32)buf->bs + DATABUFFER_SIZE - (u32)buf->put);
 	if(len>cnt) {
-		for(i=0;i<(cnt>>2);i++)
-			*buf->put++ = *p++;
-		buf->put = buf->bs;
-		for(i=0;i<((len-cnt)>>2);i++)
-			*buf->put++ = *p++;
+		memcpy(buf->put,p,cnt);
+		memcpy(buf->bs,p+cnt,len-cnt);
+		buf->put = (u32*)((u8*)buf->bs + (len-cnt));
 	} else {
-		for(i=0;i<(len>>2);i++)
-			*buf->put++ = *p++;
+		memcpy(buf->put,p,len);
+		buf->put = (u32*)((u8*)buf->put + len);
 	}
 
 	if(buf->buf_filled==0 && buf_used(buf)>=(DATABUFFER_SIZE>>1)) {
@@ -215,6 +284,28 @@ static s32 _mp3ramcopy(void *usr_data,void *buffer,s32 len)
 	return len;
 }
 
+static s32 _mp3ramseek(void *usr_data,s32 offset,s32 whence)
+{
+	struct _rambuffer *ram = (struct _rambuffer*)usr_data;
+
+	switch(whence) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			offset += ram->pos;
+			break;
+		case SEEK_END:
+			offset += ram->len;
+			break;
+		default:
+			return -1;
+	}
+	if(offset<0 || offset>ram->len) return -1;
+
+	ram->pos = offset;
+	return offset;
+}
+
 void MP3Player_Init()
 {
 	if(!init_done) {
@@ -239,6 +330,7 @@ s32 MP3Player_PlayBuffer(const void *buffer,s32 len,void (*filterfunc)(struct ma
 
 	mp3cb_data = &rambuffer;
 	mp3read = _mp3ramcopy;
+	mp3seek = _mp3ramseek;
 	mp3filterfunc = filterfunc;
 	if(LWP_CreateThread(&hStreamPlay,StreamPlay,NULL,StreamPlay_Stack,STACKSIZE,LWP_PRIO_HIGH)!=0) {
 		return -1;
@@ -252,6 +344,21 @@ s32 MP3Player_PlayFile(void *cb_data,s32 (*reader)(void *,void *,s32),void (*fil
 
 	mp3cb_data = cb_data;
 	mp3read = reader;
+	mp3seek = NULL;
+	mp3filterfunc = filterfunc;
+	if(LWP_CreateThread(&hStreamPlay,StreamPlay,NULL,StreamPlay_Stack,STACKSIZE,LWP_PRIO_HIGH)!=0) {
+		return -1;
+	}
+	return 0;
+}
+
+s32 MP3Player_PlayFileSeekable(void *cb_data,s32 (*reader)(void *,void *,s32),s32 (*seeker)(void *,s32,s32),void (*filterfunc)(struct mad_stream *,struct mad_frame *))
+{
+	if(thr_running==TRUE) return -1;
+
+	mp3cb_data = cb_data;
+	mp3read = reader;
+	mp3seek = seeker;
 	mp3filterfunc = filterfunc;
 	if(LWP_CreateThread(&hStreamPlay,StreamPlay,NULL,StreamPlay_Stack,STACKSIZE,LWP_PRIO_HIGH)!=0) {
 		return -1;
@@ -272,11 +379,36 @@ BOOL MP3Player_IsPlaying()
 	return thr_running;
 }
 
+s32 MP3Player_Seek(u32 ms)
+{
+	if(thr_running==FALSE || mp3seek==NULL) return -1;
+
+	SeekTarget = (s32)(ms&0x7fffffff);
+	return 0;
+}
+
+u32 MP3Player_GetPosition()
+{
+	u32 buffered;
+
+	if(thr_running==FALSE) return 0;
+
+	buffered = ((buf_used(&OutputRingBuffer)>>2)*1000)/48000;
+	return (PositionMs>buffered)?(PositionMs-buffered):0;
+}
+
+u32 MP3Player_GetDuration()
+{
+	return DurationMs;
+}
+
 static void *StreamPlay(void *arg)
 {
+	u32 ms,level;
 	BOOL atend;
 	u8 *GuardPtr = NULL;
 	struct mad_stream Stream;
+	struct mad_header Header;
 	struct mad_frame Frame;
 	struct mad_synth Synth;
 	mad_timer_t Timer;
@@ -284,12 +416,31 @@ static void *StreamPlay(void *arg)
 
 	thr_running = TRUE;
 
+	memset(&Info,0,sizeof(StreamInfo));
+	Info.size = -1;
+	Info.datastart = -1;
+	Info.exact = TRUE;
+	Info.stride = INDEX_STRIDE;
+	if(mp3seek!=NULL) {
+		Info.readpos = mp3seek(mp3cb_data,0,SEEK_CUR);
+		Info.size = mp3seek(mp3cb_data,0,SEEK_END);
+		if(Info.readpos<0 || mp3seek(mp3cb_data,Info.readpos,SEEK_SET)<0) {
+			Info.readpos = 0;
+			Info.size = -1;
+			mp3seek = NULL;
+		}
+	}
+	SeekTarget = -1;
+	PositionMs = 0;
+	DurationMs = 0;
+
 	CurrentBuffer = 0;
 	memset(OutputBuffer[0],0,ADMA_BUFFERSIZE);
 	memset(OutputBuffer[1],0,ADMA_BUFFERSIZE);
 	memset(OutputBuffer[2],0,ADMA_BUFFERSIZE);
 
 	buf_init(&OutputRingBuffer);
+	ResampleState.src_samplerate = 0;
 	LWP_InitQueue(&thQueue);
 	Init3BandState(&eqs[0],880,5000,48000);
 	Init3BandState(&eqs[1],880,5000,48000);
@@ -299,6 +450,7 @@ static void *StreamPlay(void *arg)
 #endif
 
 	mad_stream_init(&Stream);
+	mad_header_init(&Header);
 	mad_frame_init(&Frame);
 	mad_synth_init(&Synth);
 	mad_timer_reset(&Timer);
@@ -306,6 +458,29 @@ static void *StreamPlay(void *arg)
 	atend = FALSE;
 	MP3Playing = FALSE;
 	while(atend==FALSE && thr_running==TRUE) {
+		if(SeekTarget>=0 && Info.datastart>=0) {
+			_CPU_ISR_Disable(level);
+			ms = SeekTarget;
+			SeekTarget = -1;
+			_CPU_ISR_Restore(level);
+
+			if(StreamSeek(&Info,ms,&Timer)==TRUE) {
+				/* restart with an empty bit reservoir; the pre-roll frames refill it */
+				mad_stream_finish(&Stream);
+				mad_stream_init(&Stream);
+				mad_frame_mute(&Frame);
+				mad_synth_mute(&Synth);
+				ResampleState.src_samplerate = 0;
+				GuardPtr = NULL;
+
+				/* drop the audio decoded before the seek, so the position does not count it */
+				_CPU_ISR_Disable(level);
+				buf_init(&OutputRingBuffer);
+				PositionMs = ms;
+				_CPU_ISR_Restore(level);
+			}
+		}
+
 		if(Stream.buffer==NULL || Stream.error==MAD_ERROR_BUFLEN) {
 			u8 *ReadStart;
 			s32 ReadSize, Remaining;
@@ -315,10 +490,12 @@ static void *StreamPlay(void *arg)
 				memmove(InputBuffer,Stream.next_frame,Remaining);
 				ReadStart = InputBuffer + Remaining;
 				ReadSize = DATABUFFER_SIZE - Remaining;
+				Info.bufpos += (Stream.next_frame - InputBuffer);
 			} else {
 				ReadSize = DATABUFFER_SIZE;
 				ReadStart = InputBuffer;
 				Remaining = 0;
+				Info.bufpos = Info.readpos;
 			}
 
 
@@ -328,20 +505,48 @@ static void *StreamPlay(void *arg)
 				memset(GuardPtr,0,MAD_BUFFER_GUARD);
 				ReadSize = MAD_BUFFER_GUARD;
 				atend = TRUE;
-			}
+			} else
+				Info.readpos += ReadSize;
 
 			mad_stream_buffer(&Stream,InputBuffer,(ReadSize + Remaining));
 			//Stream.error = 0;
 		}
 
-		while (!mad_frame_decode(&Frame,&Stream) && thr_running==TRUE) {
+		while(thr_running==TRUE && !(SeekTarget>=0 && Info.datastart>=0)) {
+			if(Info.skip>0) {
+				/* headers only: step over frames that lie before the pre-roll */
+				if(mad_header_decode(&Header,&Stream)) break;
+
+				StreamFrameDone(&Info,&Stream,&Header,&Timer);
+				continue;
+			}
+
+			if(mad_frame_decode(&Frame,&Stream)) {
+				if(Info.datastart>=0 && MAD_RECOVERABLE(Stream.error) && Stream.error>=MAD_ERROR_BADCRC)
+					StreamFrameDone(&Info,&Stream,&Frame.header,&Timer);
+				break;
+			}
+
+			if(Info.datastart<0 && StreamParseInfo(&Info,&Stream,&Frame.header)==TRUE)
+				continue;
+
+			if(StreamFrameDone(&Info,&Stream,&Frame.header,&Timer)==FALSE) {
+				mad_synth_frame(&Synth,&Frame);
+				continue;
+			}
+
 			if(mp3filterfunc)
 				mp3filterfunc(&Stream,&Frame);
 
-			mad_timer_add(&Timer,Frame.header.duration);
 			mad_synth_frame(&Synth,&Frame);
 
 			Resample(&Synth.pcm,eqs,(MAD_NCHANNELS(&Frame.header)==2),Frame.header.samplerate);
+			PositionMs = mad_timer_count(Timer,MAD_UNITS_MILLISECONDS);
+		}
+
+		if(SeekTarget>=0 && Info.datastart>=0) {
+			atend = FALSE;
+			continue;
 		}
 
 		if(MAD_RECOVERABLE(Stream.error)) {
@@ -355,8 +560,12 @@ static void *StreamPlay(void *arg)
 
 	mad_synth_finish(&Synth);
 	mad_frame_finish(&Frame);
+	mad_header_finish(&Header);
 	mad_stream_finish(&Stream);
 
+	free(Info.index);
+	Info.index = NULL;
+
 	while(MP3Playing==TRUE)
 		LWP_ThreadSleep(thQueue);
 
@@ -374,33 +583,324 @@ static void *StreamPlay(void *arg)
 	return 0;
 }
 
-typedef union {
-	struct {
-		u16 hi;
-		u16 lo;
-	} aword;
-	u32 adword;
-} dword;
+static void ResampleInitCoeffs(u32 taps)
+{
+	u32 i,k;
+	f32 c[RESAMPLE_MAXTAPS];
+	f32 x,t,fc,sum;
+
+	/* Blackman-windowed sinc, cut off just below the source Nyquist rate */
+	fc = (taps>8)?0.95F:0.90F;
+	for(i=0;i<RESAMPLE_PHASES;i++) {
+		sum = 0.0F;
+		for(k=0;k<taps;k++) {
+			x = (f32)k - (f32)(taps/2 - 1) - (f32)i/(f32)RESAMPLE_PHASES;
+			t = x/(f32)(taps/2);
+
+			c[k] = (x==0.0F)?fc:(sinf(M_PI*fc*x)/(M_PI*x));
+			c[k] *= 0.42F + 0.5F*cosf(M_PI*t) + 0.08F*cosf(2.0F*M_PI*t);
+			sum += c[k];
+		}
+
+		/* normalize every phase to unity gain in 2.14 */
+		for(k=0;k<taps;k++)
+			ResampleCoeffs[i][k] = (s16)floorf((c[k]*16384.0F)/sum + 0.5F);
+	}
+	ResampleCoeffTaps = taps;
+}
+
+static void ResampleReset(Resampler *rs,u32 channels,u32 src_samplerate)
+{
+	rs->channels = channels;
+	rs->quality = mp3_quality;
+	rs->src_samplerate = src_samplerate;
+	rs->incr = (u32)(((u64)src_samplerate<<16)/48000);
+
+	if(src_samplerate==48000)
+		rs->taps = 1;
+	else if(rs->quality==MP3PLAYER_QUALITY_LOW)
+		rs->taps = 2;
+	else if(rs->quality==MP3PLAYER_QUALITY_MEDIUM)
+		rs->taps = 8;
+	else
+		rs->taps = 16;
+
+	if(rs->taps>2 && ResampleCoeffTaps!=rs->taps)
+		ResampleInitCoeffs(rs->taps);
+
+	/* prime the history so the first output lands on the first input sample */
+	rs->pos = 0;
+	rs->count = (rs->taps>1)?(rs->taps/2 - 1):0;
+	memset(rs->hist,0,sizeof(rs->hist));
+}
+
+static __inline__ s16 ResampleTap(const Resampler *rs,const s16 *in,u32 pos)
+{
+	const s16 *c;
+	s32 acc,k;
+
+	if(rs->taps==1)
+		return in[0];
+
+	if(rs->taps==2)
+		return (s16)(in[0] + (((in[1] - in[0])*(s32)((pos&0xffff)>>1))>>15));
+
+	c = ResampleCoeffs[(pos&0xffff)>>(16-RESAMPLE_PHASEBITS)];
+
+	acc = (1<<13);
+	for(k=0;k<rs->taps;k++)
+		acc += in[k]*c[k];
+	acc >>= 14;
+
+	if(acc>SHRT_MAX) acc = SHRT_MAX;
+	if(acc<SHRT_MIN) acc = SHRT_MIN;
+	return (s16)acc;
+}
 
 static void Resample(struct mad_pcm *Pcm,EQState eqs[2],u32 stereo,u32 src_samplerate)
 {
-	u16 val16;
-	u32 val32;
-	dword pos;
-	s32 incr;
-
-	pos.adword = 0;
-	incr = (u32)(((f32)src_samplerate/48000.0F)*65536.0F);
-	while(pos.aword.hi<Pcm->length) {
-		val16 = Do3Band(&eqs[0],FixedToShort(Pcm->samples[0][pos.aword.hi]));
-		val32 = (val16<<16);
-
-		if(stereo) val16 = Do3Band(&eqs[1],FixedToShort(Pcm->samples[1][pos.aword.hi]));
-		val32 |= val16;
-		
-		buf_put(&OutputRingBuffer,&val32,sizeof(u32));
-		pos.adword += incr;
+	u32 i,n,ip;
+	s16 l,r;
+	BOOL eqflat;
+	Resampler *rs = &ResampleState;
+
+	if(rs->src_samplerate!=src_samplerate || rs->channels!=(stereo?2:1) || rs->quality!=mp3_quality)
+		ResampleReset(rs,(stereo?2:1),src_samplerate);
+
+	eqflat = (mp3_eqgain[0]==1.0F && mp3_eqgain[1]==1.0F && mp3_eqgain[2]==1.0F);
+	for(i=0;i<2;i++) {
+		eqs[i].lg = mp3_eqgain[0];
+		eqs[i].mg = mp3_eqgain[1];
+		eqs[i].hg = mp3_eqgain[2];
+	}
+
+	for(i=0;i<Pcm->length;i++) {
+		rs->hist[0][rs->count+i] = FixedToShort(Pcm->samples[0][i]);
+		if(stereo) rs->hist[1][rs->count+i] = FixedToShort(Pcm->samples[1][i]);
+	}
+	rs->count += Pcm->length;
+
+	n = 0;
+	while(((rs->pos>>16)+rs->taps)<=rs->count) {
+		ip = (rs->pos>>16);
+
+		l = ResampleTap(rs,&rs->hist[0][ip],rs->pos);
+		r = stereo?ResampleTap(rs,&rs->hist[1][ip],rs->pos):l;
+
+		if(!eqflat) {
+			l = Do3Band(&eqs[0],l);
+			r = stereo?Do3Band(&eqs[1],r):l;
+		}
+
+		ResampleOutput[n++] = ((u16)l<<16)|(u16)r;
+		if(n==RESAMPLE_CHUNK) {
+			buf_put(&OutputRingBuffer,ResampleOutput,(n*sizeof(u32)));
+			n = 0;
+		}
+		rs->pos += rs->incr;
 	}
+
+	if(n>0)
+		buf_put(&OutputRingBuffer,ResampleOutput,(n*sizeof(u32)));
+
+	/* keep the unconsumed tail as history for the next frame */
+	ip = (rs->pos>>16);
+	rs->count -= ip;
+	rs->pos -= (ip<<16);
+	memmove(rs->hist[0],&rs->hist[0][ip],(rs->count*sizeof(s16)));
+	if(stereo) memmove(rs->hist[1],&rs->hist[1][ip],(rs->count*sizeof(s16)));
+}
+
+static __inline__ u32 read_be(const u8 *ptr,u32 len)
+{
+	u32 val = 0;
+
+	while(len-->0)
+		val = (val<<8)|*ptr++;
+	return val;
+}
+
+static void StreamIndexAdd(StreamInfo *si,s32 offset)
+{
+	u32 *index;
+
+	if(si->indexfixed==TRUE || si->exact==FALSE) return;
+	if(si->frame!=(si->indexcnt*si->stride)) return;
+
+	if(si->indexcnt==si->indexcap) {
+		index = realloc(si->index,(si->indexcap+INDEX_GROW)*sizeof(u32));
+		if(index==NULL) return;
+
+		si->index = index;
+		si->indexcap += INDEX_GROW;
+	}
+	si->index[si->indexcnt++] = offset;
+}
+
+static BOOL StreamParseInfo(StreamInfo *si,struct mad_stream *Stream,struct mad_header *Header)
+{
+	u32 i,n,len,xoff,flags;
+	u32 entries,scale,size;
+	const u8 *ptr = Stream->this_frame;
+	BOOL tag = FALSE,vbri = FALSE;
+
+	si->samplerate = Header->samplerate;
+	si->spf = 32*MAD_NSBSAMPLES(Header);
+	si->layer = Header->layer;
+
+	len = (Stream->next_frame - Stream->this_frame);
+	if(Header->layer==MAD_LAYER_III) {
+		/* the Xing/Info tag follows the side information of the first frame */
+		if(Header->flags&MAD_FLAG_LSF_EXT)
+			xoff = (Header->mode==MAD_MODE_SINGLE_CHANNEL)?(4+9):(4+17);
+		else
+			xoff = (Header->mode==MAD_MODE_SINGLE_CHANNEL)?(4+17):(4+32);
+
+		if(len>=(xoff+8) && (memcmp(ptr+xoff,"Xing",4)==0 || memcmp(ptr+xoff,"Info",4)==0)) {
+			tag = TRUE;
+			flags = read_be(ptr+xoff+4,4);
+
+			n = xoff+8;
+			if((flags&0x01) && len>=(n+4)) {
+				si->frames = read_be(ptr+n,4);
+				n += 4;
+			}
+			if((flags&0x02) && len>=(n+4)) {
+				si->bytes = read_be(ptr+n,4);
+				n += 4;
+			}
+			if((flags&0x04) && len>=(n+100)) {
+				memcpy(si->toc,ptr+n,100);
+				si->havetoc = TRUE;
+			}
+		} else if(len>=62 && memcmp(ptr+36,"VBRI",4)==0) {
+			tag = vbri = TRUE;
+			si->bytes = read_be(ptr+46,4);
+			si->frames = read_be(ptr+50,4);
+		}
+	}
+
+	si->datastart = si->bufpos + ((tag==TRUE?Stream->next_frame:Stream->this_frame) - InputBuffer);
+
+	if(vbri==TRUE) {
+		/* the VBRI table gives the size of every group of frames: turn it into the index */
+		entries = read_be(ptr+54,2);
+		scale = read_be(ptr+56,2);
+		size = read_be(ptr+58,2);
+		n = read_be(ptr+60,2);
+		if(entries>0 && size>=1 && size<=4 && n>0 && len>=(62+entries*size)) {
+			si->index = malloc(entries*sizeof(u32));
+			if(si->index!=NULL) {
+				si->index[0] = si->datastart;
+				for(i=1;i<entries;i++)
+					si->index[i] = si->index[i-1] + read_be(ptr+62+(i-1)*size,size)*scale;
+
+				si->indexcnt = si->indexcap = entries;
+				si->stride = n;
+				si->indexfixed = TRUE;
+			}
+		}
+	}
+
+	if(si->frames>0 && si->samplerate>0)
+		DurationMs = (u32)(((u64)si->frames*si->spf*1000)/si->samplerate);
+	else if(si->size>si->datastart && Header->bitrate>0)
+		DurationMs = (u32)(((u64)(si->size - si->datastart)*8000)/Header->bitrate);
+
+	return tag;
+}
+
+static BOOL StreamFrameDone(StreamInfo *si,struct mad_stream *Stream,struct mad_header *Header,mad_timer_t *Timer)
+{
+	u32 len = (Stream->next_frame - Stream->this_frame);
+
+	if(si->minframe==0 || len<si->minframe) si->minframe = len;
+
+	StreamIndexAdd(si,si->bufpos + (Stream->this_frame - InputBuffer));
+	mad_timer_add(Timer,Header->duration);
+	si->frame++;
+
+	if(si->skip>0) {
+		si->skip--;
+		return FALSE;
+	}
+	if(si->mute>0) {
+		si->mute--;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static BOOL StreamSeek(StreamInfo *si,u32 ms,mad_timer_t *Timer)
+{
+	u32 i,k,bytes;
+	u32 target,start,preroll,data;
+	u32 frame,skip;
+	BOOL exact;
+	s32 offset;
+	f32 pct,fa,fb;
+
+	if(mp3seek==NULL || si->samplerate==0 || si->spf==0) return FALSE;
+
+	/* without a frame count the duration is a guess from the first bitrate: past the end stops the stream */
+	if(si->frames>0 && DurationMs>0 && ms>=DurationMs) ms = DurationMs - 1;
+	target = (u32)(((u64)ms*si->samplerate)/((u64)si->spf*1000));
+	if(si->frames>0 && target>=si->frames) target = si->frames - 1;
+
+	/* decode a few frames ahead of the target to refill the bit reservoir and the overlap:
+	   the frame before the target must decode, and its main data may begin 511 bytes back,
+	   in frames as small as the smallest one seen */
+	preroll = SEEK_PREROLL;
+	if(si->layer==MAD_LAYER_III && si->minframe>(4+32)) {
+		data = si->minframe - (4+32);
+		preroll = 1 + (SEEK_RESERVOIR + data - 1)/data;
+		if(preroll<SEEK_PREROLL) preroll = SEEK_PREROLL;
+		if(preroll>SEEK_MAXPREROLL) preroll = SEEK_MAXPREROLL;
+	}
+	start = (target>preroll)?(target - preroll):0;
+
+	bytes = si->bytes;
+	if(bytes==0 && si->size>si->datastart) bytes = (si->size - si->datastart);
+
+	if(si->havetoc==TRUE && si->frames>0 && bytes>0) {
+		pct = ((f32)start*100.0F)/(f32)si->frames;
+		i = (u32)pct;
+		if(i>99) i = 99;
+
+		fa = si->toc[i];
+		fb = (i<99)?si->toc[i+1]:256.0F;
+		offset = si->datastart + (s32)(((fa + (fb - fa)*(pct - i))*bytes)/256.0F);
+
+		/* the TOC does not land on a frame boundary: let libmad resync, stop indexing */
+		frame = start;
+		skip = 0;
+		exact = FALSE;
+	} else if(si->indexcnt>0) {
+		k = start/si->stride;
+		if(k>=si->indexcnt) k = si->indexcnt - 1;
+
+		offset = si->index[k];
+		frame = k*si->stride;
+		skip = start - frame;
+		exact = si->exact;
+	} else {
+		offset = si->datastart;
+		frame = 0;
+		skip = start;
+		exact = si->exact;
+	}
+
+	if(mp3seek(mp3cb_data,offset,SEEK_SET)<0) return FALSE;
+
+	si->frame = frame;
+	si->skip = skip;
+	si->mute = target - start;
+	si->exact = exact;
+	si->readpos = offset;
+	si->bufpos = offset;
+
+	mad_timer_set(Timer,0,si->frame*si->spf,si->samplerate);
+	return TRUE;
 }
 
 static void Init3BandState(EQState *es,s32 lowfreq,s32 highfreq,s32 mixfreq)
@@ -471,6 +971,20 @@ static void DataTransferCallback()
 #endif
 }
 
+void MP3Player_SetQuality(u32 quality)
+{
+	if(quality>MP3PLAYER_QUALITY_HIGH) quality = MP3PLAYER_QUALITY_HIGH;
+
+	mp3_quality = quality;
+}
+
+void MP3Player_SetEqualizer(f32 low,f32 mid,f32 high)
+{
+	mp3_eqgain[0] = low;
+	mp3_eqgain[1] = mid;
+	mp3_eqgain[2] = high;
+}
+
 void MP3Player_Volume(u32 volume)
 {
 	if(volume>256) volume = 256;
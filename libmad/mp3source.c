@@ -0,0 +1,304 @@
+/*-------------------------------------------------------------
+
+mp3source.c -- MP3 streaming source for AESND voices
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <ogcsys.h>
+#include <ogc/timesupp.h>
+#include <ogc/machine/processor.h>
+
+#include "mad.h"
+#include "aesndlib.h"
+#include "mp3source.h"
+
+#define INPUT_SIZE			(8192)
+#define MAX_DECODES			(3)			// frame decode attempts per fill, lost sync included
+
+struct _mp3source
+{
+	struct mad_stream stream;
+	struct mad_frame frame;
+	struct mad_synth synth;
+
+	void *cb_data;
+	s32 (*reader)(void *,void *,s32);
+
+	const u8 *mem;
+	s32 memlen;
+	s32 mempos;
+
+	AESNDPB *pb;
+	u32 pcmpos;
+	u32 samplerate;
+	BOOL eof;
+
+	u64 decodetime;
+	u64 outframes;
+
+	u8 input[INPUT_SIZE+MAD_BUFFER_GUARD];
+};
+
+static __inline__ s16 FixedToShort(mad_fixed_t Fixed)
+{
+	/* Clipping */
+	if(Fixed>=MAD_F_ONE)
+		return(SHRT_MAX);
+	if(Fixed<=-MAD_F_ONE)
+		return(-SHRT_MAX);
+
+#if defined(FPM_FLOAT)
+	return((s16)(Fixed*32768.0f));
+#else
+	Fixed=Fixed>>(MAD_F_FRACBITS-15);
+	return((s16)Fixed);
+#endif
+}
+
+static s32 _mp3memread(void *cb_data,void *dst,s32 len)
+{
+	MP3Source *src = cb_data;
+
+	if(src->mempos>=src->memlen) return -1;
+	if(len>(src->memlen - src->mempos)) len = (src->memlen - src->mempos);
+
+	memcpy(dst,src->mem + src->mempos,len);
+	src->mempos += len;
+	return len;
+}
+
+/* refills the input after the undecoded tail, returns FALSE if nothing could be added */
+static BOOL _mp3sourceread(MP3Source *src)
+{
+	u8 *ReadStart;
+	s32 ReadSize,Remaining;
+
+	if(src->eof==TRUE) return FALSE;
+
+	if(src->stream.next_frame!=NULL) {
+		Remaining = src->stream.bufend - src->stream.next_frame;
+		memmove(src->input,src->stream.next_frame,Remaining);
+	} else
+		Remaining = 0;
+
+	ReadStart = src->input + Remaining;
+	ReadSize = src->reader(src->cb_data,ReadStart,INPUT_SIZE - Remaining);
+	if(ReadSize==0) return FALSE;
+	if(ReadSize<0) {
+		/* let the last frame through */
+		memset(ReadStart,0,MAD_BUFFER_GUARD);
+		ReadSize = MAD_BUFFER_GUARD;
+		src->eof = TRUE;
+	}
+
+	/* libmad leaves the error of the last failed decode: it would make the next decode read again */
+	mad_stream_buffer(&src->stream,src->input,(ReadSize + Remaining));
+	src->stream.error = MAD_ERROR_NONE;
+	return TRUE;
+}
+
+/* decodes the next frame into the synth output, returns FALSE on underrun, at the end
+   or when the budget of decode attempts is spent */
+static BOOL _mp3sourcedecode(MP3Source *src,s32 *budget)
+{
+	while(1) {
+		if(src->stream.buffer==NULL || src->stream.error==MAD_ERROR_BUFLEN) {
+			if(_mp3sourceread(src)==FALSE) return FALSE;
+		}
+
+		if((*budget)--<=0) return FALSE;
+		if(mad_frame_decode(&src->frame,&src->stream)) {
+			if(MAD_RECOVERABLE(src->stream.error)) continue;
+			if(src->stream.error==MAD_ERROR_BUFLEN) continue;
+			return FALSE;
+		}
+
+		mad_synth_frame(&src->synth,&src->frame);
+		src->pcmpos = 0;
+		return TRUE;
+	}
+}
+
+static s32 _mp3sourcefill(AESNDPB *pb,void *buffer,u32 len,void *cb_arg)
+{
+	MP3Source *src = cb_arg;
+	struct mad_pcm *pcm = &src->synth.pcm;
+	s16 *out = buffer;
+	u32 i,n,frames,done = 0;
+	s32 budget = MAX_DECODES;
+	u64 start = gettime();
+
+	frames = (len>>2);
+	while(done<frames) {
+		if(src->pcmpos>=pcm->length) {
+			if(_mp3sourcedecode(src,&budget)==FALSE) break;
+			if(pcm->samplerate!=src->samplerate) {
+				src->samplerate = pcm->samplerate;
+				AESND_SetVoiceFrequency(pb,src->samplerate);
+			}
+			continue;
+		}
+
+		n = pcm->length - src->pcmpos;
+		if(n>(frames - done)) n = (frames - done);
+
+		/* straight into the DSP stream buffer */
+		if(pcm->channels==2) {
+			for(i=0;i<n;i++) {
+				*out++ = FixedToShort(pcm->samples[0][src->pcmpos + i]);
+				*out++ = FixedToShort(pcm->samples[1][src->pcmpos + i]);
+			}
+		} else {
+			for(i=0;i<n;i++) {
+				out[0] = out[1] = FixedToShort(pcm->samples[0][src->pcmpos + i]);
+				out += 2;
+			}
+		}
+
+		src->pcmpos += n;
+		done += n;
+	}
+
+	src->decodetime += (gettime() - start);
+	src->outframes += done;
+
+	if(done==0 && src->eof==TRUE) return -1;
+	return (done<<2);
+}
+
+MP3Source* MP3Source_Create(void *cb_data,s32 (*reader)(void *,void *,s32))
+{
+	MP3Source *src;
+
+	if(reader==NULL) return NULL;
+
+	src = malloc(sizeof(MP3Source));
+	if(src==NULL) return NULL;
+
+	memset(src,0,sizeof(MP3Source));
+	src->cb_data = cb_data;
+	src->reader = reader;
+
+	mad_stream_init(&src->stream);
+	mad_frame_init(&src->frame);
+	mad_synth_init(&src->synth);
+
+	return src;
+}
+
+MP3Source* MP3Source_CreateBuffer(const void *buffer,s32 len)
+{
+	MP3Source *src;
+
+	if(buffer==NULL || len<=0) return NULL;
+
+	src = MP3Source_Create(NULL,_mp3memread);
+	if(src==NULL) return NULL;
+
+	src->cb_data = src;
+	src->mem = buffer;
+	src->memlen = len;
+	return src;
+}
+
+void MP3Source_Destroy(MP3Source *src)
+{
+	if(src==NULL) return;
+
+	if(src->pb!=NULL) {
+		AESND_SetVoiceStop(src->pb,true);
+		AESND_SetVoiceSource(src->pb,NULL,NULL);
+	}
+
+	mad_synth_finish(&src->synth);
+	mad_frame_finish(&src->frame);
+	mad_stream_finish(&src->stream);
+	free(src);
+}
+
+s32 MP3Source_Play(MP3Source *src,AESNDPB *pb,u32 delay)
+{
+	if(src==NULL || pb==NULL) return -1;
+
+	/* the first frame gives the sample rate of the voice, this runs in thread context: no budget */
+	if(src->samplerate==0) {
+		s32 budget = INT_MAX;
+
+		if(_mp3sourcedecode(src,&budget)==FALSE) return -1;
+		src->samplerate = src->synth.pcm.samplerate;
+	}
+
+	src->pb = pb;
+	AESND_SetVoiceSource(pb,_mp3sourcefill,src);
+	AESND_PlayVoice(pb,VOICE_STEREO16,NULL,0,src->samplerate,delay,false);
+	return 0;
+}
+
+u32 MP3Source_GetUnderruns(MP3Source *src)
+{
+	if(src==NULL || src->pb==NULL) return 0;
+
+	return AESND_GetVoiceUnderruns(src->pb);
+}
+
+u32 MP3Source_GetDecodeTime(MP3Source *src)
+{
+	u32 level;
+	u64 time;
+
+	if(src==NULL) return 0;
+
+	_CPU_ISR_Disable(level);
+	time = src->decodetime;
+	_CPU_ISR_Restore(level);
+
+	return ticks_to_microsecs(time);
+}
+
+f32 MP3Source_GetCPUUsage(MP3Source *src)
+{
+	u32 level;
+	u64 time,frames;
+
+	if(src==NULL || src->samplerate==0) return 0.0f;
+
+	_CPU_ISR_Disable(level);
+	time = src->decodetime;
+	frames = src->outframes;
+	_CPU_ISR_Restore(level);
+
+	if(frames==0) return 0.0f;
+	return ((f32)ticks_to_microsecs(time)*src->samplerate)/((f32)frames*10000.0f);
+}
+
+u32 MP3Source_GetLatency(MP3Source *src)
+{
+	if(src==NULL || src->samplerate==0) return 0;
+
+	/* a frame decoded when the DSP enters one half of the stream buffer plays once that half is done: up to both halves */
+	return ((DSP_STREAMBUFFER_SIZE*2/4)*1000)/src->samplerate;
+}
@@ -55,6 +55,8 @@ s8 const mad_build[] = ""
   "FPM_PPC "
 # elif defined(FPM_DEFAULT)
   "FPM_DEFAULT "
+# elif defined(FPM_FLOAT)
+  "FPM_FLOAT "
 # endif
 
 # if defined(ASO_IMDCT)
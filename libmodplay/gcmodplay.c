@@ -286,6 +286,7 @@ s32 MODPlay_SetMOD(MODPlay *mod,const void *mem)
 
 	if(MOD_SetMOD(&mod->mod,(u8*)mem)==0) {
 		MODPlay_AllocSFXChannels(mod,mod->numSFXChans);
+		mod->mod.interpolation = mod->interpolation;
 		return 0;
 	}
 	return -1;
@@ -361,6 +362,24 @@ void MODPlay_SetVolume(MODPlay *mod, s32 musicvolume, s32 sfxvolume)
 	mod->mod.sfxvolume = sfxvolume;
 }
 
+/* void MODPlay_SetInterpolation(MODPlay *mod, u32 interpolation)
+
+Select how the mixer resamples instruments (can be changed while playing)
+
+mod: the MODPlay pointer
+
+interpolation: MOD_INTERP_NONE, MOD_INTERP_LINEAR or MOD_INTERP_CUBIC
+
+*/
+
+void MODPlay_SetInterpolation(MODPlay *mod, u32 interpolation)
+{
+	if(interpolation>MOD_INTERP_CUBIC) interpolation = MOD_INTERP_CUBIC;
+
+	mod->interpolation = interpolation;
+	mod->mod.interpolation = interpolation;
+}
+
 #ifdef _GCMOD_DEBUG
 u32 MODPlay_MixingTime()
 {
@@ -45,179 +45,188 @@ THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PREFILL_WORD 32768
 #endif
 
+/* Number of output frames accumulated per pass */
+#define MIX_BLOCK 256
 
-#define MIX_SAMPLES \
-                accum = (s32)b[i] + (s32)((((s32)data[playpos.aword.high]*volume)>>6) << shiftval); \
-                if (accum<-32768) accum = -32768; else if (accum>32767) accum = 32767; \
-                b[i] = accum; \
-                playpos.adword+=incval; \
-                if ( playpos.adword>=loop_end ) \
-                  { \
-                    if (mod->instrument[mod->instnum[voice]].looped) \
-                      playpos.adword -= mod->instrument[mod->instnum[voice]].loop_length<<16; \
-                    else \
-                      { \
-                        playpos.adword = (mod->instrument[mod->instnum[voice]].loop_end-1)<<16; \
-                        mod->channel_active[voice] = FALSE; \
-                        break; \
-                      } \
-                  }
+/* Voices are summed at 8.8 sample precision times volume (0..64) */
+#define MIX_FRACBITS 14
 
-s32 mix_mono_16bit ( MOD * mod, s16 * buf, s32 numSamples )
+static s32 mixbuf[MIX_BLOCK*2];
+
+/* Fetch a sample tap with loop wrap-around, used only near the loop boundary */
+static __inline__ s32 mix_fetch ( const MOD_INSTR * inst, s32 idx )
   {
-    s32 accum;
-    s32 voice, i, j;
-    s16 * b = buf;
-    s32 shiftval = mod->shiftval;
-    s32 numIterations;
-    s32 numIterationsRest;
-    
-    numIterations = numSamples>>4;
-    numIterationsRest = numSamples&((1<<4)-1);
-
-
-    for (i=j=0;j<numIterations;j++)
+    s32 end = inst->loop_end;
+
+    if (idx>=end)
       {
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
-        buf[i] = PREFILL_WORD;i++;
+        if (!inst->looped || inst->loop_length==0)
+          return 0;
+        idx -= inst->loop_length;
+        if (idx>=end)
+          idx = end-1;
       }
-    for (j=0;j<numIterationsRest;j++,i++)
-      buf[i] = PREFILL_WORD;
+    if (idx<0)
+      idx = 0;
+    return inst->data[idx];
+  }
 
+static __inline__ s32 mix_interpolate ( s32 p0, s32 p1, s32 p2, s32 p3, s32 interp, u32 frac )
+  {
+    s32 t, y;
 
-    for (voice=0;voice<mod->num_channels;++voice)
+    switch (interp)
       {
-        if (mod->instrument[mod->instnum[voice]].data != NULL && mod->channel_active[voice])
-          {
-            u32 incval,noteidx;
-
-			noteidx = (mod->chanfreq[voice] - mod->chanfreq[voice]*2*(mod->instrument[mod->instnum[voice]].finetune-8)/256);
-			incval = mod->inctab[noteidx];
-
-            s8 * data = mod->instrument[mod->instnum[voice]].data;
-            union_dword playpos;
-            u32 loop_end = mod->instrument[mod->instnum[voice]].loop_end<<16;
-            s32 volume = mod->volume[voice];
-            playpos.adword = mod->playpos[voice];
-
-            if ( voice<mod->num_voices )
-              volume = (volume*(s32)mod->musicvolume)>>6;
-            else
-              volume = (volume*(s32)mod->sfxvolume)>>6;
-
-            if (mod->freq==32000 || mod->freq==48000)
-              incval >>= 2;
+        case MOD_INTERP_LINEAR:
+          return (p1<<8) + (((p2-p1)*(s32)frac)>>8);
+        case MOD_INTERP_CUBIC:
+          /* Catmull-Rom spline, coefficients doubled */
+          t = frac>>1;
+          y = (((-p0+3*p1-3*p2+p3)*t)>>15) + (2*p0-5*p1+4*p2-p3);
+          y = ((y*t)>>15) + (p2-p0);
+          return (p1<<8) + ((y*t)>>8);
+        default:
+          return p1<<8;
+      }
+  }
 
-            for (j=i=0;j<numIterations;j++)
-              {
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-                MIX_SAMPLES;i++;
-              }
-            for (j=0;j<numIterationsRest;j++,i++)
+/* Mix one voice into the accumulator, returns FALSE once a one-shot sample has ended */
+static BOOL mix_voice ( MOD * mod, s32 voice, s32 * acc, s32 stride, s32 numSamples, s32 volume )
+  {
+    const MOD_INSTR * inst = &mod->instrument[mod->instnum[voice]];
+    const s8 * data = inst->data;
+    s32 interp = mod->interpolation;
+    u32 loop_end = inst->loop_end<<16;
+    u32 pos = mod->playpos[voice];
+    u32 incval, noteidx, limit;
+    s32 before, after;
+    s32 n, cnt, idx;
+
+    noteidx = (mod->chanfreq[voice] - mod->chanfreq[voice]*2*(inst->finetune-8)/256);
+    incval = mod->inctab[noteidx];
+    if (mod->freq==32000 || mod->freq==48000)
+      incval >>= 2;
+
+    /* Taps needed on either side of the playing position */
+    before = (interp==MOD_INTERP_CUBIC) ? 1 : 0;
+    after = (interp==MOD_INTERP_CUBIC) ? 2 : ((interp==MOD_INTERP_LINEAR) ? 1 : 0);
+
+    for (n=0;n<numSamples;n+=cnt)
+      {
+        if (pos>=loop_end)
+          {
+            if (!inst->looped || inst->loop_length==0)
               {
-                MIX_SAMPLES;
+                mod->playpos[voice] = (inst->loop_end-1)<<16;
+                return FALSE;
               }
-            mod->playpos[voice] = playpos.adword;
+            while (pos>=loop_end)
+              pos -= inst->loop_length<<16;
+          }
+
+        idx = pos>>16;
+        if (idx<before || (u32)(idx+after)>=inst->loop_end)
+          {
+            /* Boundary sample: gather the taps one by one */
+            acc[n*stride] += mix_interpolate(mix_fetch(inst,idx-1),mix_fetch(inst,idx),
+                                             mix_fetch(inst,idx+1),mix_fetch(inst,idx+2),
+                                             interp,pos&0xffff)*volume;
+            pos += incval;
+            cnt = 1;
+            continue;
           }
+
+        /* Every tap of the next cnt samples lies inside the sample data */
+        cnt = numSamples-n;
+        if (incval>0)
+          {
+            limit = (inst->loop_end-after)<<16;
+            if ((limit-pos+incval-1)/incval<(u32)cnt)
+              cnt = (limit-pos+incval-1)/incval;
+          }
+
+        {
+          s32 * a = &acc[n*stride];
+          s32 i;
+
+          switch (interp)
+            {
+              case MOD_INTERP_LINEAR:
+                for (i=0;i<cnt;i++,a+=stride,pos+=incval)
+                  {
+                    const s8 * d = &data[pos>>16];
+                    *a += ((d[0]<<8) + (((d[1]-d[0])*(s32)(pos&0xffff))>>8))*volume;
+                  }
+                break;
+              case MOD_INTERP_CUBIC:
+                for (i=0;i<cnt;i++,a+=stride,pos+=incval)
+                  {
+                    const s8 * d = &data[pos>>16];
+                    *a += mix_interpolate(d[-1],d[0],d[1],d[2],MOD_INTERP_CUBIC,pos&0xffff)*volume;
+                  }
+                break;
+              default:
+                for (i=0;i<cnt;i++,a+=stride,pos+=incval)
+                  *a += (data[pos>>16]<<8)*volume;
+                break;
+            }
+        }
       }
-    return numSamples;
+
+    mod->playpos[voice] = pos;
+    return TRUE;
   }
 
-s32 mix_stereo_16bit ( MOD * mod, s16 * buf, s32 numSamples )
+/* Accumulate all voices at 32 bits and clip once per output sample */
+static s32 mix_16bit ( MOD * mod, s16 * buf, s32 numSamples, s32 channels )
   {
-    s32 accum;
-    s32 voice, i, j;
-    s16 * b = buf;
-    s32 shiftval = mod->shiftval+1;
-    s32 numIterations, numIterationsRest;
+    s32 voice, i, n, cnt;
+    s32 shift = MIX_FRACBITS - (mod->shiftval + channels - 1);
 
-    numIterations = (numSamples)>>2;
-    numIterationsRest = (numSamples)&((1<<2)-1);
-
-    for (i=j=0;j<numIterations;j++)
+    for (n=0;n<numSamples;n+=cnt)
       {
-        buf[i] = buf[i+1] = PREFILL_WORD;i+=2;
-        buf[i] = buf[i+1] = PREFILL_WORD;i+=2;
-        buf[i] = buf[i+1] = PREFILL_WORD;i+=2;
-        buf[i] = buf[i+1] = PREFILL_WORD;i+=2;
-      }
-    for (j=0;j<numIterationsRest;j++,i+=2)
-        buf[i] = buf[i+1] = PREFILL_WORD;
+        cnt = numSamples-n;
+        if (cnt>MIX_BLOCK)
+          cnt = MIX_BLOCK;
 
-/*    for (j=0;j<numSamples*2;j+=2)
-      buf[j] = buf[j+1] = PREFILL_WORD;*/
+        for (i=0;i<cnt*channels;i++)
+          mixbuf[i] = 0;
 
-    for (voice=0;voice<mod->num_channels;++voice)
-      {
-        s32 lrofs = (((voice-1)>>1)&1)^1;
-        if (mod->instrument[mod->instnum[voice]].data != NULL && mod->channel_active[voice])
+        for (voice=0;voice<mod->num_channels;++voice)
           {
-            u32 incval,noteidx;
+            s32 lrofs = (channels==2) ? ((((voice-1)>>1)&1)^1) : 0;
+            s32 volume;
 
-			noteidx = (mod->chanfreq[voice] - mod->chanfreq[voice]*2*(mod->instrument[mod->instnum[voice]].finetune-8)/256);
-			incval = mod->inctab[noteidx];
+            if (mod->instrument[mod->instnum[voice]].data == NULL || !mod->channel_active[voice])
+              continue;
 
-            s8 * data = mod->instrument[mod->instnum[voice]].data;
-            union_dword playpos;
-            u32 loop_end = mod->instrument[mod->instnum[voice]].loop_end<<16;
-            s32 volume = mod->volume[voice];
-            
+            volume = mod->volume[voice];
             if ( voice<mod->num_voices )
               volume = (volume*(s32)mod->musicvolume)>>6;
             else
               volume = (volume*(s32)mod->sfxvolume)>>6;
 
-            playpos.adword = mod->playpos[voice];            
-            if (mod->freq==32000 || mod->freq==48000)
-              incval >>= 2;
-            
-            i = lrofs;
-            for (j=0;j<numIterations;j++)
-              {
-                MIX_SAMPLES;i+=2;
-                MIX_SAMPLES;i+=2;
-                MIX_SAMPLES;i+=2;
-                MIX_SAMPLES;i+=2;
-              }
-            for (j=0;j<numIterationsRest;j++)
-              {
-                MIX_SAMPLES;i+=2;
-              }
-/*            for (i=0;i<numSamples*2;i+=2)
-              {
-                MIX_SAMPLES;
-              }*/
-            mod->playpos[voice] = playpos.adword;
+            if (!mix_voice(mod,voice,&mixbuf[lrofs],channels,cnt,volume))
+              mod->channel_active[voice] = FALSE;
+          }
+
+        for (i=0;i<cnt*channels;i++)
+          {
+            s32 accum = (s32)(s16)PREFILL_WORD + (mixbuf[i]>>shift);
+            if (accum<-32768) accum = -32768; else if (accum>32767) accum = 32767;
+            buf[n*channels+i] = accum;
           }
       }
 
     return numSamples;
   }
+
+s32 mix_mono_16bit ( MOD * mod, s16 * buf, s32 numSamples )
+  {
+    return mix_16bit(mod,buf,numSamples,1);
+  }
+
+s32 mix_stereo_16bit ( MOD * mod, s16 * buf, s32 numSamples )
+  {
+    return mix_16bit(mod,buf,numSamples,2);
+  }
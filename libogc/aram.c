@@ -591,8 +591,8 @@ static bool __aram_readSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSector
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != 512) return false;
-	if(!SYS_IsDMAAddress(buffer, 32)) return false;
 	if(!ARQ_CheckInit()) return false;
+	if(!SYS_IsDMAAddress(buffer, 32)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 32, __aram_readSectors);
 
 	DCInvalidateRange(buffer, numSectors << 9);
 	ARQ_PostRequest(&req, disc->ioType, ARQ_ARAMTOMRAM, ARQ_PRIO_LO, __ARInternalSize + (sector << 9), (u32)buffer, numSectors << 9);
@@ -608,8 +608,8 @@ static bool __aram_writeSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSecto
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != 512) return false;
-	if(!SYS_IsDMAAddress(buffer, 32)) return false;
 	if(!ARQ_CheckInit()) return false;
+	if(!SYS_IsDMAAddress(buffer, 32)) return disc_bounceWriteSectors(disc, sector, numSectors, buffer, 32, __aram_writeSectors);
 
 	DCStoreRange((void*)buffer, numSectors << 9);
 	ARQ_PostRequest(&req, disc->ioType, ARQ_MRAMTOARAM, ARQ_PRIO_LO, __ARInternalSize + (sector << 9), (u32)buffer, numSectors << 9);
@@ -53,6 +53,13 @@ distribution.
 #define CARD_SYSBAT					0x6000
 #define CARD_SYSBAT_BACK			0x8000
 
+#define CARD_MAXCACHE				16
+
+#define CARD_TXN_ACTIVE				0x01
+#define CARD_TXN_DIR				0x02
+#define CARD_TXN_FAT				0x04
+#define CARD_TXN_FREE				0x08
+
 #define _SHIFTL(v, s, w)	\
     ((u32) (((u32)(v) & ((0x01 << (w)) - 1)) << (s)))
 #define _SHIFTR(v, s, w)	\
@@ -146,6 +153,15 @@ typedef struct _card_block {
 	cardcallback card_xfer_cb;
 	cardcallback card_erase_cb;
 	cardcallback card_unlock_cb;
+
+	u32 txn;
+	u32 txn_freed[0x1000/32];
+	u8 *cache_buf;
+	u32 cache_len;
+	u32 cache_stamp;
+	u32 cache_hit;
+	u16 cache_block[CARD_MAXCACHE];
+	u32 cache_used[CARD_MAXCACHE];
 } card_block;
 
 #if defined(HW_RVL)
@@ -243,6 +259,7 @@ static s32 __card_readsegment(s32 chn,cardcallback callback);
 static s32 __card_read(s32 chn,u32 address,u32 block_len,void *buffer,cardcallback callback);
 static s32 __card_updatefat(s32 chn,struct card_bat *fatblock,cardcallback callback);
 static s32 __card_updatedir(s32 chn,cardcallback callback);
+static s32 __card_deferupdate(s32 chn,u32 flag,cardcallback callback);
 static s32 __card_write(s32 chn,u32 address,u32 block_len,void *buffer,cardcallback callback);
 static s32 __card_writepage(s32 chn,cardcallback callback);
 static s32 __card_sectorerase(s32 chn,u32 sector,cardcallback callback);
@@ -335,6 +352,77 @@ static __inline__ struct card_bat* __card_getbatblock(card_block *card)
 	return card->curr_fat;
 }
 
+static __inline__ u32 __card_cachecount(card_block *card)
+{
+	u32 cnt;
+
+	if(!card->cache_buf || !card->sector_size) return 0;
+
+	cnt = card->cache_len/card->sector_size;
+	if(cnt>CARD_MAXCACHE) cnt = CARD_MAXCACHE;
+	return cnt;
+}
+
+static void __card_cacheinvalidate(card_block *card,u16 block)
+{
+	u32 i;
+
+	for(i=0;i<CARD_MAXCACHE;i++) {
+		if(block==0xffff || card->cache_block[i]==block) card->cache_block[i] = 0;
+	}
+}
+
+static s32 __card_cachefind(card_block *card,u16 block)
+{
+	u32 i,cnt;
+
+	cnt = __card_cachecount(card);
+	for(i=0;i<cnt;i++) {
+		if(card->cache_block[i]==block) {
+			card->cache_used[i] = ++card->cache_stamp;
+			return i;
+		}
+	}
+	return -1;
+}
+
+// keeps a copy of a block that has just been read in full
+static void __card_cachestore(card_block *card,u16 block,const void *buffer)
+{
+	u32 i,cnt,victim;
+
+	cnt = __card_cachecount(card);
+	if(!cnt || __card_cachefind(card,block)>=0) return;
+
+	victim = 0;
+	for(i=0;i<cnt;i++) {
+		if(!card->cache_block[i]) {
+			victim = i;
+			break;
+		}
+		if((s32)(card->cache_used[i]-card->cache_used[victim])<0) victim = i;
+	}
+
+	memcpy(card->cache_buf+(victim*card->sector_size),buffer,card->sector_size);
+	card->cache_block[victim] = block;
+	card->cache_used[victim] = ++card->cache_stamp;
+}
+
+// serves the current chunk of a file read from the cache, if the block is there
+static bool __card_cacheload(card_block *card,card_file *file,u32 len)
+{
+	s32 idx;
+	u32 offset;
+
+	if((idx=__card_cachefind(card,file->iblock))<0) return false;
+
+	offset = (file->offset&(card->sector_size-1));
+	memcpy(card->cmd_usr_buf,card->cache_buf+(idx*card->sector_size)+offset,len);
+	DCFlushRange(card->cmd_usr_buf,len);
+	card->cmd_usr_buf += len;
+	return true;
+}
+
 static s32 __card_sync(s32 chn)
 {
 	s32 ret;
@@ -819,6 +907,17 @@ static s32 __card_freeblock(s32 chn,u16 block,cardcallback callback)
 	if(!card->attached) return CARD_ERROR_NOCARD;
 	
 	fatblock = __card_getbatblock(card);
+	if(card->txn&CARD_TXN_ACTIVE) {
+		// the directory on the card points at these blocks until the commit,
+		// so they stay allocated until then and are only marked for release
+		while(block!=0xffff) {
+			if(block<CARD_SYSAREA || block>=card->blocks) return CARD_ERROR_BROKEN;
+			card->txn_freed[block>>5] |= (1<<(block&31));
+			block = fatblock->fat[block-CARD_SYSAREA];
+		}
+		return __card_deferupdate(chn,CARD_TXN_FREE,callback);
+	}
+
 	next = fatblock->fat[block-CARD_SYSAREA];
 	fatblock->fat[block-CARD_SYSAREA] = 0;
 	fatblock->freeblocks++;
@@ -1268,29 +1367,37 @@ static void __read_callback(s32 chn,s32 result)
 #ifdef _CARD_DEBUG
 	printf("__read_callback(file->len = %d,file->iblock = %d)\n",file->len,file->iblock);
 #endif
-	if(ret>=0) {
-		if(file->len>=0) {
-			file->len = file->len-(((file->offset+card->sector_size)&~(card->sector_size-1))-file->offset);
+	while(ret>=0) {
+		if(file->len<0) {
+			ret = CARD_ERROR_CANCELED;
+			break;
+		}
+
+		if(!card->cache_hit && !(file->offset&(card->sector_size-1)) && file->len>=card->sector_size)
+			__card_cachestore(card,file->iblock,card->cmd_usr_buf-card->sector_size);
+
+		file->len = file->len-(((file->offset+card->sector_size)&~(card->sector_size-1))-file->offset);
 #ifdef _CARD_DEBUG
-			printf("__read_callback(file->len = %d)\n",file->len);
+		printf("__read_callback(file->len = %d)\n",file->len);
 #endif
-			if(file->len>0) {
-				fatblock = __card_getbatblock(card);
-				file->offset += (((file->offset+card->sector_size)&~(card->sector_size-1))-file->offset);
-				file->iblock = fatblock->fat[file->iblock-CARD_SYSAREA];
-				if(file->iblock<CARD_SYSAREA || file->iblock>=card->blocks) {
-					ret = CARD_ERROR_BROKEN;
-					goto exit;
-				}
-				len = file->len<card->sector_size?file->len:card->sector_size;
-				if(__card_read(chn,(file->iblock*card->sector_size),len,card->cmd_usr_buf,__read_callback)>=0) return;
-				
-			}
-		} else
-			ret = CARD_ERROR_CANCELED;
+		if(file->len<=0) break;
+
+		fatblock = __card_getbatblock(card);
+		file->offset += (((file->offset+card->sector_size)&~(card->sector_size-1))-file->offset);
+		file->iblock = fatblock->fat[file->iblock-CARD_SYSAREA];
+		if(file->iblock<CARD_SYSAREA || file->iblock>=card->blocks) {
+			ret = CARD_ERROR_BROKEN;
+			break;
+		}
+
+		len = file->len<card->sector_size?file->len:card->sector_size;
+		card->cache_hit = __card_cacheload(card,file,len);
+		if(card->cache_hit) continue;
+
+		if(__card_read(chn,(file->iblock*card->sector_size),len,card->cmd_usr_buf,__read_callback)>=0) return;
+		break;
 	}
 
-exit:
 	cb = card->card_api_cb;
 	card->card_api_cb = NULL;
 	__card_putcntrlblock(card,ret);
@@ -1748,6 +1855,7 @@ static s32 __card_sectorerase(s32 chn,u32 sector,cardcallback callback)
 	card = &cardmap[chn];
 	
 	if(sector%card->sector_size) return CARD_ERROR_FATAL_ERROR;
+	__card_cacheinvalidate(card,sector/card->sector_size);
 	
 	card->cmd[0] = 0xf1;
 	card->cmd[1] = (sector>>17)&0x7f;
@@ -1858,6 +1966,18 @@ static void __card_createfatcallback(s32 chn,s32 result)
 	}	
 }
 
+// the control block is given back here only by the last step of an operation,
+// the one that has taken card_api_cb; the earlier ones leave it to that step
+static s32 __card_deferupdate(s32 chn,u32 flag,cardcallback callback)
+{
+	card_block *card = &cardmap[chn];
+
+	card->txn |= flag;
+	if(!card->card_api_cb) __card_putcntrlblock(card,CARD_ERROR_READY);
+	if(callback) callback(chn,CARD_ERROR_READY);
+	return CARD_ERROR_READY;
+}
+
 static s32 __card_updatefat(s32 chn,struct card_bat *fatblock,cardcallback callback)
 {
 	card_block *card = NULL;
@@ -1868,6 +1988,7 @@ static s32 __card_updatefat(s32 chn,struct card_bat *fatblock,cardcallback callb
 	card = &cardmap[chn];
 
 	if(!card->attached) return CARD_ERROR_NOCARD;
+	if(card->txn&CARD_TXN_ACTIVE) return __card_deferupdate(chn,CARD_TXN_FAT,callback);
 
 	++fatblock->updated;
 	__card_checksum((u16*)(((u32)fatblock)+4),0x1ffc,&fatblock->chksum1,&fatblock->chksum2);
@@ -1889,6 +2010,7 @@ static s32 __card_updatedir(s32 chn,cardcallback callback)
 	card = &cardmap[chn];
 
 	if(!card->attached) return CARD_ERROR_NOCARD;
+	if(card->txn&CARD_TXN_ACTIVE) return __card_deferupdate(chn,CARD_TXN_DIR,callback);
 	
 	dirblock = __card_getdirblock(card);
 	dircntrl = dirblock+8128;
@@ -1913,6 +2035,8 @@ static void __card_dounmount(s32 chn,s32 result)
 		card->attached = 0;
 		card->mount_step = 0;
 		card->result = result;
+		card->txn = 0;
+		__card_cacheinvalidate(card,0xffff);
 		EXI_RegisterEXICallback(chn,NULL);
 		EXI_Detach(chn);
 		SYS_CancelAlarm(card->timeout_svc);
@@ -2571,6 +2695,8 @@ s32 CARD_MountAsync(s32 chn,void *workarea,cardcallback detach_cb,cardcallback a
 		SYS_CancelAlarm(card->timeout_svc);
 		card->curr_dir = NULL;
 		card->curr_fat = NULL;
+		card->txn = 0;
+		__card_cacheinvalidate(card,0xffff);
 		_CPU_ISR_Restore(level);
 
 		card->card_unlock_cb = __card_mountcallback;
@@ -2627,6 +2753,13 @@ s32 CARD_ReadAsync(card_file *file,void *buffer,u32 len,u32 offset,cardcallback
 	card->card_api_cb = cb;
 
 	if(len>=(card->sector_size-(file->offset&(card->sector_size-1)))) len = (card->sector_size-(file->offset&(card->sector_size-1)));
+
+	card->cmd_usr_buf = buffer;
+	card->cache_hit = __card_cacheload(card,file,len);
+	if(card->cache_hit) {
+		__read_callback(file->chn,CARD_ERROR_READY);
+		return 0;
+	}
 	
 	if((ret=__card_read(file->chn,(file->iblock*card->sector_size),len,buffer,__read_callback))<0) {
 		__card_putcntrlblock(card,ret);
@@ -3015,6 +3148,135 @@ s32 CARD_GetErrorCode(s32 chn)
 	return card->result;
 }
 
+// gives the blocks freed during a transaction back to the FAT
+static void __card_releaseblocks(card_block *card)
+{
+	u32 i;
+	struct card_bat *fatblock = __card_getbatblock(card);
+
+	for(i=CARD_SYSAREA;i<card->blocks;i++) {
+		if(!(card->txn_freed[i>>5]&(1<<(i&31)))) continue;
+
+		fatblock->fat[i-CARD_SYSAREA] = 0;
+		fatblock->freeblocks++;
+	}
+	memset(card->txn_freed,0,sizeof(card->txn_freed));
+}
+
+static void __card_commitcallback(s32 chn,s32 result);
+
+/*
+ * Starts the next step of a commit. The FAT with the blocks allocated in the
+ * transaction goes first, then the directory, then the FAT once more with the
+ * blocks freed in it. Each update replaces one of two copies, so an
+ * interrupted commit leaves the card consistent: new files' blocks are leaked
+ * if it stops before the directory, deleted files' blocks if it stops after.
+ */
+static s32 __card_commitnext(s32 chn,card_block *card)
+{
+	if(card->txn&CARD_TXN_FAT) {
+		card->txn &= ~CARD_TXN_FAT;
+		return __card_updatefat(chn,__card_getbatblock(card),__card_commitcallback);
+	}
+	if(card->txn&CARD_TXN_DIR) {
+		card->txn &= ~CARD_TXN_DIR;
+		return __card_updatedir(chn,__card_commitcallback);
+	}
+	if(card->txn&CARD_TXN_FREE) {
+		card->txn &= ~CARD_TXN_FREE;
+		__card_releaseblocks(card);
+		return __card_updatefat(chn,__card_getbatblock(card),__card_commitcallback);
+	}
+	return CARD_ERROR_READY;
+}
+
+static void __card_commitcallback(s32 chn,s32 result)
+{
+	s32 ret;
+	cardcallback cb = NULL;
+	card_block *card = &cardmap[chn];
+
+	ret = result;
+	if(ret>=0 && card->txn && (ret=__card_commitnext(chn,card))>=0) return;
+
+	// steps that did not run are dropped; their blocks stay allocated
+	card->txn = 0;
+	cb = card->card_api_cb;
+	card->card_api_cb = NULL;
+	__card_putcntrlblock(card,ret);
+	if(cb) cb(chn,ret);
+}
+
+s32 CARD_BeginTransaction(s32 chn)
+{
+	s32 ret;
+	card_block *card = NULL;
+
+	if((ret=__card_getcntrlblock(chn,&card))<0) return ret;
+	if(card->txn&CARD_TXN_ACTIVE) {
+		__card_putcntrlblock(card,CARD_ERROR_READY);
+		return CARD_ERROR_BUSY;
+	}
+
+	card->txn = CARD_TXN_ACTIVE;
+	memset(card->txn_freed,0,sizeof(card->txn_freed));
+	return __card_putcntrlblock(card,CARD_ERROR_READY);
+}
+
+s32 CARD_CommitTransactionAsync(s32 chn,cardcallback callback)
+{
+	s32 ret;
+	cardcallback cb = NULL;
+	card_block *card = NULL;
+
+	if((ret=__card_getcntrlblock(chn,&card))<0) return ret;
+	if(!(card->txn&CARD_TXN_ACTIVE)) return __card_putcntrlblock(card,CARD_ERROR_FATAL_ERROR);
+
+	// what is left in txn are the commit steps
+	card->txn &= ~CARD_TXN_ACTIVE;
+
+	cb = callback;
+	if(!cb) cb = __card_defaultapicallback;
+
+	if(!card->txn) {
+		__card_putcntrlblock(card,CARD_ERROR_READY);
+		cb(chn,CARD_ERROR_READY);
+		return CARD_ERROR_READY;
+	}
+
+	card->card_api_cb = cb;
+	if((ret=__card_commitnext(chn,card))<0) {
+		card->txn = 0;
+		card->card_api_cb = NULL;
+		__card_putcntrlblock(card,ret);
+	}
+	return ret;
+}
+
+s32 CARD_CommitTransaction(s32 chn)
+{
+	s32 ret;
+
+	if((ret=CARD_CommitTransactionAsync(chn,__card_synccallback))>=0) {
+		ret = __card_sync(chn);
+	}
+	return ret;
+}
+
+s32 CARD_SetReadCache(s32 chn,void *buffer,u32 len)
+{
+	s32 ret;
+	card_block *card = NULL;
+
+	if(buffer && ((u32)buffer&31)) return CARD_ERROR_FATAL_ERROR;
+	if((ret=__card_getcntrlblock(chn,&card))<0) return ret;
+
+	__card_cacheinvalidate(card,0xffff);
+	card->cache_buf = buffer;
+	card->cache_len = buffer?len:0;
+	return __card_putcntrlblock(card,CARD_ERROR_READY);
+}
+
 static s32 __card_findnext(card_dir *dir) 
 { 
 	s32 ret; 
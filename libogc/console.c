@@ -81,16 +81,233 @@ static u32 do_xfb_copy = FALSE;
 static struct _console_data_s _console_data;
 static struct _console_data_s *curr_con = NULL;
 static void *_console_buffer = NULL;
+static console_cell_s *_console_cells = NULL;
+static unsigned int *_console_dirty = NULL;
 
 static FILE *stdcon = NULL;
 
 extern u8 console_font_8x16[];
 
+static struct _console_font_s {
+	const unsigned char *data;
+	int width,height;
+	int first,count;
+} _console_font = { console_font_8x16, FONT_XSIZE, FONT_YSIZE, 0, 256 };
+
+/* rendering a font row is one table lookup per 8 pixels, tables are built per color pair on first use */
+static struct _console_lut_s {
+	unsigned int foreground,background;
+	unsigned int words[256*4];
+} _console_luts[CON_LUT_SLOTS] ATTRIBUTE_ALIGN(32);
+static unsigned int _console_lut_next = 0;
+
+static const unsigned char _console_blank[CON_MAX_FONT_WIDTH/8] = { 0 };
+
+static void __console_buildlut(struct _console_lut_s *lut,unsigned int fgcolor,unsigned int bgcolor)
+{
+	int i;
+	unsigned int pair[4];
+	unsigned int *words = lut->words;
+
+	/* the first pixel of a word carries the chroma, as in the 4:2:2 framebuffer */
+	for(i=0;i<4;i++)
+		pair[i] = (((i&2) ? fgcolor : bgcolor) & 0xFFFF00FF) | (((i&1) ? fgcolor : bgcolor) & 0x0000FF00);
+
+	for(i=0;i<256;i++)
+	{
+		*words++ = pair[(i>>6)&3];
+		*words++ = pair[(i>>4)&3];
+		*words++ = pair[(i>>2)&3];
+		*words++ = pair[i&3];
+	}
+
+	lut->foreground = fgcolor;
+	lut->background = bgcolor;
+}
+
+/* only one context draws at a time: the writer with CON_Init, the retrace callback with CON_InitEx */
+static const unsigned int* __console_getlut(unsigned int fgcolor,unsigned int bgcolor)
+{
+	int i;
+	struct _console_lut_s *lut;
+
+	/* the zeroed slots already hold a valid table for black on black */
+	for(i=0;i<CON_LUT_SLOTS;i++)
+	{
+		lut = &_console_luts[i];
+		if(lut->foreground == fgcolor && lut->background == bgcolor)
+			return lut->words;
+	}
+
+	lut = &_console_luts[_console_lut_next];
+	_console_lut_next = (_console_lut_next + 1) % CON_LUT_SLOTS;
+
+	__console_buildlut(lut,fgcolor,bgcolor);
+	return lut->words;
+}
+
+static void __console_drawglyph(console_data_s *con,unsigned int *ptr,int c,unsigned int fgcolor,unsigned int bgcolor)
+{
+	int ay,ax;
+	int bytes,tail,pitch;
+	const unsigned char *pbits;
+	const unsigned int *lut,*l;
+	unsigned int nextline;
+
+	lut = __console_getlut(fgcolor,bgcolor);
+	nextline = con->con_stride/4 - con->font_width/2;
+
+	/* characters missing from the font are drawn blank */
+	c -= con->font_first;
+	if(c >= 0 && c < con->font_count)
+	{
+		pitch = con->font_pitch;
+		pbits = &con->font[c * con->font_height * pitch];
+	}
+	else
+	{
+		pitch = 0;
+		pbits = _console_blank;
+	}
+
+	if(con->font_width == 8)
+	{
+		for (ay = 0; ay < con->font_height; ay++)
+		{
+			l = &lut[*pbits << 2];
+			ptr[0] = l[0];
+			ptr[1] = l[1];
+			ptr[2] = l[2];
+			ptr[3] = l[3];
+
+			pbits += pitch;
+			ptr += 4 + nextline;
+		}
+		return;
+	}
+
+	bytes = con->font_width >> 3;
+	tail = (con->font_width & 7) >> 1;
+	for (ay = 0; ay < con->font_height; ay++)
+	{
+		for (ax = 0; ax < bytes; ax++)
+		{
+			l = &lut[pbits[ax] << 2];
+			*ptr++ = l[0];
+			*ptr++ = l[1];
+			*ptr++ = l[2];
+			*ptr++ = l[3];
+		}
+		if(tail)
+		{
+			l = &lut[pbits[ax] << 2];
+			for (ax = 0; ax < tail; ax++)
+				*ptr++ = l[ax];
+		}
+
+		pbits += pitch;
+		ptr += nextline;
+	}
+}
+
+/* maps a screen row to its row in the cell grid and the console buffer */
+static __inline__ int __console_gridrow(console_data_s *con,int row)
+{
+	row += con->row_base;
+	if(row >= con->con_rows) row -= con->con_rows;
+	return row;
+}
+
+static __inline__ void __console_setdirty(console_data_s *con,int row)
+{
+	con->dirty[row>>5] |= (1<<(row&31));
+}
+
+static void __console_renderrow(console_data_s *con,int row)
+{
+	int col;
+	unsigned int *ptr;
+	console_cell_s *cell;
+
+	ptr = (unsigned int*)(con->destbuffer + ( con->con_stride * row * con->font_height ));
+	cell = &con->cells[row * con->con_cols];
+
+	for(col=0;col<con->con_cols;col++,cell++,ptr+=(con->font_width/2))
+		__console_drawglyph(con,ptr,cell->chr,cell->foreground,cell->background);
+
+	con->dirty[row>>5] &= ~(1<<(row&31));
+}
+
+static void __console_copylines(u32 *fb,u32 *ptr,u32 lines,u32 xres,u32 fb_stride,u32 stride)
+{
+	u32 xcnt;
+
+	for(;lines>0;lines--)
+	{
+		for(xcnt=xres;xcnt>0;xcnt-=VI_DISPLAY_PIX_SZ)
+		{
+			*fb++ = *ptr++;
+		}
+		fb += fb_stride;
+		ptr += stride;
+	}
+}
+
+/* renders the dirty rows of the cell grid, then copies only what changed on the target */
+static void __console_flush(console_data_s *con)
+{
+	int row,grow;
+	u32 fb_stride,lines;
+	void *fb,*xfb;
+
+	xfb = VIDEO_GetCurrentFramebuffer();
+	if(xfb != con->last_fb)
+	{
+		/* a different framebuffer holds none of our rows */
+		con->last_fb = xfb;
+		con->redraw = TRUE;
+	}
+
+	fb = SYS_VirtualToUncached(xfb) + (con->target_y*con->tgt_stride) + con->target_x*VI_DISPLAY_PIX_SZ;
+	fb_stride = con->tgt_stride/4 - (con->con_xres/VI_DISPLAY_PIX_SZ);
+
+	for(row=0;row<con->con_rows;row++)
+	{
+		grow = __console_gridrow(con,row);
+		if(con->dirty[grow>>5] & (1<<(grow&31)))
+			__console_renderrow(con,grow);
+		else if(!con->redraw)
+			continue;
+
+		__console_copylines(fb + con->tgt_stride*row*con->font_height,
+							con->destbuffer + con->con_stride*grow*con->font_height,
+							con->font_height,con->con_xres,fb_stride,
+							con->con_stride/4 - (con->con_xres/VI_DISPLAY_PIX_SZ));
+	}
+
+	/* the lines below the last text row never change */
+	lines = con->con_yres - con->con_rows*con->font_height;
+	if(con->redraw && lines>0)
+	{
+		__console_copylines(fb + con->tgt_stride*con->con_rows*con->font_height,
+							con->destbuffer + con->con_stride*con->con_rows*con->font_height,
+							lines,con->con_xres,fb_stride,
+							con->con_stride/4 - (con->con_xres/VI_DISPLAY_PIX_SZ));
+	}
+	con->redraw = FALSE;
+}
+
 void __console_vipostcb(u32 retraceCount)
 {
 	u32 ycnt,xcnt, fb_stride;
 	u32 *fb,*ptr;
 
+	if(curr_con->cells)
+	{
+		__console_flush(curr_con);
+		return;
+	}
+
 	do_xfb_copy = TRUE;
 
 	ptr = curr_con->destbuffer;
@@ -114,91 +331,62 @@ void __console_vipostcb(u32 retraceCount)
 static void __console_drawc(int c)
 {
 	console_data_s *con;
-	int ay;
 	unsigned int *ptr;
-	unsigned char *pbits;
-	unsigned char bits;
-	unsigned int color;
-	unsigned int fgcolor, bgcolor;
-	unsigned int nextline;
 
 	if(do_xfb_copy==TRUE) return;
 	if(!curr_con) return;
 	con = curr_con;
 
-	ptr = (unsigned int*)(con->destbuffer + ( con->con_stride *  con->cursor_row * FONT_YSIZE ) + ((con->cursor_col * FONT_XSIZE / 2) * 4));
-	pbits = &con->font[c * FONT_YSIZE];
-	nextline = con->con_stride/4 - 4;
-	fgcolor = con->foreground;
-	bgcolor = con->background;
-
-	for (ay = 0; ay < FONT_YSIZE; ay++)
-	{
-		/* hard coded loop unrolling ! */
-		/* this depends on FONT_XSIZE = 8*/
-#if FONT_XSIZE == 8
-		bits = *pbits++;
-
-		/* bits 1 & 2 */
-		if ( bits & 0x80)
-			color = fgcolor & 0xFFFF00FF;
-		else
-			color = bgcolor & 0xFFFF00FF;
-		if (bits & 0x40)
-			color |= fgcolor  & 0x0000FF00;
-		else
-			color |= bgcolor  & 0x0000FF00;
-		*ptr++ = color;
+	ptr = (unsigned int*)(con->destbuffer + ( con->con_stride *  con->cursor_row * con->font_height ) + ((con->cursor_col * con->font_width / 2) * 4));
+	__console_drawglyph(con,ptr,c,con->foreground,con->background);
+}
 
-		/* bits 3 & 4 */
-		if ( bits & 0x20)
-			color = fgcolor & 0xFFFF00FF;
-		else
-			color = bgcolor & 0xFFFF00FF;
-		if (bits & 0x10)
-			color |= fgcolor  & 0x0000FF00;
-		else
-			color |= bgcolor  & 0x0000FF00;
-		*ptr++ = color;
+static void __console_putcell(int c)
+{
+	console_data_s *con;
+	console_cell_s *cell;
+	int row;
 
-		/* bits 5 & 6 */
-		if ( bits & 0x08)
-			color = fgcolor & 0xFFFF00FF;
-		else
-			color = bgcolor & 0xFFFF00FF;
-		if (bits & 0x04)
-			color |= fgcolor  & 0x0000FF00;
-		else
-			color |= bgcolor  & 0x0000FF00;
-		*ptr++ = color;
+	if(!curr_con) return;
+	con = curr_con;
+	if(con->cursor_col >= con->con_cols) return;
 
-		/* bits 7 & 8 */
-		if ( bits & 0x02)
-			color = fgcolor & 0xFFFF00FF;
-		else
-			color = bgcolor & 0xFFFF00FF;
-		if (bits & 0x01)
-			color |= fgcolor  & 0x0000FF00;
-		else
-			color |= bgcolor  & 0x0000FF00;
-		*ptr++ = color;
+	row = __console_gridrow(con,con->cursor_row);
+	cell = &con->cells[row * con->con_cols + con->cursor_col];
+	cell->chr = c;
+	cell->foreground = con->foreground;
+	cell->background = con->background;
 
-		/* next line */
-		ptr += nextline;
-#else
-#endif
-	}
+	/* set last, the retrace callback may render the row at any time */
+	__console_setdirty(con,row);
 }
 static void __console_clear_line( int line, int from, int to ) {
 	console_data_s *con;
 	unsigned int c;
 	unsigned int *p;
 	unsigned int x_pixels;
-	unsigned int px_per_col = FONT_XSIZE/2;
-	unsigned int line_height = FONT_YSIZE;
+	unsigned int px_per_col;
+	unsigned int line_height;
 	unsigned int line_width;
 	
 	if( !(con = curr_con) ) return;
+	if( con->cells ) {
+		console_cell_s *cell;
+
+		if( line >= con->con_rows ) return;
+		line = __console_gridrow(con,line);
+		cell = &con->cells[line*con->con_cols];
+		for( c = from; c < (unsigned int)to; c++ ) {
+			cell[c].chr = -1;
+			cell[c].foreground = con->foreground;
+			cell[c].background = con->background;
+		}
+		__console_setdirty(con,line);
+		return;
+	}
+	px_per_col = con->font_width/2;
+	line_height = con->font_height;
+
 	// For some reason there are xres/2 pixels per screen width
   x_pixels = con->con_xres / 2;
 	
@@ -206,7 +394,7 @@ static void __console_clear_line( int line, int from, int to ) {
 	p = (unsigned int*)con->destbuffer;
 	
 	// Move pointer to the current line and column offset
-	p += line*(FONT_YSIZE*x_pixels) + from*px_per_col;
+	p += line*(line_height*x_pixels) + from*px_per_col;
 	
 	// Clears 1 line of pixels at a time, line_height times
   while( line_height-- ) {
@@ -231,6 +419,14 @@ static void __console_clear(void)
 	while(c--)
 		*p++ = con->background;
 
+	if(con->cells)
+	{
+		con->row_base = 0;
+		for(c=0;c<(unsigned int)con->con_rows;c++)
+			__console_clear_line(c,0,con->con_cols);
+		con->redraw = TRUE;
+	}
+
 	con->cursor_row = 0;
 	con->cursor_col = 0;
 	con->saved_row = 0;
@@ -262,6 +458,35 @@ static void __console_clear_to_cursor() {
     __console_clear_line( cur_row, 0, con->con_cols );
 }
 
+static void __console_setfont(console_data_s *con)
+{
+	con->font = _console_font.data;
+	con->font_width = _console_font.width;
+	con->font_height = _console_font.height;
+	con->font_pitch = (_console_font.width + 7) / 8;
+	con->font_first = _console_font.first;
+	con->font_count = _console_font.count;
+
+	con->con_cols = con->con_xres / con->font_width;
+	con->con_rows = con->con_yres / con->font_height;
+}
+
+static s32 __console_allocgrid(int cols,int rows,console_cell_s **cells,unsigned int **dirty)
+{
+	if(cols <= 0 || rows <= 0) return -1;
+
+	*cells = malloc(cols*rows*sizeof(console_cell_s));
+	*dirty = calloc((rows + 31) / 32,sizeof(unsigned int));
+	if(!*cells || !*dirty) {
+		free(*cells);
+		free(*dirty);
+		*cells = NULL;
+		*dirty = NULL;
+		return -1;
+	}
+	return 0;
+}
+
 void __console_init(void *framebuffer,int xstart,int ystart,int xres,int yres,int stride)
 {
 	unsigned int level;
@@ -272,17 +497,19 @@ void __console_init(void *framebuffer,int xstart,int ystart,int xres,int yres,in
 	con->destbuffer = framebuffer;
 	con->con_xres = xres;
 	con->con_yres = yres;
-	con->con_cols = xres / FONT_XSIZE;
-	con->con_rows = yres / FONT_YSIZE;
 	con->con_stride = con->tgt_stride = stride;
 	con->target_x = xstart;
 	con->target_y = ystart;
 
-	con->font = console_font_8x16;
+	__console_setfont(con);
 
 	con->foreground = COLOR_WHITE;
 	con->background = COLOR_BLACK;
 
+	/* drawing goes straight to the framebuffer */
+	con->cells = NULL;
+	con->dirty = NULL;
+
 	curr_con = con;
 
 	__console_clear();
@@ -310,18 +537,22 @@ void __console_init_ex(void *conbuffer,int tgt_xstart,int tgt_ystart,int tgt_str
 	con->con_yres = con_yres;
 	con->tgt_stride = tgt_stride;
 	con->con_stride = con_stride;
-	con->con_cols = con_xres / FONT_XSIZE;
-	con->con_rows = con_yres / FONT_YSIZE;
 	con->cursor_row = 0;
 	con->cursor_col = 0;
 	con->saved_row = 0;
 	con->saved_col = 0;
 
-	con->font = console_font_8x16;
+	__console_setfont(con);
 
 	con->foreground = COLOR_WHITE;
 	con->background = COLOR_BLACK;
 
+	con->cells = _console_cells;
+	con->dirty = _console_dirty;
+	con->last_fb = NULL;
+	con->row_base = 0;
+	con->redraw = TRUE;
+
 	curr_con = con;
 
 	__console_clear();
@@ -564,7 +795,10 @@ ssize_t __console_write(struct _reent *r,void *fd,const char *ptr,size_t len)
 					else con->cursor_col += TAB_SIZE;
 					break;
 				default:
-					__console_drawc(chr);
+					if(con->cells)
+						__console_putcell((unsigned char)chr);
+					else
+						__console_drawc((unsigned char)chr);
 					con->cursor_col++;
 
 					if( con->cursor_col >= con->con_cols)
@@ -582,14 +816,29 @@ ssize_t __console_write(struct _reent *r,void *fd,const char *ptr,size_t len)
 			unsigned int cnt;
 			unsigned int *src, *dst;
 
-			cnt = (con->con_stride * con->con_yres - FONT_YSIZE)/4;
-			src = (unsigned int*)(con->destbuffer + con->con_stride * (FONT_YSIZE * FONT_YFACTOR + FONT_YGAP));
+			if(con->cells)
+			{
+				/* advance the ring instead of moving rows, every row lands elsewhere on the target */
+				unsigned int level;
+
+				_CPU_ISR_Disable(level);
+				if(++con->row_base >= con->con_rows) con->row_base = 0;
+				__console_clear_line(con->con_rows - 1,0,con->con_cols);
+				con->redraw = TRUE;
+				_CPU_ISR_Restore(level);
+
+				con->cursor_row--;
+				continue;
+			}
+
+			cnt = (con->con_stride * (con->con_yres - con->font_height))/4;
+			src = (unsigned int*)(con->destbuffer + con->con_stride * con->font_height);
 			dst = con->destbuffer;
 			while(cnt--)
 				*dst++ = *src++;
 
-			cnt = (con->con_stride * (FONT_YSIZE * FONT_YFACTOR + FONT_YGAP))/4;
-			dst = (unsigned int*)(con->destbuffer + con->con_stride * (con->con_yres - FONT_YSIZE));
+			cnt = (con->con_stride * con->font_height)/4;
+			dst = (unsigned int*)(con->destbuffer + con->con_stride * (con->con_yres - con->font_height));
 			while(cnt--)
 				*dst++ = con->background;
 			con->cursor_row--;
@@ -633,15 +882,77 @@ s32 CON_InitEx(GXRModeObj *rmode, s32 conXOrigin,s32 conYOrigin,s32 conWidth,s32
 	VIDEO_SetPostRetraceCallback(NULL);
 	if(_console_buffer)
 		free(_console_buffer);
+	if(_console_cells)
+		free(_console_cells);
+	if(_console_dirty)
+		free(_console_dirty);
+	_console_cells = NULL;
+	_console_dirty = NULL;
 	
 	_console_buffer = malloc(conWidth*conHeight*VI_DISPLAY_PIX_SZ);
 	if(!_console_buffer) return -1;
 
+	/* without a grid the whole buffer is copied on every retrace */
+	__console_allocgrid(conWidth / _console_font.width,conHeight / _console_font.height,&_console_cells,&_console_dirty);
+
 	__console_init_ex(_console_buffer,conXOrigin,conYOrigin,rmode->fbWidth*VI_DISPLAY_PIX_SZ,conWidth,conHeight,conWidth*VI_DISPLAY_PIX_SZ);
 
 	return 0;
 }
 
+s32 CON_SetFont(const void *font,int width,int height,int first,int count)
+{
+	unsigned int level;
+	console_data_s *con;
+	console_cell_s *cells = NULL;
+	unsigned int *dirty = NULL;
+
+	if(!font) {
+		font = console_font_8x16;
+		width = FONT_XSIZE;
+		height = FONT_YSIZE;
+		first = 0;
+		count = 256;
+	}
+	if(width < 2 || width > CON_MAX_FONT_WIDTH || (width&1)) return -1;
+	if(height < 1 || first < 0 || count < 1) return -1;
+
+	/* the cell grid is sized for the font, allocate the new one up front */
+	con = curr_con;
+	if(con && con->cells) {
+		if(__console_allocgrid(con->con_xres / width,con->con_yres / height,&cells,&dirty) < 0) return -1;
+	}
+
+	_CPU_ISR_Disable(level);
+
+	_console_font.data = font;
+	_console_font.width = width;
+	_console_font.height = height;
+	_console_font.first = first;
+	_console_font.count = count;
+
+	if(con) {
+		if(con->cells) {
+			/* swap, the old grid is freed below */
+			console_cell_s *old_cells = _console_cells;
+			unsigned int *old_dirty = _console_dirty;
+
+			con->cells = _console_cells = cells;
+			con->dirty = _console_dirty = dirty;
+			cells = old_cells;
+			dirty = old_dirty;
+		}
+		__console_setfont(con);
+		__console_clear();
+	}
+
+	_CPU_ISR_Restore(level);
+
+	free(cells);
+	free(dirty);
+	return 0;
+}
+
 void CON_GetMetrics(int *cols, int *rows)
 {
 	if(curr_con) {
@@ -10,9 +10,19 @@
 #define FONT_YGAP			0
 #define TAB_SIZE			4
 
+#define CON_MAX_FONT_WIDTH	32
+#define CON_LUT_SLOTS		4
+
+typedef struct _console_cell_s {
+	unsigned int foreground,background;
+	int chr;					// -1 for a cleared cell, drawn in the background color whatever the font
+} console_cell_s;
+
 typedef struct _console_data_s {
 	void *destbuffer;
-	unsigned char *font;
+	const unsigned char *font;
+	int font_width,font_height,font_pitch;
+	int font_first,font_count;
 	int con_xres,con_yres,con_stride;
 	int target_x,target_y, tgt_stride;
 	int cursor_row,cursor_col;
@@ -20,6 +30,12 @@ typedef struct _console_data_s {
 	int con_rows, con_cols;
 
 	unsigned int foreground,background;
+
+	console_cell_s *cells;
+	unsigned int *dirty;
+	void *last_fb;
+	int row_base;
+	int redraw;
 } console_data_s;
 
 extern ssize_t __console_write(struct _reent *r,void *fd,const char *ptr,size_t len);
@@ -0,0 +1,688 @@
+/*-------------------------------------------------------------
+
+disc_io.c -- Bounce buffering and write-back caching for DISC_INTERFACE drivers
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include "asm.h"
+#include "processor.h"
+#include "system.h"
+#include "lwp.h"
+#include "mutex.h"
+#include "cond.h"
+#include "timesupp.h"
+#include "disc_io.h"
+
+#define DISC_BOUNCE_SLOTS		2
+#define DISC_BOUNCE_SIZE		0x10000
+
+#define DISC_CACHE_STAGING		16
+#define DISC_CACHE_STACKSIZE	8192
+#define DISC_CACHE_PRIORITY		64
+#define DISC_CACHE_NIL			-1
+
+typedef struct _disc_cacheentry {
+	sec_t sector;
+	s32 hnext;				// next entry in the same hash bucket
+	s32 prev,next;			// neighbours on the free, clean or dirty list
+	u8 valid;
+	u8 dirty;
+} disc_cacheentry;
+
+typedef struct _disc_cachelist {
+	s32 head;
+	s32 tail;
+} disc_cachelist;
+
+typedef struct _disc_cache {
+	DISC_INTERFACE iface;
+	DISC_INTERFACE *disc;
+	disc_cacheentry *entries;
+	s32 *buckets;
+	u32 hashbits;
+	disc_cachelist free;
+	disc_cachelist clean;		// least recently written first
+	disc_cachelist dirty;		// in the order of their first write since the last flush
+	u8 *data;
+	u8 *staging;
+	u32 size;
+	u32 count;
+	u32 bps;
+	u32 ndirty;
+	u64 dirtytime;
+	u32 flushms;
+	bool stop;
+	mutex_t lock;
+	cond_t cond;
+	lwp_t flusher;
+} disc_cache;
+
+static u32 __disc_bounce_inuse = 0;
+static void *__disc_bounce_buf[DISC_BOUNCE_SLOTS] = {NULL,NULL};
+
+static void* __disc_bounce_get(u32 *slot)
+{
+	u32 i,level;
+	void *buf;
+
+	_CPU_ISR_Disable(level);
+	for(i=0;i<DISC_BOUNCE_SLOTS;i++) {
+		if(!(__disc_bounce_inuse&(1<<i))) {
+			__disc_bounce_inuse |= (1<<i);
+			break;
+		}
+	}
+	_CPU_ISR_Restore(level);
+
+	*slot = i;
+	if(i==DISC_BOUNCE_SLOTS) return memalign(32,DISC_BOUNCE_SIZE);
+
+	if(!__disc_bounce_buf[i]) __disc_bounce_buf[i] = memalign(32,DISC_BOUNCE_SIZE);
+	buf = __disc_bounce_buf[i];
+	if(!buf) {
+		_CPU_ISR_Disable(level);
+		__disc_bounce_inuse &= ~(1<<i);
+		_CPU_ISR_Restore(level);
+	}
+	return buf;
+}
+
+static void __disc_bounce_put(u32 slot,void *buf)
+{
+	u32 level;
+
+	if(slot==DISC_BOUNCE_SLOTS) {
+		free(buf);
+		return;
+	}
+
+	_CPU_ISR_Disable(level);
+	__disc_bounce_inuse &= ~(1<<slot);
+	_CPU_ISR_Restore(level);
+}
+
+static __inline__ bool __disc_isdma(const u8 *ptr,u32 len,u32 align)
+{
+	return (SYS_IsDMAAddress(ptr,align) && SYS_IsDMAAddress(ptr+len-1,1));
+}
+
+// length of the run of sectors starting at ptr that all are (or all aren't) usable for DMA
+static sec_t __disc_run(const u8 *ptr,sec_t numSectors,u32 bps,u32 align,bool dma)
+{
+	sec_t n;
+
+	for(n=0;n<numSectors;n++,ptr+=bps) {
+		if(__disc_isdma(ptr,bps,align)!=dma) break;
+	}
+	return n;
+}
+
+bool disc_bounceReadSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,void *buffer,u32 align,FN_MEDIUM_READSECTORS readSectors)
+{
+	bool ret;
+	u32 bps,slot,shift;
+	sec_t n;
+	void *buf;
+	u8 *ptr = (u8*)buffer;
+
+	bps = disc->bytesPerSector;
+	if(!bps || bps>DISC_BOUNCE_SIZE) return false;
+
+	while(numSectors>0) {
+		n = __disc_run(ptr,numSectors,bps,align,true);
+		if(n>0) {
+			if(!readSectors(disc,sector,n,ptr)) return false;
+		} else if((n=__disc_run(ptr,numSectors,bps,align,false))>1
+				  && (shift=(-(u32)ptr&(align-1)))!=0 && __disc_isdma(ptr+shift,(n-1)*bps,align)) {
+			// a buffer that is only misaligned gets all but its last sector by DMA
+			// to the next aligned address inside it, and they are moved into place;
+			// the last sector, which does not fit there, is bounced on the next pass
+			n--;
+			if(!readSectors(disc,sector,n,ptr+shift)) return false;
+			memmove(ptr,ptr+shift,n*bps);
+		} else {
+			if(n>(DISC_BOUNCE_SIZE/bps)) n = (DISC_BOUNCE_SIZE/bps);
+
+			buf = __disc_bounce_get(&slot);
+			if(!buf) return false;
+			if(!__disc_isdma(buf,n*bps,align)) {
+				__disc_bounce_put(slot,buf);
+				return false;
+			}
+
+			ret = readSectors(disc,sector,n,buf);
+			if(ret) memcpy(ptr,buf,n*bps);
+			__disc_bounce_put(slot,buf);
+			if(!ret) return false;
+		}
+
+		ptr += (n*bps);
+		sector += n;
+		numSectors -= n;
+	}
+	return true;
+}
+
+bool disc_bounceWriteSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,const void *buffer,u32 align,FN_MEDIUM_WRITESECTORS writeSectors)
+{
+	bool ret;
+	u32 bps,slot;
+	sec_t n;
+	void *buf;
+	const u8 *ptr = (const u8*)buffer;
+
+	bps = disc->bytesPerSector;
+	if(!bps || bps>DISC_BOUNCE_SIZE) return false;
+
+	while(numSectors>0) {
+		n = __disc_run(ptr,numSectors,bps,align,true);
+		if(n>0) {
+			if(!writeSectors(disc,sector,n,ptr)) return false;
+		} else {
+			n = __disc_run(ptr,numSectors,bps,align,false);
+			if(n>(DISC_BOUNCE_SIZE/bps)) n = (DISC_BOUNCE_SIZE/bps);
+
+			buf = __disc_bounce_get(&slot);
+			if(!buf) return false;
+			if(!__disc_isdma(buf,n*bps,align)) {
+				__disc_bounce_put(slot,buf);
+				return false;
+			}
+
+			memcpy(buf,ptr,n*bps);
+			ret = writeSectors(disc,sector,n,buf);
+			__disc_bounce_put(slot,buf);
+			if(!ret) return false;
+		}
+
+		ptr += (n*bps);
+		sector += n;
+		numSectors -= n;
+	}
+	return true;
+}
+
+static void __disc_cache_sync(disc_cache *c)
+{
+	c->iface.numberOfSectors = c->disc->numberOfSectors;
+	c->iface.sectorsPerBlock = c->disc->sectorsPerBlock;
+	c->iface.bytesPerSector = c->disc->bytesPerSector;
+}
+
+static void __disc_cache_free(disc_cache *c)
+{
+	if(c->data) free(c->data);
+	if(c->staging) free(c->staging);
+	if(c->entries) free(c->entries);
+	if(c->buckets) free(c->buckets);
+	c->data = NULL;
+	c->staging = NULL;
+	c->entries = NULL;
+	c->buckets = NULL;
+	c->count = 0;
+	c->bps = 0;
+	c->ndirty = 0;
+}
+
+static __inline__ u32 __disc_cache_hash(disc_cache *c,sec_t sector)
+{
+	return ((u32)(sector^(sector>>32))*0x9e3779b1)>>(32 - c->hashbits);
+}
+
+static void __disc_cache_unlink(disc_cache *c,disc_cachelist *l,s32 idx)
+{
+	disc_cacheentry *e = &c->entries[idx];
+
+	if(e->prev!=DISC_CACHE_NIL) c->entries[e->prev].next = e->next;
+	else l->head = e->next;
+	if(e->next!=DISC_CACHE_NIL) c->entries[e->next].prev = e->prev;
+	else l->tail = e->prev;
+}
+
+static void __disc_cache_append(disc_cache *c,disc_cachelist *l,s32 idx)
+{
+	disc_cacheentry *e = &c->entries[idx];
+
+	e->prev = l->tail;
+	e->next = DISC_CACHE_NIL;
+	if(l->tail!=DISC_CACHE_NIL) c->entries[l->tail].next = idx;
+	else l->head = idx;
+	l->tail = idx;
+}
+
+static disc_cachelist* __disc_cache_listof(disc_cache *c,s32 idx)
+{
+	if(!c->entries[idx].valid) return &c->free;
+	if(c->entries[idx].dirty) return &c->dirty;
+	return &c->clean;
+}
+
+// only valid entries are hashed
+static void __disc_cache_hashinsert(disc_cache *c,s32 idx)
+{
+	u32 h = __disc_cache_hash(c,c->entries[idx].sector);
+
+	c->entries[idx].hnext = c->buckets[h];
+	c->buckets[h] = idx;
+}
+
+static void __disc_cache_hashremove(disc_cache *c,s32 idx)
+{
+	s32 *link = &c->buckets[__disc_cache_hash(c,c->entries[idx].sector)];
+
+	while(*link!=idx) link = &c->entries[*link].hnext;
+	*link = c->entries[idx].hnext;
+}
+
+static void __disc_cache_invalidate(disc_cache *c)
+{
+	u32 i;
+
+	c->free.head = c->free.tail = DISC_CACHE_NIL;
+	c->clean = c->dirty = c->free;
+	for(i=0;i<c->count;i++) {
+		c->entries[i].valid = 0;
+		c->entries[i].dirty = 0;
+		__disc_cache_append(c,&c->free,i);
+	}
+	for(i=0;i<(1<<c->hashbits);i++) c->buckets[i] = DISC_CACHE_NIL;
+	c->ndirty = 0;
+}
+
+// the sector size is only known once the medium is up, so the cache is sized on first use
+static bool __disc_cache_setup(disc_cache *c)
+{
+	u32 bps,count,bits;
+
+	bps = c->disc->bytesPerSector;
+	if(c->entries && c->bps==bps) return true;
+
+	__disc_cache_free(c);
+	if(!bps) return false;
+
+	count = c->size/bps;
+	if(count<2) return false;
+	for(bits=1;(1<<bits)<count;bits++);
+
+	c->data = memalign(32,count*bps);
+	c->staging = memalign(32,DISC_CACHE_STAGING*bps);
+	c->entries = calloc(count,sizeof(disc_cacheentry));
+	c->buckets = malloc((1<<bits)*sizeof(s32));
+	if(!c->data || !c->staging || !c->entries || !c->buckets) {
+		__disc_cache_free(c);
+		return false;
+	}
+
+	c->count = count;
+	c->bps = bps;
+	c->hashbits = bits;
+	__disc_cache_invalidate(c);
+	return true;
+}
+
+static s32 __disc_cache_find(disc_cache *c,sec_t sector)
+{
+	s32 idx = c->buckets[__disc_cache_hash(c,sector)];
+
+	while(idx!=DISC_CACHE_NIL && c->entries[idx].sector!=sector) idx = c->entries[idx].hnext;
+	return idx;
+}
+
+// writes the dirty sectors back in the order they were first written since
+// the last flush; sectors written in ascending order go out as single writes
+// of up to DISC_CACHE_STAGING sectors
+static bool __disc_cache_flush(disc_cache *c)
+{
+	u32 n;
+	s32 idx;
+	sec_t sector;
+
+	while(c->dirty.head!=DISC_CACHE_NIL) {
+		idx = c->dirty.head;
+		sector = c->entries[idx].sector;
+		for(n=0;idx!=DISC_CACHE_NIL && n<DISC_CACHE_STAGING;n++,idx=c->entries[idx].next) {
+			if(c->entries[idx].sector!=(sector+n)) break;
+			memcpy(c->staging+(n*c->bps),c->data+(idx*c->bps),c->bps);
+		}
+
+		if(!c->disc->writeSectors(c->disc,sector,n,c->staging)) return false;
+
+		for(;n>0;n--) {
+			idx = c->dirty.head;
+			__disc_cache_unlink(c,&c->dirty,idx);
+			c->entries[idx].dirty = 0;
+			__disc_cache_append(c,&c->clean,idx);
+			c->ndirty--;
+		}
+	}
+	return true;
+}
+
+// takes a free entry, else the least recently written clean one; dirty
+// entries are only reclaimed after writing all of them back. The entry
+// returned is on no list and not hashed.
+static s32 __disc_cache_alloc(disc_cache *c)
+{
+	s32 idx;
+
+	if(c->free.head==DISC_CACHE_NIL && c->clean.head==DISC_CACHE_NIL) {
+		if(!__disc_cache_flush(c)) return -1;
+	}
+
+	idx = c->free.head;
+	if(idx!=DISC_CACHE_NIL) {
+		__disc_cache_unlink(c,&c->free,idx);
+		return idx;
+	}
+
+	idx = c->clean.head;
+	__disc_cache_unlink(c,&c->clean,idx);
+	__disc_cache_hashremove(c,idx);
+	c->entries[idx].valid = 0;
+	return idx;
+}
+
+// drops the clean entries, the dirty ones stay for a later flush
+static void __disc_cache_dropclean(disc_cache *c)
+{
+	s32 idx;
+
+	while(c->clean.head!=DISC_CACHE_NIL) {
+		idx = c->clean.head;
+		__disc_cache_unlink(c,&c->clean,idx);
+		__disc_cache_hashremove(c,idx);
+		c->entries[idx].valid = 0;
+		__disc_cache_append(c,&c->free,idx);
+	}
+}
+
+static bool __disc_cache_startup(DISC_INTERFACE *disc)
+{
+	bool ret,flushed = true;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	// sectors not yet written back go out before the cache is emptied, and
+	// are kept if neither the old nor the restarted medium takes them
+	if(c->entries) flushed = __disc_cache_flush(c);
+	ret = c->disc->startup(c->disc);
+	__disc_cache_sync(c);
+	if(c->entries) {
+		if(!flushed && ret) flushed = __disc_cache_flush(c);
+		if(flushed) __disc_cache_invalidate(c);
+		else __disc_cache_dropclean(c);
+	}
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_isinserted(DISC_INTERFACE *disc)
+{
+	bool ret;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	ret = c->disc->isInserted(c->disc);
+	__disc_cache_sync(c);
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_readsectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,void *buffer)
+{
+	s32 idx;
+	sec_t n;
+	bool ret = true;
+	u8 *ptr = (u8*)buffer;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	if(!__disc_cache_setup(c)) {
+		ret = c->disc->readSectors(c->disc,sector,numSectors,buffer);
+		LWP_MutexUnlock(c->lock);
+		return ret;
+	}
+
+	while(numSectors>0) {
+		idx = __disc_cache_find(c,sector);
+		if(idx>=0) {
+			memcpy(ptr,c->data+(idx*c->bps),c->bps);
+			n = 1;
+		} else {
+			for(n=1;n<numSectors && __disc_cache_find(c,sector+n)<0;n++);
+			ret = c->disc->readSectors(c->disc,sector,n,ptr);
+			if(!ret) break;
+		}
+
+		ptr += (n*c->bps);
+		sector += n;
+		numSectors -= n;
+	}
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_writesectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,const void *buffer)
+{
+	s32 idx;
+	sec_t i;
+	bool ret = true;
+	const u8 *ptr = (const u8*)buffer;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	if(!__disc_cache_setup(c)) {
+		ret = c->disc->writeSectors(c->disc,sector,numSectors,buffer);
+		LWP_MutexUnlock(c->lock);
+		return ret;
+	}
+
+	// large writes go straight through; pending writes are flushed first so
+	// they never land after newer data, and cached copies are refreshed
+	if(numSectors>(c->count/2)) {
+		ret = __disc_cache_flush(c);
+		if(ret) ret = c->disc->writeSectors(c->disc,sector,numSectors,buffer);
+		if(ret) {
+			for(i=0;i<numSectors;i++) {
+				idx = __disc_cache_find(c,sector+i);
+				if(idx>=0) memcpy(c->data+(idx*c->bps),ptr+(i*c->bps),c->bps);
+			}
+		}
+		LWP_MutexUnlock(c->lock);
+		return ret;
+	}
+
+	for(i=0;i<numSectors;i++,ptr+=c->bps) {
+		idx = __disc_cache_find(c,sector+i);
+		if(idx<0) {
+			idx = __disc_cache_alloc(c);
+			if(idx<0) {
+				ret = false;
+				break;
+			}
+			c->entries[idx].sector = sector+i;
+			c->entries[idx].valid = 1;
+			c->entries[idx].dirty = 0;
+			__disc_cache_hashinsert(c,idx);
+		} else if(!c->entries[idx].dirty)
+			__disc_cache_unlink(c,&c->clean,idx);
+
+		// a sector rewritten before it was flushed keeps its place on the dirty list
+		memcpy(c->data+(idx*c->bps),ptr,c->bps);
+		if(!c->entries[idx].dirty) {
+			if(!c->ndirty) c->dirtytime = gettime();
+			c->entries[idx].dirty = 1;
+			c->ndirty++;
+			__disc_cache_append(c,&c->dirty,idx);
+		}
+	}
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_erasesectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors)
+{
+	s32 idx;
+	sec_t i;
+	bool ret = true;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	if(c->entries) {
+		ret = __disc_cache_flush(c);
+		for(i=0;i<numSectors;i++) {
+			idx = __disc_cache_find(c,sector+i);
+			if(idx<0) continue;
+
+			__disc_cache_unlink(c,__disc_cache_listof(c,idx),idx);
+			__disc_cache_hashremove(c,idx);
+			if(c->entries[idx].dirty) c->ndirty--;
+			c->entries[idx].valid = 0;
+			c->entries[idx].dirty = 0;
+			__disc_cache_append(c,&c->free,idx);
+		}
+	}
+	if(ret) ret = c->disc->eraseSectors(c->disc,sector,numSectors);
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_clearstatus(DISC_INTERFACE *disc)
+{
+	bool ret = true;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	if(c->entries) ret = __disc_cache_flush(c);
+	if(ret && c->disc->flush) ret = c->disc->flush(c->disc);
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static bool __disc_cache_shutdown(DISC_INTERFACE *disc)
+{
+	bool ret = true;
+	disc_cache *c = (disc_cache*)disc;
+
+	LWP_MutexLock(c->lock);
+	if(c->entries) {
+		ret = __disc_cache_flush(c);
+		__disc_cache_invalidate(c);
+	}
+	if(!c->disc->shutdown(c->disc)) ret = false;
+	LWP_MutexUnlock(c->lock);
+	return ret;
+}
+
+static void* __disc_cache_flusher(void *arg)
+{
+	struct timespec tb;
+	disc_cache *c = (disc_cache*)arg;
+
+	tb.tv_sec = c->flushms/TB_MSPERSEC;
+	tb.tv_nsec = (c->flushms%TB_MSPERSEC)*TB_NSPERMS;
+
+	LWP_MutexLock(c->lock);
+	while(!c->stop) {
+		LWP_CondTimedWait(c->cond,c->lock,&tb);
+		if(c->stop) break;
+
+		if(c->ndirty && ticks_to_millisecs(diff_ticks(c->dirtytime,gettime()))>=c->flushms)
+			__disc_cache_flush(c);
+	}
+	LWP_MutexUnlock(c->lock);
+	return NULL;
+}
+
+DISC_INTERFACE* disc_cacheCreate(DISC_INTERFACE *disc,u32 cacheSize,u32 flushMs)
+{
+	disc_cache *c;
+
+	if(!disc || !disc->writeSectors) return NULL;
+
+	c = calloc(1,sizeof(disc_cache));
+	if(!c) return NULL;
+
+	c->disc = disc;
+	c->size = cacheSize;
+	c->flushms = flushMs;
+	c->flusher = LWP_THREAD_NULL;
+
+	c->iface.ioType = disc->ioType;
+	c->iface.features = disc->features;
+	c->iface.startup = __disc_cache_startup;
+	c->iface.isInserted = __disc_cache_isinserted;
+	c->iface.readSectors = __disc_cache_readsectors;
+	c->iface.writeSectors = __disc_cache_writesectors;
+	c->iface.eraseSectors = disc->eraseSectors?__disc_cache_erasesectors:NULL;
+	c->iface.flush = __disc_cache_clearstatus;
+	c->iface.shutdown = __disc_cache_shutdown;
+	__disc_cache_sync(c);
+
+	if(LWP_MutexInit(&c->lock,false)<0) {
+		free(c);
+		return NULL;
+	}
+
+	if(flushMs) {
+		if(LWP_CondInit(&c->cond)<0) {
+			LWP_MutexDestroy(c->lock);
+			free(c);
+			return NULL;
+		}
+		if(LWP_CreateThread(&c->flusher,__disc_cache_flusher,c,NULL,DISC_CACHE_STACKSIZE,DISC_CACHE_PRIORITY)<0) {
+			LWP_CondDestroy(c->cond);
+			LWP_MutexDestroy(c->lock);
+			free(c);
+			return NULL;
+		}
+	}
+	return &c->iface;
+}
+
+bool disc_cacheDestroy(DISC_INTERFACE *cache)
+{
+	bool ret = true;
+	disc_cache *c = (disc_cache*)cache;
+
+	if(!c) return false;
+
+	if(c->flusher!=LWP_THREAD_NULL) {
+		LWP_MutexLock(c->lock);
+		c->stop = true;
+		LWP_CondSignal(c->cond);
+		LWP_MutexUnlock(c->lock);
+		LWP_JoinThread(c->flusher,NULL);
+		LWP_CondDestroy(c->cond);
+	}
+
+	if(c->entries) ret = __disc_cache_flush(c);
+	__disc_cache_free(c);
+	LWP_MutexDestroy(c->lock);
+	free(c);
+	return ret;
+}
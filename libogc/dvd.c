@@ -71,6 +71,18 @@ distribution.
 #define DVD_DRVINFSIZE					0x20
 #define DVD_GCODE_BLKSIZE				0x200
 
+#define DVD_QUEUE_MAXBYPASS				16
+#define DVD_QUEUE_MAXMERGE				8
+#define DVD_QUEUE_MAXGAP				0x8000
+
+#define DVD_PREFETCH_SLOTS				4
+#define DVD_PREFETCH_PRIO				3
+
+#define DVD_PREFETCH_FREE				0
+#define DVD_PREFETCH_BUSY				1
+#define DVD_PREFETCH_READY				2
+#define DVD_PREFETCH_STALE				3
+
 #define DVD_INQUIRY						0x12000000
 #define DVD_FWSETOFFSET					0x32000000
 #define DVD_FWENABLEEXT					0x55000000
@@ -213,7 +225,36 @@ static void *__dvd_usrdata = NULL;
 static dvddiskid *__dvd_diskID = (dvddiskid*)0x80000000;
 
 static lwp_queue __dvd_waitingqueue[4];
+static u32 __dvd_queuebypass[4];
+static u32 __dvd_queuepolicy = DVD_QUEUE_FIFO;
+static s32 __dvd_queueprio = 0;
+static s64 __dvd_headpos = 0;
+static dvdcmdblk __dvd_mergedcmdblk;
+static dvdcmdblk *__dvd_mergedblocks[DVD_QUEUE_MAXMERGE];
+static u32 __dvd_mergedcnt = 0;
+static s32 __dvd_mergedprio = 0;
+static dvdcmdblk *__dvd_mergecanceled = NULL;
+static u8 *__dvd_mergebuf = NULL;
+static u32 __dvd_mergebuflen = 0;
+static u32 __dvd_mergebounce = 0;
+static dvdcbcallback __dvd_mergecancelusrcb = NULL;
 static dvdcmdl __dvd_cmdlist[4];
+
+typedef struct _dvdpfslot {
+	dvdcmdblk block;
+	u8 *buf;
+	s64 offset;
+	u32 len;
+	u32 used;
+	u32 pins;
+	u32 state;
+} dvdpfslot;
+
+static dvdpfslot __dvd_pfslots[DVD_PREFETCH_SLOTS];
+static u32 __dvd_pfchunk = 0;
+static s64 __dvd_pfnext = -1;
+static s64 __dvd_pfahead = -1;
+static dvdprefetchstats __dvd_pfstats;
 static dvdcmds __dvd_cmd_curr,__dvd_cmd_prev;
 
 static u32 __dvdpatchcode_size = 0;
@@ -381,6 +422,9 @@ void __dvd_statecoverclosed_cmd(dvdcmdblk *block);
 void __dvd_statebusy(dvdcmdblk *block);
 s32 __issuecommand(s32 prio,dvdcmdblk *block);
 
+static void __dvd_prefetchcb(s32 result,dvdcmdblk *block);
+static void __dvd_prefetchdemand(s64 offset,u32 len);
+
 extern syssramex* __SYS_LockSramEx(void);
 extern u32 __SYS_UnlockSramEx(u32 write);
 
@@ -455,6 +499,35 @@ static s32 __dvd_pushwaitingqueue(s32 prio,dvdcmdblk *block)
 	return 1;
 }
 
+static __inline__ u32 __dvd_isreadcmd(dvdcmdblk *block)
+{
+	return (block->cmd==0x0001 || block->cmd==0x0004);
+}
+
+static dvdcmdblk* __dvd_elevatorwaitingqueue(s32 prio)
+{
+	lwp_node *node;
+	lwp_queue *queue;
+	dvdcmdblk *block,*head,*next,*lowest;
+
+	queue = &__dvd_waitingqueue[prio];
+	head = (dvdcmdblk*)queue->first;
+	if(!__dvd_isreadcmd(head) || __dvd_queuebypass[prio]>=DVD_QUEUE_MAXBYPASS) return head;
+
+	// C-LOOK: nearest read at or beyond the head position, else wrap around
+	// to the lowest one. Any other command acts as a barrier for reordering.
+	next = lowest = NULL;
+	for(node=queue->first;!__lwp_queue_istail(queue,node);node=node->next) {
+		block = (dvdcmdblk*)node;
+		if(!__dvd_isreadcmd(block)) break;
+
+		if(block->offset>=__dvd_headpos) {
+			if(!next || block->offset<next->offset) next = block;
+		} else if(!lowest || block->offset<lowest->offset) lowest = block;
+	}
+	return next?next:lowest;
+}
+
 static dvdcmdblk* __dvd_popwaitingqueueprio(s32 prio)
 {
 	u32 level;
@@ -463,7 +536,17 @@ static dvdcmdblk* __dvd_popwaitingqueueprio(s32 prio)
 	printf("__dvd_popwaitingqueueprio(%d)\n",prio);
 #endif
 	_CPU_ISR_Disable(level);
-	ret = (dvdcmdblk*)__lwp_queue_firstnodeI(&__dvd_waitingqueue[prio]);
+	if(__dvd_queuepolicy&DVD_QUEUE_ELEVATOR) {
+		ret = __dvd_elevatorwaitingqueue(prio);
+		if(ret==(dvdcmdblk*)__dvd_waitingqueue[prio].first) __dvd_queuebypass[prio] = 0;
+		else __dvd_queuebypass[prio]++;
+		__lwp_queue_extractI(&ret->node);
+	} else
+		ret = (dvdcmdblk*)__lwp_queue_firstnodeI(&__dvd_waitingqueue[prio]);
+
+	if(__dvd_isreadcmd(ret)) __dvd_headpos = ret->offset+ret->len;
+	else if(ret->cmd==0x0002) __dvd_headpos = ret->offset;
+	__dvd_queueprio = prio;
 	_CPU_ISR_Restore(level);
 #ifdef _DVD_DEBUG
 	printf("__dvd_popwaitingqueueprio(%p,%p)\n",ret,ret->cb);
@@ -490,6 +573,148 @@ static dvdcmdblk* __dvd_popwaitingqueue()
 	return NULL;
 }
 
+static u32 __dvd_ismerged(dvdcmdblk *block)
+{
+	u32 i;
+
+	for(i=0;i<__dvd_mergedcnt;i++) {
+		if(__dvd_mergedblocks[i]==block) return 1;
+	}
+	return 0;
+}
+
+static void __dvd_mergedcb(s32 result,dvdcmdblk *block)
+{
+	u32 i,cnt,bounce;
+	dvdcmdblk *member;
+
+	cnt = __dvd_mergedcnt;
+	__dvd_mergedcnt = 0;
+	bounce = __dvd_mergebounce;
+	__dvd_mergebounce = 0;
+	if(bounce) LWP_ThreadBroadcast(__dvd_wait_queue);
+
+	if(result==DVD_ERROR_CANCELED && __dvd_mergecanceled) {
+		// only the request that was asked to be canceled fails, the others
+		// go back to the front of their queue in their original order.
+		for(i=cnt;i>0;i--) {
+			member = __dvd_mergedblocks[i-1];
+			if(member==__dvd_mergecanceled) continue;
+
+			member->state = DVD_STATE_WAITING;
+			member->txdsize = 0;
+			__lwp_queue_prependI(&__dvd_waitingqueue[__dvd_mergedprio],&member->node);
+		}
+		member = __dvd_mergecanceled;
+		member->state = DVD_STATE_CANCELED;
+		if(member->cb) member->cb(DVD_ERROR_CANCELED,member);
+		return;
+	}
+
+	for(i=0;i<cnt;i++) {
+		member = __dvd_mergedblocks[i];
+		if(result<0) {
+			member->state = block->state;
+			if(member->cb) member->cb(result,member);
+		} else {
+			// each request gets its own part of the bounce buffer, gaps are dropped
+			if(bounce) {
+				memcpy(member->buf,__dvd_mergebuf+(member->offset-block->offset),member->len);
+				DCFlushRange(member->buf,member->len);
+			}
+			member->txdsize = member->len;
+			member->state = DVD_STATE_END;
+			if(member->cb) member->cb(member->txdsize,member);
+		}
+	}
+}
+
+static void __dvd_mergecancelcb(s32 result,dvdcmdblk *block)
+{
+	dvdcbcallback cb;
+
+	block = __dvd_mergecanceled;
+	cb = __dvd_mergecancelusrcb;
+	__dvd_mergecanceled = NULL;
+	__dvd_mergecancelusrcb = NULL;
+	if(cb) cb(result,block);
+}
+
+/*
+ * Folds the reads that continue the one about to be issued into a single
+ * transfer. Reads that also continue it in memory are transferred in place;
+ * any others, and reads a small gap further on disc, go through the merge
+ * buffer and are copied out to each request when the transfer completes.
+ */
+static dvdcmdblk* __dvd_mergewaitingqueue(dvdcmdblk *block)
+{
+	u32 len,gap,level,direct;
+	s64 end;
+	lwp_node *node;
+	lwp_queue *queue;
+	dvdcmdblk *next,*best;
+
+	if(!block || block->cmd!=0x0001 || !(__dvd_queuepolicy&DVD_QUEUE_MERGE)) return block;
+
+	_CPU_ISR_Disable(level);
+	queue = &__dvd_waitingqueue[__dvd_queueprio];
+	len = block->len;
+	direct = 1;
+	__dvd_mergedcnt = 0;
+	__dvd_mergedblocks[__dvd_mergedcnt++] = block;
+	while(__dvd_mergedcnt<DVD_QUEUE_MAXMERGE) {
+		end = block->offset+len;
+		best = NULL;
+		for(node=queue->first;!__lwp_queue_istail(queue,node);node=node->next) {
+			next = (dvdcmdblk*)node;
+			if(!__dvd_isreadcmd(next)) break;
+			if(next->cmd!=0x0001 || next->offset<end) continue;
+
+			gap = next->offset-end;
+			if(direct && !gap && next->buf==(block->buf+len)) {
+				best = next;
+				break;
+			}
+			if(gap<=DVD_QUEUE_MAXGAP && (len+gap+next->len)<=__dvd_mergebuflen
+				&& (!best || next->offset<best->offset)) best = next;
+		}
+		if(!best) break;
+
+		if(&best->node==queue->first) __dvd_queuebypass[__dvd_queueprio] = 0;
+		__lwp_queue_extractI(&best->node);
+		best->state = DVD_STATE_BUSY;
+		best->txdsize = 0;
+		__dvd_mergedblocks[__dvd_mergedcnt++] = best;
+		if(best->offset!=end || best->buf!=(block->buf+len)) direct = 0;
+		len = (best->offset+best->len)-block->offset;
+	}
+
+	if(__dvd_mergedcnt==1) {
+		__dvd_mergedcnt = 0;
+		_CPU_ISR_Restore(level);
+		return block;
+	}
+
+	block->state = DVD_STATE_BUSY;
+	block->txdsize = 0;
+	__dvd_mergedprio = __dvd_queueprio;
+	__dvd_headpos = block->offset+len;
+
+	__dvd_mergebounce = !direct;
+	if(__dvd_mergebounce && __dvd_autoinvalidation) DCInvalidateRange(__dvd_mergebuf,len);
+
+	__dvd_mergedcmdblk.cmd = 0x0001;
+	__dvd_mergedcmdblk.buf = direct?block->buf:__dvd_mergebuf;
+	__dvd_mergedcmdblk.len = len;
+	__dvd_mergedcmdblk.offset = block->offset;
+	__dvd_mergedcmdblk.currtxsize = 0;
+	__dvd_mergedcmdblk.txdsize = 0;
+	__dvd_mergedcmdblk.cb = __dvd_mergedcb;
+	__dvd_mergedcmdblk.usrdata = NULL;
+	_CPU_ISR_Restore(level);
+	return &__dvd_mergedcmdblk;
+}
+
 static void __dvd_timeouthandler(syswd_t alarm,void *cbarg)
 {
 	dvdcallbacklow cb;
@@ -1661,7 +1886,7 @@ void __dvd_stateready()
 		return;
 	}
 
-	__dvd_executing = __dvd_popwaitingqueue();
+	__dvd_executing = __dvd_mergewaitingqueue(__dvd_popwaitingqueue());
 
 	if(__dvd_fatalerror) {
 		__dvd_executing->state = DVD_STATE_FATAL_ERROR;
@@ -2524,6 +2749,8 @@ s32 DVD_ReadAbsAsyncPrio(dvdcmdblk *block,void *buf,u32 len,s64 offset,dvdcbcall
 #ifdef _DVD_DEBUG
 	printf("DVD_ReadAbsAsyncPrio(%p,%p,%d,%d,%p,%d)\n",block,buf,len,offset,cb,prio);
 #endif
+	if(__dvd_pfchunk && cb!=__dvd_prefetchcb) __dvd_prefetchdemand(offset,len);
+
 	block->cmd = 0x0001;
 	block->buf = (void*)buf;
 	block->len = len;
@@ -2539,6 +2766,8 @@ s32 DVD_ReadAbsAsyncForBS(dvdcmdblk *block,void *buf,u32 len,s64 offset,dvdcbcal
 #ifdef _DVD_DEBUG
 	printf("DVD_ReadAbsAsyncForBS(%p,%p,%d,%d,%p)\n",block,buf,len,offset,cb);
 #endif
+	if(__dvd_pfchunk) __dvd_prefetchdemand(offset,len);
+
 	block->cmd = 0x0004;
 	block->buf = (void*)buf;
 	block->len = len;
@@ -2598,29 +2827,255 @@ s32 DVD_Inquiry(dvdcmdblk *block,dvddrvinfo *info)
 	return ret;
 }
 
-s32 DVD_ReadAbsPrio(dvdcmdblk *block,void *buf,u32 len,s64 offset,s32 prio)
+static s32 __dvd_readabs(dvdcmdblk *block,void *buf,u32 len,s64 offset,s32 prio)
 {
 	s32 ret,state;
 	u32 level;
-#ifdef _DVD_DEBUG
-	printf("DVD_ReadAbsPrio(%p,%p,%d,%d,%d)\n",block,buf,len,offset,prio);
-#endif
-	if(offset>=0 && offset<8511160320LL) {
-		ret = DVD_ReadAbsAsyncPrio(block,buf,len,offset,__dvd_synccallback,prio);
-		if(!ret) return DVD_ERROR_FATAL;
 
-		_CPU_ISR_Disable(level);
-		do {
-			state = block->state;
-			if(state==DVD_STATE_END) ret = block->txdsize;
-			else if(state==DVD_STATE_FATAL_ERROR) ret = DVD_ERROR_FATAL;
-			else if(state==DVD_STATE_CANCELED) ret = DVD_ERROR_CANCELED;
-			else LWP_ThreadSleep(__dvd_wait_queue);
-		} while(state!=DVD_STATE_END && state!=DVD_STATE_FATAL_ERROR && state!=DVD_STATE_CANCELED);
+	ret = DVD_ReadAbsAsyncPrio(block,buf,len,offset,__dvd_synccallback,prio);
+	if(!ret) return DVD_ERROR_FATAL;
+
+	_CPU_ISR_Disable(level);
+	do {
+		state = block->state;
+		if(state==DVD_STATE_END) ret = block->txdsize;
+		else if(state==DVD_STATE_FATAL_ERROR) ret = DVD_ERROR_FATAL;
+		else if(state==DVD_STATE_CANCELED) ret = DVD_ERROR_CANCELED;
+		else LWP_ThreadSleep(__dvd_wait_queue);
+	} while(state!=DVD_STATE_END && state!=DVD_STATE_FATAL_ERROR && state!=DVD_STATE_CANCELED);
+	_CPU_ISR_Restore(level);
+
+	return ret;
+}
+
+/*
+ * Read-ahead for synchronous reads. Once a read starts where the previous one
+ * ended, the free slots of the ring are filled with the data that follows at
+ * the lowest queue priority, so they only use the drive while nothing else is
+ * pending. A read the ring does not cover drops it, and so does any other
+ * demand read, asynchronous ones included, that takes the drive outside the
+ * window being read ahead: queued prefetches are cancelled and the one in
+ * flight is left to finish and then discarded.
+ */
+static void __dvd_prefetchcb(s32 result,dvdcmdblk *block)
+{
+	dvdpfslot *slot = (dvdpfslot*)block;
+
+	if(slot->state==DVD_PREFETCH_BUSY && block->state==DVD_STATE_END) {
+		slot->len = block->txdsize;
+		slot->state = DVD_PREFETCH_READY;
+		__dvd_pfstats.bytes_prefetched += block->txdsize;
+	} else {
+		if(block->state==DVD_STATE_END) {
+			__dvd_pfstats.bytes_prefetched += block->txdsize;
+			__dvd_pfstats.bytes_wasted += block->txdsize;
+		}
+		slot->state = DVD_PREFETCH_FREE;
+	}
+	LWP_ThreadBroadcast(__dvd_wait_queue);
+}
+
+static void __dvd_prefetchrelease(dvdpfslot *slot)
+{
+	if(slot->state==DVD_PREFETCH_READY) __dvd_pfstats.bytes_wasted += (slot->len-slot->used);
+	slot->state = slot->pins?DVD_PREFETCH_STALE:DVD_PREFETCH_FREE;
+}
+
+static void __dvd_prefetchdiscard()
+{
+	u32 i;
+	dvdpfslot *slot;
+
+	for(i=0;i<DVD_PREFETCH_SLOTS;i++) {
+		slot = &__dvd_pfslots[i];
+		if(slot->state==DVD_PREFETCH_READY) __dvd_prefetchrelease(slot);
+		else if(slot->state==DVD_PREFETCH_BUSY) {
+			slot->state = DVD_PREFETCH_STALE;
+			if(slot->block.state==DVD_STATE_WAITING) DVD_CancelAsync(&slot->block,NULL);
+		}
+	}
+	__dvd_pfahead = -1;
+}
+
+static void __dvd_prefetchdemand(s64 offset,u32 len)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(offset<__dvd_pfnext || (offset+len)>__dvd_pfahead) __dvd_prefetchdiscard();
+	_CPU_ISR_Restore(level);
+}
+
+static dvdpfslot* __dvd_prefetchfind(s64 offset)
+{
+	u32 i;
+	dvdpfslot *slot;
+
+	for(i=0;i<DVD_PREFETCH_SLOTS;i++) {
+		slot = &__dvd_pfslots[i];
+		if(slot->state!=DVD_PREFETCH_BUSY && slot->state!=DVD_PREFETCH_READY) continue;
+		if(offset>=slot->offset && offset<(slot->offset+slot->len)) return slot;
+	}
+	return NULL;
+}
+
+// waits for the prefetches covering the range to land, false if any part is missing
+static bool __dvd_prefetchcovers(s64 offset,u32 len)
+{
+	dvdpfslot *slot;
+	s64 curr,end = offset+len;
+
+	curr = offset;
+	while(curr<end) {
+		if(!(slot=__dvd_prefetchfind(curr))) return false;
+		if(slot->state==DVD_PREFETCH_BUSY) {
+			LWP_ThreadSleep(__dvd_wait_queue);
+			curr = offset;
+			continue;
+		}
+		curr = slot->offset+slot->len;
+	}
+	return true;
+}
+
+static void __dvd_prefetchissue()
+{
+	u32 i;
+	dvdpfslot *slot;
+
+	if(__dvd_pfahead<__dvd_pfnext) __dvd_pfahead = (__dvd_pfnext&~31);
+
+	for(i=0;i<DVD_PREFETCH_SLOTS;i++) {
+		slot = &__dvd_pfslots[i];
+		if(slot->state!=DVD_PREFETCH_FREE) continue;
+		if((__dvd_pfahead+__dvd_pfchunk)>8511160320LL) break;
+
+		slot->offset = __dvd_pfahead;
+		slot->len = __dvd_pfchunk;
+		slot->used = 0;
+		slot->state = DVD_PREFETCH_BUSY;
+		DCInvalidateRange(slot->buf,__dvd_pfchunk);
+		if(!DVD_ReadAbsAsyncPrio(&slot->block,slot->buf,__dvd_pfchunk,__dvd_pfahead,__dvd_prefetchcb,DVD_PREFETCH_PRIO)) {
+			slot->state = DVD_PREFETCH_FREE;
+			break;
+		}
+		__dvd_pfahead += __dvd_pfchunk;
+	}
+}
+
+static s32 __dvd_prefetchread(dvdcmdblk *block,void *buf,u32 len,s64 offset,s32 prio)
+{
+	s32 ret,res;
+	u32 n,level;
+	bool seq;
+	dvdpfslot *slot;
+	u8 *ptr = (u8*)buf;
+
+	_CPU_ISR_Disable(level);
+	seq = (offset==__dvd_pfnext);
+	if(!__dvd_prefetchcovers(offset,len)) {
+		__dvd_pfstats.misses++;
+		__dvd_prefetchdiscard();
 		_CPU_ISR_Restore(level);
 
+		ret = __dvd_readabs(block,buf,len,offset,prio);
+		if(ret<0) return ret;
+
+		_CPU_ISR_Disable(level);
+		__dvd_pfnext = offset+len;
+		if(seq) __dvd_prefetchissue();
+		_CPU_ISR_Restore(level);
 		return ret;
 	}
+
+	__dvd_pfstats.hits++;
+	ret = len;
+	while(len>0) {
+		slot = __dvd_prefetchfind(offset);
+		if(!slot || slot->state!=DVD_PREFETCH_READY) {
+			// another read dropped the ring while we were copying, the drive has the rest
+			_CPU_ISR_Restore(level);
+			res = __dvd_readabs(block,ptr,len,offset,prio);
+			_CPU_ISR_Disable(level);
+			if(res<0) ret = res;
+			else offset += len;
+			break;
+		}
+
+		n = (slot->offset+slot->len)-offset;
+		if(n>len) n = len;
+
+		slot->pins++;
+		_CPU_ISR_Restore(level);
+		memcpy(ptr,slot->buf+(offset-slot->offset),n);
+		DCFlushRange(ptr,n);
+		_CPU_ISR_Disable(level);
+		slot->pins--;
+
+		__dvd_pfstats.bytes_hit += n;
+		ptr += n;
+		offset += n;
+		len -= n;
+
+		if(slot->state==DVD_PREFETCH_STALE) {
+			if(!slot->pins) {
+				slot->state = DVD_PREFETCH_FREE;
+				LWP_ThreadBroadcast(__dvd_wait_queue);
+			}
+		} else {
+			slot->used += n;
+			if(offset==(slot->offset+slot->len)) __dvd_prefetchrelease(slot);
+		}
+	}
+
+	__dvd_pfnext = offset;
+	if(ret>=0) __dvd_prefetchissue();
+	_CPU_ISR_Restore(level);
+	return ret;
+}
+
+s32 DVD_SetPrefetch(void *buffer,u32 len)
+{
+	u32 i,level,chunk;
+
+	chunk = ((len/DVD_PREFETCH_SLOTS)&~0x7ff);
+	if(buffer && (((u32)buffer&31) || !chunk)) return DVD_ERROR_FATAL;
+
+	_CPU_ISR_Disable(level);
+	__dvd_prefetchdiscard();
+	for(i=0;i<DVD_PREFETCH_SLOTS;i++) {
+		while(__dvd_pfslots[i].state!=DVD_PREFETCH_FREE) LWP_ThreadSleep(__dvd_wait_queue);
+	}
+
+	__dvd_pfchunk = 0;
+	if(buffer) {
+		for(i=0;i<DVD_PREFETCH_SLOTS;i++) __dvd_pfslots[i].buf = (u8*)buffer+(i*chunk);
+		__dvd_pfchunk = chunk;
+	}
+	__dvd_pfnext = -1;
+	memset(&__dvd_pfstats,0,sizeof(dvdprefetchstats));
+	_CPU_ISR_Restore(level);
+	return DVD_ERROR_OK;
+}
+
+void DVD_GetPrefetchStats(dvdprefetchstats *stats)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	*stats = __dvd_pfstats;
+	_CPU_ISR_Restore(level);
+}
+
+s32 DVD_ReadAbsPrio(dvdcmdblk *block,void *buf,u32 len,s64 offset,s32 prio)
+{
+#ifdef _DVD_DEBUG
+	printf("DVD_ReadAbsPrio(%p,%p,%d,%d,%d)\n",block,buf,len,offset,prio);
+#endif
+	if(offset>=0 && offset<8511160320LL) {
+		if(__dvd_pfchunk) return __dvd_prefetchread(block,buf,len,offset,prio);
+		return __dvd_readabs(block,buf,len,offset,prio);
+	}
 	return DVD_ERROR_FATAL;
 }
 
@@ -2658,6 +3113,16 @@ s32 DVD_CancelAsync(dvdcmdblk *block,dvdcbcallback cb)
 	printf("DVD_CancelAsync(%p,%p)\n",block,cb);
 #endif
 	_CPU_ISR_Disable(level);
+	if(__dvd_ismerged(block)) {
+		if(__dvd_canceling || __dvd_mergecanceled) {
+			_CPU_ISR_Restore(level);
+			return 0;
+		}
+		__dvd_mergecanceled = block;
+		__dvd_mergecancelusrcb = cb;
+		block = &__dvd_mergedcmdblk;
+		cb = __dvd_mergecancelcb;
+	}
 
 	switch(block->state) {
 		case DVD_STATE_FATAL_ERROR:
@@ -2701,6 +3166,8 @@ s32 DVD_CancelAsync(dvdcmdblk *block,dvdcbcallback cb)
 		case DVD_STATE_RETRY:
 			old = DVD_LowClearCallback();
 			if(old!=__dvd_statemotorstoppedcb) {
+				__dvd_mergecanceled = NULL;
+				__dvd_mergecancelusrcb = NULL;
 				_CPU_ISR_Restore(level);
 				return 0;
 			}
@@ -3371,6 +3838,7 @@ s32 DVD_GetCmdBlockStatus(dvdcmdblk *block)
 	u32 level;
 
 	_CPU_ISR_Disable(level);
+	if(__dvd_ismerged(block)) block = &__dvd_mergedcmdblk;
 	if((ret=block->state)==DVD_STATE_COVER_CLOSED) ret = DVD_STATE_BUSY;
 	_CPU_ISR_Restore(level);
 	return ret;
@@ -3452,6 +3920,31 @@ void DVD_Resume()
 	_CPU_ISR_Restore(level);
 }
 
+u32 DVD_SetQueuePolicy(u32 policy)
+{
+	u32 level,old;
+
+	_CPU_ISR_Disable(level);
+	old = __dvd_queuepolicy;
+	__dvd_queuepolicy = policy&(DVD_QUEUE_ELEVATOR|DVD_QUEUE_MERGE);
+	_CPU_ISR_Restore(level);
+	return old;
+}
+
+s32 DVD_SetMergeBuffer(void *buffer,u32 len)
+{
+	u32 level;
+
+	if(buffer && (((u32)buffer&31) || len<32)) return DVD_ERROR_FATAL;
+
+	_CPU_ISR_Disable(level);
+	while(__dvd_mergebounce) LWP_ThreadSleep(__dvd_wait_queue);
+	__dvd_mergebuf = buffer;
+	__dvd_mergebuflen = buffer?(len&~31):0;
+	_CPU_ISR_Restore(level);
+	return DVD_ERROR_OK;
+}
+
 void DVD_Reset(u32 reset_mode)
 {
 	u32 level;
@@ -3503,6 +3996,14 @@ s32 DVD_MountAsync(dvdcmdblk *block,dvdcbcallback cb)
 #ifdef _DVD_DEBUG
 	printf("DVD_MountAsync()\n");
 #endif
+	if(__dvd_pfchunk) {
+		u32 level;
+
+		_CPU_ISR_Disable(level);
+		__dvd_prefetchdiscard();
+		__dvd_pfnext = -1;
+		_CPU_ISR_Restore(level);
+	}
 	__dvd_mountusrcb = cb;
 	DVD_Reset(DVD_RESETHARD);
 	udelay(1150*1000);
@@ -3594,7 +4095,7 @@ static bool __gcdvd_ReadSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSecto
 	if(sector & ~0x7fffff) return false;
 	if(numSectors & ~0x1fffff) return false;
 	if(disc->bytesPerSector != 2048) return false;
-	if(!SYS_IsDMAAddress(buffer, 32)) return false;
+	if(!SYS_IsDMAAddress(buffer, 32)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 32, __gcdvd_ReadSectors);
 	if(!__dvd_initflag) return false;
 
 	if(DVD_ReadAbs(&blk, buffer, numSectors << 11, sector << 11) < 0)
@@ -3679,7 +4180,7 @@ static bool __gcode_ReadSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSecto
 	if((u32)sector != sector) return false;
 	if(numSectors & ~0x7fffff) return false;
 	if(disc->bytesPerSector != 512) return false;
-	if(!SYS_IsDMAAddress(buffer, 32)) return false;
+	if(!SYS_IsDMAAddress(buffer, 32)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 32, __gcode_ReadSectors);
 	if(!__dvd_initflag) return false;
 
 	if(DVD_GcodeRead(&blk, buffer, numSectors << 9, sector) < 0)
@@ -3697,7 +4198,7 @@ static bool __gcode_WriteSectors(DISC_INTERFACE *disc,sec_t sector,sec_t numSect
 	if((u32)sector != sector) return false;
 	if((u32)numSectors != numSectors) return false;
 	if(disc->bytesPerSector != 512) return false;
-	if(!SYS_IsDMAAddress(buffer, 32)) return false;
+	if(!SYS_IsDMAAddress(buffer, 32)) return disc_bounceWriteSectors(disc, sector, numSectors, buffer, 32, __gcode_WriteSectors);
 	if(!__dvd_initflag) return false;
 
 	if(DVD_GcodeWrite(&blk, buffer, numSectors, sector) < 0)
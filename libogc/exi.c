@@ -84,6 +84,7 @@ typedef struct _exibus_priv {
 	lwp_queue lckd_dev;
 	lwpq_t unlockqueue;
 	lwpq_t syncqueue;
+	exichain *chain;
 } exibus_priv;
 
 static lwp_queue _lckdev_queue;
@@ -164,6 +165,7 @@ static void __exi_initmap(exibus_priv *exim)
 		__lwp_queue_init_empty(&m->lckd_dev);
 		m->unlockqueue = LWP_TQUEUE_NULL;
 		m->syncqueue = LWP_TQUEUE_NULL;
+		m->chain = NULL;
 	}
 }
 
@@ -528,14 +530,14 @@ s32 EXI_Sync(s32 nChn)
 	return ret;
 }
 
-static s32 __exi_synccallback(s32 nChn,s32 nDev)
+s32 __exi_synccallback(s32 nChn,s32 nDev)
 {
 	exibus_priv *exi = &eximap[nChn];
 	LWP_ThreadBroadcast(exi->syncqueue);
 	return 1;
 }
 
-static s32 __exi_syncex(s32 nChn)
+s32 __exi_syncex(s32 nChn)
 {
 	u32 level;
 	exibus_priv *exi = &eximap[nChn];
@@ -680,6 +682,138 @@ s32 EXI_DmaEx(s32 nChn,void *pData,u32 nLen,u32 nMode)
 	return 1;
 }
 
+static s32 __exi_chaintc(s32 nChn,s32 nDev);
+
+static void __exi_chainfinish(s32 nChn,s32 result)
+{
+	exichain *chain;
+	exibus_priv *exi = &eximap[nChn];
+
+	chain = exi->chain;
+	if(result!=EXI_CHAIN_OK && exi->flags&EXI_FLAG_SELECT) EXI_Deselect(nChn);
+
+	exi->chain = NULL;
+	chain->result = result;
+	if(chain->cb) chain->cb(nChn,result,chain);
+}
+
+static void __exi_chainstep(s32 nChn)
+{
+	u32 len;
+	exiop *op;
+	exibus_priv *exi = &eximap[nChn];
+	exichain *chain = exi->chain;
+
+	while(chain->curr<chain->cnt) {
+		op = &chain->ops[chain->curr];
+		switch(op->op) {
+			case EXI_OP_SELECT:
+				if(!EXI_Select(nChn,op->dev,op->freq)) goto error;
+				break;
+			case EXI_OP_SELECTSD:
+				if(!EXI_SelectSD(nChn,op->dev,op->freq)) goto error;
+				break;
+			case EXI_OP_DESELECT:
+				if(!EXI_Deselect(nChn)) goto error;
+				break;
+			case EXI_OP_IMM:
+				len = op->len-chain->pos;
+				if(len>0) {
+					if(len>4) len = 4;
+					if(!EXI_Imm(nChn,op->buf+chain->pos,len,op->mode,__exi_chaintc)) goto error;
+					chain->pos += len;
+					return;
+				}
+				break;
+			case EXI_OP_DMA:
+				if(chain->pos<op->len) {
+					if(op->mode==EXI_READ) DCInvalidateRange(op->buf,op->len);
+					else DCStoreRange(op->buf,op->len);
+					if(!EXI_Dma(nChn,op->buf,op->len,op->mode,__exi_chaintc)) goto error;
+					chain->pos = op->len;
+					return;
+				}
+				break;
+			case EXI_OP_POLL:
+				if(chain->pos>0 && (chain->poll&op->mask)==op->value) {
+					if(op->buf) *(u8*)op->buf = chain->poll;
+					break;
+				}
+				if(chain->pos>=op->len) {
+					__exi_chainfinish(nChn,EXI_CHAIN_TIMEOUT);
+					return;
+				}
+				if(!EXI_Imm(nChn,&chain->poll,1,EXI_READ,__exi_chaintc)) goto error;
+				chain->pos++;
+				return;
+			default:
+				goto error;
+		}
+		chain->curr++;
+		chain->pos = 0;
+	}
+	__exi_chainfinish(nChn,EXI_CHAIN_OK);
+	return;
+
+error:
+	__exi_chainfinish(nChn,EXI_CHAIN_ERROR);
+}
+
+static s32 __exi_chaintc(s32 nChn,s32 nDev)
+{
+	if(eximap[nChn].chain) __exi_chainstep(nChn);
+	return 1;
+}
+
+s32 EXI_SubmitChain(s32 nChn,exichain *chain,EXIChainCallback cb)
+{
+	u32 level;
+	exibus_priv *exi = &eximap[nChn];
+#ifdef _EXI_DEBUG
+	printf("EXI_SubmitChain(%d,%p,%p)\n",nChn,chain,cb);
+#endif
+	_CPU_ISR_Disable(level);
+	if(exi->chain || exi->flags&(EXI_FLAG_DMA|EXI_FLAG_IMM)) {
+		_CPU_ISR_Restore(level);
+		return 0;
+	}
+
+	chain->curr = 0;
+	chain->pos = 0;
+	chain->result = EXI_CHAIN_OK;
+	chain->cb = cb;
+	exi->chain = chain;
+	__exi_chainstep(nChn);
+	_CPU_ISR_Restore(level);
+	return 1;
+}
+
+static void __exi_chainsynccb(s32 nChn,s32 result,exichain *chain)
+{
+	LWP_ThreadBroadcast(eximap[nChn].syncqueue);
+}
+
+s32 EXI_RunChain(s32 nChn,exichain *chain)
+{
+	u32 level;
+	exibus_priv *exi = &eximap[nChn];
+
+	_CPU_ISR_Disable(level);
+	if(exi->syncqueue==LWP_TQUEUE_NULL) {
+		if(LWP_InitQueue(&exi->syncqueue)!=0) {
+			_CPU_ISR_Restore(level);
+			return EXI_CHAIN_ERROR;
+		}
+	}
+	if(!EXI_SubmitChain(nChn,chain,__exi_chainsynccb)) {
+		_CPU_ISR_Restore(level);
+		return EXI_CHAIN_ERROR;
+	}
+	while(exi->chain==chain) LWP_ThreadSleep(exi->syncqueue);
+	_CPU_ISR_Restore(level);
+	return chain->result;
+}
+
 s32 EXI_GetState(s32 nChn)
 {
 	exibus_priv *exi = &eximap[nChn];
@@ -126,7 +126,7 @@ static bool __gcsd_readSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSect
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != PAGE_SIZE512) return false;
-	if(!SYS_IsDMAAddress(buffer, 1)) return false;
+	if(!SYS_IsDMAAddress(buffer, 1)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 1, __gcsd_readSectors);
 	if(!sdgecko_isInitialized(chan)) return false;
 
 	if(numSectors == 1)
@@ -150,7 +150,7 @@ static bool __gcsd_writeSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSec
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != PAGE_SIZE512) return false;
-	if(!SYS_IsDMAAddress(buffer, 1)) return false;
+	if(!SYS_IsDMAAddress(buffer, 1)) return disc_bounceWriteSectors(disc, sector, numSectors, buffer, 1, __gcsd_writeSectors);
 	if(!sdgecko_isInitialized(chan)) return false;
 
 	if(numSectors == 1)
@@ -0,0 +1,203 @@
+/*-------------------------------------------------------------
+
+iocq.c -- I/O completion queues
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <errno.h>
+#include "asm.h"
+#include "processor.h"
+#include "lwp.h"
+#include "dvd.h"
+#include "card.h"
+#include "iocq.h"
+
+static iocq_req *__iocq_cardreq[CARD_SLOTB+1] = {NULL,NULL};
+
+static u32 __iocq_harvest(iocq *cq,iocq_event *events,u32 max)
+{
+	u32 i,cnt;
+
+	cnt = (cq->count<max)?cq->count:max;
+	for(i=0;i<cnt;i++) {
+		events[i] = cq->events[cq->head];
+		if(++cq->head==cq->size) cq->head = 0;
+	}
+	cq->count -= cnt;
+	return cnt;
+}
+
+s32 IOCQ_Init(iocq *cq,iocq_event *events,u32 size)
+{
+	s32 ret;
+
+	if(!cq || !events || !size) return -EINVAL;
+
+	ret = LWP_InitQueue(&cq->waitq);
+	if(ret) return -ret;
+
+	cq->events = events;
+	cq->size = size;
+	cq->head = 0;
+	cq->count = 0;
+	cq->overflows = 0;
+	return 0;
+}
+
+s32 IOCQ_Close(iocq *cq)
+{
+	s32 ret;
+	u32 level;
+	lwpq_t waitq;
+
+	if(!cq) return -EINVAL;
+
+	_CPU_ISR_Disable(level);
+	waitq = cq->waitq;
+	cq->waitq = LWP_TQUEUE_NULL;
+	_CPU_ISR_Restore(level);
+
+	ret = LWP_CloseQueue(waitq);
+	return ret?-ret:0;
+}
+
+void IOCQ_InitRequest(iocq_req *req,iocq *cq,void *tag)
+{
+	req->cq = cq;
+	req->tag = tag;
+}
+
+s32 IOCQ_Post(iocq *cq,void *tag,s32 result,u32 source)
+{
+	u32 level,idx;
+	iocq_event *event;
+
+	_CPU_ISR_Disable(level);
+	if(cq->count==cq->size) {
+		cq->overflows++;
+		_CPU_ISR_Restore(level);
+		return IOCQ_ERROR_OVERFLOW;
+	}
+
+	idx = cq->head+cq->count;
+	if(idx>=cq->size) idx -= cq->size;
+
+	event = &cq->events[idx];
+	event->tag = tag;
+	event->result = result;
+	event->source = source;
+	cq->count++;
+
+	if(cq->waitq!=LWP_TQUEUE_NULL) LWP_ThreadSignal(cq->waitq);
+	_CPU_ISR_Restore(level);
+
+	return IOCQ_ERROR_OK;
+}
+
+s32 IOCQ_Wait(iocq *cq,iocq_event *events,u32 max,const struct timespec *reltime)
+{
+	s32 ret;
+	u32 level;
+
+	if(!cq || !events || !max) return -EINVAL;
+
+	_CPU_ISR_Disable(level);
+	while(!cq->count) {
+		if(cq->waitq==LWP_TQUEUE_NULL) {
+			_CPU_ISR_Restore(level);
+			return -EINVAL;
+		}
+
+		if(reltime) {
+			if(LWP_ThreadTimedSleep(cq->waitq,reltime)==ETIMEDOUT) break;
+		} else
+			LWP_ThreadSleep(cq->waitq);
+	}
+	ret = __iocq_harvest(cq,events,max);
+	_CPU_ISR_Restore(level);
+
+	return ret;
+}
+
+s32 IOCQ_Poll(iocq *cq,iocq_event *events,u32 max)
+{
+	s32 ret;
+	u32 level;
+
+	if(!cq || !events) return -EINVAL;
+
+	_CPU_ISR_Disable(level);
+	ret = __iocq_harvest(cq,events,max);
+	_CPU_ISR_Restore(level);
+
+	return ret;
+}
+
+void IOCQ_DVDCallback(s32 result,dvdcmdblk *block)
+{
+	iocq_req *req = (iocq_req*)DVD_GetUserData(block);
+
+	if(req) IOCQ_Post(req->cq,req->tag,result,IOCQ_SOURCE_DVD);
+}
+
+s32 IOCQ_IPCCallback(s32 result,void *usrdata)
+{
+	iocq_req *req = (iocq_req*)usrdata;
+
+	if(req) IOCQ_Post(req->cq,req->tag,result,IOCQ_SOURCE_IPC);
+	return 0;
+}
+
+s32 IOCQ_CARDBind(s32 chn,iocq_req *req)
+{
+	u32 level;
+
+	if(chn<CARD_SLOTA || chn>CARD_SLOTB) return -EINVAL;
+
+	_CPU_ISR_Disable(level);
+	if(req && __iocq_cardreq[chn]) {
+		_CPU_ISR_Restore(level);
+		return IOCQ_ERROR_BUSY;
+	}
+	__iocq_cardreq[chn] = req;
+	_CPU_ISR_Restore(level);
+
+	return IOCQ_ERROR_OK;
+}
+
+void IOCQ_CARDCallback(s32 chn,s32 result)
+{
+	u32 level;
+	iocq_req *req;
+
+	if(chn<CARD_SLOTA || chn>CARD_SLOTB) return;
+
+	_CPU_ISR_Disable(level);
+	req = __iocq_cardreq[chn];
+	__iocq_cardreq[chn] = NULL;
+	_CPU_ISR_Restore(level);
+
+	if(req) IOCQ_Post(req->cq,req->tag,result,IOCQ_SOURCE_CARD);
+}
@@ -60,9 +60,11 @@ distribution.
 #include "lwp_threadq.h"
 #include "lwp_threads.h"
 #include "lwp_wkspace.h"
+#include "lwp_stack.h"
 #include "lwp_objmgr.h"
 #include "lwp_config.h"
 #include "lwp.h"
+#include "system.h"
 
 #define LWP_OBJTYPE_THREAD			1
 #define LWP_OBJTYPE_TQUEUE			2
@@ -87,6 +89,19 @@ typedef struct _tqueue_st {
 lwp_objinfo _lwp_thr_objects;
 lwp_objinfo _lwp_tqueue_objects;
 
+u32 __attribute__((weak)) __lwp_max_threads = LWP_UNLIMITED(LWP_MAX_THREADS);
+u32 __attribute__((weak)) __lwp_max_tqueues = LWP_UNLIMITED(LWP_MAX_TQUEUES);
+
+extern lwp_objinfo _lwp_mutex_objects;
+extern lwp_objinfo _lwp_sema_objects;
+extern lwp_objinfo _lwp_cond_objects;
+extern lwp_objinfo _lwp_mqbox_objects;
+extern lwp_objinfo sys_alarm_objects;
+
+extern void (*_lwp_stackoverflowfunc)(lwp_cntrl *);
+
+static lwpstackcallback __lwp_stackoverflow_cb = NULL;
+
 extern int __crtmain();
 
 extern u8 __stack_addr[],__stack_end[];
@@ -168,8 +183,8 @@ static void* idle_func(void *arg)
 
 void __lwp_sysinit()
 {
-	__lwp_objmgr_initinfo(&_lwp_thr_objects,LWP_MAX_THREADS,sizeof(lwp_cntrl));
-	__lwp_objmgr_initinfo(&_lwp_tqueue_objects,LWP_MAX_TQUEUES,sizeof(tqueue_st));
+	__lwp_objmgr_initinfo(&_lwp_thr_objects,__lwp_max_threads,sizeof(lwp_cntrl));
+	__lwp_objmgr_initinfo(&_lwp_tqueue_objects,__lwp_max_tqueues,sizeof(tqueue_st));
 
 	// create idle thread, is needed if all threads are locked on a queue
 	_thr_idle = (lwp_cntrl*)__lwp_objmgr_allocate(&_lwp_thr_objects);
@@ -194,7 +209,7 @@ BOOL __lwp_thread_isalive(lwp_t thr_id)
 	
 	if(thethread) {  
 		u32 *stackbase = thethread->stack;
-		if(stackbase[0]==0xDEADBABE && !__lwp_statedormant(thethread->cur_state) && !__lwp_statetransient(thethread->cur_state))
+		if(stackbase[0]==CPU_STACK_MAGIC && !__lwp_statedormant(thethread->cur_state) && !__lwp_statetransient(thethread->cur_state))
 			return TRUE;
 	}
 	
@@ -339,6 +354,57 @@ s32 LWP_GetThreadStackSize(lwp_t thethread)
 	return stack_size;
 }
 
+s32 LWP_GetThreadStackUsage(lwp_t thethread)
+{
+	u32 stack_used;
+	lwp_cntrl *lwp_thread;
+
+	if(thethread==LWP_THREAD_NULL) thethread = LWP_GetSelf();
+
+	lwp_thread = __lwp_cntrl_open(thethread);
+	if(!lwp_thread) return LWP_CLOSED;
+
+	stack_used = __lwp_stack_used(lwp_thread);
+	__lwp_thread_dispatchenable();
+
+	return stack_used;
+}
+
+static void __lwp_stackoverflow(lwp_cntrl *thethread)
+{
+	lwpstackcallback cb = __lwp_stackoverflow_cb;
+
+	if(cb) cb((lwp_t)(LWP_OBJMASKTYPE(LWP_OBJTYPE_THREAD)|LWP_OBJMASKID(thethread->object.id)));
+}
+
+void LWP_SetStackOverflowCallback(lwpstackcallback cb)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	__lwp_stackoverflow_cb = cb;
+	_lwp_stackoverflowfunc = cb?__lwp_stackoverflow:NULL;
+	_CPU_ISR_Restore(level);
+}
+
+void LWP_ReportStackUsage()
+{
+	u32 id,stack_size,stack_used;
+	lwp_cntrl *lwp_thread;
+
+	for(id=0;id<_lwp_thr_objects.max_id;id++) {
+		lwp_thread = (lwp_cntrl*)__lwp_objmgr_get(&_lwp_thr_objects,id);
+		if(!lwp_thread) continue;
+
+		stack_size = lwp_thread->stack_size;
+		stack_used = __lwp_stack_used(lwp_thread);
+		__lwp_thread_dispatchenable();
+
+		SYS_Report("thread %08x: stack %u/%u bytes peak%s\n",(LWP_OBJMASKTYPE(LWP_OBJTYPE_THREAD)|id),stack_used,stack_size,
+				   (stack_used+(CPU_STACK_GUARD_WORDS+1)*sizeof(u32)>=stack_size)?", overflowed":"");
+	}
+}
+
 s32 LWP_GetThreadPriority(lwp_t thethread)
 {
 	u32 cur_prio;
@@ -612,3 +678,39 @@ s32 LWP_ThreadSignal(lwpq_t thequeue)
 
 	return 0;
 }
+
+s32 LWP_GetObjectStats(u32 type,lwp_objstats *stats)
+{
+	lwp_objinfo *info;
+
+	if(!stats) return EINVAL;
+
+	switch(type) {
+		case LWP_OBJECTS_THREAD:
+			info = &_lwp_thr_objects;
+			break;
+		case LWP_OBJECTS_TQUEUE:
+			info = &_lwp_tqueue_objects;
+			break;
+		case LWP_OBJECTS_MUTEX:
+			info = &_lwp_mutex_objects;
+			break;
+		case LWP_OBJECTS_SEMA:
+			info = &_lwp_sema_objects;
+			break;
+		case LWP_OBJECTS_COND:
+			info = &_lwp_cond_objects;
+			break;
+		case LWP_OBJECTS_MQUEUE:
+			info = &_lwp_mqbox_objects;
+			break;
+		case LWP_OBJECTS_ALARM:
+			info = &sys_alarm_objects;
+			break;
+		default:
+			return EINVAL;
+	}
+
+	__lwp_objmgr_getstats(info,&stats->allocated,&stats->inuse,&stats->peak);
+	return 0;
+}
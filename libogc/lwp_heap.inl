@@ -54,14 +54,18 @@ distribution.
 #ifndef __OGC_LWP_HEAP_INL__
 #define __OGC_LWP_HEAP_INL__
 
+#include <stddef.h>
+
+// the head and tail blocks overlay the control block so that their next/prev
+// links are first/perm_null and perm_null/last, whatever the pointer size
 static __inline__ heap_block* __lwp_heap_head(heap_cntrl *theheap)
 {
-	return (heap_block*)&theheap->start;
+	return (heap_block*)((char*)&theheap->first - offsetof(heap_block,next));
 }
 
 static __inline__ heap_block* __lwp_heap_tail(heap_cntrl *heap)
 {
-	return (heap_block*)&heap->final;
+	return (heap_block*)((char*)&heap->perm_null - offsetof(heap_block,next));
 }
 
 static __inline__ heap_block* __lwp_heap_prevblock(heap_block *block)
@@ -82,7 +86,7 @@ static __inline__ heap_block* __lwp_heap_blockat(heap_block *block,u32 offset)
 static __inline__ heap_block* __lwp_heap_usrblockat(void *ptr)
 {
 	u32 offset = *(((u32*)ptr)-1);
-	return __lwp_heap_blockat(ptr,-offset+-HEAP_BLOCK_USED_OVERHEAD);
+	return (heap_block*)((char*)ptr - offset - HEAP_BLOCK_USED_OVERHEAD);
 }
 
 static __inline__ bool __lwp_heap_prev_blockfree(heap_block *block)
@@ -69,51 +69,97 @@ u32 __lwp_objmgr_memsize()
 	return _lwp_objmgr_memsize;
 }
 
-void __lwp_objmgr_initinfo(lwp_objinfo *info,u32 max_nodes,u32 node_size)
+static BOOL __lwp_objmgr_extend(lwp_objinfo *info,u32 nodes)
 {
-	u32 idx,i,size;
+	u32 idx,i,level,size;
 	lwp_obj *object;
 	lwp_queue inactives;
-	void **local_table;
-	
-	info->min_id = 0;
-	info->max_id = 0;
-	info->inactives_cnt = 0;
-	info->node_size = node_size;
-	info->max_nodes = max_nodes;
-	info->obj_blocks = NULL;
-	info->local_table = &null_local_table;
-
-	__lwp_queue_init_empty(&info->inactives);
+	lwp_obj **local_table,**old_table;
+	void *obj_block;
 
-	size = ((info->max_nodes*sizeof(lwp_obj*))+(info->max_nodes*info->node_size));
-	local_table = (void**)__lwp_wkspace_allocate(info->max_nodes*sizeof(lwp_obj*));
-	if(!local_table) return;
+	_CPU_ISR_Disable(level);
+	if(nodes>(LWP_OBJ_MAXNODES-info->max_nodes)) nodes = (LWP_OBJ_MAXNODES-info->max_nodes);
+	if(!nodes) {
+		_CPU_ISR_Restore(level);
+		return FALSE;
+	}
 
-	info->local_table = (lwp_obj**)local_table;
-	for(i=0;i<info->max_nodes;i++) {
-		local_table[i] = NULL;
+	size = (((info->max_nodes+nodes)*sizeof(lwp_obj*))+(nodes*info->node_size));
+	local_table = (lwp_obj**)__lwp_wkspace_allocate((info->max_nodes+nodes)*sizeof(lwp_obj*));
+	if(!local_table) {
+		_CPU_ISR_Restore(level);
+		return FALSE;
 	}
 
-	info->obj_blocks = __lwp_wkspace_allocate(info->max_nodes*info->node_size);
-	if(!info->obj_blocks) {
+	obj_block = __lwp_wkspace_allocate(nodes*info->node_size);
+	if(!obj_block) {
 		__lwp_wkspace_free(local_table);
-		return;
+		_CPU_ISR_Restore(level);
+		return FALSE;
 	}
 
-	__lwp_queue_initialize(&inactives,info->obj_blocks,info->max_nodes,info->node_size);
+	for(i=0;i<info->max_nodes;i++) {
+		local_table[i] = info->local_table[i];
+	}
+	for(;i<(info->max_nodes+nodes);i++) {
+		local_table[i] = NULL;
+	}
 
-	idx = info->min_id;
-	while((object=(lwp_obj*)__lwp_queue_get(&inactives))!=NULL) {
+	__lwp_queue_initialize(&inactives,obj_block,nodes,info->node_size);
+
+	idx = info->max_id;
+	while((object=(lwp_obj*)__lwp_queue_getI(&inactives))!=NULL) {
 		object->id = idx;
 		object->information = NULL;
-		__lwp_queue_append(&info->inactives,&object->node);
+		__lwp_queue_appendI(&info->inactives,&object->node);
 		idx++;
 	}
 
-	info->max_id += info->max_nodes;
-	info->inactives_cnt += info->max_nodes;
+	old_table = info->local_table;
+	info->local_table = local_table;
+	if(!info->obj_blocks) info->obj_blocks = obj_block;
+
+	if(old_table!=&null_local_table) {
+		__lwp_wkspace_free(old_table);
+		_lwp_objmgr_memsize -= (info->max_nodes*sizeof(lwp_obj*));
+	}
+
+	info->max_id += nodes;
+	info->max_nodes += nodes;
+	info->inactives_cnt += nodes;
 	_lwp_objmgr_memsize += size;
+	_CPU_ISR_Restore(level);
+
+	return TRUE;
+}
+
+void __lwp_objmgr_initinfo(lwp_objinfo *info,u32 max_nodes,u32 node_size)
+{
+	info->min_id = 0;
+	info->max_id = 0;
+	info->max_nodes = 0;
+	info->inactives_cnt = 0;
+	info->peak_cnt = 0;
+	info->node_size = node_size;
+	info->obj_blocks = NULL;
+	info->local_table = &null_local_table;
+	info->auto_extend = ((max_nodes&LWP_UNLIMITED_OBJECTS)!=0);
+	info->objs_per_block = (max_nodes&~LWP_UNLIMITED_OBJECTS);
+
+	__lwp_queue_init_empty(&info->inactives);
+
+	__lwp_objmgr_extend(info,info->objs_per_block);
+}
+
+void __lwp_objmgr_getstats(lwp_objinfo *info,u32 *p_allocated,u32 *p_inuse,u32 *p_peak)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(p_allocated) *p_allocated = info->max_nodes;
+	if(p_inuse) *p_inuse = (info->max_nodes-info->inactives_cnt);
+	if(p_peak) *p_peak = info->peak_cnt;
+	_CPU_ISR_Restore(level);
 }
 
 lwp_obj* __lwp_objmgr_getisrdisable(lwp_objinfo *info,u32 id,u32 *p_level)
@@ -122,7 +168,7 @@ lwp_obj* __lwp_objmgr_getisrdisable(lwp_objinfo *info,u32 id,u32 *p_level)
 	lwp_obj *object = NULL;
 
 	_CPU_ISR_Disable(level);
-	if(info->max_id>=id) {
+	if(info->max_id>id) {
 		if((object=info->local_table[id])!=NULL) {
 			*p_level = level;
 			return object;
@@ -136,7 +182,7 @@ lwp_obj* __lwp_objmgr_getnoprotection(lwp_objinfo *info,u32 id)
 {
 	lwp_obj *object = NULL;
 
-	if(info->max_id>=id) {
+	if(info->max_id>id) {
 		if((object=info->local_table[id])!=NULL) return object;
 	}
 	return NULL;
@@ -146,7 +192,7 @@ lwp_obj* __lwp_objmgr_get(lwp_objinfo *info,u32 id)
 {
 	lwp_obj *object = NULL;
 
-	if(info->max_id>=id) {
+	if(info->max_id>id) {
 		__lwp_thread_dispatchdisable();
 		if((object=info->local_table[id])!=NULL) return object;
 		__lwp_thread_dispatchenable();
@@ -160,11 +206,15 @@ lwp_obj* __lwp_objmgr_allocate(lwp_objinfo *info)
 	lwp_obj* object;
 
 	_CPU_ISR_Disable(level);
-	 object = (lwp_obj*)__lwp_queue_getI(&info->inactives);
-	 if(object) {
-		 object->information = info;
-		 info->inactives_cnt--;
-	 }
+	object = (lwp_obj*)__lwp_queue_getI(&info->inactives);
+	if(!object && info->auto_extend && __lwp_objmgr_extend(info,info->objs_per_block))
+		object = (lwp_obj*)__lwp_queue_getI(&info->inactives);
+	if(object) {
+		object->information = info;
+		info->inactives_cnt--;
+		if((info->max_nodes-info->inactives_cnt)>info->peak_cnt)
+			info->peak_cnt = (info->max_nodes-info->inactives_cnt);
+	}
 	_CPU_ISR_Restore(level);
 
 	return object;
@@ -76,3 +76,29 @@ void __lwp_stack_free(lwp_cntrl *thethread)
 
 	__lwp_wkspace_free(thethread->stack);
 }
+
+void __lwp_stack_paint(lwp_cntrl *thethread)
+{
+	u32 sp;
+	u32 *ptr,*end;
+
+	ptr = (u32*)thethread->stack+1;
+	end = (u32*)(((u32)thethread->stack+thethread->stack_size-CPU_MINIMUM_STACK_FRAME_SIZE)&~3);
+
+	// the main thread is set up while we are still running on its stack
+	sp = mfsp();
+	if(sp>(u32)ptr && sp<=(u32)end) end = (u32*)((sp-64)&~3);
+
+	while(ptr<end) *ptr++ = CPU_STACK_PAINT;
+}
+
+u32 __lwp_stack_used(lwp_cntrl *thethread)
+{
+	u32 *ptr,*end;
+
+	ptr = (u32*)thethread->stack+1;
+	end = (u32*)(((u32)thethread->stack+thethread->stack_size)&~3);
+
+	while(ptr<end && *ptr==CPU_STACK_PAINT) ptr++;
+	return ((u32)end-(u32)ptr);
+}
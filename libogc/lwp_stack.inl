@@ -59,4 +59,16 @@ static __inline__ u32 __lwp_stack_isenough(u32 size)
 	return (size>=CPU_MINIMUM_STACK_SIZE);
 }
 
+static __inline__ u32 __lwp_stack_isoverflowed(lwp_cntrl *thethread)
+{
+	u32 i;
+	u32 *stackbase = (u32*)thethread->stack;
+
+	if(stackbase[0]!=CPU_STACK_MAGIC) return 1;
+	for(i=1;i<=CPU_STACK_GUARD_WORDS;i++) {
+		if(stackbase[i]!=CPU_STACK_PAINT) return 1;
+	}
+	return 0;
+}
+
 #endif
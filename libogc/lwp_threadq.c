@@ -85,12 +85,9 @@ lwp_cntrl* __lwp_threadqueue_firstfifo(lwp_thrqueue *queue)
 
 lwp_cntrl* __lwp_threadqueue_firstpriority(lwp_thrqueue *queue)
 {
-	u32 index;
+	if(queue->prio_major)
+		return (lwp_cntrl*)queue->queues.priority[cntlzw(queue->prio_major)].first;
 
-	for(index=0;index<LWP_THREADQ_NUM_PRIOHEADERS;index++) {
-		if(!__lwp_queue_isempty(&queue->queues.priority[index]))
-			return (lwp_cntrl*)queue->queues.priority[index].first;
-	}
 	return NULL;
 }
 
@@ -163,106 +160,116 @@ lwp_cntrl* __lwp_threadqueue_dequeuefifo(lwp_thrqueue *queue)
 	return NULL;
 }
 
-void __lwp_threadqueue_enqueuepriority(lwp_thrqueue *queue,lwp_cntrl *thethread,s64 timeout)
+static lwp_cntrl* __lwp_threadqueue_priorityleader(lwp_thrqueue *queue,u32 major,u32 mask)
 {
-	u32 level,search_prio,header_idx,prio,block_state,sync_state;
-	lwp_cntrl *search_thread;
+	u32 before,after;
 	lwp_queue *header;
-	lwp_node *cur_node,*next_node,*prev_node,*search_node;
+	lwp_node *node;
+
+	// the minor bitmap says how many priority levels are linked ahead of
+	// and behind this one, so walk in from whichever end is closer.
+	header = &queue->queues.priority[major];
+	before = __builtin_popcount(queue->prio_minor[major]&~(mask|(mask-1)));
+	after = __builtin_popcount(queue->prio_minor[major]&(mask-1));
+	if(before<=after) {
+		node = header->first;
+		while(before--) node = node->next;
+	} else {
+		node = header->last;
+		while(after--) node = node->prev;
+	}
+	return (lwp_cntrl*)node;
+}
 
-	__lwp_queue_init_empty(&thethread->wait.block2n);
-	
-	prio = thethread->cur_prio;
-	header_idx = prio/LWP_THREADQ_PRIOPERHEADER;
-	header = &queue->queues.priority[header_idx];
-	block_state = queue->state;
+static void __lwp_threadqueue_insertpriority(lwp_thrqueue *queue,lwp_cntrl *thethread,u32 prio)
+{
+	u32 major,mask,lower;
+	lwp_node *search_node,*prev_node,*cur_node;
 
-	if(prio&LWP_THREADQ_REVERSESEARCHMASK) {
-#ifdef _LWPTHRQ_DEBUG
-		printf("__lwp_threadqueue_enqueuepriority(%p,reverse_search)\n",thethread);
-#endif
-		goto reverse_search;
-	}
+	major = prio/LWP_THREADQ_PRIOPERHEADER;
+	mask = 0x80000000>>(prio%LWP_THREADQ_PRIOPERHEADER);
+	cur_node = (lwp_node*)thethread;
 
-#ifdef _LWPTHRQ_DEBUG
-	printf("__lwp_threadqueue_enqueuepriority(%p,forward_search)\n",thethread);
-#endif
-forward_search:
-	search_prio = LWP_PRIO_MIN - 1;
-	_CPU_ISR_Disable(level);
-	search_thread = (lwp_cntrl*)header->first;
-	while(!__lwp_queue_istail(header,(lwp_node*)search_thread)) {
-		search_prio = search_thread->cur_prio;
-		if(prio<=search_prio) break;
-		_CPU_ISR_Flash(level);
+	__lwp_queue_init_empty(&thethread->wait.block2n);
+	thethread->wait.prio = prio;
 
-		if(!__lwp_statesset(search_thread->cur_state,block_state)) {
-			_CPU_ISR_Restore(level);
-			goto forward_search;
-		}
-		search_thread = (lwp_cntrl*)search_thread->object.node.next;
+	if(queue->prio_minor[major]&mask) {
+		search_node = __lwp_queue_tail(&__lwp_threadqueue_priorityleader(queue,major,mask)->wait.block2n);
+	} else {
+		lower = queue->prio_minor[major]&(mask-1);
+		if(lower)
+			search_node = (lwp_node*)__lwp_threadqueue_priorityleader(queue,major,0x80000000>>cntlzw(lower));
+		else
+			search_node = __lwp_queue_tail(&queue->queues.priority[major]);
+
+		queue->prio_minor[major] |= mask;
+		queue->prio_major |= (0x80000000>>major);
 	}
-	if(queue->sync_state!=LWP_THREADQ_NOTHINGHAPPEND) goto synchronize;
-	queue->sync_state = LWP_THREADQ_SYNCHRONIZED;
-	if(prio==search_prio) goto equal_prio;
 
-	search_node = (lwp_node*)search_thread;
 	prev_node = search_node->prev;
-	cur_node = (lwp_node*)thethread;
-	
 	cur_node->next = search_node;
 	cur_node->prev = prev_node;
 	prev_node->next = cur_node;
 	search_node->prev = cur_node;
-	_CPU_ISR_Restore(level);
-	return;
+}
 
-reverse_search:
-	search_prio = LWP_PRIO_MAX + 1;
-	_CPU_ISR_Disable(level);
-	search_thread = (lwp_cntrl*)header->last;
-	while(!__lwp_queue_ishead(header,(lwp_node*)search_thread)) {
-		search_prio = search_thread->cur_prio;
-		if(prio>=search_prio) break;
-		_CPU_ISR_Flash(level);
+static void __lwp_threadqueue_removepriority(lwp_thrqueue *queue,lwp_cntrl *thethread)
+{
+	u32 major,mask;
+	lwp_cntrl *first;
+	lwp_node *curr,*next,*prev,*new_first,*new_sec,*last;
 
-		if(!__lwp_statesset(search_thread->cur_state,block_state)) {
-			_CPU_ISR_Restore(level);
-			goto reverse_search;
+	curr = (lwp_node*)thethread;
+	next = curr->next;
+	prev = curr->prev;
+
+	if(!__lwp_queue_isempty(&thethread->wait.block2n)) {
+		new_first = thethread->wait.block2n.first;
+		first = (lwp_cntrl*)new_first;
+		last = thethread->wait.block2n.last;
+		new_sec = new_first->next;
+
+		prev->next = new_first;
+		next->prev = new_first;
+		new_first->next = next;
+		new_first->prev = prev;
+
+		if(!__lwp_queue_onenode(&thethread->wait.block2n)) {
+			new_sec->prev = __lwp_queue_head(&first->wait.block2n);
+			first->wait.block2n.first = new_sec;
+			first->wait.block2n.last = last;
+			last->next = __lwp_queue_tail(&first->wait.block2n);
 		}
-		search_thread = (lwp_cntrl*)search_thread->object.node.prev;
+		return;
 	}
-	if(queue->sync_state!=LWP_THREADQ_NOTHINGHAPPEND) goto synchronize;
-	queue->sync_state = LWP_THREADQ_SYNCHRONIZED;
-	if(prio==search_prio) goto equal_prio;
 
-	search_node = (lwp_node*)search_thread;
-	next_node = search_node->next;
-	cur_node = (lwp_node*)thethread;
-	
-	cur_node->next = next_node;
-	cur_node->prev = search_node;
-	search_node->next = cur_node;
-	next_node->prev = cur_node;
-	_CPU_ISR_Restore(level);
-	return;
+	// only the last thread of a priority level clears its bit
+	major = thethread->wait.prio/LWP_THREADQ_PRIOPERHEADER;
+	mask = 0x80000000>>(thethread->wait.prio%LWP_THREADQ_PRIOPERHEADER);
+	if(__lwp_threadqueue_priorityleader(queue,major,mask)==thethread) {
+		queue->prio_minor[major] &= ~mask;
+		if(!queue->prio_minor[major]) queue->prio_major &= ~(0x80000000>>major);
+	}
+
+	prev->next = next;
+	next->prev = prev;
+}
+
+void __lwp_threadqueue_enqueuepriority(lwp_thrqueue *queue,lwp_cntrl *thethread,s64 timeout)
+{
+	u32 level,sync_state;
 
-equal_prio:
+	_CPU_ISR_Disable(level);
+	if(queue->sync_state==LWP_THREADQ_NOTHINGHAPPEND) {
 #ifdef _LWPTHRQ_DEBUG
-	printf("__lwp_threadqueue_enqueuepriority(%p,equal_prio)\n",thethread);
+		printf("__lwp_threadqueue_enqueuepriority(%p,%d)\n",thethread,thethread->cur_prio);
 #endif
-	search_node = __lwp_queue_tail(&search_thread->wait.block2n);
-	prev_node = search_node->prev;
-	cur_node = (lwp_node*)thethread;
-
-	cur_node->next = search_node;
-	cur_node->prev = prev_node;
-	prev_node->next = cur_node;
-	search_node->prev = cur_node;
-	_CPU_ISR_Restore(level);
-	return;
+		queue->sync_state = LWP_THREADQ_SYNCHRONIZED;
+		__lwp_threadqueue_insertpriority(queue,thethread,thethread->cur_prio);
+		_CPU_ISR_Restore(level);
+		return;
+	}
 
-synchronize:
 	sync_state = queue->sync_state;
 	queue->sync_state = LWP_THREADQ_SYNCHRONIZED;
 
@@ -271,8 +278,8 @@ synchronize:
 #endif
 	switch(sync_state) {
 		case LWP_THREADQ_SYNCHRONIZED:
-			break;
 		case LWP_THREADQ_NOTHINGHAPPEND:
+			_CPU_ISR_Restore(level);
 			break;
 		case LWP_THREADQ_TIMEOUT:
 			thethread->wait.ret_code = thethread->wait.queue->timeout_status;
@@ -292,59 +299,34 @@ synchronize:
 
 lwp_cntrl* __lwp_threadqueue_dequeuepriority(lwp_thrqueue *queue)
 {
-	u32 level,idx;
-	lwp_cntrl *newfirstthr,*ret = NULL;
-	lwp_node *newfirstnode,*newsecnode,*last_node,*next_node,*prev_node;
+	u32 level;
+	lwp_cntrl *ret;
 
 	_CPU_ISR_Disable(level);
-	for(idx=0;idx<LWP_THREADQ_NUM_PRIOHEADERS;idx++) {
-		if(!__lwp_queue_isempty(&queue->queues.priority[idx])) {
-			ret	 = (lwp_cntrl*)queue->queues.priority[idx].first;
-			goto dequeue;
-		}
-	}
-
+	if(!queue->prio_major) {
 #ifdef _LWPTHRQ_DEBUG
-	printf("__lwp_threadqueue_dequeuepriority(%p,sync_state = %d)\n",ret,queue->sync_state);
+		printf("__lwp_threadqueue_dequeuepriority(sync_state = %d)\n",queue->sync_state);
 #endif
-	switch(queue->sync_state) {
-		case LWP_THREADQ_SYNCHRONIZED:
-		case LWP_THREADQ_SATISFIED:
-			_CPU_ISR_Restore(level);
-			return NULL;
-		case LWP_THREADQ_NOTHINGHAPPEND:
-		case LWP_THREADQ_TIMEOUT:
-			queue->sync_state = LWP_THREADQ_SATISFIED;
-			_CPU_ISR_Restore(level);
-			return _thr_executing;
+		switch(queue->sync_state) {
+			case LWP_THREADQ_SYNCHRONIZED:
+			case LWP_THREADQ_SATISFIED:
+				_CPU_ISR_Restore(level);
+				return NULL;
+			case LWP_THREADQ_NOTHINGHAPPEND:
+			case LWP_THREADQ_TIMEOUT:
+				queue->sync_state = LWP_THREADQ_SATISFIED;
+				_CPU_ISR_Restore(level);
+				return _thr_executing;
+		}
+		_CPU_ISR_Restore(level);
+		return NULL;
 	}
 
-dequeue:
+	ret = (lwp_cntrl*)queue->queues.priority[cntlzw(queue->prio_major)].first;
 #ifdef _LWPTHRQ_DEBUG
 	printf("__lwp_threadqueue_dequeuepriority(%p,dequeue)\n",ret);
 #endif
-	newfirstnode = ret->wait.block2n.first;
-	newfirstthr = (lwp_cntrl*)newfirstnode;
-	next_node = ret->object.node.next;
-	prev_node = ret->object.node.prev;
-	if(!__lwp_queue_isempty(&ret->wait.block2n)) {
-		last_node = ret->wait.block2n.last;
-		newsecnode = newfirstnode->next;
-		prev_node->next = newfirstnode;
-		next_node->prev = newfirstnode;
-		newfirstnode->next = next_node;
-		newfirstnode->prev = prev_node;
-		
-		if(!__lwp_queue_onenode(&ret->wait.block2n)) {
-			newsecnode->prev = __lwp_queue_head(&newfirstthr->wait.block2n);
-			newfirstthr->wait.block2n.first = newsecnode;
-			newfirstthr->wait.block2n.last = last_node;
-			last_node->next = __lwp_queue_tail(&newfirstthr->wait.block2n);
-		}
-	} else {
-		prev_node->next = next_node;
-		next_node->prev = prev_node;
-	}
+	__lwp_threadqueue_removepriority(queue,ret);
 
 	if(!__lwp_wd_isactive(&ret->timer)) {
 		_CPU_ISR_Restore(level);
@@ -358,6 +340,18 @@ dequeue:
 	return ret;
 }
 
+void __lwp_threadqueue_requeuepriority(lwp_thrqueue *queue,lwp_cntrl *thethread)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(__lwp_statewaitthreadqueue(thethread->cur_state) && thethread->wait.prio!=thethread->cur_prio) {
+		__lwp_threadqueue_removepriority(queue,thethread);
+		__lwp_threadqueue_insertpriority(queue,thethread,thethread->cur_prio);
+	}
+	_CPU_ISR_Restore(level);
+}
+
 void __lwp_threadqueue_init(lwp_thrqueue *queue,u32 mode,u32 state,u32 timeout_status)
 {
 	u32 index;
@@ -374,8 +368,11 @@ void __lwp_threadqueue_init(lwp_thrqueue *queue,u32 mode,u32 state,u32 timeout_s
 			__lwp_queue_init_empty(&queue->queues.fifo);
 			break;
 		case LWP_THREADQ_MODEPRIORITY:
-			for(index=0;index<LWP_THREADQ_NUM_PRIOHEADERS;index++)
+			for(index=0;index<LWP_THREADQ_NUM_PRIOHEADERS;index++) {
 				__lwp_queue_init_empty(&queue->queues.priority[index]);
+				queue->prio_minor[index] = 0;
+			}
+			queue->prio_major = 0;
 			break;
 	}
 }
@@ -493,37 +490,11 @@ void __lwp_threadqueue_extractfifo(lwp_thrqueue *queue,lwp_cntrl *thethread)
 void __lwp_threadqueue_extractpriority(lwp_thrqueue *queue,lwp_cntrl *thethread)
 {
 	u32 level;
-	lwp_cntrl *first;
-	lwp_node *curr,*next,*prev,*new_first,*new_sec,*last;
-
-	curr = (lwp_node*)thethread;
 
 	_CPU_ISR_Disable(level);
 	if(__lwp_statewaitthreadqueue(thethread->cur_state)) {
-		next = curr->next;
-		prev = curr->prev;
-		
-		if(!__lwp_queue_isempty(&thethread->wait.block2n)) {
-			new_first = thethread->wait.block2n.first;
-			first = (lwp_cntrl*)new_first;
-			last = thethread->wait.block2n.last;
-			new_sec = new_first->next;
-
-			prev->next = new_first;
-			next->prev = new_first;
-			new_first->next = next;
-			new_first->prev = prev;
-
-			if(!__lwp_queue_onenode(&thethread->wait.block2n)) {
-				new_sec->prev = __lwp_queue_head(&first->wait.block2n);
-				first->wait.block2n.first = new_sec;
-				first->wait.block2n.last = last;
-				last->next = __lwp_queue_tail(&first->wait.block2n);
-			}
-		} else {
-			prev->next = next;
-			next->prev = prev;
-		}
+		__lwp_threadqueue_removepriority(queue,thethread);
+
 		if(!__lwp_wd_isactive(&thethread->timer)) {
 			_CPU_ISR_Restore(level);
 			__lwp_thread_unblock(thethread);
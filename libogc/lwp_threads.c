@@ -83,6 +83,7 @@ void **__lwp_thr_libc_reent = NULL;
 lwp_queue _lwp_thr_ready[LWP_MAXPRIORITIES];
 
 static void (*_lwp_exitfunc)(void);
+void (*_lwp_stackoverflowfunc)(lwp_cntrl *) = NULL;
 
 extern void _cpu_context_switch(void *,void *);
 extern void _cpu_context_switch_ex(void *,void *);
@@ -185,6 +186,11 @@ void __thread_dispatch()
 		_thr_executing = heir;
 		_CPU_ISR_Restore(level);
 
+		// an exiting thread's stack was already given back to the workspace
+		if(_lwp_stackoverflowfunc && !__lwp_statetransient(exec->cur_state)
+			&& exec->stack && __lwp_stack_isoverflowed(exec))
+			_lwp_stackoverflowfunc(exec);
+
 		if(__lwp_thr_libc_reent) {
 			exec->libc_reent = *__lwp_thr_libc_reent;
 			*__lwp_thr_libc_reent = heir->libc_reent;
@@ -367,9 +373,14 @@ void __lwp_thread_changepriority(lwp_cntrl *thethread,u32 prio,u32 prependit)
 	
 	__lwp_thread_settransient(thethread);
 	
-	if(thethread->cur_prio!=prio) 
+	if(thethread->cur_prio!=prio) {
 		__lwp_thread_setpriority(thethread,prio);
 
+		// keep a thread blocked on a priority queue sorted at its new priority
+		if(thethread->wait.queue && thethread->wait.queue->mode==LWP_THREADQ_MODEPRIORITY)
+			__lwp_threadqueue_requeuepriority(thethread->wait.queue,thethread);
+	}
+
 	_CPU_ISR_Disable(level);
 
 	thethread->cur_state = __lwp_clearstate(thethread->cur_state,LWP_STATES_TRANSIENT);
@@ -503,7 +514,8 @@ void __lwp_thread_loadenv(lwp_cntrl *thethread)
 	size = thethread->stack_size;
 
 	// tag both bottom & head of stack
-	*((u32*)stackbase) = 0xDEADBABE;
+	*((u32*)stackbase) = CPU_STACK_MAGIC;
+	__lwp_stack_paint(thethread);
 	sp = stackbase+size-CPU_MINIMUM_STACK_FRAME_SIZE;
 	*((u32*)sp) = 0;
 	
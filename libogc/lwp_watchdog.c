@@ -73,13 +73,9 @@ static void __lwp_wd_settimer(wd_cntrl *wd)
 {
 	u64 now;
 	s64 diff;
-	union uulc {
-		u64 ull;
-		u32 ul[2];
-	} v;
 
 	now = __SYS_GetSystemTime();
-	v.ull = diff = diff_ticks(now,wd->fire);
+	diff = diff_ticks(now,wd->fire);
 #ifdef _LWPWD_DEBUG
 	printf("__lwp_wd_settimer(%p,%llu,%lld)\n",wd,wd->fire,diff);
 #endif
@@ -91,9 +87,9 @@ static void __lwp_wd_settimer(wd_cntrl *wd)
 		mtdec(0);
 	} else if(diff<0x0000000080000000LL) {
 #ifdef _LWPWD_DEBUG
-		printf("__lwp_wd_settimer(%d): %lld<0x0000000080000000LL\n",v.ul[1],diff);
+		printf("__lwp_wd_settimer(%d): %lld<0x0000000080000000LL\n",(u32)diff,diff);
 #endif
-		mtdec(v.ul[1]);
+		mtdec((u32)diff);
 	} else {
 #ifdef _LWPWD_DEBUG
 		printf("__lwp_wd_settimer(0x7fffffff)\n");
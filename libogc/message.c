@@ -77,9 +77,11 @@ typedef struct _mqbox_st
 
 lwp_objinfo _lwp_mqbox_objects;
 
+u32 __attribute__((weak)) __lwp_max_mqueues = LWP_UNLIMITED(LWP_MAX_MQUEUES);
+
 void __lwp_mqbox_init()
 {
-	__lwp_objmgr_initinfo(&_lwp_mqbox_objects,LWP_MAX_MQUEUES,sizeof(mqbox_st));
+	__lwp_objmgr_initinfo(&_lwp_mqbox_objects,__lwp_max_mqueues,sizeof(mqbox_st));
 }
 
 static __inline__ mqbox_st* __lwp_mqbox_open(mqbox_t mbox)
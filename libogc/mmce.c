@@ -597,8 +597,8 @@ static bool __mmce_readSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSect
 	if ((u32)sector != sector) return false;
 	if ((u16)numSectors != numSectors) return false;
 	if (disc->bytesPerSector != 512) return false;
-	if (!SYS_IsDMAAddress(buffer, 32)) return false;
 	if (!__MMCE[chan].attached) return false;
+	if (!SYS_IsDMAAddress(buffer, 32)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 32, __mmce_readSectors);
 
 	return MMCE_ReadSectors(chan, sector, numSectors, buffer) == MMCE_RESULT_READY;
 }
@@ -613,8 +613,8 @@ static bool __mmce_writeSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSec
 	if ((u32)sector != sector) return false;
 	if ((u16)numSectors != numSectors) return false;
 	if (disc->bytesPerSector != 512) return false;
-	if (!SYS_IsDMAAddress(buffer, 32)) return false;
 	if (!__MMCE[chan].attached) return false;
+	if (!SYS_IsDMAAddress(buffer, 32)) return disc_bounceWriteSectors(disc, sector, numSectors, buffer, 32, __mmce_writeSectors);
 
 	return MMCE_WriteSectors(chan, sector, numSectors, buffer) == MMCE_RESULT_READY;
 }
@@ -77,6 +77,8 @@ typedef struct _mutex_st
 
 lwp_objinfo _lwp_mutex_objects;
 
+u32 __attribute__((weak)) __lwp_max_mutexes = LWP_UNLIMITED(LWP_MAX_MUTEXES);
+
 static s32 __lwp_mutex_locksupp(mutex_t lock,u32 wait_status,s64 timeout)
 {
 	u32 level;
@@ -110,7 +112,7 @@ static s32 __lwp_mutex_locksupp(mutex_t lock,u32 wait_status,s64 timeout)
 
 void __lwp_mutex_init()
 {
-	__lwp_objmgr_initinfo(&_lwp_mutex_objects,LWP_MAX_MUTEXES,sizeof(mutex_st));
+	__lwp_objmgr_initinfo(&_lwp_mutex_objects,__lwp_max_mutexes,sizeof(mutex_st));
 }
 
 static __inline__ mutex_st* __lwp_mutex_open(mutex_t lock)
@@ -0,0 +1,158 @@
+/*-------------------------------------------------------------
+
+sdgecko_crc.inl -- CRC7 and CRC16-CCITT kernels of the SD-over-EXI driver
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __SDGECKO_CRC_INL__
+#define __SDGECKO_CRC_INL__
+
+/* Included by sdgecko_io.c and by tools/sdcrc, which checks and times the
+   kernels on the host. The data is big-endian, so word loads are swapped
+   on a little-endian host. */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__
+#define __crc_load16(p)		__builtin_bswap16(*(const u16*)(p))
+#define __crc_load32(p)		__builtin_bswap32(*(const u32*)(p))
+#else
+#define __crc_load16(p)		(*(const u16*)(p))
+#define __crc_load32(p)		(*(const u32*)(p))
+#endif
+
+static u8 _ioCrc7Table[4][256];
+static u16 _ioCrc16Table[8][256];
+
+static void __build_crc7_tables()
+{
+	s32 i,j;
+	u8 crc7;
+
+	for(i=0;i<256;i++) {
+		crc7 = i;
+		for(j=0;j<8;j++) {
+			if(crc7&0x80) crc7 = (crc7<<1)^0x12;
+			else crc7 <<= 1;
+		}
+		_ioCrc7Table[0][i] = crc7;
+	}
+
+	for(j=1;j<4;j++) {
+		for(i=0;i<256;i++) _ioCrc7Table[j][i] = _ioCrc7Table[0][_ioCrc7Table[j-1][i]];
+	}
+}
+
+static void __build_crc16_tables()
+{
+	s32 i,j;
+	u16 crc16;
+
+	for(i=0;i<256;i++) {
+		crc16 = ((u16)i)<<8;
+		for(j=0;j<8;j++) {
+			if(crc16&0x8000) crc16 = (crc16<<1)^0x1021;
+			else crc16 <<= 1;
+		}
+		_ioCrc16Table[0][i] = crc16;
+	}
+
+	for(j=1;j<8;j++) {
+		for(i=0;i<256;i++) {
+			crc16 = _ioCrc16Table[j-1][i];
+			crc16 = _ioCrc16Table[0][crc16>>8]^(crc16<<8);
+			_ioCrc16Table[j][i] = crc16;
+		}
+	}
+}
+
+static u8 __make_crc7_bytewise(void *buffer,u32 len)
+{
+	s32 i;
+	u8 crc7;
+	u8 *ptr;
+
+	crc7 = 0;
+	ptr = buffer;
+	for(i=0;i<len;i++) {
+		crc7 ^= ptr[i];
+		crc7 = _ioCrc7Table[0][crc7];
+	}
+	return crc7;
+}
+
+static u8 __make_crc7_sliced(void *buffer,u32 len)
+{
+	u8 crc7;
+	u8 *ptr;
+
+	crc7 = 0;
+	ptr = buffer;
+	for(;len>=4;len-=4,ptr+=4) {
+		crc7 = _ioCrc7Table[3][crc7^ptr[0]]^_ioCrc7Table[2][ptr[1]]
+			^_ioCrc7Table[1][ptr[2]]^_ioCrc7Table[0][ptr[3]];
+	}
+	for(;len>0;len--,ptr++) crc7 = _ioCrc7Table[0][crc7^*ptr];
+	return crc7;
+}
+
+static u16 __make_crc16_wordwise(void *buffer,u32 len)
+{
+	s32 i;
+	u16 crc16;
+	u16 *ptr;
+
+	crc16 = 0;
+	len /= 2;
+	ptr = buffer;
+	for(i=0;i<len;i++) {
+		crc16 ^= __crc_load16(&ptr[i]);
+		crc16 = _ioCrc16Table[1][crc16>>8]^_ioCrc16Table[0][crc16&0xff];
+	}
+	return crc16;
+}
+
+static u16 __make_crc16_sliced(void *buffer,u32 len)
+{
+	u32 w0,w1;
+	u16 crc16;
+	u8 *ptr;
+
+	crc16 = 0;
+	ptr = buffer;
+	if(!((u32)ptr&3)) {
+		for(;len>=8;len-=8,ptr+=8) {
+			w0 = __crc_load32(ptr)^((u32)crc16<<16);
+			w1 = __crc_load32(ptr+4);
+			crc16 = _ioCrc16Table[7][w0>>24]^_ioCrc16Table[6][(w0>>16)&0xff]
+				^_ioCrc16Table[5][(w0>>8)&0xff]^_ioCrc16Table[4][w0&0xff]
+				^_ioCrc16Table[3][w1>>24]^_ioCrc16Table[2][(w1>>16)&0xff]
+				^_ioCrc16Table[1][(w1>>8)&0xff]^_ioCrc16Table[0][w1&0xff];
+		}
+	}
+	for(;len>1;len-=2,ptr+=2) {
+		crc16 = _ioCrc16Table[1][(crc16>>8)^ptr[0]]^_ioCrc16Table[0][(crc16&0xff)^ptr[1]];
+	}
+	return crc16;
+}
+
+#endif
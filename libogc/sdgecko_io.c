@@ -14,6 +14,7 @@
 //#include "card_fat.h"
 #include "card_io.h"
 #include "timesupp.h"
+#include "sdgecko_crc.inl"
 
 //#define _CARDIO_DEBUG
 #ifdef _CARDIO_DEBUG
@@ -49,6 +50,9 @@
 
 typedef s32 (*cardiocallback)(s32 drv_no);
 
+extern s32 __exi_synccallback(s32 nChn,s32 nDev);
+extern s32 __exi_syncex(s32 nChn);
+
 u8 g_CID[MAX_DRIVE][16];
 u8 g_CSD[MAX_DRIVE][16];
 u8 g_CardStatus[MAX_DRIVE][64];
@@ -80,8 +84,6 @@ static u32 _ioError[MAX_DRIVE];
 static bool _ioCardInserted[MAX_DRIVE];
 
 static u8 _ioResponse[MAX_DRIVE][128];
-static u8 _ioCrc7Table[256];
-static u16 _ioCrc16Table[2][256];
 
 // SDHC support
 static u32 _initType[MAX_DRIVE];
@@ -105,34 +107,20 @@ static __inline__ u32 __check_response(s32 drv_no,u8 res)
 	return ((_ioError[drv_no]&CARDIO_OP_IOERR_FATAL)?CARDIO_ERROR_FATALERROR:CARDIO_ERROR_READY);
 }
 
-static void __init_crc7()
-{
-	s32 i,j;
-	u8 crc7;
-
-	for(i=0;i<256;i++) {
-		crc7 = i;
-		for(j=0;j<8;j++) {
-			if(crc7&0x80) crc7 = (crc7<<1)^0x12;
-			else crc7 <<= 1;
-		}
-		_ioCrc7Table[i] = crc7;
-	}
-}
+static u8 (*__make_crc7)(void *buffer,u32 len) = __make_crc7_bytewise;
 
-static u8 __make_crc7(void *buffer,u32 len)
+static void __init_crc7()
 {
 	s32 i;
-	u8 crc7;
-	u8 *ptr;
+	u8 buf[16];
 
-	crc7 = 0;
-	ptr = buffer;
-	for(i=0;i<len;i++) {
-		crc7 ^= ptr[i];
-		crc7 = _ioCrc7Table[crc7];
+	__build_crc7_tables();
+
+	for(i=0;i<sizeof(buf);i++) buf[i] = (i*0x9d)^0x5a;
+	for(i=0;i<=sizeof(buf);i++) {
+		if(__make_crc7_sliced(buf,i)!=__make_crc7_bytewise(buf,i)) break;
 	}
-	return crc7;
+	__make_crc7 = (i>sizeof(buf))?__make_crc7_sliced:__make_crc7_bytewise;
 }
 
 /* Old way, realtime
@@ -167,41 +155,25 @@ static u8 __make_crc7(void *buffer,u32 len)
 	return (res<<1)&0xff;
 }
 */
-static void __init_crc16()
-{
-	s32 i,j;
-	u16 crc16;
-
-	for(i=0;i<256;i++) {
-		crc16 = ((u16)i)<<8;
-		for(j=0;j<8;j++) {
-			if(crc16&0x8000) crc16 = (crc16<<1)^0x1021;
-			else crc16 <<= 1;
-		}
-		_ioCrc16Table[0][i] = crc16;
-	}
-
-	for(i=0;i<256;i++) {
-		crc16 = _ioCrc16Table[0][i];
-		crc16 = _ioCrc16Table[0][crc16>>8]^(crc16<<8);
-		_ioCrc16Table[1][i] = crc16;
-	}
-}
+static u16 (*__make_crc16)(void *buffer,u32 len) = __make_crc16_wordwise;
 
-static u16 __make_crc16(void *buffer,u32 len)
+static void __init_crc16()
 {
 	s32 i;
-	u16 crc16;
-	u16 *ptr;
+	u8 buf[PAGE_SIZE512] ATTRIBUTE_ALIGN(32);
 
-	crc16 = 0;
-	len /= 2;
-	ptr = buffer;
-	for(i=0;i<len;i++) {
-		crc16 ^= ptr[i];
-		crc16 = _ioCrc16Table[1][crc16>>8]^_ioCrc16Table[0][crc16&0xff];
+	__build_crc16_tables();
+
+	// only switch to the sliced kernel if it matches the word-wise one bit for bit
+	for(i=0;i<PAGE_SIZE512;i++) buf[i] = (i*0x9d)^(i>>8)^0x5a;
+	for(i=0;i<=32;i+=2) {
+		if(__make_crc16_sliced(buf,i)!=__make_crc16_wordwise(buf,i)) break;
+		if(__make_crc16_sliced(buf+2,i)!=__make_crc16_wordwise(buf+2,i)) break;
 	}
-	return crc16;
+	if(i>32 && __make_crc16_sliced(buf,PAGE_SIZE512)==__make_crc16_wordwise(buf,PAGE_SIZE512))
+		__make_crc16 = __make_crc16_sliced;
+	else
+		__make_crc16 = __make_crc16_wordwise;
 }
 
 /* Old way, realtime
@@ -702,6 +674,144 @@ static s32 __card_dataread(s32 drv_no,void *buf,u32 len)
 	return ret;
 }
 
+// transfers the misaligned head of the buffer immediately and starts the DMA
+// of the aligned body. The caller is free to use the CPU until __card_dmafinish.
+static s32 __card_dmastart(s32 drv_no,u8 *ptr,u32 len,u32 mode,u32 *tail)
+{
+	u32 head,body;
+
+	head = -((u32)ptr)&0x1f;
+	if(head>len) head = len;
+	if(head>0 && EXI_ImmEx(drv_no,ptr,head,mode)==0) return 0;
+
+	ptr += head;
+	len -= head;
+	body = len&~0x1f;
+	*tail = len-body;
+	if(body>0) {
+		if(mode==EXI_READ) DCInvalidateRange(ptr,body);
+		else DCStoreRange(ptr,body);
+		if(EXI_Dma(drv_no,ptr,body,mode,__exi_synccallback)==0) return 0;
+	}
+	return 1;
+}
+
+static s32 __card_dmafinish(s32 drv_no,u8 *end,u32 tail,u32 mode)
+{
+	if(__exi_syncex(drv_no)==0) return 0;
+
+	if(tail>0) return EXI_ImmEx(drv_no,end-tail,tail,mode);
+	return 1;
+}
+
+// polls for the start block token four bytes at a time, any data that
+// followed the token in the same word is stored to buf.
+static s32 __card_datatoken(s32 drv_no,u8 *buf,u32 *cnt)
+{
+	u32 i,j;
+	u8 tok[4];
+	s32 startT;
+
+	startT = gettick();
+	while(1) {
+		if(EXI_ImmEx(drv_no,tok,4,EXI_READ)==0) return CARDIO_ERROR_IOERROR;
+
+		for(i=0;i<4 && tok[i]==0xff;i++);
+		if(i<4) {
+			if(tok[i]!=0xfe) return CARDIO_ERROR_IOERROR;
+
+			for(j=0,i++;i<4;i++,j++) buf[j] = tok[i];
+			*cnt = j;
+			return CARDIO_ERROR_READY;
+		}
+		if(__card_checktimeout(drv_no,startT,1500)!=0) return CARDIO_ERROR_IOTIMEOUT;
+	}
+}
+
+static s32 __card_databusy(s32 drv_no)
+{
+	u8 res[4];
+	s32 startT;
+
+	startT = gettick();
+	while(1) {
+		if(EXI_ImmEx(drv_no,res,4,EXI_READ)==0) return CARDIO_ERROR_IOERROR;
+		if(res[0] || res[1] || res[2] || res[3]) return CARDIO_ERROR_READY;
+		if(__card_checktimeout(drv_no,startT,1500)!=0) return CARDIO_ERROR_IOTIMEOUT;
+	}
+}
+
+// Streams cnt data blocks of a CMD18 run within a single selection. The CRC
+// of each block is checked while the DMA of the next one is in flight.
+static s32 __card_multidataread(s32 drv_no,void *buf,u32 len,u32 cnt)
+{
+	u8 *ptr,*prev;
+	u32 i,n,tail;
+	u16 crc,crc_org,crc_prev;
+	s32 ret;
+
+	if(drv_no<0 || drv_no>=MAX_DRIVE) return CARDIO_ERROR_NOCARD;
+
+	EXI_LockEx(drv_no,_ioCardSelect[drv_no]);
+
+	if((_ioTransferMode[drv_no]==CARDIO_TRANSFER_DMA?
+		EXI_SelectSD(drv_no,_ioCardSelect[drv_no],_ioCardFreq[drv_no]):
+		EXI_Select(drv_no,_ioCardSelect[drv_no],_ioCardFreq[drv_no]))==0) {
+		EXI_Unlock(drv_no);
+		return CARDIO_ERROR_NOCARD;
+	}
+
+	ret = CARDIO_ERROR_READY;
+	ptr = buf;
+	prev = NULL;
+	crc_prev = 0;
+	for(i=0;i<cnt;i++) {
+		if((ret=__card_datatoken(drv_no,ptr,&n))!=0) break;
+
+		if(_ioTransferMode[drv_no]==CARDIO_TRANSFER_DMA) {
+			if(__card_dmastart(drv_no,ptr+n,len-n,EXI_READ,&tail)==0) {
+				ret = CARDIO_ERROR_IOERROR;
+				break;
+			}
+			if(prev && __make_crc16(prev,len)!=crc_prev) {
+				__card_dmafinish(drv_no,ptr+len,0,EXI_READ);
+				ret = CARDIO_OP_IOERR_CRC;
+				break;
+			}
+			if(__card_dmafinish(drv_no,ptr+len,tail,EXI_READ)==0) {
+				ret = CARDIO_ERROR_IOERROR;
+				break;
+			}
+		} else {
+			if(prev && __make_crc16(prev,len)!=crc_prev) {
+				ret = CARDIO_OP_IOERR_CRC;
+				break;
+			}
+			if(EXI_ImmEx(drv_no,ptr+n,len-n,EXI_READ)==0) {
+				ret = CARDIO_ERROR_IOERROR;
+				break;
+			}
+		}
+
+		if(EXI_ImmEx(drv_no,&crc_org,2,EXI_READ)==0) {
+			ret = CARDIO_ERROR_IOERROR;
+			break;
+		}
+		prev = ptr;
+		crc_prev = crc_org;
+		ptr += len;
+	}
+
+	EXI_Deselect(drv_no);
+	EXI_Unlock(drv_no);
+
+	if(ret==CARDIO_ERROR_READY) {
+		crc = __make_crc16(prev,len);
+		if(crc!=crc_prev) ret = CARDIO_OP_IOERR_CRC;
+	}
+	return ret;
+}
+
 static s32 __card_datawrite(s32 drv_no,void *buf,u32 len)
 {
 	u8 dummy[32];
@@ -741,15 +851,21 @@ static s32 __card_datawrite(s32 drv_no,void *buf,u32 len)
 	return ret;
 }
 
-static s32 __card_multidatawrite(s32 drv_no,void *buf,u32 len)
+// Streams cnt data blocks of a CMD25 run within a single selection, including
+// the data response and busy wait of each block. The CRC of the next block is
+// computed while the DMA of the current one is in flight.
+static s32 __card_multidatawrite(s32 drv_no,void *buf,u32 len,u32 cnt)
 {
+	u8 *ptr;
 	u8 dummy[32];
-	u16 crc;
-	s32 ret;
+	u32 i,tail;
+	u16 crc,crc_next;
+	s32 startT,ret;
 
 	if(drv_no<0 || drv_no>=MAX_DRIVE) return CARDIO_ERROR_NOCARD;
 
-	crc = __make_crc16(buf,len);
+	ptr = buf;
+	crc_next = __make_crc16(ptr,len);
 
 	EXI_LockEx(drv_no,_ioCardSelect[drv_no]);
 
@@ -758,21 +874,40 @@ static s32 __card_multidatawrite(s32 drv_no,void *buf,u32 len)
 		return CARDIO_ERROR_NOCARD;
 	}
 
-	dummy[0] = 0xfc;
-	if(EXI_ImmEx(drv_no,dummy,1,EXI_WRITE)==0) {
-		EXI_Deselect(drv_no);
-		EXI_Unlock(drv_no);
-		return CARDIO_ERROR_IOERROR;
-	}
+	ret = CARDIO_ERROR_READY;
+	for(i=0;i<cnt;i++) {
+		crc = crc_next;
 
-	if(EXI_DmaEx(drv_no,buf,len,EXI_WRITE)==0) {
-		EXI_Deselect(drv_no);
-		EXI_Unlock(drv_no);
-		return CARDIO_ERROR_IOERROR;
-	}
+		dummy[0] = 0xfc;
+		if(EXI_ImmEx(drv_no,dummy,1,EXI_WRITE)==0
+			|| __card_dmastart(drv_no,ptr,len,EXI_WRITE,&tail)==0) {
+			ret = CARDIO_ERROR_IOERROR;
+			break;
+		}
+		if((i+1)<cnt) crc_next = __make_crc16(ptr+len,len);
+		if(__card_dmafinish(drv_no,ptr+len,tail,EXI_WRITE)==0
+			|| EXI_ImmEx(drv_no,&crc,2,EXI_WRITE)==0) {
+			ret = CARDIO_ERROR_IOERROR;
+			break;
+		}
 
-	ret = CARDIO_ERROR_READY;
-	if(EXI_ImmEx(drv_no,&crc,2,EXI_WRITE)==0) ret = CARDIO_ERROR_IOERROR;
+		// data response token, then busy until the block is programmed
+		startT = gettick();
+		do {
+			if(EXI_ImmEx(drv_no,dummy,1,EXI_READ)==0) ret = CARDIO_ERROR_IOERROR;
+			else if((dummy[0]&0x10) && __card_checktimeout(drv_no,startT,1500)!=0) ret = CARDIO_ERROR_IOTIMEOUT;
+		} while(ret==CARDIO_ERROR_READY && (dummy[0]&0x10));
+		if(ret!=CARDIO_ERROR_READY) break;
+
+		_ioResponse[drv_no][0] = dummy[0];
+		dummy[0] = _SHIFTR(dummy[0],1,3);
+		if(dummy[0]==0x0005) ret = CARDIO_OP_IOERR_CRC;
+		else if(dummy[0]==0x0006) ret = CARDIO_OP_IOERR_WRITE;
+		else ret = __card_databusy(drv_no);
+		if(ret!=CARDIO_ERROR_READY) break;
+
+		ptr += len;
+	}
 
 	EXI_Deselect(drv_no);
 	EXI_Unlock(drv_no);
@@ -1419,7 +1554,6 @@ s32 sdgecko_readSector(s32 drv_no,void *buf,u32 sector_no)
 // Multiple sector read by emu_kidid
 s32 sdgecko_readSectors(s32 drv_no,u32 sector_no,u32 num_sectors,void *buf)
 {
-	u32 i;
 	s32 ret,ret2;
 	u8 arg[4] = {0,0,0,0};
 	char *ptr = (char*)buf;
@@ -1447,16 +1581,12 @@ s32 sdgecko_readSectors(s32 drv_no,u32 sector_no,u32 num_sectors,void *buf)
 		if((ret=__card_response1(drv_no))!=0) return ret;
 	}
 
-	for(i=0;i<num_sectors;i++) {
-		if((ret=__card_dataread(drv_no,ptr,_ioPageSize[drv_no]))!=0) {
-			if((ret2=__card_sendcmd(drv_no,0x0C,NULL))!=0) return ret2;
-			if((ret2=__card_stopresponse(drv_no))!=0) return ret2;
-			return ret;
-		}
-		ptr += _ioPageSize[drv_no];
-		sector_no++;
+	if((ret=__card_multidataread(drv_no,ptr,_ioPageSize[drv_no],num_sectors))!=0) {
+		if((ret2=__card_sendcmd(drv_no,0x0C,NULL))!=0) return ret2;
+		if((ret2=__card_stopresponse(drv_no))!=0) return ret2;
+		return ret;
 	}
-	_ioReadSector[drv_no] = sector_no;
+	_ioReadSector[drv_no] = sector_no+num_sectors;
 	return ret;
 }
 
@@ -1493,7 +1623,6 @@ s32 sdgecko_writeSector(s32 drv_no,const void *buf,u32 sector_no)
 
 s32 sdgecko_writeSectors(s32 drv_no,u32 sector_no,u32 num_sectors,const void *buf)
 {
-	u32 i;
 	s32 ret,ret2;
 	u8 arg[4] = {0,0,0,0};
 	char *ptr = (char*)buf;
@@ -1527,14 +1656,10 @@ s32 sdgecko_writeSectors(s32 drv_no,u32 sector_no,u32 num_sectors,const void *bu
 	if((ret=__card_sendcmd(drv_no,0x19,arg))!=0) return ret;
 	if((ret=__card_response1(drv_no))!=0) return ret;
 
-	for(i=0;i<num_sectors;i++) {
-		if((ret=__card_multidatawrite(drv_no,ptr,_ioPageSize[drv_no]))!=0) return ret;
-		if((ret=__card_dataresponse(drv_no))!=0) {
-			if((ret2=__card_sendcmd(drv_no,0x0C,arg))!=0) return ret2;
-			if((ret2=__card_stopresponse(drv_no))!=0) return ret2;
-			return ret;
-		}
-		ptr += _ioPageSize[drv_no];
+	if((ret=__card_multidatawrite(drv_no,ptr,_ioPageSize[drv_no],num_sectors))!=0) {
+		if((ret2=__card_sendcmd(drv_no,0x0C,arg))!=0) return ret2;
+		if((ret2=__card_stopresponse(drv_no))!=0) return ret2;
+		return ret;
 	}
 
 	if((ret=__card_multiwritestop(drv_no))!=0) return ret;
@@ -79,11 +79,13 @@ typedef struct _alarm_st
 	void *cb_arg;
 } alarm_st;
 
-static lwp_objinfo sys_alarm_objects;
+lwp_objinfo sys_alarm_objects;
+
+u32 __attribute__((weak)) __lwp_max_watchdogs = LWP_UNLIMITED(LWP_MAX_WATCHDOGS);
 
 void __lwp_syswd_init()
 {
-	__lwp_objmgr_initinfo(&sys_alarm_objects,LWP_MAX_WATCHDOGS,sizeof(alarm_st));
+	__lwp_objmgr_initinfo(&sys_alarm_objects,__lwp_max_watchdogs,sizeof(alarm_st));
 }
 
 static __inline__ alarm_st* __lwp_syswd_open(syswd_t wd)
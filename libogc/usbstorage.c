@@ -100,10 +100,31 @@ distribution.
 
 #define DEVLIST_MAXSIZE    			8
 
+#define USBSTORAGE_ASYNC_DEPTH		8
+#define USBSTORAGE_WORKER_STACK		(16*1024)
+#define USBSTORAGE_WORKER_PRIO		80
+
+#define USBSTORAGE_RA_SLOTS			2
+#define USBSTORAGE_RA_SIZE			(32*1024)
+
+#define RA_IDLE						0
+#define RA_PENDING					1
+#define RA_READY					2
+
+typedef struct {
+	usbstorage_req req;
+	u8 *buf;
+	u64 sector;
+	u32 count;
+	u32 state;
+	bool stale;
+} usbstorage_ra;
+
 static heap_cntrl __heap;
 static bool __inited = false;
 static u64 usb_last_used = 0;
 static lwpq_t __usbstorage_waitq = 0;
+static lwpq_t __usbstorage_raq = 0;
 static u32 usbtimeout = USBSTORAGE_TIMEOUT;
 
 /*
@@ -118,8 +139,16 @@ static u16 __vid = 0;
 static u16 __pid = 0;
 static bool usb2_mode=true;
 
+// the read-ahead slots are shared by every caller of the DISC_INTERFACE; the
+// worker only moves a slot out of RA_PENDING, with interrupts disabled
+static usbstorage_ra __ra[USBSTORAGE_RA_SLOTS];
+static u64 __ra_next = ~0ULL;
+static mutex_t __ra_lock = LWP_MUTEX_NULL;
+
 static s32 __usbstorage_reset(usbstorage_handle *dev);
 static s32 __usbstorage_clearerrors(usbstorage_handle *dev, u8 lun);
+static void* __usbstorage_worker(void *arg);
+static void __usbstorage_rainvalidate(u64 sector, u64 n_sectors);
 s32 USBStorage_Inquiry(usbstorage_handle *dev, u8 lun);
 
 /* XXX: this is a *really* dirty and ugly way to send a bulkmessage with a timeout
@@ -210,6 +239,9 @@ s32 USBStorage_Initialize()
 	if(__inited)
 		return IPC_OK;
 
+	if(__ra_lock == LWP_MUTEX_NULL && LWP_MutexInit(&__ra_lock, false) != 0)
+		return IPC_ENOMEM;
+
 	_CPU_ISR_Disable(level);
 	if(!arena_ptr) {
 		arena_ptr = SYS_AllocArenaMem2Hi(HEAP_SIZE, 32);
@@ -221,6 +253,7 @@ s32 USBStorage_Initialize()
 	__lwp_heap_init(&__heap, arena_ptr, HEAP_SIZE, 32);
 	cbw_buffer=(u8*)__lwp_heap_allocate(&__heap, 32);
 	LWP_InitQueue(&__usbstorage_waitq);
+	LWP_InitQueue(&__usbstorage_raq);
 	__inited = true;
 	_CPU_ISR_Restore(level);
 	return IPC_OK;
@@ -414,10 +447,13 @@ s32 USBStorage_Open(usbstorage_handle *dev, s32 device_id, u16 vid, u16 pid)
 
 	memset(dev, 0, sizeof(*dev));
 	dev->usb_fd = -1;
+	dev->reqbox = MQ_BOX_NULL;
+	dev->worker = LWP_THREAD_NULL;
 
 	dev->tag = TAG_START;
 
-	if (LWP_MutexInit(&dev->lock, false) != 0)
+	// recursive: USBStorage_Read/Write hold it across the re-mount and the command
+	if (LWP_MutexInit(&dev->lock, true) != 0)
 		goto free_and_return;
 
 	if (SYS_CreateAlarm(&dev->alarm) != 0)
@@ -538,8 +574,15 @@ found:
 	if(!dev->buffer)
 		dev->buffer = __lwp_heap_allocate(&__heap, MAX_TRANSFER_SIZE_V5);
 
+	// the request queue lives as long as the handle, so submitters never race to create it
 	if(!dev->buffer) {
 		retval = IPC_ENOMEM;
+	} else if (MQ_Init(&dev->reqbox, USBSTORAGE_ASYNC_DEPTH) != 0) {
+		dev->reqbox = MQ_BOX_NULL;
+		retval = IPC_ENOMEM;
+	} else if (LWP_CreateThread(&dev->worker, __usbstorage_worker, dev, NULL, USBSTORAGE_WORKER_STACK, USBSTORAGE_WORKER_PRIO) != 0) {
+		dev->worker = LWP_THREAD_NULL;
+		retval = IPC_ENOMEM;
 	} else {
 		USB_DeviceRemovalNotifyAsync(dev->usb_fd,__usb_deviceremoved_cb,dev);
 		retval = USBSTORAGE_OK;
@@ -557,8 +600,33 @@ free_and_return:
 	return 0;
 }
 
+static void __usbstorage_stopworker(usbstorage_handle *dev)
+{
+	u32 i;
+
+	if (dev->worker != LWP_THREAD_NULL) {
+		MQ_Send(dev->reqbox, NULL, MQ_MSG_BLOCK);
+		LWP_JoinThread(dev->worker, NULL);
+		dev->worker = LWP_THREAD_NULL;
+	}
+	if (dev->reqbox != MQ_BOX_NULL) {
+		MQ_Close(dev->reqbox);
+		dev->reqbox = MQ_BOX_NULL;
+	}
+
+	if (dev == &__usbfd && __ra_lock != LWP_MUTEX_NULL) {
+		LWP_MutexLock(__ra_lock);
+		for (i = 0; i < USBSTORAGE_RA_SLOTS; i++)
+			__ra[i].state = RA_IDLE;
+		__ra_next = ~0ULL;
+		LWP_MutexUnlock(__ra_lock);
+	}
+}
+
 s32 USBStorage_Close(usbstorage_handle *dev)
 {
+	__usbstorage_stopworker(dev);
+
 	__mounted = false;
 	__lun = 0;
 	__vid = 0;
@@ -578,6 +646,8 @@ s32 USBStorage_Close(usbstorage_handle *dev)
 
 	memset(dev, 0, sizeof(*dev));
 	dev->usb_fd = -1;
+	dev->reqbox = MQ_BOX_NULL;
+	dev->worker = LWP_THREAD_NULL;
 	return 0;
 }
 
@@ -759,6 +829,8 @@ s32 USBStorage_Read(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors, u
 	if(lun >= dev->max_lun || dev->sector_size[lun] == 0)
 		return IPC_EINVAL;
 
+	LWP_MutexLock(dev->lock);
+
 	// more than 60s since last use - make sure drive is awake
 	if(ticks_to_secs(gettime() - usb_last_used) > 60)
 	{
@@ -795,6 +867,8 @@ s32 USBStorage_Read(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors, u
 	usb_last_used = gettime();
 	usbtimeout = USBSTORAGE_TIMEOUT;
 
+	LWP_MutexUnlock(dev->lock);
+
 	return retval;
 }
 
@@ -806,6 +880,8 @@ s32 USBStorage_Write(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors,
 	if(lun >= dev->max_lun || dev->sector_size[lun] == 0)
 		return IPC_EINVAL;
 
+	LWP_MutexLock(dev->lock);
+
 	// more than 60s since last use - make sure drive is awake
 	if(ticks_to_secs(gettime() - usb_last_used) > 60)
 	{
@@ -813,6 +889,10 @@ s32 USBStorage_Write(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors,
 		USBStorage_MountLUN(dev, lun);
 	}
 
+	// whichever path the write came by, read-ahead of these sectors is now stale
+	if(dev == &__usbfd && lun == __lun)
+		__usbstorage_rainvalidate(sector, n_sectors);
+
 	if(dev->n_sectors[lun] >= 0x100000000)
 	{
 		u8 cmd[16];
@@ -842,9 +922,104 @@ s32 USBStorage_Write(usbstorage_handle *dev, u8 lun, u64 sector, u32 n_sectors,
 	usb_last_used = gettime();
 	usbtimeout = USBSTORAGE_TIMEOUT;
 
+	LWP_MutexUnlock(dev->lock);
+
 	return retval;
 }
 
+/*
+Requests are queued per device and run in submission order by a worker
+thread, so a caller can consume one buffer while the next is being read.
+The queue and the worker are created by USBStorage_Open.
+*/
+static void* __usbstorage_worker(void *arg)
+{
+	usbstorage_handle *dev = (usbstorage_handle*)arg;
+	usbstorage_req *req;
+
+	while (MQ_Receive(dev->reqbox, (mqmsg_t*)&req, MQ_MSG_BLOCK)) {
+		if (!req)
+			break;
+
+		if (req->write)
+			req->result = USBStorage_Write(dev, req->lun, req->sector, req->n_sectors, req->buffer);
+		else
+			req->result = USBStorage_Read(dev, req->lun, req->sector, req->n_sectors, req->buffer);
+
+		if (req->cb)
+			req->cb(req->result, req);
+	}
+	return NULL;
+}
+
+static s32 __usbstorage_checkreq(usbstorage_handle *dev, usbstorage_req *req, u8 lun, u64 sector, u32 n_sectors, const u8 *buffer)
+{
+	if(!req || !buffer || n_sectors == 0)
+		return IPC_EINVAL;
+
+	if(lun >= dev->max_lun || dev->sector_size[lun] == 0 || dev->reqbox == MQ_BOX_NULL)
+		return IPC_EINVAL;
+
+	if(sector >= dev->n_sectors[lun] || n_sectors > (dev->n_sectors[lun] - sector))
+		return IPC_EINVAL;
+
+	// the transfer length is 32-bit, and READ(10)/WRITE(10) only carry a 16-bit count
+	if(n_sectors > (0xFFFFFFFF / dev->sector_size[lun]))
+		return IPC_EINVAL;
+	if(dev->n_sectors[lun] < 0x100000000 && n_sectors > 0xFFFF)
+		return IPC_EINVAL;
+
+	return USBSTORAGE_OK;
+}
+
+static s32 __usbstorage_submit(usbstorage_handle *dev, usbstorage_req *req)
+{
+	req->dev = dev;
+	req->result = USBSTORAGE_PROCESSING;
+	if (!MQ_Send(dev->reqbox, (mqmsg_t)req, MQ_MSG_BLOCK))
+		return IPC_EINVAL;
+
+	return USBSTORAGE_OK;
+}
+
+s32 USBStorage_ReadAsync(usbstorage_handle *dev, usbstorage_req *req, u8 lun, u64 sector, u32 n_sectors, u8 *buffer, usbstorage_callback cb, void *usrdata)
+{
+	s32 retval;
+
+	retval = __usbstorage_checkreq(dev, req, lun, sector, n_sectors, buffer);
+	if(retval < 0)
+		return retval;
+
+	req->lun = lun;
+	req->write = 0;
+	req->sector = sector;
+	req->n_sectors = n_sectors;
+	req->buffer = buffer;
+	req->cb = cb;
+	req->usrdata = usrdata;
+
+	return __usbstorage_submit(dev, req);
+}
+
+s32 USBStorage_WriteAsync(usbstorage_handle *dev, usbstorage_req *req, u8 lun, u64 sector, u32 n_sectors, const u8 *buffer, usbstorage_callback cb, void *usrdata)
+{
+	s32 retval;
+
+	retval = __usbstorage_checkreq(dev, req, lun, sector, n_sectors, buffer);
+	if(retval < 0)
+		return retval;
+
+	req->lun = lun;
+	req->write = 1;
+	req->sector = sector;
+	req->n_sectors = n_sectors;
+	req->buffer = (void*)buffer;
+	req->cb = cb;
+	req->usrdata = usrdata;
+
+	return __usbstorage_submit(dev, req);
+}
+
 s32 USBStorage_Suspend(usbstorage_handle *dev)
 {
 	if(dev->suspended == 1)
@@ -992,16 +1167,146 @@ static bool __usbstorage_IsInserted(DISC_INTERFACE *disc)
 	return __mounted;
 }
 
+static void __usbstorage_racb(s32 result, usbstorage_req *req)
+{
+	u32 level;
+	usbstorage_ra *ra = (usbstorage_ra*)req->usrdata;
+
+	_CPU_ISR_Disable(level);
+	ra->state = (result >= 0 && !ra->stale) ? RA_READY : RA_IDLE;
+	LWP_ThreadBroadcast(__usbstorage_raq);
+	_CPU_ISR_Restore(level);
+}
+
+static void __usbstorage_rawait(usbstorage_ra *ra)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	while (ra->state == RA_PENDING)
+		LWP_ThreadSleep(__usbstorage_raq);
+	_CPU_ISR_Restore(level);
+}
+
+static bool __usbstorage_rahit(sec_t sector, sec_t numSectors, void *buffer)
+{
+	u32 i;
+	usbstorage_ra *ra;
+
+	for (i = 0; i < USBSTORAGE_RA_SLOTS; i++) {
+		ra = &__ra[i];
+		if (ra->state == RA_IDLE)
+			continue;
+		if (sector < ra->sector || (sector + numSectors) > (ra->sector + ra->count))
+			continue;
+
+		__usbstorage_rawait(ra);
+		if (ra->state != RA_READY)
+			return false;
+
+		memcpy(buffer, ra->buf + (sector - ra->sector) * __usbfd.sector_size[__lun], numSectors * __usbfd.sector_size[__lun]);
+		return true;
+	}
+	return false;
+}
+
+// keeps the chunk following sector in flight, in whichever slot doesn't hold the current one
+static void __usbstorage_prefetch(sec_t sector, sec_t current)
+{
+	u32 i, count;
+	usbstorage_ra *ra, *slot = NULL;
+
+	for (i = 0; i < USBSTORAGE_RA_SLOTS; i++) {
+		ra = &__ra[i];
+		if (ra->state != RA_IDLE && sector >= ra->sector && sector < (ra->sector + ra->count))
+			sector = ra->sector + ra->count;
+	}
+	if (sector >= __usbfd.n_sectors[__lun])
+		return;
+
+	for (i = 0; i < USBSTORAGE_RA_SLOTS; i++) {
+		ra = &__ra[i];
+		if (ra->state == RA_PENDING)
+			continue;
+		if (ra->state == RA_READY && current >= ra->sector && current < (ra->sector + ra->count))
+			continue;
+		slot = ra;
+		if (ra->state == RA_IDLE)
+			break;
+	}
+	if (!slot)
+		return;
+
+	if (!slot->buf) {
+		slot->buf = memalign(32, USBSTORAGE_RA_SIZE);
+		if (!slot->buf)
+			return;
+	}
+
+	count = USBSTORAGE_RA_SIZE / __usbfd.sector_size[__lun];
+	if ((sector + count) > __usbfd.n_sectors[__lun])
+		count = __usbfd.n_sectors[__lun] - sector;
+
+	slot->stale = false;
+	slot->sector = sector;
+	slot->count = count;
+	slot->state = RA_PENDING;
+	if (USBStorage_ReadAsync(&__usbfd, &slot->req, __lun, sector, count, slot->buf, __usbstorage_racb, slot) < 0)
+		slot->state = RA_IDLE;
+}
+
+// run by every write to the mounted LUN under dev->lock, the worker's included,
+// so it cannot wait for a slot in flight: that read may have run before the
+// write, the slot is only marked and its completion drops it
+static void __usbstorage_rainvalidate(u64 sector, u64 n_sectors)
+{
+	u32 i, level;
+	usbstorage_ra *ra;
+
+	_CPU_ISR_Disable(level);
+	for (i = 0; i < USBSTORAGE_RA_SLOTS; i++) {
+		ra = &__ra[i];
+		if (ra->state == RA_IDLE)
+			continue;
+		if (sector >= (ra->sector + ra->count))
+			continue;
+		if (sector < ra->sector && (ra->sector - sector) >= n_sectors)
+			continue;
+
+		if (ra->state == RA_PENDING)
+			ra->stale = true;
+		else
+			ra->state = RA_IDLE;
+	}
+	_CPU_ISR_Restore(level);
+}
+
 static bool __usbstorage_ReadSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, void *buffer)
 {
 	s32 retval;
+	bool sequential;
 
 	if (!__mounted)
 		return false;
 
-	retval = USBStorage_Read(&__usbfd, __lun, sector, numSectors, buffer);
+	LWP_MutexLock(__ra_lock);
 
-	return retval >= 0;
+	sequential = (sector == __ra_next) && (numSectors * __usbfd.sector_size[__lun]) < USBSTORAGE_RA_SIZE;
+	__ra_next = sector + numSectors;
+
+	if (!__usbstorage_rahit(sector, numSectors, buffer)) {
+		retval = USBStorage_Read(&__usbfd, __lun, sector, numSectors, buffer);
+		if (retval < 0) {
+			LWP_MutexUnlock(__ra_lock);
+			return false;
+		}
+	}
+
+	if (sequential)
+		__usbstorage_prefetch(sector + numSectors, sector);
+
+	LWP_MutexUnlock(__ra_lock);
+	return true;
 }
 
 static bool __usbstorage_WriteSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, const void *buffer)
@@ -1011,7 +1316,11 @@ static bool __usbstorage_WriteSectors(DISC_INTERFACE *disc, sec_t sector, sec_t
 	if (!__mounted)
 		return false;
 
+	// USBStorage_Write drops the read-ahead it overlaps; a write also ends the sequential run
+	LWP_MutexLock(__ra_lock);
+	__ra_next = ~0ULL;
 	retval = USBStorage_Write(&__usbfd, __lun, sector, numSectors, buffer);
+	LWP_MutexUnlock(__ra_lock);
 
 	return retval >= 0;
 }
@@ -1038,6 +1347,11 @@ void USBStorage_Deinitialize()
 {
 	__usbstorage_Shutdown(&__io_usbstorage);
 	LWP_CloseQueue(__usbstorage_waitq);
+	LWP_CloseQueue(__usbstorage_raq);
+	if (__ra_lock != LWP_MUTEX_NULL) {
+		LWP_MutexDestroy(__ra_lock);
+		__ra_lock = LWP_MUTEX_NULL;
+	}
 	__inited = false;
 }
 
@@ -1058,7 +1372,12 @@ int USBStorage_ioctl(int request, ...)
             u8 write;
             raw_device_command *rdc = va_arg(ap, raw_device_command *);
 		    write = (rdc->flags == B_RAW_DEVICE_DATA_IN) ? 0 : 1;
+            // a raw command may write anywhere on the LUN
+            LWP_MutexLock(__usbfd.lock);
+            if (write)
+                __usbstorage_rainvalidate(0, ~0ULL);
             retval = __cycle(&__usbfd, __lun, rdc->data, rdc->data_length, rdc->command, rdc->command_length, write, &rdc->scsi_status, NULL);
+            LWP_MutexUnlock(__usbfd.lock);
             break;
         }
 
@@ -41,6 +41,7 @@
 #include <time.h>
 #include <gcutil.h>
 #include <ogc/ipc.h>
+#include <ogc/lwp.h>
 #include <ogc/system.h>
 #include <unistd.h>
 #include <ogc/disc_io.h>
@@ -63,6 +64,14 @@
 
 #define SDIO_DEFAULT_TIMEOUT		0xe
 
+#define SDIO_QUEUE_DEPTH			2
+
+#define SDIO_STATE_IDLE				0
+#define SDIO_STATE_SYNC				1
+#define SDIO_STATE_SELECT			2
+#define SDIO_STATE_ACTIVE			3
+#define SDIO_STATE_DESELECT			4
+
 #define IOCTL_SDIO_WRITEHCREG		0x01
 #define IOCTL_SDIO_READHCREG		0x02
 #define IOCTL_SDIO_READCREG			0x03
@@ -149,6 +158,14 @@ struct _sdioresponse
 	u32 acmd12_response;
 };
 
+struct _sdioslot
+{
+	struct _sdiorequest request ATTRIBUTE_ALIGN(32);
+	struct _sdioresponse response ATTRIBUTE_ALIGN(32);
+	ioctlv iovec[3] ATTRIBUTE_ALIGN(32);
+	sdio_request *req;
+};
+
 static s32 __sd0_fd = -1;
 static u16 __sd0_rca = 0;
 static s32 __sd0_initialized = 0;
@@ -159,6 +176,14 @@ static u8 __sd0_functions[64] ATTRIBUTE_ALIGN(32);
 
 static bool __sdio_initialized = false;
 
+static u32 __sdio_state = SDIO_STATE_IDLE;
+static u32 __sdio_inflight = 0;
+static sdio_request *__sdio_qhead = NULL;
+static sdio_request *__sdio_qtail = NULL;
+static sdio_request *__sdio_qissue = NULL;
+static lwpq_t __sdio_idleq = LWP_TQUEUE_NULL;
+static struct _sdioslot __sdio_slots[SDIO_QUEUE_DEPTH] ATTRIBUTE_ALIGN(32);
+
 static char _sd0_fs[] ATTRIBUTE_ALIGN(32) = "/dev/sdio/slot0";
 
 static s32 __sdio_sendcommand(u32 cmd,u32 cmd_type,u32 rsp_type,u32 arg,u32 blk_cnt,u32 blk_size,void *buffer,void *reply,u32 rlen)
@@ -196,6 +221,32 @@ static s32 __sdio_sendcommand(u32 cmd,u32 cmd_type,u32 rsp_type,u32 arg,u32 blk_
 	return ret;
 }
 
+static s32 __sdio_sendcommandasync(struct _sdioslot *slot,u32 cmd,u32 cmd_type,u32 rsp_type,u32 arg,u32 blk_cnt,u32 blk_size,void *buffer,ipccallback cb)
+{
+	struct _sdiorequest *request = &slot->request;
+
+	request->cmd = cmd;
+	request->cmd_type = cmd_type;
+	request->rsp_type = rsp_type;
+	request->arg = arg;
+	request->blk_cnt = blk_cnt;
+	request->blk_size = blk_size;
+	request->dma_addr = buffer;
+	request->isdma = ((buffer!=NULL)?1:0);
+	request->pad0 = 0;
+
+	if(request->isdma || __sd0_sdhc == 1) {
+		slot->iovec[0].data = request;
+		slot->iovec[0].len = sizeof(struct _sdiorequest);
+		slot->iovec[1].data = buffer;
+		slot->iovec[1].len = (blk_size*blk_cnt);
+		slot->iovec[2].data = &slot->response;
+		slot->iovec[2].len = sizeof(struct _sdioresponse);
+		return IOS_IoctlvAsync(__sd0_fd,IOCTL_SDIO_SENDCMD,2,1,slot->iovec,cb,slot);
+	}
+	return IOS_IoctlAsync(__sd0_fd,IOCTL_SDIO_SENDCMD,request,sizeof(struct _sdiorequest),&slot->response,sizeof(struct _sdioresponse),cb,slot);
+}
+
 static s32 __sdio_setclock(u32 set)
 {
 	s32 ret;
@@ -359,6 +410,228 @@ static s32 __sd0_deselect()
 	return ret;
 }
 
+/*
+ * Queued requests are run entirely from IPC callbacks: the card is selected
+ * once, up to SDIO_QUEUE_DEPTH data commands are kept queued in IOS so the
+ * next one starts as soon as the previous completes, and the card is only
+ * deselected once the queue drains. The synchronous paths take the bus by
+ * setting SDIO_STATE_SYNC while the queue is idle.
+ */
+static s32 __sdio_selectcb(s32 result,void *usrdata);
+static s32 __sdio_deselectcb(s32 result,void *usrdata);
+static s32 __sdio_datacb(s32 result,void *usrdata);
+
+static void __sdio_complete(sdio_request *req)
+{
+	sdio_request *prev = NULL,*curr = __sdio_qhead;
+
+	while(curr && curr!=req) {
+		prev = curr;
+		curr = curr->next;
+	}
+	if(!curr) return;
+
+	if(prev) prev->next = req->next;
+	else __sdio_qhead = req->next;
+	if(__sdio_qtail==req) __sdio_qtail = prev;
+	req->next = NULL;
+
+	if(req->cb) req->cb(req->result,req);
+}
+
+static void __sdio_issued(sdio_request *req)
+{
+	if(__sdio_qissue==req) __sdio_qissue = req->next;
+}
+
+static void __sdio_failall(s32 result)
+{
+	sdio_request *req;
+
+	while((req=__sdio_qhead)!=NULL) {
+		req->result = result;
+		__sdio_complete(req);
+	}
+	__sdio_qissue = NULL;
+}
+
+static void __sdio_idle()
+{
+	__sdio_state = SDIO_STATE_IDLE;
+	LWP_ThreadBroadcast(__sdio_idleq);
+}
+
+static void __sdio_startqueue()
+{
+	s32 ret;
+
+	__sdio_state = SDIO_STATE_SELECT;
+	ret = __sdio_sendcommandasync(&__sdio_slots[0],SDIO_CMD_SELECT,SDIOCMD_TYPE_AC,SDIO_RESPONSE_R1B,(__sd0_rca<<16),0,0,NULL,__sdio_selectcb);
+	if(ret<0) {
+		__sdio_failall(ret);
+		__sdio_idle();
+	}
+}
+
+static void __sdio_pump()
+{
+	s32 ret;
+	u32 i,cnt,sec;
+	sdio_request *req;
+	sdio_segment *seg;
+	struct _sdioslot *slot;
+
+	while(__sdio_inflight<SDIO_QUEUE_DEPTH && (req=__sdio_qissue)!=NULL) {
+		seg = &req->segs[req->seg];
+
+		cnt = (seg->numSectors-req->pos);
+		if(cnt>0xffff) cnt = 0xffff;
+
+		if(__sd0_sdhc == 0) sec = ((req->sector+req->done)*PAGE_SIZE512);
+		else sec = (req->sector+req->done);
+
+		for(i=0;i<SDIO_QUEUE_DEPTH;i++) {
+			if(!__sdio_slots[i].req) break;
+		}
+		slot = &__sdio_slots[i];
+
+		ret = __sdio_sendcommandasync(slot,(req->write?SDIO_CMD_WRITEMULTIBLOCK:SDIO_CMD_READMULTIBLOCK),SDIOCMD_TYPE_AC,SDIO_RESPONSE_R1,sec,cnt,PAGE_SIZE512,(u8*)seg->buffer+(req->pos*PAGE_SIZE512),__sdio_datacb);
+		if(ret<0) {
+			req->result = ret;
+			__sdio_issued(req);
+			if(!req->pending) __sdio_complete(req);
+			continue;
+		}
+
+		slot->req = req;
+		req->pending++;
+		__sdio_inflight++;
+
+		req->pos += cnt;
+		req->done += cnt;
+		if(req->pos==seg->numSectors) {
+			req->pos = 0;
+			if(++req->seg==req->numSegs) __sdio_issued(req);
+		}
+	}
+
+	if(!__sdio_inflight && !__sdio_qhead) {
+		__sdio_state = SDIO_STATE_DESELECT;
+		ret = __sdio_sendcommandasync(&__sdio_slots[0],SDIO_CMD_DESELECT,SDIOCMD_TYPE_AC,SDIO_RESPONSE_R1B,0,0,0,NULL,__sdio_deselectcb);
+		if(ret<0) __sdio_idle();
+	}
+}
+
+static s32 __sdio_selectcb(s32 result,void *usrdata)
+{
+	if(result<0) {
+		__sdio_failall(result);
+		__sdio_idle();
+		return 0;
+	}
+
+	__sdio_state = SDIO_STATE_ACTIVE;
+	__sdio_pump();
+	return 0;
+}
+
+static s32 __sdio_deselectcb(s32 result,void *usrdata)
+{
+	if(__sdio_qhead) {
+		__sdio_qissue = __sdio_qhead;
+		__sdio_startqueue();
+		return 0;
+	}
+
+	__sdio_idle();
+	return 0;
+}
+
+static s32 __sdio_datacb(s32 result,void *usrdata)
+{
+	struct _sdioslot *slot = (struct _sdioslot*)usrdata;
+	sdio_request *req = slot->req;
+
+	slot->req = NULL;
+	__sdio_inflight--;
+
+	if(result<0 && req->result>=0) {
+		req->result = result;
+		__sdio_issued(req);
+	}
+	if(--req->pending==0 && (req->seg==req->numSegs || req->result<0)) __sdio_complete(req);
+
+	__sdio_pump();
+	return 0;
+}
+
+static void __sdio_lock()
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	while(__sdio_state!=SDIO_STATE_IDLE) {
+		LWP_ThreadSleep(__sdio_idleq);
+	}
+	__sdio_state = SDIO_STATE_SYNC;
+	_CPU_ISR_Restore(level);
+}
+
+static void __sdio_unlock()
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(__sdio_qhead) {
+		__sdio_qissue = __sdio_qhead;
+		__sdio_startqueue();
+	} else
+		__sdio_idle();
+	_CPU_ISR_Restore(level);
+}
+
+static s32 __sdio_submit(sdio_request *req,bool write,sec_t sector,sdio_segment *segs,u32 numSegs,sdio_callback cb,void *usrdata)
+{
+	u32 i,level;
+	sec_t numSectors = 0;
+
+	if(!req || !segs || !numSegs) return IPC_EINVAL;
+	if(!__sdio_initialized) return IPC_ENOENT;
+	if(!(__io_wiisd.features & (write?FEATURE_MEDIUM_CANWRITE:FEATURE_MEDIUM_CANREAD))) return IPC_EINVAL;
+
+	for(i=0;i<numSegs;i++) {
+		if(!segs[i].numSectors) return IPC_EINVAL;
+		if(!SYS_IsDMAAddress(segs[i].buffer, 1)) return IPC_EINVAL;
+		numSectors += segs[i].numSectors;
+	}
+	if((sector + numSectors) < sector) return IPC_EINVAL;
+	if((sector + numSectors) > __io_wiisd.numberOfSectors) return IPC_EINVAL;
+
+	req->next = NULL;
+	req->segs = segs;
+	req->numSegs = numSegs;
+	req->sector = sector;
+	req->write = write;
+	req->result = 0;
+	req->cb = cb;
+	req->usrdata = usrdata;
+	req->seg = 0;
+	req->pos = 0;
+	req->done = 0;
+	req->pending = 0;
+
+	_CPU_ISR_Disable(level);
+	if(__sdio_qtail) __sdio_qtail->next = req;
+	else __sdio_qhead = req;
+	__sdio_qtail = req;
+	if(!__sdio_qissue) __sdio_qissue = req;
+
+	if(__sdio_state==SDIO_STATE_IDLE) __sdio_startqueue();
+	else if(__sdio_state==SDIO_STATE_ACTIVE) __sdio_pump();
+	_CPU_ISR_Restore(level);
+	return 0;
+}
+
 static s32 __sd0_setblocklength(u32 blk_len)
 {
 	s32 ret;
@@ -575,11 +848,25 @@ static bool __sd0_initio(DISC_INTERFACE *disc)
 
 bool sdio_Deinitialize()
 {
+	u32 level;
+	bool locked = __sdio_initialized;
+
+	if(locked) {
+		__sdio_lock();
+
+		// requests queued behind the lock would never be started on a closed handle
+		_CPU_ISR_Disable(level);
+		__sdio_initialized = false;
+		__sdio_failall(IPC_ENOENT);
+		_CPU_ISR_Restore(level);
+	}
+
 	if(__sd0_fd>=0)
 		IOS_Close(__sd0_fd);
 
 	__sd0_fd = -1;
 	__sd0_initialized = 0;
+	if(locked) __sdio_idle();
 	return true;
 }
 
@@ -587,6 +874,7 @@ bool sdio_Startup(DISC_INTERFACE *disc)
 {
 	if(disc->ioType != DEVICE_TYPE_WII_SD) return false;
 	if(__sdio_initialized) return true;
+	if(__sdio_idleq==LWP_TQUEUE_NULL) LWP_InitQueue(&__sdio_idleq);
 
 	__sd0_fd = IOS_Open(_sd0_fs,1);
 
@@ -626,11 +914,15 @@ bool sdio_ReadSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, void
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != PAGE_SIZE512) return false;
-	if(!SYS_IsDMAAddress(buffer, 1)) return false;
+	if(!SYS_IsDMAAddress(buffer, 1)) return disc_bounceReadSectors(disc, sector, numSectors, buffer, 1, sdio_ReadSectors);
 	if(!__sdio_initialized) return false;
 
+	__sdio_lock();
 	ret = __sd0_select();
-	if(ret<0) return false;
+	if(ret<0) {
+		__sdio_unlock();
+		return false;
+	}
 
 	while(numSectors>0) {
 		if(__sd0_sdhc == 0) sec = (sector*PAGE_SIZE512);
@@ -648,6 +940,7 @@ bool sdio_ReadSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, void
 	}
 
 	__sd0_deselect();
+	__sdio_unlock();
 	return (ret>=0);
 }
 
@@ -663,11 +956,15 @@ bool sdio_WriteSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, con
 	if((sector + numSectors) < sector) return false;
 	if((sector + numSectors) > disc->numberOfSectors) return false;
 	if(disc->bytesPerSector != PAGE_SIZE512) return false;
-	if(!SYS_IsDMAAddress(buffer, 1)) return false;
+	if(!SYS_IsDMAAddress(buffer, 1)) return disc_bounceWriteSectors(disc, sector, numSectors, buffer, 1, sdio_WriteSectors);
 	if(!__sdio_initialized) return false;
 
+	__sdio_lock();
 	ret = __sd0_select();
-	if(ret<0) return false;
+	if(ret<0) {
+		__sdio_unlock();
+		return false;
+	}
 
 	while(numSectors>0) {
 		if(__sd0_sdhc == 0) sec = (sector*PAGE_SIZE512);
@@ -685,9 +982,20 @@ bool sdio_WriteSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors, con
 	}
 
 	__sd0_deselect();
+	__sdio_unlock();
 	return (ret>=0);
 }
 
+s32 sdio_ReadAsync(sdio_request *req, sec_t sector, sdio_segment *segs, u32 numSegs, sdio_callback cb, void *usrdata)
+{
+	return __sdio_submit(req, false, sector, segs, numSegs, cb, usrdata);
+}
+
+s32 sdio_WriteAsync(sdio_request *req, sec_t sector, sdio_segment *segs, u32 numSegs, sdio_callback cb, void *usrdata)
+{
+	return __sdio_submit(req, true, sector, segs, numSegs, cb, usrdata);
+}
+
 bool sdio_EraseSectors(DISC_INTERFACE *disc, sec_t sector, sec_t numSectors)
 {
 	return false;
@@ -0,0 +1,431 @@
+/*-------------------------------------------------------------
+
+adpcmtest.c -- host model of AESND ADPCM stream buffer playback
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Plays DSP-ADPCM voices through a model of the AESND stream buffer and
+ * checks the result against a straight dspadpcm_decode() of the same data.
+ *
+ * The model mirrors, step for step:
+ *   - __aesndhandlerequest/__aesndfillbuffer/__aesndsetloopcontext (aesndlib.c)
+ *   - setup_accl, the mixer's per block PB writeback and exception5 (dspmixer.s)
+ *   - the accelerator in ACFMT 0, with the frame header read either before the
+ *     nibble is decoded or right after the address increments, since the two
+ *     readings of the hardware differ and the microcode must work with both.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dspadpcm.h"
+
+#define DSP_STREAMBUFFER_SIZE	1152
+#define RING_ADDR				0x00040000		// byte address of the voice stream buffer
+
+#define VOICE_LOOP				0x0010
+#define VOICE_ONCE				0x0020
+#define VOICE_STREAM			0x0040
+#define VOICE_ADPCM				0x0080
+#define VOICE_LOOPCTX			0x0100
+#define VOICE_SOURCE			0x0200
+#define VOICE_STOPPED			0x1000
+
+enum {
+	HEADER_BEFORE_DECODE,
+	HEADER_AFTER_INCREMENT
+};
+
+typedef struct _modelpb {
+	uint32_t buf_start,buf_end,buf_curr;
+	int16_t yn1,yn2;
+	uint16_t pds;
+	uint32_t flags;
+	uint16_t loop_pds;
+	int16_t loop_yn1,loop_yn2;
+	uint16_t ring_pds;
+	uint32_t loop_start,loop_end;
+	int16_t coefs[16];
+
+	const uint8_t *data;
+	uint32_t mram_start,mram_curr,mram_end;
+	uint32_t stream_last;
+} modelpb;
+
+typedef struct _accel {
+	uint32_t sa,ea,ca;
+	uint16_t pds;
+	dspadpcm_hist hist;
+	int timing;
+} accel;
+
+static uint8_t ring[DSP_STREAMBUFFER_SIZE*2];
+static int ring_pds_enabled = 1;
+
+static uint8_t __ringbyte(uint32_t nibble_addr)
+{
+	return ring[(nibble_addr>>1) - RING_ADDR];
+}
+
+static uint32_t __bufaddr(uint32_t addr) { return (addr<<1); }
+static uint32_t __bufstart(uint32_t addr) { return (addr<<1) + 2; }
+
+/* aesndlib.c */
+
+static void __setloopcontext(modelpb *pb,uint32_t buf_addr,uint32_t buffer)
+{
+	if((pb->flags&(VOICE_ADPCM|VOICE_LOOP|VOICE_STREAM))!=(VOICE_ADPCM|VOICE_LOOP)) return;
+	if((pb->flags&VOICE_SOURCE) || pb->mram_curr!=pb->mram_start) return;
+
+	pb->loop_start = __bufstart(buf_addr);
+	pb->loop_end = buffer ? (__bufaddr(buf_addr) - 1) : pb->buf_end;
+	pb->flags |= VOICE_LOOPCTX;
+}
+
+static uint32_t __readsource(modelpb *pb,uint8_t *buffer,uint32_t len)
+{
+	uint32_t copy_len = pb->mram_end - pb->mram_curr;
+
+	if(copy_len>len) copy_len = len;
+	memcpy(buffer,pb->data + pb->mram_curr,copy_len);
+	pb->mram_curr += copy_len;
+	return copy_len;
+}
+
+static void __fillbuffer(modelpb *pb,uint32_t buffer)
+{
+	uint32_t buf_addr = RING_ADDR;
+	uint8_t *ptr = ring;
+	uint32_t copy_len;
+
+	if(buffer) {
+		buf_addr += DSP_STREAMBUFFER_SIZE;
+		ptr += DSP_STREAMBUFFER_SIZE;
+	}
+
+	__setloopcontext(pb,buf_addr,buffer);
+
+	copy_len = __readsource(pb,ptr,DSP_STREAMBUFFER_SIZE);
+	if(copy_len<DSP_STREAMBUFFER_SIZE) memset(ptr + copy_len,0,DSP_STREAMBUFFER_SIZE - copy_len);
+	if(!buffer) pb->ring_pds = ptr[0];
+}
+
+static void __handlerequest(modelpb *pb)
+{
+	uint32_t copy_len;
+
+	if(pb->mram_curr>=pb->mram_end) {
+		if(pb->flags&VOICE_ONCE) {
+			pb->buf_start = 0;
+			pb->flags |= VOICE_STOPPED;
+			return;
+		} else if(pb->flags&(VOICE_LOOP|VOICE_SOURCE)) pb->mram_curr = pb->mram_start;
+	}
+
+	if(pb->buf_start) {
+		uint32_t curr_pos = pb->buf_curr;
+		if(curr_pos<pb->stream_last)
+			__fillbuffer(pb,1);
+		if(curr_pos>=(pb->buf_start + __bufaddr(DSP_STREAMBUFFER_SIZE)) &&
+		   pb->stream_last<(pb->buf_start + __bufaddr(DSP_STREAMBUFFER_SIZE)))
+			__fillbuffer(pb,0);
+
+		pb->stream_last = curr_pos;
+		return;
+	}
+
+	pb->buf_start = __bufstart(RING_ADDR);
+	pb->buf_end = __bufaddr(RING_ADDR + (DSP_STREAMBUFFER_SIZE*2)) - 1;
+	pb->buf_curr = pb->buf_start;
+
+	copy_len = __readsource(pb,ring,(DSP_STREAMBUFFER_SIZE*2));
+	if(copy_len<(DSP_STREAMBUFFER_SIZE*2)) memset(ring + copy_len,0,(DSP_STREAMBUFFER_SIZE*2) - copy_len);
+	pb->pds = pb->ring_pds = ring[0];
+}
+
+/* dspmixer.s */
+
+static void __exception5(modelpb *pb,accel *acc)
+{
+	if(pb->flags&VOICE_LOOPCTX) {
+		if((acc->sa&0xffff)==(pb->loop_start&0xffff)) {
+			acc->hist.yn1 = pb->loop_yn1;
+			acc->hist.yn2 = pb->loop_yn2;
+			acc->pds = pb->loop_pds;
+			acc->sa = pb->buf_start;
+			acc->ea = pb->buf_end;
+			pb->flags &= ~VOICE_LOOPCTX;
+			return;
+		}
+		acc->sa = pb->loop_start;
+		acc->ea = pb->loop_end;
+	}
+	if(ring_pds_enabled) acc->pds = pb->ring_pds;
+}
+
+static void __setupaccl(modelpb *pb,accel *acc)
+{
+	acc->sa = pb->buf_start;
+	acc->ea = pb->buf_end;
+	acc->ca = pb->buf_curr;
+	acc->pds = pb->pds;
+	acc->hist.yn1 = pb->yn1;
+	acc->hist.yn2 = pb->yn2;
+
+	if((pb->flags&VOICE_LOOPCTX) && acc->ca<pb->loop_start) {
+		acc->sa = pb->loop_start;
+		acc->ea = pb->loop_end;
+	}
+}
+
+static void __mixerend(modelpb *pb,accel *acc)
+{
+	pb->pds = acc->pds;
+	pb->yn1 = acc->hist.yn1;
+	pb->yn2 = acc->hist.yn2;
+	pb->buf_curr = acc->ca;
+}
+
+/* accelerator, ACFMT 0 */
+
+static int16_t __accelread(modelpb *pb,accel *acc)
+{
+	uint8_t byte;
+	int16_t val;
+
+	if(acc->timing==HEADER_BEFORE_DECODE && (acc->ca&15)==0) {
+		acc->pds = __ringbyte(acc->ca);
+		acc->ca += 2;
+	}
+
+	byte = __ringbyte(acc->ca);
+	val = dspadpcm_decodenibble(pb->coefs,(uint8_t)acc->pds,(acc->ca&1) ? (byte&0x0f) : (byte>>4),&acc->hist);
+
+	if(acc->ca==acc->ea) {
+		acc->ca = acc->sa;
+		__exception5(pb,acc);
+	} else
+		acc->ca++;
+
+	if(acc->timing==HEADER_AFTER_INCREMENT && (acc->ca&15)==0) {
+		acc->pds = __ringbyte(acc->ca);
+		acc->ca += 2;
+	}
+	return val;
+}
+
+/* reference: the byte stream the fills hand the DSP, decoded without the ring */
+
+static uint32_t __reference(const uint8_t *data,uint32_t len,uint32_t flags,const modelpb *ctx,int16_t *out,uint32_t samples)
+{
+	static uint8_t chunk[DSP_STREAMBUFFER_SIZE*2];
+	dspadpcm_hist hist = {0,0};
+	uint32_t off = 0,produced = 0;
+	uint32_t chunk_len = DSP_STREAMBUFFER_SIZE*2;
+	int first = 1;
+
+	while(produced<samples) {
+		uint32_t copy_len,frames,i;
+
+		if(off>=len) {
+			if(flags&VOICE_ONCE) break;
+			off = 0;
+		}
+		if(off==0 && !first && (flags&(VOICE_LOOP|VOICE_SOURCE))==VOICE_LOOP) {
+			hist.yn1 = ctx->loop_yn1;
+			hist.yn2 = ctx->loop_yn2;
+		}
+
+		copy_len = len - off;
+		if(copy_len>chunk_len) copy_len = chunk_len;
+		memset(chunk,0,chunk_len);
+		memcpy(chunk,data + off,copy_len);
+		off += copy_len;
+
+		frames = chunk_len/DSPADPCM_FRAME_BYTES;
+		for(i=0;i<frames && produced<samples;i++) {
+			uint32_t n = samples - produced;
+			if(n>DSPADPCM_FRAME_SAMPLES) n = DSPADPCM_FRAME_SAMPLES;
+			dspadpcm_decode(ctx->coefs,chunk + i*DSPADPCM_FRAME_BYTES,out + produced,n,&hist);
+			produced += n;
+		}
+
+		first = 0;
+		chunk_len = DSP_STREAMBUFFER_SIZE;
+	}
+	return produced;
+}
+
+static uint32_t __rand_state = 1;
+static uint32_t __rand(void)
+{
+	__rand_state = __rand_state*1103515245 + 12345;
+	return (__rand_state>>16)&0x7fff;
+}
+
+static uint32_t __play(const uint8_t *data,uint32_t len,uint32_t flags,const modelpb *ctx,int timing,int16_t *out,uint32_t samples)
+{
+	modelpb pb = *ctx;
+	accel acc;
+	uint32_t produced = 0;
+
+	pb.data = data;
+	pb.mram_start = pb.mram_curr = 0;
+	pb.mram_end = len;
+	pb.flags = flags|VOICE_ADPCM;
+	pb.buf_start = pb.buf_curr = pb.buf_end = pb.stream_last = 0;
+	pb.pds = pb.ring_pds = 0;
+	pb.yn1 = pb.yn2 = 0;
+
+	memset(&acc,0,sizeof(acc));
+	acc.timing = timing;
+
+	__handlerequest(&pb);
+	while(produced<samples && !(pb.flags&VOICE_STOPPED)) {
+		// 2ms blocks: 96 output samples at up to 3x the mixing rate
+		uint32_t reads = 32 + (__rand()%257);
+		uint32_t i;
+
+		__setupaccl(&pb,&acc);
+		for(i=0;i<reads && produced<samples;i++)
+			out[produced++] = __accelread(&pb,&acc);
+		__mixerend(&pb,&acc);
+
+		__handlerequest(&pb);
+	}
+	return produced;
+}
+
+static int __runcase(const char *name,const uint8_t *data,uint32_t len,uint32_t flags,const modelpb *ctx,uint32_t samples)
+{
+	int16_t *ref = malloc(samples*sizeof(int16_t));
+	int16_t *out = malloc(samples*sizeof(int16_t));
+	int timing,failed = 0;
+
+	for(timing=HEADER_BEFORE_DECODE;timing<=HEADER_AFTER_INCREMENT;timing++) {
+		uint32_t nref,nout,i;
+
+		__rand_state = 1;
+		nref = __reference(data,len,flags,ctx,ref,samples);
+		nout = __play(data,len,flags,ctx,timing,out,samples);
+
+		// a ONCE voice stops as soon as its data has been queued, so only its prefix is compared
+		if(nout>nref) nout = nref;
+		for(i=0;i<nout;i++) {
+			if(out[i]!=ref[i]) break;
+		}
+		printf("%-32s %-16s %8u samples: ",name,timing==HEADER_BEFORE_DECODE ? "header/decode" : "header/increment",nout);
+		if(i<nout || (nout<nref && !(flags&VOICE_ONCE))) {
+			if(i<nout) printf("FAIL at %u (%d != %d)\n",i,out[i],ref[i]);
+			else printf("FAIL short (%u of %u)\n",nout,nref);
+			failed = 1;
+		} else
+			printf("ok\n");
+	}
+
+	free(ref);
+	free(out);
+	return failed;
+}
+
+static uint32_t __makesample(int16_t *pcm,uint32_t samples,double freq)
+{
+	uint32_t i;
+
+	for(i=0;i<samples;i++)
+		pcm[i] = (int16_t)(12000.0*sin(2.0*M_PI*freq*i/48000.0) + 6000.0*sin(2.0*M_PI*freq*2.71*i/48000.0));
+	return samples;
+}
+
+int main(void)
+{
+	static int16_t pcm[48000*2];
+	static int16_t recon[48000*2];
+	static int16_t dec[48000*2];
+	static uint8_t adpcm[48000];
+	static const uint32_t lengths[] = {
+		DSP_STREAMBUFFER_SIZE/2,
+		DSP_STREAMBUFFER_SIZE,
+		DSP_STREAMBUFFER_SIZE*2,
+		DSP_STREAMBUFFER_SIZE*3,
+		DSP_STREAMBUFFER_SIZE*5 + 136,
+		DSP_STREAMBUFFER_SIZE*7 + 8
+	};
+	modelpb ctx;
+	dspadpcm_hist hist;
+	double err = 0.0,sig = 0.0;
+	uint32_t i,bytes,samples;
+	int failed = 0;
+
+	/* codec: the encoder's reconstruction is what the decoder produces */
+	samples = __makesample(pcm,(sizeof(adpcm)/DSPADPCM_FRAME_BYTES)*DSPADPCM_FRAME_SAMPLES,440.0);
+	hist.yn1 = hist.yn2 = 0;
+	bytes = dspadpcm_encode(dspadpcm_defcoefs,pcm,adpcm,samples,&hist,recon);
+	hist.yn1 = hist.yn2 = 0;
+	dspadpcm_decode(dspadpcm_defcoefs,adpcm,dec,samples,&hist);
+	for(i=0;i<samples;i++) {
+		if(dec[i]!=recon[i]) break;
+		err += (double)(pcm[i] - dec[i])*(pcm[i] - dec[i]);
+		sig += (double)pcm[i]*pcm[i];
+	}
+	printf("%-32s %u bytes, SNR %.1f dB: %s\n","encode/decode",bytes,10.0*log10(sig/(err + 1.0)),(i==samples && sig>err*1000.0) ? "ok" : "FAIL");
+	if(i<samples || sig<=err*1000.0) failed = 1;
+
+	memset(&ctx,0,sizeof(ctx));
+	memcpy(ctx.coefs,dspadpcm_defcoefs,sizeof(ctx.coefs));
+
+	for(i=0;i<sizeof(lengths)/sizeof(lengths[0]);i++) {
+		uint32_t len = lengths[i];
+		uint32_t nsamples = (len/DSPADPCM_FRAME_BYTES)*DSPADPCM_FRAME_SAMPLES;
+		char name[64];
+
+		// loop context: decoder state at the end of the loop, header of the loop start frame
+		hist.yn1 = hist.yn2 = 0;
+		dspadpcm_encode(dspadpcm_defcoefs,pcm,adpcm,nsamples,&hist,NULL);
+		ctx.loop_pds = adpcm[0];
+		ctx.loop_yn1 = hist.yn1;
+		ctx.loop_yn2 = hist.yn2;
+
+		snprintf(name,sizeof(name),"loop %u bytes",len);
+		failed |= __runcase(name,adpcm,len,VOICE_LOOP,&ctx,200000);
+		snprintf(name,sizeof(name),"once %u bytes",len);
+		failed |= __runcase(name,adpcm,len,VOICE_ONCE,&ctx,200000);
+		snprintf(name,sizeof(name),"source %u bytes",len);
+		failed |= __runcase(name,adpcm,len,VOICE_SOURCE,&ctx,200000);
+	}
+
+	/* sanity: without the PB supplied header at the ring start the model must diverge */
+	ring_pds_enabled = 0;
+	printf("expected failures without ring_pds:\n");
+	if(!__runcase("source (no ring_pds)",adpcm,DSP_STREAMBUFFER_SIZE*3,VOICE_SOURCE,&ctx,200000)) {
+		printf("model does not detect a missing ring_pds\n");
+		failed = 1;
+	}
+	ring_pds_enabled = 1;
+
+	printf(failed ? "FAILED\n" : "PASSED\n");
+	return failed;
+}
@@ -0,0 +1,144 @@
+/*-------------------------------------------------------------
+
+dspadpcm.c -- reference DSP-ADPCM decoder and encoder
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <string.h>
+#include "dspadpcm.h"
+
+const int16_t dspadpcm_defcoefs[16] = {
+	     0,     0,
+	  2048,     0,
+	  3072, -1024,
+	  3584, -1536,
+	  3840, -1920,
+	  1024,     0,
+	  4000, -2000,
+	  1536,  -512
+};
+
+static int32_t __clamp16(int32_t val)
+{
+	if(val>0x7fff) return 0x7fff;
+	if(val<-0x7fff) return -0x7fff;
+	return val;
+}
+
+int16_t dspadpcm_decodenibble(const int16_t coefs[16],uint8_t ps,int nibble,dspadpcm_hist *hist)
+{
+	int32_t scale = 1<<(ps&0x0f);
+	int32_t c1 = coefs[((ps>>4)&0x07)*2 + 0];
+	int32_t c2 = coefs[((ps>>4)&0x07)*2 + 1];
+	int32_t val;
+
+	if(nibble>=8) nibble -= 16;
+
+	val = __clamp16((scale*nibble) + ((0x400 + c1*hist->yn1 + c2*hist->yn2)>>11));
+
+	hist->yn2 = hist->yn1;
+	hist->yn1 = (int16_t)val;
+	return (int16_t)val;
+}
+
+void dspadpcm_decode(const int16_t coefs[16],const uint8_t *src,int16_t *dst,uint32_t samples,dspadpcm_hist *hist)
+{
+	uint32_t i;
+
+	for(i=0;i<samples;i++) {
+		const uint8_t *frame = src + (i/DSPADPCM_FRAME_SAMPLES)*DSPADPCM_FRAME_BYTES;
+		uint32_t nib = (i%DSPADPCM_FRAME_SAMPLES) + 2;
+		int nibble = (nib&1) ? (frame[nib>>1]&0x0f) : (frame[nib>>1]>>4);
+
+		dst[i] = dspadpcm_decodenibble(coefs,frame[0],nibble,hist);
+	}
+}
+
+// quantizes one frame with the given header, returning the squared error
+static uint64_t __encodeframe(const int16_t coefs[16],uint8_t ps,const int16_t *src,uint32_t count,dspadpcm_hist *hist,uint8_t *nibbles,int16_t *recon)
+{
+	int32_t scale = 1<<(ps&0x0f);
+	int32_t c1 = coefs[((ps>>4)&0x07)*2 + 0];
+	int32_t c2 = coefs[((ps>>4)&0x07)*2 + 1];
+	uint64_t err = 0;
+	uint32_t i;
+
+	for(i=0;i<DSPADPCM_FRAME_SAMPLES;i++) {
+		int32_t pred = (0x400 + c1*hist->yn1 + c2*hist->yn2)>>11;
+		int32_t target = (i<count) ? src[i] : 0;
+		int32_t diff = target - pred;
+		int32_t q,val;
+
+		// round to nearest, away from zero on ties
+		if(diff>=0) q = (diff + (scale>>1))/scale;
+		else q = -((-diff + (scale>>1))/scale);
+		if(q>7) q = 7;
+		if(q<-8) q = -8;
+
+		nibbles[i] = (uint8_t)(q&0x0f);
+		val = dspadpcm_decodenibble(coefs,ps,nibbles[i],hist);
+		if(recon) recon[i] = (int16_t)val;
+		if(i<count) err += (uint64_t)((int64_t)(target - val)*(target - val));
+	}
+	return err;
+}
+
+uint32_t dspadpcm_encode(const int16_t coefs[16],const int16_t *src,uint8_t *dst,uint32_t samples,dspadpcm_hist *hist,int16_t *recon)
+{
+	uint32_t pos,bytes = 0;
+
+	for(pos=0;pos<samples;pos+=DSPADPCM_FRAME_SAMPLES) {
+		uint32_t count = samples - pos;
+		uint64_t best_err = UINT64_MAX;
+		uint8_t best_ps = 0;
+		uint8_t nibbles[DSPADPCM_FRAME_SAMPLES];
+		int16_t out[DSPADPCM_FRAME_SAMPLES];
+		uint32_t pred,shift,i;
+
+		if(count>DSPADPCM_FRAME_SAMPLES) count = DSPADPCM_FRAME_SAMPLES;
+
+		for(pred=0;pred<8;pred++) {
+			for(shift=0;shift<12;shift++) {
+				dspadpcm_hist h = *hist;
+				uint8_t ps = (uint8_t)((pred<<4)|shift);
+				uint64_t err = __encodeframe(coefs,ps,src + pos,count,&h,nibbles,NULL);
+
+				if(err<best_err) {
+					best_err = err;
+					best_ps = ps;
+				}
+			}
+		}
+
+		__encodeframe(coefs,best_ps,src + pos,count,hist,nibbles,out);
+
+		dst[bytes] = best_ps;
+		for(i=0;i<DSPADPCM_FRAME_SAMPLES;i+=2)
+			dst[bytes + 1 + (i>>1)] = (uint8_t)((nibbles[i]<<4)|nibbles[i + 1]);
+		bytes += DSPADPCM_FRAME_BYTES;
+
+		if(recon) memcpy(recon + pos,out,count*sizeof(int16_t));
+	}
+	return bytes;
+}
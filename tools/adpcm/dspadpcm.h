@@ -0,0 +1,64 @@
+/*-------------------------------------------------------------
+
+dspadpcm.h -- reference DSP-ADPCM decoder and encoder
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __DSPADPCM_H__
+#define __DSPADPCM_H__
+
+#include <stdint.h>
+
+#define DSPADPCM_FRAME_BYTES		8
+#define DSPADPCM_FRAME_SAMPLES		14
+#define DSPADPCM_FRAME_NIBBLES		16
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/* decoder history, as kept by the accelerator in ACYN1/ACYN2 */
+typedef struct _dspadpcm_hist {
+	int16_t yn1;
+	int16_t yn2;
+} dspadpcm_hist;
+
+/* 8 predictor pairs (c1,c2) in 1/2048 units, indexed by the upper nibble of a frame header */
+extern const int16_t dspadpcm_defcoefs[16];
+
+/* decodes one nibble with the frame header ps, exactly as the accelerator does for ACFMT 0 */
+int16_t dspadpcm_decodenibble(const int16_t coefs[16],uint8_t ps,int nibble,dspadpcm_hist *hist);
+
+/* decodes samples starting at frame header nibble 0 of src */
+void dspadpcm_decode(const int16_t coefs[16],const uint8_t *src,int16_t *dst,uint32_t samples,dspadpcm_hist *hist);
+
+/* encodes samples into frames, zero padding the last one; returns the number of bytes written.
+   the encoder tracks the decoder, so dspadpcm_decode() reproduces recon (if given) bit exactly */
+uint32_t dspadpcm_encode(const int16_t coefs[16],const int16_t *src,uint8_t *dst,uint32_t samples,dspadpcm_hist *hist,int16_t *recon);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+/*-------------------------------------------------------------
+
+aesndshim.h -- the AESND voice API on the host model
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Stands in for gc/aesndlib.h when a library source that drives AESND voices
+ * is built on the host: AESNDPB is the parameter block of the model in
+ * tools/mixer/aesndmodel.h, and the voice calls go to the model's, which
+ * carry the aesndlib.c code. Include it before the library source.
+ */
+
+#ifndef __AESNDSHIM_H__
+#define __AESNDSHIM_H__
+
+/* keeps gc/aesndlib.h out */
+#define __AESNDLIB_H__
+
+#include <gctypes.h>
+#include "aesndmodel.h"
+
+#define DSP_STREAMBUFFER_SIZE		AESND_STREAMBUFFER_SIZE
+#define DSP_DEFAULT_FREQ			AESND_DEFAULT_FREQ
+
+typedef aesndmodelpb AESNDPB;
+typedef aesndmodel_voicecb AESNDVoiceCallback;
+typedef aesndmodel_sourcecb AESNDSourceCallback;
+
+#define AESND_PlayVoice				aesndmodel_playvoice
+#define AESND_SetVoiceSource		aesndmodel_setvoicesource
+#define AESND_SetVoiceFormat		aesndmodel_setvoiceformat
+#define AESND_SetVoiceVolume		aesndmodel_setvoicevolume
+#define AESND_SetVoiceFrequency		aesndmodel_setvoicefrequency
+#define AESND_SetVoiceStream		aesndmodel_setvoicestream
+#define AESND_SetVoiceLoop			aesndmodel_setvoiceloop
+#define AESND_SetVoiceMute			aesndmodel_setvoicemute
+#define AESND_SetVoiceStop			aesndmodel_setvoicestop
+#define AESND_SetVoiceDelay			aesndmodel_setvoicedelay
+
+static inline u32 AESND_GetVoiceUnderruns(AESNDPB *pb)
+{
+	return pb->underruns;
+}
+
+#endif
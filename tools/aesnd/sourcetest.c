@@ -0,0 +1,579 @@
+/*-------------------------------------------------------------
+
+sourcetest.c -- AESND streaming sources on the host model
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libmad/mp3source.c and libaesnd/imasource.c as they are, on the AESND
+ * model of tools/mixer/ standing in for the DSP and aesndlib.c: aesndshim.h
+ * gives them the voice API of the model. The sources are included here so
+ * that the voice source callback can be wrapped. Each tick of the model runs
+ * with interrupts disabled, as the DSP interrupt does, mixes 96 samples and
+ * refills the stream buffer halves the DSP entered.
+ *
+ * The checks compare what the voice plays with an independent decode of the
+ * same data: libmad for the streams of tools/mad/madstream.c, the encoder's
+ * own reconstruction for IMA-ADPCM. Readers fed by a link slower or faster
+ * than the stream give the underrun counts. The latency is measured for each
+ * sample, from the tick that decodes it to the tick that plays it.
+ *
+ *   sourcetest				run the checks
+ *   sourcetest -b			also time the sources
+ *
+ * The benchmark figures are host figures, in CPU time per second of audio.
+ */
+
+#include "aesndshim.h"
+#include "mp3source.c"
+#include "imasource.c"
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#include "madstream.h"
+
+#define MAX_STREAM				(512*1024)
+#define MAX_FRAMES				(8*48000)
+
+#define MP3_FRAMES				200				// 4.8 s at 48 kHz
+#define MP3_BITRATE				128
+
+#define IMA_SECONDS				3
+#define IMA_GROUPS				127				// 8 sample groups a block: 1016 samples
+#define IMA_LASTGROUPS			50				// groups of the short last block
+
+#define LINK_PREFILL			4096
+
+static int bench = 0;
+
+static aesndmodel model;
+
+static u8 stream[MAX_STREAM];
+static s16 ref[MAX_FRAMES*2];
+static s16 played[MAX_FRAMES*2];
+static u32 filltick[MAX_FRAMES];
+
+/* the voice source callback of the library, wrapped */
+static struct {
+	AESNDSourceCallback fill;
+	void *arg;
+	u32 framesize;
+	u32 frames;
+	u32 tick;
+	double cputime;
+} source;
+
+/* a reader fed at rate bytes/s, LINK_PREFILL bytes ahead */
+static struct {
+	const u8 *buf;
+	u32 len,pos,avail;
+	u32 rate;
+} link;
+
+static double __cputime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/* the sources store samples in the byte order of the CPU, the DSP reads them big endian */
+static s32 __fill(AESNDPB *pb,void *buffer,u32 len,void *cb_arg)
+{
+	s32 i,ret;
+	u16 *ptr = buffer;
+	double start = __cputime();
+
+	ret = source.fill(pb,buffer,len,source.arg);
+	source.cputime += __cputime() - start;
+
+	for(i=0;i<ret/2;i++) ptr[i] = __builtin_bswap16(ptr[i]);
+
+	for(i=0;i<ret/(s32)source.framesize && source.frames<MAX_FRAMES;i++)
+		filltick[source.frames++] = source.tick;
+	return ret;
+}
+
+static s32 __linkread(void *cb_data,void *dst,s32 len)
+{
+	u32 n;
+
+	if(link.pos>=link.len) return -1;
+
+	n = link.avail - link.pos;
+	if(n>(u32)len) n = len;
+
+	memcpy(dst,link.buf + link.pos,n);
+	link.pos += n;
+	return n;
+}
+
+static void __linkopen(const u8 *buf,u32 len,u32 rate)
+{
+	link.buf = buf;
+	link.len = len;
+	link.pos = 0;
+	link.avail = (len<LINK_PREFILL) ? len : LINK_PREFILL;
+	link.rate = rate;
+}
+
+static void __linktick(u32 tick)
+{
+	u64 avail;
+
+	if(link.buf==NULL) return;
+
+	avail = LINK_PREFILL + ((u64)link.rate*tick*AESND_FRAME_SAMPLES)/AESND_DEFAULT_FREQ;
+	link.avail = (avail<link.len) ? (u32)avail : link.len;
+}
+
+static AESNDPB* __voice(void)
+{
+	aesndmodel_init(&model);
+	memset(&link,0,sizeof(link));
+	return aesndmodel_allocatevoice(&model,NULL);
+}
+
+/* plays the voice the source was started on until it stops, returns the frames played */
+static u32 __run(AESNDPB *pb,u32 framesize)
+{
+	u32 level,tick;
+
+	source.fill = pb->source;
+	source.arg = pb->source_arg;
+	source.framesize = framesize;
+	source.frames = 0;
+	source.cputime = 0.0;
+	pb->source = __fill;
+
+	for(tick=0;(tick + 1)*AESND_FRAME_SAMPLES<=MAX_FRAMES;tick++) {
+		__linktick(tick);
+		source.tick = tick;
+
+		_CPU_ISR_Disable(level);
+		aesndmodel_tick(&model);
+		_CPU_ISR_Restore(level);
+
+		if(model.voices==0) break;
+		memcpy(played + tick*AESND_FRAME_SAMPLES*2,model.out,sizeof(model.out));
+	}
+	return tick*AESND_FRAME_SAMPLES;
+}
+
+/*
+ * The voice plays the right channel first, and holds each sample for the
+ * output sample before it reads the next. Returns the offset of the stream
+ * in what was played, -1 if the frames played do not match ref[0..frames).
+ */
+static s32 __match(u32 len,u32 frames)
+{
+	u32 i,p;
+
+	for(p=0;p<len;p++) {
+		if(played[p*2]!=0 || played[p*2 + 1]!=0) break;
+	}
+	for(i=0;i<frames;i++) {
+		if(ref[i*2]!=0 || ref[i*2 + 1]!=0) break;
+	}
+	if(p<i) return -1;
+	p -= i;
+
+	if(p + frames>len) return -1;
+	for(i=0;i<frames;i++) {
+		if(played[(p + i)*2 + 0]!=ref[i*2 + 1] || played[(p + i)*2 + 1]!=ref[i*2 + 0]) return -1;
+	}
+	for(i=p + frames;i<len;i++) {
+		if(played[i*2]!=0 || played[i*2 + 1]!=0) return -1;
+	}
+	return p;
+}
+
+/* the same with the gaps of silence the underruns leave taken out of both */
+static s32 __matchgaps(u32 len,u32 frames)
+{
+	u32 i = 0,p = 0;
+
+	while(1) {
+		while(p<len && played[p*2]==0 && played[p*2 + 1]==0) p++;
+		while(i<frames && ref[i*2]==0 && ref[i*2 + 1]==0) i++;
+		if(p>=len || i>=frames) break;
+
+		if(played[p*2 + 0]!=ref[i*2 + 1] || played[p*2 + 1]!=ref[i*2 + 0]) return -1;
+		p++;
+		i++;
+	}
+	return (p>=len && i>=frames) ? 0 : -1;
+}
+
+/* decode to play of the frames, in output samples: a frame decoded in a tick can play from the next one */
+static void __latency(s32 offset,u32 frames,u32 *lo,u32 *hi)
+{
+	u32 i,t;
+
+	*lo = ~0;
+	*hi = 0;
+	for(i=0;i<frames && i<source.frames;i++) {
+		t = offset + i - (filltick[i] + 1)*AESND_FRAME_SAMPLES;
+		if(t<*lo) *lo = t;
+		if(t>*hi) *hi = t;
+	}
+}
+
+/*---------------------------------------------------------------------------------*/
+/* MP3Source */
+
+static u32 __mp3stream(u32 seed)
+{
+	u32 i;
+	madstream ms;
+
+	madstream_init(&ms,stream,sizeof(stream),seed);
+	ms.reservoir = 1;
+
+	for(i=0;i<MP3_FRAMES;i++) {
+		if(!madstream_frame(&ms,3,MP3_BITRATE,48000)) return 0;
+	}
+	return ms.len;
+}
+
+static u32 __mp3decode(u32 len)
+{
+	u32 i,n = 0;
+	struct mad_stream st;
+	struct mad_frame fr;
+	struct mad_synth sy;
+
+	mad_stream_init(&st);
+	mad_frame_init(&fr);
+	mad_synth_init(&sy);
+	mad_stream_buffer(&st,stream,len + MADSTREAM_GUARD);
+	while(!mad_frame_decode(&fr,&st)) {
+		mad_synth_frame(&sy,&fr);
+		for(i=0;i<sy.pcm.length;i++) {
+			ref[n++] = FixedToShort(sy.pcm.samples[0][i]);
+			ref[n++] = FixedToShort(sy.pcm.samples[1][i]);
+		}
+	}
+	mad_synth_finish(&sy);
+	mad_frame_finish(&fr);
+	mad_stream_finish(&st);
+	return n/2;
+}
+
+static int __test_mp3(void)
+{
+	u32 len,frames,n,lo,hi;
+	s32 offset;
+	AESNDPB *pb = __voice();
+	MP3Source *src;
+
+	len = __mp3stream(0x3d0);
+	if(len==0) return 1;
+	frames = __mp3decode(len);
+	if(frames!=MP3_FRAMES*1152) return 1;
+
+	src = MP3Source_CreateBuffer(stream,len);
+	if(src==NULL) return 1;
+	if(MP3Source_Play(src,pb,0)) return 1;
+	if(pb->freq_h!=1 || pb->freq_l!=0) return 1;
+
+	n = __run(pb,4);
+	offset = __match(n,frames);
+	if(offset<0 || MP3Source_GetUnderruns(src)!=0) return 1;
+
+	/* the latency the source reports covers every frame */
+	__latency(offset,frames,&lo,&hi);
+	printf("%-16s latency %.2f to %.2f ms, MP3Source_GetLatency() %u ms\n","",lo/48.0,hi/48.0,MP3Source_GetLatency(src));
+	if(hi>MP3Source_GetLatency(src)*48) return 1;
+
+	MP3Source_Destroy(src);
+	return 0;
+}
+
+/* a reader fed slower than the stream underruns, and the voice plays the rest of it after each gap */
+static int __test_mp3_underrun(void)
+{
+	u32 len,frames,n;
+	AESNDPB *pb = __voice();
+	MP3Source *src;
+
+	len = __mp3stream(0x3d1);
+	if(len==0) return 1;
+	frames = __mp3decode(len);
+
+	__linkopen(stream,len,MP3_BITRATE*1000/8*7/8);
+	src = MP3Source_Create(NULL,__linkread);
+	if(src==NULL) return 1;
+	if(MP3Source_Play(src,pb,0)) return 1;
+
+	n = __run(pb,4);
+	if(MP3Source_GetUnderruns(src)==0 || __matchgaps(n,frames)) return 1;
+	MP3Source_Destroy(src);
+
+	/* one faster than the stream does not */
+	pb = __voice();
+	__linkopen(stream,len,MP3_BITRATE*1000/8*3/2);
+	src = MP3Source_Create(NULL,__linkread);
+	if(src==NULL) return 1;
+	if(MP3Source_Play(src,pb,0)) return 1;
+
+	n = __run(pb,4);
+	if(MP3Source_GetUnderruns(src)!=0 || __match(n,frames)<0) return 1;
+	MP3Source_Destroy(src);
+	return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* IMASource */
+
+static u32 __imaencode(s32 *pred,s32 *index,s32 sample)
+{
+	s32 step = _imasteps[*index];
+	s32 diff = sample - *pred;
+	s32 delta = step>>3;
+	u32 nibble = 0;
+
+	if(diff<0) {
+		nibble = 8;
+		diff = -diff;
+	}
+	if(diff>=step) {
+		nibble |= 4;
+		diff -= step;
+		delta += step;
+	}
+	if(diff>=(step>>1)) {
+		nibble |= 2;
+		diff -= step>>1;
+		delta += step>>1;
+	}
+	if(diff>=(step>>2)) {
+		nibble |= 1;
+		delta += step>>2;
+	}
+
+	*pred += (nibble&8) ? -delta : delta;
+	if(*pred>32767) *pred = 32767;
+	else if(*pred<-32768) *pred = -32768;
+
+	*index += _imaindex[nibble&7];
+	if(*index<0) *index = 0;
+	else if(*index>88) *index = 88;
+
+	return nibble;
+}
+
+static s16 __imasample(u32 i,u32 c,u32 *seed)
+{
+	*seed = *seed*1103515245 + 12345;
+	return (s16)(12000.0*sin(2.0*M_PI*(c ? 660.0 : 440.0)*i/48000.0) + (s32)((*seed>>16)&0x3ff) - 512);
+}
+
+/*
+ * Encodes IMA_SECONDS of a tone as blocks of IMA_GROUPS groups and a short
+ * last one, with the reconstruction a decoder gives in ref, the two channels
+ * of mono alike. Returns the bytes and the frames in *frames.
+ */
+static u32 __imastream(u32 channels,u32 *frames)
+{
+	u32 blocksamples = 1 + IMA_GROUPS*8;
+	u32 i,c,g,k,s,first,groups,seed = 0x1a4;
+	s32 pred[2],index[2] = {0,0};
+	u8 *out = stream;
+	s16 in[2];
+
+	first = 0;
+	do {
+		groups = (first + blocksamples<=IMA_SECONDS*48000) ? IMA_GROUPS : IMA_LASTGROUPS;
+
+		for(c=0;c<channels;c++) {
+			in[c] = __imasample(first,c,&seed);
+			pred[c] = in[c];
+			out[c*4 + 0] = (u8)(in[c]&0xff);
+			out[c*4 + 1] = (u8)((u16)in[c]>>8);
+			out[c*4 + 2] = (u8)index[c];
+			out[c*4 + 3] = 0;
+			ref[first*2 + c] = in[c];
+			if(channels==1) ref[first*2 + 1] = in[c];
+		}
+		out += channels*4;
+
+		for(g=0;g<groups;g++) {
+			s16 group[8][2];
+
+			for(k=0;k<8;k++) {
+				for(c=0;c<channels;c++) group[k][c] = __imasample(first + 1 + g*8 + k,c,&seed);
+			}
+			for(c=0;c<channels;c++) {
+				for(k=0;k<8;k++) {
+					s = first + 1 + g*8 + k;
+					i = __imaencode(&pred[c],&index[c],group[k][c]);
+					if(k&1) out[c*4 + (k>>1)] |= (u8)(i<<4);
+					else out[c*4 + (k>>1)] = (u8)i;
+					ref[s*2 + c] = (s16)pred[c];
+					if(channels==1) ref[s*2 + 1] = (s16)pred[c];
+				}
+			}
+			out += channels*4;
+		}
+		first += 1 + groups*8;
+	} while(groups==IMA_GROUPS);
+
+	*frames = first;
+	return (u32)(out - stream);
+}
+
+static int __test_ima(u32 channels)
+{
+	u32 len,frames,n;
+	AESNDPB *pb = __voice();
+	IMASource *src;
+
+	len = __imastream(channels,&frames);
+	src = IMASource_CreateBuffer(stream,len,channels,48000,channels*4*(1 + IMA_GROUPS));
+	if(src==NULL) return 1;
+	if(IMASource_Play(src,pb,0)) return 1;
+
+	n = __run(pb,channels*2);
+	if(__match(n,frames)<0 || IMASource_GetUnderruns(src)!=0) return 1;
+
+	IMASource_Destroy(src);
+	return 0;
+}
+
+static int __test_ima_mono(void)
+{
+	return __test_ima(1);
+}
+
+static int __test_ima_stereo(void)
+{
+	return __test_ima(2);
+}
+
+static int __test_ima_underrun(void)
+{
+	u32 len,frames,n;
+	AESNDPB *pb = __voice();
+	IMASource *src;
+
+	len = __imastream(2,&frames);
+
+	__linkopen(stream,len,48000*7/8);
+	src = IMASource_Create(NULL,__linkread,2,48000,2*4*(1 + IMA_GROUPS));
+	if(src==NULL) return 1;
+	if(IMASource_Play(src,pb,0)) return 1;
+
+	n = __run(pb,4);
+	if(IMASource_GetUnderruns(src)==0 || __matchgaps(n,frames)) return 1;
+
+	IMASource_Destroy(src);
+	return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+
+static void __bench_mp3(void)
+{
+	u32 len,n;
+	AESNDPB *pb = __voice();
+	MP3Source *src;
+
+	len = __mp3stream(0x3d2);
+	src = MP3Source_CreateBuffer(stream,len);
+	if(src==NULL || MP3Source_Play(src,pb,0)) return;
+
+	n = __run(pb,4);
+	printf("%-24s %8.2f ms/s\n","mp3 source",source.cputime*1000.0/(n/48000.0));
+	MP3Source_Destroy(src);
+}
+
+static void __bench_ima(u32 channels)
+{
+	u32 len,frames,n;
+	AESNDPB *pb = __voice();
+	IMASource *src;
+
+	len = __imastream(channels,&frames);
+	src = IMASource_CreateBuffer(stream,len,channels,48000,channels*4*(1 + IMA_GROUPS));
+	if(src==NULL || IMASource_Play(src,pb,0)) return;
+
+	n = __run(pb,channels*2);
+	printf("%-24s %8.2f ms/s\n",channels==2 ? "ima source stereo" : "ima source mono",source.cputime*1000.0/(n/48000.0));
+	IMASource_Destroy(src);
+}
+
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "mp3",			__test_mp3 },
+	{ "mp3 underrun",	__test_mp3_underrun },
+	{ "ima mono",		__test_ima_mono },
+	{ "ima stereo",		__test_ima_stereo },
+	{ "ima underrun",	__test_ima_underrun },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		__bench_mp3();
+		__bench_ima(1);
+		__bench_ima(2);
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	int i;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,839 @@
+/*-------------------------------------------------------------
+
+cardtest.c -- memory card transaction tests against a simulated EXI card
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/card.c as it is, on the simulated kernel of lwpsim/, against a
+ * model of an unlocked memory card in slot A. The EXI functions feed the
+ * card the bytes the driver sends; it decodes the status, read, sector erase
+ * and page program commands, keeps its flash in memory, and completes DMA
+ * transfers and flash operations from a thread above every other priority,
+ * with interrupts disabled as in the EXI interrupt handler.
+ *
+ * The card can lose power at any flash operation: that one is left half
+ * done and every later one fails. The commit test cuts the power at each
+ * operation of a commit, brings the card back and checks that it holds the
+ * directory from before or after the transaction, that every file's chain
+ * in the FAT is whole and that blocks are at worst leaked.
+ *
+ *   cardtest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "cache.h"
+#include "dsp.h"
+#include "exi.h"
+#include "card.h"
+
+#define STACKSIZE				(64*1024)
+
+#define CARD_ID					EXI_MEMCARD59		// 8KB sectors, 4 latency bytes
+#define CARD_SIZE				(512*1024)
+#define SECTOR_SIZE				8192
+#define PAGE_SIZE				128
+#define CARD_BLOCKS				(CARD_SIZE/SECTOR_SIZE)
+#define CARD_SYSAREA			5
+
+#define STATUS_ERROR			0x18
+#define STATUS_UNLOCKED			0x40
+
+#define MOCK_QUEUE				8
+#define MAX_ERASES				16
+
+/* the system area as card.c lays it out */
+#define SYS_DIR					1
+#define SYS_FAT					3
+#define DIR_ENTRY_SIZE			64
+#define DIR_FILENAME			8
+#define DIR_BLOCK				54
+#define DIR_LENGTH				56
+#define DIR_UPDATED				8186
+#define DIR_CHKSUM				8188
+#define FAT_UPDATED				4
+#define FAT_FREEBLOCKS			6
+#define FAT_LASTALLOC			8
+#define FAT_MAP					10
+
+enum {
+	FILE_OLD1,
+	FILE_OLD2,
+	FILE_NEW1,
+	FILE_AFTER,
+	NUM_FILES
+};
+
+#define FILES_BEFORE			((1<<FILE_OLD1)|(1<<FILE_OLD2))
+#define FILES_AFTER				((1<<FILE_OLD2)|(1<<FILE_NEW1))
+
+enum {
+	OP_TRANSFER,
+	OP_ERASE,
+	OP_PROGRAM
+};
+
+typedef struct _mockop {
+	u32 type;
+	u32 addr;
+	EXICallback cb;
+	u8 page[PAGE_SIZE];
+} mockop;
+
+typedef struct _cardcheck {
+	u32 files;					// FILE_* bits of the files in the directory
+	u32 leaked;					// blocks allocated in the FAT that no file uses
+} cardcheck;
+
+static struct {
+	u8 flash[CARD_SIZE];
+	u8 cmd[8];
+	u32 cmdlen;
+	u8 page[PAGE_SIZE];
+	bool paged;
+	u8 status;
+	bool interrupts;
+
+	u32 flashops;				// erases and page programs started
+	u32 cutat;					// the one that loses power
+	bool dead;
+
+	u32 erases[MAX_ERASES];		// sectors in erase order
+	u32 nerases;
+	u32 programs;
+} card;
+
+static struct {
+	volatile bool attached;
+	volatile bool locked;
+	EXICallback exicb;
+	EXICallback unlockcb;
+} bus;
+
+static const char *names[NUM_FILES] = {"old1","old2","new1","after"};
+static const u32 sizes[NUM_FILES] = {2,1,2,1};
+
+static mockop ops[MOCK_QUEUE];
+static u32 ophead,opcount;
+static volatile u32 latency;
+static sem_t opsem;
+static sem_t donesem;
+static lwp_t cardthread = LWP_THREAD_NULL;
+
+static u8 workarea[CARD_WORKAREA] ATTRIBUTE_ALIGN(32);
+static u8 buffer[2*SECTOR_SIZE] ATTRIBUTE_ALIGN(32);
+static u8 snapshot[CARD_SIZE];
+
+static card_file chainfile;
+static volatile s32 apiresult,chainret,chainresult;
+
+/*---------------------------------------------------------------------------------*/
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+static u16 __get16(const u8 *ptr)
+{
+	u16 val;
+
+	memcpy(&val,ptr,2);
+	return val;
+}
+
+static void __put16(u8 *ptr,u16 val)
+{
+	memcpy(ptr,&val,2);
+}
+
+/* the checksum pair card.c keeps behind each directory and in front of each FAT */
+static void __checksum(const u8 *buf,u32 len,u8 *out)
+{
+	u32 i;
+	u16 cs1 = 0,cs2 = 0;
+
+	for(i=0;i<len;i+=2) {
+		cs1 += __get16(buf+i);
+		cs2 += __get16(buf+i)^0xffff;
+	}
+	if(cs1==0xffff) cs1 = 0;
+	if(cs2==0xffff) cs2 = 0;
+	__put16(out,cs1);
+	__put16(out+2,cs2);
+}
+
+static void __queue(u32 type,u32 addr,EXICallback cb)
+{
+	u32 level;
+	mockop *op;
+
+	_CPU_ISR_Disable(level);
+	if(opcount==MOCK_QUEUE) abort();
+	op = &ops[(ophead+opcount)%MOCK_QUEUE];
+	op->type = type;
+	op->addr = addr;
+	op->cb = cb;
+	if(type==OP_PROGRAM) memcpy(op->page,card.page,PAGE_SIZE);
+	opcount++;
+	_CPU_ISR_Restore(level);
+
+	LWP_SemPost(opsem);
+}
+
+static void __flashop(const mockop *op)
+{
+	u32 i,len;
+
+	if(card.dead) {
+		card.status |= STATUS_ERROR;
+		return;
+	}
+
+	len = op->type==OP_ERASE ? SECTOR_SIZE : PAGE_SIZE;
+	if(card.flashops++==card.cutat) {
+		// the power goes half way through
+		len /= 2;
+		card.dead = true;
+		card.status |= STATUS_ERROR;
+	}
+
+	if(op->type==OP_ERASE) {
+		memset(&card.flash[op->addr],0xff,len);
+		if(card.nerases<MAX_ERASES) card.erases[card.nerases] = op->addr/SECTOR_SIZE;
+		card.nerases++;
+	} else {
+		for(i=0;i<len;i++) card.flash[op->addr+i] &= op->page[i];
+		card.programs++;
+	}
+}
+
+static void* __card(void *arg)
+{
+	u32 level;
+	mockop op;
+
+	while(LWP_SemWait(opsem)==0) {
+		_CPU_ISR_Disable(level);
+		if(!opcount) {
+			_CPU_ISR_Restore(level);
+			break;
+		}
+		op = ops[ophead];
+		_CPU_ISR_Restore(level);
+
+		if(op.type==OP_TRANSFER) {
+			if(latency) __sleep(latency);
+		} else {
+			__flashop(&op);
+			// an erase takes long enough for the driver to let go of the bus
+			while(bus.locked) __sleep(1);
+		}
+
+		_CPU_ISR_Disable(level);
+		ophead = (ophead+1)%MOCK_QUEUE;
+		opcount--;
+		if(op.type==OP_TRANSFER) op.cb(EXI_CHANNEL_0,EXI_DEVICE_0);
+		else if(card.interrupts && bus.exicb) bus.exicb(EXI_CHANNEL_0,EXI_DEVICE_0);
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+static u32 __cmdaddr(void)
+{
+	u32 addr = (card.cmd[1]<<17)|(card.cmd[2]<<9);
+
+	if(card.cmd[0]!=0xf1) addr |= ((card.cmd[3]&0x03)<<7)|(card.cmd[4]&0x7f);
+	if(addr>=CARD_SIZE) abort();
+	return addr;
+}
+
+/*---------------------------------------------------------------------------------*/
+s32 EXI_GetID(s32 nChn,s32 nDev,u32 *nId)
+{
+	*nId = 0;
+	if(nChn!=EXI_CHANNEL_0 || nDev!=EXI_DEVICE_0) return 0;
+
+	*nId = CARD_ID;
+	return 1;
+}
+
+s32 EXI_Probe(s32 nChn)
+{
+	return nChn==EXI_CHANNEL_0;
+}
+
+s32 EXI_ProbeEx(s32 nChn)
+{
+	return nChn==EXI_CHANNEL_0 ? 1 : -1;
+}
+
+s32 EXI_GetState(s32 nChn)
+{
+	if(nChn!=EXI_CHANNEL_0) return 0;
+	return (bus.attached ? EXI_FLAG_ATTACH : 0)|(bus.locked ? EXI_FLAG_LOCKED : 0);
+}
+
+s32 EXI_Attach(s32 nChn,EXICallback ext_cb)
+{
+	if(nChn!=EXI_CHANNEL_0) return 0;
+
+	bus.attached = true;
+	return 1;
+}
+
+s32 EXI_Detach(s32 nChn)
+{
+	bus.attached = false;
+	return 1;
+}
+
+EXICallback EXI_RegisterEXICallback(s32 nChn,EXICallback exi_cb)
+{
+	EXICallback old = bus.exicb;
+
+	bus.exicb = exi_cb;
+	return old;
+}
+
+/* one driver on the bus, so one waiter at most */
+s32 EXI_Lock(s32 nChn,s32 nDev,EXICallback unlockCB)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(bus.locked) {
+		if(unlockCB) bus.unlockcb = unlockCB;
+		_CPU_ISR_Restore(level);
+		return 0;
+	}
+	bus.locked = true;
+	_CPU_ISR_Restore(level);
+	return 1;
+}
+
+s32 EXI_Unlock(s32 nChn)
+{
+	u32 level;
+	EXICallback cb;
+
+	_CPU_ISR_Disable(level);
+	if(!bus.locked) {
+		_CPU_ISR_Restore(level);
+		return 0;
+	}
+	bus.locked = false;
+	cb = bus.unlockcb;
+	bus.unlockcb = NULL;
+	if(cb) cb(nChn,EXI_DEVICE_0);
+	_CPU_ISR_Restore(level);
+	return 1;
+}
+
+s32 EXI_Select(s32 nChn,s32 nDev,s32 nFrq)
+{
+	card.cmdlen = 0;
+	card.paged = false;
+	return 1;
+}
+
+/* the card acts on a command when it is deselected */
+s32 EXI_Deselect(s32 nChn)
+{
+	if(!card.cmdlen) return 1;
+
+	switch(card.cmd[0]) {
+		case 0x81:
+			card.interrupts = card.cmd[1]&0x01;
+			break;
+		case 0x89:
+			card.status &= ~STATUS_ERROR;
+			break;
+		case 0xf1:
+			__queue(OP_ERASE,__cmdaddr()&~(SECTOR_SIZE-1),NULL);
+			break;
+		case 0xf2:
+			if(card.paged) __queue(OP_PROGRAM,__cmdaddr(),NULL);
+			break;
+	}
+	card.cmdlen = 0;
+	card.paged = false;
+	return 1;
+}
+
+s32 EXI_ImmEx(s32 nChn,void *pData,u32 nLen,u32 nMode)
+{
+	u8 *data = pData;
+
+	if(nMode==EXI_WRITE) {
+		// the read command's latency bytes fall off the end
+		while(nLen-- && card.cmdlen<sizeof(card.cmd)) card.cmd[card.cmdlen++] = *data++;
+		return 1;
+	}
+
+	memset(data,0,nLen);
+	if(card.cmdlen && card.cmd[0]==0x83) data[0] = card.status;
+	return 1;
+}
+
+s32 EXI_Dma(s32 nChn,void *pData,u32 nLen,u32 nMode,EXICallback tc_cb)
+{
+	if(nMode==EXI_READ && card.cmd[0]==0x52 && card.cmdlen>=5) {
+		memcpy(pData,&card.flash[__cmdaddr()],nLen);
+	} else if(nMode==EXI_WRITE && card.cmd[0]==0xf2 && card.cmdlen==5 && nLen==PAGE_SIZE) {
+		memcpy(card.page,pData,PAGE_SIZE);
+		card.paged = true;
+	} else
+		return 0;
+
+	__queue(OP_TRANSFER,0,tc_cb);
+	return 1;
+}
+
+s32 SYS_CreateAlarm(syswd_t *thealarm)
+{
+	*thealarm = 1;
+	return 0;
+}
+
+/* the card always answers, the command timeouts never expire */
+s32 SYS_SetAlarm(syswd_t thealarm,const struct timespec *tp,alarmcallback cb,void *cbarg)
+{
+	return 0;
+}
+
+s32 SYS_CancelAlarm(syswd_t thealarm)
+{
+	return 0;
+}
+
+void SYS_RegisterResetFunc(sys_resetinfo *info) {}
+
+u16 SYS_GetFontEncoding()
+{
+	return 0;
+}
+
+static syssram sram;
+static syssramex sramex = { .flashID_chksum = {0xff,0xff} };
+
+syssram* __SYS_LockSram()
+{
+	return &sram;
+}
+
+syssramex* __SYS_LockSramEx()
+{
+	return &sramex;
+}
+
+u32 __SYS_UnlockSram(u32 write)
+{
+	return 1;
+}
+
+u32 __SYS_UnlockSramEx(u32 write)
+{
+	return 1;
+}
+
+/* the card comes up unlocked, the DSP is never asked for a key */
+void DSP_Init() {}
+u32 DSP_CheckMailTo()
+{
+	return 0;
+}
+void DSP_SendMailTo(u32 mail) {}
+dsptask_t* DSP_AddTask(dsptask_t *task)
+{
+	return task;
+}
+
+void DCInvalidateRange(void *startaddress,u32 len) {}
+void DCStoreRange(void *startaddress,u32 len) {}
+void DCFlushRange(void *startaddress,u32 len) {}
+
+/*---------------------------------------------------------------------------------*/
+/* an empty card, as CARD_Format() would leave it */
+static void __format(void)
+{
+	u32 i;
+	u8 *blk;
+
+	memset(card.flash,0xff,CARD_SIZE);
+	for(i=0;i<2;i++) {
+		blk = &card.flash[(SYS_DIR+i)*SECTOR_SIZE];
+		__put16(blk+DIR_UPDATED,i);
+		__checksum(blk,0x1ffc,blk+DIR_CHKSUM);
+
+		blk = &card.flash[(SYS_FAT+i)*SECTOR_SIZE];
+		memset(blk,0,SECTOR_SIZE);
+		__put16(blk+FAT_UPDATED,i);
+		__put16(blk+FAT_FREEBLOCKS,CARD_BLOCKS-CARD_SYSAREA);
+		__put16(blk+FAT_LASTALLOC,CARD_SYSAREA-1);
+		__checksum(blk+4,0x1ffc,blk);
+	}
+}
+
+static bool __dirvalid(const u8 *blk)
+{
+	u8 sum[4];
+
+	__checksum(blk,0x1ffc,sum);
+	return !memcmp(sum,blk+DIR_CHKSUM,4);
+}
+
+static bool __fatvalid(const u8 *blk)
+{
+	u32 i,freeblocks = 0;
+	u8 sum[4];
+
+	__checksum(blk+4,0x1ffc,sum);
+	if(memcmp(sum,blk,4)) return false;
+
+	for(i=CARD_SYSAREA;i<CARD_BLOCKS;i++) {
+		if(!__get16(blk+FAT_MAP+(i-CARD_SYSAREA)*2)) freeblocks++;
+	}
+	return freeblocks==__get16(blk+FAT_FREEBLOCKS);
+}
+
+/* the copy the driver mounts: the valid one, or the newer of two */
+static const u8* __current(u32 sector,u32 updated,bool (*valid)(const u8*))
+{
+	const u8 *blk0 = &card.flash[sector*SECTOR_SIZE];
+	const u8 *blk1 = &card.flash[(sector+1)*SECTOR_SIZE];
+	bool ok0 = valid(blk0),ok1 = valid(blk1);
+
+	if(ok0 && ok1) return __get16(blk0+updated)<__get16(blk1+updated) ? blk1 : blk0;
+	if(ok0) return blk0;
+	if(ok1) return blk1;
+	return NULL;
+}
+
+/* every file's chain is whole and its own, and blocks are at worst leaked */
+static int __fsck(cardcheck *chk)
+{
+	u32 i,n,j,len;
+	u16 block;
+	u8 used[CARD_BLOCKS];
+	const u8 *entry;
+	const u8 *dir = __current(SYS_DIR,DIR_UPDATED,__dirvalid);
+	const u8 *fat = __current(SYS_FAT,FAT_UPDATED,__fatvalid);
+
+	if(!dir || !fat) return 1;
+
+	memset(used,0,sizeof(used));
+	chk->files = 0;
+	chk->leaked = 0;
+	for(i=0;i<CARD_MAXFILES;i++) {
+		entry = dir+i*DIR_ENTRY_SIZE;
+		if(entry[0]==0xff) continue;
+
+		for(n=0;n<NUM_FILES;n++) {
+			if(!strncmp((const char*)entry+DIR_FILENAME,names[n],CARD_FILENAMELEN)) break;
+		}
+		if(n==NUM_FILES || (chk->files&(1<<n))) return 1;
+		chk->files |= 1<<n;
+
+		block = __get16(entry+DIR_BLOCK);
+		len = __get16(entry+DIR_LENGTH);
+		if(len!=sizes[n]) return 1;
+		for(j=0;j<len;j++) {
+			if(block<CARD_SYSAREA || block>=CARD_BLOCKS || used[block]++) return 1;
+			block = __get16(fat+FAT_MAP+(block-CARD_SYSAREA)*2);
+		}
+		if(block!=0xffff) return 1;
+	}
+
+	for(i=CARD_SYSAREA;i<CARD_BLOCKS;i++) {
+		if(__get16(fat+FAT_MAP+(i-CARD_SYSAREA)*2) && !used[i]) chk->leaked++;
+	}
+	return 0;
+}
+
+static void __fill(u8 *ptr,u32 len,u32 n)
+{
+	u32 i;
+
+	for(i=0;i<len;i++) ptr[i] = (u8)(n*37 + i/SECTOR_SIZE*13 + i);
+}
+
+static int __compare(const u8 *ptr,u32 len,u32 n)
+{
+	u32 i;
+
+	for(i=0;i<len;i++) {
+		if(ptr[i]!=(u8)(n*37 + i/SECTOR_SIZE*13 + i)) return 1;
+	}
+	return 0;
+}
+
+static bool __waitdone(u32 count)
+{
+	struct timespec ts = {1,0};
+
+	while(count--) {
+		if(LWP_SemTimedWait(donesem,&ts)) return false;
+	}
+	return true;
+}
+
+/* takes the card out and puts it back in, powered */
+static s32 __remount(void)
+{
+	CARD_Unmount(CARD_SLOTA);
+
+	card.dead = false;
+	card.cutat = ~0;
+	card.status = STATUS_UNLOCKED;
+	card.interrupts = false;
+	return CARD_Mount(CARD_SLOTA,workarea,NULL);
+}
+
+static s32 __create(u32 n)
+{
+	s32 ret;
+	card_file file;
+	u32 len = sizes[n]*SECTOR_SIZE;
+
+	if((ret=CARD_Create(CARD_SLOTA,names[n],len,&file))<0) return ret;
+
+	__fill(buffer,len,n);
+	ret = CARD_Write(&file,buffer,len,0);
+	CARD_Close(&file);
+	return ret;
+}
+
+/* reads every file back that the directory lists */
+static int __readback(u32 files)
+{
+	u32 n,len;
+	card_file file;
+
+	for(n=0;n<NUM_FILES;n++) {
+		if(!(files&(1<<n))) continue;
+
+		len = sizes[n]*SECTOR_SIZE;
+		memset(buffer,0,len);
+		if(CARD_Open(CARD_SLOTA,names[n],&file)<0) return 1;
+		if(CARD_Read(&file,buffer,len,0)<0 || CARD_Close(&file)<0) return 1;
+		if(__compare(buffer,len,n)) return 1;
+	}
+	return 0;
+}
+
+/* two files, then a transaction that adds one and deletes another */
+static int __setup(void)
+{
+	__format();
+	if(__remount()!=CARD_ERROR_READY) return 1;
+	if(__create(FILE_OLD1)<0 || __create(FILE_OLD2)<0) return 1;
+	memcpy(snapshot,card.flash,CARD_SIZE);
+	return 0;
+}
+
+static int __transaction(void)
+{
+	if(CARD_BeginTransaction(CARD_SLOTA)!=CARD_ERROR_READY) return 1;
+	if(__create(FILE_NEW1)<0) return 1;
+	return CARD_Delete(CARD_SLOTA,names[FILE_OLD1])!=CARD_ERROR_READY;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* a commit writes the FAT, then the directory, then the FAT with the freed blocks */
+static u32 commitops;
+
+static int __test_order(void)
+{
+	u32 start;
+	cardcheck chk;
+
+	if(__setup() || __transaction()) return 1;
+
+	// nothing of the transaction reaches the system area before the commit
+	if(memcmp(&card.flash[SYS_DIR*SECTOR_SIZE],&snapshot[SYS_DIR*SECTOR_SIZE],(CARD_SYSAREA-SYS_DIR)*SECTOR_SIZE)) return 1;
+
+	card.nerases = 0;
+	card.programs = 0;
+	start = card.flashops;
+	if(CARD_CommitTransaction(CARD_SLOTA)!=CARD_ERROR_READY) return 1;
+	commitops = card.flashops-start;
+
+	printf("%-16s commit erased sectors %u,%u,%u with %u page programs\n","",card.erases[0],card.erases[1],card.erases[2],card.programs);
+	if(card.nerases!=3 || card.programs!=3*SECTOR_SIZE/PAGE_SIZE) return 1;
+	if(card.erases[0]<SYS_FAT || card.erases[0]>SYS_FAT+1) return 1;
+	if(card.erases[1]<SYS_DIR || card.erases[1]>SYS_DIR+1) return 1;
+	if(card.erases[2]!=(card.erases[0]^(SYS_FAT^(SYS_FAT+1)))) return 1;
+
+	if(__fsck(&chk) || chk.files!=FILES_AFTER || chk.leaked) return 1;
+	if(__remount()!=CARD_ERROR_READY) return 1;
+	return __readback(chk.files);
+}
+
+/* the power goes at each flash operation of a commit; the card keeps either state */
+static int __test_interrupted(void)
+{
+	u32 k,switched = 0,maxleak = 0;
+	s32 ret;
+	cardcheck chk;
+
+	if(!commitops || __setup()) return 1;
+
+	for(k=0;k<commitops;k++) {
+		memcpy(card.flash,snapshot,CARD_SIZE);
+		if(__remount()!=CARD_ERROR_READY || __transaction()) return 1;
+
+		card.cutat = card.flashops+k;
+		ret = CARD_CommitTransaction(CARD_SLOTA);
+		if(ret>=0 || !card.dead) return 1;
+
+		if(__remount()!=CARD_ERROR_READY || __fsck(&chk)) return 1;
+		if(chk.files==FILES_AFTER) {
+			if(!switched) switched = k+1;
+		} else if(chk.files!=FILES_BEFORE || switched)
+			return 1;
+		// the new file's blocks before the switch, the deleted file's after it
+		if(chk.leaked>sizes[switched ? FILE_OLD1 : FILE_NEW1]) return 1;
+		if(chk.leaked>maxleak) maxleak = chk.leaked;
+		if(__readback(chk.files)) return 1;
+
+		// and it takes new files
+		if(__create(FILE_AFTER)<0 || __fsck(&chk) || !(chk.files&(1<<FILE_AFTER))) return 1;
+	}
+
+	printf("%-16s %u cut points, new directory from cut %u on, up to %u blocks leaked\n","",commitops,switched-1,maxleak);
+	return !switched;
+}
+
+static void __chainread(s32 chn,s32 result)
+{
+	chainresult = result;
+	LWP_SemPost(donesem);
+}
+
+/* the callback of an operation inside a transaction starts a read */
+static void __chain(s32 chn,s32 result)
+{
+	apiresult = result;
+	chainret = CARD_ReadAsync(&chainfile,buffer,CARD_READSIZE,0,__chainread);
+}
+
+/* the operation gave the card back once: the read it started still holds it */
+static int __released(s32 ret)
+{
+	if(ret<0 || apiresult!=CARD_ERROR_READY || chainret!=CARD_ERROR_READY) return 1;
+	if(CARD_GetErrorCode(CARD_SLOTA)!=CARD_ERROR_BUSY) return 1;
+	if(!__waitdone(1) || chainresult!=CARD_ERROR_READY) return 1;
+	if(CARD_GetErrorCode(CARD_SLOTA)!=CARD_ERROR_READY) return 1;
+
+	apiresult = chainret = chainresult = 1;
+	return __compare(buffer,CARD_READSIZE,FILE_OLD2);
+}
+
+static int __test_release(void)
+{
+	s32 ret;
+	card_file file;
+	card_stat stat;
+	cardcheck chk;
+
+	apiresult = chainret = chainresult = 1;
+	if(__setup()) return 1;
+	if(CARD_Open(CARD_SLOTA,names[FILE_OLD2],&chainfile)!=CARD_ERROR_READY) return 1;
+	if(CARD_BeginTransaction(CARD_SLOTA)!=CARD_ERROR_READY) return 1;
+
+	latency = 2;
+	ret = __released(CARD_CreateAsync(CARD_SLOTA,names[FILE_NEW1],sizes[FILE_NEW1]*SECTOR_SIZE,&file,__chain));
+	if(!ret) ret = __released(CARD_DeleteAsync(CARD_SLOTA,names[FILE_OLD1],__chain));
+	if(!ret && CARD_GetStatus(CARD_SLOTA,chainfile.filenum,&stat)!=CARD_ERROR_READY) ret = 1;
+	if(!ret) ret = __released(CARD_SetStatusAsync(CARD_SLOTA,chainfile.filenum,&stat,__chain));
+	latency = 0;
+	if(ret) return 1;
+
+	if(CARD_Close(&chainfile)!=CARD_ERROR_READY) return 1;
+	if(CARD_CommitTransaction(CARD_SLOTA)!=CARD_ERROR_READY) return 1;
+	return __fsck(&chk) || chk.files!=FILES_AFTER || chk.leaked;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "order",			__test_order },
+	{ "interrupted",	__test_interrupted },
+	{ "release",		__test_release },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&opsem,0,MOCK_QUEUE*2);
+	LWP_SemInit(&donesem,0,16);
+	if(LWP_CreateThread(&cardthread,__card,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+	CARD_Init("GTST","01");
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	CARD_Unmount(CARD_SLOTA);
+	LWP_SemPost(opsem);
+	LWP_JoinThread(cardthread,NULL);
+	LWP_SemDestroy(donesem);
+	LWP_SemDestroy(opsem);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
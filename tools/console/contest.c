@@ -0,0 +1,592 @@
+/*-------------------------------------------------------------
+
+contest.c -- console rendering tests and printf benchmarks
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/console.c as it is, included here with the newlib headers of
+ * console/host/ and on the simulated kernel of lwpsim/ for the interrupt
+ * macros. Framebuffers are host arrays, and a retrace is a direct call of
+ * the post-retrace callback the console installed.
+ *
+ * Glyphs are checked against a renderer that tests one bit per pixel, for
+ * the built-in font and for fonts of other sizes that cover part of the
+ * characters. The cell grid console is checked against the console without
+ * a grid, which draws into its buffer as it writes and copies all of it on
+ * every retrace: the same text, with colors, cursor moves, line clears and
+ * scrolling, must give the same framebuffer, whichever retraces come in
+ * between. The copy itself is checked by leaving marks in the framebuffer.
+ *
+ *   contest				run the checks
+ *   contest -b				also time glyphs, printf and idle retraces
+ *
+ * The benchmark figures are host figures.
+ */
+
+#include "console.c"
+
+#include <ctype.h>
+#include <time.h>
+
+#define FB_WIDTH				640
+#define FB_HEIGHT				480
+
+#define CON_X					32
+#define CON_Y					24
+#define CON_WIDTH				576
+#define CON_HEIGHT				432
+
+#define MAX_TEXT				(64*1024)
+#define MAX_FONT				(256*32*4)
+
+#define POISON					0xdeadbeef
+
+static int bench = 0;
+
+static u32 xfb[2][FB_WIDTH*FB_HEIGHT/2];
+static u32 screen[FB_WIDTH*FB_HEIGHT/2];
+static u32 refscreen[FB_WIDTH*FB_HEIGHT/2];
+static int curfb = 0;
+static u32 retraces = 0;
+
+static VIRetraceCallback postcb = NULL;
+static GXRModeObj rmode = { .fbWidth = FB_WIDTH };
+
+static char text[MAX_TEXT];
+static u8 font[MAX_FONT];
+
+static const u32 pairs[6][2] = {
+	{ 0xB580B580, 0x10801080 },
+	{ 0x316D31B8, 0x10801080 },
+	{ 0xEB80EB80, 0x1DB81D77 },
+	{ 0x10801080, 0xD210D292 },
+	{ 0x5D935D48, 0x6ACA6ADE },
+	{ 0xAAA6AA10, 0x515A51F0 },
+};
+
+static double __cputime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* what console.c needs besides the kernel */
+const devoptab_t *devoptab_list[STD_MAX];
+
+void* VIDEO_GetCurrentFramebuffer()
+{
+	return xfb[curfb];
+}
+
+VIRetraceCallback VIDEO_SetPostRetraceCallback(VIRetraceCallback callback)
+{
+	VIRetraceCallback old = postcb;
+
+	postcb = callback;
+	return old;
+}
+
+void* SYS_VirtualToUncached(const void *addr)
+{
+	return (void*)addr;
+}
+
+int usb_isgeckoalive(s32 chn) { return 0; }
+int usb_sendbuffer(s32 chn,const void *buffer,int size) { return 0; }
+int usb_sendbuffer_safe(s32 chn,const void *buffer,int size) { return 0; }
+void __SYS_EnableBarnacle(s32 chn,u32 dev) {}
+s32 InitializeUART() { return -1; }
+s32 WriteUARTN(void *buf,u32 len) { return -1; }
+
+FILE* funopen(const void *cookie,int (*readfn)(void *,char *,size_t),int (*writefn)(void *,const char *,size_t),fpos_t (*seekfn)(void *,fpos_t,int),int (*closefn)(void *))
+{
+	return NULL;
+}
+
+FILE* fwopen(const void *cookie,int (*writefn)(void *,const char *,size_t))
+{
+	return NULL;
+}
+
+size_t _fwrite_unlocked_r(struct _reent *r,const void *buf,size_t size,size_t count,FILE *fp)
+{
+	return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+
+/* the renderer before the lookup tables: eight bit tests a row, 8x16 only */
+static void __bitsglyph(u32 *ptr,const u8 *pbits,u32 nextline,u32 fgcolor,u32 bgcolor)
+{
+	int ay;
+	u8 bits;
+	u32 color;
+
+	for(ay=0;ay<FONT_YSIZE;ay++) {
+		bits = *pbits++;
+
+		if(bits&0x80) color = fgcolor&0xFFFF00FF;
+		else color = bgcolor&0xFFFF00FF;
+		if(bits&0x40) color |= fgcolor&0x0000FF00;
+		else color |= bgcolor&0x0000FF00;
+		*ptr++ = color;
+
+		if(bits&0x20) color = fgcolor&0xFFFF00FF;
+		else color = bgcolor&0xFFFF00FF;
+		if(bits&0x10) color |= fgcolor&0x0000FF00;
+		else color |= bgcolor&0x0000FF00;
+		*ptr++ = color;
+
+		if(bits&0x08) color = fgcolor&0xFFFF00FF;
+		else color = bgcolor&0xFFFF00FF;
+		if(bits&0x04) color |= fgcolor&0x0000FF00;
+		else color |= bgcolor&0x0000FF00;
+		*ptr++ = color;
+
+		if(bits&0x02) color = fgcolor&0xFFFF00FF;
+		else color = bgcolor&0xFFFF00FF;
+		if(bits&0x01) color |= fgcolor&0x0000FF00;
+		else color |= bgcolor&0x0000FF00;
+		*ptr++ = color;
+
+		ptr += nextline;
+	}
+}
+
+/* one bit a pixel, the first pixel of a pair giving the chroma */
+static void __refglyph(u32 *ptr,u32 stride,const u8 *data,int width,int height,int first,int count,int c,u32 fg,u32 bg)
+{
+	int x,y,pitch = (width + 7)/8;
+	const u8 *row;
+	u32 p0,p1;
+
+	c -= first;
+	for(y=0;y<height;y++) {
+		row = (c>=0 && c<count) ? &data[(c*height + y)*pitch] : NULL;
+		for(x=0;x<width;x+=2) {
+			p0 = (row && (row[x>>3]&(0x80>>(x&7)))) ? fg : bg;
+			p1 = (row && (row[(x + 1)>>3]&(0x80>>((x + 1)&7)))) ? fg : bg;
+			ptr[y*stride + (x>>1)] = (p0&0xFFFF00FF)|(p1&0x0000FF00);
+		}
+	}
+}
+
+static void __randfont(int width,int height,int count,u32 seed)
+{
+	int i,n = count*height*((width + 7)/8);
+
+	for(i=0;i<n && i<MAX_FONT;i++) {
+		seed = seed*1103515245 + 12345;
+		font[i] = (u8)(seed>>16);
+	}
+}
+
+/* a console that is only a glyph target, stride words wide */
+static void __glyphcon(console_data_s *con,const u8 *data,int width,int height,int first,int count,u32 stride)
+{
+	memset(con,0,sizeof(*con));
+	con->destbuffer = screen;
+	con->con_stride = stride*4;
+	con->font = data;
+	con->font_width = width;
+	con->font_height = height;
+	con->font_pitch = (width + 7)/8;
+	con->font_first = first;
+	con->font_count = count;
+}
+
+/* every character in every color pair, more pairs than the tables hold and twice over */
+static int __checkglyphs(const u8 *data,int width,int height,int first,int count)
+{
+	const u32 stride = 64;
+	console_data_s con;
+	int c,k;
+
+	__glyphcon(&con,data,width,height,first,count,stride);
+	for(k=0;k<12;k++) {
+		for(c=0;c<256;c++) {
+			memset(screen,0x55,stride*height*4);
+			memset(refscreen,0x55,stride*height*4);
+			__console_drawglyph(&con,screen,c,pairs[k%6][0],pairs[k%6][1]);
+			__refglyph(refscreen,stride,data,width,height,first,count,c,pairs[k%6][0],pairs[k%6][1]);
+			if(memcmp(screen,refscreen,stride*height*4)) return 1;
+		}
+	}
+	return 0;
+}
+
+static int __test_glyphs(void)
+{
+	return __checkglyphs(console_font_8x16,FONT_XSIZE,FONT_YSIZE,0,256);
+}
+
+static int __test_fonts(void)
+{
+	static const int sizes[][2] = { {6,10}, {12,20}, {16,8}, {10,12}, {32,32}, {2,4}, {8,8} };
+	u32 i;
+
+	for(i=0;i<sizeof(sizes)/sizeof(sizes[0]);i++) {
+		__randfont(sizes[i][0],sizes[i][1],96,0xf0 + i);
+		if(__checkglyphs(font,sizes[i][0],sizes[i][1],32,96)) return 1;
+	}
+	return 0;
+}
+
+/*---------------------------------------------------------------------------------*/
+
+/* the grid console, or the one without a grid as when it cannot be allocated */
+static void __open(int grid)
+{
+	curfb = 0;
+	memset(xfb,0,sizeof(xfb));
+
+	CON_InitEx(&rmode,CON_X,CON_Y,CON_WIDTH,CON_HEIGHT);
+	if(!grid) {
+		VIDEO_SetPostRetraceCallback(NULL);
+		free(_console_cells);
+		free(_console_dirty);
+		_console_cells = NULL;
+		_console_dirty = NULL;
+		__console_init_ex(_console_buffer,CON_X,CON_Y,FB_WIDTH*VI_DISPLAY_PIX_SZ,CON_WIDTH,CON_HEIGHT,CON_WIDTH*VI_DISPLAY_PIX_SZ);
+	}
+}
+
+static void __retrace(void)
+{
+	if(postcb) postcb(++retraces);
+}
+
+static void __write(const char *str,size_t len)
+{
+	__console_write(NULL,NULL,str,len);
+}
+
+/* the console region of the current framebuffer */
+static void __grab(u32 *dst)
+{
+	u32 y;
+
+	for(y=0;y<CON_HEIGHT;y++)
+		memcpy(dst + y*(CON_WIDTH/2),&xfb[curfb][(CON_Y + y)*(FB_WIDTH/2) + CON_X/2],CON_WIDTH*VI_DISPLAY_PIX_SZ);
+}
+
+static void __poison(void)
+{
+	u32 i;
+
+	for(i=0;i<FB_WIDTH*FB_HEIGHT/2;i++) xfb[curfb][i] = POISON;
+}
+
+/* the console lines still marked, -1 if a line is partly copied */
+static int __marked(u32 line)
+{
+	u32 x,n = 0;
+	const u32 *ptr = &xfb[curfb][(CON_Y + line)*(FB_WIDTH/2) + CON_X/2];
+
+	for(x=0;x<CON_WIDTH/2;x++) n += (ptr[x]==POISON);
+	if(n==0) return 0;
+	return (n==CON_WIDTH/2) ? 1 : -1;
+}
+
+/*
+ * Logging text: words, colors, carriage returns, cursor moves and line
+ * clears, lines longer than the console, and enough of them to scroll it
+ * several times over. Background colors only if backgrounds is set.
+ */
+static u32 __logtext(u32 lines,u32 seed,int backgrounds)
+{
+	static const char *words[] = { "retrace", "0x80003100", "ok", "DVD", "read", "sector", "[", "]", "fifo", "timeout", "card", "slot", "A", "B", "12345", "-" };
+	u32 i,k,n,len = 0;
+
+	for(i=0;i<lines && len<MAX_TEXT - 256;i++) {
+		seed = seed*1103515245 + 12345;
+		n = 2 + ((seed>>16)%30);
+		for(k=0;k<n;k++) {
+			seed = seed*1103515245 + 12345;
+			switch((seed>>16)%24) {
+				case 0:
+					len += sprintf(text + len,"\x1b[3%u;%um",(seed>>20)%10,(seed>>24)&1);
+					break;
+				case 1:
+					if(!backgrounds) goto word;
+					len += sprintf(text + len,"\x1b[4%u;%um",(seed>>20)%8,(seed>>24)&1);
+					break;
+				case 2:
+					text[len++] = '\r';
+					break;
+				case 3:
+					len += sprintf(text + len,"\x1b[%uK",(seed>>20)%3);
+					break;
+				case 4:
+					len += sprintf(text + len,"\x1b[%u;%uH",(seed>>20)%24,(seed>>25)%60);
+					break;
+				default:
+				word:
+					len += sprintf(text + len,"%s ",words[(seed>>20)%16]);
+			}
+		}
+		text[len++] = '\n';
+	}
+	text[len] = '\0';
+	return len;
+}
+
+/* writes the text in pieces, a retrace after some of them; an escape sequence is written whole, as printf would */
+static void __play(u32 len,u32 seed,u32 period)
+{
+	u32 pos = 0,n,k;
+
+	while(pos<len) {
+		seed = seed*1103515245 + 12345;
+		n = 1 + ((seed>>16)%64);
+		if(n>len - pos) n = len - pos;
+
+		for(k=pos;k<pos + n;k++) {
+			if(text[k]!=0x1b) continue;
+			for(k+=2;k<len && !isalpha((unsigned char)text[k]);k++);
+			if(k>=pos + n) n = k + 1 - pos;
+		}
+
+		__write(text + pos,n);
+		pos += n;
+		if(period && ((seed>>24)%period)==0) __retrace();
+	}
+	__retrace();
+}
+
+static int __checkgrid(int backgrounds)
+{
+	static const u32 periods[] = { 0, 1, 3, 17 };
+	u32 i,len,seed;
+
+	for(seed=1;seed<=4;seed++) {
+		len = __logtext(120,seed,backgrounds);
+
+		__open(0);
+		__play(len,seed,0);
+		__grab(refscreen);
+
+		for(i=0;i<sizeof(periods)/sizeof(periods[0]);i++) {
+			__open(1);
+			__play(len,seed*7 + i,periods[i]);
+			__grab(screen);
+			if(memcmp(screen,refscreen,sizeof(u32)*CON_WIDTH*CON_HEIGHT/2)) return 1;
+		}
+	}
+	return 0;
+}
+
+static int __test_grid(void)
+{
+	return __checkgrid(1);
+}
+
+/*
+ * 12x20 and 6x10 leave lines below the last row. Without a grid, a scroll
+ * clears them in the background color of the moment and the next scroll
+ * moves them up into the bottom row, so the text for those keeps to one
+ * background. 32x36 is a font of four bytes a row.
+ */
+static int __test_grid_fonts(void)
+{
+	static const int sizes[][2] = { {12,20}, {6,10}, {12,24}, {32,36} };
+	u32 i;
+	int ret = 0;
+
+	for(i=0;i<sizeof(sizes)/sizeof(sizes[0]) && !ret;i++) {
+		__randfont(sizes[i][0],sizes[i][1],96,0x40 + i);
+		if(CON_SetFont(font,sizes[i][0],sizes[i][1],32,96)) return 1;
+		ret = __checkgrid((CON_HEIGHT%sizes[i][1])==0);
+	}
+	CON_SetFont(NULL,0,0,0,0);
+	return ret;
+}
+
+/* an idle console copies nothing, a changed row only itself, a scroll or another framebuffer all */
+static int __test_dirty(void)
+{
+	u32 line;
+	int cols = 0,rows = 0;
+
+	__open(1);
+	__write(text,__logtext(10,9,1));
+	__retrace();
+	CON_GetMetrics(&cols,&rows);
+
+	__poison();
+	__retrace();
+	for(line=0;line<CON_HEIGHT;line++) {
+		if(__marked(line)!=1) return 1;
+	}
+
+	__write("\x1b[5;10Hx",8);
+	__retrace();
+	for(line=0;line<CON_HEIGHT;line++) {
+		if(__marked(line)!=((line/FONT_YSIZE)==5 ? 0 : 1)) return 1;
+	}
+
+	__poison();
+	__write("\x1b[40;0H\n",8);
+	__retrace();
+	for(line=0;line<CON_HEIGHT;line++) {
+		if(__marked(line)!=0) return 1;
+	}
+
+	curfb = 1;
+	__poison();
+	__retrace();
+	for(line=0;line<CON_HEIGHT;line++) {
+		if(__marked(line)!=0) return 1;
+	}
+	return (rows==CON_HEIGHT/FONT_YSIZE && cols==CON_WIDTH/FONT_XSIZE) ? 0 : 1;
+}
+
+/*---------------------------------------------------------------------------------*/
+
+#define BENCH_GLYPHS			(1024*1024)
+#define BENCH_LINES				20000
+#define BENCH_LINESPERFRAME		8
+#define BENCH_FRAMES			2000
+
+static void __bench_glyphs(void)
+{
+	const u32 stride = FB_WIDTH/2;
+	console_data_s con;
+	double start,bits,lut,lut12;
+	u32 i,col,row;
+	u32 *ptr;
+
+	/* a screen of characters at a time, as printf fills it */
+	start = __cputime();
+	for(i=0;i<BENCH_GLYPHS;i++) {
+		col = i%(FB_WIDTH/8);
+		row = (i/(FB_WIDTH/8))%(FB_HEIGHT/16);
+		ptr = screen + row*16*stride + col*4;
+		__bitsglyph(ptr,&console_font_8x16[(i&0x7f)*FONT_YSIZE],stride - 4,pairs[(i>>12)%6][0],pairs[(i>>12)%6][1]);
+	}
+	bits = __cputime() - start;
+
+	__glyphcon(&con,console_font_8x16,FONT_XSIZE,FONT_YSIZE,0,256,stride);
+	start = __cputime();
+	for(i=0;i<BENCH_GLYPHS;i++) {
+		col = i%(FB_WIDTH/8);
+		row = (i/(FB_WIDTH/8))%(FB_HEIGHT/16);
+		ptr = screen + row*16*stride + col*4;
+		__console_drawglyph(&con,ptr,i&0x7f,pairs[(i>>12)%6][0],pairs[(i>>12)%6][1]);
+	}
+	lut = __cputime() - start;
+
+	__randfont(12,20,96,0x77);
+	__glyphcon(&con,font,12,20,32,96,stride);
+	start = __cputime();
+	for(i=0;i<BENCH_GLYPHS;i++) {
+		col = i%(FB_WIDTH/12);
+		row = (i/(FB_WIDTH/12))%(FB_HEIGHT/20);
+		ptr = screen + row*20*stride + col*6;
+		__console_drawglyph(&con,ptr,32 + (i%96),pairs[(i>>12)%6][0],pairs[(i>>12)%6][1]);
+	}
+	lut12 = __cputime() - start;
+
+	printf("%-24s %8.2f Mchar/s\n","glyph bit tests 8x16",BENCH_GLYPHS/bits*1e-6);
+	printf("%-24s %8.2f Mchar/s\n","glyph lookup 8x16",BENCH_GLYPHS/lut*1e-6);
+	printf("%-24s %8.2f Mchar/s\n","glyph lookup 12x20",BENCH_GLYPHS/lut12*1e-6);
+}
+
+/* heavy logging: full lines, a retrace every BENCH_LINESPERFRAME of them */
+static void __bench_printf(int grid)
+{
+	char line[80];
+	double start,t;
+	u32 i,len;
+
+	__open(grid);
+	start = __cputime();
+	for(i=0;i<BENCH_LINES;i++) {
+		len = sprintf(line,"\x1b[3%um%06u retrace 0x%08x sector %8u read ok timeout %u\n",i%8,i,i*2654435761u,i*7,i%100);
+		__write(line,len);
+		if((i%BENCH_LINESPERFRAME)==BENCH_LINESPERFRAME - 1) __retrace();
+	}
+	t = __cputime() - start;
+	printf("%-24s %8.2f us/line\n",grid ? "printf grid" : "printf no grid",t*1e6/BENCH_LINES);
+
+	start = __cputime();
+	for(i=0;i<BENCH_FRAMES;i++) __retrace();
+	t = __cputime() - start;
+	printf("%-24s %8.2f us/frame\n",grid ? "idle retrace grid" : "idle retrace no grid",t*1e6/BENCH_FRAMES);
+}
+
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "glyphs",			__test_glyphs },
+	{ "fonts",			__test_fonts },
+	{ "grid",			__test_grid },
+	{ "grid fonts",		__test_grid_fonts },
+	{ "dirty rows",		__test_dirty },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		__bench_glyphs();
+		__bench_printf(0);
+		__bench_printf(1);
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	int i;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,66 @@
+/*-------------------------------------------------------------
+
+iosupport.h -- the newlib device table, for host builds
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * The devoptab_t layout and the stdio extensions of newlib that
+ * libogc/console.c uses; the test that builds it defines the functions.
+ */
+
+#ifndef __HOST_IOSUPPORT_H__
+#define __HOST_IOSUPPORT_H__
+
+#include <stdio.h>
+#include <reent.h>
+#include <sys/stat.h>
+
+#define STD_IN		0
+#define STD_OUT		1
+#define STD_ERR		2
+#define STD_MAX		35
+
+typedef struct {
+	const char *name;
+	int structSize;
+	void *open_r;
+	void *close_r;
+	ssize_t (*write_r)(struct _reent *r,void *fd,const char *ptr,size_t len);
+	void *read_r;
+	void *seek_r;
+	int (*fstat_r)(struct _reent *r,void *fd,struct stat *st);
+	void *stat_r,*link_r,*unlink_r,*chdir_r,*rename_r,*mkdir_r;
+	int dirStateSize;
+	void *diropen_r,*dirreset_r,*dirnext_r,*dirclose_r,*statvfs_r,*ftruncate_r,*fsync_r,*deviceData;
+	void *chmod_r,*fchmod_r,*rmdir_r,*lstat_r,*utimes_r,*fpathconf_r,*pathconf_r,*symlink_r,*readlink_r;
+} devoptab_t;
+
+extern const devoptab_t *devoptab_list[STD_MAX];
+
+FILE* funopen(const void *cookie,int (*readfn)(void *,char *,size_t),int (*writefn)(void *,const char *,size_t),fpos_t (*seekfn)(void *,fpos_t,int),int (*closefn)(void *));
+FILE* fwopen(const void *cookie,int (*writefn)(void *,const char *,size_t));
+size_t _fwrite_unlocked_r(struct _reent *r,const void *buf,size_t size,size_t count,FILE *fp);
+
+#endif
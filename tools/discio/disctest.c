@@ -0,0 +1,485 @@
+/*-------------------------------------------------------------
+
+disctest.c -- file-backed tests of the DISC_INTERFACE bounce buffers and sector cache
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/disc_io.c as it is, on the simulated kernel of lwpsim/, in
+ * front of a medium backed by a temporary file. The medium logs every write
+ * it gets and can be made to fail them, so that write-back order, coalescing
+ * and what survives a failed flush can be checked against a shadow copy.
+ *
+ * For the bounce buffers the medium takes the part of a DMA driver: it fails
+ * any transfer that is misaligned or reaches into a region the simulated DMA
+ * cannot, and counts the sectors it moved straight to the caller's buffer
+ * and those that went through a bounce buffer and had to be copied.
+ *
+ *   disctest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "disc_io.h"
+
+#define SECTOR_SIZE				512
+#define DISC_SECTORS			1024
+#define CACHE_SECTORS			32
+
+#define MAX_WRITES				4096
+
+#define DMA_ALIGN				32
+#define NODMA_SIZE				(16*SECTOR_SIZE)
+
+typedef struct _wrlog {
+	sec_t sector;
+	sec_t count;
+} wrlog;
+
+static int fd = -1;
+static u8 shadow[DISC_SECTORS*SECTOR_SIZE];
+static u8 buf[DISC_SECTORS*SECTOR_SIZE] ATTRIBUTE_ALIGN(32);
+
+static wrlog writes[MAX_WRITES];
+static u32 nwrites;
+static u32 nreads;
+static u32 startups;
+static bool failwrites;
+
+static sem_t idle;
+
+/* a DMA-capable area directly followed by one the DMA cannot reach */
+static struct {
+	u8 dma[DISC_SECTORS*SECTOR_SIZE + DMA_ALIGN];
+	u8 nodma[NODMA_SIZE];
+} region ATTRIBUTE_ALIGN(32);
+
+static const u8 *userbuf;
+static u32 userlen;
+static u32 direct;
+static u32 bounced;
+static u32 violations;
+
+bool SYS_IsDMAAddress(const void *addr,u32 align)
+{
+	const u8 *ptr = addr;
+
+	if((uintptr_t)ptr&(align-1)) return false;
+	return !(ptr>=region.nodma && ptr<region.nodma+NODMA_SIZE);
+}
+
+/*---------------------------------------------------------------------------------*/
+static bool __file_startup(DISC_INTERFACE *disc)
+{
+	startups++;
+	return true;
+}
+
+static bool __file_isinserted(DISC_INTERFACE *disc)
+{
+	return true;
+}
+
+static bool __file_read(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,void *buffer)
+{
+	nreads++;
+	if(sector+numSectors>DISC_SECTORS) return false;
+	return pread(fd,buffer,numSectors*SECTOR_SIZE,sector*SECTOR_SIZE)==(ssize_t)(numSectors*SECTOR_SIZE);
+}
+
+static bool __file_write(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,const void *buffer)
+{
+	if(failwrites || sector+numSectors>DISC_SECTORS) return false;
+	if(nwrites<MAX_WRITES) {
+		writes[nwrites].sector = sector;
+		writes[nwrites].count = numSectors;
+	}
+	nwrites++;
+	return pwrite(fd,buffer,numSectors*SECTOR_SIZE,sector*SECTOR_SIZE)==(ssize_t)(numSectors*SECTOR_SIZE);
+}
+
+/* transfers that the bounce buffers hand on must be usable for DMA throughout */
+static bool __dma_check(const u8 *ptr,sec_t numSectors)
+{
+	if(!SYS_IsDMAAddress(ptr,DMA_ALIGN) || !SYS_IsDMAAddress(ptr+numSectors*SECTOR_SIZE-1,1)
+	   || (ptr<region.nodma+NODMA_SIZE && ptr+numSectors*SECTOR_SIZE>region.nodma)) {
+		violations++;
+		return false;
+	}
+	if(ptr>=userbuf && ptr<userbuf+userlen) direct += numSectors;
+	else bounced += numSectors;
+	return true;
+}
+
+static bool __dma_read(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,void *buffer)
+{
+	return __dma_check(buffer,numSectors) && __file_read(disc,sector,numSectors,buffer);
+}
+
+static bool __dma_write(DISC_INTERFACE *disc,sec_t sector,sec_t numSectors,const void *buffer)
+{
+	return __dma_check(buffer,numSectors) && __file_write(disc,sector,numSectors,buffer);
+}
+
+static bool __file_flush(DISC_INTERFACE *disc)
+{
+	return true;
+}
+
+static bool __file_shutdown(DISC_INTERFACE *disc)
+{
+	return true;
+}
+
+static DISC_INTERFACE filedisc = {
+	0x46494c45,
+	FEATURE_MEDIUM_CANREAD|FEATURE_MEDIUM_CANWRITE,
+	__file_startup,
+	__file_isinserted,
+	__file_read,
+	__file_write,
+	NULL,
+	__file_flush,
+	__file_shutdown,
+	DISC_SECTORS,
+	1,
+	SECTOR_SIZE
+};
+
+static void __reset(void)
+{
+	memset(shadow,0,sizeof(shadow));
+	if(ftruncate(fd,0) || ftruncate(fd,sizeof(shadow))) exit(1);
+	nwrites = nreads = startups = 0;
+	failwrites = false;
+	direct = bounced = violations = 0;
+}
+
+/* every sector holds its number and a generation, so stale data shows */
+static void __fill(u8 *ptr,sec_t sector,sec_t count,u32 gen)
+{
+	u32 i,j;
+
+	for(i=0;i<count;i++,ptr+=SECTOR_SIZE) {
+		for(j=0;j<SECTOR_SIZE;j+=8) {
+			*(u32*)(ptr+j) = (u32)(sector+i);
+			*(u32*)(ptr+j+4) = gen*0x9e3779b1 + j;
+		}
+	}
+}
+
+static bool __write(DISC_INTERFACE *cache,sec_t sector,sec_t count,u32 gen)
+{
+	__fill(buf,sector,count,gen);
+	memcpy(shadow+sector*SECTOR_SIZE,buf,count*SECTOR_SIZE);
+	return cache->writeSectors(cache,sector,count,buf);
+}
+
+static bool __readcheck(DISC_INTERFACE *cache,sec_t sector,sec_t count)
+{
+	memset(buf,0xa5,count*SECTOR_SIZE);
+	if(!cache->readSectors(cache,sector,count,buf)) return false;
+	return !memcmp(buf,shadow+sector*SECTOR_SIZE,count*SECTOR_SIZE);
+}
+
+/* what the medium holds, not the cache */
+static bool __medium(sec_t sector,sec_t count)
+{
+	static u8 tmp[DISC_SECTORS*SECTOR_SIZE];
+
+	if(pread(fd,tmp,count*SECTOR_SIZE,sector*SECTOR_SIZE)!=(ssize_t)(count*SECTOR_SIZE)) return false;
+	return !memcmp(tmp,shadow+sector*SECTOR_SIZE,count*SECTOR_SIZE);
+}
+
+static bool __logged(u32 i,sec_t sector,sec_t count)
+{
+	return i<nwrites && writes[i].sector==sector && writes[i].count==count;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* run a transfer through the bounce buffers and check the caller's buffer against the medium */
+static bool __bounceread(u8 *ptr,sec_t sector,sec_t count)
+{
+	bool ok;
+
+	userbuf = ptr;
+	userlen = count*SECTOR_SIZE;
+	memset(ptr,0xa5,count*SECTOR_SIZE);
+	ok = disc_bounceReadSectors(&filedisc,sector,count,ptr,DMA_ALIGN,__dma_read);
+	return ok && !violations && !memcmp(ptr,shadow+sector*SECTOR_SIZE,count*SECTOR_SIZE);
+}
+
+static bool __bouncewrite(u8 *ptr,sec_t sector,sec_t count,u32 gen)
+{
+	bool ok;
+
+	userbuf = ptr;
+	userlen = count*SECTOR_SIZE;
+	__fill(ptr,sector,count,gen);
+	memcpy(shadow+sector*SECTOR_SIZE,ptr,count*SECTOR_SIZE);
+	ok = disc_bounceWriteSectors(&filedisc,sector,count,ptr,DMA_ALIGN,__dma_write);
+	return ok && !violations && __medium(sector,count);
+}
+
+static void __seed(sec_t sector,sec_t count)
+{
+	__fill(shadow+sector*SECTOR_SIZE,sector,count,7);
+	if(pwrite(fd,shadow+sector*SECTOR_SIZE,count*SECTOR_SIZE,sector*SECTOR_SIZE)!=(ssize_t)(count*SECTOR_SIZE)) exit(1);
+}
+
+/* a misaligned read gets all but one sector by DMA into the caller's buffer */
+static int __test_misaligned(void)
+{
+	int ok;
+	u32 off;
+
+	for(off=1;off<DMA_ALIGN;off+=3) {
+		__reset();
+		__seed(0,256);
+		ok = __bounceread(region.dma+off,3,200) && direct==199 && bounced==1;
+		if(ok) {
+			direct = bounced = 0;
+			ok = __bounceread(region.dma+off,40,1) && direct==0 && bounced==1;
+		}
+		if(!ok) return 1;
+	}
+	return 0;
+}
+
+/* writes from a misaligned buffer cannot be moved, they are all bounced */
+static int __test_misalignedwrite(void)
+{
+	__reset();
+	return !(__bouncewrite(region.dma+4,5,150,1) && direct==0 && bounced==150);
+}
+
+/* a buffer that ends right where DMA stops reaching is still taken whole */
+static int __test_dmaend(void)
+{
+	u8 *ptr = region.nodma - 8*SECTOR_SIZE;
+
+	__reset();
+	__seed(0,64);
+	return !(__bounceread(ptr,16,8) && direct==8 && bounced==0);
+}
+
+/* the part of a buffer that lies out of DMA reach is bounced, the rest is not */
+static int __test_straddle(void)
+{
+	int ok;
+	u8 *ptr = region.nodma - 4*SECTOR_SIZE;
+
+	__reset();
+	__seed(0,64);
+	ok = __bounceread(ptr,10,12) && direct==4 && bounced==8;
+	direct = bounced = 0;
+	ok = ok && __bouncewrite(ptr,30,12,2) && direct==4 && bounced==8;
+	return !ok;
+}
+
+/* writes stay in the cache until a flush, which writes a sequential run at once */
+static int __test_writeback(void)
+{
+	int ok;
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,0);
+	if(!cache) return 1;
+
+	ok = __write(cache,10,4,1) && nwrites==0 && !__medium(10,4) && __readcheck(cache,10,4);
+	ok = ok && cache->flush(cache) && nwrites==1 && __logged(0,10,4) && __medium(10,4);
+	return !(disc_cacheDestroy(cache) && ok);
+}
+
+/* a sector rewritten before the flush keeps the place of its first write */
+static int __test_order(void)
+{
+	int ok;
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,0);
+	if(!cache) return 1;
+
+	ok = __write(cache,100,1,1) && __write(cache,200,1,1) && __write(cache,100,1,2) && __write(cache,101,1,1);
+	ok = ok && cache->flush(cache) && nwrites==3
+		&& __logged(0,100,1) && __logged(1,200,1) && __logged(2,101,1) && __medium(100,2) && __medium(200,1);
+	return !(disc_cacheDestroy(cache) && ok);
+}
+
+/* restarting the medium writes back what is pending before emptying the cache */
+static int __test_restart(void)
+{
+	int ok;
+	u32 reads;
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,0);
+	if(!cache) return 1;
+
+	ok = __write(cache,300,2,1) && cache->startup(cache) && startups==1 && __medium(300,2);
+
+	/* the cache is empty afterwards: reading goes to the medium */
+	reads = nreads;
+	ok = ok && __readcheck(cache,300,2) && nreads==reads+1;
+	return !(disc_cacheDestroy(cache) && ok);
+}
+
+/* a restart that cannot write back keeps the dirty sectors for the next flush */
+static int __test_restartfail(void)
+{
+	int ok;
+	u32 reads;
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,0);
+	if(!cache) return 1;
+
+	ok = __write(cache,500,1,1) && cache->flush(cache) && __write(cache,400,3,1);
+	failwrites = true;
+	ok = ok && cache->startup(cache) && !__medium(400,3);
+	failwrites = false;
+
+	/* the dirty sectors still read back from the cache, the clean one was dropped */
+	reads = nreads;
+	ok = ok && __readcheck(cache,400,3) && nreads==reads;
+	ok = ok && __readcheck(cache,500,1) && nreads==reads+1;
+	ok = ok && cache->flush(cache) && __medium(400,3);
+	return !(disc_cacheDestroy(cache) && ok);
+}
+
+/* the flusher writes back on its own once the oldest write is old enough */
+static int __test_flusher(void)
+{
+	int ok;
+	struct timespec ts = {0,200*TB_NSPERMS};
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,20);
+	if(!cache) return 1;
+
+	ok = __write(cache,700,1,1) && nwrites==0;
+	LWP_SemTimedWait(idle,&ts);
+	ok = ok && nwrites==1 && __medium(700,1);
+	return !(disc_cacheDestroy(cache) && ok);
+}
+
+/* random reads, writes larger and smaller than the cache, and flushes, against the shadow copy */
+static int __test_random(void)
+{
+	int ok = 1;
+	u32 i,op,seed = 12345;
+	sec_t sector,count;
+	DISC_INTERFACE *cache;
+
+	__reset();
+	cache = disc_cacheCreate(&filedisc,CACHE_SECTORS*SECTOR_SIZE,0);
+	if(!cache) return 1;
+
+	for(i=0;i<20000 && ok;i++) {
+		seed = seed*1103515245 + 12345;
+		op = (seed>>16)%16;
+		seed = seed*1103515245 + 12345;
+		sector = (seed>>16)%(4*CACHE_SECTORS);
+		count = 1 + op%8;
+		if(op==15) count = CACHE_SECTORS;
+
+		if(op<6) ok = __readcheck(cache,sector,count);
+		else if(op<14 || op==15) ok = __write(cache,sector,count,i);
+		else ok = cache->flush(cache);
+	}
+	ok = ok && disc_cacheDestroy(cache) && __medium(0,DISC_SECTORS);
+	return !ok;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "misaligned",		__test_misaligned },
+	{ "misalignedwrite",__test_misalignedwrite },
+	{ "dmaend",			__test_dmaend },
+	{ "straddle",		__test_straddle },
+	{ "writeback",		__test_writeback },
+	{ "order",			__test_order },
+	{ "restart",		__test_restart },
+	{ "restartfail",	__test_restartfail },
+	{ "flusher",		__test_flusher },
+	{ "random",			__test_random },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&idle,0,1);
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+	LWP_SemDestroy(idle);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	char path[] = "/tmp/disctestXXXXXX";
+	int ret;
+
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	fd = mkstemp(path);
+	if(fd<0) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path);
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	ret = simcpu_run(__main);
+	close(fd);
+	return ret;
+}
@@ -0,0 +1,569 @@
+/*-------------------------------------------------------------
+
+dvdtest.c -- DVD command queue tests against a simulated drive
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/dvd.c as it is, on the simulated kernel of lwpsim/, in front
+ * of a simulated drive. The DI registers are mapped where the driver expects
+ * them; a thread above every other priority picks up each command the driver
+ * starts, transfers a synthetic disc image to the DMA address, and raises the
+ * transfer-complete interrupt with interrupts disabled.
+ *
+ * The drive logs every command and keeps a model of its head: each read costs
+ * a fixed command overhead plus its transfer time, and each head movement a
+ * seek time that grows with the distance, so that queue policies can be
+ * compared by the seek distance and drive time they cause.
+ *
+ *   dvdtest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "irq.h"
+#include "cache.h"
+#include "dvd.h"
+
+#define STACKSIZE				(64*1024)
+
+#define DI_BASE					0xCD806000
+#define DI_READ					0xA8000000
+#define DI_SEEK					0xAB000000
+#define DI_START				(1<<0)
+#define DI_DE_INT				(1<<2)
+#define DI_TC_INT				(1<<4)
+#define DI_BRK_INT				(1<<6)
+
+#define DISC_SIZE				1459978240LL
+
+#define DRIVE_CMD_US			500
+#define DRIVE_SEEK_US			20000
+#define DRIVE_STROKE_US			80000
+#define DRIVE_BYTES_PER_US		3
+
+#define MAX_CMDS				1024
+
+#define PF_CHUNK				(32*1024)
+#define PF_BASE					0x00100000LL
+#define FAR_OFFSET				0x40000000LL
+
+#define ELEV_READS				12
+#define ELEV_START				0x20000000LL
+#define MERGE_BASE				0x00800000LL
+#define MERGE_LEN				8192
+
+typedef struct _drivecmd {
+	u32 cmd;
+	s64 offset;
+	u32 len;
+} drivecmd;
+
+static vu32 *di;
+static irq_handler_t dihandler;
+static volatile bool drivestop;
+static lwp_t drivethread = LWP_THREAD_NULL;
+
+static drivecmd cmds[MAX_CMDS];
+static u32 ncmds;
+static s64 head;
+static u32 seeks;
+static u64 seekdist;
+static u64 drivetime;
+
+static void (*flushhook)(void);
+
+static u8 ring[4*PF_CHUNK] ATTRIBUTE_ALIGN(32);
+static u8 data[256*1024] ATTRIBUTE_ALIGN(32);
+static u8 other[PF_CHUNK] ATTRIBUTE_ALIGN(32);
+
+/*---------------------------------------------------------------------------------*/
+irq_handler_t IRQ_Request(u32 nIrq,irq_handler_t pHndl)
+{
+	irq_handler_t old = dihandler;
+
+	if(nIrq==IRQ_PI_DI) dihandler = pHndl;
+	return old;
+}
+
+void __MaskIrq(u32 nMask) {}
+void __UnmaskIrq(u32 nMask) {}
+
+s32 SYS_CreateAlarm(syswd_t *thealarm)
+{
+	*thealarm = 1;
+	return 0;
+}
+
+/* the drive always answers, the command timeouts never expire */
+s32 SYS_SetAlarm(syswd_t thealarm,const struct timespec *tp,alarmcallback cb,void *cbarg)
+{
+	return 0;
+}
+
+s32 SYS_CancelAlarm(syswd_t thealarm)
+{
+	return 0;
+}
+
+bool SYS_IsDMAAddress(const void *addr,u32 align)
+{
+	return !((uintptr_t)addr&(align-1));
+}
+
+void DCInvalidateRange(void *startaddress,u32 len) {}
+void DCStoreRange(void *startaddress,u32 len) {}
+
+void DCFlushRange(void *startaddress,u32 len)
+{
+	void (*hook)(void) = flushhook;
+
+	flushhook = NULL;
+	if(hook) hook();
+}
+
+void udelay(u32 usec) {}
+
+u32 diff_msec(u64 start,u64 end)
+{
+	return ticks_to_millisecs(diff_ticks(start,end));
+}
+
+static syssramex sramex;
+
+syssramex* __SYS_LockSramEx(void)
+{
+	return &sramex;
+}
+
+u32 __SYS_UnlockSramEx(u32 write)
+{
+	return 0;
+}
+
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static inline u8 __discbyte(s64 pos)
+{
+	return (u8)(pos*7 + (pos>>11)*13 + (pos>>19));
+}
+
+static bool __disccheck(const u8 *ptr,s64 offset,u32 len)
+{
+	u32 i;
+
+	for(i=0;i<len;i++) {
+		if(ptr[i]!=__discbyte(offset+i)) return false;
+	}
+	return true;
+}
+
+static void __drivemove(s64 offset,u32 len)
+{
+	u64 dist = (offset>head) ? (offset-head) : (head-offset);
+
+	if(dist) {
+		seeks++;
+		seekdist += dist;
+		drivetime += DRIVE_SEEK_US + (dist*DRIVE_STROKE_US)/DISC_SIZE;
+	}
+	drivetime += DRIVE_CMD_US + len/DRIVE_BYTES_PER_US;
+	head = offset+len;
+}
+
+/* one command per poll, completed a poll later as the DI interrupt would */
+static void* __drive(void *arg)
+{
+	u32 i,cmd,len,level;
+	s64 offset;
+	u8 *buf;
+
+	while(!drivestop) {
+		if(!(di[7]&DI_START)) {
+			__sleep(1);
+			continue;
+		}
+		__sleep(1);
+
+		cmd = di[2];
+		offset = (s64)di[3]<<2;
+		len = di[4];
+		buf = (u8*)(uintptr_t)di[5];
+
+		if(cmd==DI_READ) {
+			for(i=0;i<len;i++) buf[i] = __discbyte(offset+i);
+			__drivemove(offset,len);
+		} else if(cmd==DI_SEEK)
+			__drivemove(offset,0);
+
+		if(ncmds<MAX_CMDS) {
+			cmds[ncmds].cmd = cmd;
+			cmds[ncmds].offset = offset;
+			cmds[ncmds].len = len;
+		}
+		ncmds++;
+
+		_CPU_ISR_Disable(level);
+		di[6] = 0;
+		di[7] &= ~DI_START;
+		di[0] |= DI_TC_INT;
+		dihandler(IRQ_PI_DI,NULL);
+		di[0] &= ~(DI_DE_INT|DI_TC_INT|DI_BRK_INT);
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+static void __drivereset(void)
+{
+	ncmds = 0;
+	seeks = 0;
+	seekdist = 0;
+	drivetime = 0;
+}
+
+/* waits until the drive has nothing left to do */
+static void __driveidle(void)
+{
+	u32 n;
+
+	do {
+		n = ncmds;
+		__sleep(5);
+	} while(n!=ncmds || (di[7]&DI_START));
+}
+
+/*---------------------------------------------------------------------------------*/
+static sem_t donesem;
+
+static void __done(s32 result,dvdcmdblk *block)
+{
+	LWP_SemPost(donesem);
+}
+
+static bool __waitdone(u32 count)
+{
+	struct timespec ts = {1,0};
+
+	while(count--) {
+		if(LWP_SemTimedWait(donesem,&ts)) return false;
+	}
+	return true;
+}
+
+/* sequential reads are served from the ring, the drive only sees whole chunks */
+static int __test_prefetch(void)
+{
+	u32 i;
+	dvdcmdblk blk;
+	dvdprefetchstats st;
+
+	if(DVD_SetPrefetch(ring,sizeof(ring))!=DVD_ERROR_OK) return 1;
+	__drivereset();
+
+	for(i=0;i<64;i++) {
+		if(DVD_ReadAbs(&blk,data+i*4096,4096,PF_BASE+i*4096)!=4096) return 1;
+	}
+	if(!__disccheck(data,PF_BASE,64*4096)) return 1;
+	__driveidle();
+
+	DVD_GetPrefetchStats(&st);
+	printf("%-16s %u hits, %u misses, %u drive reads for 64\n","",st.hits,st.misses,ncmds);
+	if(st.hits<60 || st.misses>2 || ncmds>16) return 1;
+	return DVD_SetPrefetch(NULL,0)!=DVD_ERROR_OK;
+}
+
+/* a demand read elsewhere, even an asynchronous one, cancels the queued prefetches */
+static int __test_demand(void)
+{
+	u32 i,after;
+	dvdcmdblk blk,dblk;
+	dvdprefetchstats st;
+
+	if(DVD_SetPrefetch(ring,sizeof(ring))!=DVD_ERROR_OK) return 1;
+	__drivereset();
+
+	if(DVD_ReadAbs(&blk,data,4096,PF_BASE)!=4096) return 1;
+	if(DVD_ReadAbs(&blk,data,4096,PF_BASE+4096)!=4096) return 1;
+	if(!DVD_ReadAbsAsync(&dblk,other,sizeof(other),FAR_OFFSET,__done)) return 1;
+	if(!__waitdone(1) || dblk.state!=DVD_STATE_END) return 1;
+	if(!__disccheck(other,FAR_OFFSET,sizeof(other))) return 1;
+	__driveidle();
+
+	for(i=0;i<ncmds && cmds[i].offset!=FAR_OFFSET;i++);
+	after = 0;
+	for(i++;i<ncmds;i++) {
+		if(cmds[i].offset>=PF_BASE && cmds[i].offset<PF_BASE+sizeof(ring)+8192) after++;
+	}
+
+	DVD_GetPrefetchStats(&st);
+	printf("%-16s %u prefetches after the demand read, %llu bytes wasted\n","",after,(unsigned long long)st.bytes_wasted);
+	if(after) return 1;
+	return DVD_SetPrefetch(NULL,0)!=DVD_ERROR_OK;
+}
+
+static s32 raceret;
+
+/* runs where the copy out of the ring has interrupts enabled, as another thread could */
+static void __racedemand(void)
+{
+	dvdcmdblk blk;
+
+	raceret = DVD_ReadAbs(&blk,other,sizeof(other),FAR_OFFSET);
+}
+
+/* a read spanning slots still completes when the ring is dropped under it */
+static int __test_race(void)
+{
+	dvdcmdblk blk;
+	s64 offset = PF_BASE+8192;
+
+	if(DVD_SetPrefetch(ring,sizeof(ring))!=DVD_ERROR_OK) return 1;
+	__drivereset();
+
+	if(DVD_ReadAbs(&blk,data,4096,PF_BASE)!=4096) return 1;
+	if(DVD_ReadAbs(&blk,data,4096,PF_BASE+4096)!=4096) return 1;
+
+	memset(data,0,2*PF_CHUNK);
+	flushhook = __racedemand;
+	if(DVD_ReadAbs(&blk,data,2*PF_CHUNK,offset)!=2*PF_CHUNK) return 1;
+	if(flushhook || !__disccheck(data,offset,2*PF_CHUNK)) return 1;
+
+	if(raceret!=sizeof(other) || !__disccheck(other,FAR_OFFSET,sizeof(other))) return 1;
+	__driveidle();
+	return DVD_SetPrefetch(NULL,0)!=DVD_ERROR_OK;
+}
+
+static u64 __elevatorrun(u32 policy,u64 *time)
+{
+	u32 i,level,seed = 12345;
+	s64 offsets[ELEV_READS];
+	dvdcmdblk blks[ELEV_READS];
+
+	DVD_SetQueuePolicy(policy);
+	if(DVD_ReadAbs(&blks[0],other,2048,ELEV_START)!=2048) return 0;
+	__driveidle();
+	__drivereset();
+
+	// all queued at once, behind the first that goes straight to the drive
+	_CPU_ISR_Disable(level);
+	for(i=0;i<ELEV_READS;i++) {
+		seed = seed*1103515245 + 12345;
+		offsets[i] = (s64)((seed>>8)%(DISC_SIZE>>11))<<11;
+		DVD_ReadAbsAsync(&blks[i],data+i*2048,2048,offsets[i],__done);
+	}
+	_CPU_ISR_Restore(level);
+	if(!__waitdone(ELEV_READS)) return 0;
+
+	for(i=0;i<ELEV_READS;i++) {
+		if(blks[i].state!=DVD_STATE_END || !__disccheck(data+i*2048,offsets[i],2048)) return 0;
+	}
+	*time = drivetime;
+	return seekdist;
+}
+
+/* C-LOOK serves the queue in one sweep up from the head, wrapping once */
+static int __test_elevator(void)
+{
+	u32 i,wraps;
+	u64 fifodist,elevdist,fifotime,elevtime;
+
+	if(!(fifodist=__elevatorrun(DVD_QUEUE_FIFO,&fifotime))) return 1;
+	if(!(elevdist=__elevatorrun(DVD_QUEUE_ELEVATOR,&elevtime))) return 1;
+
+	wraps = 0;
+	for(i=2;i<ncmds;i++) {
+		if(cmds[i].offset<cmds[i-1].offset) wraps++;
+	}
+	DVD_SetQueuePolicy(DVD_QUEUE_FIFO);
+
+	printf("%-16s fifo %llu MiB seeked, %llu ms; elevator %llu MiB, %llu ms\n","",
+		(unsigned long long)(fifodist>>20),(unsigned long long)(fifotime/1000),
+		(unsigned long long)(elevdist>>20),(unsigned long long)(elevtime/1000));
+	return ncmds!=ELEV_READS || wraps>1 || elevdist*2>fifodist || elevtime>=fifotime;
+}
+
+/* reads continuing each other on disc make one transfer, wherever their buffers are */
+static int __test_merge(void)
+{
+	u32 i,level;
+	dvdcmdblk blocker,blks[4];
+	const u32 order[4] = {2,0,3,1};
+	const s64 offsets[4] = {MERGE_BASE,MERGE_BASE+MERGE_LEN,MERGE_BASE+2*MERGE_LEN,MERGE_BASE+3*MERGE_LEN+4096};
+
+	if(DVD_SetMergeBuffer(ring+1,sizeof(ring))!=DVD_ERROR_FATAL) return 1;
+	if(DVD_SetMergeBuffer(ring,sizeof(ring))!=DVD_ERROR_OK) return 1;
+	DVD_SetQueuePolicy(DVD_QUEUE_ELEVATOR|DVD_QUEUE_MERGE);
+	__drivereset();
+
+	// scattered buffers, submitted out of order, the last one a small gap further on
+	memset(data,0,sizeof(data));
+	_CPU_ISR_Disable(level);
+	DVD_ReadAbsAsync(&blocker,other,2048,FAR_OFFSET,__done);
+	for(i=0;i<4;i++) DVD_ReadAbsAsync(&blks[order[i]],data+order[i]*2*MERGE_LEN,MERGE_LEN,offsets[order[i]],__done);
+	_CPU_ISR_Restore(level);
+	if(!__waitdone(5)) return 1;
+
+	for(i=0;i<4;i++) {
+		if(blks[i].state!=DVD_STATE_END || blks[i].txdsize!=MERGE_LEN) return 1;
+		if(!__disccheck(data+i*2*MERGE_LEN,offsets[i],MERGE_LEN)) return 1;
+	}
+	if(ncmds!=2 || cmds[1].offset!=MERGE_BASE || cmds[1].len!=4*MERGE_LEN+4096) return 1;
+
+	// without the buffer only reads that continue in memory too are merged
+	if(DVD_SetMergeBuffer(NULL,0)!=DVD_ERROR_OK) return 1;
+	DVD_SetQueuePolicy(DVD_QUEUE_MERGE);
+	__driveidle();
+	__drivereset();
+
+	_CPU_ISR_Disable(level);
+	DVD_ReadAbsAsync(&blocker,other,2048,FAR_OFFSET,__done);
+	for(i=0;i<4;i++) DVD_ReadAbsAsync(&blks[i],data+i*MERGE_LEN+(i==3)*32,MERGE_LEN,MERGE_BASE+i*MERGE_LEN,__done);
+	_CPU_ISR_Restore(level);
+	if(!__waitdone(5)) return 1;
+
+	for(i=0;i<4;i++) {
+		if(blks[i].state!=DVD_STATE_END) return 1;
+		if(!__disccheck(data+i*MERGE_LEN+(i==3)*32,MERGE_BASE+i*MERGE_LEN,MERGE_LEN)) return 1;
+	}
+	DVD_SetQueuePolicy(DVD_QUEUE_FIFO);
+	return ncmds!=3 || cmds[1].len!=3*MERGE_LEN || cmds[2].len!=MERGE_LEN;
+}
+
+static u32 cancelcbs;
+
+static void __cancelled(s32 result,dvdcmdblk *block)
+{
+	cancelcbs++;
+}
+
+/* cancelling one read of a merged transfer fails only that one */
+static int __test_mergecancel(void)
+{
+	u32 i,level;
+	dvdcmdblk blocker,blks[3];
+
+	if(DVD_SetMergeBuffer(ring,sizeof(ring))!=DVD_ERROR_OK) return 1;
+	DVD_SetQueuePolicy(DVD_QUEUE_MERGE);
+	__drivereset();
+	cancelcbs = 0;
+
+	memset(data,0,sizeof(data));
+	_CPU_ISR_Disable(level);
+	DVD_ReadAbsAsync(&blocker,other,2048,FAR_OFFSET,__done);
+	for(i=0;i<3;i++) DVD_ReadAbsAsync(&blks[i],data+i*2*MERGE_LEN,MERGE_LEN,MERGE_BASE+i*MERGE_LEN,__done);
+	_CPU_ISR_Restore(level);
+
+	// the three go to the drive together as soon as the blocker is done
+	if(!__waitdone(1) || blocker.state!=DVD_STATE_END) return 1;
+	for(i=0;i<3;i++) {
+		if(blks[i].state!=DVD_STATE_BUSY) return 1;
+	}
+	if(!DVD_CancelAsync(&blks[1],__cancelled)) return 1;
+	if(!__waitdone(3)) return 1;
+
+	if(blks[1].state!=DVD_STATE_CANCELED || cancelcbs!=1) return 1;
+	for(i=0;i<3;i+=2) {
+		if(blks[i].state!=DVD_STATE_END || !__disccheck(data+i*2*MERGE_LEN,MERGE_BASE+i*MERGE_LEN,MERGE_LEN)) return 1;
+	}
+
+	DVD_SetQueuePolicy(DVD_QUEUE_FIFO);
+	return DVD_SetMergeBuffer(NULL,0)!=DVD_ERROR_OK;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "prefetch",		__test_prefetch },
+	{ "demand",			__test_demand },
+	{ "race",			__test_race },
+	{ "elevator",		__test_elevator },
+	{ "merge",			__test_merge },
+	{ "mergecancel",	__test_mergecancel },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&donesem,0,64);
+	DVD_Init();
+	if(LWP_CreateThread(&drivethread,__drive,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	drivestop = true;
+	LWP_JoinThread(drivethread,NULL);
+	LWP_SemDestroy(donesem);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	void *regs;
+
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	// the DI registers, where the driver addresses them
+	regs = mmap((void*)DI_BASE,4096,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE,-1,0);
+	if(regs!=(void*)DI_BASE) {
+		perror("mmap");
+		return 1;
+	}
+	di = regs;
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
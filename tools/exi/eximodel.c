@@ -0,0 +1,342 @@
+/*-------------------------------------------------------------
+
+eximodel.c -- register-level model of the EXI bus for host tests
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "lwp.h"
+#include "lwp_threads.h"
+#include "semaphore.h"
+#include "timesupp.h"
+#include "irq.h"
+#include "exi.h"
+#include "eximodel.h"
+
+#if !defined(__x86_64__)
+#error the store trap single-steps with EFLAGS.TF, x86-64 hosts only
+#endif
+
+#define STACKSIZE				(64*1024)
+
+#define EXI_PAGE				0xCD006000
+#define EXI_PAGESIZE			4096
+#define EXI_REGS				0x800			// _exiReg of the Wii build
+#define EXI_BLOCK				0x40			// the register block repeats every 0x40 bytes
+#define EXI_MIRRORS				16
+
+#define CSR_EXIINT				0x0002
+#define CSR_TCINT				0x0008
+#define CSR_EXTINT				0x0800
+#define CSR_EXT					0x1000
+#define CSR_INTS				(CSR_EXIINT|CSR_TCINT|CSR_EXTINT)
+
+#define CR_TSTART				0x01
+#define CR_DMA					0x02
+
+#define EFLAGS_TF				0x100
+
+#define IRQ_POLL_US				100
+
+static u8 *page;								// the model's writable view of the register page
+static u32 regs[EXIMODEL_CHANNELS][5];
+static s32 selected[EXIMODEL_CHANNELS] = {-1,-1,-1};
+static const eximodeldev *devs[EXIMODEL_CHANNELS][EXIMODEL_DEVICES];
+static eximodelstats stats[EXIMODEL_CHANNELS];
+
+static irq_handler_t handlers[32];
+static vu32 irqmask;
+
+static uintptr_t trapaddr;
+static int trapalarm;
+
+static volatile bool irqstop;
+static lwp_t irqthread = LWP_THREAD_NULL;
+
+/*---------------------------------------------------------------------------------*/
+irq_handler_t IRQ_Request(u32 nIrq,irq_handler_t pHndl)
+{
+	irq_handler_t old = handlers[nIrq];
+
+	handlers[nIrq] = pHndl;
+	return old;
+}
+
+irq_handler_t IRQ_GetHandler(u32 nIrq)
+{
+	return handlers[nIrq];
+}
+
+void __MaskIrq(u32 nMask)
+{
+	irqmask &= ~nMask;
+}
+
+void __UnmaskIrq(u32 nMask)
+{
+	irqmask |= nMask;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* what the driver reads back: the model's registers, in every mirror of the block */
+static void __publish(void)
+{
+	u32 i,chn,r;
+	vu32 *blk;
+
+	for(i=0;i<EXI_MIRRORS;i++) {
+		blk = (vu32*)(page+EXI_REGS+i*EXI_BLOCK);
+		for(chn=0;chn<EXIMODEL_CHANNELS;chn++) {
+			for(r=0;r<5;r++) blk[chn*5+r] = regs[chn][r];
+		}
+	}
+}
+
+static u8 __exchange(u32 chn,u8 mosi)
+{
+	u32 dev;
+	const eximodeldev *d;
+
+	if(selected[chn]<0) {
+		for(dev=0;dev<EXIMODEL_DEVICES;dev++) {
+			if((d=devs[chn][dev]) && (d->flags&EXIMODEL_NOCS)) return d->exchange(d->usr,mosi);
+		}
+		return 0xff;
+	}
+	if(!(d=devs[chn][selected[chn]])) return 0xff;
+	return d->exchange(d->usr,mosi);
+}
+
+static void __chipselect(u32 chn,u32 csr)
+{
+	s32 dev = -1;
+	const eximodeldev *d;
+
+	if(csr&0x080) dev = EXI_DEVICE_0;
+	else if(csr&0x100) dev = EXI_DEVICE_1;
+	else if(csr&0x200) dev = EXI_DEVICE_2;
+	if(dev==selected[chn]) return;
+
+	if(selected[chn]>=0 && (d=devs[chn][selected[chn]]) && d->deselect) d->deselect(d->usr);
+	selected[chn] = dev;
+	if(dev>=0) {
+		stats[chn].selects++;
+		if((d=devs[chn][dev]) && d->select) d->select(d->usr);
+	}
+}
+
+/* runs at once: the driver never sees the start bit set */
+static void __transfer(u32 chn)
+{
+	u8 *buf;
+	u32 i,len,mode,val,res;
+	u32 cr = regs[chn][3];
+
+	mode = (cr>>2)&0x03;
+	if(cr&CR_DMA) {
+		buf = (u8*)(uintptr_t)regs[chn][1];
+		len = regs[chn][2];
+		for(i=0;i<len;i++) {
+			res = __exchange(chn,mode==EXI_READ ? 0xff : buf[i]);
+			if(mode!=EXI_WRITE) buf[i] = res;
+		}
+		stats[chn].dmas++;
+		stats[chn].dmabytes += len;
+	} else {
+		len = ((cr>>4)&0x03)+1;
+		val = regs[chn][4];
+		res = 0;
+		for(i=0;i<len;i++) res |= (u32)__exchange(chn,val>>(24-i*8))<<(24-i*8);
+		if(mode!=EXI_WRITE) regs[chn][4] = res;
+		stats[chn].imms++;
+		stats[chn].immbytes += len;
+	}
+	stats[chn].bustime += EXIMODEL_XFER_NS + (u64)len*8*TB_NSPERSEC/(EXIMODEL_BASEHZ<<((regs[chn][0]>>4)&0x07));
+
+	regs[chn][3] = cr&~CR_TSTART;
+	regs[chn][0] |= CSR_TCINT;
+}
+
+/* one store of the driver to the page, already carried out in page memory */
+static void __store(u32 off)
+{
+	u32 reg,chn,r,val,old;
+
+	if(off<EXI_REGS || off>=EXI_REGS+EXI_MIRRORS*EXI_BLOCK) return;
+	val = *(vu32*)(page+(off&~3));
+	reg = ((off-EXI_REGS)%EXI_BLOCK)/4;
+	chn = reg/5;
+	r = reg%5;
+	if(chn<EXIMODEL_CHANNELS) {
+		if(r==0) {
+			// the interrupt bits clear on a one, EXT follows the device
+			old = regs[chn][0];
+			regs[chn][0] = (val&~(CSR_INTS|CSR_EXT))|(old&CSR_INTS&~val)|(old&CSR_EXT);
+			__chipselect(chn,regs[chn][0]);
+		} else {
+			regs[chn][r] = val;
+			if(r==3 && (val&CR_TSTART)) __transfer(chn);
+		}
+	}
+	__publish();
+}
+
+static void __storefault(int sig,siginfo_t *si,void *ctx)
+{
+	ucontext_t *uc = ctx;
+	uintptr_t addr = (uintptr_t)si->si_addr;
+
+	if(addr<EXI_PAGE || addr>=EXI_PAGE+EXI_PAGESIZE) {
+		// not ours: fault again, for real
+		signal(SIGSEGV,SIG_DFL);
+		return;
+	}
+
+	// let the store through and trap right after it, with the decrementer held off
+	trapaddr = addr;
+	mprotect((void*)EXI_PAGE,EXI_PAGESIZE,PROT_READ|PROT_WRITE);
+	uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+	trapalarm = !sigismember(&uc->uc_sigmask,SIGALRM);
+	sigaddset(&uc->uc_sigmask,SIGALRM);
+}
+
+static void __storestep(int sig,siginfo_t *si,void *ctx)
+{
+	ucontext_t *uc = ctx;
+
+	uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+	if(trapalarm) sigdelset(&uc->uc_sigmask,SIGALRM);
+	mprotect((void*)EXI_PAGE,EXI_PAGESIZE,PROT_READ);
+	__store(trapaddr-EXI_PAGE);
+}
+
+int eximodel_init(void)
+{
+	int fd;
+	void *view;
+	struct sigaction sa;
+
+	fd = memfd_create("exi",0);
+	if(fd<0 || ftruncate(fd,EXI_PAGESIZE)) {
+		perror("memfd_create");
+		return -1;
+	}
+	page = mmap(NULL,EXI_PAGESIZE,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+	view = mmap((void*)EXI_PAGE,EXI_PAGESIZE,PROT_READ,MAP_SHARED|MAP_FIXED_NOREPLACE,fd,0);
+	close(fd);
+	if(page==MAP_FAILED || view!=(void*)EXI_PAGE) {
+		perror("mmap");
+		return -1;
+	}
+
+	memset(&sa,0,sizeof(sa));
+	sa.sa_flags = SA_SIGINFO;
+	sigemptyset(&sa.sa_mask);
+	sigaddset(&sa.sa_mask,SIGALRM);
+	sa.sa_sigaction = __storefault;
+	sigaction(SIGSEGV,&sa,NULL);
+	sa.sa_sigaction = __storestep;
+	sigaction(SIGTRAP,&sa,NULL);
+	return 0;
+}
+
+void eximodel_attach(u32 chn,u32 dev,const eximodeldev *d)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	devs[chn][dev] = d;
+	if(chn!=EXI_CHANNEL_2 && dev==EXI_DEVICE_0) {
+		if(d) regs[chn][0] |= CSR_EXT;
+		else regs[chn][0] &= ~CSR_EXT;
+	}
+	__publish();
+	_CPU_ISR_Restore(level);
+}
+
+void eximodel_getstats(u32 chn,eximodelstats *st)
+{
+	*st = stats[chn];
+}
+
+void eximodel_resetstats(u32 chn)
+{
+	memset(&stats[chn],0,sizeof(stats[chn]));
+}
+
+/*---------------------------------------------------------------------------------*/
+/* as the external interrupt exception enters a handler */
+static void __interrupt(u32 nIrq)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	mtspr(SPRG0,mfspr(SPRG0)+1);
+	__lwp_thread_dispatchdisable();
+
+	handlers[nIrq](nIrq,NULL);
+
+	mtspr(SPRG0,mfspr(SPRG0)-1);
+	__lwp_thread_dispatchenable();
+	_CPU_ISR_Restore(level);
+}
+
+static void* __irq(void *arg)
+{
+	u32 chn,irq;
+	sem_t sem;
+	struct timespec ts = {0,IRQ_POLL_US*TB_NSPERUS};
+
+	LWP_SemInit(&sem,0,1);
+	while(!irqstop) {
+		for(chn=0;chn<EXIMODEL_CHANNELS;chn++) {
+			irq = IRQ_EXI0_TC+chn*3;
+			if((regs[chn][0]&CSR_TCINT) && (irqmask&IRQMASK(irq)) && handlers[irq]) __interrupt(irq);
+		}
+		LWP_SemTimedWait(sem,&ts);
+	}
+	LWP_SemDestroy(sem);
+	return NULL;
+}
+
+s32 eximodel_start(void)
+{
+	irqstop = false;
+	return LWP_CreateThread(&irqthread,__irq,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST);
+}
+
+void eximodel_stop(void)
+{
+	irqstop = true;
+	LWP_JoinThread(irqthread,NULL);
+	irqthread = LWP_THREAD_NULL;
+}
@@ -0,0 +1,89 @@
+/*-------------------------------------------------------------
+
+eximodel.h -- register-level model of the EXI bus for host tests
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __EXIMODEL_H__
+#define __EXIMODEL_H__
+
+/* The EXI registers of the Wii build, mapped where libogc/exi.c addresses
+   them. The page is read-only to the driver: each store to it traps, is
+   single-stepped and then carried out by the model, so that a write of the
+   control register with the start bit runs the transfer against the device
+   selected on that channel before the next instruction. The transfer
+   complete interrupt is raised by a thread above every other priority, in
+   interrupt context, through the handlers exi.c requests from IRQ_Request,
+   which the model provides along with __MaskIrq and __UnmaskIrq. */
+
+#include <gctypes.h>
+
+#define EXIMODEL_CHANNELS		3
+#define EXIMODEL_DEVICES		3
+
+#define EXIMODEL_BASEHZ			843750			// EXI_SPEED1MHZ, doubled by each step
+#define EXIMODEL_XFER_NS		1000			// CPU time to start and complete one transfer, charged to the bus
+
+#define EXIMODEL_NOCS			0x01			// also clocked with no chip select asserted, as SD adapters are (EXI_SelectSD)
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/* an SPI device on one chip select; MOSI is the byte shifted out, the return value MISO */
+typedef struct _eximodeldev {
+	void (*select)(void *usr);
+	void (*deselect)(void *usr);
+	u8 (*exchange)(void *usr,u8 mosi);
+	void *usr;
+	u32 flags;
+} eximodeldev;
+
+typedef struct _eximodelstats {
+	u32 selects;
+	u32 imms;
+	u32 dmas;
+	u64 immbytes;
+	u64 dmabytes;
+	u64 bustime;				// ns: every byte at the selected clock, plus EXIMODEL_XFER_NS per transfer
+} eximodelstats;
+
+/* maps the registers and installs the store trap, before simcpu_run */
+int eximodel_init(void);
+
+/* plugs dev in on chn, NULL unplugs; device 0 on channels 0 and 1 sets the EXT bit */
+void eximodel_attach(u32 chn,u32 dev,const eximodeldev *d);
+
+/* starts and stops the interrupt thread, on the simulated kernel */
+s32 eximodel_start(void);
+void eximodel_stop(void);
+
+void eximodel_getstats(u32 chn,eximodelstats *st);
+void eximodel_resetstats(u32 chn);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,449 @@
+/*-------------------------------------------------------------
+
+exitest.c -- EXI chain tests against a register-level model of the bus
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/exi.c as it is, on the simulated kernel of lwpsim/, against the
+ * register-level EXI model of eximodel.c with a small SPI flash on channel 0,
+ * device 1. The flash takes a five byte command, an opcode and a big-endian
+ * address; a read answers after a few busy bytes with a start token and then
+ * streams its contents, a write stores every byte that follows.
+ *
+ * The chain tests submit select, immediate, poll, DMA and deselect steps and
+ * check what the flash saw, that the chain ran from the transfer complete
+ * interrupt alone, with a single callback, and that a failed or timed out
+ * step deselects the device and ends the chain there.
+ *
+ *   exitest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwp.h"
+#include "lwp_threads.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "irq.h"
+#include "exi.h"
+#include "eximodel.h"
+
+#define FLASH_SIZE				65536
+#define FLASH_LATENCY			10				// busy bytes before the start token
+#define FLASH_TOKEN				0xfe
+
+#define CMD_READ				0x03
+#define CMD_WRITE				0x02
+
+#define TEST_CHN				EXI_CHANNEL_0
+#define TEST_DEV				EXI_DEVICE_1
+
+enum {
+	FLASH_IDLE,
+	FLASH_CMD,
+	FLASH_BUSY,
+	FLASH_READ,
+	FLASH_WRITE
+};
+
+static struct {
+	u8 mem[FLASH_SIZE];
+	u32 state;
+	u8 cmd[5];
+	u32 cmdlen;
+	u32 addr;
+	u32 busy;
+	u32 latency;
+
+	u32 selects;
+	u32 deselects;
+	u32 bytes;
+} flash;
+
+static u8 data[1024] ATTRIBUTE_ALIGN(32);
+
+extern void __exi_init(void);
+
+/*---------------------------------------------------------------------------------*/
+void DCInvalidateRange(void *startaddress,u32 len) {}
+void DCStoreRange(void *startaddress,u32 len) {}
+void DCFlushRange(void *startaddress,u32 len) {}
+
+u32 diff_msec(u64 start,u64 end)
+{
+	return ticks_to_millisecs(diff_ticks(start,end));
+}
+
+u32 SYS_GetConsoleType(void)
+{
+	return SYS_CONSOLE_RETAIL;
+}
+
+u32 sdgecko_getDevice(s32 drv_no)
+{
+	return EXI_DEVICE_0;
+}
+
+bool sdgecko_isInitialized(s32 drv_no)
+{
+	return false;
+}
+
+/*---------------------------------------------------------------------------------*/
+static inline u8 __flashbyte(u32 addr)
+{
+	return (u8)(addr*7 + (addr>>8)*13 + 0x5a);
+}
+
+static void __flashselect(void *usr)
+{
+	flash.selects++;
+	flash.state = FLASH_CMD;
+	flash.cmdlen = 0;
+}
+
+static void __flashdeselect(void *usr)
+{
+	flash.deselects++;
+	flash.state = FLASH_IDLE;
+}
+
+static u8 __flashexchange(void *usr,u8 mosi)
+{
+	u8 miso = 0xff;
+
+	flash.bytes++;
+	switch(flash.state) {
+		case FLASH_CMD:
+			flash.cmd[flash.cmdlen++] = mosi;
+			if(flash.cmdlen<sizeof(flash.cmd)) break;
+
+			flash.addr = (flash.cmd[1]<<24)|(flash.cmd[2]<<16)|(flash.cmd[3]<<8)|flash.cmd[4];
+			if(flash.cmd[0]==CMD_READ) {
+				flash.busy = flash.latency;
+				flash.state = FLASH_BUSY;
+			} else if(flash.cmd[0]==CMD_WRITE)
+				flash.state = FLASH_WRITE;
+			else
+				flash.state = FLASH_IDLE;
+			break;
+		case FLASH_BUSY:
+			if(flash.busy) flash.busy--;
+			else {
+				miso = FLASH_TOKEN;
+				flash.state = FLASH_READ;
+			}
+			break;
+		case FLASH_READ:
+			miso = flash.mem[flash.addr++%FLASH_SIZE];
+			break;
+		case FLASH_WRITE:
+			flash.mem[flash.addr++%FLASH_SIZE] = mosi;
+			break;
+	}
+	return miso;
+}
+
+static const eximodeldev flashdev = {
+	__flashselect,
+	__flashdeselect,
+	__flashexchange,
+	NULL,
+	0
+};
+
+static void __flashreset(u32 latency)
+{
+	u32 i;
+
+	for(i=0;i<FLASH_SIZE;i++) flash.mem[i] = __flashbyte(i);
+	flash.state = FLASH_IDLE;
+	flash.latency = latency;
+	flash.selects = 0;
+	flash.deselects = 0;
+	flash.bytes = 0;
+}
+
+static void __cmd(u8 *cmd,u8 op,u32 addr)
+{
+	cmd[0] = op;
+	cmd[1] = addr>>24;
+	cmd[2] = addr>>16;
+	cmd[3] = addr>>8;
+	cmd[4] = addr;
+}
+
+static bool __flashcheck(const u8 *ptr,u32 addr,u32 len)
+{
+	u32 i;
+
+	for(i=0;i<len;i++) {
+		if(ptr[i]!=flash.mem[(addr+i)%FLASH_SIZE]) return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------------*/
+static sem_t donesem;
+static u32 chaincbs;
+static u32 chaincbisr;
+static s32 chaincbresult;
+
+static void __chaindone(s32 chn,s32 result,exichain *chain)
+{
+	chaincbs++;
+	if(__lwp_isr_in_progress()) chaincbisr++;
+	chaincbresult = result;
+	LWP_SemPost(donesem);
+}
+
+static s32 __chainwait(void)
+{
+	struct timespec ts = {1,0};
+
+	if(LWP_SemTimedWait(donesem,&ts)) return 1;
+	return 0;
+}
+
+static void __chainreset(void)
+{
+	chaincbs = 0;
+	chaincbisr = 0;
+	chaincbresult = 1;
+}
+
+/* the synchronous calls the chains replace, through the same registers */
+static int __test_imm(void)
+{
+	u8 cmd[5],tok;
+	u32 i;
+
+	__flashreset(FLASH_LATENCY);
+	memset(data,0,sizeof(data));
+
+	if(!EXI_Lock(TEST_CHN,TEST_DEV,NULL)) return 1;
+	if(!EXI_Select(TEST_CHN,TEST_DEV,EXI_SPEED32MHZ)) return 1;
+	__cmd(cmd,CMD_READ,0x1234);
+	if(!EXI_ImmEx(TEST_CHN,cmd,sizeof(cmd),EXI_WRITE)) return 1;
+	for(i=0;i<=FLASH_LATENCY;i++) {
+		if(!EXI_ImmEx(TEST_CHN,&tok,1,EXI_READ)) return 1;
+		if(tok==FLASH_TOKEN) break;
+	}
+	if(tok!=FLASH_TOKEN) return 1;
+	if(!EXI_DmaEx(TEST_CHN,data,512,EXI_READ)) return 1;
+	if(!EXI_ImmEx(TEST_CHN,data+512,7,EXI_READ)) return 1;
+	if(!EXI_Deselect(TEST_CHN)) return 1;
+	EXI_Unlock(TEST_CHN);
+
+	return !__flashcheck(data,0x1234,519) || flash.selects!=1 || flash.deselects!=1;
+}
+
+/* a whole read in one chain: one callback, from the interrupt, nothing left selected */
+static int __test_chainread(void)
+{
+	u8 cmd[5],tok = 0;
+	exichain chain;
+	exiop ops[] = {
+		{ EXI_OP_SELECT,	0,			TEST_DEV,	EXI_SPEED32MHZ,	0,		0,				NULL,		0 },
+		{ EXI_OP_IMM,		EXI_WRITE,	0,			0,				0,		0,				cmd,		sizeof(cmd) },
+		{ EXI_OP_POLL,		EXI_READ,	0,			0,				0xff,	FLASH_TOKEN,	&tok,		64 },
+		{ EXI_OP_DMA,		EXI_READ,	0,			0,				0,		0,				data,		512 },
+		{ EXI_OP_IMM,		EXI_READ,	0,			0,				0,		0,				data+512,	7 },
+		{ EXI_OP_DESELECT,	0,			0,			0,				0,		0,				NULL,		0 },
+	};
+
+	__flashreset(FLASH_LATENCY);
+	__chainreset();
+	memset(data,0,sizeof(data));
+	__cmd(cmd,CMD_READ,0x2345);
+
+	chain.ops = ops;
+	chain.cnt = sizeof(ops)/sizeof(ops[0]);
+	if(!EXI_Lock(TEST_CHN,TEST_DEV,NULL)) return 1;
+	if(!EXI_SubmitChain(TEST_CHN,&chain,__chaindone)) return 1;
+	if(__chainwait()) return 1;
+	EXI_Unlock(TEST_CHN);
+
+	if(chaincbs!=1 || chaincbisr!=1 || chaincbresult!=EXI_CHAIN_OK || chain.result!=EXI_CHAIN_OK) return 1;
+	if(tok!=FLASH_TOKEN || !__flashcheck(data,0x2345,519)) return 1;
+	if(flash.selects!=1 || flash.deselects!=1) return 1;
+	if(EXI_GetState(TEST_CHN)&(EXI_FLAG_SELECT|EXI_FLAG_DMA|EXI_FLAG_IMM)) return 1;
+
+	// the command, every poll and the three transfers of the data
+	return flash.bytes!=sizeof(cmd)+FLASH_LATENCY+1+519;
+}
+
+/* a write through EXI_RunChain, which sleeps until the callback */
+static int __test_chainwrite(void)
+{
+	u8 cmd[5];
+	u32 i;
+	exichain chain;
+	exiop ops[] = {
+		{ EXI_OP_SELECT,	0,			TEST_DEV,	EXI_SPEED32MHZ,	0,	0,	NULL,		0 },
+		{ EXI_OP_IMM,		EXI_WRITE,	0,			0,				0,	0,	cmd,		sizeof(cmd) },
+		{ EXI_OP_DMA,		EXI_WRITE,	0,			0,				0,	0,	data,		256 },
+		{ EXI_OP_IMM,		EXI_WRITE,	0,			0,				0,	0,	data+256,	3 },
+		{ EXI_OP_DESELECT,	0,			0,			0,				0,	0,	NULL,		0 },
+	};
+
+	__flashreset(FLASH_LATENCY);
+	for(i=0;i<259;i++) data[i] = i*31+1;
+	__cmd(cmd,CMD_WRITE,0x8000);
+
+	chain.ops = ops;
+	chain.cnt = sizeof(ops)/sizeof(ops[0]);
+	if(!EXI_Lock(TEST_CHN,TEST_DEV,NULL)) return 1;
+	if(EXI_RunChain(TEST_CHN,&chain)!=EXI_CHAIN_OK) return 1;
+	EXI_Unlock(TEST_CHN);
+
+	return !__flashcheck(data,0x8000,259) || flash.selects!=1 || flash.deselects!=1;
+}
+
+/* a poll that never matches ends the chain on that step, deselected */
+static int __test_timeout(void)
+{
+	u8 cmd[5];
+	exichain chain;
+	exiop ops[] = {
+		{ EXI_OP_SELECT,	0,			TEST_DEV,	EXI_SPEED32MHZ,	0,		0,				NULL,	0 },
+		{ EXI_OP_IMM,		EXI_WRITE,	0,			0,				0,		0,				cmd,	sizeof(cmd) },
+		{ EXI_OP_POLL,		EXI_READ,	0,			0,				0xff,	FLASH_TOKEN,	NULL,	8 },
+		{ EXI_OP_DMA,		EXI_READ,	0,			0,				0,		0,				data,	512 },
+		{ EXI_OP_DESELECT,	0,			0,			0,				0,		0,				NULL,	0 },
+	};
+
+	__flashreset(FLASH_LATENCY);
+	__chainreset();
+	__cmd(cmd,CMD_READ,0);
+
+	chain.ops = ops;
+	chain.cnt = sizeof(ops)/sizeof(ops[0]);
+	if(!EXI_Lock(TEST_CHN,TEST_DEV,NULL)) return 1;
+	if(!EXI_SubmitChain(TEST_CHN,&chain,__chaindone)) return 1;
+	if(__chainwait()) return 1;
+	EXI_Unlock(TEST_CHN);
+
+	if(chaincbs!=1 || chaincbresult!=EXI_CHAIN_TIMEOUT || chain.curr!=2) return 1;
+	if(flash.deselects!=1 || (EXI_GetState(TEST_CHN)&EXI_FLAG_SELECT)) return 1;
+	return flash.bytes!=sizeof(cmd)+8;
+}
+
+/* a step that cannot start fails the chain; a second chain on a busy channel is refused */
+static int __test_error(void)
+{
+	u8 cmd[5];
+	exichain chain,other;
+	exiop unlocked[] = {
+		{ EXI_OP_SELECT,	0,	TEST_DEV,	EXI_SPEED32MHZ,	0,	0,	NULL,	0 },
+		{ EXI_OP_DESELECT,	0,	0,			0,				0,	0,	NULL,	0 },
+	};
+	exiop ops[] = {
+		{ EXI_OP_SELECT,	0,			TEST_DEV,	EXI_SPEED32MHZ,	0,	0,	NULL,	0 },
+		{ EXI_OP_IMM,		EXI_WRITE,	0,			0,				0,	0,	cmd,	sizeof(cmd) },
+		{ EXI_OP_SELECT,	0,			TEST_DEV,	EXI_SPEED32MHZ,	0,	0,	NULL,	0 },
+		{ EXI_OP_DESELECT,	0,			0,			0,				0,	0,	NULL,	0 },
+	};
+
+	__flashreset(FLASH_LATENCY);
+	__chainreset();
+
+	// without the lock the select fails at once, within the submit
+	unlocked[0].dev = TEST_DEV;
+	chain.ops = unlocked;
+	chain.cnt = sizeof(unlocked)/sizeof(unlocked[0]);
+	if(!EXI_SubmitChain(TEST_CHN,&chain,__chaindone)) return 1;
+	if(__chainwait()) return 1;
+	if(chaincbs!=1 || chaincbresult!=EXI_CHAIN_ERROR || chain.curr!=0 || flash.selects) return 1;
+
+	// selecting twice fails on the second select, after the command went out
+	__chainreset();
+	__cmd(cmd,CMD_READ,0);
+	chain.ops = ops;
+	chain.cnt = sizeof(ops)/sizeof(ops[0]);
+	if(!EXI_Lock(TEST_CHN,TEST_DEV,NULL)) return 1;
+	if(!EXI_SubmitChain(TEST_CHN,&chain,__chaindone)) return 1;
+	other.ops = unlocked;
+	other.cnt = 1;
+	if(EXI_SubmitChain(TEST_CHN,&other,__chaindone)) return 1;
+	if(__chainwait()) return 1;
+	EXI_Unlock(TEST_CHN);
+
+	if(chaincbs!=1 || chaincbresult!=EXI_CHAIN_ERROR || chain.curr!=2) return 1;
+	return flash.selects!=1 || flash.deselects!=1 || flash.bytes!=sizeof(cmd);
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "imm",			__test_imm },
+	{ "chain read",		__test_chainread },
+	{ "chain write",	__test_chainwrite },
+	{ "timeout",		__test_timeout },
+	{ "error",			__test_error },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&donesem,0,1);
+	__exi_init();
+	eximodel_attach(TEST_CHN,TEST_DEV,&flashdev);
+	if(eximodel_start()!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	eximodel_stop();
+	LWP_SemDestroy(donesem);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	if(eximodel_init()) return 1;
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,424 @@
+#!/usr/bin/env python3
+#
+# gdsp.py -- GameCube/Wii DSP assembler for the libasnd/libaesnd mixer sources
+#
+# Copyright (C) 2026 Extrems' Corner.org
+#
+# This software is provided 'as-is', without any express or implied
+# warranty.  In no event will the authors be held liable for any
+# damages arising from the use of this software.
+#
+# Permission is granted to anyone to use this software for any
+# purpose, including commercial applications, and to alter it and
+# redistribute it freely, subject to the following restrictions:
+#
+# 1.	The origin of this software must not be misrepresented; you
+# must not claim that you wrote the original software. If you use
+# this software in a product, an acknowledgment in the product
+# documentation would be appreciated but is not required.
+#
+# 2.	Altered source versions must be plainly marked as such, and
+# must not be misrepresented as being the original software.
+#
+# 3.	This notice may not be removed or altered from any source
+# distribution.
+#
+# Accepts the gdtool syntax of dsp_mixer.s and dspmixer.s and writes the
+# same .h layout gdtool exports, so the prebuilt microcode headers can be
+# regenerated from their sources:
+#
+#   gdsp.py libaesnd/dspcode/dspmixer.s dspmixer > libaesnd/dspmixer.h
+#   gdsp.py libasnd/dsp_mixer/dsp_mixer.s dsp_mixer > libasnd/dsp_mixer.h
+#
+# Encodings follow the DSP instruction set as documented by Duddie and the
+# Dolphin project. Only the instructions and extended opcodes the mixers use
+# are implemented; anything else is reported as an error.
+
+import re
+import sys
+
+REGS = {
+	'ar0': 0x00, 'ar1': 0x01, 'ar2': 0x02, 'ar3': 0x03,
+	'ix0': 0x04, 'ix1': 0x05, 'ix2': 0x06, 'ix3': 0x07,
+	'wr0': 0x08, 'wr1': 0x09, 'wr2': 0x0a, 'wr3': 0x0b,
+	'r08': 0x08, 'r09': 0x09, 'r0a': 0x0a, 'r0b': 0x0b,
+	'st0': 0x0c, 'st1': 0x0d, 'st2': 0x0e, 'st3': 0x0f,
+	'acc0.h': 0x10, 'acc1.h': 0x11,
+	'config': 0x12, 'sr': 0x13,
+	'prod.l': 0x14, 'prod.m1': 0x15, 'prod.h': 0x16, 'prod.m2': 0x17,
+	'acx0.l': 0x18, 'acx1.l': 0x19, 'acx0.h': 0x1a, 'acx1.h': 0x1b,
+	'acc0.l': 0x1c, 'acc1.l': 0x1d, 'acc0.m': 0x1e, 'acc1.m': 0x1f,
+	# whole accumulators, only meaningful where an accumulator index is expected
+	'acc0': 0x1e, 'acc1': 0x1f, 'acx0': 0x18, 'acx1': 0x19,
+	'acm0': 0x1e, 'acm1': 0x1f, 'acl0': 0x1c, 'acl1': 0x1d,
+	'ach0': 0x10, 'ach1': 0x11,
+	'axl0': 0x18, 'axl1': 0x19, 'axh0': 0x1a, 'axh1': 0x1b,
+}
+
+CONDS = {
+	'ge': 0x0, 'l': 0x1, 'lt': 0x1, 'g': 0x2, 'gt': 0x2, 'le': 0x3,
+	'nz': 0x4, 'ne': 0x4, 'z': 0x5, 'eq': 0x5, 'nc': 0x6, 'c': 0x7,
+	'lnz': 0xc, 'lz': 0xd, 'o': 0xe, '': 0xf, 'mp': 0xf,
+}
+
+# operand kinds: (kind, shift)
+#   reg    full register number          reg18  register - 0x18
+#   reg1c  register - 0x1c               acc    accumulator index
+#   ax     $acx index                    axh    $acx.h index
+#   ar     $arN                          ix     $ixN
+#   prg    @$arN                         imm    immediate in the opcode (mask in third field)
+#   simm   signed immediate in the opcode, negated  (shift count of lsr/asr)
+#   mem    low byte of a data address    w_imm/w_mem/w_addr  second instruction word
+OPS = {
+	'nop':    (0x0000, []),
+	'halt':   (0x0021, []),
+	'dar':    (0x0004, [('ar', 0)]),
+	'iar':    (0x0008, [('ar', 0)]),
+	'subarn': (0x000c, [('ar', 0)]),
+	'addarn': (0x0010, [('ar', 0), ('ix', 2)]),
+	'loop':   (0x0040, [('reg', 0)]),
+	'bloop':  (0x0060, [('reg', 0), ('w_addr', 0)]),
+	'loopi':  (0x1000, [('imm', 0, 0xff)]),
+	'bloopi': (0x1100, [('imm', 0, 0xff), ('w_addr', 0)]),
+	'lri':    (0x0080, [('reg', 0), ('w_imm', 0)]),
+	'lr':     (0x00c0, [('reg', 0), ('w_mem', 0)]),
+	'sr':     (0x00e0, [('w_mem', 0), ('reg', 0)]),
+	'addi':   (0x0200, [('acc', 8), ('w_imm', 0)]),
+	'xori':   (0x0220, [('acc', 8), ('w_imm', 0)]),
+	'andi':   (0x0240, [('acc', 8), ('w_imm', 0)]),
+	'ori':    (0x0260, [('acc', 8), ('w_imm', 0)]),
+	'cmpi':   (0x0280, [('acc', 8), ('w_imm', 0)]),
+	'andf':   (0x02a0, [('acc', 8), ('w_imm', 0)]),
+	'andcf':  (0x02c0, [('acc', 8), ('w_imm', 0)]),
+	'ilrr':   (0x0210, [('acc', 8), ('prg', 0)]),
+	'ilrrd':  (0x0214, [('acc', 8), ('prg', 0)]),
+	'ilrri':  (0x0218, [('acc', 8), ('prg', 0)]),
+	'ilrrn':  (0x021c, [('acc', 8), ('prg', 0)]),
+	'addis':  (0x0400, [('acc', 8), ('imm', 0, 0xff)]),
+	'cmpis':  (0x0600, [('acc', 8), ('imm', 0, 0xff)]),
+	'lris':   (0x0800, [('reg18', 8), ('imm', 0, 0xff)]),
+	'sbclr':  (0x1200, [('imm', 0, 0x07)]),
+	'sbset':  (0x1300, [('imm', 0, 0x07)]),
+	'lsl':    (0x1400, [('acc', 8), ('imm', 0, 0x3f)]),
+	'lsr':    (0x1440, [('acc', 8), ('simm', 0, 0x3f)]),
+	'asl':    (0x1480, [('acc', 8), ('imm', 0, 0x3f)]),
+	'asr':    (0x14c0, [('acc', 8), ('simm', 0, 0x3f)]),
+	'si':     (0x1600, [('mem', 0), ('w_imm', 0)]),
+	'lrr':    (0x1800, [('reg', 0), ('prg', 5)]),
+	'lrrd':   (0x1880, [('reg', 0), ('prg', 5)]),
+	'lrri':   (0x1900, [('reg', 0), ('prg', 5)]),
+	'lrrn':   (0x1980, [('reg', 0), ('prg', 5)]),
+	'srr':    (0x1a00, [('prg', 5), ('reg', 0)]),
+	'srrd':   (0x1a80, [('prg', 5), ('reg', 0)]),
+	'srri':   (0x1b00, [('prg', 5), ('reg', 0)]),
+	'srrn':   (0x1b80, [('prg', 5), ('reg', 0)]),
+	'mrr':    (0x1c00, [('reg', 5), ('reg', 0)]),
+	'lrs':    (0x2000, [('reg18', 8), ('mem', 0)]),
+	'srs':    (0x2800, [('mem', 0), ('reg18', 8)]),
+	# extendable opcodes
+	'xorr':   (0x3000, [('acc', 8), ('axh', 9)]),
+	'andr':   (0x3400, [('acc', 8), ('axh', 9)]),
+	'orr':    (0x3800, [('acc', 8), ('axh', 9)]),
+	'addr':   (0x4000, [('acc', 8), ('reg18', 9)]),
+	'addax':  (0x4800, [('acc', 8), ('ax', 9)]),
+	'add':    (0x4c00, [('acc', 8)]),
+	'addp':   (0x4e00, [('acc', 8)]),
+	'subr':   (0x5000, [('acc', 8), ('reg18', 9)]),
+	'subax':  (0x5800, [('acc', 8), ('ax', 9)]),
+	'sub':    (0x5c00, [('acc', 8)]),
+	'subp':   (0x5e00, [('acc', 8)]),
+	'movr':   (0x6000, [('acc', 8), ('reg18', 9)]),
+	'movax':  (0x6800, [('acc', 8), ('ax', 9)]),
+	'mov':    (0x6c00, [('acc', 8)]),
+	'movp':   (0x6e00, [('acc', 8)]),
+	'addaxl': (0x7000, [('acc', 8), ('ax', 9)]),
+	'incm':   (0x7400, [('acc', 8)]),
+	'inc':    (0x7600, [('acc', 8)]),
+	'decm':   (0x7800, [('acc', 8)]),
+	'dec':    (0x7a00, [('acc', 8)]),
+	'neg':    (0x7c00, [('acc', 8)]),
+	'movnp':  (0x7e00, [('acc', 8)]),
+	'nx':     (0x8000, []),
+	'clr':    (0x8100, [('acc', 11)]),
+	'cmp':    (0x8200, []),
+	'mulaxh': (0x8300, []),
+	'clrp':   (0x8400, []),
+	'tstprod':(0x8500, []),
+	'tstaxh': (0x8600, [('axh', 8)]),
+	'm2':     (0x8a00, []),
+	'm0':     (0x8b00, []),
+	'clr15':  (0x8c00, []),
+	'set15':  (0x8d00, []),
+	'set16':  (0x8e00, []),
+	's16':    (0x8e00, []),
+	'set40':  (0x8f00, []),
+	's40':    (0x8f00, []),
+	'mul':    (0x9000, [('ax', 11), ('axh', 11)]),
+	'asr16':  (0x9100, [('acc', 11)]),
+	'mulmvz': (0x9200, [('ax', 11), ('axh', 11), ('acc', 8)]),
+	'mulac':  (0x9400, [('ax', 11), ('axh', 11), ('acc', 8)]),
+	'mulmv':  (0x9600, [('ax', 11), ('axh', 11), ('acc', 8)]),
+	'abs':    (0xa100, [('acc', 11)]),
+	'tst':    (0xb100, [('acc', 11)]),
+	'mulc':   (0xc000, [('acc', 12), ('axh', 11)]),
+	'cmpaxh': (0xc100, [('acc', 11), ('axh', 12)]),
+	'mulcmvz':(0xc200, [('acc', 12), ('axh', 11), ('acc', 8)]),
+	'mulcac': (0xc400, [('acc', 12), ('axh', 11), ('acc', 8)]),
+	'mulcmv': (0xc600, [('acc', 12), ('axh', 11), ('acc', 8)]),
+	'lsl16':  (0xf000, [('acc', 8)]),
+	'lsr16':  (0xf400, [('acc', 8)]),
+	'clrl':   (0xfc00, [('acc', 8)]),
+	'movpz':  (0xfe00, [('acc', 8)]),
+}
+
+# conditional families: base opcode, operand list
+for cc, v in CONDS.items():
+	OPS['j' + cc] = (0x0290 | v, [('w_addr', 0)])
+	OPS['call' + cc] = (0x02b0 | v, [('w_addr', 0)])
+	OPS['ret' + cc] = (0x02d0 | v, [])
+	OPS['rti' + cc] = (0x02f0 | v, [])
+	OPS['if' + cc] = (0x0270 | v, [])
+	OPS['jr' + cc] = (0x1700 | v, [('reg', 5)])
+	OPS['callr' + cc] = (0x1710 | v, [('reg', 5)])
+OPS['jmpr'] = OPS['jr']
+OPS['callr'] = OPS['callr']
+
+EXT = {
+	'dr':   (0x04, [('ar', 0)]),
+	'ir':   (0x08, [('ar', 0)]),
+	'nr':   (0x0c, [('ar', 0)]),
+	'mv':   (0x10, [('reg18', 2), ('reg1c', 0)]),
+	's':    (0x20, [('prg', 0), ('reg1c', 3)]),
+	'sn':   (0x24, [('prg', 0), ('reg1c', 3)]),
+	'l':    (0x40, [('reg18', 3), ('prg', 0)]),
+	'ln':   (0x44, [('reg18', 3), ('prg', 0)]),
+	'ls':   (0x80, [('reg18', 4), ('acc', 0)]),
+	'sl':   (0x82, [('acc', 0), ('reg18', 4)]),
+	'lsn':  (0x84, [('reg18', 4), ('acc', 0)]),
+	'sln':  (0x86, [('acc', 0), ('reg18', 4)]),
+	'lsm':  (0x88, [('reg18', 4), ('acc', 0)]),
+	'slm':  (0x8a, [('acc', 0), ('reg18', 4)]),
+	'lsnm': (0x8c, [('reg18', 4), ('acc', 0)]),
+	'slnm': (0x8e, [('acc', 0), ('reg18', 4)]),
+}
+
+
+class AsmError(Exception):
+	pass
+
+
+def strip_comments(text):
+	text = re.sub(r'/\*.*?\*/', lambda m: '\n' * m.group(0).count('\n'), text, flags=re.S)
+	lines = []
+	for line in text.split('\n'):
+		line = line.split('//')[0].split(';')[0]
+		lines.append(line.rstrip())
+	return lines
+
+
+class Assembler:
+	def __init__(self):
+		self.symbols = {}
+
+	def value(self, expr):
+		expr = expr.strip()
+
+		def sym(m):
+			name = m.group(0)
+			if re.match(r'0x[0-9a-f]+$', name, re.I) or name.isdigit():
+				return str(int(name, 0))
+			key = name.lower()
+			if key not in self.symbols:
+				if self.final:
+					raise AsmError('undefined symbol %s' % name)
+				return '0'
+			return str(self.symbols[key])
+
+		py = re.sub(r'[A-Za-z_][A-Za-z_0-9]*|0x[0-9A-Fa-f]+|\d+', sym, expr)
+		if not re.match(r'^[0-9+\-*/%()<>&|~^ \t]*$', py):
+			raise AsmError('bad expression %s' % expr)
+		return int(eval(py.replace('/', '//')))
+
+	def register(self, op):
+		op = op.strip()
+		if not op.startswith('$'):
+			raise AsmError('register expected: %s' % op)
+		name = op[1:].lower()
+		if name in REGS:
+			return REGS[name]
+		if name in self.symbols:
+			return self.symbols[name]
+		return self.value(name)
+
+	def operand(self, kind, op):
+		k = kind[0]
+		if k == 'reg':
+			return self.register(op)
+		if k == 'reg18':
+			r = self.register(op)
+			if r < 0x18:
+				raise AsmError('register out of range: %s' % op)
+			return r - 0x18
+		if k == 'reg1c':
+			r = self.register(op)
+			if r < 0x1c:
+				raise AsmError('register out of range: %s' % op)
+			return r - 0x1c
+		if k == 'acc':
+			r = self.register(op)
+			if r in (0x10, 0x11):
+				return r - 0x10
+			if r in (0x1c, 0x1d, 0x1e, 0x1f):
+				return r & 1
+			raise AsmError('accumulator expected: %s' % op)
+		if k == 'ax':
+			r = self.register(op)
+			if r in (0x18, 0x19, 0x1a, 0x1b):
+				return r & 1
+			raise AsmError('$acx expected: %s' % op)
+		if k == 'axh':
+			r = self.register(op)
+			if r in (0x1a, 0x1b):
+				return r - 0x1a
+			raise AsmError('$acx.h expected: %s' % op)
+		if k == 'ar':
+			r = self.register(op)
+			if r > 3:
+				raise AsmError('$ar expected: %s' % op)
+			return r
+		if k == 'ix':
+			r = self.register(op)
+			if r < 4 or r > 7:
+				raise AsmError('$ix expected: %s' % op)
+			return r - 4
+		if k == 'prg':
+			op = op.strip()
+			if not op.startswith('@$'):
+				raise AsmError('@$ar expected: %s' % op)
+			return self.operand(('ar', 0), op[1:])
+		if k in ('imm', 'simm'):
+			op = op.strip()
+			if op.startswith('#'):
+				op = op[1:]
+			v = self.value(op)
+			if k == 'simm':
+				v = -v
+			return v & kind[2]
+		if k == 'mem':
+			op = op.strip()
+			if op.startswith('@'):
+				op = op[1:]
+			return self.value(op) & 0xff
+		if k in ('w_imm', 'w_mem', 'w_addr'):
+			op = op.strip()
+			if op[:1] in ('#', '@'):
+				op = op[1:]
+			return self.value(op) & 0xffff
+		raise AsmError('bad operand kind %s' % k)
+
+	@staticmethod
+	def split_operands(text):
+		text = text.strip()
+		if not text:
+			return []
+		return [o.strip() for o in text.split(',')]
+
+	def encode(self, mnemonic, args):
+		name, _, ext = mnemonic.lower().partition("'")
+		if name == 'cw':
+			return [self.value(args) & 0xffff]
+		if name not in OPS:
+			raise AsmError('unknown instruction %s' % name)
+
+		base, kinds = OPS[name]
+		main, _, extargs = args.partition(':')
+		ops = self.split_operands(main)
+		if len(ops) < len(kinds):
+			raise AsmError('%s expects %d operands' % (name, len(kinds)))
+
+		words = [base]
+		for kind, op in zip(kinds, ops):
+			v = self.operand(kind, op)
+			if kind[0].startswith('w_'):
+				words.append(v)
+			else:
+				words[0] |= v << kind[1]
+
+		if ext:
+			if ext not in EXT:
+				raise AsmError('unknown extended opcode %s' % ext)
+			if base < 0x3000:
+				raise AsmError('%s cannot be extended' % name)
+			ebase, ekinds = EXT[ext]
+			eops = self.split_operands(extargs)
+			if len(eops) < len(ekinds):
+				raise AsmError("'%s expects %d operands" % (ext, len(ekinds)))
+			e = ebase
+			for kind, op in zip(ekinds, eops):
+				e |= self.operand(kind, op) << kind[1]
+			words[0] |= e & (0x7f if base < 0x4000 else 0xff)
+		return words
+
+	def assemble(self, text):
+		lines = strip_comments(text)
+		code = []
+		for self.final in (False, True):
+			pc = 0
+			code = []
+			for lineno, line in enumerate(lines, 1):
+				try:
+					m = re.match(r'^\s*([A-Za-z_][A-Za-z_0-9]*)\s*:(.*)$', line)
+					if m:
+						label, line = m.group(1).lower(), m.group(2)
+						e = re.match(r'^\s*equ\s+(.*)$', line, re.I)
+						if e:
+							self.symbols[label] = self.value(e.group(1))
+							continue
+						self.symbols[label] = pc
+					line = line.strip()
+					if not line:
+						continue
+					parts = line.split(None, 1)
+					words = self.encode(parts[0], parts[1] if len(parts) > 1 else '')
+				except AsmError as err:
+					raise AsmError('line %d: %s' % (lineno, err))
+				code.extend(words)
+				pc += len(words)
+		return code
+
+
+def export(code, name):
+	code = list(code)
+	while len(code) % 16:
+		code.append(0)
+
+	out = ['/* gdtool v1.4 .h exporter by Hermes */', '',
+		   '#define %s_size %d' % (name, len(code) * 2), '',
+		   'unsigned short %s[%d] __attribute__ ((aligned (32))) ={' % (name, len(code)), '', '']
+	rows = [code[i:i + 16] for i in range(0, len(code), 16)]
+	for i, row in enumerate(rows):
+		line = '\t' + ', '.join('0x%04x' % w for w in row)
+		if i < len(rows) - 1:
+			line += ','
+		out.append(line)
+	out += ['', '};', '', '']
+	return '\n'.join(out)
+
+
+def main():
+	if len(sys.argv) != 3:
+		sys.stderr.write('usage: %s <source.s> <array name>\n' % sys.argv[0])
+		return 1
+	with open(sys.argv[1]) as f:
+		text = f.read()
+	try:
+		code = Assembler().assemble(text)
+	except AsmError as err:
+		sys.stderr.write('%s: %s\n' % (sys.argv[1], err))
+		return 1
+	sys.stdout.write(export(code, sys.argv[2]))
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main())
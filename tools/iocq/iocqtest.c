@@ -0,0 +1,260 @@
+/*-------------------------------------------------------------
+
+iocqtest.c -- I/O completion queue tests with fake device backends
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/iocq.c as it is on the simulated kernel of lwpsim/. The fake
+ * DVD, IPC and memory card backends are threads above every other priority
+ * that complete their requests through the same callbacks the drivers take,
+ * with interrupts disabled as in an interrupt handler, so a worker thread
+ * sees completions from all of them on one queue.
+ *
+ *   iocqtest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "timesupp.h"
+#include "card.h"
+#include "iocq.h"
+
+#define STACKSIZE				(64*1024)
+
+#define DEVICE_REQUESTS			24
+#define DEVICE_BURST			6
+#define RING_SIZE				16
+
+typedef struct _fakedev {
+	u32 source;
+	u32 period;					// ms between bursts
+	iocq_req reqs[DEVICE_REQUESTS];
+	dvdcmdblk blocks[DEVICE_REQUESTS];
+	lwp_t thread;
+} fakedev;
+
+static iocq queue;
+static iocq_event ring[RING_SIZE];
+static fakedev devices[3];
+
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+/* each burst completes back to back, as a driver draining its hardware queue would */
+static void* __device(void *arg)
+{
+	u32 i,level;
+	fakedev *dev = arg;
+
+	for(i=0;i<DEVICE_REQUESTS;i++) {
+		if(!(i%DEVICE_BURST)) __sleep(dev->period);
+
+		_CPU_ISR_Disable(level);
+		switch(dev->source) {
+			case IOCQ_SOURCE_DVD:
+				IOCQ_DVDCallback(i*2048,&dev->blocks[i]);
+				break;
+			case IOCQ_SOURCE_IPC:
+				IOCQ_IPCCallback(i,&dev->reqs[i]);
+				break;
+			case IOCQ_SOURCE_CARD:
+				IOCQ_CARDBind(CARD_SLOTB,&dev->reqs[i]);
+				IOCQ_CARDCallback(CARD_SLOTB,CARD_ERROR_READY);
+				break;
+		}
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* misuse is reported as negative errno values */
+static int __test_errors(void)
+{
+	iocq_event ev;
+	iocq_req req;
+
+	if(IOCQ_Init(NULL,ring,RING_SIZE)!=-EINVAL || IOCQ_Init(&queue,ring,0)!=-EINVAL) return 1;
+	if(IOCQ_Init(&queue,ring,RING_SIZE)!=0) return 1;
+	if(IOCQ_Wait(&queue,&ev,0,NULL)!=-EINVAL || IOCQ_Poll(&queue,NULL,1)!=-EINVAL) return 1;
+
+	if(IOCQ_CARDBind(CARD_SLOTB+1,&req)!=-EINVAL || IOCQ_CARDBind(-1,&req)!=-EINVAL) return 1;
+	if(IOCQ_CARDBind(CARD_SLOTA,&req)!=IOCQ_ERROR_OK || IOCQ_CARDBind(CARD_SLOTA,&req)!=IOCQ_ERROR_BUSY) return 1;
+	if(IOCQ_CARDBind(CARD_SLOTA,NULL)!=IOCQ_ERROR_OK) return 1;
+
+	if(IOCQ_Close(&queue)!=0 || IOCQ_Close(&queue)!=-EINVAL || IOCQ_Close(NULL)!=-EINVAL) return 1;
+	return IOCQ_Wait(&queue,&ev,1,NULL)!=-EINVAL;
+}
+
+/* a full ring drops and counts what does not fit, and keeps the posting order */
+static int __test_overflow(void)
+{
+	u32 i;
+	s32 n;
+	iocq_event ev[RING_SIZE];
+
+	if(IOCQ_Init(&queue,ring,4)!=0) return 1;
+	for(i=0;i<6;i++) {
+		if(IOCQ_Post(&queue,(void*)(unsigned long)i,i,IOCQ_SOURCE_USER)!=(i<4 ? IOCQ_ERROR_OK : IOCQ_ERROR_OVERFLOW)) return 1;
+	}
+	n = IOCQ_Poll(&queue,ev,RING_SIZE);
+	if(n!=4 || queue.overflows!=2) return 1;
+	for(i=0;i<4;i++) {
+		if(ev[i].tag!=(void*)(unsigned long)i || ev[i].result!=(s32)i) return 1;
+	}
+	return IOCQ_Poll(&queue,ev,RING_SIZE)!=0 || IOCQ_Close(&queue)!=0;
+}
+
+/* a wait with nothing posted times out empty-handed */
+static int __test_timeout(void)
+{
+	s32 n;
+	u64 start,elapsed;
+	iocq_event ev;
+	struct timespec ts = {0,5*TB_NSPERMS};
+
+	if(IOCQ_Init(&queue,ring,RING_SIZE)!=0) return 1;
+	start = gettime();
+	n = IOCQ_Wait(&queue,&ev,1,&ts);
+	elapsed = diff_ticks(start,gettime());
+	return IOCQ_Close(&queue)!=0 || n!=0 || elapsed<millisecs_to_ticks(5);
+}
+
+static volatile s32 closedret;
+
+static void* __closedwaiter(void *arg)
+{
+	iocq_event ev;
+
+	closedret = IOCQ_Wait(&queue,&ev,1,NULL);
+	return NULL;
+}
+
+/* closing the queue wakes a thread blocked on it */
+static int __test_close(void)
+{
+	lwp_t thr = LWP_THREAD_NULL;
+
+	closedret = 1;
+	if(IOCQ_Init(&queue,ring,RING_SIZE)!=0) return 1;
+	if(LWP_CreateThread(&thr,__closedwaiter,NULL,NULL,STACKSIZE,LWP_PRIO_HIGH)!=0) return 1;
+	if(IOCQ_Close(&queue)!=0) return 1;
+	LWP_JoinThread(thr,NULL);
+	return closedret!=-EINVAL;
+}
+
+/* one worker collects the completions of three devices, several per wakeup */
+static int __test_devices(void)
+{
+	u32 i,j,total,wakeups,maxbatch;
+	s32 n;
+	u8 seen[3][DEVICE_REQUESTS];
+	iocq_event ev[RING_SIZE];
+	const u32 sources[3] = {IOCQ_SOURCE_DVD,IOCQ_SOURCE_IPC,IOCQ_SOURCE_CARD};
+
+	if(IOCQ_Init(&queue,ring,RING_SIZE)!=0) return 1;
+	memset(seen,0,sizeof(seen));
+	for(i=0;i<3;i++) {
+		devices[i].source = sources[i];
+		devices[i].period = 2 + i*3;
+		for(j=0;j<DEVICE_REQUESTS;j++) {
+			IOCQ_InitRequest(&devices[i].reqs[j],&queue,&seen[i][j]);
+			DVD_SetUserData(&devices[i].blocks[j],&devices[i].reqs[j]);
+		}
+		devices[i].thread = LWP_THREAD_NULL;
+		if(LWP_CreateThread(&devices[i].thread,__device,&devices[i],NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+	}
+
+	total = wakeups = maxbatch = 0;
+	while(total<3*DEVICE_REQUESTS) {
+		n = IOCQ_Wait(&queue,ev,RING_SIZE,NULL);
+		if(n<=0) return 1;
+		for(i=0;i<(u32)n;i++) {
+			u8 *tag = ev[i].tag;
+			u32 dev = (tag - &seen[0][0])/DEVICE_REQUESTS;
+
+			if(dev>=3 || ev[i].source!=sources[dev] || (*tag)++) return 1;
+		}
+		if((u32)n>maxbatch) maxbatch = n;
+		total += n;
+		wakeups++;
+	}
+	for(i=0;i<3;i++) LWP_JoinThread(devices[i].thread,NULL);
+
+	printf("%-16s %u completions in %u wakeups, up to %u at once\n","",total,wakeups,maxbatch);
+	return IOCQ_Close(&queue)!=0 || queue.overflows!=0 || maxbatch<DEVICE_BURST || wakeups>=total;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "errors",			__test_errors },
+	{ "overflow",		__test_overflow },
+	{ "timeout",		__test_timeout },
+	{ "close",			__test_close },
+	{ "devices",		__test_devices },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,552 @@
+/*-------------------------------------------------------------
+
+lwptest.c -- scheduling tests and benchmarks of the kernel on the host
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs the kernel (libogc/lwp_*.c and the mutex, semaphore, condition and
+ * message queue front ends, unchanged) as a host process on the simulated
+ * CPU of simcpu.c: threads are ucontexts, the decrementer is a SIGALRM timer
+ * and the timebase ticks at TB_TIMER_CLOCK off the host's monotonic clock.
+ *
+ *   lwptest				run the scheduling tests
+ *   lwptest -b				also time context switches, wakeup latency and timer precision
+ *
+ * The benchmark figures are host figures: they compare kernel changes on the
+ * same machine, they are not console timings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lwp.h"
+#include "mutex.h"
+#include "cond.h"
+#include "semaphore.h"
+#include "message.h"
+#include "timesupp.h"
+#include "processor.h"
+
+#define STACKSIZE				(64*1024)
+
+#define BENCH_SWITCHES			200000
+#define BENCH_WAKEUPS			20000
+#define BENCH_TIMERS			200
+
+static int bench = 0;
+
+static char order[64];
+static volatile u32 orderlen;
+
+static sem_t sem_a,sem_b;
+static mutex_t mtx;
+static cond_t cnd;
+static volatile u32 counter;
+
+static void __log(char c)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	if(orderlen<sizeof(order) - 1) order[orderlen++] = c;
+	order[orderlen] = 0;
+	_CPU_ISR_Restore(level);
+}
+
+static void __resetlog(void)
+{
+	orderlen = 0;
+	order[0] = 0;
+}
+
+static lwp_t __spawn(void* (*entry)(void*),void *arg,u8 prio)
+{
+	lwp_t thr = LWP_THREAD_NULL;
+
+	if(LWP_CreateThread(&thr,entry,arg,NULL,STACKSIZE,prio)!=0) {
+		fprintf(stderr,"LWP_CreateThread failed\n");
+		exit(1);
+	}
+	return thr;
+}
+
+/*---------------------------------------------------------------------------------*/
+static void* __logger(void *arg)
+{
+	__log((char)(unsigned long)arg);
+	return NULL;
+}
+
+/* a higher priority thread runs before LWP_CreateThread returns, a lower one once main blocks */
+static int __test_preempt(void)
+{
+	lwp_t hi,lo;
+
+	__resetlog();
+	hi = __spawn(__logger,(void*)'H',LWP_PRIO_HIGH);
+	lo = __spawn(__logger,(void*)'L',LWP_PRIO_LOW);
+	__log('M');
+	LWP_JoinThread(hi,NULL);
+	LWP_JoinThread(lo,NULL);
+	return strcmp(order,"HML")!=0;
+}
+
+static void* __yielder(void *arg)
+{
+	u32 i;
+
+	for(i=0;i<3;i++) {
+		__log((char)(unsigned long)arg);
+		LWP_YieldThread();
+	}
+	return NULL;
+}
+
+/* threads of one priority take turns on LWP_YieldThread */
+static int __test_yield(void)
+{
+	lwp_t a,b;
+
+	__resetlog();
+	a = __spawn(__yielder,(void*)'a',LWP_PRIO_NORMAL);
+	b = __spawn(__yielder,(void*)'b',LWP_PRIO_NORMAL);
+	LWP_JoinThread(a,NULL);
+	LWP_JoinThread(b,NULL);
+	return strcmp(order,"ababab")!=0;
+}
+
+static void* __ponger(void *arg)
+{
+	u32 i,n = (u32)(unsigned long)arg;
+
+	for(i=0;i<n;i++) {
+		LWP_SemWait(sem_a);
+		counter++;
+		LWP_SemPost(sem_b);
+	}
+	return (void*)0x600d;
+}
+
+static int __test_sema(void)
+{
+	u32 i;
+	void *ret = NULL;
+	lwp_t thr;
+
+	counter = 0;
+	LWP_SemInit(&sem_a,0,1);
+	LWP_SemInit(&sem_b,0,1);
+	thr = __spawn(__ponger,(void*)1000,LWP_PRIO_NORMAL);
+	for(i=0;i<1000;i++) {
+		LWP_SemPost(sem_a);
+		LWP_SemWait(sem_b);
+	}
+	LWP_JoinThread(thr,&ret);
+	LWP_SemDestroy(sem_a);
+	LWP_SemDestroy(sem_b);
+	return counter!=1000 || ret!=(void*)0x600d;
+}
+
+static void* __mtxowner(void *arg)
+{
+	LWP_MutexLock(mtx);
+	LWP_SemPost(sem_a);
+	LWP_SemWait(sem_b);
+	__log('l');
+	LWP_MutexUnlock(mtx);
+	return NULL;
+}
+
+static void* __mtxwaiter(void *arg)
+{
+	LWP_MutexLock(mtx);
+	__log('h');
+	LWP_MutexUnlock(mtx);
+	return NULL;
+}
+
+/* a low priority owner runs at the priority of the thread it blocks: posted
+   by main, it preempts main to release the mutex instead of waiting for it */
+static int __test_inherit(void)
+{
+	lwp_t lo,hi;
+
+	__resetlog();
+	LWP_MutexInit(&mtx,false);
+	LWP_SemInit(&sem_a,0,1);
+	LWP_SemInit(&sem_b,0,1);
+
+	lo = __spawn(__mtxowner,NULL,LWP_PRIO_LOW);
+	LWP_SemWait(sem_a);
+	hi = __spawn(__mtxwaiter,NULL,LWP_PRIO_HIGH);
+	LWP_SemPost(sem_b);
+	__log('m');
+
+	LWP_JoinThread(hi,NULL);
+	LWP_JoinThread(lo,NULL);
+	LWP_SemDestroy(sem_a);
+	LWP_SemDestroy(sem_b);
+	LWP_MutexDestroy(mtx);
+	return strcmp(order,"lhm")!=0;
+}
+
+static void* __condwaiter(void *arg)
+{
+	LWP_MutexLock(mtx);
+	while(counter==0) LWP_CondWait(cnd,mtx);
+	counter++;
+	LWP_MutexUnlock(mtx);
+	return NULL;
+}
+
+static int __test_cond(void)
+{
+	u32 i;
+	lwp_t thr[3];
+
+	counter = 0;
+	LWP_MutexInit(&mtx,false);
+	LWP_CondInit(&cnd);
+	for(i=0;i<3;i++) thr[i] = __spawn(__condwaiter,NULL,LWP_PRIO_HIGH);
+
+	LWP_MutexLock(mtx);
+	counter = 1;
+	LWP_CondBroadcast(cnd);
+	LWP_MutexUnlock(mtx);
+
+	for(i=0;i<3;i++) LWP_JoinThread(thr[i],NULL);
+	LWP_CondDestroy(cnd);
+	LWP_MutexDestroy(mtx);
+	return counter!=4;
+}
+
+static void* __mqreader(void *arg)
+{
+	mqbox_t mq = (mqbox_t)(unsigned long)arg;
+	mqmsg_t msg;
+	u32 i;
+
+	for(i=0;i<4;i++) {
+		MQ_Receive(mq,&msg,MQ_MSG_BLOCK);
+		__log((char)(unsigned long)msg);
+	}
+	return NULL;
+}
+
+/* FIFO order, MQ_Jam at the front, a blocked reader woken by the sender */
+static int __test_mqueue(void)
+{
+	mqbox_t mq;
+	mqmsg_t msg;
+	lwp_t thr;
+	BOOL empty;
+
+	__resetlog();
+	MQ_Init(&mq,4);
+	MQ_Send(mq,(mqmsg_t)'2',MQ_MSG_BLOCK);
+	MQ_Send(mq,(mqmsg_t)'3',MQ_MSG_BLOCK);
+	MQ_Jam(mq,(mqmsg_t)'1',MQ_MSG_BLOCK);
+	thr = __spawn(__mqreader,(void*)(unsigned long)mq,LWP_PRIO_HIGH);
+	MQ_Send(mq,(mqmsg_t)'4',MQ_MSG_BLOCK);
+	LWP_JoinThread(thr,NULL);
+	empty = !MQ_Receive(mq,&msg,MQ_MSG_NOBLOCK);
+	MQ_Close(mq);
+	return !empty || strcmp(order,"1234")!=0;
+}
+
+/* a timeout never fires early, and not much late on an idle system */
+static int __test_timeout(void)
+{
+	struct timespec ts = {0,5*TB_NSPERMS};
+	u64 start,elapsed;
+	s32 ret;
+
+	LWP_SemInit(&sem_a,0,1);
+	start = gettime();
+	ret = LWP_SemTimedWait(sem_a,&ts);
+	elapsed = diff_ticks(start,gettime());
+	LWP_SemDestroy(sem_a);
+	return ret!=ETIMEDOUT || elapsed<millisecs_to_ticks(5) || elapsed>millisecs_to_ticks(100);
+}
+
+static volatile u32 overflows;
+static volatile lwp_t overflowed;
+static u32 guardstack[STACKSIZE/4] ATTRIBUTE_ALIGN(32);
+
+static void __overflowcb(lwp_t thr)
+{
+	overflowed = thr;
+	overflows++;
+}
+
+static void* __exiter(void *arg)
+{
+	LWP_SemWait(*(sem_t*)arg);
+	return NULL;
+}
+
+/* threads that exit hand their stack back to the workspace before the last
+   switch away from them, which must not be taken for an overflow. The older
+   thread exits first, so that its stack is put on the free list rather than
+   merged into the block below, at every alignment of the stack. */
+static int __test_stackexit(void)
+{
+	u32 i;
+	lwp_t old,young;
+
+	overflows = 0;
+	LWP_SemInit(&sem_a,0,1);
+	LWP_SemInit(&sem_b,0,1);
+	LWP_SetStackOverflowCallback(__overflowcb);
+	for(i=0;i<8;i++) {
+		old = young = LWP_THREAD_NULL;
+		if(LWP_CreateThread(&old,__exiter,&sem_a,NULL,STACKSIZE + i*4,LWP_PRIO_HIGH)!=0
+		   || LWP_CreateThread(&young,__exiter,&sem_b,NULL,STACKSIZE + i*4,LWP_PRIO_HIGH)!=0) return 1;
+		LWP_SemPost(sem_a);
+		LWP_JoinThread(old,NULL);
+		LWP_SemPost(sem_b);
+		LWP_JoinThread(young,NULL);
+	}
+	LWP_SetStackOverflowCallback(NULL);
+	LWP_SemDestroy(sem_a);
+	LWP_SemDestroy(sem_b);
+	return overflows!=0;
+}
+
+static void* __smasher(void *arg)
+{
+	guardstack[1] = 0;
+	LWP_SemWait(sem_a);
+	return NULL;
+}
+
+/* a thread that wrote into the guard words is reported once it switches away */
+static int __test_stackguard(void)
+{
+	lwp_t thr = LWP_THREAD_NULL;
+	u32 hits;
+
+	overflows = 0;
+	overflowed = LWP_THREAD_NULL;
+	LWP_SemInit(&sem_a,0,1);
+	LWP_SetStackOverflowCallback(__overflowcb);
+	if(LWP_CreateThread(&thr,__smasher,NULL,guardstack,sizeof(guardstack),LWP_PRIO_HIGH)!=0) return 1;
+	hits = overflows;
+	guardstack[1] = 0xC5C5C5C5;
+	LWP_SemPost(sem_a);
+	LWP_JoinThread(thr,NULL);
+	LWP_SetStackOverflowCallback(NULL);
+	LWP_SemDestroy(sem_a);
+	return hits!=1 || overflows!=1 || overflowed!=thr;
+}
+
+static volatile u64 spin_first[2],spin_last[2];
+
+static void* __spinner(void *arg)
+{
+	u32 id = (u32)(unsigned long)arg;
+	u64 start = gettime();
+
+	spin_first[id] = start;
+	while(diff_ticks(start,gettime())<millisecs_to_ticks(60));
+	spin_last[id] = gettime();
+	return NULL;
+}
+
+/* busy threads of one priority share the CPU through the decrementer and the timeslice */
+static int __test_timeslice(void)
+{
+	lwp_t a,b;
+
+	a = __spawn(__spinner,(void*)0,LWP_PRIO_LOW);
+	b = __spawn(__spinner,(void*)1,LWP_PRIO_LOW);
+	LWP_JoinThread(a,NULL);
+	LWP_JoinThread(b,NULL);
+	return spin_first[1]>=spin_last[0];
+}
+
+/*---------------------------------------------------------------------------------*/
+static void* __benchyield(void *arg)
+{
+	u32 i;
+
+	for(i=0;i<BENCH_SWITCHES/2;i++) LWP_YieldThread();
+	return NULL;
+}
+
+static void __bench_switch(void)
+{
+	u64 start,elapsed;
+	lwp_t a,b;
+
+	/* at main's priority, so that neither starts before main blocks in the join */
+	a = __spawn(__benchyield,NULL,LWP_PRIO_NORMAL);
+	b = __spawn(__benchyield,NULL,LWP_PRIO_NORMAL);
+	start = gettime();
+	LWP_JoinThread(a,NULL);
+	LWP_JoinThread(b,NULL);
+	elapsed = diff_ticks(start,gettime());
+	printf("yield switch      %8.0f ns/switch\n",(double)ticks_to_nanosecs(elapsed)/BENCH_SWITCHES);
+
+	LWP_SemInit(&sem_a,0,1);
+	LWP_SemInit(&sem_b,0,1);
+	a = __spawn(__ponger,(void*)(BENCH_SWITCHES/2),LWP_PRIO_NORMAL);
+	start = gettime();
+	for(u32 i=0;i<BENCH_SWITCHES/2;i++) {
+		LWP_SemPost(sem_a);
+		LWP_SemWait(sem_b);
+	}
+	elapsed = diff_ticks(start,gettime());
+	LWP_JoinThread(a,NULL);
+	LWP_SemDestroy(sem_a);
+	LWP_SemDestroy(sem_b);
+	printf("sema ping-pong    %8.0f ns/switch\n",(double)ticks_to_nanosecs(elapsed)/BENCH_SWITCHES);
+}
+
+static volatile u64 wake_posted,wake_sum,wake_max;
+
+static void* __benchwaker(void *arg)
+{
+	u64 lat;
+	u32 i;
+
+	for(i=0;i<BENCH_WAKEUPS;i++) {
+		LWP_SemWait(sem_a);
+		lat = diff_ticks(wake_posted,gettime());
+		wake_sum += lat;
+		if(lat>wake_max) wake_max = lat;
+	}
+	return NULL;
+}
+
+/* LWP_SemPost to a higher priority waiter until it runs */
+static void __bench_wakeup(void)
+{
+	lwp_t thr;
+	u32 i;
+
+	wake_sum = wake_max = 0;
+	LWP_SemInit(&sem_a,0,1);
+	thr = __spawn(__benchwaker,NULL,LWP_PRIO_HIGH);
+	for(i=0;i<BENCH_WAKEUPS;i++) {
+		wake_posted = gettime();
+		LWP_SemPost(sem_a);
+	}
+	LWP_JoinThread(thr,NULL);
+	LWP_SemDestroy(sem_a);
+	printf("wakeup latency    %8.0f ns mean  %8.0f ns max\n",
+		   (double)ticks_to_nanosecs(wake_sum)/BENCH_WAKEUPS,(double)ticks_to_nanosecs(wake_max));
+}
+
+/* lateness of timed waits, from the watchdog through the decrementer to the woken thread */
+static void __bench_timer(void)
+{
+	static const u32 periods[] = {50,100,1000,10000};
+	struct timespec ts;
+	u64 start,late,sum,max;
+	u32 i,j;
+
+	LWP_SemInit(&sem_a,0,1);
+	for(i=0;i<sizeof(periods)/sizeof(periods[0]);i++) {
+		ts.tv_sec = 0;
+		ts.tv_nsec = periods[i]*TB_NSPERUS;
+
+		sum = max = 0;
+		for(j=0;j<BENCH_TIMERS;j++) {
+			start = gettime();
+			LWP_SemTimedWait(sem_a,&ts);
+			late = diff_ticks(start,gettime()) - microsecs_to_ticks(periods[i]);
+			if((s64)late<0) {
+				printf("timer %uus fired early\n",periods[i]);
+				late = 0;
+			}
+			sum += late;
+			if(late>max) max = late;
+			if(periods[i]>=10000 && j>=20) break;
+		}
+		printf("timer %6uus     %8.0f ns late mean  %8.0f ns max\n",periods[i],
+			   (double)ticks_to_nanosecs(sum)/j,(double)ticks_to_nanosecs(max));
+	}
+	LWP_SemDestroy(sem_a);
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "preempt",		__test_preempt },
+	{ "yield",			__test_yield },
+	{ "sema",			__test_sema },
+	{ "inherit",		__test_inherit },
+	{ "cond",			__test_cond },
+	{ "mqueue",			__test_mqueue },
+	{ "timeout",		__test_timeout },
+	{ "timeslice",		__test_timeslice },
+	{ "stackexit",		__test_stackexit },
+	{ "stackguard",		__test_stackguard },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		__bench_switch();
+		__bench_wakeup();
+		__bench_timer();
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	int i;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
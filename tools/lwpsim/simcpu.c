@@ -0,0 +1,385 @@
+/*-------------------------------------------------------------
+
+simcpu.c -- CPU, decrementer and system glue for the host simulation build of the kernel
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "asm.h"
+#include "processor.h"
+#include "sys_state.h"
+#include "lwp_threads.h"
+#include "lwp_watchdog.h"
+#include "lwp_wkspace.h"
+#include "lwp_priority.h"
+#include "timesupp.h"
+#include "context.h"
+#include "system.h"
+
+#define SIM_KERNEL_HEAP			(4*1024*1024)
+#define SIM_DRIVER_ARENA		(256*1024)
+#define SIM_MAX_CONTEXTS		1024
+
+/* a ucontext for each frame_context the kernel switches through; the
+   frame_context keeps its slot number + 1 in nExcept, which
+   __lwp_thread_init clears, so a zero marks a thread that never ran */
+typedef struct _simctx {
+	frame_context *ctx;
+	ucontext_t uc;
+	u32 msr;
+} simctx;
+
+volatile u32 __simcpu_msr = 0;
+volatile u32 __simcpu_pending = 0;
+
+static volatile u32 __simcpu_sprg0 = 0;
+static u64 __simcpu_decfire = 0;
+static u64 __simcpu_tbbase = 0;
+static timer_t __simcpu_dectimer;
+
+static simctx __simcpu_ctxs[SIM_MAX_CONTEXTS];
+static u32 __simcpu_ctxcnt = 0;
+
+static int (*__simcpu_entry)(void) = NULL;
+static int __simcpu_ret = 0;
+
+static u8 __simcpu_arena[SIM_KERNEL_HEAP+SIM_DRIVER_ARENA] ATTRIBUTE_ALIGN(32);
+static unsigned long __simcpu_arenahi = (unsigned long)__simcpu_arena + sizeof(__simcpu_arena);
+
+/* system alarms are not simulated, their object table stays empty */
+lwp_objinfo sys_alarm_objects;
+
+/* the main thread's stack, bounded by the symbols the linker script gives the target */
+__asm__(".bss\n"
+		".balign 32\n"
+		".globl __stack_end\n"
+		"__stack_end:\n"
+		".space 262144\n"
+		".globl __stack_addr\n"
+		"__stack_addr:\n"
+		".previous\n");
+
+extern void __lwp_thread_coreinit(void);
+extern void __lwp_sysinit(void);
+extern void __lwp_mutex_init(void);
+extern void __lwp_cond_init(void);
+extern void __lwp_mqbox_init(void);
+extern void __lwp_sema_init(void);
+extern void c_decrementerhandler(frame_context *ctx);
+
+/* the decrementer exception, as decrementer_handler.S runs it */
+void __simcpu_interrupt(void)
+{
+	u32 msr;
+
+	while(__simcpu_pending && (__simcpu_msr&MSR_EE)) {
+		msr = __simcpu_msr;
+		__simcpu_msr &= ~MSR_EE;
+		__simcpu_pending = 0;
+
+		__simcpu_sprg0++;
+		_thread_dispatch_disable_level++;
+
+		c_decrementerhandler(NULL);
+
+		__simcpu_sprg0--;
+		if(--_thread_dispatch_disable_level==0 && _context_switch_want)
+			__thread_dispatch();
+
+		__simcpu_msr = msr;
+	}
+}
+
+static void __simcpu_decsignal(int sig)
+{
+	int err = errno;
+
+	__simcpu_pending = 1;
+	if(__simcpu_msr&MSR_EE) __simcpu_interrupt();
+
+	errno = err;
+}
+
+void __simcpu_mtmsr(u32 msr)
+{
+	sigset_t mask;
+
+	__simcpu_msr = (msr&~MSR_POW);
+	if(!(msr&MSR_EE)) return;
+
+	if(__simcpu_pending) __simcpu_interrupt();
+	if(msr&MSR_POW) {
+		/* doze until the decrementer, the signal takes the interrupt */
+		sigemptyset(&mask);
+		if(!__simcpu_pending) sigsuspend(&mask);
+		if(__simcpu_pending) __simcpu_interrupt();
+	}
+}
+
+u32 __simcpu_mfdec(void)
+{
+	return (u32)(s32)(__simcpu_decfire - gettime());
+}
+
+void __simcpu_mtdec(u32 val)
+{
+	struct itimerspec its;
+	u64 ns;
+
+	memset(&its,0,sizeof(its));
+	if((s32)val<=0) {
+		/* expired, or negative: the interrupt is pending right away */
+		timer_settime(__simcpu_dectimer,0,&its,NULL);
+		__simcpu_decfire = gettime();
+		__simcpu_pending = 1;
+		if(__simcpu_msr&MSR_EE) __simcpu_interrupt();
+		return;
+	}
+
+	ns = ticks_to_nanosecs(val);
+	__simcpu_decfire = gettime() + val;
+
+	its.it_value.tv_sec = ns/TB_NSPERSEC;
+	its.it_value.tv_nsec = ns%TB_NSPERSEC;
+	timer_settime(__simcpu_dectimer,0,&its,NULL);
+}
+
+u32 __simcpu_mfspr(u32 rn)
+{
+	if(rn==SPRG0) return __simcpu_sprg0;
+	return 0;
+}
+
+void __simcpu_mtspr(u32 rn,u32 val)
+{
+	if(rn==SPRG0) __simcpu_sprg0 = val;
+}
+
+static simctx* __simcpu_getctx(frame_context *ctx)
+{
+	u32 i;
+
+	if(ctx->nExcept) return &__simcpu_ctxs[ctx->nExcept - 1];
+
+	/* a thread control block that ran before is reused for a new thread */
+	for(i=0;i<__simcpu_ctxcnt;i++) {
+		if(__simcpu_ctxs[i].ctx==ctx) break;
+	}
+	if(i==__simcpu_ctxcnt) {
+		if(__simcpu_ctxcnt==SIM_MAX_CONTEXTS) {
+			fprintf(stderr,"simcpu: out of contexts\n");
+			abort();
+		}
+		__simcpu_ctxcnt++;
+	}
+
+	__simcpu_ctxs[i].ctx = ctx;
+	return &__simcpu_ctxs[i];
+}
+
+static void __simcpu_threadstart(void)
+{
+	frame_context *ctx = &_thr_executing->context;
+	void (*entry)(void) = (void(*)(void))(unsigned long)ctx->lr;
+
+	/* the handler never returns, __lwp_thread_exit switches away for good */
+	__simcpu_mtmsr(ctx->msr);
+	entry();
+	abort();
+}
+
+void _cpu_context_switch(void *from,void *to)
+{
+	frame_context *fctx = from,*tctx = to;
+	simctx *f,*t;
+	lwp_cntrl *thethread;
+
+	f = __simcpu_getctx(fctx);
+	f->msr = __simcpu_msr;
+	fctx->nExcept = (f - __simcpu_ctxs) + 1;
+
+	t = __simcpu_getctx(tctx);
+	if(!tctx->nExcept) {
+		/* a thread's first switch: start the handler __lwp_thread_loadenv put in LR on its own stack */
+		thethread = (lwp_cntrl*)((u8*)tctx - offsetof(lwp_cntrl,context));
+
+		getcontext(&t->uc);
+		t->uc.uc_stack.ss_sp = thethread->stack;
+		t->uc.uc_stack.ss_size = thethread->stack_size;
+		t->uc.uc_link = NULL;
+		sigemptyset(&t->uc.uc_sigmask);
+		makecontext(&t->uc,__simcpu_threadstart,0);
+		tctx->nExcept = (t - __simcpu_ctxs) + 1;
+	}
+
+	/* the switch itself is atomic, as on the target */
+	__simcpu_msr &= ~MSR_EE;
+	swapcontext(&f->uc,&t->uc);
+	__simcpu_mtmsr(f->msr);
+}
+
+void _cpu_context_switch_ex(void *from,void *to)
+{
+	_cpu_context_switch(from,to);
+}
+
+void _cpu_context_save_fp(void *ctx)
+{
+}
+
+void _cpu_context_restore_fp(void *ctx)
+{
+}
+
+u64 gettime()
+{
+	struct timespec ts;
+	u64 ns;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	ns = ((u64)ts.tv_sec*TB_NSPERSEC + ts.tv_nsec) - __simcpu_tbbase;
+	return nanosecs_to_ticks(ns);
+}
+
+s64 __SYS_GetSystemTime()
+{
+	return gettime();
+}
+
+/* hands out the arena from the top down, the kernel workspace first */
+void* SYS_AllocArenaMemHi(u32 size,u32 align)
+{
+	unsigned long hi = __simcpu_arenahi;
+
+	hi = (hi - size) & ~((unsigned long)align - 1);
+	if(hi<(unsigned long)__simcpu_arena || hi>__simcpu_arenahi) abort();
+	__simcpu_arenahi = hi;
+	return (void*)hi;
+}
+
+void kprintf(const char *fmt,...)
+{
+	u32 level;
+	va_list args;
+
+	_CPU_ISR_Disable(level);
+	va_start(args,fmt);
+	vfprintf(stderr,fmt,args);
+	va_end(args);
+	_CPU_ISR_Restore(level);
+}
+
+void SYS_Report(const char *msg,...)
+{
+	u32 level;
+	va_list args;
+
+	_CPU_ISR_Disable(level);
+	va_start(args,msg);
+	vprintf(msg,args);
+	va_end(args);
+	_CPU_ISR_Restore(level);
+}
+
+int __libc_create_hook(lwp_cntrl *curr_thr,lwp_cntrl *create_thr)
+{
+	return 1;
+}
+
+int __libc_start_hook(lwp_cntrl *curr_thr,lwp_cntrl *start_thr)
+{
+	return 1;
+}
+
+int __libc_delete_hook(lwp_cntrl *curr_thr,lwp_cntrl *delete_thr)
+{
+	return 1;
+}
+
+int __crtmain()
+{
+	__simcpu_ret = __simcpu_entry();
+	__lwp_thread_stopmultitasking(NULL);
+	return __simcpu_ret;
+}
+
+int simcpu_run(int (*entry)(void))
+{
+	u32 level;
+	struct sigaction sa;
+	struct sigevent sev;
+	struct itimerspec its;
+	struct timespec ts;
+
+	memset(&sa,0,sizeof(sa));
+	sa.sa_handler = __simcpu_decsignal;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM,&sa,NULL);
+
+	memset(&sev,0,sizeof(sev));
+	sev.sigev_notify = SIGEV_SIGNAL;
+	sev.sigev_signo = SIGALRM;
+	if(timer_create(CLOCK_MONOTONIC,&sev,&__simcpu_dectimer)) {
+		perror("timer_create");
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	__simcpu_tbbase = (u64)ts.tv_sec*TB_NSPERSEC + ts.tv_nsec;
+	__simcpu_entry = entry;
+
+	/* the kernel part of SYS_Init */
+	_CPU_ISR_Disable(level);
+	__lwp_wkspace_init(SIM_KERNEL_HEAP);
+	__sys_state_init();
+	__lwp_priority_init();
+	__lwp_watchdog_init();
+	__lwp_thread_coreinit();
+	__lwp_sysinit();
+	__lwp_mqbox_init();
+	__lwp_sema_init();
+	__lwp_mutex_init();
+	__lwp_cond_init();
+	__lwp_thread_startmultitasking();
+	_CPU_ISR_Restore(level);
+
+	memset(&its,0,sizeof(its));
+	timer_settime(__simcpu_dectimer,0,&its,NULL);
+	timer_delete(__simcpu_dectimer);
+
+	return __simcpu_ret;
+}
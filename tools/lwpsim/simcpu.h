@@ -0,0 +1,188 @@
+/*-------------------------------------------------------------
+
+simcpu.h -- processor.h for the host simulation build of the kernel
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __OGC_MACHINE_PROCESSOR_H__
+#define __OGC_MACHINE_PROCESSOR_H__
+
+/* Force-included ahead of every source of the host simulation build, it
+   takes the include guard of gc/ogc/machine/processor.h in its place.
+   Only the MSR[EE] and MSR[POW] bits, SPRG0 (the interrupt nesting level)
+   and the decrementer exist: EE is a flag that the decrementer signal
+   checks, POW waits for the next signal. The kernel is linked non-PIE so
+   that its (u32) pointer casts hold, as on the 32-bit target. */
+
+#include <gctypes.h>
+#include "asm.h"
+
+#define __stringify(rn)								#rn
+#define ATTRIBUTE_ALIGN(v)							__attribute__((aligned(v)))
+#define STACK_ALIGN(type, name, cnt, alignment)		u8 _al__##name[(sizeof(type)*(cnt)) + (alignment)]; \
+													type *name = (type*)((((unsigned long)(_al__##name)) + ((alignment)-1)) & ~((unsigned long)(alignment)-1))
+
+#define _sync() __sync_synchronize()
+#define _isync() __asm__ __volatile__("" : : : "memory")
+#define _nop() __asm__ __volatile__("nop")
+#define ppcsync() _isync(); _sync()
+
+#ifdef __cplusplus
+   extern "C" {
+#endif /* __cplusplus */
+
+extern volatile u32 __simcpu_msr;
+extern volatile u32 __simcpu_pending;
+
+void __simcpu_mtmsr(u32 msr);
+void __simcpu_interrupt(void);
+u32 __simcpu_mfdec(void);
+void __simcpu_mtdec(u32 val);
+u32 __simcpu_mfspr(u32 rn);
+void __simcpu_mtspr(u32 rn,u32 val);
+
+/* brings the kernel up as SYS_Init does and runs entry as the main thread,
+   returns its result once it is done */
+int simcpu_run(int (*entry)(void));
+
+#ifdef __cplusplus
+   }
+#endif /* __cplusplus */
+
+#define __simcpu_barrier() __asm__ __volatile__("" : : : "memory")
+
+#define mfmsr()			(__simcpu_msr)
+#define mtmsr(val)		__simcpu_mtmsr(val)
+
+#define mfdec()			__simcpu_mfdec()
+#define mtdec(_val)		__simcpu_mtdec(_val)
+
+#define mfsp()			((u32)(unsigned long)__builtin_frame_address(0))
+
+#define mfspr(_rn)			__simcpu_mfspr(_rn)
+#define mtspr(_rn, _val)	__simcpu_mtspr(_rn,_val)
+
+/* lswx/stswx move up to four bytes, big-endian, through a register */
+static inline u32 __simcpu_lswx(const void *base,u32 bytes)
+{
+	u32 i,res = 0;
+
+	for(i=0;i<bytes && i<4;i++) res |= (u32)((const u8*)base)[i]<<(24-i*8);
+	return res;
+}
+
+static inline void __simcpu_stswx(void *base,u32 bytes,u32 value)
+{
+	u32 i;
+
+	for(i=0;i<bytes && i<4;i++) ((u8*)base)[i] = (u8)(value>>(24-i*8));
+}
+
+#define __lswx(base,bytes)			__simcpu_lswx((base),(bytes))
+#define __stswx(base,bytes,value)	__simcpu_stswx((base),(bytes),(value))
+
+/* lhbrx/lwbrx and their stores access little-endian data, whatever the host */
+static inline u32 __simcpu_lbrx(const void *base,u32 bytes)
+{
+	u32 i,res = 0;
+
+	for(i=0;i<bytes;i++) res |= (u32)((const u8*)base)[i]<<(i*8);
+	return res;
+}
+
+static inline void __simcpu_stbrx(void *base,u32 bytes,u32 value)
+{
+	u32 i;
+
+	for(i=0;i<bytes;i++) ((u8*)base)[i] = (u8)(value>>(i*8));
+}
+
+#define __lhbrx(base,index)			((u16)__simcpu_lbrx((const u8*)(base)+(index),2))
+#define __lwbrx(base,index)			__simcpu_lbrx((const u8*)(base)+(index),4)
+#define __sthbrx(base,index,value)	__simcpu_stbrx((u8*)(base)+(index),2,(value))
+#define __stwbrx(base,index,value)	__simcpu_stbrx((u8*)(base)+(index),4,(value))
+
+#ifndef bswap16
+#define bswap16(_val)	__builtin_bswap16(_val)
+#endif
+#ifndef bswap32
+#define bswap32(_val)	__builtin_bswap32(_val)
+#endif
+#ifndef bswap64
+#define bswap64(_val)	__builtin_bswap64(_val)
+#endif
+
+#define cntlzw(_val)	__builtin_clz(_val)
+#define cntlzd(_val)	__builtin_clzll(_val)
+
+#define _CPU_MSR_GET( _msr_value ) \
+	do { \
+		(_msr_value) = __simcpu_msr; \
+	} while (0)
+
+#define _CPU_MSR_SET( _msr_value ) \
+	__simcpu_mtmsr(_msr_value)
+
+/* a decrementer signal that finds EE clear only sets __simcpu_pending,
+   setting EE takes the interrupt as MSR[EE] would */
+#define _CPU_ISR_Enable() \
+	do { \
+		__simcpu_barrier(); \
+		__simcpu_msr |= MSR_EE; \
+		__simcpu_barrier(); \
+		if(__simcpu_pending) __simcpu_interrupt(); \
+	} while (0)
+
+#define _CPU_ISR_Disable( _isr_cookie ) \
+	do { \
+		__simcpu_barrier(); \
+		(_isr_cookie) = (__simcpu_msr&MSR_EE) ? 1 : 0; \
+		__simcpu_msr &= ~MSR_EE; \
+		__simcpu_barrier(); \
+	} while (0)
+
+#define _CPU_ISR_Restore( _isr_cookie )  \
+	do { \
+		if(_isr_cookie) _CPU_ISR_Enable(); \
+		else __simcpu_msr &= ~MSR_EE; \
+	} while (0)
+
+#define _CPU_ISR_Flash( _isr_cookie ) \
+	do { \
+		if(_isr_cookie) { \
+			_CPU_ISR_Enable(); \
+			__simcpu_msr &= ~MSR_EE; \
+			__simcpu_barrier(); \
+		} \
+	} while (0)
+
+#define _CPU_FPR_Enable()
+#define _CPU_FPR_Disable()
+
+/* the time base is the host monotonic clock, see gettime() in simcpu.c */
+#include "timesupp.h"
+#undef gettick
+#define gettick()		((u32)gettime())
+
+#endif
@@ -0,0 +1,69 @@
+/*-------------------------------------------------------------
+
+maddecode.c -- whole-buffer libmad decode for madtest
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Built once per libmad build with MADDECODE naming the entry point, so the
+ * same loop drives the fixed-point and the floating-point decoder.
+ */
+
+#include <mad.h>
+
+#include "maddecode.h"
+
+u32 MADDECODE(const u8 *buf,u32 len,double *out,u32 maxsamples,u32 *errors)
+{
+	u32 i,n = 0;
+	struct mad_stream stream;
+	struct mad_frame frame;
+	struct mad_synth synth;
+
+	mad_stream_init(&stream);
+	mad_frame_init(&frame);
+	mad_synth_init(&synth);
+
+	*errors = 0;
+	mad_stream_buffer(&stream,buf,len);
+	for(;;) {
+		if(mad_frame_decode(&frame,&stream)) {
+			/* the search for a next frame in the guard bytes loses sync */
+			if(stream.this_frame<buf + len - MAD_BUFFER_GUARD) (*errors)++;
+			if(MAD_RECOVERABLE(stream.error)) continue;
+			break;
+		}
+
+		mad_synth_frame(&synth,&frame);
+		for(i=0;i<synth.pcm.length && n+synth.pcm.channels<=maxsamples;i++) {
+			out[n++] = mad_f_todouble(synth.pcm.samples[0][i]);
+			if(synth.pcm.channels==2) out[n++] = mad_f_todouble(synth.pcm.samples[1][i]);
+		}
+	}
+
+	mad_synth_finish(&synth);
+	mad_frame_finish(&frame);
+	mad_stream_finish(&stream);
+	return n;
+}
@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------
+
+maddecode.h -- whole-buffer libmad decode for madtest
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __MADDECODE_H__
+#define __MADDECODE_H__
+
+#include <gctypes.h>
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/*
+ * Decodes every frame of an MPEG audio stream and stores the interleaved
+ * output samples as doubles, full scale +-1.0. len must include
+ * MAD_BUFFER_GUARD zero bytes after the last frame. Returns the number of
+ * samples stored, and the number of frames libmad rejected in *errors.
+ * maddecode.c is built once against each libmad build.
+ */
+u32 mad_decodefixed(const u8 *buf,u32 len,double *out,u32 maxsamples,u32 *errors);
+u32 mad_decodefloat(const u8 *buf,u32 len,double *out,u32 maxsamples,u32 *errors);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/*-------------------------------------------------------------
+
+madfixed.h -- symbol renames for the fixed-point libmad build of madtest
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * madtest links libmad twice, once as FPM_64BIT and once as FPM_FLOAT. This
+ * header is forced into every object of the fixed-point build so that its
+ * external symbols do not collide with the floating-point ones.
+ */
+
+#ifndef __MADFIXED_H__
+#define __MADFIXED_H__
+
+#define mad_author					madfixed_author
+#define mad_bit_crc					madfixed_bit_crc
+#define mad_bit_init				madfixed_bit_init
+#define mad_bit_length				madfixed_bit_length
+#define mad_bit_nextbyte			madfixed_bit_nextbyte
+#define mad_bit_read				madfixed_bit_read
+#define mad_bit_skip				madfixed_bit_skip
+#define mad_build					madfixed_build
+#define mad_copyright				madfixed_copyright
+#define mad_decoder_finish			madfixed_decoder_finish
+#define mad_decoder_init			madfixed_decoder_init
+#define mad_decoder_message			madfixed_decoder_message
+#define mad_decoder_run				madfixed_decoder_run
+#define mad_f_abs					madfixed_f_abs
+#define mad_f_div					madfixed_f_div
+#define mad_frame_decode			madfixed_frame_decode
+#define mad_frame_finish			madfixed_frame_finish
+#define mad_frame_init				madfixed_frame_init
+#define mad_frame_mute				madfixed_frame_mute
+#define mad_header_decode			madfixed_header_decode
+#define mad_header_init				madfixed_header_init
+#define mad_huff_pair_table			madfixed_huff_pair_table
+#define mad_huff_quad_table			madfixed_huff_quad_table
+#define mad_layer_I					madfixed_layer_I
+#define mad_layer_II				madfixed_layer_II
+#define mad_layer_III				madfixed_layer_III
+#define mad_stream_buffer			madfixed_stream_buffer
+#define mad_stream_errorstr			madfixed_stream_errorstr
+#define mad_stream_finish			madfixed_stream_finish
+#define mad_stream_init				madfixed_stream_init
+#define mad_stream_skip				madfixed_stream_skip
+#define mad_stream_sync				madfixed_stream_sync
+#define mad_synth_frame				madfixed_synth_frame
+#define mad_synth_init				madfixed_synth_init
+#define mad_synth_mute				madfixed_synth_mute
+#define mad_timer_abs				madfixed_timer_abs
+#define mad_timer_add				madfixed_timer_add
+#define mad_timer_compare			madfixed_timer_compare
+#define mad_timer_count				madfixed_timer_count
+#define mad_timer_fraction			madfixed_timer_fraction
+#define mad_timer_multiply			madfixed_timer_multiply
+#define mad_timer_negate			madfixed_timer_negate
+#define mad_timer_set				madfixed_timer_set
+#define mad_timer_string			madfixed_timer_string
+#define mad_timer_zero				madfixed_timer_zero
+#define mad_version					madfixed_version
+
+#endif
@@ -0,0 +1,495 @@
+/*-------------------------------------------------------------
+
+madstream.c -- synthetic MPEG-1 audio streams for the libmad tests
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "madstream.h"
+
+#define MODE_STEREO				0
+#define MODE_JOINT_STEREO		1
+
+typedef struct _bitwriter {
+	u8 *buf;
+	u32 pos;
+} bitwriter;
+
+typedef struct _header {
+	u32 layer;
+	u32 bitrate;				// bitrate_index
+	u32 samplerate;				// sampling_frequency
+	u32 padding;
+	u32 mode;
+	u32 ext;
+} header;
+
+/* ISO/IEC 11172-3 2.4.2.3, kbit/s by layer and bitrate_index */
+static const u16 bitrates[3][15] = {
+	{0,32,64,96,128,160,192,224,256,288,320,352,384,416,448},
+	{0,32,48,56,64,80,96,112,128,160,192,224,256,320,384},
+	{0,32,40,48,56,64,80,96,112,128,160,192,224,256,320}
+};
+
+static const u32 samplerates[3] = {44100,48000,32000};
+
+static u32 rnd(madstream *ms,u32 n)
+{
+	ms->seed = ms->seed*1103515245 + 12345;
+	return (ms->seed>>8)%n;
+}
+
+static void putbits(bitwriter *bw,u32 val,u32 n)
+{
+	while(n--) {
+		if((val>>n)&1) bw->buf[bw->pos>>3] |= 0x80>>(bw->pos&7);
+		bw->pos++;
+	}
+}
+
+static void putheader(bitwriter *bw,const header *h)
+{
+	putbits(bw,0xfff,12);
+	putbits(bw,1,1);			// MPEG-1
+	putbits(bw,4 - h->layer,2);
+	putbits(bw,1,1);			// no CRC
+	putbits(bw,h->bitrate,4);
+	putbits(bw,h->samplerate,2);
+	putbits(bw,h->padding,1);
+	putbits(bw,0,1);			// private bit
+	putbits(bw,h->mode,2);
+	putbits(bw,h->ext,2);
+	putbits(bw,0,4);			// copyright, original, emphasis
+}
+
+/*---------------------------------------------------------------------------------*/
+static void __layer1(madstream *ms,bitwriter *bw,header *h,u32 framebits)
+{
+	u32 sb,ch,s,bits,bound;
+	u8 alloc[2][32];
+
+	h->mode = rnd(ms,2);
+	h->ext = rnd(ms,4);
+	bound = h->mode==MODE_JOINT_STEREO ? 4 + h->ext*4 : 32;
+
+	for(sb=0;sb<32;sb++) {
+		for(ch=0;ch<2;ch++) alloc[ch][sb] = rnd(ms,3) ? rnd(ms,15) : 0;		// 15 is forbidden
+		if(sb>=bound) alloc[1][sb] = alloc[0][sb];
+	}
+
+	/* drop whole subbands until the frame fits */
+	for(;;) {
+		bits = 32 + 4*(bound*2 + 32 - bound);
+		for(sb=0;sb<32;sb++) {
+			for(ch=0;ch<2;ch++) {
+				if(alloc[ch][sb]) bits += 6 + (sb<bound || ch==0 ? 12*(alloc[ch][sb] + 1) : 0);
+			}
+		}
+		if(bits<=framebits) break;
+		sb = rnd(ms,32);
+		alloc[0][sb] = alloc[1][sb] = 0;
+	}
+
+	putheader(bw,h);
+	for(sb=0;sb<32;sb++) {
+		for(ch=0;ch<(sb<bound ? 2u : 1u);ch++) putbits(bw,alloc[ch][sb],4);
+	}
+	for(sb=0;sb<32;sb++) {
+		for(ch=0;ch<2;ch++) {
+			if(alloc[ch][sb]) putbits(bw,6 + rnd(ms,57),6);
+		}
+	}
+	for(s=0;s<12;s++) {
+		for(sb=0;sb<32;sb++) {
+			for(ch=0;ch<(sb<bound ? 2u : 1u);ch++) {
+				if(alloc[ch][sb]) putbits(bw,rnd(ms,(2<<alloc[ch][sb]) - 1),alloc[ch][sb] + 1);
+			}
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------------*/
+/* ISO/IEC 11172-3 Tables B.2a and B.2b, the allocations of the higher bitrates */
+static const u8 II_offsets[30] = {
+	7,7,7,6,6,6,6,6,6,6,6,3,3,3,3,3,3,3,3,3,3,3,3,0,0,0,0,0,0,0
+};
+
+static const struct {
+	u8 nbal;
+	u8 offset;
+} II_bitalloc[8] = {
+	{2,0},{2,3},{3,3},{3,1},{4,2},{4,3},{4,4},{4,5}
+};
+
+static const u8 II_classes[6][15] = {
+	{0,1,16},
+	{0,1,2,3,4,5,16},
+	{0,1,2,3,4,5,6,7,8,9,10,11,12,13,14},
+	{0,1,3,4,5,6,7,8,9,10,11,12,13,14,15},
+	{0,1,2,3,4,5,6,7,8,9,10,11,12,13,16},
+	{0,2,4,5,6,7,8,9,10,11,12,13,14,15,16}
+};
+
+static const struct {
+	u16 nlevels;
+	u8 grouped;
+	u8 bits;					// per group of three if grouped, else per sample
+} II_quant[17] = {
+	{3,1,5},{5,1,7},{7,0,3},{9,1,10},{15,0,4},{31,0,5},{63,0,6},{127,0,7},{255,0,8},
+	{511,0,9},{1023,0,10},{2047,0,11},{4095,0,12},{8191,0,13},{16383,0,14},{32767,0,15},{65535,0,16}
+};
+
+static const u8 II_scalefactors[4] = {3,2,1,2};
+
+static u32 II_class(u32 sb,u32 alloc)
+{
+	return II_classes[II_bitalloc[II_offsets[sb]].offset][alloc - 1];
+}
+
+static void __layer2(madstream *ms,bitwriter *bw,header *h,u32 framebits,u32 sblimit)
+{
+	u32 sb,ch,gr,s,q,bits,bound,nch,code;
+	u8 alloc[2][32],scfsi[2][32];
+
+	h->mode = rnd(ms,2);
+	h->ext = rnd(ms,4);
+	bound = h->mode==MODE_JOINT_STEREO ? 4 + h->ext*4 : 32;
+	if(bound>sblimit) bound = sblimit;
+
+	for(sb=0;sb<sblimit;sb++) {
+		for(ch=0;ch<2;ch++) {
+			alloc[ch][sb] = rnd(ms,3) ? rnd(ms,1<<II_bitalloc[II_offsets[sb]].nbal) : 0;
+			scfsi[ch][sb] = rnd(ms,4);
+		}
+		if(sb>=bound) alloc[1][sb] = alloc[0][sb];
+	}
+
+	for(;;) {
+		bits = 32;
+		for(sb=0;sb<sblimit;sb++) {
+			nch = sb<bound ? 2 : 1;
+			bits += nch*II_bitalloc[II_offsets[sb]].nbal;
+			for(ch=0;ch<2;ch++) {
+				if(!alloc[ch][sb]) continue;
+
+				bits += 2 + 6*II_scalefactors[scfsi[ch][sb]];
+				if(ch<nch) {
+					q = II_class(sb,alloc[ch][sb]);
+					bits += 12*(II_quant[q].grouped ? 1 : 3)*II_quant[q].bits;
+				}
+			}
+		}
+		if(bits<=framebits) break;
+		sb = rnd(ms,sblimit);
+		alloc[0][sb] = alloc[1][sb] = 0;
+	}
+
+	putheader(bw,h);
+	for(sb=0;sb<sblimit;sb++) {
+		for(ch=0;ch<(sb<bound ? 2u : 1u);ch++) putbits(bw,alloc[ch][sb],II_bitalloc[II_offsets[sb]].nbal);
+	}
+	for(sb=0;sb<sblimit;sb++) {
+		for(ch=0;ch<2;ch++) {
+			if(alloc[ch][sb]) putbits(bw,scfsi[ch][sb],2);
+		}
+	}
+	for(sb=0;sb<sblimit;sb++) {
+		for(ch=0;ch<2;ch++) {
+			if(!alloc[ch][sb]) continue;
+			for(s=0;s<II_scalefactors[scfsi[ch][sb]];s++) putbits(bw,6 + rnd(ms,57),6);
+		}
+	}
+	for(gr=0;gr<12;gr++) {
+		for(sb=0;sb<sblimit;sb++) {
+			for(ch=0;ch<(sb<bound ? 2u : 1u);ch++) {
+				if(!alloc[ch][sb]) continue;
+
+				q = II_class(sb,alloc[ch][sb]);
+				if(II_quant[q].grouped) {
+					code = rnd(ms,II_quant[q].nlevels);
+					code = code*II_quant[q].nlevels + rnd(ms,II_quant[q].nlevels);
+					code = code*II_quant[q].nlevels + rnd(ms,II_quant[q].nlevels);
+					putbits(bw,code,II_quant[q].bits);
+				} else {
+					for(s=0;s<3;s++) putbits(bw,rnd(ms,II_quant[q].nlevels),II_quant[q].bits);
+				}
+			}
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------------*/
+/* 32 bytes of stereo side information follow the header */
+#define III_SIDEINFO_BYTES		32
+#define III_MAX_CHANNEL_BITS	((1440 - 4 - III_SIDEINFO_BYTES + MADSTREAM_RESERVOIR)*8/4)
+
+typedef struct _granule {
+	u32 part2_3_length;
+	u32 big_values;
+	u32 quads;
+	u32 global_gain;
+	u32 scalefac_compress;
+	u32 block_type;
+	u32 mixed;
+	u32 subblock_gain[3];
+	u32 region0_count;
+	u32 region1_count;
+	u32 preflag;
+	u32 scalefac_scale;
+	u8 data[(III_MAX_CHANNEL_BITS + 7)/8];
+} granule;
+
+static const u8 III_slen[16][2] = {
+	{0,0},{0,1},{0,2},{0,3},{3,0},{1,1},{1,2},{1,3},
+	{2,1},{2,2},{2,3},{3,1},{3,2},{3,3},{4,2},{4,3}
+};
+
+/* ISO/IEC 11172-3 Table B.7, Huffman code table 1: {hcod,hlen} by x,y */
+static const u8 III_table1[2][2][2] = {
+	{{1,1},{1,3}},
+	{{1,2},{0,3}}
+};
+
+/* scalefactors, then big_values pairs in table 1, then quads in count1 table B */
+static void III_maindata(madstream *ms,granule *g)
+{
+	u32 i,n1,n2,x,y,v,w;
+	bitwriter bw = {g->data,0};
+
+	memset(g->data,0,sizeof(g->data));
+
+	if(g->block_type==2) {
+		n1 = g->mixed ? 8 + 3*3 : 6*3;
+		n2 = 6*3;
+	} else {
+		n1 = 11;
+		n2 = 10;
+	}
+	for(i=0;i<n1;i++) putbits(&bw,rnd(ms,1<<III_slen[g->scalefac_compress][0]),III_slen[g->scalefac_compress][0]);
+	for(i=0;i<n2;i++) putbits(&bw,rnd(ms,1<<III_slen[g->scalefac_compress][1]),III_slen[g->scalefac_compress][1]);
+
+	for(i=0;i<g->big_values;i++) {
+		x = rnd(ms,2);
+		y = rnd(ms,2);
+		putbits(&bw,III_table1[x][y][0],III_table1[x][y][1]);
+		if(x) putbits(&bw,rnd(ms,2),1);
+		if(y) putbits(&bw,rnd(ms,2),1);
+	}
+	for(i=0;i<g->quads;i++) {
+		v = rnd(ms,16);
+		putbits(&bw,~v&0xf,4);
+		for(w=8;w;w>>=1) {
+			if(v&w) putbits(&bw,rnd(ms,2),1);
+		}
+	}
+	g->part2_3_length = bw.pos;
+}
+
+/* worst case of a granule: 126 scalefactor bits and five bits a pair */
+static u32 III_maxbits(const granule *g)
+{
+	return 126 + 5*g->big_values + 8*g->quads;
+}
+
+static void __layer3(madstream *ms,bitwriter *bw,header *h,u32 framebits)
+{
+	u32 gr,ch,i,block_type,mixed,budget,begin,start,len,n;
+	u8 md[1440 + MADSTREAM_RESERVOIR];
+	u32 offset[1440 + MADSTREAM_RESERVOIR];
+	bitwriter mdw = {md,0};
+	granule g[2][2];
+
+	h->mode = rnd(ms,2);
+	h->ext = h->mode==MODE_JOINT_STEREO ? rnd(ms,4) : 0;
+	begin = ms->reservoir ? ms->mdfree : 0;
+	budget = (framebits - 32 - III_SIDEINFO_BYTES*8 + begin*8)/4;
+
+	/* joint stereo needs the same blocks in both channels, so every mode gets them */
+	for(gr=0;gr<2;gr++) {
+		block_type = rnd(ms,2) ? 1 + rnd(ms,3) : 0;
+		mixed = block_type==2 ? rnd(ms,2) : 0;
+
+		for(ch=0;ch<2;ch++) {
+			granule *c = &g[gr][ch];
+
+			c->block_type = block_type;
+			c->mixed = mixed;
+			c->global_gain = 140 + rnd(ms,50);
+			c->scalefac_compress = rnd(ms,16);
+			for(i=0;i<3;i++) c->subblock_gain[i] = rnd(ms,8);
+			c->region0_count = rnd(ms,16);
+			c->region1_count = rnd(ms,8);
+			if(c->region0_count + c->region1_count>20) c->region1_count = 20 - c->region0_count;
+			c->preflag = rnd(ms,2);
+			c->scalefac_scale = rnd(ms,2);
+			c->big_values = rnd(ms,289);
+			c->quads = rnd(ms,(576 - 2*c->big_values)/4 + 1);
+			while(III_maxbits(c)>budget && (c->big_values || c->quads)) {
+				c->big_values /= 2;
+				c->quads /= 2;
+			}
+			if(III_maxbits(c)>budget) c->scalefac_compress = 0;
+			III_maindata(ms,c);
+		}
+	}
+
+	putheader(bw,h);
+	putbits(bw,begin,9);		// main_data_begin
+	putbits(bw,0,3);			// private_bits
+	putbits(bw,0,8);			// scfsi
+	for(gr=0;gr<2;gr++) {
+		for(ch=0;ch<2;ch++) {
+			granule *c = &g[gr][ch];
+
+			putbits(bw,c->part2_3_length,12);
+			putbits(bw,c->big_values,9);
+			putbits(bw,c->global_gain,8);
+			putbits(bw,c->scalefac_compress,4);
+			if(c->block_type) {
+				putbits(bw,1,1);
+				putbits(bw,c->block_type,2);
+				putbits(bw,c->mixed,1);
+				putbits(bw,1,5);
+				putbits(bw,1,5);
+				for(i=0;i<3;i++) putbits(bw,c->subblock_gain[i],3);
+			} else {
+				putbits(bw,0,1);
+				for(i=0;i<3;i++) putbits(bw,1,5);
+				putbits(bw,c->region0_count,4);
+				putbits(bw,c->region1_count,3);
+			}
+			putbits(bw,c->preflag,1);
+			putbits(bw,c->scalefac_scale,1);
+			putbits(bw,1,1);	// count1 table B
+		}
+	}
+
+	memset(md,0,sizeof(md));
+	for(gr=0;gr<2;gr++) {
+		for(ch=0;ch<2;ch++) {
+			for(i=0;i<g[gr][ch].part2_3_length;i++) putbits(&mdw,(g[gr][ch].data[i>>3]>>(7 - (i&7)))&1,1);
+		}
+	}
+
+	/* the main data goes to the free bytes of the frames before, then to this one's */
+	start = bw->buf - ms->buf + bw->pos/8;
+	n = 0;
+	for(i=ms->mdfree - begin;i<ms->mdfree;i++) offset[n++] = ms->mdoffset[i];
+	for(i=start;i<start + framebits/8 - bw->pos/8;i++) offset[n++] = i;
+
+	len = (mdw.pos + 7)/8;
+	for(i=0;i<len;i++) ms->buf[offset[i]] = md[i];
+
+	ms->mdfree = n - len<MADSTREAM_RESERVOIR ? n - len : MADSTREAM_RESERVOIR;
+	memmove(ms->mdoffset,offset + n - ms->mdfree,ms->mdfree*sizeof(u32));
+}
+
+/*---------------------------------------------------------------------------------*/
+void madstream_init(madstream *ms,u8 *buf,u32 size,u32 seed)
+{
+	memset(buf,0,size);
+	ms->buf = buf;
+	ms->size = size;
+	ms->len = 0;
+	ms->seed = seed;
+	ms->rest = 0;
+	ms->reservoir = 0;
+	ms->mdfree = 0;
+}
+
+/* the bitrate and sampling frequency indices, 0 if either is not supported */
+static u32 __header(header *h,u32 layer,u32 bitrate,u32 samplerate)
+{
+	memset(h,0,sizeof(*h));
+	h->layer = layer;
+	while(h->samplerate<3 && samplerates[h->samplerate]!=samplerate) h->samplerate++;
+	while(h->bitrate<15 && bitrates[layer - 1][h->bitrate]!=bitrate) h->bitrate++;
+	return h->samplerate<3 && h->bitrate>0 && h->bitrate<15;
+}
+
+u32 madstream_frame(madstream *ms,u32 layer,u32 bitrate,u32 samplerate)
+{
+	u32 bytes,slot,per;
+	header h;
+	bitwriter bw;
+
+	if(layer<1 || layer>3) return 0;
+	if(!__header(&h,layer,bitrate,samplerate)) return 0;
+
+	/* of libmad's Layer II allocation tables only B.2a and B.2b are written */
+	per = bitrate/2;
+	if(layer==2 && (per==32 || per==48)) return 0;
+
+	/* ISO/IEC 11172-3 2.4.3.1, padding slots keep the mean bitrate exact */
+	slot = layer==1 ? 4 : 1;
+	bytes = (layer==1 ? 12 : 144)*bitrate*1000/samplerate*slot;
+	ms->rest += (layer==1 ? 12 : 144)*bitrate*1000%samplerate;
+	if(ms->rest>=samplerate) {
+		ms->rest -= samplerate;
+		h.padding = 1;
+		bytes += slot;
+	}
+	if(ms->len + bytes + MADSTREAM_GUARD>ms->size) return 0;
+
+	bw.buf = ms->buf + ms->len;
+	bw.pos = 0;
+	switch(layer) {
+		case 1:
+			__layer1(ms,&bw,&h,bytes*8);
+			ms->mdfree = 0;
+			break;
+		case 2:
+			__layer2(ms,&bw,&h,bytes*8,(per>=56 && per<=80) || samplerate==48000 ? 27 : 30);
+			ms->mdfree = 0;
+			break;
+		case 3:
+			__layer3(ms,&bw,&h,bytes*8);
+			break;
+	}
+
+	ms->len += bytes;
+	return bytes;
+}
+
+u32 madstream_empty(madstream *ms,u32 bitrate,u32 samplerate)
+{
+	u32 bytes;
+	header h;
+	bitwriter bw;
+
+	if(!__header(&h,3,bitrate,samplerate)) return 0;
+
+	bytes = 144*bitrate*1000/samplerate;
+	if(ms->len + bytes + MADSTREAM_GUARD>ms->size) return 0;
+
+	/* zero side information: no main data, no reservoir, every granule silent */
+	bw.buf = ms->buf + ms->len;
+	bw.pos = 0;
+	putheader(&bw,&h);
+
+	ms->mdfree = 0;
+	ms->len += bytes;
+	return bytes;
+}
@@ -0,0 +1,73 @@
+/*-------------------------------------------------------------
+
+madstream.h -- synthetic MPEG-1 audio streams for the libmad tests
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __MADSTREAM_H__
+#define __MADSTREAM_H__
+
+#include <gctypes.h>
+
+#define MADSTREAM_GUARD			8				// MAD_BUFFER_GUARD
+#define MADSTREAM_RESERVOIR		511				// largest main_data_begin
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+typedef struct _madstream {
+	u8 *buf;
+	u32 size;
+	u32 len;
+	u32 seed;
+	u32 rest;					// bitrate*144 remainder that decides the padding
+	u32 reservoir;				// Layer III main data may begin in the frames before
+	u32 mdfree;					// main data bytes left unused at the end of the stream
+	u32 mdoffset[MADSTREAM_RESERVOIR];
+} madstream;
+
+/*
+ * The frames are 48, 44.1 or 32 kHz stereo and joint stereo. Their content
+ * comes from a seeded generator: random bit allocations and scalefactors for
+ * Layers I and II, and for Layer III every block type, mixed blocks, MS and
+ * intensity stereo, preflag and scalefac_scale, with spectra coded in
+ * Huffman table 1 and count1 table B. Every frame is valid and carries its
+ * own main data, unless reservoir is set after madstream_init(): then Layer
+ * III main data starts in the bytes the frames before left unused, up to
+ * 511 of them, and may grow past what the frame alone would hold.
+ */
+void madstream_init(madstream *ms,u8 *buf,u32 size,u32 seed);
+
+/* appends a frame at bitrate kbit/s, returns its size or 0 if it does not fit or is not supported */
+u32 madstream_frame(madstream *ms,u32 layer,u32 bitrate,u32 samplerate);
+
+/* appends a Layer III frame of silence, all zeros past the side information, where a Xing or VBRI tag goes */
+u32 madstream_empty(madstream *ms,u32 bitrate,u32 samplerate);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+/*-------------------------------------------------------------
+
+madtest.c -- libmad fixed-point against floating-point decode
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Links libmad twice, as the FPM_64BIT fixed-point build and as the
+ * FPM_FLOAT build, decodes the same streams with both and holds the
+ * difference to the ISO/IEC 11172-4 bounds for a full accuracy decoder:
+ * an RMS error under 2^-15/sqrt(12) and no sample off by more than 2^-14,
+ * full scale being +-1.0. The fixed-point build stands in for the reference
+ * decoder.
+ *
+ * The streams come from madstream.c, 48 kHz at the highest bitrate of each
+ * layer. They are valid, so neither decoder may reject a frame.
+ *
+ *   madtest				run the checks
+ *   madtest -b				also time both decoders
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <gctypes.h>
+#include "madstream.h"
+#include "maddecode.h"
+
+#define FRAMES					64
+#define MAX_FRAME_BYTES			1152
+#define MAX_SAMPLES				(FRAMES*1152*2)
+
+#define BENCH_ROUNDS			20
+
+/* ISO/IEC 11172-4 full accuracy */
+#define BOUND_RMS				(1.0/(32768.0*sqrt(12.0)))
+#define BOUND_MAX				(1.0/16384.0)
+
+typedef struct _layer {
+	u32 layer;
+	u32 bitrate;
+	u32 samples;				// per channel and frame
+} layer;
+
+static int bench = 0;
+
+static u8 stream[FRAMES*MAX_FRAME_BYTES + MADSTREAM_GUARD];
+static double fixedout[MAX_SAMPLES];
+static double floatout[MAX_SAMPLES];
+
+/* the highest bitrate of each layer */
+static const layer layers[3] = {
+	{ 1, 384,  384 },
+	{ 2, 384, 1152 },
+	{ 3, 320, 1152 },
+};
+
+static u32 __build(const layer *l)
+{
+	u32 i;
+	madstream ms;
+
+	madstream_init(&ms,stream,sizeof(stream),l->layer);
+	for(i=0;i<FRAMES;i++) {
+		if(!madstream_frame(&ms,l->layer,l->bitrate,48000)) return 0;
+	}
+	return ms.len + MADSTREAM_GUARD;
+}
+
+static int __compare(const layer *l)
+{
+	u32 i,n,len,nfixed,nfloat,efixed,efloat,lsbs;
+	double d,sum,signal,max;
+
+	len = __build(l);
+	if(!len) return 1;
+
+	n = FRAMES*l->samples*2;
+	nfixed = mad_decodefixed(stream,len,fixedout,MAX_SAMPLES,&efixed);
+	nfloat = mad_decodefloat(stream,len,floatout,MAX_SAMPLES,&efloat);
+	if(nfixed!=n || nfloat!=n || efixed || efloat) {
+		printf("%-16s %u/%u samples, %u/%u frames rejected\n","",nfixed,nfloat,efixed,efloat);
+		return 1;
+	}
+
+	sum = signal = max = 0;
+	lsbs = 0;
+	for(i=0;i<n;i++) {
+		d = fabs(floatout[i] - fixedout[i]);
+		sum += d*d;
+		signal += fixedout[i]*fixedout[i];
+		if(d>max) max = d;
+		if(lrint(floatout[i]*32768.0)!=lrint(fixedout[i]*32768.0)) lsbs++;
+	}
+	sum = sqrt(sum/n);
+	signal = sqrt(signal/n);
+
+	printf("%-16s signal %.3e rms, error %.3e rms %.3e max, %u of %u 16-bit samples differ\n","",signal,sum,max,lsbs,n);
+	return signal<1e-3 || sum>=BOUND_RMS || max>BOUND_MAX;
+}
+
+static int __test_layer1(void)
+{
+	return __compare(&layers[0]);
+}
+
+static int __test_layer2(void)
+{
+	return __compare(&layers[1]);
+}
+
+static int __test_layer3(void)
+{
+	return __compare(&layers[2]);
+}
+
+/*---------------------------------------------------------------------------------*/
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static void bench_decode(const char *name,const layer *l,u32 (*decode)(const u8*,u32,double*,u32,u32*))
+{
+	u32 i,errors,len = __build(l);
+	double t = now();
+
+	for(i=0;i<BENCH_ROUNDS;i++) decode(stream,len,fixedout,MAX_SAMPLES,&errors);
+	t = now() - t;
+	printf("%-24s %8.2f us/frame %8.0fx realtime\n",name,t*1e6/(BENCH_ROUNDS*FRAMES),
+		BENCH_ROUNDS*FRAMES*l->samples/48000.0/t);
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "layer I",		__test_layer1 },
+	{ "layer II",		__test_layer2 },
+	{ "layer III",		__test_layer3 },
+};
+
+int main(int argc,char *argv[])
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=1;i<(u32)argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		bench_decode("layer I fixed",&layers[0],mad_decodefixed);
+		bench_decode("layer I float",&layers[0],mad_decodefloat);
+		bench_decode("layer II fixed",&layers[1],mad_decodefixed);
+		bench_decode("layer II float",&layers[1],mad_decodefloat);
+		bench_decode("layer III fixed",&layers[2],mad_decodefixed);
+		bench_decode("layer III float",&layers[2],mad_decodefloat);
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
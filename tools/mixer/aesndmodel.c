@@ -0,0 +1,537 @@
+/*-------------------------------------------------------------
+
+aesndmodel.c -- host reference model of the AESND mixer
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * CPU side: the HW_RVL __aesndhandlerequest/__aesndfillbuffer of aesndlib.c
+ * and the voice walk of __audio_dma_callback/__dsp_requestcallback.
+ *
+ * DSP side: dsp_mixer to finish_voice of libaesnd/dspcode/dspmixer.s and its
+ * exception5 handler, with the accelerator reading the stream buffers:
+ *   - PCM at the unity gains the microcode programs (0x100 for 8 bit, 0x800
+ *     for 16 bit), so a read returns the stored sample;
+ *   - ADPCM with the frame header fetched before the nibble is decoded, as
+ *     the Dolphin accelerator does;
+ *   - the end address compares for equality, after which the current address
+ *     reloads from the start address and exception5 runs.
+ * A delay longer than a frame leaves the microcode reading an empty loop stack
+ * at exit_delay; the model treats that frame as fully delayed.
+ */
+
+#include <string.h>
+#include "aesndmodel.h"
+#include "../adpcm/dspadpcm.h"
+
+#define VOICE_PAUSE				0x00000008
+#define VOICE_LOOP				0x00000010
+#define VOICE_ONCE				0x00000020
+#define VOICE_STREAM			0x00000040
+#define VOICE_ADPCM				0x00000080
+#define VOICE_LOOPCTX			0x00000100
+#define VOICE_SOURCEEND			0x00000200
+#define VOICE_SOURCESHORT		0x00000400
+#define VOICE_SOURCEDONE		0x00000800
+
+#define VOICE_FINISHED			0x00100000
+#define VOICE_STOPPED			0x00200000
+#define VOICE_RUNNING			0x40000000
+#define VOICE_USED				0x80000000
+
+typedef struct _accel {
+	uint32_t sa,ea,ca;
+	uint16_t pds;
+	dspadpcm_hist hist;
+} accel;
+
+static int16_t __sat16(int32_t val)
+{
+	if(val>32767) return 32767;
+	if(val<-32768) return -32768;
+	return (int16_t)val;
+}
+
+static uint8_t __ringbyte(const aesndmodel *m,uint32_t addr)
+{
+	uint32_t off = addr - AESND_RING_BASE;
+
+	if(addr<AESND_RING_BASE || off>=sizeof(m->stream_buffer)) return 0;
+	return ((const uint8_t*)m->stream_buffer)[off];
+}
+
+static uint32_t __ringaddr(uint32_t voiceno)
+{
+	return AESND_RING_BASE + voiceno*(AESND_STREAMBUFFER_SIZE*2);
+}
+
+/* aesndlib.c */
+
+static void __aesndsetvoiceformat(aesndmodelpb *pb,uint32_t format)
+{
+	if(format==VOICE_MONO_ADPCM) {
+		pb->flags = (pb->flags&~(0x07|VOICE_LOOPCTX))|(VOICE_ADPCM|VOICE_MONO16);
+		pb->shift = 0;
+		return;
+	}
+
+	pb->flags = (pb->flags&~(0x07|VOICE_ADPCM|VOICE_LOOPCTX))|(format&0x07);
+	pb->shift = (format&0x02) ? 1 : 0;
+}
+
+static uint32_t __aesndbufaddr(aesndmodelpb *pb,uint32_t addr)
+{
+	if(pb->flags&VOICE_ADPCM) return (addr<<1);
+	return (addr>>pb->shift);
+}
+
+static uint32_t __aesndbufstart(aesndmodelpb *pb,uint32_t addr)
+{
+	if(pb->flags&VOICE_ADPCM) return (addr<<1) + 2;
+	return (addr>>pb->shift);
+}
+
+static void __aesndsetloopcontext(aesndmodelpb *pb,uint32_t buf_addr,uint32_t buffer)
+{
+	if((pb->flags&(VOICE_ADPCM|VOICE_LOOP|VOICE_STREAM))!=(VOICE_ADPCM|VOICE_LOOP)) return;
+	if(pb->source || pb->mram_curr!=pb->mram_start) return;
+
+	pb->loop_start = __aesndbufstart(pb,buf_addr);
+	pb->loop_end = buffer ? (__aesndbufaddr(pb,buf_addr) - 1) : pb->buf_end;
+	pb->flags |= VOICE_LOOPCTX;
+}
+
+static uint32_t __aesndreadsource(aesndmodelpb *pb,void *buffer,uint32_t len)
+{
+	uint32_t copy_len;
+	int32_t ret;
+
+	if(pb->source) {
+		/* asked again after the end: the DSP is done with the half that holds the last data */
+		if(pb->flags&VOICE_SOURCEEND) {
+			pb->flags |= VOICE_SOURCEDONE;
+			return 0;
+		}
+
+		ret = pb->source(pb,buffer,len,pb->source_arg);
+		if(ret<0) {
+			pb->flags = (pb->flags&~VOICE_SOURCESHORT)|VOICE_SOURCEEND;
+			return 0;
+		}
+
+		/* a short read is an underrun once the source goes on, not when it was the last one */
+		if(pb->flags&VOICE_SOURCESHORT) pb->underruns++;
+		if((uint32_t)ret<len)
+			pb->flags |= VOICE_SOURCESHORT;
+		else
+			pb->flags &= ~VOICE_SOURCESHORT;
+		return (uint32_t)ret;
+	}
+
+	copy_len = (uint32_t)(pb->mram_end - pb->mram_curr);
+	if(copy_len>len) copy_len = len;
+
+	memcpy(buffer,pb->mram_curr,copy_len);
+	pb->mram_curr += copy_len;
+
+	return copy_len;
+}
+
+static int __aesndsourcedone(aesndmodelpb *pb)
+{
+	if(pb->source) return ((pb->flags&VOICE_SOURCEDONE)!=0);
+	return (pb->mram_curr>=pb->mram_end);
+}
+
+static void __aesndsetvoicebuffer(aesndmodelpb *pb,const void *buffer,uint32_t len)
+{
+	pb->mram_start = buffer;
+	pb->mram_curr = buffer;
+	pb->mram_end = (const uint8_t*)buffer + len;
+}
+
+static void __aesndsetvoicefreq(aesndmodelpb *pb,uint32_t freq)
+{
+	uint32_t fact = (uint32_t)(0x00010000u*AESND_DEFAULT_FREQ);
+	uint32_t ratio = (uint32_t)((((uint64_t)freq<<32) + (fact>>1))/fact);
+
+	pb->freq_h = (uint16_t)(ratio>>16);
+	pb->freq_l = (uint16_t)(ratio&0xffff);
+}
+
+static void __aesndfillbuffer(aesndmodelpb *pb,uint32_t buffer)
+{
+	uint8_t *ptr = pb->model->stream_buffer[pb->voiceno];
+	uint32_t buf_addr = __ringaddr(pb->voiceno);
+	uint32_t copy_len;
+
+	if(buffer) {
+		buf_addr += AESND_STREAMBUFFER_SIZE;
+		ptr += AESND_STREAMBUFFER_SIZE;
+	}
+
+	__aesndsetloopcontext(pb,buf_addr,buffer);
+
+	copy_len = __aesndreadsource(pb,ptr,AESND_STREAMBUFFER_SIZE);
+	if(copy_len<AESND_STREAMBUFFER_SIZE) memset(ptr + copy_len,0,AESND_STREAMBUFFER_SIZE - copy_len);
+	if(!buffer && pb->flags&VOICE_ADPCM) pb->ring_pds = ptr[0];
+}
+
+static void __aesndhandlerequest(aesndmodelpb *pb)
+{
+	uint8_t *ptr = pb->model->stream_buffer[pb->voiceno];
+	uint32_t buf_addr;
+	uint32_t copy_len;
+
+	if(__aesndsourcedone(pb)) {
+		if(pb->flags&VOICE_STREAM && pb->cb)
+			pb->cb(pb,VOICE_STATE_STREAM);
+		if(pb->flags&VOICE_ONCE) {
+			pb->buf_start = 0;
+			pb->flags |= VOICE_STOPPED;
+			return;
+		} else if(pb->flags&VOICE_LOOP) pb->mram_curr = pb->mram_start;
+	}
+
+	if(pb->buf_start) {
+		uint32_t curr_pos = pb->buf_curr;
+		if(curr_pos<pb->stream_last)
+			__aesndfillbuffer(pb,1);
+		if(curr_pos>=(pb->buf_start + __aesndbufaddr(pb,AESND_STREAMBUFFER_SIZE)) &&
+		   pb->stream_last<(pb->buf_start + __aesndbufaddr(pb,AESND_STREAMBUFFER_SIZE)))
+			__aesndfillbuffer(pb,0);
+
+		pb->stream_last = curr_pos;
+		return;
+	}
+
+	buf_addr = __ringaddr(pb->voiceno);
+	pb->buf_start = __aesndbufstart(pb,buf_addr);
+	pb->buf_end = __aesndbufaddr(pb,buf_addr + (AESND_STREAMBUFFER_SIZE*2)) - 1;
+	pb->buf_curr = pb->buf_start;
+
+	copy_len = __aesndreadsource(pb,ptr,(AESND_STREAMBUFFER_SIZE*2));
+	if(copy_len<(AESND_STREAMBUFFER_SIZE*2)) memset(ptr + copy_len,0,(AESND_STREAMBUFFER_SIZE*2) - copy_len);
+	if(pb->flags&VOICE_ADPCM) pb->pds = pb->ring_pds = ptr[0];
+
+	pb->flags |= VOICE_RUNNING;
+}
+
+/* dspmixer.s */
+
+static void __exception5(aesndmodelpb *pb,accel *acc)
+{
+	if(!(pb->flags&VOICE_ADPCM)) return;
+
+	if(pb->flags&VOICE_LOOPCTX) {
+		if((acc->sa&0xffff)==(pb->loop_start&0xffff)) {
+			acc->hist.yn1 = (int16_t)pb->loop_yn1;
+			acc->hist.yn2 = (int16_t)pb->loop_yn2;
+			acc->pds = pb->loop_pds;
+			acc->sa = pb->buf_start;
+			acc->ea = pb->buf_end;
+			pb->flags &= ~VOICE_LOOPCTX;
+			return;
+		}
+		acc->sa = pb->loop_start;
+		acc->ea = pb->loop_end;
+	}
+	acc->pds = pb->ring_pds;
+}
+
+static int16_t __accelread(const aesndmodel *m,aesndmodelpb *pb,accel *acc)
+{
+	int16_t val;
+
+	if(pb->flags&VOICE_ADPCM) {
+		uint8_t byte;
+
+		if((acc->ca&15)==0) {
+			acc->pds = __ringbyte(m,acc->ca>>1);
+			acc->ca += 2;
+		}
+		byte = __ringbyte(m,acc->ca>>1);
+		val = dspadpcm_decodenibble(pb->coefs,(uint8_t)acc->pds,(acc->ca&1) ? (byte&0x0f) : (byte>>4),&acc->hist);
+	} else if(pb->shift)
+		val = (int16_t)((__ringbyte(m,acc->ca<<1)<<8)|__ringbyte(m,(acc->ca<<1) + 1));
+	else
+		val = (int16_t)(__ringbyte(m,acc->ca)<<8);
+
+	if(acc->ca==acc->ea) {
+		acc->ca = acc->sa;
+		__exception5(pb,acc);
+	} else
+		acc->ca++;
+
+	return val;
+}
+
+void aesndmodel_mixvoice(const aesndmodel *m,aesndmodelpb *pb,int16_t *out)
+{
+	uint32_t n = AESND_FRAME_SAMPLES;
+	uint32_t o = 0;
+	uint32_t delay;
+	int16_t left,right;
+	accel acc;
+
+	if((pb->flags&VOICE_PAUSE) || !(pb->flags&VOICE_RUNNING) || !pb->buf_start) goto finish;
+
+	// setup_accl
+	acc.sa = pb->buf_start;
+	acc.ea = pb->buf_end;
+	acc.ca = pb->buf_curr;
+	acc.pds = pb->pds;
+	acc.hist.yn1 = (int16_t)pb->yn1;
+	acc.hist.yn2 = (int16_t)pb->yn2;
+	if((pb->flags&VOICE_LOOPCTX) && acc.ca<pb->loop_start) {
+		acc.sa = pb->loop_start;
+		acc.ea = pb->loop_end;
+	}
+
+	left = pb->left;
+	right = pb->right;
+
+	delay = pb->delay&0x00ffffff;
+	if(delay) {
+		if(delay<=AESND_FRAME_SAMPLES) {
+			o = delay - 1;
+			n = (AESND_FRAME_SAMPLES + 1) - delay;
+			delay = 0;
+		} else {
+			o = AESND_FRAME_SAMPLES;
+			n = 0;
+			delay -= AESND_FRAME_SAMPLES;
+		}
+		pb->delay = delay;
+	}
+
+	while(n--) {
+		uint32_t counter,k;
+
+		out[o*2 + 0] = __sat16(out[o*2 + 0] + right);
+		out[o*2 + 1] = __sat16(out[o*2 + 1] + left);
+		o++;
+
+		counter = pb->counter + (((uint32_t)pb->freq_h<<16)|pb->freq_l);
+		pb->counter = (uint16_t)(counter&0xffff);
+		k = counter>>16;
+		if(k>=1) {
+			int16_t s0 = 0,s1 = 0;
+
+			while(k--) {
+				s0 = __accelread(m,pb,&acc);
+				s1 = (pb->flags&1) ? __accelread(m,pb,&acc) : s0;
+			}
+			if(pb->flags&4) {
+				s0 ^= 0x8000;
+				s1 ^= 0x8000;
+			}
+			left = __sat16(((int32_t)s0*(int16_t)pb->volume_l)>>8);
+			right = __sat16(((int32_t)s1*(int16_t)pb->volume_r)>>8);
+		}
+	}
+
+	pb->left = left;
+	pb->right = right;
+
+	// mixer_end
+	pb->pds = acc.pds;
+	pb->yn2 = (uint16_t)acc.hist.yn2;
+	pb->yn1 = (uint16_t)acc.hist.yn1;
+	pb->buf_curr = acc.ca;
+
+finish:
+	pb->flags |= VOICE_FINISHED;
+}
+
+/* CPU side */
+
+static int __voiceready(const aesndmodelpb *pb)
+{
+	return (pb->flags&VOICE_USED) && !(pb->flags&VOICE_STOPPED);
+}
+
+void aesndmodel_tick(aesndmodel *m)
+{
+	uint32_t curr = 0;
+
+	memset(m->out,0,sizeof(m->out));
+	m->voices = 0;
+
+	while(1) {
+		while(curr<AESND_MAX_VOICES && !__voiceready(&m->voicepb[curr])) curr++;
+		if(curr>=AESND_MAX_VOICES) break;
+
+		m->command = m->voicepb[curr];
+		if(m->command.cb) m->command.cb(&m->command,VOICE_STATE_RUNNING);
+
+		aesndmodel_mixvoice(m,&m->command,m->out);
+		m->voices++;
+
+		m->command.flags &= ~VOICE_FINISHED;
+		__aesndhandlerequest(&m->command);
+
+		if(m->command.flags&VOICE_STOPPED && m->command.cb) m->command.cb(&m->command,VOICE_STATE_STOPPED);
+
+		if(m->voicepb[curr].flags&VOICE_USED) m->voicepb[curr] = m->command;
+		curr++;
+	}
+}
+
+/* voice API */
+
+void aesndmodel_init(aesndmodel *m)
+{
+	memset(m,0,sizeof(*m));
+}
+
+aesndmodelpb* aesndmodel_allocatevoice(aesndmodel *m,aesndmodel_voicecb cb)
+{
+	aesndmodelpb *pb;
+	uint32_t i;
+
+	for(i=0;i<AESND_MAX_VOICES;i++) {
+		if(!(m->voicepb[i].flags&VOICE_USED)) {
+			pb = &m->voicepb[i];
+			pb->model = m;
+			pb->voiceno = i;
+			pb->flags = (VOICE_USED|VOICE_STOPPED);
+			pb->pds = pb->yn1 = pb->yn2 = 0;
+			pb->buf_start = 0;
+			pb->buf_curr = 0;
+			pb->buf_end = 0;
+			pb->counter = 0;
+			pb->volume_l = 0x0100;
+			pb->volume_r = 0x0100;
+			pb->freq_h = 0x0001;
+			pb->freq_l = 0x0000;
+			pb->cb = cb;
+			return pb;
+		}
+	}
+	return NULL;
+}
+
+void aesndmodel_freevoice(aesndmodelpb *pb)
+{
+	aesndmodel *m;
+
+	if(pb==NULL) return;
+
+	m = pb->model;
+	memset(pb,0,sizeof(*pb));
+	pb->model = m;
+}
+
+void aesndmodel_playvoice(aesndmodelpb *pb,uint32_t format,const void *buffer,uint32_t len,uint32_t freq,uint32_t delay,int looped)
+{
+	__aesndsetvoiceformat(pb,format);
+	__aesndsetvoicefreq(pb,freq);
+	__aesndsetvoicebuffer(pb,buffer,len);
+
+	pb->flags &= ~(VOICE_RUNNING|VOICE_STOPPED|VOICE_LOOP|VOICE_ONCE|VOICE_LOOPCTX|VOICE_SOURCEEND|VOICE_SOURCESHORT|VOICE_SOURCEDONE);
+	if(looped)
+		pb->flags |= VOICE_LOOP;
+	else
+		pb->flags |= VOICE_ONCE;
+
+	pb->buf_start = pb->buf_curr = pb->buf_end = pb->stream_last = 0;
+	pb->delay = (delay*48);
+	pb->pds = pb->yn1 = pb->yn2 = pb->ring_pds = 0;
+	pb->counter = 0;
+}
+
+void aesndmodel_setvoicebuffer(aesndmodelpb *pb,const void *buffer,uint32_t len)
+{
+	__aesndsetvoicebuffer(pb,buffer,len);
+}
+
+void aesndmodel_setvoicesource(aesndmodelpb *pb,aesndmodel_sourcecb source,void *cb_arg)
+{
+	pb->source = source;
+	pb->source_arg = cb_arg;
+	pb->underruns = 0;
+	pb->flags &= ~(VOICE_SOURCEEND|VOICE_SOURCESHORT|VOICE_SOURCEDONE);
+}
+
+void aesndmodel_setvoiceformat(aesndmodelpb *pb,uint32_t format)
+{
+	__aesndsetvoiceformat(pb,format);
+}
+
+void aesndmodel_setvoiceadpcm(aesndmodelpb *pb,const int16_t *coefs,uint16_t loop_ps,int16_t loop_yn1,int16_t loop_yn2)
+{
+	memcpy(pb->coefs,coefs,sizeof(pb->coefs));
+	pb->loop_pds = loop_ps;
+	pb->loop_yn1 = (uint16_t)loop_yn1;
+	pb->loop_yn2 = (uint16_t)loop_yn2;
+}
+
+void aesndmodel_setvoicevolume(aesndmodelpb *pb,uint16_t volume_l,uint16_t volume_r)
+{
+	pb->volume_l = volume_l;
+	pb->volume_r = volume_r;
+}
+
+void aesndmodel_setvoicefrequency(aesndmodelpb *pb,uint32_t freq)
+{
+	__aesndsetvoicefreq(pb,freq);
+}
+
+void aesndmodel_setvoicestream(aesndmodelpb *pb,int stream)
+{
+	if(stream)
+		pb->flags |= VOICE_STREAM;
+	else
+		pb->flags &= ~VOICE_STREAM;
+}
+
+void aesndmodel_setvoiceloop(aesndmodelpb *pb,int loop)
+{
+	if(loop)
+		pb->flags |= VOICE_LOOP;
+	else
+		pb->flags &= ~VOICE_LOOP;
+}
+
+void aesndmodel_setvoicemute(aesndmodelpb *pb,int mute)
+{
+	if(mute)
+		pb->flags |= VOICE_PAUSE;
+	else
+		pb->flags &= ~VOICE_PAUSE;
+}
+
+void aesndmodel_setvoicestop(aesndmodelpb *pb,int stop)
+{
+	if(stop)
+		pb->flags |= VOICE_STOPPED;
+	else
+		pb->flags &= ~VOICE_STOPPED;
+}
+
+void aesndmodel_setvoicedelay(aesndmodelpb *pb,uint32_t delay)
+{
+	pb->delay = (delay*48);
+}
@@ -0,0 +1,150 @@
+/*-------------------------------------------------------------
+
+aesndmodel.h -- host reference model of the AESND mixer
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __AESNDMODEL_H__
+#define __AESNDMODEL_H__
+
+#include <stdint.h>
+
+#define AESND_MAX_VOICES		32				// MAX_VOICES
+#define AESND_FRAME_SAMPLES		96				// stereo samples mixed per tick (SND_BUFFERSIZE/4)
+#define AESND_STREAMBUFFER_SIZE	1152			// DSP_STREAMBUFFER_SIZE
+#define AESND_DEFAULT_FREQ		48000			// the Wii build: DSP_DEFAULT_FREQ
+
+#define AESND_RING_BASE			0x00100000		// physical address of the model's stream_buffer[0]
+
+#define VOICE_STATE_STOPPED		0
+#define VOICE_STATE_RUNNING		1
+#define VOICE_STATE_STREAM		2
+
+#define VOICE_MONO8				0x00000000
+#define VOICE_STEREO8			0x00000001
+#define VOICE_MONO16			0x00000002
+#define VOICE_STEREO16			0x00000003
+#define VOICE_MONO8_UNSIGNED	0x00000004
+#define VOICE_STEREO8_UNSIGNED	0x00000005
+#define VOICE_MONO16_UNSIGNED	0x00000006
+#define VOICE_STEREO16_UNSIGNED	0x00000007
+#define VOICE_MONO_ADPCM		0x00000008
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+typedef struct _aesndmodel aesndmodel;
+typedef struct _aesndmodelpb aesndmodelpb;
+
+typedef void (*aesndmodel_voicecb)(aesndmodelpb *pb,uint32_t state);
+typedef int32_t (*aesndmodel_sourcecb)(aesndmodelpb *pb,void *buffer,uint32_t len,void *cb_arg);
+
+/* mirrors struct aesndpb_t in aesndlib.c; the voice buffer is a host pointer */
+struct _aesndmodelpb {
+	uint32_t buf_start;
+	uint32_t buf_end;
+	uint32_t buf_curr;
+
+	uint16_t yn1;
+	uint16_t yn2;
+	uint16_t pds;
+
+	uint16_t freq_h;
+	uint16_t freq_l;
+	uint16_t counter;
+
+	int16_t left,right;
+	uint16_t volume_l,volume_r;
+
+	uint32_t delay;
+
+	uint32_t flags;
+
+	uint16_t loop_pds;
+	uint16_t loop_yn1;
+	uint16_t loop_yn2;
+	uint16_t ring_pds;
+
+	uint32_t loop_start;
+	uint32_t loop_end;
+
+	int16_t coefs[16];
+
+	const uint8_t *mram_start;
+	const uint8_t *mram_curr;
+	const uint8_t *mram_end;
+	uint32_t stream_last;
+
+	uint32_t voiceno;
+	uint32_t shift;
+	aesndmodel_voicecb cb;
+	void *usr_data;
+
+	aesndmodel_sourcecb source;
+	void *source_arg;
+	uint32_t underruns;
+
+	aesndmodel *model;
+};
+
+struct _aesndmodel {
+	aesndmodelpb voicepb[AESND_MAX_VOICES];
+	aesndmodelpb command;
+
+	uint8_t stream_buffer[AESND_MAX_VOICES][AESND_STREAMBUFFER_SIZE*2];
+	int16_t out[AESND_FRAME_SAMPLES*2];
+
+	uint32_t voices;			// voices handed to the DSP in the last tick
+};
+
+void aesndmodel_init(aesndmodel *m);
+
+/* the voice API, as in aesndlib.c */
+aesndmodelpb* aesndmodel_allocatevoice(aesndmodel *m,aesndmodel_voicecb cb);
+void aesndmodel_freevoice(aesndmodelpb *pb);
+void aesndmodel_playvoice(aesndmodelpb *pb,uint32_t format,const void *buffer,uint32_t len,uint32_t freq,uint32_t delay,int looped);
+void aesndmodel_setvoicebuffer(aesndmodelpb *pb,const void *buffer,uint32_t len);
+void aesndmodel_setvoicesource(aesndmodelpb *pb,aesndmodel_sourcecb source,void *cb_arg);
+void aesndmodel_setvoiceformat(aesndmodelpb *pb,uint32_t format);
+void aesndmodel_setvoiceadpcm(aesndmodelpb *pb,const int16_t *coefs,uint16_t loop_ps,int16_t loop_yn1,int16_t loop_yn2);
+void aesndmodel_setvoicevolume(aesndmodelpb *pb,uint16_t volume_l,uint16_t volume_r);
+void aesndmodel_setvoicefrequency(aesndmodelpb *pb,uint32_t freq);
+void aesndmodel_setvoicestream(aesndmodelpb *pb,int stream);
+void aesndmodel_setvoiceloop(aesndmodelpb *pb,int loop);
+void aesndmodel_setvoicemute(aesndmodelpb *pb,int mute);
+void aesndmodel_setvoicestop(aesndmodelpb *pb,int stop);
+void aesndmodel_setvoicedelay(aesndmodelpb *pb,uint32_t delay);
+
+/* one audio DMA tick: the CPU side voice requests and the DSP mix of every running voice into m->out */
+void aesndmodel_tick(aesndmodel *m);
+
+/* the DSP part alone: mixes one parameter block for a frame into out, as dsp_mixer does */
+void aesndmodel_mixvoice(const aesndmodel *m,aesndmodelpb *pb,int16_t *out);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
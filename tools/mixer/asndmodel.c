@@ -0,0 +1,581 @@
+/*-------------------------------------------------------------
+
+asndmodel.c -- host reference model of the ASND mixer
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * CPU side: audio_dma_callback() and __dsp_requestcallback() of asndlib.c,
+ * reduced to the per voice handoff of sound_data[] to sound_data_dma.
+ *
+ * DSP side: start_main to end_main of libasnd/dsp_mixer/dsp_mixer.s, one
+ * slice of one voice. The 32 byte sample cache at MEM_SAMP is modelled too,
+ * since it is only refetched on block boundaries. Flag results follow the
+ * Dolphin DSP interpreter: the counter advances while it is > 48000 on the
+ * fast path, and >= 48000 inside the slow (pitch > 48000) loop.
+ */
+
+#include <string.h>
+#include "asndmodel.h"
+
+#define VOICE_UPDATEADD		(1<<12)
+#define VOICE_UPDATE		(1<<11)
+#define VOICE_VOLUPDATE		(1<<10)
+#define VOICE_PAUSE			(1<<9)
+#define VOICE_SETLOOP		(1<<8)
+
+#define DSP_RATE			48000
+
+typedef struct _dspstate {
+	const asndmodel *m;
+	asndvoice *sd;
+	uint16_t cache[32];		// MEM_SAMP, only the first 16 words are ever fetched
+	uint32_t addr;			// IX2:IX3
+	uint32_t end;			// R0A:R0B
+	uint16_t vol_l,vol_r;	// IX0,IX1
+} dspstate;
+
+static uint16_t __memword(const asndmodel *m,uint32_t addr)
+{
+	uint32_t off = (addr&~1) - m->mem_base;
+
+	if(addr<m->mem_base || off + 1>=m->mem_size) return 0;
+	return (uint16_t)((m->mem[off]<<8)|m->mem[off + 1]);
+}
+
+static int16_t __sat16(int32_t val)
+{
+	if(val>32767) return 32767;
+	if(val<-32768) return -32768;
+	return (int16_t)val;
+}
+
+static uint16_t __bswap16(uint16_t val)
+{
+	return (uint16_t)((val<<8)|(val>>8));
+}
+
+static void __fetch(dspstate *st,uint32_t addr)
+{
+	uint32_t i;
+
+	for(i=0;i<16;i++) st->cache[i] = __memword(st->m,(addr&~31) + i*2);
+}
+
+// change_buffer: switches to the second buffer, which is kept for a loop
+static void __changebuffer(dspstate *st)
+{
+	asndvoice *sd = st->sd;
+
+	sd->volume_l = sd->volume2_l;
+	sd->volume_r = sd->volume2_r;
+	st->vol_l = sd->volume_l;
+	st->vol_r = sd->volume_r;
+
+	sd->end_addr = sd->end_addr2;
+	st->end = sd->end_addr;
+
+	sd->backup_addr = sd->start_addr = sd->start_addr2;
+	st->addr = sd->start_addr;
+
+	if(sd->flags&VOICE_SETLOOP) return;
+
+	sd->start_addr2 = 0;
+	sd->end_addr2 = 0;
+}
+
+// jump_load_smp_addr and the sample_selector routines, then out_samp
+static void __loadsample(dspstate *st,int16_t *ax0,int16_t *ax1)
+{
+	uint32_t idx = (st->addr>>1)&0x0f;
+	uint16_t w0,w1,b;
+	int16_t s0,s1;
+
+	if(idx==0) __fetch(st,st->addr);
+
+	w0 = st->cache[idx];
+	w1 = st->cache[idx + 1];
+
+	switch(st->sd->flags&7) {
+		case 0:		// mono 8 bits
+			b = (st->addr&1) ? (w0&0xff) : (w0>>8);
+			s0 = s1 = (int16_t)(b<<8);
+			break;
+		case 1:		// mono 16 bits
+			s0 = s1 = (int16_t)w0;
+			break;
+		case 2:		// stereo 8 bits
+			s0 = (int16_t)(w0&0xff00);
+			s1 = (int16_t)((w0&0xff)<<8);
+			break;
+		case 3:		// stereo 16 bits
+			s0 = (int16_t)w0;
+			s1 = (int16_t)w1;
+			break;
+		case 4:		// mono 8 bits unsigned
+			b = (st->addr&1) ? (w0&0xff) : (w0>>8);
+			s0 = s1 = (int16_t)((b<<8)^0x8000);
+			break;
+		case 5:		// mono 16 bits little-endian
+			s0 = s1 = (int16_t)__bswap16(w0);
+			break;
+		case 6:		// stereo 8 bits unsigned
+			w0 ^= 0x8080;
+			s0 = (int16_t)(w0&0xff00);
+			s1 = (int16_t)((w0&0xff)<<8);
+			break;
+		default:	// stereo 16 bits little-endian
+			s0 = (int16_t)__bswap16(w0);
+			s1 = (int16_t)__bswap16(w1);
+			break;
+	}
+
+	*ax0 = (int16_t)(((int32_t)s0*(int16_t)st->vol_l)>>8);
+	*ax1 = (int16_t)(((int32_t)s1*(int16_t)st->vol_r)>>8);
+}
+
+// get_new_buffer
+static void __newbuffer(dspstate *st,int16_t *ax0,int16_t *ax1)
+{
+	__changebuffer(st);
+	if(!st->addr) {
+		*ax0 = *ax1 = 0;
+		return;
+	}
+	__fetch(st,st->addr);
+	__loadsample(st,ax0,ax1);
+}
+
+void asndmodel_mixvoice(const asndmodel *m,asndvoice *sd,int16_t *out)
+{
+	dspstate st;
+	uint32_t step = sd->flags>>16;
+	uint32_t n,o = 0;
+	int16_t ax0 = sd->right,ax1 = sd->left;
+	int slow;
+
+	if(sd->flags&VOICE_PAUSE) return;
+
+	memset(&st,0,sizeof(st));
+	st.m = m;
+	st.sd = sd;
+	st.addr = sd->start_addr;
+
+	if(!st.addr) {
+		__changebuffer(&st);
+		if(!st.addr) goto save;
+	}
+	st.end = sd->end_addr;
+
+	n = ASND_SLICE_SAMPLES;
+	if(sd->delay_samples) {
+		uint32_t count = ASND_SLICE_SAMPLES;
+
+		ax0 = ax1 = 0;
+		while(1) {
+			o++;
+			if(--count==0) {
+				sd->delay_samples--;
+				n = 0;
+				break;
+			}
+			if(--sd->delay_samples==0) {
+				// exit_delay2 reloads the sample count from $ACL1 (0), not $ACM1:
+				// the rest of the slice after the delay runs out stays silent
+				n = 0;
+				break;
+			}
+		}
+	}
+
+	__fetch(&st,st.addr);
+	st.vol_l = sd->volume_l;
+	st.vol_r = sd->volume_r;
+	slow = (sd->freq>DSP_RATE);
+
+	while(n--) {
+		uint32_t counter;
+
+		out[o*2 + 0] = __sat16(out[o*2 + 0] + ax1);
+		out[o*2 + 1] = __sat16(out[o*2 + 1] + ax0);
+		o++;
+
+		counter = sd->counter + sd->freq;
+		if(counter<=DSP_RATE) {
+			sd->counter = counter;
+			continue;
+		}
+
+		if(!slow) {
+			uint32_t addr;
+
+			sd->counter = counter - DSP_RATE;
+			addr = st.addr + step;
+			if(addr>=st.end) {
+				__newbuffer(&st,&ax0,&ax1);
+				continue;
+			}
+			st.addr = addr;
+		} else {
+			do {
+				counter -= DSP_RATE;
+				st.addr += step;
+				if(!(st.addr&0x1f)) __fetch(&st,st.addr);
+			} while(counter>=DSP_RATE);
+			sd->counter = counter;
+
+			if(st.addr>=st.end) {
+				__newbuffer(&st,&ax0,&ax1);
+				continue;
+			}
+		}
+		__loadsample(&st,&ax0,&ax1);
+	}
+
+	if(!st.addr) __changebuffer(&st);
+
+save:
+	sd->start_addr = st.addr;
+	sd->right = ax0;
+	sd->left = ax1;
+}
+
+/* CPU side */
+
+static int __active(const asndvoice *sd)
+{
+	return (sd->flags>>16)!=0;
+}
+
+static void __dropunused(asndvoice *sd)
+{
+	if(!sd->cb && (!sd->start_addr && !sd->start_addr2)) sd->flags = 0;
+}
+
+// audio_dma_callback(): voice 0 is prepared in place before the DSP gets it
+static void __preparefirst(asndmodel *m)
+{
+	asndvoice *sd = &m->voice[0];
+
+	if(!sd->start_addr2 && __active(sd) && sd->cb) sd->cb(m,0);
+
+	if(sd->flags&VOICE_VOLUPDATE) sd->flags &= ~VOICE_VOLUPDATE;
+
+	if(sd->flags&VOICE_UPDATE)
+		sd->flags &= ~(VOICE_UPDATE|VOICE_VOLUPDATE|VOICE_PAUSE|VOICE_UPDATEADD);
+	else {
+		if(sd->start_addr>=sd->end_addr) {
+			sd->backup_addr = sd->start_addr = sd->start_addr2;
+			sd->start_addr2 = 0;
+			sd->end_addr = sd->end_addr2;
+			sd->end_addr2 = 0;
+			sd->volume_l = sd->volume2_l;
+			sd->volume_r = sd->volume2_r;
+		}
+
+		if(sd->start_addr2 && (sd->flags&VOICE_UPDATEADD)) {
+			sd->flags &= ~VOICE_UPDATEADD;
+
+			if(!sd->start_addr) {
+				sd->backup_addr = sd->start_addr = sd->start_addr2;
+				sd->end_addr = sd->end_addr2;
+				if(!(sd->flags&VOICE_SETLOOP)) {
+					sd->start_addr2 = 0;
+					sd->end_addr2 = 0;
+				}
+				sd->volume_l = sd->volume2_l;
+				sd->volume_r = sd->volume2_r;
+			}
+		}
+	}
+	__dropunused(sd);
+}
+
+// the "callback strategy for next channel" blocks: run while the DSP mixes chan
+static void __preparenext(asndmodel *m,int32_t chan,int first)
+{
+	int32_t n = chan + 1;
+	asndvoice *sd;
+
+	while(n<ASND_MAX_VOICES && !__active(&m->voice[n])) n++;
+	if(n>=ASND_MAX_VOICES) return;
+
+	sd = &m->voice[n];
+	if(!sd->start_addr2 && __active(sd) && sd->cb) sd->cb(m,n);
+
+	if(first) {
+		if(sd->flags&(VOICE_VOLUPDATE|VOICE_UPDATEADD))
+			sd->flags &= ~(VOICE_VOLUPDATE|VOICE_UPDATEADD);
+	} else {
+		if(m->voice[chan].flags&VOICE_VOLUPDATE)
+			m->voice[chan].flags &= ~VOICE_VOLUPDATE;
+	}
+
+	if(sd->flags&VOICE_UPDATE)
+		sd->flags &= ~(VOICE_UPDATE|VOICE_VOLUPDATE|VOICE_PAUSE|VOICE_UPDATEADD);
+
+	__dropunused(sd);
+}
+
+// __dsp_requestcallback(): merges the channel data the DSP sent back
+static void __writeback(asndmodel *m,int32_t chan,asndvoice *dma)
+{
+	asndvoice *sd = &m->voice[chan];
+
+	dma->freq = sd->freq;
+	dma->cb = sd->cb;
+	if(sd->flags&VOICE_UPDATE) {
+		sd->flags &= ~(VOICE_UPDATE|VOICE_VOLUPDATE|VOICE_PAUSE|VOICE_UPDATEADD);
+		*dma = *sd;
+	} else {
+		if(sd->flags&VOICE_VOLUPDATE) {
+			sd->flags &= ~VOICE_VOLUPDATE;
+			dma->volume_l = dma->volume2_l = sd->volume2_l;
+			dma->volume_r = dma->volume2_r = sd->volume2_r;
+		}
+
+		if(dma->start_addr>=dma->end_addr || !dma->start_addr) {
+			dma->backup_addr = dma->start_addr = dma->start_addr2;
+			dma->end_addr = dma->end_addr2;
+			if(!(sd->flags&VOICE_SETLOOP)) {
+				dma->start_addr2 = 0;
+				dma->end_addr2 = 0;
+			}
+			dma->volume_l = dma->volume2_l;
+			dma->volume_r = dma->volume2_r;
+		}
+
+		if(sd->start_addr2 && (sd->flags&VOICE_UPDATEADD)) {
+			sd->flags &= ~VOICE_UPDATEADD;
+			if(!sd->start_addr || !dma->start_addr) {
+				dma->backup_addr = dma->start_addr = sd->start_addr2;
+				dma->end_addr = sd->end_addr2;
+				dma->start_addr2 = sd->start_addr2;
+				dma->end_addr2 = sd->end_addr2;
+				if(!(sd->flags&VOICE_SETLOOP)) {
+					dma->start_addr2 = 0;
+					dma->end_addr2 = 0;
+				}
+				dma->volume_l = sd->volume2_l;
+				dma->volume_r = sd->volume2_r;
+			} else {
+				dma->start_addr2 = sd->start_addr2;
+				dma->end_addr2 = sd->end_addr2;
+				dma->volume2_l = sd->volume2_l;
+				dma->volume2_r = sd->volume2_r;
+			}
+		}
+
+		if(!sd->cb && (!dma->start_addr && !dma->start_addr2)) sd->flags = 0;
+		dma->flags = sd->flags&~(VOICE_UPDATE|VOICE_VOLUPDATE|VOICE_UPDATEADD);
+		*sd = *dma;
+	}
+
+	if(__active(sd)) {
+		if(!sd->delay_samples && !(sd->flags&VOICE_PAUSE) && (dma->start_addr || dma->start_addr2)) sd->tick_counter++;
+	}
+}
+
+void asndmodel_tick(asndmodel *m)
+{
+	asndvoice dma;
+	int32_t chan = 0;
+
+	// 0x111: the first voice clears the mix buffer
+	memset(m->out,0,sizeof(m->out));
+
+	__preparefirst(m);
+	dma = m->voice[0];
+	asndmodel_mixvoice(m,&dma,m->out);
+	__preparenext(m,0,1);
+
+	while(1) {
+		__writeback(m,chan,&dma);
+
+		chan++;
+		if(chan<ASND_MAX_VOICES) __dropunused(&m->voice[chan]);
+		while(chan<ASND_MAX_VOICES && !__active(&m->voice[chan])) chan++;
+		if(chan>=ASND_MAX_VOICES) break;
+
+		dma = m->voice[chan];
+		asndmodel_mixvoice(m,&dma,m->out);
+		__preparenext(m,chan,0);
+	}
+}
+
+/* voice API */
+
+void asndmodel_init(asndmodel *m,const uint8_t *mem,uint32_t mem_base,uint32_t mem_size)
+{
+	memset(m,0,sizeof(*m));
+	m->mem = mem;
+	m->mem_base = mem_base;
+	m->mem_size = mem_size;
+}
+
+static int32_t __clamp(int32_t val,int32_t min,int32_t max)
+{
+	if(val<min) return min;
+	if(val>max) return max;
+	return val;
+}
+
+static uint32_t __formatflags(int32_t format)
+{
+	uint32_t flag_h = 0;
+
+	format &= 7;
+	switch(format&3) {
+		case 0:
+			flag_h = 1<<16;
+			break;
+		case 1:
+		case 2:
+			flag_h = 2<<16;
+			break;
+		case 3:
+			flag_h = 4<<16;
+			break;
+	}
+	return (uint32_t)format|flag_h;
+}
+
+static int32_t __setvoice(asndmodel *m,int32_t voice,int32_t format,int32_t pitch,int32_t delay,uint32_t snd,int32_t size_snd,int32_t volume_l,int32_t volume_r,asndmodel_cb cb,int loop)
+{
+	asndvoice *sd;
+
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+	if(size_snd<=0 || !snd) return ASND_INVALID;
+
+	pitch = __clamp(pitch,ASND_MIN_PITCH,ASND_MAX_PITCH);
+	volume_l = __clamp(volume_l,ASND_MIN_VOLUME,ASND_MAX_VOLUME);
+	volume_r = __clamp(volume_r,ASND_MIN_VOLUME,ASND_MAX_VOLUME);
+
+	sd = &m->voice[voice];
+	sd->left = 0;
+	sd->right = 0;
+	sd->counter = 0;
+
+	sd->freq = (uint32_t)pitch;
+	sd->delay_samples = (uint32_t)(48000LL*(uint64_t)delay/1000LL);
+
+	sd->volume_l = sd->volume2_l = (uint16_t)volume_l;
+	sd->volume_r = sd->volume2_r = (uint16_t)volume_r;
+
+	sd->backup_addr = sd->start_addr = snd;
+	sd->end_addr = snd + (uint32_t)size_snd;
+
+	if(loop) {
+		sd->start_addr2 = sd->start_addr;
+		sd->end_addr2 = sd->end_addr;
+	} else {
+		sd->start_addr2 = 0;
+		sd->end_addr2 = 0;
+	}
+
+	sd->flags = __formatflags(format)|VOICE_UPDATE|(loop ? VOICE_SETLOOP : 0);
+	sd->tick_counter = 0;
+	sd->cb = loop ? NULL : cb;
+
+	return ASND_OK;
+}
+
+int32_t asndmodel_setvoice(asndmodel *m,int32_t voice,int32_t format,int32_t pitch,int32_t delay,uint32_t snd,int32_t size_snd,int32_t volume_l,int32_t volume_r,asndmodel_cb cb)
+{
+	return __setvoice(m,voice,format,pitch,delay,snd,size_snd,volume_l,volume_r,cb,0);
+}
+
+int32_t asndmodel_setinfinitevoice(asndmodel *m,int32_t voice,int32_t format,int32_t pitch,int32_t delay,uint32_t snd,int32_t size_snd,int32_t volume_l,int32_t volume_r)
+{
+	return __setvoice(m,voice,format,pitch,delay,snd,size_snd,volume_l,volume_r,NULL,1);
+}
+
+int32_t asndmodel_addvoice(asndmodel *m,int32_t voice,uint32_t snd,int32_t size_snd)
+{
+	asndvoice *sd;
+
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+	if(size_snd<=0 || !snd) return ASND_INVALID;
+
+	sd = &m->voice[voice];
+	if((sd->flags&(VOICE_UPDATE|VOICE_UPDATEADD)) || !__active(sd)) return ASND_INVALID;
+	if(sd->start_addr2) return ASND_BUSY;
+
+	sd->start_addr2 = snd;
+	sd->end_addr2 = snd + (uint32_t)size_snd;
+	sd->flags &= ~VOICE_SETLOOP;
+	sd->flags |= VOICE_UPDATEADD;
+
+	return ASND_OK;
+}
+
+int32_t asndmodel_stopvoice(asndmodel *m,int32_t voice)
+{
+	asndvoice *sd;
+
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+
+	sd = &m->voice[voice];
+	sd->backup_addr = sd->start_addr = sd->start_addr2 = 0;
+	sd->end_addr = sd->end_addr2 = 0;
+	sd->flags = 0;
+
+	return ASND_OK;
+}
+
+int32_t asndmodel_pausevoice(asndmodel *m,int32_t voice,int32_t pause)
+{
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+
+	if(pause) m->voice[voice].flags |= VOICE_PAUSE;
+	else m->voice[voice].flags &= ~VOICE_PAUSE;
+
+	return ASND_OK;
+}
+
+int32_t asndmodel_changepitchvoice(asndmodel *m,int32_t voice,int32_t pitch)
+{
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+
+	m->voice[voice].freq = (uint32_t)__clamp(pitch,ASND_MIN_PITCH,ASND_MAX_PITCH);
+
+	return ASND_OK;
+}
+
+int32_t asndmodel_changevolumevoice(asndmodel *m,int32_t voice,int32_t volume_l,int32_t volume_r)
+{
+	asndvoice *sd;
+
+	if(voice<0 || voice>=ASND_MAX_VOICES) return ASND_INVALID;
+
+	volume_l = __clamp(volume_l,ASND_MIN_VOLUME,ASND_MAX_VOLUME);
+	volume_r = __clamp(volume_r,ASND_MIN_VOLUME,ASND_MAX_VOLUME);
+
+	sd = &m->voice[voice];
+	sd->flags |= VOICE_VOLUPDATE;
+	sd->volume_l = sd->volume2_l = (uint16_t)volume_l;
+	sd->volume_r = sd->volume2_r = (uint16_t)volume_r;
+
+	return ASND_OK;
+}
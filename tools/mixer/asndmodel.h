@@ -0,0 +1,113 @@
+/*-------------------------------------------------------------
+
+asndmodel.h -- host reference model of the ASND mixer
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+#ifndef __ASNDMODEL_H__
+#define __ASNDMODEL_H__
+
+#include <stdint.h>
+
+#define ASND_MAX_VOICES			16
+#define ASND_SLICE_SAMPLES		1024			// stereo samples mixed per tick (SND_BUFFERSIZE/4)
+
+#define ASND_MIN_PITCH			1
+#define ASND_MAX_PITCH			144000
+#define ASND_MIN_VOLUME			0
+#define ASND_MAX_VOLUME			256
+
+#define ASND_OK					0
+#define ASND_INVALID			-1
+#define ASND_BUSY				1
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+typedef struct _asndmodel asndmodel;
+typedef void (*asndmodel_cb)(asndmodel *m,int32_t voice);
+
+/* mirrors t_sound_data in asndlib.c, minus the output buffer pointer */
+typedef struct _asndvoice {
+	uint32_t delay_samples;
+	uint32_t flags;
+
+	uint32_t start_addr;
+	uint32_t end_addr;
+
+	uint32_t freq;
+
+	int16_t left,right;
+
+	uint32_t counter;
+
+	uint16_t volume_l,volume_r;
+
+	uint32_t start_addr2;
+	uint32_t end_addr2;
+
+	uint16_t volume2_l,volume2_r;
+
+	uint32_t backup_addr;
+
+	uint32_t tick_counter;
+
+	asndmodel_cb cb;
+} asndvoice;
+
+/* sample memory is a host buffer seen by the DSP at physical address mem_base */
+struct _asndmodel {
+	const uint8_t *mem;
+	uint32_t mem_base;
+	uint32_t mem_size;
+
+	asndvoice voice[ASND_MAX_VOICES];
+	int16_t out[ASND_SLICE_SAMPLES*2];
+
+	void *usr_data;
+};
+
+void asndmodel_init(asndmodel *m,const uint8_t *mem,uint32_t mem_base,uint32_t mem_size);
+
+/* the voice API, as in asndlib.c; snd is a physical address inside the model memory */
+int32_t asndmodel_setvoice(asndmodel *m,int32_t voice,int32_t format,int32_t pitch,int32_t delay,uint32_t snd,int32_t size_snd,int32_t volume_l,int32_t volume_r,asndmodel_cb cb);
+int32_t asndmodel_setinfinitevoice(asndmodel *m,int32_t voice,int32_t format,int32_t pitch,int32_t delay,uint32_t snd,int32_t size_snd,int32_t volume_l,int32_t volume_r);
+int32_t asndmodel_addvoice(asndmodel *m,int32_t voice,uint32_t snd,int32_t size_snd);
+int32_t asndmodel_stopvoice(asndmodel *m,int32_t voice);
+int32_t asndmodel_pausevoice(asndmodel *m,int32_t voice,int32_t pause);
+int32_t asndmodel_changepitchvoice(asndmodel *m,int32_t voice,int32_t pitch);
+int32_t asndmodel_changevolumevoice(asndmodel *m,int32_t voice,int32_t volume_l,int32_t volume_r);
+
+/* one audio DMA tick: the CPU side voice handoff and the DSP mix of every active voice into m->out */
+void asndmodel_tick(asndmodel *m);
+
+/* the DSP part alone: mixes one voice for a slice into out, updating its channel data as the DSP writes it back */
+void asndmodel_mixvoice(const asndmodel *m,asndvoice *sd,int16_t *out);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif
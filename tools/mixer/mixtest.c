@@ -0,0 +1,864 @@
+/*-------------------------------------------------------------
+
+mixtest.c -- scenario and benchmark harness for the mixer models
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Renders scripted voice scenarios through the ASND and AESND models.
+ *
+ *   mixtest				run the scenarios, check them against the golden hashes
+ *   mixtest -u				rewrite the golden hashes from the current models
+ *   mixtest -o <dir>		also write each scenario as raw 48kHz stereo s16le
+ *   mixtest -g <file>		golden hash file (default mixer/golden.txt)
+ *   mixtest -b				time the models against the number of voices
+ *
+ * Every scenario hashes its whole output (FNV-1a 64 over s16le), so a change
+ * to either model or to the ported library code that alters a single output
+ * sample is caught. The raw dumps line up with captures of the same scripts
+ * on hardware or in an emulator, frame for frame.
+ *
+ * A few scenarios are also checked against an exact expectation that does not
+ * depend on the golden file: a single voice at the output rate and unity
+ * volume must reproduce its samples, delayed by the mixer's pipeline.
+ *
+ * The benchmark measures the host models, not the DSP: it shows how the cost
+ * of the reference logic scales with voice count, and gives the CPU side cost
+ * of a tick when the mixer is run in software.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "asndmodel.h"
+#include "aesndmodel.h"
+#include "../adpcm/dspadpcm.h"
+
+#define ASND_MEM_BASE			0x00200000
+#define ASND_MEM_SIZE			(1<<20)
+
+#define MAX_SCENARIOS			32
+
+typedef struct _sink {
+	uint64_t hash;
+	FILE *fp;
+} sink;
+
+typedef struct _scenario {
+	const char *name;
+	int (*run)(sink *s);
+} scenario;
+
+typedef struct _golden {
+	char name[64];
+	uint64_t hash;
+} golden;
+
+static uint8_t asnd_mem[ASND_MEM_SIZE];
+static uint32_t asnd_alloc;
+
+static uint32_t __rand_state;
+
+/* signal generation: integer only, so the hashes do not depend on the host libm */
+
+static void __srand(uint32_t seed)
+{
+	__rand_state = seed;
+}
+
+static uint32_t __rand(void)
+{
+	__rand_state = __rand_state*1103515245 + 12345;
+	return (__rand_state>>16)&0x7fff;
+}
+
+// a triangle of the given period in samples, plus some noise
+static void __gensignal(int16_t *dst,uint32_t samples,uint32_t period,int32_t amplitude,int32_t noise)
+{
+	uint32_t i;
+
+	for(i=0;i<samples;i++) {
+		uint32_t phase = i%period;
+		int32_t tri = (int32_t)((phase*4*(uint32_t)amplitude)/period);
+		int32_t val;
+
+		if(phase<period/4) val = tri;
+		else if(phase<(period*3)/4) val = 2*amplitude - tri;
+		else val = tri - 4*amplitude;
+
+		if(noise) val += (int32_t)(__rand()%(2*noise + 1)) - noise;
+		if(val>32767) val = 32767;
+		if(val<-32768) val = -32768;
+		dst[i] = (int16_t)val;
+	}
+}
+
+// stores samples in one of the eight ASND or AESND PCM layouts
+static uint32_t __storepcm(uint8_t *dst,const int16_t *l,const int16_t *r,uint32_t samples,int stereo,int bits,int is_unsigned,int little)
+{
+	uint32_t i,c,len = 0;
+
+	for(i=0;i<samples;i++) {
+		for(c=0;c<(uint32_t)(stereo ? 2 : 1);c++) {
+			int16_t val = c ? r[i] : l[i];
+
+			if(bits==8) {
+				uint8_t b = (uint8_t)((uint16_t)val>>8);
+				if(is_unsigned) b ^= 0x80;
+				dst[len++] = b;
+			} else {
+				uint16_t w = (uint16_t)val;
+				if(is_unsigned) w ^= 0x8000;
+				if(little) {
+					dst[len++] = (uint8_t)w;
+					dst[len++] = (uint8_t)(w>>8);
+				} else {
+					dst[len++] = (uint8_t)(w>>8);
+					dst[len++] = (uint8_t)w;
+				}
+			}
+		}
+	}
+	return len;
+}
+
+/* output */
+
+static void __sinkwrite(sink *s,const int16_t *pcm,uint32_t count)
+{
+	uint32_t i;
+
+	for(i=0;i<count;i++) {
+		uint8_t b[2] = {(uint8_t)pcm[i],(uint8_t)((uint16_t)pcm[i]>>8)};
+
+		s->hash = (s->hash^b[0])*0x100000001b3ULL;
+		s->hash = (s->hash^b[1])*0x100000001b3ULL;
+		if(s->fp) fwrite(b,1,2,s->fp);
+	}
+}
+
+/* ASND scenarios */
+
+static uint32_t __asndstore(const uint8_t *data,uint32_t len)
+{
+	uint32_t addr = ASND_MEM_BASE + asnd_alloc;
+
+	memcpy(asnd_mem + asnd_alloc,data,len);
+	asnd_alloc = (asnd_alloc + len + 31)&~31;
+	return addr;
+}
+
+static asndmodel* __asndnew(void)
+{
+	asndmodel *m = malloc(sizeof(asndmodel));
+
+	memset(asnd_mem,0,sizeof(asnd_mem));
+	asnd_alloc = 0;
+	asndmodel_init(m,asnd_mem,ASND_MEM_BASE,ASND_MEM_SIZE);
+	return m;
+}
+
+// ASND format number to layout: mono8, mono16, stereo8, stereo16, mono8u, mono16le, stereo8u, stereo16le
+static uint32_t __asndpcm(int format,const int16_t *l,const int16_t *r,uint32_t samples)
+{
+	static uint8_t buf[65536*4];
+	int stereo = (format&2)!=0;
+	int bits = (format&1) ? 16 : 8;
+	int is_unsigned = (format==4 || format==6);
+	int little = (format==5 || format==7);
+
+	return __asndstore(buf,__storepcm(buf,l,r,samples,stereo,bits,is_unsigned,little));
+}
+
+static uint32_t __asndbytes(int format,uint32_t samples)
+{
+	return samples*((format&2) ? 2 : 1)*((format&1) ? 2 : 1);
+}
+
+static int __asnd_unity(sink *s)
+{
+	static int16_t l[8192];
+	asndmodel *m = __asndnew();
+	uint32_t addr,t,i,o = 0;
+	int failed = 0;
+
+	__srand(1);
+	__gensignal(l,8192,301,12000,500);
+	addr = __asndpcm(1,l,l,8192);
+	asndmodel_setvoice(m,0,1,48000,0,addr,8192*2,256,256,NULL);
+
+	for(t=0;t<6;t++) {
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+
+		// the sample at the start address is stepped over before the first read
+		for(i=0;i<ASND_SLICE_SAMPLES;i++,o++) {
+			int16_t expect = (o<2) ? 0 : l[o - 1];
+			if(m->out[i*2]!=expect || m->out[i*2 + 1]!=expect) failed = 1;
+		}
+	}
+	free(m);
+	return failed;
+}
+
+static int __asnd_formats(sink *s)
+{
+	static const int32_t pitch[8] = {8000,11025,22050,32000,44100,48000,96000,144000};
+	static int16_t l[16384],r[16384];
+	asndmodel *m = __asndnew();
+	uint32_t t;
+	int f;
+
+	__srand(2);
+	for(f=0;f<8;f++) {
+		uint32_t samples = 4000 + f*1500;
+		uint32_t addr;
+
+		__gensignal(l,samples,97 + f*31,9000,300);
+		__gensignal(r,samples,211 - f*17,7000,0);
+		addr = __asndpcm(f,l,r,samples);
+		asndmodel_setvoice(m,f,f,pitch[f],0,addr,(int32_t)__asndbytes(f,samples),200 - f*10,60 + f*20,NULL);
+	}
+
+	for(t=0;t<40;t++) {
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+	}
+	free(m);
+	return 0;
+}
+
+static int __asnd_loop(sink *s)
+{
+	static int16_t l[3000],r[3000];
+	asndmodel *m = __asndnew();
+	uint32_t a0,a1,a2,t;
+
+	__srand(3);
+	__gensignal(l,3000,150,10000,0);
+	__gensignal(r,3000,75,10000,200);
+	a0 = __asndpcm(1,l,l,3000);
+	a1 = __asndpcm(3,l,r,1000);
+	a2 = __asndpcm(0,r,r,2999);
+
+	asndmodel_setinfinitevoice(m,0,1,32000,0,a0,3000*2,256,128);
+	asndmodel_setinfinitevoice(m,5,3,44100,0,a1,1000*4,100,255);
+	asndmodel_setinfinitevoice(m,9,0,22050,0,a2,2999,200,200);
+
+	for(t=0;t<36;t++) {
+		switch(t) {
+			case 5: asndmodel_changepitchvoice(m,0,60000); break;
+			case 8: asndmodel_changepitchvoice(m,5,130000); break;
+			case 10: asndmodel_changevolumevoice(m,9,40,256); break;
+			case 15: asndmodel_pausevoice(m,5,1); break;
+			case 18: asndmodel_pausevoice(m,5,0); break;
+			case 22: asndmodel_changepitchvoice(m,0,1000); break;
+			case 25: asndmodel_stopvoice(m,9); break;
+			case 30: asndmodel_changevolumevoice(m,0,300,-5); break;
+		}
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+	}
+	free(m);
+	return 0;
+}
+
+typedef struct _asndstream {
+	uint32_t addr[4];
+	uint32_t len;
+	uint32_t next;
+	uint32_t queued;
+	uint32_t limit;
+} asndstream;
+
+static void __asndstreamcb(asndmodel *m,int32_t voice)
+{
+	asndstream *st = m->usr_data;
+
+	if(st->queued>=st->limit) return;
+	if(asndmodel_addvoice(m,voice,st->addr[st->next],(int32_t)st->len)!=ASND_OK) return;
+
+	st->next = (st->next + 1)&3;
+	st->queued++;
+}
+
+static int __asnd_stream(sink *s)
+{
+	static int16_t l[4096];
+	asndmodel *m = __asndnew();
+	asndstream st;
+	uint32_t i,t;
+
+	__srand(4);
+	memset(&st,0,sizeof(st));
+	for(i=0;i<4;i++) {
+		__gensignal(l,1024,64 + i*40,8000 + i*4000,0);
+		st.addr[i] = __asndpcm(1,l,l,1024);
+	}
+	st.len = 1024*2;
+	st.limit = 30;
+	m->usr_data = &st;
+
+	asndmodel_setvoice(m,3,1,44100,0,st.addr[0],(int32_t)st.len,256,256,__asndstreamcb);
+	asndmodel_setvoice(m,12,1,48000,0,st.addr[2],(int32_t)st.len,64,64,NULL);
+
+	for(t=0;t<40;t++) {
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+	}
+	free(m);
+	return (st.queued==st.limit) ? 0 : 1;
+}
+
+static int __asnd_delay(sink *s)
+{
+	static int16_t l[20000];
+	asndmodel *m = __asndnew();
+	uint32_t addr,t;
+
+	__srand(5);
+	__gensignal(l,20000,480,6000,100);
+	addr = __asndpcm(1,l,l,20000);
+
+	asndmodel_setvoice(m,0,1,48000,5,addr,20000*2,256,256,NULL);
+	asndmodel_setvoice(m,1,1,24000,30,addr,20000*2,128,256,NULL);
+	asndmodel_setinfinitevoice(m,2,1,96000,100,addr,4000*2,256,64);
+
+	for(t=0;t<14;t++) {
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+	}
+	free(m);
+	return 0;
+}
+
+static int __asnd_saturate(sink *s)
+{
+	static int16_t l[2048],r[2048];
+	asndmodel *m = __asndnew();
+	uint32_t addr,t;
+	int32_t v;
+
+	__srand(6);
+	__gensignal(l,2048,128,30000,0);
+	__gensignal(r,2048,96,30000,2000);
+	addr = __asndpcm(3,l,r,2048);
+
+	for(v=0;v<ASND_MAX_VOICES;v++)
+		asndmodel_setinfinitevoice(m,v,3,40000 + v*1500,v,addr,2048*4,256,256 - v*8);
+
+	for(t=0;t<8;t++) {
+		asndmodel_tick(m);
+		__sinkwrite(s,m->out,ASND_SLICE_SAMPLES*2);
+	}
+	free(m);
+	return 0;
+}
+
+/* AESND scenarios */
+
+static uint8_t aesnd_data[16][65536] __attribute__((aligned(32)));
+
+static aesndmodel* __aesndnew(void)
+{
+	aesndmodel *m = malloc(sizeof(aesndmodel));
+
+	aesndmodel_init(m);
+	return m;
+}
+
+// AESND format to layout: mono8, stereo8, mono16, stereo16 and their unsigned variants, all big-endian
+static uint32_t __aesndpcm(uint8_t *dst,uint32_t format,const int16_t *l,const int16_t *r,uint32_t samples)
+{
+	return __storepcm(dst,l,r,samples,(format&1)!=0,(format&2) ? 16 : 8,(format&4)!=0,0);
+}
+
+static void __aesndrun(aesndmodel *m,sink *s,uint32_t frames)
+{
+	uint32_t t;
+
+	for(t=0;t<frames;t++) {
+		aesndmodel_tick(m);
+		__sinkwrite(s,m->out,AESND_FRAME_SAMPLES*2);
+	}
+}
+
+static int __aesnd_unity(sink *s)
+{
+	static int16_t l[16384],ref[16384];
+	aesndmodel *m = __aesndnew();
+	aesndmodelpb *pcm,*adpcm;
+	dspadpcm_hist hist = {0,0};
+	uint32_t len,t,i,o = 0;
+	int failed = 0;
+
+	__srand(7);
+	__gensignal(l,16384,173,11000,400);
+	__aesndpcm(aesnd_data[0],VOICE_MONO16,l,l,16384);
+	len = dspadpcm_encode(dspadpcm_defcoefs,l,aesnd_data[1],16380,&hist,ref);
+
+	// one voice per channel pair: the PCM voice alone first, then the ADPCM one
+	pcm = aesndmodel_allocatevoice(m,NULL);
+	aesndmodel_playvoice(pcm,VOICE_MONO16,aesnd_data[0],16384*2,48000,0,0);
+
+	for(t=0;t<60;t++) {
+		aesndmodel_tick(m);
+		__sinkwrite(s,m->out,AESND_FRAME_SAMPLES*2);
+
+		// the first tick only fills the stream buffer, the mixer then holds one sample
+		for(i=0;i<AESND_FRAME_SAMPLES;i++,o++) {
+			int16_t expect = (o<=AESND_FRAME_SAMPLES) ? 0 : l[o - AESND_FRAME_SAMPLES - 1];
+			if(m->out[i*2]!=expect || m->out[i*2 + 1]!=expect) failed = 1;
+		}
+	}
+	aesndmodel_freevoice(pcm);
+
+	adpcm = aesndmodel_allocatevoice(m,NULL);
+	aesndmodel_setvoiceadpcm(adpcm,dspadpcm_defcoefs,aesnd_data[1][0],0,0);
+	aesndmodel_playvoice(adpcm,VOICE_MONO_ADPCM,aesnd_data[1],len,48000,0,0);
+
+	for(t=0,o=0;t<60;t++) {
+		aesndmodel_tick(m);
+		__sinkwrite(s,m->out,AESND_FRAME_SAMPLES*2);
+
+		for(i=0;i<AESND_FRAME_SAMPLES;i++,o++) {
+			int16_t expect = (o<=AESND_FRAME_SAMPLES) ? 0 : ref[o - AESND_FRAME_SAMPLES - 1];
+			if(m->out[i*2]!=expect || m->out[i*2 + 1]!=expect) failed = 1;
+		}
+	}
+	free(m);
+	return failed;
+}
+
+static int __aesnd_formats(sink *s)
+{
+	static const uint32_t freq[9] = {8000,11025,22050,32000,44100,48000,96000,144000,32000};
+	static int16_t l[16384],r[16384];
+	aesndmodel *m = __aesndnew();
+	uint32_t f;
+
+	__srand(8);
+	for(f=0;f<9;f++) {
+		uint32_t samples = 3000 + f*1100;
+		aesndmodelpb *pb = aesndmodel_allocatevoice(m,NULL);
+		uint32_t len;
+
+		__gensignal(l,samples,89 + f*23,9000,250);
+		__gensignal(r,samples,193 - f*11,6000,0);
+		if(f<8) {
+			len = __aesndpcm(aesnd_data[f],f,l,r,samples);
+			aesndmodel_playvoice(pb,f,aesnd_data[f],len,freq[f],0,0);
+		} else {
+			dspadpcm_hist hist = {0,0};
+
+			len = dspadpcm_encode(dspadpcm_defcoefs,l,aesnd_data[f],samples,&hist,NULL);
+			aesndmodel_setvoiceadpcm(pb,dspadpcm_defcoefs,aesnd_data[f][0],0,0);
+			aesndmodel_playvoice(pb,VOICE_MONO_ADPCM,aesnd_data[f],len,freq[f],0,0);
+		}
+		aesndmodel_setvoicevolume(pb,(uint16_t)(0xe0 - f*8),(uint16_t)(0x40 + f*16));
+	}
+
+	__aesndrun(m,s,300);
+	free(m);
+	return 0;
+}
+
+static int __aesnd_loop(sink *s)
+{
+	static int16_t l[4000],r[4000];
+	aesndmodel *m = __aesndnew();
+	aesndmodelpb *a,*b,*c;
+	dspadpcm_hist hist = {0,0};
+	uint32_t len,t;
+
+	__srand(9);
+	__gensignal(l,4000,140,10000,0);
+	__gensignal(r,4000,70,10000,300);
+
+	a = aesndmodel_allocatevoice(m,NULL);
+	len = __aesndpcm(aesnd_data[0],VOICE_MONO16,l,l,1500);
+	aesndmodel_playvoice(a,VOICE_MONO16,aesnd_data[0],len,32000,0,1);
+
+	b = aesndmodel_allocatevoice(m,NULL);
+	len = __aesndpcm(aesnd_data[1],VOICE_STEREO8,l,r,999);
+	aesndmodel_playvoice(b,VOICE_STEREO8,aesnd_data[1],len,44100,0,1);
+
+	// a loop longer than a stream buffer half and one much shorter
+	c = aesndmodel_allocatevoice(m,NULL);
+	len = dspadpcm_encode(dspadpcm_defcoefs,r,aesnd_data[2],3990,&hist,NULL);
+	aesndmodel_setvoiceadpcm(c,dspadpcm_defcoefs,aesnd_data[2][0],0,0);
+	aesndmodel_playvoice(c,VOICE_MONO_ADPCM,aesnd_data[2],len,48000,0,1);
+
+	for(t=0;t<400;t++) {
+		switch(t) {
+			case 50: aesndmodel_setvoicefrequency(a,96000); break;
+			case 80: aesndmodel_setvoicevolume(b,0x180,0x20); break;
+			case 120: aesndmodel_setvoicemute(c,1); break;
+			case 140: aesndmodel_setvoicemute(c,0); break;
+			case 200: aesndmodel_setvoicefrequency(c,144000); break;
+			case 260: aesndmodel_setvoicestop(b,1); break;
+			case 300: aesndmodel_setvoicefrequency(a,4000); break;
+		}
+		aesndmodel_tick(m);
+		__sinkwrite(s,m->out,AESND_FRAME_SAMPLES*2);
+	}
+	free(m);
+	return 0;
+}
+
+typedef struct _aesndstream {
+	const uint8_t *chunk[3];
+	uint32_t len;
+	uint32_t next;
+	uint32_t requests;
+	uint32_t limit;
+} aesndstream;
+
+static void __aesndstreamcb(aesndmodelpb *pb,uint32_t state)
+{
+	aesndstream *st = pb->usr_data;
+
+	if(state!=VOICE_STATE_STREAM) return;
+
+	if(++st->requests>=st->limit) {
+		aesndmodel_setvoicestop(pb,1);
+		return;
+	}
+	aesndmodel_setvoicebuffer(pb,st->chunk[st->next],st->len);
+	st->next = (st->next + 1)%3;
+}
+
+static int __aesnd_stream(sink *s)
+{
+	static int16_t l[2000],r[2000];
+	aesndmodel *m = __aesndnew();
+	aesndstream st;
+	aesndmodelpb *pb;
+	uint32_t i;
+
+	__srand(10);
+	memset(&st,0,sizeof(st));
+	for(i=0;i<3;i++) {
+		__gensignal(l,2000,50 + i*30,12000,0);
+		__gensignal(r,2000,90 - i*20,9000,500);
+		st.len = __aesndpcm(aesnd_data[i],VOICE_STEREO16,l,r,2000);
+		st.chunk[i] = aesnd_data[i];
+	}
+	st.next = 1;
+	st.limit = 12;
+
+	pb = aesndmodel_allocatevoice(m,__aesndstreamcb);
+	pb->usr_data = &st;
+	aesndmodel_setvoicestream(pb,1);
+	aesndmodel_playvoice(pb,VOICE_STEREO16,st.chunk[0],st.len,44100,0,1);
+
+	__aesndrun(m,s,400);
+	free(m);
+	return (st.requests==st.limit) ? 0 : 1;
+}
+
+typedef struct _aesndsrc {
+	uint32_t phase;
+	uint32_t calls;
+} aesndsrc;
+
+static int32_t __aesndsourcecb(aesndmodelpb *pb,void *buffer,uint32_t len,void *cb_arg)
+{
+	aesndsrc *src = cb_arg;
+	int16_t pcm[AESND_STREAMBUFFER_SIZE];
+	uint32_t i,samples = len/4;
+
+	(void)pb;
+	if(++src->calls>40) return -1;
+
+	// every seventh call comes back short, as a decoder falling behind would
+	if((src->calls%7)==0) samples /= 3;
+
+	for(i=0;i<samples;i++,src->phase++) {
+		pcm[i*2 + 0] = (int16_t)((int32_t)((src->phase*331)&0xffff) - 32768)/4;
+		pcm[i*2 + 1] = (int16_t)((int32_t)((src->phase*97)&0xffff) - 32768)/3;
+	}
+	__storepcm(buffer,pcm,pcm,samples*2,0,16,0,0);
+	return (int32_t)(samples*4);
+}
+
+static int __aesnd_source(sink *s)
+{
+	aesndmodel *m = __aesndnew();
+	aesndsrc src = {0,0};
+	aesndmodelpb *pb;
+
+	pb = aesndmodel_allocatevoice(m,NULL);
+	aesndmodel_playvoice(pb,VOICE_STEREO16,aesnd_data[0],0,48000,0,0);
+	aesndmodel_setvoicesource(pb,__aesndsourcecb,&src);
+
+	__aesndrun(m,s,220);
+	free(m);
+	return (pb->underruns>0 && src.calls>40) ? 0 : 1;
+}
+
+static int __aesnd_delay(sink *s)
+{
+	static int16_t l[20000];
+	aesndmodel *m = __aesndnew();
+	aesndmodelpb *pb;
+	uint32_t len,d;
+
+	__srand(11);
+	__gensignal(l,20000,480,6000,100);
+	len = __aesndpcm(aesnd_data[0],VOICE_MONO16,l,l,20000);
+
+	for(d=0;d<4;d++) {
+		static const uint32_t delay[4] = {0,1,2,20};
+
+		pb = aesndmodel_allocatevoice(m,NULL);
+		aesndmodel_playvoice(pb,VOICE_MONO16,aesnd_data[0],len,24000 + d*8000,delay[d],0);
+	}
+
+	__aesndrun(m,s,80);
+	free(m);
+	return 0;
+}
+
+static int __aesnd_saturate(sink *s)
+{
+	static int16_t l[2048],r[2048];
+	aesndmodel *m = __aesndnew();
+	uint32_t len,v;
+
+	__srand(12);
+	__gensignal(l,2048,128,30000,0);
+	__gensignal(r,2048,96,30000,2000);
+	len = __aesndpcm(aesnd_data[0],VOICE_STEREO16,l,r,2048);
+
+	for(v=0;v<AESND_MAX_VOICES;v++) {
+		aesndmodelpb *pb = aesndmodel_allocatevoice(m,NULL);
+
+		aesndmodel_playvoice(pb,VOICE_STEREO16,aesnd_data[0],len,40000 + v*1500,0,1);
+		aesndmodel_setvoicevolume(pb,(uint16_t)(0x100 + v*4),(uint16_t)(0x100 - v*4));
+	}
+
+	__aesndrun(m,s,100);
+	free(m);
+	return 0;
+}
+
+static const scenario scenarios[] = {
+	{"asnd_unity",__asnd_unity},
+	{"asnd_formats",__asnd_formats},
+	{"asnd_loop",__asnd_loop},
+	{"asnd_stream",__asnd_stream},
+	{"asnd_delay",__asnd_delay},
+	{"asnd_saturate",__asnd_saturate},
+	{"aesnd_unity",__aesnd_unity},
+	{"aesnd_formats",__aesnd_formats},
+	{"aesnd_loop",__aesnd_loop},
+	{"aesnd_stream",__aesnd_stream},
+	{"aesnd_source",__aesnd_source},
+	{"aesnd_delay",__aesnd_delay},
+	{"aesnd_saturate",__aesnd_saturate},
+	{NULL,NULL}
+};
+
+/* golden hashes */
+
+static int __loadgolden(const char *path,golden *g,int max)
+{
+	char line[256];
+	FILE *fp = fopen(path,"r");
+	int n = 0;
+
+	if(!fp) return -1;
+	while(n<max && fgets(line,sizeof(line),fp)) {
+		unsigned long long hash;
+
+		if(line[0]=='#' || line[0]=='\n') continue;
+		if(sscanf(line,"%63s %llx",g[n].name,&hash)!=2) continue;
+		g[n++].hash = hash;
+	}
+	fclose(fp);
+	return n;
+}
+
+static const golden* __findgolden(const golden *g,int n,const char *name)
+{
+	int i;
+
+	for(i=0;i<n;i++) {
+		if(!strcmp(g[i].name,name)) return &g[i];
+	}
+	return NULL;
+}
+
+/* benchmark */
+
+static double __now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (double)ts.tv_sec*1e9 + (double)ts.tv_nsec;
+}
+
+static void __bench(void)
+{
+	static const uint32_t counts[6] = {1,2,4,8,16,32};
+	static int16_t l[4096],r[4096];
+	uint32_t i,t,v,addr,len;
+
+	__srand(13);
+	__gensignal(l,4096,100,12000,100);
+	__gensignal(r,4096,77,12000,100);
+
+	printf("mixer  voices   ns/tick  ns/voice  tick budget\n");
+	for(i=0;i<6;i++) {
+		asndmodel *m;
+		uint32_t ticks = 2000/counts[i] + 50;
+		double start,ns;
+
+		if(counts[i]>ASND_MAX_VOICES) break;
+
+		m = __asndnew();
+		addr = __asndpcm(3,l,r,4096);
+		for(v=0;v<counts[i];v++)
+			asndmodel_setinfinitevoice(m,(int32_t)v,3,44100,0,addr,4096*4,200,200);
+		for(t=0;t<8;t++) asndmodel_tick(m);
+
+		start = __now();
+		for(t=0;t<ticks;t++) asndmodel_tick(m);
+		ns = (__now() - start)/ticks;
+		printf("asnd   %6u  %8.0f  %8.0f  %10.2f%%\n",counts[i],ns,ns/counts[i],ns*100.0/(ASND_SLICE_SAMPLES*1e9/48000.0));
+		free(m);
+	}
+
+	for(i=0;i<6;i++) {
+		aesndmodel *m = __aesndnew();
+		uint32_t ticks = 200000/counts[i] + 500;
+		double start,ns;
+
+		len = __aesndpcm(aesnd_data[0],VOICE_STEREO16,l,r,4096);
+		for(v=0;v<counts[i];v++) {
+			aesndmodelpb *pb = aesndmodel_allocatevoice(m,NULL);
+			aesndmodel_playvoice(pb,VOICE_STEREO16,aesnd_data[0],len,44100,0,1);
+		}
+		for(t=0;t<8;t++) aesndmodel_tick(m);
+
+		start = __now();
+		for(t=0;t<ticks;t++) aesndmodel_tick(m);
+		ns = (__now() - start)/ticks;
+		printf("aesnd  %6u  %8.0f  %8.0f  %10.2f%%\n",counts[i],ns,ns/counts[i],ns*100.0/(AESND_FRAME_SAMPLES*1e9/48000.0));
+		free(m);
+	}
+}
+
+int main(int argc,char *argv[])
+{
+	golden g[MAX_SCENARIOS];
+	const char *golden_path = "mixer/golden.txt";
+	const char *out_dir = NULL;
+	int update = 0,bench = 0;
+	int i,n,failed = 0;
+	FILE *gfp = NULL;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-u")) update = 1;
+		else if(!strcmp(argv[i],"-b")) bench = 1;
+		else if(!strcmp(argv[i],"-o") && i + 1<argc) out_dir = argv[++i];
+		else if(!strcmp(argv[i],"-g") && i + 1<argc) golden_path = argv[++i];
+		else {
+			fprintf(stderr,"usage: %s [-u] [-b] [-o dir] [-g golden]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	if(bench) {
+		__bench();
+		return 0;
+	}
+
+	n = 0;
+	if(update) {
+		gfp = fopen(golden_path,"w");
+		if(!gfp) {
+			perror(golden_path);
+			return 1;
+		}
+		fprintf(gfp,"# FNV-1a 64 of each scenario's s16le output, regenerate with mixtest -u\n");
+	} else {
+		n = __loadgolden(golden_path,g,MAX_SCENARIOS);
+		if(n<0) {
+			perror(golden_path);
+			return 1;
+		}
+	}
+
+	for(i=0;scenarios[i].name;i++) {
+		const golden *ref;
+		sink s;
+		int ret;
+
+		s.hash = 0xcbf29ce484222325ULL;
+		s.fp = NULL;
+		if(out_dir) {
+			char path[512];
+
+			snprintf(path,sizeof(path),"%s/%s.raw",out_dir,scenarios[i].name);
+			s.fp = fopen(path,"wb");
+			if(!s.fp) {
+				perror(path);
+				return 1;
+			}
+		}
+
+		ret = scenarios[i].run(&s);
+		if(s.fp) fclose(s.fp);
+
+		printf("%-16s %016llx",scenarios[i].name,(unsigned long long)s.hash);
+		if(ret) {
+			printf("  FAILED expectation\n");
+			failed = 1;
+			continue;
+		}
+
+		if(update) {
+			fprintf(gfp,"%s %016llx\n",scenarios[i].name,(unsigned long long)s.hash);
+			printf("  updated\n");
+			continue;
+		}
+
+		ref = __findgolden(g,n,scenarios[i].name);
+		if(!ref) {
+			printf("  no golden hash\n");
+			failed = 1;
+		} else if(ref->hash!=s.hash) {
+			printf("  FAILED, expected %016llx\n",(unsigned long long)ref->hash);
+			failed = 1;
+		} else
+			printf("  ok\n");
+	}
+
+	if(gfp) fclose(gfp);
+	return failed;
+}
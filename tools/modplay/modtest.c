@@ -0,0 +1,440 @@
+/*-------------------------------------------------------------
+
+modtest.c -- libmodplay block mixer tests and benchmark
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libmodplay/mixer.c as it is, included here so that its tap fetch and
+ * interpolation can serve a per-sample reference mixer: one voice at a time,
+ * the loop end tested on every sample, as the mixer worked before it mixed
+ * in blocks. The block mixer has to give the same output and leave every
+ * channel in the same state, for random channels and random call lengths.
+ * libmodplay/modplay.c plays the benchmark module.
+ *
+ *   modtest				run the checks
+ *   modtest -b				also render a 32-channel module with each interpolation
+ *
+ * The benchmark figures are host figures, in CPU time per second of audio.
+ */
+
+#include "mixer.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "video.h"
+
+#define MIX_FREQ				48000
+#define MAX_CALL				1200			// a tick at 100 BPM
+
+#define BENCH_SECONDS			10
+
+extern s32 shiftvals[33];
+
+static int bench = 0;
+static u32 seed = 1;
+
+static u32 inctab[4096];
+static s8 samples[31][8192];
+static MOD mod,refmod;
+static s16 out[MAX_CALL*2],refout[MAX_CALL*2];
+static s32 refacc[MAX_CALL*2];
+
+static u8 module[1084 + 4*64*32*4 + 31*8192];
+static s16 render[MIX_FREQ/10*2];
+
+/* modplay.c builds its increment table for the TV mode the console is in */
+u32 VIDEO_GetCurrentTvMode()
+{
+	return VI_NTSC;
+}
+
+static u32 rnd(u32 n)
+{
+	seed = seed*1103515245 + 12345;
+	return (seed>>8)%n;
+}
+
+static double __cputime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* every voice of mix_16bit(), a sample at a time through the mixer's own taps */
+static void __refmix(MOD *m,s16 *buf,s32 numSamples,s32 channels)
+{
+	s32 voice,i,volume,lrofs;
+	s32 shift = MIX_FRACBITS - (m->shiftval + channels - 1);
+	u32 incval,noteidx;
+
+	memset(refacc,0,numSamples*channels*sizeof(s32));
+	for(voice=0;voice<m->num_channels;voice++) {
+		const MOD_INSTR *inst = &m->instrument[m->instnum[voice]];
+		u32 pos = m->playpos[voice];
+
+		if(inst->data==NULL || !m->channel_active[voice]) continue;
+
+		lrofs = channels==2 ? (((voice - 1)>>1)&1)^1 : 0;
+		volume = m->volume[voice];
+		volume = (volume*(s32)(voice<m->num_voices ? m->musicvolume : m->sfxvolume))>>6;
+
+		noteidx = m->chanfreq[voice] - m->chanfreq[voice]*2*(inst->finetune - 8)/256;
+		incval = m->inctab[noteidx];
+		if(m->freq==32000 || m->freq==48000) incval >>= 2;
+
+		for(i=0;i<numSamples;i++) {
+			if(pos>=(inst->loop_end<<16)) {
+				if(!inst->looped || inst->loop_length==0) {
+					pos = (inst->loop_end - 1)<<16;
+					m->channel_active[voice] = FALSE;
+					break;
+				}
+				while(pos>=(inst->loop_end<<16)) pos -= inst->loop_length<<16;
+			}
+			refacc[i*channels + lrofs] += mix_interpolate(mix_fetch(inst,(pos>>16) - 1),mix_fetch(inst,pos>>16),
+				mix_fetch(inst,(pos>>16) + 1),mix_fetch(inst,(pos>>16) + 2),m->interpolation,pos&0xffff)*volume;
+			pos += incval;
+		}
+		m->playpos[voice] = pos;
+	}
+
+	for(i=0;i<numSamples*channels;i++) {
+		s32 accum = (s32)(s16)PREFILL_WORD + (refacc[i]>>shift);
+
+		buf[i] = accum<-32768 ? -32768 : (accum>32767 ? 32767 : accum);
+	}
+}
+
+/* a one-shot or a loop as short as two samples, anywhere in the sample */
+static void __randinstr(MOD_INSTR *inst,s8 *data)
+{
+	u32 i;
+
+	inst->length = 2 + rnd(8190);
+	inst->finetune = rnd(16);
+	inst->data = data;
+	for(i=0;i<inst->length;i++) data[i] = (s8)rnd(256);
+
+	inst->looped = rnd(3)!=0;
+	if(inst->looped) {
+		inst->loop_start = rnd(inst->length - 1);
+		inst->loop_length = 2 + rnd(inst->length - inst->loop_start - 1);
+		if(inst->loop_start + inst->loop_length>inst->length) inst->loop_length = inst->length - inst->loop_start;
+		inst->loop_end = inst->loop_start + inst->loop_length;
+	} else {
+		inst->loop_start = inst->loop_end = inst->length;
+		inst->loop_length = 0;
+	}
+}
+
+static void __randvoice(MOD *m,s32 voice)
+{
+	m->instnum[voice] = rnd(31);
+	m->chanfreq[voice] = 113 + rnd(856 - 113 + 1);
+	m->volume[voice] = rnd(65);
+	m->playpos[voice] = rnd(m->instrument[m->instnum[voice]].loop_end)<<16 | rnd(0x10000);
+	m->channel_active[voice] = rnd(8)!=0;
+}
+
+static void __randmod(MOD *m,s32 channels)
+{
+	s32 i;
+
+	memset(m,0,sizeof(*m));
+	for(i=0;i<31;i++) __randinstr(&m->instrument[i],samples[i]);
+
+	m->num_channels = 1 + rnd(32);
+	m->num_voices = m->num_channels - rnd(m->num_channels<4 ? m->num_channels : 4);
+	m->shiftval = shiftvals[m->num_channels];
+	m->musicvolume = rnd(65);
+	m->sfxvolume = rnd(65);
+	m->freq = MIX_FREQ;
+	m->bits = 16;
+	m->channels = channels;
+	m->inctab = inctab;
+	for(i=0;i<m->num_channels;i++) __randvoice(m,i);
+}
+
+/* random channels mixed in calls of random length, retriggered now and then */
+static int __test_blocks(s32 interp)
+{
+	u32 round,call,n;
+	s32 i,channels;
+
+	for(round=0;round<64;round++) {
+		channels = 1 + (round&1);
+		__randmod(&mod,channels);
+		mod.interpolation = interp;
+		memcpy(&refmod,&mod,sizeof(mod));
+
+		for(call=0;call<64;call++) {
+			n = 1 + rnd(MAX_CALL);
+			if(channels==2) mix_stereo_16bit(&mod,out,n);
+			else mix_mono_16bit(&mod,out,n);
+			__refmix(&refmod,refout,n,channels);
+
+			if(memcmp(out,refout,n*channels*sizeof(s16))) return 1;
+			if(memcmp(mod.playpos,refmod.playpos,sizeof(mod.playpos))) return 1;
+			if(memcmp(mod.channel_active,refmod.channel_active,sizeof(mod.channel_active))) return 1;
+
+			if(rnd(4)==0) {
+				i = rnd(mod.num_channels);
+				__randvoice(&mod,i);
+				refmod.instnum[i] = mod.instnum[i];
+				refmod.chanfreq[i] = mod.chanfreq[i];
+				refmod.volume[i] = mod.volume[i];
+				refmod.playpos[i] = mod.playpos[i];
+				refmod.channel_active[i] = mod.channel_active[i];
+			}
+		}
+	}
+	return 0;
+}
+
+static int __test_none(void)
+{
+	return __test_blocks(MOD_INTERP_NONE);
+}
+
+static int __test_linear(void)
+{
+	return __test_blocks(MOD_INTERP_LINEAR);
+}
+
+static int __test_cubic(void)
+{
+	return __test_blocks(MOD_INTERP_CUBIC);
+}
+
+/* a looped sine of 12 samples played 5.7 times slower: each interpolation gets closer to it */
+static int __test_quality(void)
+{
+	static const char *names[3] = {"none","linear","cubic"};
+	const u32 period = 12;
+	s32 interp,i,n = MAX_CALL;
+	double snr[3],w,phase,sig,noise,e;
+	MOD_INSTR *inst;
+
+	for(interp=MOD_INTERP_NONE;interp<=MOD_INTERP_CUBIC;interp++) {
+		memset(&mod,0,sizeof(mod));
+		inst = &mod.instrument[0];
+		inst->length = inst->loop_end = inst->loop_length = period;
+		inst->loop_start = 0;
+		inst->looped = TRUE;
+		inst->finetune = 8;
+		inst->data = samples[0];
+		for(i=0;i<(s32)period;i++) samples[0][i] = (s8)lrint(100.0*sin(2.0*M_PI*i/period));
+
+		mod.num_channels = mod.num_voices = 1;
+		mod.shiftval = shiftvals[1];
+		mod.musicvolume = 64;
+		mod.freq = MIX_FREQ;
+		mod.inctab = inctab;
+		mod.interpolation = interp;
+		mod.chanfreq[0] = 428;
+		mod.volume[0] = 64;
+		mod.channel_active[0] = TRUE;
+		mix_mono_16bit(&mod,out,n);
+
+		/* the output is the sample scaled up by 1 << (14 - shiftval) */
+		w = 2.0*M_PI*(inctab[428]>>2)/65536.0/period;
+		sig = noise = 0;
+		for(i=0;i<n;i++) {
+			phase = w*i;
+			e = 100.0*sin(phase)*256.0*64.0/(1<<(MIX_FRACBITS - mod.shiftval));
+			sig += e*e;
+			noise += (out[i] - e)*(out[i] - e);
+		}
+		snr[interp] = 10.0*log10(sig/noise);
+	}
+	printf("%-16s %s %5.1f dB, %s %5.1f dB, %s %5.1f dB\n","",names[0],snr[0],names[1],snr[1],names[2],snr[2]);
+	return !(snr[MOD_INTERP_LINEAR]>snr[MOD_INTERP_NONE] + 6.0 && snr[MOD_INTERP_CUBIC]>snr[MOD_INTERP_LINEAR]);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void __put_be16(u8 *ptr,u32 val)
+{
+	ptr[0] = val>>8;
+	ptr[1] = val&0xff;
+}
+
+/* a 32CH module of looped instruments, a note on a quarter of the cells, some volume changes */
+static void __buildmod(void)
+{
+	static const u16 periods[36] = {
+		856,808,762,720,678,640,604,570,538,508,480,453,
+		428,404,381,360,339,320,302,285,269,254,240,226,
+		214,202,190,180,170,160,151,143,135,127,120,113
+	};
+	u32 i,k,len,ofs,instr,period;
+	u8 *ptr;
+
+	memset(module,0,sizeof(module));
+	memcpy(module,"modtest",7);
+	for(i=0;i<31;i++) {
+		ptr = module + 20 + i*30;
+		len = 1024 + rnd(3072);					// words
+		__put_be16(ptr + 22,len);
+		ptr[25] = 64;
+		__put_be16(ptr + 26,len/2);
+		__put_be16(ptr + 28,len/2);
+	}
+	module[950] = 4;
+	module[951] = 127;
+	for(i=0;i<4;i++) module[952 + i] = i;
+	memcpy(module + 1080,"32CH",4);
+
+	ofs = 1084;
+	for(i=0;i<4*64*32;i++,ofs+=4) {
+		if(rnd(4)) continue;
+		instr = 1 + rnd(31);
+		period = periods[rnd(36)];
+		module[ofs] = (instr&0xf0) | (period>>8);
+		module[ofs + 1] = period&0xff;
+		module[ofs + 2] = (instr&0x0f)<<4;
+		if(rnd(4)==0) {
+			module[ofs + 2] |= 0x0c;
+			module[ofs + 3] = rnd(65);
+		}
+	}
+
+	for(i=0;i<31;i++) {
+		len = ((module[20 + i*30 + 22]<<8) | module[20 + i*30 + 23])*2;
+		for(k=0;k<len;k++) module[ofs + k] = (s8)lrint(90.0*sin(2.0*M_PI*k*(i + 1)/256.0)) + (s8)(rnd(21) - 10);
+		ofs += len;
+	}
+}
+
+static void __startmod(s32 interp)
+{
+	MOD_SetMOD(&mod,module);
+	mod.freq = MIX_FREQ;
+	mod.bits = 16;
+	mod.channels = 2;
+	mod.mixingbuf = (u8*)render;
+	mod.mixingbuflen = sizeof(render);
+	mod.interpolation = interp;
+	MOD_Start(&mod);
+}
+
+/* the whole player, note processing included, in calls of 100 ms */
+static void __bench_player(void)
+{
+	static const char *names[3] = {"player none","player linear","player cubic"};
+	s32 interp;
+	u32 i;
+	double t;
+
+	for(interp=MOD_INTERP_NONE;interp<=MOD_INTERP_CUBIC;interp++) {
+		__startmod(interp);
+
+		t = __cputime();
+		for(i=0;i<BENCH_SECONDS*10;i++) MOD_Player(&mod);
+		t = __cputime() - t;
+		printf("%-24s %8.2f ms/s\n",names[interp],t*1e3/BENCH_SECONDS);
+	}
+}
+
+/* the mixer alone on the voices playing a second into the module, and the per-sample reference on them */
+static void __bench_mixer(void)
+{
+	static const char *names[4] = {"mix none","mix linear","mix cubic","mix none per sample"};
+	s32 interp,voice,active;
+	u32 i;
+	double t;
+
+	__startmod(MOD_INTERP_NONE);
+	for(i=0;i<10;i++) MOD_Player(&mod);
+	memcpy(&refmod,&mod,sizeof(mod));
+
+	for(active=voice=0;voice<mod.num_channels;voice++) active += mod.channel_active[voice];
+	printf("%-24s %8d\n","voices playing",active);
+
+	for(interp=0;interp<4;interp++) {
+		memcpy(&mod,&refmod,sizeof(mod));
+		mod.interpolation = interp<3 ? interp : MOD_INTERP_NONE;
+
+		t = __cputime();
+		for(i=0;i<BENCH_SECONDS*50;i++) {
+			if(interp<3) mix_stereo_16bit(&mod,render,MIX_FREQ/50);
+			else __refmix(&mod,render,MIX_FREQ/50,2);
+		}
+		t = __cputime() - t;
+		printf("%-24s %8.2f ms/s\n",names[interp],t*1e3/BENCH_SECONDS);
+	}
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "blocks none",	__test_none },
+	{ "blocks linear",	__test_linear },
+	{ "blocks cubic",	__test_cubic },
+	{ "quality",		__test_quality },
+};
+
+int main(int argc,char *argv[])
+{
+	u32 i;
+	int failed = 0;
+
+	for(i=1;i<(u32)argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	/* modplay.c's table for 48 kHz on NTSC */
+	for(i=1;i<4096;i++) inctab[i] = (u32)(((7159090.5/2.0F)/(f32)i)/(f32)MIX_FREQ*262144.0F);
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		__buildmod();
+		__bench_player();
+		__bench_mixer();
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
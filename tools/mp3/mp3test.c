@@ -0,0 +1,783 @@
+/*-------------------------------------------------------------
+
+mp3test.c -- MP3Player resampler and playback tests
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libmad/mp3player.c as it is, on the simulated kernel of lwpsim/ and
+ * with the fixed-point libmad build of madtest. The source is included here
+ * so that the resampler can be driven directly. A fake ASND voice, a thread
+ * above every other priority, plays the output buffers a tick of 1024
+ * samples at a time and calls the voice callback with interrupts disabled
+ * as the DSP interrupt would. It runs its ticks faster than real time, and
+ * keeps everything it plays.
+ *
+ * The streams come from tools/mad/madstream.c. The seek checks play them
+ * as files through MP3Player_PlayFileSeekable(): constant and variable
+ * bitrate, with no tag, a Xing TOC or a VBRI table, all of them using the
+ * bit reservoir.
+ *
+ *   mp3test				run the checks
+ *   mp3test -b				also time the resampler, the whole player and seeks
+ *
+ * The benchmark figures are host figures, in CPU time per second of audio.
+ */
+
+#include "mp3player.c"
+
+#include <time.h>
+
+#include "semaphore.h"
+#include "timesupp.h"
+#include "madstream.h"
+
+#define TICK_SAMPLES			1024
+#define TICK_MS					1
+
+#define MAX_STREAM				(512*1024)
+#define MAX_CAPTURE				(16*48000)
+
+#define TONE_SECONDS			1
+
+#define SEEK_FRAMES				400				// 9.6 s at 48 kHz
+#define SEEK_VBRI_FRAMES		8				// frames a VBRI table entry covers
+
+enum {
+	SEEK_CBR = 0,
+	SEEK_VBR,
+	SEEK_XING,
+	SEEK_VBRI
+};
+
+static int bench = 0;
+
+static struct {
+	void *cur,*next;
+	u32 pos,size;
+	u32 active;
+	ASNDVoiceCallback cb;
+	u32 underruns;
+} voice;
+
+static volatile bool voicestop;
+static lwp_t voicethread = LWP_THREAD_NULL;
+
+static u32 capture[MAX_CAPTURE];
+static u32 captured;
+
+static u8 stream[MAX_STREAM];
+static s16 ref[MAX_CAPTURE*2];
+static double tone[TONE_SECONDS*48000];
+static s16 toneout[TONE_SECONDS*48000*2];
+static struct mad_pcm pcm;
+static u32 drain[RESAMPLE_CHUNK];
+
+static struct {
+	const u8 *buf;
+	s32 len,pos;
+	u32 read;
+} file;
+
+static u32 frameoff[SEEK_FRAMES];
+static volatile s32 landed = -2;
+static volatile u32 landpos;
+static u64 landtime;
+static u32 landread;
+
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+static double __cputime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* voice 0 of ASND, the only one MP3Player uses */
+void ASND_Pause(s32 paused) {}
+
+s32 ASND_SetVoice(s32 v,s32 format,s32 pitch,s32 delay,void *snd,s32 size_snd,s32 volume_l,s32 volume_r,ASNDVoiceCallback callback)
+{
+	u32 level;
+
+	if(v!=0 || format!=VOICE_STEREO_16BIT || pitch!=48000) return SND_INVALID;
+
+	_CPU_ISR_Disable(level);
+	voice.cur = snd;
+	voice.next = NULL;
+	voice.pos = 0;
+	voice.size = size_snd;
+	voice.cb = callback;
+	voice.active = 1;
+	_CPU_ISR_Restore(level);
+	return SND_OK;
+}
+
+s32 ASND_AddVoice(s32 v,void *snd,s32 size_snd)
+{
+	u32 level;
+	s32 ret = SND_OK;
+
+	if(v!=0 || !voice.active || (u32)size_snd!=voice.size) return SND_INVALID;
+
+	_CPU_ISR_Disable(level);
+	if(voice.next==NULL) voice.next = snd;
+	else ret = SND_BUSY;
+	_CPU_ISR_Restore(level);
+	return ret;
+}
+
+s32 ASND_TestPointer(s32 v,void *pointer)
+{
+	return (voice.cur==pointer || voice.next==pointer) ? SND_BUSY : SND_OK;
+}
+
+s32 ASND_StatusVoice(s32 v)
+{
+	return voice.active ? SND_WORKING : SND_UNUSED;
+}
+
+s32 ASND_StopVoice(s32 v)
+{
+	u32 level;
+
+	_CPU_ISR_Disable(level);
+	voice.active = 0;
+	voice.cur = voice.next = NULL;
+	voice.cb = NULL;
+	_CPU_ISR_Restore(level);
+	return SND_OK;
+}
+
+s32 ASND_ChangeVolumeVoice(s32 v,s32 volume_l,s32 volume_r)
+{
+	return SND_OK;
+}
+
+/* a buffer played to its end is replaced by the one added, or the voice waits with nothing to play */
+static void* __voice(void *arg)
+{
+	u32 i,level;
+
+	while(!voicestop) {
+		__sleep(TICK_MS);
+
+		_CPU_ISR_Disable(level);
+		if(voice.active) {
+			if(voice.cur==NULL) {
+				voice.cur = voice.next;
+				voice.next = NULL;
+				voice.pos = 0;
+			}
+			if(voice.cur==NULL)
+				voice.underruns++;
+			else {
+				for(i=0;i<TICK_SAMPLES && captured<MAX_CAPTURE;i++) capture[captured++] = ((u32*)voice.cur)[voice.pos/4 + i];
+				voice.pos += TICK_SAMPLES*4;
+				if(voice.pos>=voice.size) voice.cur = NULL;
+			}
+			if(voice.next==NULL && voice.cb) voice.cb(0);
+		}
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+/* the stream as a file, through MP3Player_PlayFileSeekable() */
+static s32 __read(void *cb_data,void *buf,s32 len)
+{
+	if(len>file.len - file.pos) len = file.len - file.pos;
+	memcpy(buf,file.buf + file.pos,len);
+	file.pos += len;
+	file.read += len;
+	return len;
+}
+
+static s32 __seek(void *cb_data,s32 offset,s32 whence)
+{
+	switch(whence) {
+		case SEEK_SET:
+			break;
+		case SEEK_CUR:
+			offset += file.pos;
+			break;
+		case SEEK_END:
+			offset += file.len;
+			break;
+		default:
+			return -1;
+	}
+	if(offset<0 || offset>file.len) return -1;
+
+	file.pos = offset;
+	return offset;
+}
+
+/* the first frame played after a seek, and the position reported once it is in the ring */
+static void __filter(struct mad_stream *st,struct mad_frame *fr)
+{
+	if(landed==-1) {
+		landed = Info.bufpos + (st->this_frame - InputBuffer);
+		landtime = gettime();
+		landread = file.read;
+	} else if(landed>=0 && landpos==~0U)
+		landpos = MP3Player_GetPosition();
+}
+
+/*---------------------------------------------------------------------------------*/
+/* feeds mono samples through Resample() a frame at a time, keeps the left channel */
+static u32 __resample(const double *in,u32 len,u32 samplerate,EQState eqs[2],s16 *out,u32 maxout)
+{
+	u32 i,n = 0;
+	s32 got,k;
+
+	buf_init(&OutputRingBuffer);
+	LWP_InitQueue(&thQueue);
+	ResampleState.src_samplerate = 0;
+
+	pcm.samplerate = samplerate;
+	pcm.channels = 2;
+	for(i=0;i<len;i+=pcm.length) {
+		pcm.length = (len - i)<1152 ? (len - i) : 1152;
+		for(k=0;k<pcm.length;k++) pcm.samples[0][k] = pcm.samples[1][k] = mad_f_tofixed(in[i + k]);
+		Resample(&pcm,eqs,1,samplerate);
+
+		while((got = buf_get(&OutputRingBuffer,drain,sizeof(drain)))>0) {
+			for(k=0;k<got/4 && n<maxout;k++) out[n++] = (s16)(drain[k]>>16);
+		}
+	}
+	LWP_CloseQueue(thQueue);
+	return n;
+}
+
+static void __tone(double freq,u32 samplerate)
+{
+	u32 i;
+
+	for(i=0;i<TONE_SECONDS*samplerate;i++) tone[i] = 0.5*sin(2.0*M_PI*freq*i/samplerate);
+}
+
+/* signal to noise of the output against the sine that fits it best, at the frequency the 16.16 step makes */
+static double __snr(const s16 *out,u32 n,double freq,u32 samplerate)
+{
+	u32 i;
+	double w,s,c,ss,sc,cc,ys,yc,det,a,b,e,sig,noise;
+
+	w = 2.0*M_PI*freq*((u32)(((u64)samplerate<<16)/48000)/65536.0)/samplerate;
+	ss = sc = cc = ys = yc = 0;
+	for(i=32;i<n - 32;i++) {
+		s = sin(w*i);
+		c = cos(w*i);
+		ss += s*s;
+		sc += s*c;
+		cc += c*c;
+		ys += out[i]*s;
+		yc += out[i]*c;
+	}
+	det = ss*cc - sc*sc;
+	a = (ys*cc - yc*sc)/det;
+	b = (yc*ss - ys*sc)/det;
+
+	sig = noise = 0;
+	for(i=32;i<n - 32;i++) {
+		e = a*sin(w*i) + b*cos(w*i);
+		sig += e*e;
+		noise += (out[i] - e)*(out[i] - e);
+	}
+	return 10.0*log10(sig/noise);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* 48 kHz goes through untouched, and so does a flat EQ */
+static int __test_passthrough(void)
+{
+	u32 i,n;
+	EQState eqs[2];
+
+	Init3BandState(&eqs[0],880,5000,48000);
+	Init3BandState(&eqs[1],880,5000,48000);
+	MP3Player_SetEqualizer(1.0F,1.0F,1.0F);
+	MP3Player_SetQuality(MP3PLAYER_QUALITY_HIGH);
+
+	__tone(1000.0,48000);
+	n = __resample(tone,48000,48000,eqs,toneout,48000);
+	if(n!=48000) return 1;
+	for(i=0;i<n;i++) {
+		if(toneout[i]!=FixedToShort(mad_f_tofixed(tone[i]))) return 1;
+	}
+	return 0;
+}
+
+/* a non-flat EQ is not skipped: equal gains scale the three-sample delay of the flat one */
+static int __test_equalizer(void)
+{
+	u32 i,n;
+	EQState eqs[2];
+
+	Init3BandState(&eqs[0],880,5000,48000);
+	Init3BandState(&eqs[1],880,5000,48000);
+	MP3Player_SetEqualizer(0.5F,0.5F,0.5F);
+
+	__tone(1000.0,48000);
+	n = __resample(tone,48000,48000,eqs,toneout,48000);
+	MP3Player_SetEqualizer(1.0F,1.0F,1.0F);
+	if(n!=48000) return 1;
+	for(i=3;i<n;i++) {
+		if(abs(toneout[i] - FixedToShort(mad_f_tofixed(tone[i - 3]))/2)>1) return 1;
+	}
+	return 0;
+}
+
+/* 44.1 kHz tones, at every quality: the sinc filters keep the images of a high tone out */
+static int __test_resample(void)
+{
+	static const double freqs[3] = {1000.0,10000.0,16000.0};
+	static const double minsnr[3][3] = {
+		{55.0,15.0, 5.0},		// LOW, linear
+		{65.0,50.0,20.0},		// MEDIUM, 8 taps
+		{65.0,50.0,45.0},		// HIGH, 16 taps
+	};
+	u32 q,f,n,expect;
+	double snr[3][3];
+	EQState eqs[2];
+	int failed = 0;
+
+	Init3BandState(&eqs[0],880,5000,48000);
+	Init3BandState(&eqs[1],880,5000,48000);
+	MP3Player_SetEqualizer(1.0F,1.0F,1.0F);
+
+	expect = (u32)((44100ULL<<16)/((44100ULL<<16)/48000));
+	for(q=0;q<3;q++) {
+		MP3Player_SetQuality(q);
+		for(f=0;f<3;f++) {
+			__tone(freqs[f],44100);
+			n = __resample(tone,44100,44100,eqs,toneout,TONE_SECONDS*48000*2);
+			if(n + ResampleState.taps/2 + 1<expect || n>expect) failed = 1;
+
+			snr[q][f] = __snr(toneout,n,freqs[f],44100);
+			if(snr[q][f]<minsnr[q][f]) failed = 1;
+		}
+		printf("%-16s quality %u: %5.1f dB at 1 kHz, %5.1f dB at 10 kHz, %5.1f dB at 16 kHz\n","",q,snr[q][0],snr[q][1],snr[q][2]);
+	}
+	MP3Player_SetQuality(MP3PLAYER_QUALITY_MEDIUM);
+	return failed;
+}
+
+/* a stream decoded by MP3Player and played by the voice is the stream decoded by libmad */
+static int __test_player(void)
+{
+	u32 i,n,len,wait;
+	madstream ms;
+	struct mad_stream st;
+	struct mad_frame fr;
+	struct mad_synth sy;
+
+	madstream_init(&ms,stream,sizeof(stream),42);
+	for(i=0;i<64;i++) {
+		if(!madstream_frame(&ms,3,128,48000)) return 1;
+	}
+	len = ms.len;
+
+	n = 0;
+	mad_stream_init(&st);
+	mad_frame_init(&fr);
+	mad_synth_init(&sy);
+	mad_stream_buffer(&st,stream,len + MADSTREAM_GUARD);
+	while(!mad_frame_decode(&fr,&st)) {
+		mad_synth_frame(&sy,&fr);
+		for(i=0;i<sy.pcm.length;i++) {
+			ref[n++] = FixedToShort(sy.pcm.samples[0][i]);
+			ref[n++] = FixedToShort(sy.pcm.samples[1][i]);
+		}
+	}
+	mad_synth_finish(&sy);
+	mad_frame_finish(&fr);
+	mad_stream_finish(&st);
+	if(n!=64*1152*2) return 1;
+
+	captured = voice.underruns = 0;
+	MP3Player_Init();
+	if(MP3Player_PlayBuffer(stream,len,NULL)!=0) return 1;
+	for(wait=0;MP3Player_IsPlaying() && wait<10000;wait++) __sleep(1);
+	if(MP3Player_IsPlaying()) return 1;
+
+	/* the voice starts on a silent buffer, and is stopped once the ring is empty with up to two buffers queued */
+	if(captured + 2*ADMA_BUFFERSIZE/4<n/2 + ADMA_BUFFERSIZE/4) return 1;
+	for(i=0;i<captured - ADMA_BUFFERSIZE/4 && i<n/2;i++) {
+		u32 s = capture[ADMA_BUFFERSIZE/4 + i];
+
+		if((s16)(s>>16)!=ref[2*i] || (s16)s!=ref[2*i + 1]) return 1;
+	}
+	printf("%-16s %u samples played, %u ticks without a buffer\n","",captured,voice.underruns);
+	return 0;
+}
+
+static void __put_be(u8 *ptr,u32 val,u32 len)
+{
+	while(len-->0) {
+		ptr[len] = val&0xff;
+		val >>= 8;
+	}
+}
+
+/* 48 kHz Layer III with the bit reservoir in use, preceded by a Xing or VBRI frame as the kind asks */
+static u32 __seekstream(u32 kind,u32 seed)
+{
+	static const u16 rates[6] = {64,96,128,192,256,320};
+	u32 i,k,tag,datastart,bytes,entries,end;
+	madstream ms;
+	u8 *ptr;
+
+	madstream_init(&ms,stream,sizeof(stream),seed);
+	ms.reservoir = 1;
+
+	tag = ms.len;
+	if(kind>=SEEK_XING && !madstream_empty(&ms,128,48000)) return 0;
+	datastart = ms.len;
+
+	for(i=0;i<SEEK_FRAMES;i++) {
+		frameoff[i] = ms.len;
+		seed = seed*1103515245 + 12345;
+		if(!madstream_frame(&ms,3,kind==SEEK_CBR ? 128 : rates[(seed>>16)%6],48000)) return 0;
+	}
+	bytes = ms.len - datastart;
+
+	ptr = stream + tag + 4 + 32;
+	if(kind==SEEK_XING) {
+		memcpy(ptr,"Xing",4);
+		__put_be(ptr + 4,0x07,4);			// frames, bytes, TOC
+		__put_be(ptr + 8,SEEK_FRAMES,4);
+		__put_be(ptr + 12,bytes,4);
+		for(i=0;i<100;i++) ptr[16 + i] = (u8)(((u64)(frameoff[i*SEEK_FRAMES/100] - datastart)*256)/bytes);
+	} else if(kind==SEEK_VBRI) {
+		entries = (SEEK_FRAMES + SEEK_VBRI_FRAMES - 1)/SEEK_VBRI_FRAMES;
+		memcpy(ptr,"VBRI",4);
+		__put_be(ptr + 4,1,2);				// version
+		__put_be(ptr + 6,0,2);				// delay
+		__put_be(ptr + 8,75,2);				// quality
+		__put_be(ptr + 10,bytes,4);
+		__put_be(ptr + 14,SEEK_FRAMES,4);
+		__put_be(ptr + 18,entries,2);
+		__put_be(ptr + 20,1,2);				// scale
+		__put_be(ptr + 22,2,2);				// bytes an entry
+		__put_be(ptr + 24,SEEK_VBRI_FRAMES,2);
+		for(i=0;i<entries;i++) {
+			k = (i + 1)*SEEK_VBRI_FRAMES;
+			end = k<SEEK_FRAMES ? frameoff[k] : ms.len;
+			__put_be(ptr + 26 + i*2,end - frameoff[i*SEEK_VBRI_FRAMES],2);
+		}
+	}
+	return ms.len;
+}
+
+/* libmad's output for every frame from the first after the tag */
+static u32 __decode(u32 start,u32 len)
+{
+	u32 i,n = 0;
+	struct mad_stream st;
+	struct mad_frame fr;
+	struct mad_synth sy;
+
+	mad_stream_init(&st);
+	mad_frame_init(&fr);
+	mad_synth_init(&sy);
+	mad_stream_buffer(&st,stream + start,len - start + MADSTREAM_GUARD);
+	while(!mad_frame_decode(&fr,&st)) {
+		mad_synth_frame(&sy,&fr);
+		for(i=0;i<sy.pcm.length;i++) {
+			ref[n++] = FixedToShort(sy.pcm.samples[0][i]);
+			ref[n++] = FixedToShort(sy.pcm.samples[1][i]);
+		}
+	}
+	mad_synth_finish(&sy);
+	mad_frame_finish(&fr);
+	mad_stream_finish(&st);
+	return n/2;
+}
+
+static s32 __playfile(u32 len)
+{
+	file.buf = stream;
+	file.len = len;
+	file.pos = 0;
+	file.read = 0;
+	landed = -2;
+
+	captured = voice.underruns = 0;
+	return MP3Player_PlayFileSeekable(NULL,__read,__seek,__filter);
+}
+
+/*
+ * Seeks the playing stream to ms and waits for the first frame played after
+ * it. Returns the index of that frame, -1 if there is none, with the time
+ * and bytes read it took, and where its audio starts among the samples
+ * played or -1 if it is not played as libmad decodes it.
+ */
+static s32 __seekto(u32 ms,u64 *ticks,u32 *read,s32 *played)
+{
+	u32 i,k,p,p0,wait,level;
+	u64 start;
+
+	_CPU_ISR_Disable(level);
+	landed = -1;
+	landpos = ~0U;
+	*read = file.read;
+	p0 = captured;
+	start = gettime();
+	MP3Player_Seek(ms);
+	_CPU_ISR_Restore(level);
+
+	for(wait=0;(landed<0 || landpos==~0U) && MP3Player_IsPlaying() && wait<10000;wait++) __sleep(1);
+	if(landed<0) return -1;
+
+	*ticks = diff_ticks(start,landtime);
+	*read = landread - *read;
+	for(k=0;k<SEEK_FRAMES && frameoff[k]!=(u32)landed;k++);
+	if(k==SEEK_FRAMES) return -1;
+
+	/* the audio queued ahead of it plays first */
+	for(wait=0;captured<p0 + 4*ADMA_BUFFERSIZE/4 + 2*1152 && MP3Player_IsPlaying() && wait<10000;wait++) __sleep(1);
+
+	*played = -1;
+	for(p=p0;p + 1152<=captured && *played<0;p++) {
+		for(i=0;i<1152;i++) {
+			u32 s = capture[p + i];
+
+			if((s16)(s>>16)!=ref[2*(k*1152 + i)] || (s16)s!=ref[2*(k*1152 + i) + 1]) break;
+		}
+		if(i==1152) *played = p - p0;
+	}
+	return k;
+}
+
+/*
+ * Seeks back and forth in a stream that plays: past the frames indexed so
+ * far, back into them, and further on. A seek lands on the frame that holds
+ * the time asked for, or within the TOC resolution of a Xing tag, and that
+ * frame plays as libmad decodes it in the whole stream, bit reservoir and
+ * overlap included.
+ */
+static int __test_seek(u32 kind)
+{
+	static const u32 targets[4] = {6000,2000,8500,500};
+	u32 i,len,wait,read,target,slack;
+	s32 k,played = -1;
+	u64 ticks = 0;
+	int failed = 0;
+
+	len = __seekstream(kind,kind*7 + 1);
+	if(len==0) return 1;
+	if(__decode(kind>=SEEK_XING ? frameoff[0] : 0,len)!=SEEK_FRAMES*1152) return 1;
+
+	MP3Player_Init();
+	if(__playfile(len)!=0) return 1;
+	for(wait=0;captured<48000/2 && MP3Player_IsPlaying() && wait<10000;wait++) __sleep(1);
+
+	if(kind!=SEEK_VBR && MP3Player_GetDuration()!=SEEK_FRAMES*1152*1000/48000) failed = 1;
+
+	slack = kind==SEEK_XING ? SEEK_FRAMES/100 + 1 : 0;
+	for(i=0;i<4 && !failed;i++) {
+		target = targets[i]*48/1152;
+		k = __seekto(targets[i],&ticks,&read,&played);
+		if(k<0 || played<0 || abs(k - (s32)target)>slack) failed = 1;
+		if(landpos==~0U || abs((s32)landpos - (s32)targets[i])>50) failed = 1;
+
+		printf("%-16s %4u ms: frame %3d for %3u, %4u us, %6u bytes read, %3u ms queued before it\n","",
+			targets[i],k,target,(u32)ticks_to_microsecs(ticks),read,played>=0 ? played*1000/48000 : 0);
+	}
+
+	MP3Player_Stop();
+	return failed;
+}
+
+static int __test_seek_cbr(void)
+{
+	return __test_seek(SEEK_CBR);
+}
+
+static int __test_seek_vbr(void)
+{
+	return __test_seek(SEEK_VBR);
+}
+
+static int __test_seek_xing(void)
+{
+	return __test_seek(SEEK_XING);
+}
+
+static int __test_seek_vbri(void)
+{
+	return __test_seek(SEEK_VBRI);
+}
+
+/*---------------------------------------------------------------------------------*/
+static void __bench_resample(void)
+{
+	static const char *names[4] = {"resample low","resample medium","resample high","resample medium + EQ"};
+	u32 q;
+	double t;
+	EQState eqs[2];
+
+	Init3BandState(&eqs[0],880,5000,48000);
+	Init3BandState(&eqs[1],880,5000,48000);
+	__tone(1000.0,44100);
+	for(q=0;q<4;q++) {
+		MP3Player_SetQuality(q<3 ? q : MP3PLAYER_QUALITY_MEDIUM);
+		if(q==3) MP3Player_SetEqualizer(1.5F,1.0F,0.5F);
+
+		t = __cputime();
+		__resample(tone,TONE_SECONDS*44100,44100,eqs,toneout,TONE_SECONDS*48000*2);
+		t = __cputime() - t;
+		printf("%-24s %8.2f ms/s\n",names[q],t*1e3/TONE_SECONDS);
+	}
+	MP3Player_SetEqualizer(1.0F,1.0F,1.0F);
+	MP3Player_SetQuality(MP3PLAYER_QUALITY_MEDIUM);
+}
+
+/* random seeks in each kind of stream, from MP3Player_Seek() to the first frame played after it */
+static void __bench_seek(void)
+{
+	static const char *names[4] = {"seek cbr","seek vbr","seek xing","seek vbri"};
+	u32 kind,i,n,len,wait,read,bytes,seed;
+	s32 played;
+	u64 ticks,total;
+
+	for(kind=SEEK_CBR;kind<=SEEK_VBRI;kind++) {
+		len = __seekstream(kind,kind*7 + 1);
+		if(len==0 || __decode(kind>=SEEK_XING ? frameoff[0] : 0,len)!=SEEK_FRAMES*1152) return;
+		if(__playfile(len)!=0) return;
+		for(wait=0;captured<48000/2 && MP3Player_IsPlaying() && wait<10000;wait++) __sleep(1);
+
+		seed = 1;
+		total = 0;
+		bytes = n = 0;
+		for(i=0;i<16;i++) {
+			seed = seed*1103515245 + 12345;
+			if(__seekto((seed>>16)%9000,&ticks,&read,&played)<0) continue;
+			total += ticks;
+			bytes += read;
+			n++;
+		}
+		MP3Player_Stop();
+
+		if(n>0) printf("%-24s %8u us %8u bytes read\n",names[kind],(u32)ticks_to_microsecs(total/n),bytes/n);
+	}
+}
+
+/* everything the player does for a 44.1 kHz stream, with the kernel and the fake voice */
+static void __bench_player(void)
+{
+	static const char *names[3] = {"player low","player medium","player high"};
+	u32 i,q,len,wait;
+	double t,seconds;
+	madstream ms;
+
+	madstream_init(&ms,stream,sizeof(stream),7);
+	for(i=0;i<383;i++) madstream_frame(&ms,3,128,44100);
+	len = ms.len;
+	seconds = 383*1152/44100.0;
+
+	for(q=0;q<3;q++) {
+		MP3Player_SetQuality(q);
+		captured = 0;
+
+		t = __cputime();
+		if(MP3Player_PlayBuffer(stream,len,NULL)!=0) return;
+		for(wait=0;MP3Player_IsPlaying() && wait<100000;wait++) __sleep(1);
+		t = __cputime() - t;
+		printf("%-24s %8.2f ms/s\n",names[q],t*1e3/seconds);
+	}
+	MP3Player_SetQuality(MP3PLAYER_QUALITY_MEDIUM);
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "passthrough",	__test_passthrough },
+	{ "equalizer",		__test_equalizer },
+	{ "resample",		__test_resample },
+	{ "player",			__test_player },
+	{ "seek cbr",		__test_seek_cbr },
+	{ "seek vbr",		__test_seek_vbr },
+	{ "seek xing",		__test_seek_xing },
+	{ "seek vbri",		__test_seek_vbri },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	if(LWP_CreateThread(&voicethread,__voice,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		__bench_resample();
+		__bench_player();
+		__bench_seek();
+	}
+
+	voicestop = true;
+	LWP_JoinThread(voicethread,NULL);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	int i;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,210 @@
+/*-------------------------------------------------------------
+
+crctest.c -- equivalence test and benchmark of the SD-over-EXI CRC kernels
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Builds the kernels of libogc/sdgecko_crc.inl as they are and checks the
+ * sliced ones against the byte-wise CRC7 and word-wise CRC16 they replaced,
+ * and all of them against a bit-serial reference and the SD specification's
+ * examples, at every length and alignment a transfer can have.
+ *
+ *   crctest				run the checks
+ *   crctest -b				also time the old and new kernels
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <gctypes.h>
+#include "sdgecko_crc.inl"
+
+#define PAGE_SIZE512			512
+
+#define BENCH_BYTES				(64*1024*1024)
+
+static int bench = 0;
+static int failed = 0;
+
+static u8 data[4096 + 8] __attribute__((aligned(32)));
+
+static void report(const char *name,int ok)
+{
+	printf("%-24s %s\n",name,ok ? "ok" : "FAILED");
+	if(!ok) failed++;
+}
+
+/* x^7 + x^3 + 1, one bit at a time, result in the upper 7 bits as the driver sends it */
+static u8 crc7_reference(const u8 *ptr,u32 len)
+{
+	u32 i,j;
+	u8 crc = 0;
+
+	for(i=0;i<len;i++) {
+		for(j=0;j<8;j++) {
+			u8 bit = ((ptr[i]>>(7 - j))&1)^((crc>>6)&1);
+			crc = (crc<<1)&0x7f;
+			if(bit) crc ^= 0x09;
+		}
+	}
+	return crc<<1;
+}
+
+/* x^16 + x^12 + x^5 + 1, initial value 0, one bit at a time */
+static u16 crc16_reference(const u8 *ptr,u32 len)
+{
+	u32 i,j;
+	u16 crc = 0;
+
+	for(i=0;i<len;i++) {
+		crc ^= ptr[i]<<8;
+		for(j=0;j<8;j++) {
+			if(crc&0x8000) crc = (crc<<1)^0x1021;
+			else crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+static void test_vectors(void)
+{
+	u8 cmd0[5] = {0x40,0x00,0x00,0x00,0x00};
+	u8 cmd8[5] = {0x48,0x00,0x00,0x01,0xaa};
+	u8 cmd17[5] = {0x51,0x00,0x00,0x00,0x00};
+	u8 block[PAGE_SIZE512] __attribute__((aligned(32)));
+
+	/* the fixed CRCs every SD host sends before CRC checking is off */
+	report("crc7 CMD0/CMD8/CMD17",
+		   __make_crc7_bytewise(cmd0,5)==0x94 && __make_crc7_sliced(cmd0,5)==0x94 &&
+		   __make_crc7_bytewise(cmd8,5)==0x86 && __make_crc7_sliced(cmd8,5)==0x86 &&
+		   __make_crc7_bytewise(cmd17,5)==0x54 && __make_crc7_sliced(cmd17,5)==0x54);
+
+	/* the specification's example: 512 bytes of 0xff */
+	memset(block,0xff,sizeof(block));
+	report("crc16 512 x 0xff",
+		   __make_crc16_wordwise(block,sizeof(block))==0x7fa1 &&
+		   __make_crc16_sliced(block,sizeof(block))==0x7fa1);
+}
+
+static void test_crc7(void)
+{
+	u32 len,off;
+	int ok = 1;
+
+	for(off=0;off<8;off++) {
+		for(len=0;len<=64;len++) {
+			u8 ref = crc7_reference(data + off,len);
+
+			if(__make_crc7_bytewise(data + off,len)!=ref) ok = 0;
+			if(__make_crc7_sliced(data + off,len)!=ref) ok = 0;
+		}
+	}
+	report("crc7 lengths/alignments",ok);
+}
+
+static void test_crc16(void)
+{
+	u32 len,off;
+	int ok = 1;
+
+	/* data blocks always are a whole number of halfwords */
+	for(off=0;off<8;off++) {
+		for(len=0;len<=4096;len+=2) {
+			u16 ref = crc16_reference(data + off,len);
+
+			if(__make_crc16_wordwise(data + off,len)!=ref) ok = 0;
+			if(__make_crc16_sliced(data + off,len)!=ref) ok = 0;
+		}
+	}
+	report("crc16 lengths/alignments",ok);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static volatile u32 sink;
+
+static void bench_crc16(const char *name,u16 (*kernel)(void*,u32))
+{
+	u32 i,n = BENCH_BYTES/PAGE_SIZE512;
+	double t = now();
+
+	for(i=0;i<n;i++) sink += kernel(data + (i&7)*PAGE_SIZE512,PAGE_SIZE512);
+	t = now() - t;
+	printf("%-24s %8.1f MB/s  %8.0f ns/block\n",name,BENCH_BYTES/t/1e6,t*1e9/n);
+}
+
+static void bench_crc7(const char *name,u8 (*kernel)(void*,u32))
+{
+	u32 i,n = BENCH_BYTES/64;
+	double t = now();
+
+	for(i=0;i<n;i++) sink += kernel(data + (i&1023),5);
+	t = now() - t;
+	printf("%-24s %8.1f ns/command\n",name,t*1e9/n);
+}
+
+int main(int argc,char *argv[])
+{
+	u32 i,seed = 1;
+
+	for(i=1;i<(u32)argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	for(i=0;i<sizeof(data);i++) {
+		seed = seed*1103515245 + 12345;
+		data[i] = seed>>16;
+	}
+
+	__build_crc7_tables();
+	__build_crc16_tables();
+
+	test_vectors();
+	test_crc7();
+	test_crc16();
+
+	if(bench) {
+		printf("\n");
+		bench_crc16("crc16 word-wise (old)",__make_crc16_wordwise);
+		bench_crc16("crc16 sliced-by-8",__make_crc16_sliced);
+		bench_crc7("crc7 byte-wise (old)",__make_crc7_bytewise);
+		bench_crc7("crc7 sliced-by-4",__make_crc7_sliced);
+	}
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,722 @@
+/*-------------------------------------------------------------
+
+sdtest.c -- SD-over-EXI multi-block tests against a bus-level model of an SPI card
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/sdgecko_io.c and libogc/exi.c as they are, on the simulated
+ * kernel of lwpsim/, against the register-level EXI model of exi/eximodel.c
+ * with an SDHC card in SPI mode on channel 2, device 0: the drive that
+ * transfers its data blocks by DMA. The card sits behind an adapter that
+ * keeps it selected, so it also answers the responses and data the driver
+ * clocks through EXI_SelectSD without any chip select.
+ *
+ * The card takes six byte commands, checks their CRC7 once CMD59 turned
+ * checking on, answers after one byte of Ncr and streams its data blocks
+ * after a few hundred bytes of Nac, the start token and then the CRC16 of
+ * the block. A CMD18 run streams until CMD12, a CMD25 run takes blocks
+ * until the stop token, checks the CRC16 of each and keeps the line busy
+ * while it programs them. The CRC16 travels in the byte order of the host's
+ * u16, which is what the driver's two byte transfers to and from a u16 put
+ * on the wire of a little-endian host.
+ *
+ * The checks run the multi-block reads and writes through one selection for
+ * the whole run, with four byte token and busy polls, CRC errors on either
+ * side in any block, misaligned buffers and the single-block commands. The
+ * benchmark reports the throughput the driver achieves on the modelled bus,
+ * every byte at the selected clock plus the cost of starting each transfer,
+ * for single-block commands against CMD18 and CMD25 runs.
+ *
+ *   sdtest				run the checks
+ *   sdtest -b				also report MB/s of single-block and multi-block transfers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwp.h"
+#include "system.h"
+#include "timesupp.h"
+#include "exi.h"
+#include "card_cmn.h"
+#include "card_io.h"
+#include "eximodel.h"
+
+#define SD_DRV					2				// channel 2, device 0
+#define SD_CHN					EXI_CHANNEL_2
+
+#define CARD_SECTORS			4096
+#define CARD_QUEUE				4096
+#define CARD_NAC				256				// Nac bytes before a start token, plus 0..3 so that it moves within a word
+#define CARD_BUSY				1024			// busy bytes while a block programs
+#define CARD_IDLEPOLLS			3				// ACMD41 answered idle this often after CMD0
+#define CARD_NONE				~0U
+
+#define TOKEN_START				0xfe
+#define TOKEN_MULTI				0xfc
+#define TOKEN_STOP				0xfd
+
+#define R1_IDLE					0x01
+#define R1_ILLEGAL				0x04
+#define R1_CRC					0x08
+#define R1_ADDRESS				0x20
+#define R1_PARAM				0x40
+
+#define DATA_ACCEPTED			0x05
+#define DATA_CRCERR				0x0b
+
+#define CARDIO_OP_IOERR_CRC		0x0002			// as sdgecko_io.c reports a CRC error
+
+#define TEST_SECTORS			64
+#define BENCH_SECTORS			256
+
+enum {
+	CARD_IDLE,
+	CARD_READMULTI,
+	CARD_WRITEWAIT,
+	CARD_WRITEDATA
+};
+
+static struct {
+	u8 mem[CARD_SECTORS*PAGE_SIZE512];
+	u8 cid[16];
+	u8 csd[16];
+	u8 status[64];
+
+	u8 out[CARD_QUEUE];
+	u32 head,tail;
+
+	u32 state;
+	u8 cmd[6];
+	u32 cmdlen;
+	u8 blk[PAGE_SIZE512+2];
+	u32 blklen;
+	bool idle,app,crcon,multi;
+	u32 idlepolls;
+	u32 addr;
+	u32 blocks;
+
+	u32 badread;								// sector sent with a wrong CRC16, once
+	u32 badwrite;								// sector refused with a CRC error, once
+
+	u32 cmds[64];
+	u32 acmds[64];
+	u32 cmdcrcerrs;
+	u32 datacrcerrs;
+} card;
+
+static u8 buf[BENCH_SECTORS*PAGE_SIZE512+32] ATTRIBUTE_ALIGN(32);
+static u8 ref[BENCH_SECTORS*PAGE_SIZE512];
+
+static u32 selects;
+static int bench = 0;
+
+extern void __exi_init(void);
+extern s32 __real_EXI_Select(s32 nChn,s32 nDev,s32 nFrq);
+extern s32 __real_EXI_SelectSD(s32 nChn,s32 nDev,s32 nFrq);
+
+/*---------------------------------------------------------------------------------*/
+void DCInvalidateRange(void *startaddress,u32 len) {}
+void DCStoreRange(void *startaddress,u32 len) {}
+void DCFlushRange(void *startaddress,u32 len) {}
+
+u32 diff_msec(u64 start,u64 end)
+{
+	return ticks_to_millisecs(diff_ticks(start,end));
+}
+
+u32 SYS_GetConsoleType(void)
+{
+	return SYS_CONSOLE_RETAIL;
+}
+
+/* every selection the driver makes, with or without a chip select (linked with --wrap) */
+s32 __wrap_EXI_Select(s32 nChn,s32 nDev,s32 nFrq)
+{
+	selects++;
+	return __real_EXI_Select(nChn,nDev,nFrq);
+}
+
+s32 __wrap_EXI_SelectSD(s32 nChn,s32 nDev,s32 nFrq)
+{
+	selects++;
+	return __real_EXI_SelectSD(nChn,nDev,nFrq);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* x^7 + x^3 + 1, in the upper 7 bits with the end bit set, as a command carries it */
+static u8 __crc7(const u8 *ptr,u32 len)
+{
+	u32 i,j;
+	u8 bit,crc = 0;
+
+	for(i=0;i<len;i++) {
+		for(j=0;j<8;j++) {
+			bit = ((ptr[i]>>(7-j))&1)^((crc>>6)&1);
+			crc = (crc<<1)&0x7f;
+			if(bit) crc ^= 0x09;
+		}
+	}
+	return (crc<<1)|0x01;
+}
+
+/* x^16 + x^12 + x^5 + 1 */
+static u16 __crc16(const u8 *ptr,u32 len)
+{
+	u32 i,j;
+	u16 crc = 0;
+
+	for(i=0;i<len;i++) {
+		crc ^= ptr[i]<<8;
+		for(j=0;j<8;j++) {
+			if(crc&0x8000) crc = (crc<<1)^0x1021;
+			else crc <<= 1;
+		}
+	}
+	return crc;
+}
+
+static inline u8 __cardbyte(u32 addr,u32 seed)
+{
+	return (u8)(addr*7 + (addr>>9)*13 + seed);
+}
+
+static void __cardpush(u8 val)
+{
+	card.out[card.tail++%CARD_QUEUE] = val;
+}
+
+static void __cardfill(u8 val,u32 len)
+{
+	while(len--) __cardpush(val);
+}
+
+/* Nac, the start token, the block and its CRC16 in the byte order of a host u16 */
+static void __carddata(const u8 *ptr,u32 len,bool badcrc)
+{
+	u32 i;
+	u16 crc = __crc16(ptr,len);
+
+	if(badcrc) crc ^= 0x8001;
+	__cardfill(0xff,CARD_NAC+(card.blocks++&3));
+	__cardpush(TOKEN_START);
+	for(i=0;i<len;i++) __cardpush(ptr[i]);
+	__cardpush(crc);
+	__cardpush(crc>>8);
+}
+
+static void __cardsector(u32 sector)
+{
+	bool bad = (sector==card.badread);
+
+	if(bad) card.badread = CARD_NONE;
+	__carddata(card.mem+sector*PAGE_SIZE512,PAGE_SIZE512,bad);
+}
+
+/* Ncr, then R1 */
+static void __cardr1(u8 flags)
+{
+	__cardpush(0xff);
+	__cardpush((card.idle ? R1_IDLE : 0)|flags);
+}
+
+static u8 __cardpop(void)
+{
+	if(card.head==card.tail) {
+		if(card.state!=CARD_READMULTI) return 0xff;
+		__cardsector(card.addr++%CARD_SECTORS);
+	}
+	return card.out[card.head++%CARD_QUEUE];
+}
+
+static void __cardcommand(void)
+{
+	u32 idx = card.cmd[0]&0x3f;
+	u32 arg = (card.cmd[1]<<24)|(card.cmd[2]<<16)|(card.cmd[3]<<8)|card.cmd[4];
+	bool app = card.app;
+
+	card.app = false;
+	if(app) card.acmds[idx]++;
+	else card.cmds[idx]++;
+
+	if((card.crcon || idx==0 || idx==8) && __crc7(card.cmd,5)!=card.cmd[5]) {
+		card.cmdcrcerrs++;
+		__cardr1(R1_CRC);
+		return;
+	}
+
+	// a run ends with its stop command, anything else is taken as it comes
+	if(idx==12) {
+		card.head = card.tail;
+		card.state = CARD_IDLE;
+		__cardpush(0xff);
+		__cardpush(0x00);
+		__cardfill(0x00,CARD_BUSY);
+		return;
+	}
+	if(card.state==CARD_READMULTI) card.head = card.tail;
+	card.state = CARD_IDLE;
+
+	switch(idx) {
+		case 0:
+			card.idle = true;
+			card.crcon = false;
+			card.idlepolls = CARD_IDLEPOLLS;
+			__cardr1(0);
+			break;
+		case 8:
+			__cardr1(0);
+			__cardpush(0x00);
+			__cardpush(0x00);
+			__cardpush((arg>>8)&0x0f);
+			__cardpush(arg&0xff);
+			break;
+		case 9:
+			__cardr1(0);
+			__carddata(card.csd,sizeof(card.csd),false);
+			break;
+		case 10:
+			__cardr1(0);
+			__carddata(card.cid,sizeof(card.cid),false);
+			break;
+		case 13:
+			__cardr1(0);
+			__cardpush(0x00);
+			if(app) __carddata(card.status,sizeof(card.status),false);
+			break;
+		case 16:
+			__cardr1(arg!=PAGE_SIZE512 ? R1_PARAM : 0);
+			break;
+		case 17:
+		case 18:
+		case 24:
+		case 25:
+			if(arg>=CARD_SECTORS) {
+				__cardr1(R1_ADDRESS);
+				break;
+			}
+			__cardr1(0);
+			card.addr = arg;
+			if(idx==17) __cardsector(arg);
+			else if(idx==18) card.state = CARD_READMULTI;
+			else {
+				card.multi = (idx==25);
+				card.state = CARD_WRITEWAIT;
+			}
+			break;
+		case 23:
+		case 55:
+			if(idx==55) card.app = true;
+			__cardr1(app||idx==55 ? 0 : R1_ILLEGAL);
+			break;
+		case 41:
+			if(app && card.idlepolls && !--card.idlepolls) card.idle = false;
+			__cardr1(app ? 0 : R1_ILLEGAL);
+			break;
+		case 58:
+			__cardr1(0);
+			__cardpush(0xc0);						// powered up, CCS: block addressed
+			__cardpush(0xff);
+			__cardpush(0x80);
+			__cardpush(0x00);
+			break;
+		case 59:
+			card.crcon = (arg&1);
+			__cardr1(0);
+			break;
+		default:
+			__cardr1(R1_ILLEGAL);
+			break;
+	}
+}
+
+/* a whole data block with its CRC16 came in: data response, then busy while it programs */
+static void __cardblock(void)
+{
+	u16 crc = card.blk[PAGE_SIZE512]|(card.blk[PAGE_SIZE512+1]<<8);
+	bool ok = (__crc16(card.blk,PAGE_SIZE512)==crc);
+
+	if(!ok) card.datacrcerrs++;
+	if(card.addr==card.badwrite) {
+		card.badwrite = CARD_NONE;
+		ok = false;
+	}
+
+	card.state = card.multi ? CARD_WRITEWAIT : CARD_IDLE;
+	if(!ok) {
+		__cardpush(DATA_CRCERR);
+		return;
+	}
+	memcpy(card.mem+(card.addr++%CARD_SECTORS)*PAGE_SIZE512,card.blk,PAGE_SIZE512);
+	__cardpush(DATA_ACCEPTED);
+	__cardfill(0x00,CARD_BUSY);
+}
+
+static u8 __cardexchange(void *usr,u8 mosi)
+{
+	u8 miso = __cardpop();
+
+	switch(card.state) {
+		case CARD_WRITEDATA:
+			card.blk[card.blklen++] = mosi;
+			if(card.blklen==sizeof(card.blk)) __cardblock();
+			return miso;
+		case CARD_WRITEWAIT:
+			if(mosi==(card.multi ? TOKEN_MULTI : TOKEN_START)) {
+				card.blklen = 0;
+				card.state = CARD_WRITEDATA;
+				return miso;
+			}
+			if(mosi==TOKEN_STOP && card.multi) {
+				card.state = CARD_IDLE;
+				__cardpush(0xff);
+				__cardfill(0x00,CARD_BUSY);
+				return miso;
+			}
+			break;
+	}
+
+	if(card.cmdlen>0 || (mosi&0xc0)==0x40) {
+		card.cmd[card.cmdlen++] = mosi;
+		if(card.cmdlen==sizeof(card.cmd)) {
+			card.cmdlen = 0;
+			__cardcommand();
+		}
+	}
+	return miso;
+}
+
+static const eximodeldev carddev = {
+	NULL,
+	NULL,
+	__cardexchange,
+	NULL,
+	EXIMODEL_NOCS
+};
+
+static void __cardreset(void)
+{
+	u32 i,c_size = CARD_SECTORS/1024-1;
+
+	for(i=0;i<sizeof(card.mem);i++) card.mem[i] = __cardbyte(i,0x5a);
+	memset(card.cid,0,sizeof(card.cid));
+	memcpy(card.cid,"\x03SDSIM01",8);
+	card.cid[15] = __crc7(card.cid,15);
+
+	// CSD 2.0: 25 MHz, command classes without switch (CMD6), 512 byte blocks
+	memset(card.csd,0,sizeof(card.csd));
+	card.csd[0] = 0x40;
+	card.csd[1] = 0x0e;
+	card.csd[3] = 0x32;
+	card.csd[4] = 0x1b;
+	card.csd[5] = 0x59;
+	card.csd[7] = (c_size>>16)&0x3f;
+	card.csd[8] = c_size>>8;
+	card.csd[9] = c_size;
+	card.csd[10] = 0x7f;
+	card.csd[11] = 0x80;
+	card.csd[12] = 0x0a;
+	card.csd[13] = 0x40;
+	card.csd[15] = __crc7(card.csd,15);
+	memset(card.status,0,sizeof(card.status));
+
+	card.head = card.tail = 0;
+	card.state = CARD_IDLE;
+	card.cmdlen = 0;
+	card.idle = true;
+	card.app = false;
+	card.crcon = false;
+	card.idlepolls = CARD_IDLEPOLLS;
+	card.badread = CARD_NONE;
+	card.badwrite = CARD_NONE;
+}
+
+static void __countreset(void)
+{
+	memset(card.cmds,0,sizeof(card.cmds));
+	memset(card.acmds,0,sizeof(card.acmds));
+	card.cmdcrcerrs = 0;
+	card.datacrcerrs = 0;
+	selects = 0;
+	eximodel_resetstats(SD_CHN);
+}
+
+static bool __cardcheck(const u8 *ptr,u32 sector,u32 cnt)
+{
+	return memcmp(ptr,card.mem+sector*PAGE_SIZE512,cnt*PAGE_SIZE512)==0;
+}
+
+/* contents no sector of the card holds yet, to write */
+static void __refill(u32 seed,u32 cnt)
+{
+	u32 i;
+
+	for(i=0;i<cnt*PAGE_SIZE512;i++) ref[i] = __cardbyte(i,seed);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* SDHC, block addressed, and on the DMA path: the card answers without a chip select */
+static int __test_init(void)
+{
+	__cardreset();
+	sdgecko_setDevice(SD_DRV,EXI_DEVICE_0);
+	if(sdgecko_initIO(SD_DRV)!=CARDIO_ERROR_READY || !sdgecko_isInitialized(SD_DRV)) return 1;
+	if(sdgecko_getTransferMode(SD_DRV)!=CARDIO_TRANSFER_DMA) return 1;
+	if(sdgecko_getAddressingType(SD_DRV)!=CARDIO_ADDRESSING_BLOCK) return 1;
+	return card.idle || !card.crcon || card.cmdcrcerrs;
+}
+
+/* one CMD18 streamed through a single selection, the run left open for the next read */
+static int __test_read(void)
+{
+	eximodelstats st;
+
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	__countreset();
+	memset(buf,0,sizeof(buf));
+	if(sdgecko_readSectors(SD_DRV,100,TEST_SECTORS,buf)!=CARDIO_ERROR_READY) return 1;
+	if(!__cardcheck(buf,100,TEST_SECTORS)) return 1;
+
+	// command and response, then the run
+	eximodel_getstats(SD_CHN,&st);
+	if(card.cmds[18]!=1 || selects!=3 || st.dmas!=TEST_SECTORS) return 1;
+
+	// the start token is polled a word at a time: about Nac/4 transfers a block, a byte at a time would be Nac
+	if(st.imms>TEST_SECTORS*CARD_NAC/2) return 1;
+
+	// the next sectors continue the run, into a misaligned buffer
+	__countreset();
+	memset(buf,0,sizeof(buf));
+	if(sdgecko_readSectors(SD_DRV,100+TEST_SECTORS,TEST_SECTORS,buf+5)!=CARDIO_ERROR_READY) return 1;
+	if(!__cardcheck(buf+5,100+TEST_SECTORS,TEST_SECTORS)) return 1;
+	if(card.cmds[18] || card.cmds[12] || selects!=1) return 1;
+
+	// anything else stops it first
+	if(sdgecko_readSectors(SD_DRV,10,1,buf)!=CARDIO_ERROR_READY || !__cardcheck(buf,10,1)) return 1;
+	return card.cmds[12]!=1 || card.cmds[18]!=1 || card.cmdcrcerrs;
+}
+
+/* a bad CRC16 is found in the middle of a run, with the DMA of the next block in flight, and at its end */
+static int __test_readcrc(void)
+{
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	__countreset();
+	card.badread = 210;
+	if(sdgecko_readSectors(SD_DRV,200,TEST_SECTORS,buf)!=CARDIO_OP_IOERR_CRC) return 1;
+	if(card.cmds[12]!=1 || card.state!=CARD_IDLE) return 1;
+
+	card.badread = 200+TEST_SECTORS-1;
+	if(sdgecko_readSectors(SD_DRV,200,TEST_SECTORS,buf)!=CARDIO_OP_IOERR_CRC) return 1;
+	if(card.cmds[12]!=2) return 1;
+
+	// the retry goes through
+	memset(buf,0,sizeof(buf));
+	if(sdgecko_readSectors(SD_DRV,200,TEST_SECTORS,buf)!=CARDIO_ERROR_READY) return 1;
+	return !__cardcheck(buf,200,TEST_SECTORS);
+}
+
+/* one CMD25 in a single selection, every block's CRC16 right, from aligned and misaligned sources */
+static int __test_write(void)
+{
+	eximodelstats st;
+
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	__countreset();
+	__refill(0x11,TEST_SECTORS);
+	memcpy(buf,ref,TEST_SECTORS*PAGE_SIZE512);
+	if(sdgecko_writeSectors(SD_DRV,300,TEST_SECTORS,buf)!=CARDIO_ERROR_READY) return 1;
+	if(!__cardcheck(ref,300,TEST_SECTORS) || card.datacrcerrs) return 1;
+
+	// ACMD23 and CMD25 with their responses, the run, the stop token, CMD13 and its response
+	eximodel_getstats(SD_CHN,&st);
+	if(card.acmds[23]!=1 || card.cmds[25]!=1 || card.cmds[13]!=1 || selects!=10) return 1;
+	// and the busy wait of each block as well
+	if(st.dmas!=TEST_SECTORS || st.imms>TEST_SECTORS*CARD_BUSY/2) return 1;
+
+	__refill(0x22,TEST_SECTORS);
+	memcpy(buf+3,ref,TEST_SECTORS*PAGE_SIZE512);
+	if(sdgecko_writeSectors(SD_DRV,400,TEST_SECTORS,buf+3)!=CARDIO_ERROR_READY) return 1;
+	return !__cardcheck(ref,400,TEST_SECTORS) || card.datacrcerrs || card.cmdcrcerrs;
+}
+
+/* a block the card refuses fails the run, which is stopped; the blocks before it are written */
+static int __test_writecrc(void)
+{
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	__countreset();
+	__refill(0x33,TEST_SECTORS);
+	memcpy(buf,ref,TEST_SECTORS*PAGE_SIZE512);
+	card.badwrite = 520;
+	if(sdgecko_writeSectors(SD_DRV,500,TEST_SECTORS,buf)!=CARDIO_OP_IOERR_CRC) return 1;
+	if(card.cmds[12]!=1 || card.state!=CARD_IDLE || !__cardcheck(ref,500,20)) return 1;
+
+	if(sdgecko_writeSectors(SD_DRV,500,TEST_SECTORS,buf)!=CARDIO_ERROR_READY) return 1;
+	return !__cardcheck(ref,500,TEST_SECTORS) || card.datacrcerrs;
+}
+
+/* CMD17 and CMD24 */
+static int __test_single(void)
+{
+	__countreset();
+	__refill(0x44,1);
+	memcpy(buf,ref,PAGE_SIZE512);
+	if(sdgecko_writeSector(SD_DRV,buf,700)!=CARDIO_ERROR_READY || !__cardcheck(ref,700,1)) return 1;
+
+	memset(buf,0,sizeof(buf));
+	if(sdgecko_readSector(SD_DRV,buf,700)!=CARDIO_ERROR_READY || !__cardcheck(buf,700,1)) return 1;
+	if(card.cmds[24]!=1 || card.cmds[17]!=1 || card.datacrcerrs) return 1;
+
+	card.badread = 700;
+	return sdgecko_readSector(SD_DRV,buf,700)!=CARDIO_OP_IOERR_CRC;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "init",			__test_init },
+	{ "read",			__test_read },
+	{ "read crc",		__test_readcrc },
+	{ "write",			__test_write },
+	{ "write crc",		__test_writecrc },
+	{ "single",			__test_single },
+};
+
+/* MB/s on the modelled bus: the bytes of data over the bus time that moved them */
+static void __report(const char *name,u32 cnt)
+{
+	eximodelstats st;
+
+	eximodel_getstats(SD_CHN,&st);
+	printf("%-24s %8.2f MB/s\n",name,st.bustime ? (f64)cnt*PAGE_SIZE512*1000.0/st.bustime : 0.0);
+}
+
+static int __bench_read(u32 chunk)
+{
+	u32 i;
+	s32 ret;
+
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	eximodel_resetstats(SD_CHN);
+	for(i=0;i<BENCH_SECTORS;i+=chunk) {
+		if(chunk==1) ret = sdgecko_readSector(SD_DRV,buf+i*PAGE_SIZE512,1000+i);
+		else ret = sdgecko_readSectors(SD_DRV,1000+i,chunk,buf+i*PAGE_SIZE512);
+		if(ret!=CARDIO_ERROR_READY) return 1;
+	}
+	return !__cardcheck(buf,1000,BENCH_SECTORS);
+}
+
+static int __bench_write(u32 chunk)
+{
+	u32 i;
+	s32 ret;
+
+	__refill(chunk,BENCH_SECTORS);
+	memcpy(buf,ref,BENCH_SECTORS*PAGE_SIZE512);
+	if(sdgecko_readCSD(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+	eximodel_resetstats(SD_CHN);
+	for(i=0;i<BENCH_SECTORS;i+=chunk) {
+		if(chunk==1) ret = sdgecko_writeSector(SD_DRV,buf+i*PAGE_SIZE512,2000+i);
+		else ret = sdgecko_writeSectors(SD_DRV,2000+i,chunk,buf+i*PAGE_SIZE512);
+		if(ret!=CARDIO_ERROR_READY) return 1;
+	}
+	return !__cardcheck(ref,2000,BENCH_SECTORS);
+}
+
+static int __bench(void)
+{
+	static const u32 chunks[] = { 1, 8, BENCH_SECTORS };
+	char name[32];
+	u32 i;
+
+	__cardreset();
+	if(sdgecko_initIO(SD_DRV)!=CARDIO_ERROR_READY) return 1;
+
+	// the clock the driver runs the card at, every bit of it data
+	printf("%-24s %8.2f MB/s\n","bus 27 MHz",(f64)(EXIMODEL_BASEHZ<<EXI_SPEED32MHZ)/8/1e6);
+	for(i=0;i<sizeof(chunks)/sizeof(chunks[0]);i++) {
+		if(__bench_read(chunks[i])) return 1;
+		sprintf(name,"read %s x%u",chunks[i]==1 ? "CMD17" : "CMD18",chunks[i]);
+		__report(name,BENCH_SECTORS);
+	}
+	for(i=0;i<sizeof(chunks)/sizeof(chunks[0]);i++) {
+		if(__bench_write(chunks[i])) return 1;
+		sprintf(name,"write %s x%u",chunks[i]==1 ? "CMD24" : "CMD25",chunks[i]);
+		__report(name,BENCH_SECTORS);
+	}
+	return 0;
+}
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	__exi_init();
+	sdgecko_initIODefault();
+	eximodel_attach(SD_CHN,EXI_DEVICE_0,&carddev);
+	if(eximodel_start()!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	if(bench) {
+		printf("\n");
+		if(__bench()) {
+			printf("%-16s FAILED\n","bench");
+			failed++;
+		}
+	}
+
+	eximodel_stop();
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	int i;
+
+	for(i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-b")) bench = 1;
+		else {
+			fprintf(stderr,"usage: %s [-b]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	if(eximodel_init()) return 1;
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
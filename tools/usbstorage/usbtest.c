@@ -0,0 +1,639 @@
+/*-------------------------------------------------------------
+
+usbtest.c -- USB mass storage driver tests against a mock IOS USB device
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/usbstorage.c as it is, on the simulated kernel of lwpsim/,
+ * against a mock of the IOS USB interface. The mock is a bulk-only mass
+ * storage device with one LUN, its disk kept in memory; control and bulk
+ * messages are queued to a thread above every other priority that runs
+ * them one at a time, with some latency, and completes them with
+ * interrupts disabled as the IPC interrupt handler would. A CBW arriving
+ * in the middle of another command counts as a protocol error.
+ *
+ *   usbtest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "ipc.h"
+#include "usb.h"
+#include "disc_io.h"
+#include "usbstorage.h"
+
+#define STACKSIZE				(64*1024)
+
+#define SECTOR_SIZE				512
+#define DISK_SECTORS			0x11000		// past the 16-bit count of READ(10)
+#define DEVICE_ID				3
+#define DEVICE_VID				0x1234
+#define DEVICE_PID				0x5678
+#define DEVICE_FD				0x20
+#define EP_IN					0x81
+#define EP_OUT					0x02
+
+#define MOCK_QUEUE				8
+#define MOCK_LATENCY			1		// ms per message
+#define SETTLE					20		// ms for the read-ahead to land
+
+#define CBW_SIZE				31
+#define CBW_SIGNATURE			0x43425355
+#define CSW_SIZE				13
+#define CSW_SIGNATURE			0x53425355
+
+#define SCSI_TEST_UNIT_READY	0x00
+#define SCSI_REQUEST_SENSE		0x03
+#define SCSI_INQUIRY			0x12
+#define SCSI_READ_CAPACITY		0x25
+#define SCSI_READ_10			0x28
+#define SCSI_WRITE_10			0x2A
+
+#define USBSTORAGE_GET_MAX_LUN	0xFE
+#define USBSTORAGE_RESET		0xFF
+
+typedef struct _mockop {
+	u8 ep;						// 0 for a control message
+	u8 request;
+	u16 len;
+	void *data;
+	usbcallback cb;
+	void *usrdata;
+} mockop;
+
+typedef struct _cmdlog {
+	u8 op;
+	u32 sector;
+	u32 count;
+} cmdlog;
+
+static u8 disk[DISK_SECTORS*SECTOR_SIZE];
+static u32 opens;
+static u32 protoerrs;
+
+/* the command between its CBW and its CSW */
+static struct {
+	bool active;
+	u8 op;
+	u32 tag;
+	u32 remaining;
+	u32 pos;
+	u8 status;
+	u8 reply[36];
+} scsi;
+
+static cmdlog cmds[256];
+static u32 ncmds;
+
+static mockop ops[MOCK_QUEUE];
+static u32 ophead,opcount;
+static sem_t opsem;
+static lwp_t iosthread = LWP_THREAD_NULL;
+
+// the driver hands its handle to every bulk callback, which is how the
+// tests get at the handle of the mounted device
+static usbstorage_handle *lasthandle;
+
+static u8 bufs[4][64*SECTOR_SIZE] ATTRIBUTE_ALIGN(32);
+
+static usb_endpointdesc endpoints[2] = {
+	{ 7, 5, EP_IN, 2, 512, 0 },
+	{ 7, 5, EP_OUT, 2, 512, 0 },
+};
+static usb_interfacedesc interface = { 9, 4, 0, 0, 2, 0x08, 0x06, 0x50, 0, NULL, 0, endpoints };
+static usb_configurationdesc configuration = { 9, 2, 32, 1, 1, 0, 0x80, 50, &interface };
+
+s32 SYS_CreateAlarm(syswd_t *thealarm)
+{
+	*thealarm = 1;
+	return 0;
+}
+
+/* the device always answers, the message timeouts never expire */
+s32 SYS_SetAlarm(syswd_t thealarm,const struct timespec *tp,alarmcallback cb,void *cbarg)
+{
+	return 0;
+}
+
+s32 SYS_CancelAlarm(syswd_t thealarm)
+{
+	return 0;
+}
+
+s32 SYS_RemoveAlarm(syswd_t thealarm)
+{
+	return 0;
+}
+
+bool SYS_IsDMAAddress(const void *addr,u32 align)
+{
+	return !((uintptr_t)addr&(align-1));
+}
+
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* the driver stores the SCSI fields with native stores, as the target is
+   big-endian, so they are read back the same way here */
+static void __scsi_command(const u8 *cbw)
+{
+	u32 sector = 0;
+	u16 count = 0;
+	const u8 *cb = cbw + 15;
+
+	scsi.active = true;
+	scsi.tag = __lwbrx(cbw,4);
+	scsi.remaining = __lwbrx(cbw,8);
+	scsi.op = cb[0];
+	scsi.pos = 0;
+	scsi.status = 0;
+	memset(scsi.reply,0,sizeof(scsi.reply));
+
+	switch(scsi.op) {
+		case SCSI_TEST_UNIT_READY:
+		case SCSI_REQUEST_SENSE:
+		case SCSI_INQUIRY:
+			break;
+		case SCSI_READ_CAPACITY:
+			sector = DISK_SECTORS - 1;
+			memcpy(scsi.reply,&sector,4);
+			sector = SECTOR_SIZE;
+			memcpy(scsi.reply+4,&sector,4);
+			break;
+		case SCSI_READ_10:
+		case SCSI_WRITE_10:
+			memcpy(&sector,cb+2,4);
+			memcpy(&count,cb+7,2);
+			if(ncmds<sizeof(cmds)/sizeof(cmds[0])) {
+				cmds[ncmds].op = scsi.op;
+				cmds[ncmds].sector = sector;
+				cmds[ncmds].count = count;
+			}
+			ncmds++;
+			if(sector+count>DISK_SECTORS || count*SECTOR_SIZE!=scsi.remaining) {
+				scsi.status = 1;
+				protoerrs++;
+			}
+			scsi.pos = sector*SECTOR_SIZE;
+			break;
+		default:
+			scsi.status = 1;
+			break;
+	}
+}
+
+static s32 __bulk(const mockop *op)
+{
+	u32 len = op->len;
+
+	if(op->ep==EP_OUT && !scsi.active) {
+		if(len!=CBW_SIZE || __lwbrx(op->data,0)!=CBW_SIGNATURE) goto error;
+		__scsi_command(op->data);
+		return CBW_SIZE;
+	}
+	if(!scsi.active) goto error;
+
+	if(scsi.remaining) {
+		if(len>scsi.remaining) len = scsi.remaining;
+		if(op->ep==EP_IN && scsi.op==SCSI_READ_10)
+			memcpy(op->data,&disk[scsi.pos],len);
+		else if(op->ep==EP_OUT && scsi.op==SCSI_WRITE_10)
+			memcpy(&disk[scsi.pos],op->data,len);
+		else if(op->ep==EP_IN && scsi.op!=SCSI_WRITE_10 && scsi.pos+len<=sizeof(scsi.reply))
+			memcpy(op->data,scsi.reply+scsi.pos,len);
+		else
+			goto error;
+		scsi.pos += len;
+		scsi.remaining -= len;
+		return len;
+	}
+
+	if(op->ep!=EP_IN || len!=CSW_SIZE) goto error;
+	__stwbrx(op->data,0,CSW_SIGNATURE);
+	__stwbrx(op->data,4,scsi.tag);
+	__stwbrx(op->data,8,0);
+	((u8*)op->data)[12] = scsi.status;
+	scsi.active = false;
+	return CSW_SIZE;
+
+error:
+	protoerrs++;
+	scsi.active = false;
+	return IPC_EINVAL;
+}
+
+static s32 __control(const mockop *op)
+{
+	switch(op->request) {
+		case USBSTORAGE_GET_MAX_LUN:
+			((u8*)op->data)[0] = 0;
+			return 1;
+		case USBSTORAGE_RESET:
+			scsi.active = false;
+			return 0;
+		default:
+			return IPC_EINVAL;
+	}
+}
+
+static s32 __queue(u8 ep,u8 request,u16 len,void *data,usbcallback cb,void *usrdata)
+{
+	u32 level;
+	mockop *op;
+
+	_CPU_ISR_Disable(level);
+	if(opcount==MOCK_QUEUE) {
+		_CPU_ISR_Restore(level);
+		return IPC_EINVAL;
+	}
+	op = &ops[(ophead+opcount)%MOCK_QUEUE];
+	op->ep = ep;
+	op->request = request;
+	op->len = len;
+	op->data = data;
+	op->cb = cb;
+	op->usrdata = usrdata;
+	opcount++;
+	_CPU_ISR_Restore(level);
+
+	LWP_SemPost(opsem);
+	return 0;
+}
+
+/* IOS works through its queue in order, one message at a time */
+static void* __ios(void *arg)
+{
+	s32 ret;
+	u32 level;
+	mockop op;
+
+	while(LWP_SemWait(opsem)==0) {
+		_CPU_ISR_Disable(level);
+		if(!opcount) {
+			_CPU_ISR_Restore(level);
+			break;
+		}
+		op = ops[ophead];
+		_CPU_ISR_Restore(level);
+
+		__sleep(MOCK_LATENCY);
+		ret = op.ep ? __bulk(&op) : __control(&op);
+
+		_CPU_ISR_Disable(level);
+		ophead = (ophead+1)%MOCK_QUEUE;
+		opcount--;
+		op.cb(ret,op.usrdata);
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+s32 USB_Initialize()
+{
+	return 0;
+}
+
+s32 USB_GetDeviceList(usb_device_entry *descr_buffer,u8 num_descr,u8 interface_class,u8 *cnt_descr)
+{
+	*cnt_descr = 0;
+	if(num_descr<1 || interface_class!=0x08) return 0;
+
+	descr_buffer[0].device_id = DEVICE_ID;
+	descr_buffer[0].vid = DEVICE_VID;
+	descr_buffer[0].pid = DEVICE_PID;
+	descr_buffer[0].token = 0;
+	*cnt_descr = 1;
+	return 0;
+}
+
+s32 USB_OpenDevice(s32 device_id,u16 vid,u16 pid,s32 *fd)
+{
+	if(device_id!=DEVICE_ID || vid!=DEVICE_VID || pid!=DEVICE_PID) return IPC_ENOENT;
+	opens++;
+	*fd = DEVICE_FD;
+	return 0;
+}
+
+s32 USB_CloseDevice(s32 *fd)
+{
+	if(*fd!=DEVICE_FD || !opens) return IPC_EINVAL;
+	opens--;
+	*fd = -1;
+	return 0;
+}
+
+s32 USB_GetDescriptors(s32 fd,usb_devdesc *udd)
+{
+	memset(udd,0,sizeof(*udd));
+	udd->bLength = 18;
+	udd->bDescriptorType = 1;
+	udd->bcdUSB = 0x200;
+	udd->idVendor = DEVICE_VID;
+	udd->idProduct = DEVICE_PID;
+	udd->bNumConfigurations = 1;
+	udd->configurations = &configuration;
+	return 0;
+}
+
+void USB_FreeDescriptors(usb_devdesc *udd) {}
+
+s32 USB_GetConfiguration(s32 fd,u8 *conf)
+{
+	*conf = configuration.bConfigurationValue;
+	return 0;
+}
+
+s32 USB_SetConfiguration(s32 fd,u8 conf) { return 0; }
+s32 USB_SetAlternativeInterface(s32 fd,u8 interface,u8 alternateSetting) { return 0; }
+s32 USB_ClearHalt(s32 fd,u8 endpointAddress) { return 0; }
+s32 USB_DeviceRemovalNotifyAsync(s32 fd,usbcallback cb,void *userdata) { return 0; }
+s32 USB_SuspendDevice(s32 fd) { return 0; }
+s32 USB_ResumeDevice(s32 fd) { return 0; }
+
+s32 USB_WriteCtrlMsgAsync(s32 fd,u8 bmRequestType,u8 bmRequest,u16 wValue,u16 wIndex,u16 wLength,void *rpData,usbcallback cb,void *usrdata)
+{
+	if(fd!=DEVICE_FD || !opens) return IPC_EINVAL;
+	return __queue(0,bmRequest,wLength,rpData,cb,usrdata);
+}
+
+s32 USB_WriteBlkMsgAsync(s32 fd,u8 bEndpoint,u16 wLength,void *rpData,usbcallback cb,void *usrdata)
+{
+	if(fd!=DEVICE_FD || !opens || (bEndpoint!=EP_IN && bEndpoint!=EP_OUT)) return IPC_EINVAL;
+	lasthandle = usrdata;
+	return __queue(bEndpoint,0,wLength,rpData,cb,usrdata);
+}
+
+/*---------------------------------------------------------------------------------*/
+static DISC_INTERFACE *usb = &__io_usbstorage;
+static usbstorage_handle dev;
+
+static sem_t donesem;
+static usbstorage_req *order[16];
+static u32 ndone;
+
+static void __done(s32 result,usbstorage_req *req)
+{
+	order[ndone++%16] = req;
+	LWP_SemPost(donesem);
+}
+
+static bool __waitdone(u32 count)
+{
+	struct timespec ts = {1,0};
+
+	while(count--) {
+		if(LWP_SemTimedWait(donesem,&ts)) return false;
+	}
+	return true;
+}
+
+static void __fill(u8 *ptr,u32 sector,u32 count,u32 gen)
+{
+	u32 i;
+
+	for(i=0;i<count*SECTOR_SIZE;i++) ptr[i] = (u8)(sector*7 + i/SECTOR_SIZE*13 + i + gen);
+}
+
+/* reads on the bus since command first that touch sectors [sector,sector+count) */
+static u32 __reads(u32 first,u32 sector,u32 count)
+{
+	u32 i,n = 0;
+
+	for(i=first;i<ncmds && i<sizeof(cmds)/sizeof(cmds[0]);i++) {
+		if(cmds[i].op!=SCSI_READ_10) continue;
+		if(cmds[i].sector<sector+count && cmds[i].sector+cmds[i].count>sector) n++;
+	}
+	return n;
+}
+
+/* reads sectors through the DISC_INTERFACE in chunks and checks them against the disk */
+static bool __readback(u32 sector,u32 count,u32 chunk)
+{
+	u32 i;
+
+	for(i=0;i<count;i+=chunk) {
+		if(!usb->readSectors(usb,sector+i,chunk,bufs[3])) return false;
+		if(memcmp(bufs[3],&disk[(sector+i)*SECTOR_SIZE],chunk*SECTOR_SIZE)) return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------------*/
+/* the device mounts through the DISC_INTERFACE and takes synchronous transfers */
+static int __test_mount(void)
+{
+	if(!usb->startup(usb) || !usb->isInserted(usb)) return 1;
+	if(usb->numberOfSectors!=DISK_SECTORS || usb->bytesPerSector!=SECTOR_SIZE) return 1;
+
+	__fill(bufs[0],100,8,1);
+	if(!usb->writeSectors(usb,100,8,bufs[0])) return 1;
+	if(memcmp(&disk[100*SECTOR_SIZE],bufs[0],8*SECTOR_SIZE)) return 1;
+	memset(bufs[1],0,8*SECTOR_SIZE);
+	if(!usb->readSectors(usb,100,8,bufs[1])) return 1;
+	if(memcmp(bufs[0],bufs[1],8*SECTOR_SIZE)) return 1;
+
+	return !usb->shutdown(usb) || opens || protoerrs;
+}
+
+/* the queue is there as soon as the handle is open, and runs requests in order */
+static int __test_async(void)
+{
+	u32 i;
+	usbstorage_req reqs[4];
+
+	if(USBStorage_Open(&dev,DEVICE_ID,DEVICE_VID,DEVICE_PID)!=0) return 1;
+	if(dev.reqbox==MQ_BOX_NULL || dev.worker==LWP_THREAD_NULL) return 1;
+	if(USBStorage_MountLUN(&dev,0)<0 || dev.n_sectors[0]!=DISK_SECTORS) return 1;
+
+	ndone = 0;
+	__fill(&disk[200*SECTOR_SIZE],200,32,2);
+	__fill(bufs[2],300,8,3);
+	if(USBStorage_ReadAsync(&dev,&reqs[0],0,200,16,bufs[0],__done,NULL)!=0) return 1;
+	if(USBStorage_ReadAsync(&dev,&reqs[1],0,216,16,bufs[1],__done,NULL)!=0) return 1;
+	if(USBStorage_WriteAsync(&dev,&reqs[2],0,300,8,bufs[2],__done,NULL)!=0) return 1;
+	if(USBStorage_ReadAsync(&dev,&reqs[3],0,300,8,bufs[3],__done,NULL)!=0) return 1;
+	if(!__waitdone(4)) return 1;
+
+	for(i=0;i<4;i++) {
+		if(order[i]!=&reqs[i] || reqs[i].result<0 || reqs[i].dev!=&dev) return 1;
+	}
+	if(memcmp(bufs[0],&disk[200*SECTOR_SIZE],16*SECTOR_SIZE)) return 1;
+	if(memcmp(bufs[1],&disk[216*SECTOR_SIZE],16*SECTOR_SIZE)) return 1;
+	if(memcmp(bufs[2],&disk[300*SECTOR_SIZE],8*SECTOR_SIZE)) return 1;
+	return memcmp(bufs[3],bufs[2],8*SECTOR_SIZE)!=0 || protoerrs;
+}
+
+/* bad requests are refused up front, without a command reaching the device */
+static int __test_invalid(void)
+{
+	u32 cmdsbefore = ncmds;
+	usbstorage_req req;
+
+	ndone = 0;
+	if(USBStorage_ReadAsync(&dev,NULL,0,0,1,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,0,0,1,NULL,__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,0,0,0,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,1,0,1,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,0,DISK_SECTORS-4,8,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,0,DISK_SECTORS,1,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_ReadAsync(&dev,&req,0,0,0x10000,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_WriteAsync(&dev,&req,0,0,1,NULL,__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_WriteAsync(&dev,&req,0,0,0,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+	if(USBStorage_WriteAsync(&dev,&req,0,DISK_SECTORS-1,2,bufs[0],__done,NULL)!=IPC_EINVAL) return 1;
+
+	__sleep(SETTLE);
+	return ndone!=0 || ncmds!=cmdsbefore;
+}
+
+/* closing stops the worker, and a closed handle takes no more requests */
+static int __test_close(void)
+{
+	usbstorage_req req;
+
+	if(USBStorage_Close(&dev)!=0) return 1;
+	if(dev.worker!=LWP_THREAD_NULL || dev.reqbox!=MQ_BOX_NULL || opens) return 1;
+	return USBStorage_ReadAsync(&dev,&req,0,0,1,bufs[0],__done,NULL)!=IPC_EINVAL;
+}
+
+/* sequential reads are served from the read-ahead, which every kind of write drops */
+static int __test_readahead(void)
+{
+	u32 i,reads;
+	s32 ret;
+	u16 count = 64;
+	u32 sector = 64;
+	usbstorage_handle *mounted;
+	usbstorage_req req;
+	raw_device_command rdc;
+
+	__fill(disk,0,256,4);
+	if(!usb->isInserted(usb)) return 1;
+	mounted = lasthandle;
+
+	// two small reads in a row start the read-ahead, the next ones come out of it
+	ncmds = 0;
+	if(!__readback(0,16,8)) return 1;
+	__sleep(SETTLE);
+	reads = ncmds;
+	if(!__readback(16,16,8) || __reads(reads,16,16)!=0) return 1;
+	printf("%-16s %u reads on the bus for 4 sequential ones\n","",__reads(0,0,32));
+	__sleep(SETTLE);
+
+	// an asynchronous write to the handle of the mounted device
+	ndone = 0;
+	__fill(bufs[0],36,4,5);
+	if(USBStorage_WriteAsync(mounted,&req,0,36,4,bufs[0],__done,NULL)!=0) return 1;
+	if(!__waitdone(1) || req.result<0) return 1;
+	if(!__readback(32,16,8)) return 1;
+	__sleep(SETTLE);
+
+	// a synchronous one
+	__fill(bufs[1],52,4,6);
+	if(USBStorage_Write(mounted,0,52,4,bufs[1])<0) return 1;
+	if(!__readback(48,16,8)) return 1;
+
+	// and a raw command, while the read-ahead it hits may still be in flight
+	for(i=0;i<2;i++) {
+		__fill(bufs[2],sector,count,7+i);
+		memset(&rdc,0,sizeof(rdc));
+		rdc.command[0] = SCSI_WRITE_10;
+		memcpy(rdc.command+2,&sector,4);
+		memcpy(rdc.command+7,&count,2);
+		rdc.command_length = 10;
+		rdc.data = bufs[2];
+		rdc.data_length = count*SECTOR_SIZE;
+		ret = USBStorage_ioctl(B_RAW_DEVICE_COMMAND,&rdc);
+		if(ret<0 || rdc.scsi_status!=0) return 1;
+		if(!__readback(sector,count,8)) return 1;
+		sector += count;
+	}
+
+	__sleep(SETTLE);
+	return !usb->shutdown(usb) || opens || protoerrs;
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "mount",			__test_mount },
+	{ "async",			__test_async },
+	{ "invalid",		__test_invalid },
+	{ "close",			__test_close },
+	{ "readahead",		__test_readahead },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&opsem,0,MOCK_QUEUE*2);
+	LWP_SemInit(&donesem,0,16);
+	if(LWP_CreateThread(&iosthread,__ios,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	LWP_SemPost(opsem);
+	LWP_JoinThread(iosthread,NULL);
+	LWP_SemDestroy(donesem);
+	LWP_SemDestroy(opsem);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}
@@ -0,0 +1,500 @@
+/*-------------------------------------------------------------
+
+sdiotest.c -- Wii SD slot driver tests against a mock /dev/sdio
+
+Copyright (C) 2026 Extrems' Corner.org
+
+This software is provided 'as-is', without any express or implied
+warranty.  In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1.	The origin of this software must not be misrepresented; you
+must not claim that you wrote the original software. If you use
+this software in a product, an acknowledgment in the product
+documentation would be appreciated but is not required.
+
+2.	Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3.	This notice may not be removed or altered from any source
+distribution.
+
+-------------------------------------------------------------*/
+
+/*
+ * Runs libogc/wiisd.c as it is, on the simulated kernel of lwpsim/, against
+ * a mock of the IOS /dev/sdio/slot0 device. The mock answers the host
+ * controller ioctls of an initialized SDHC card and keeps the card itself
+ * in memory; asynchronous ioctls are queued to a thread above every other
+ * priority that runs them one at a time, with some latency, and completes
+ * them with interrupts disabled as the IPC interrupt handler would.
+ *
+ *   sdiotest				run the checks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "lwp.h"
+#include "semaphore.h"
+#include "system.h"
+#include "timesupp.h"
+#include "ipc.h"
+#include "disc_io.h"
+#include "sdcard/wiisd_io.h"
+
+#define STACKSIZE				(64*1024)
+
+#define SECTOR_SIZE				512
+#define CARD_SECTORS			1024
+#define CARD_RCA				0x1234
+#define CARD_FD					7
+
+#define MOCK_QUEUE				8
+#define MOCK_LATENCY			1		// ms per queued command
+
+#define IOCTL_SDIO_WRITEHCREG	0x01
+#define IOCTL_SDIO_READHCREG	0x02
+#define IOCTL_SDIO_RESETCARD	0x04
+#define IOCTL_SDIO_SETCLK		0x06
+#define IOCTL_SDIO_SENDCMD		0x07
+#define IOCTL_SDIO_GETSTATUS	0x0B
+
+#define SDIO_CMD_SELECT			0x07
+#define SDIO_CMD_SENDCSD		0x09
+#define SDIO_CMD_READMULTIBLOCK	0x12
+#define SDIO_CMD_WRITEMULTIBLOCK	0x19
+
+#define SDIO_STATUS_CARD_INSERTED		0x1
+#define SDIO_STATUS_CARD_INITIALIZED	0x10000
+#define SDIO_STATUS_CARD_SDHC			0x100000
+
+/* as the driver lays out its requests */
+struct _sdiorequest
+{
+	u32 cmd;
+	u32 cmd_type;
+	u32 rsp_type;
+	u32 arg;
+	u32 blk_cnt;
+	u32 blk_size;
+	void *dma_addr;
+	u32 isdma;
+	u32 pad0;
+};
+
+typedef struct _mockop {
+	struct _sdiorequest *request;
+	void *buffer;
+	void *response;
+	ipccallback cb;
+	void *usrdata;
+} mockop;
+
+typedef struct _cmdlog {
+	u32 cmd;
+	u32 arg;
+	u32 count;
+} cmdlog;
+
+static u8 card[CARD_SECTORS*SECTOR_SIZE];
+static bool opened;
+static bool selected;
+static u32 selects;
+
+static cmdlog cmds[256];
+static u32 ncmds;
+
+static mockop ops[MOCK_QUEUE];
+static u32 ophead,opcount,opmax;
+static sem_t opsem;
+static lwp_t iosthread = LWP_THREAD_NULL;
+
+static void (*closehook)(void);
+
+static u8 bufs[4][64*SECTOR_SIZE] ATTRIBUTE_ALIGN(32);
+
+bool SYS_IsDMAAddress(const void *addr,u32 align)
+{
+	return !((uintptr_t)addr&(align-1));
+}
+
+static void __sleep(u32 ms)
+{
+	sem_t sem;
+	struct timespec ts = {0,ms*TB_NSPERMS};
+
+	LWP_SemInit(&sem,0,1);
+	LWP_SemTimedWait(sem,&ts);
+	LWP_SemDestroy(sem);
+}
+
+/*---------------------------------------------------------------------------------*/
+static s32 __card_command(struct _sdiorequest *request,void *buffer,void *response)
+{
+	u8 *csd = response;
+	u32 len = request->blk_cnt*SECTOR_SIZE;
+
+	if(response) memset(response,0,16);
+	if(ncmds<sizeof(cmds)/sizeof(cmds[0])) {
+		cmds[ncmds].cmd = request->cmd;
+		cmds[ncmds].arg = request->arg;
+		cmds[ncmds].count = request->blk_cnt;
+	}
+	ncmds++;
+
+	switch(request->cmd) {
+		case SDIO_CMD_SELECT:
+			selected = (request->arg==(CARD_RCA<<16));
+			if(selected) selects++;
+			return 0;
+		case SDIO_CMD_SENDCSD:
+			// CSD version 2.0, C_SIZE 0: 512KiB
+			if(csd) csd[13] = 0x40;
+			return 0;
+		case SDIO_CMD_READMULTIBLOCK:
+		case SDIO_CMD_WRITEMULTIBLOCK:
+			if(!selected || request->blk_size!=SECTOR_SIZE || !buffer) return IPC_EINVAL;
+			if(request->arg+request->blk_cnt>CARD_SECTORS) return IPC_EINVAL;
+			if(request->cmd==SDIO_CMD_READMULTIBLOCK) memcpy(buffer,&card[request->arg*SECTOR_SIZE],len);
+			else memcpy(&card[request->arg*SECTOR_SIZE],buffer,len);
+			return 0;
+		default:
+			return 0;
+	}
+}
+
+s32 IOS_Open(const char *filepath,u32 mode)
+{
+	if(strcmp(filepath,"/dev/sdio/slot0")) return IPC_ENOENT;
+	opened = true;
+	return CARD_FD;
+}
+
+s32 IOS_Close(s32 fd)
+{
+	if(fd!=CARD_FD || !opened) return IPC_EINVAL;
+	if(closehook) closehook();
+	opened = false;
+	selected = false;
+	return 0;
+}
+
+s32 IOS_Ioctl(s32 fd,s32 ioctl,void *buffer_in,s32 len_in,void *buffer_io,s32 len_io)
+{
+	if(fd!=CARD_FD || !opened) return IPC_EINVAL;
+
+	switch(ioctl) {
+		case IOCTL_SDIO_GETSTATUS:
+			*(u32*)buffer_io = SDIO_STATUS_CARD_INSERTED|SDIO_STATUS_CARD_INITIALIZED|SDIO_STATUS_CARD_SDHC;
+			return 0;
+		case IOCTL_SDIO_RESETCARD:
+			*(u32*)buffer_io = (CARD_RCA<<16);
+			return 0;
+		case IOCTL_SDIO_READHCREG:
+			*(u32*)buffer_io = 0;
+			return 0;
+		case IOCTL_SDIO_WRITEHCREG:
+		case IOCTL_SDIO_SETCLK:
+			return 0;
+		case IOCTL_SDIO_SENDCMD:
+			return __card_command(buffer_in,NULL,buffer_io);
+		default:
+			return IPC_EINVAL;
+	}
+}
+
+s32 IOS_Ioctlv(s32 fd,s32 ioctl,s32 cnt_in,s32 cnt_io,ioctlv *argv)
+{
+	if(fd!=CARD_FD || !opened || ioctl!=IOCTL_SDIO_SENDCMD) return IPC_EINVAL;
+	return __card_command(argv[0].data,argv[1].data,argv[2].data);
+}
+
+static s32 __queue(struct _sdiorequest *request,void *buffer,void *response,ipccallback cb,void *usrdata)
+{
+	u32 level;
+	mockop *op;
+
+	_CPU_ISR_Disable(level);
+	if(!opened || opcount==MOCK_QUEUE) {
+		_CPU_ISR_Restore(level);
+		return IPC_EINVAL;
+	}
+	op = &ops[(ophead+opcount)%MOCK_QUEUE];
+	op->request = request;
+	op->buffer = buffer;
+	op->response = response;
+	op->cb = cb;
+	op->usrdata = usrdata;
+	if(++opcount>opmax) opmax = opcount;
+	_CPU_ISR_Restore(level);
+
+	LWP_SemPost(opsem);
+	return 0;
+}
+
+s32 IOS_IoctlAsync(s32 fd,s32 ioctl,void *buffer_in,s32 len_in,void *buffer_io,s32 len_io,ipccallback ipc_cb,void *usrdata)
+{
+	if(fd!=CARD_FD || ioctl!=IOCTL_SDIO_SENDCMD) return IPC_EINVAL;
+	return __queue(buffer_in,NULL,buffer_io,ipc_cb,usrdata);
+}
+
+s32 IOS_IoctlvAsync(s32 fd,s32 ioctl,s32 cnt_in,s32 cnt_io,ioctlv *argv,ipccallback ipc_cb,void *usrdata)
+{
+	if(fd!=CARD_FD || ioctl!=IOCTL_SDIO_SENDCMD) return IPC_EINVAL;
+	return __queue(argv[0].data,argv[1].data,argv[2].data,ipc_cb,usrdata);
+}
+
+/* IOS works through its queue in order, one command at a time */
+static void* __ios(void *arg)
+{
+	s32 ret;
+	u32 level;
+	mockop op;
+
+	while(LWP_SemWait(opsem)==0) {
+		_CPU_ISR_Disable(level);
+		if(!opcount) {
+			_CPU_ISR_Restore(level);
+			break;
+		}
+		op = ops[ophead];
+		_CPU_ISR_Restore(level);
+
+		__sleep(MOCK_LATENCY);
+		ret = __card_command(op.request,op.buffer,op.response);
+
+		_CPU_ISR_Disable(level);
+		ophead = (ophead+1)%MOCK_QUEUE;
+		opcount--;
+		op.cb(ret,op.usrdata);
+		_CPU_ISR_Restore(level);
+	}
+	return NULL;
+}
+
+/*---------------------------------------------------------------------------------*/
+static sem_t donesem;
+static sdio_request *order[16];
+static u32 ndone;
+
+static void __done(s32 result,sdio_request *req)
+{
+	req->usrdata = (void*)(intptr_t)result;
+	order[ndone++%16] = req;
+	LWP_SemPost(donesem);
+}
+
+static bool __waitdone(u32 count)
+{
+	struct timespec ts = {1,0};
+
+	while(count--) {
+		if(LWP_SemTimedWait(donesem,&ts)) return false;
+	}
+	return true;
+}
+
+static void __fill(u8 *ptr,sec_t sector,sec_t count,u32 gen)
+{
+	u32 i;
+
+	for(i=0;i<count*SECTOR_SIZE;i++) ptr[i] = (u8)(sector*7 + i/SECTOR_SIZE*13 + i + gen);
+}
+
+static bool __startup(void)
+{
+	ncmds = selects = opmax = ndone = 0;
+	return __io_wiisd.startup(&__io_wiisd);
+}
+
+/*---------------------------------------------------------------------------------*/
+/* the card comes up from the status IOS reports and takes synchronous transfers */
+static int __test_startup(void)
+{
+	if(!__startup() || __io_wiisd.numberOfSectors!=CARD_SECTORS) return 1;
+
+	__fill(bufs[0],100,8,1);
+	if(!__io_wiisd.writeSectors(&__io_wiisd,100,8,bufs[0])) return 1;
+	if(memcmp(&card[100*SECTOR_SIZE],bufs[0],8*SECTOR_SIZE)) return 1;
+	memset(bufs[1],0,8*SECTOR_SIZE);
+	if(!__io_wiisd.readSectors(&__io_wiisd,100,8,bufs[1])) return 1;
+	if(memcmp(bufs[0],bufs[1],8*SECTOR_SIZE) || selected) return 1;
+
+	return !__io_wiisd.shutdown(&__io_wiisd) || opened;
+}
+
+/* queued requests run back to back under a single select, two at a time in IOS */
+static int __test_queue(void)
+{
+	u32 i;
+	sdio_request reqs[3];
+	sdio_segment segs[3][2];
+
+	if(!__startup()) return 1;
+	__fill(&card[200*SECTOR_SIZE],200,64,2);
+
+	for(i=0;i<3;i++) {
+		segs[i][0].buffer = bufs[i];
+		segs[i][0].numSectors = 5;
+		segs[i][1].buffer = bufs[i]+32*SECTOR_SIZE;
+		segs[i][1].numSectors = 3;
+	}
+	selects = 0;
+	for(i=0;i<2;i++) {
+		if(sdio_ReadAsync(&reqs[i],200+i*8,segs[i],2,__done,NULL)!=0) return 1;
+	}
+	__fill(bufs[2],400,5,3);
+	__fill(bufs[2]+32*SECTOR_SIZE,405,3,3);
+	if(sdio_WriteAsync(&reqs[2],400,segs[2],2,__done,NULL)!=0) return 1;
+	if(!__waitdone(3)) return 1;
+
+	for(i=0;i<3;i++) {
+		if(reqs[i].usrdata!=NULL || order[i]!=&reqs[i]) return 1;
+	}
+	for(i=0;i<2;i++) {
+		if(memcmp(bufs[i],&card[(200+i*8)*SECTOR_SIZE],5*SECTOR_SIZE)) return 1;
+		if(memcmp(bufs[i]+32*SECTOR_SIZE,&card[(205+i*8)*SECTOR_SIZE],3*SECTOR_SIZE)) return 1;
+	}
+	if(memcmp(bufs[2],&card[400*SECTOR_SIZE],5*SECTOR_SIZE)) return 1;
+	if(memcmp(bufs[2]+32*SECTOR_SIZE,&card[405*SECTOR_SIZE],3*SECTOR_SIZE)) return 1;
+	if(selects!=1 || opmax!=2) return 1;
+
+	__sleep(5*MOCK_LATENCY);
+	return selected || !__io_wiisd.shutdown(&__io_wiisd);
+}
+
+/* a synchronous transfer waits for the queue to drain, and the queue for it */
+static int __test_sync(void)
+{
+	sdio_request req;
+	sdio_segment seg = {bufs[0],16};
+
+	if(!__startup()) return 1;
+	__fill(&card[0],0,16,4);
+	__fill(bufs[1],600,16,5);
+
+	if(sdio_ReadAsync(&req,0,&seg,1,__done,NULL)!=0) return 1;
+	if(!__io_wiisd.writeSectors(&__io_wiisd,600,16,bufs[1])) return 1;
+	if(ndone!=1 || req.usrdata!=NULL || memcmp(bufs[0],&card[0],16*SECTOR_SIZE)) return 1;
+	if(memcmp(bufs[1],&card[600*SECTOR_SIZE],16*SECTOR_SIZE)) return 1;
+
+	return !__waitdone(1) || !__io_wiisd.shutdown(&__io_wiisd);
+}
+
+/* bad requests are refused up front */
+static int __test_invalid(void)
+{
+	sdio_request req;
+	sdio_segment seg = {bufs[0],1};
+
+	if(sdio_ReadAsync(&req,0,&seg,1,__done,NULL)!=IPC_ENOENT) return 1;
+	if(!__startup()) return 1;
+	if(sdio_ReadAsync(NULL,0,&seg,1,__done,NULL)!=IPC_EINVAL) return 1;
+	if(sdio_ReadAsync(&req,CARD_SECTORS,&seg,1,__done,NULL)!=IPC_EINVAL) return 1;
+	if(sdio_ReadAsync(&req,0,&seg,0,__done,NULL)!=IPC_EINVAL) return 1;
+	seg.numSectors = 0;
+	if(sdio_ReadAsync(&req,0,&seg,1,__done,NULL)!=IPC_EINVAL) return 1;
+	return ndone!=0 || !__io_wiisd.shutdown(&__io_wiisd);
+}
+
+static sdio_request latereqs[2];
+static s32 lateret[2];
+
+static void __latesubmit(void)
+{
+	u32 i;
+	static sdio_segment seg = {bufs[3],4};
+
+	for(i=0;i<2;i++) lateret[i] = sdio_ReadAsync(&latereqs[i],i*4,&seg,1,__done,NULL);
+}
+
+/* shutting down waits for the queue, and what is submitted meanwhile still completes */
+static int __test_shutdown(void)
+{
+	u32 i,expect;
+	sdio_request reqs[2];
+	sdio_segment segs[2] = {{bufs[0],32},{bufs[1],32}};
+
+	if(!__startup()) return 1;
+	for(i=0;i<2;i++) {
+		if(sdio_ReadAsync(&reqs[i],i*32,&segs[i],1,__done,NULL)!=0) return 1;
+	}
+
+	closehook = __latesubmit;
+	__io_wiisd.shutdown(&__io_wiisd);
+	closehook = NULL;
+
+	// both earlier requests finished before the handle went away
+	if(ndone<2 || reqs[0].usrdata!=NULL || reqs[1].usrdata!=NULL) return 1;
+	if(opened || opcount) return 1;
+
+	// the late ones were either refused or completed with an error, none is left hanging
+	expect = 2;
+	for(i=0;i<2;i++) {
+		if(lateret[i]==0) expect++;
+		else if(lateret[i]!=IPC_ENOENT) return 1;
+	}
+	if(!__waitdone(expect-2)) return 1;
+	for(i=0;i<2;i++) {
+		if(lateret[i]==0 && (s32)(intptr_t)latereqs[i].usrdata>=0) return 1;
+	}
+
+	// and the driver comes back up afterwards
+	return !__startup() || !__io_wiisd.shutdown(&__io_wiisd);
+}
+
+/*---------------------------------------------------------------------------------*/
+static const struct {
+	const char *name;
+	int (*run)(void);
+} tests[] = {
+	{ "startup",		__test_startup },
+	{ "queue",			__test_queue },
+	{ "sync",			__test_sync },
+	{ "invalid",		__test_invalid },
+	{ "shutdown",		__test_shutdown },
+};
+
+static int __main(void)
+{
+	u32 i;
+	int failed = 0;
+
+	LWP_SemInit(&opsem,0,MOCK_QUEUE*2);
+	LWP_SemInit(&donesem,0,16);
+	if(LWP_CreateThread(&iosthread,__ios,NULL,NULL,STACKSIZE,LWP_PRIO_HIGHEST)!=0) return 1;
+
+	for(i=0;i<sizeof(tests)/sizeof(tests[0]);i++) {
+		if(tests[i].run()) {
+			printf("%-16s FAILED\n",tests[i].name);
+			failed++;
+		} else
+			printf("%-16s ok\n",tests[i].name);
+	}
+
+	LWP_SemPost(opsem);
+	LWP_JoinThread(iosthread,NULL);
+	LWP_SemDestroy(donesem);
+	LWP_SemDestroy(opsem);
+
+	printf("%s\n",failed ? "FAILED" : "PASSED");
+	return failed ? 1 : 0;
+}
+
+int main(int argc,char *argv[])
+{
+	if(argc>1) {
+		fprintf(stderr,"usage: %s\n",argv[0]);
+		return 2;
+	}
+
+	setvbuf(stdout,NULL,_IOLBF,0);
+	return simcpu_run(__main);
+}